@@ -3,6 +3,63 @@
 
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
+#include "protocol/inline_upload.h"
+
+namespace {
+
+// VENUS_INLINE_UPLOADS=off sends every vkCmdUpdateBuffer as it is.
+bool inline_uploads_enabled() {
+    static const bool enabled = []() {
+        const char* env = std::getenv("VENUS_INLINE_UPLOADS");
+        return !env || (std::strcmp(env, "0") != 0 && std::strcmp(env, "off") != 0 &&
+                        std::strcmp(env, "OFF") != 0);
+    }();
+    return enabled;
+}
+
+// Records vkCmdUpdateBuffer into a captured recording as an inline upload
+// region (see protocol/inline_upload.h), added to the inline upload command
+// right before it if there is one. False when the recording is not being
+// captured; the caller then sends vkCmdUpdateBuffer.
+bool record_inline_upload(VkCommandBuffer remote_cb,
+                          VkBuffer remote_dst,
+                          VkDeviceSize offset,
+                          VkDeviceSize size,
+                          const void* data) {
+    if (!inline_uploads_enabled()) {
+        return false;
+    }
+    const uint32_t type = VENUS_PLUS_CMD_INLINE_UPLOAD;
+    const uint32_t flags = 0;
+    const uint32_t region_count = 1;
+    const size_t header_size = vn_sizeof_uint32_t(&type) + vn_sizeof_uint32_t(&flags) +
+                               vn_sizeof_VkCommandBuffer(&remote_cb) + vn_sizeof_uint32_t(&region_count);
+    const size_t region_size = vn_sizeof_VkBuffer(&remote_dst) + vn_sizeof_VkDeviceSize(&offset) +
+                               vn_sizeof_VkDeviceSize(&size) + vn_sizeof_blob_array(data, size);
+    std::vector<uint8_t> command(header_size + region_size);
+    vn_cs_encoder enc;
+    vn_cs_encoder_init_external(&enc, command.data(), command.size());
+    vn_encode_uint32_t(&enc, &type);
+    vn_encode_uint32_t(&enc, &flags);
+    vn_encode_VkCommandBuffer(&enc, &remote_cb);
+    vn_encode_uint32_t(&enc, &region_count);
+    vn_encode_VkBuffer(&enc, &remote_dst);
+    vn_encode_VkDeviceSize(&enc, &offset);
+    vn_encode_VkDeviceSize(&enc, &size);
+    vn_encode_blob_array(&enc, data, size);
+
+    const uint64_t command_buffer = reinterpret_cast<uint64_t>(remote_cb);
+    const bool recorded = vn_ring_extend_capture(&g_ring, command_buffer, command.data() + header_size, region_size,
+                                                 VENUS_PLUS_INLINE_UPLOAD_MAX_COMMAND_SIZE) ||
+                          vn_ring_capture_extendable(&g_ring, command_buffer, command.data(), command.size(),
+                                                     VENUS_PLUS_INLINE_UPLOAD_COUNT_OFFSET);
+    if (recorded) {
+        g_inline_uploads.fetch_add(1, std::memory_order_relaxed);
+    }
+    return recorded;
+}
+
+} // namespace
 
 extern "C" {
 
@@ -147,6 +204,7 @@ VKAPI_ATTR void VKAPI_CALL vkFreeCommandBuffers(
     }
 
     for (VkCommandBuffer handle : local_handles) {
+        forget_command_buffer_recording(handle);
         IcdCommandBuffer* icd_cb = icd_command_buffer_from_handle(handle);
         delete icd_cb;
     }
@@ -217,7 +275,63 @@ VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    VkResult result = vn_call_vkBeginCommandBuffer(&g_ring, remote_cb, pBeginInfo);
+    VkCommandBufferBeginInfo remote_begin = *pBeginInfo;
+    VkCommandBufferInheritanceInfo remote_inheritance = {};
+    if (g_command_buffer_state.get_buffer_level(commandBuffer) != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+        // Only secondary buffers read the inheritance info.
+        remote_begin.pInheritanceInfo = nullptr;
+    } else if (pBeginInfo->pInheritanceInfo) {
+        remote_inheritance = *pBeginInfo->pInheritanceInfo;
+        if (remote_inheritance.renderPass != VK_NULL_HANDLE) {
+            remote_inheritance.renderPass =
+                g_resource_state.get_remote_render_pass(remote_inheritance.renderPass);
+            if (remote_inheritance.renderPass == VK_NULL_HANDLE) {
+                ICD_LOG_ERROR() << "[Client ICD] Inheritance render pass not tracked in vkBeginCommandBuffer\n";
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
+        if (remote_inheritance.framebuffer != VK_NULL_HANDLE) {
+            remote_inheritance.framebuffer =
+                g_resource_state.get_remote_framebuffer(remote_inheritance.framebuffer);
+            if (remote_inheritance.framebuffer == VK_NULL_HANDLE) {
+                ICD_LOG_ERROR() << "[Client ICD] Inheritance framebuffer not tracked in vkBeginCommandBuffer\n";
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
+        remote_begin.pInheritanceInfo = &remote_inheritance;
+    }
+
+    // Bound state never carries over between recordings. A secondary that
+    // continues a render pass records entirely inside one.
+    if (g_command_buffer_state.get_buffer_level(commandBuffer) == VK_COMMAND_BUFFER_LEVEL_SECONDARY &&
+        (pBeginInfo->flags & VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT)) {
+        g_state_filter.begin_scope(commandBuffer);
+    } else {
+        g_state_filter.end_scope(commandBuffer);
+    }
+
+    if (g_replay_cache.enabled() || g_deferred_recording.enabled()) {
+        // Begin travels with the captured stream: nothing is sent until
+        // vkEndCommandBuffer (or, when deferred, the first submit) finds the
+        // recording has to go out, and a server side failure surfaces there.
+        if (g_replay_cache.enabled()) {
+            // The server may replay this recording again, so it must outlive
+            // a submit.
+            remote_begin.flags &= ~VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            g_replay_cache.begin(commandBuffer);
+        }
+        // Also tracks the pipeline layouts the capture uses, with or without
+        // deferral.
+        g_deferred_recording.begin(commandBuffer);
+        vn_ring_begin_capture(&g_ring, reinterpret_cast<uint64_t>(remote_cb));
+        vn_async_vkBeginCommandBuffer(&g_ring, remote_cb, &remote_begin);
+        g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::RECORDING);
+        g_command_buffer_state.set_usage_flags(commandBuffer, pBeginInfo->flags);
+        ICD_LOG_INFO() << "[Client ICD] Command buffer recording begun (captured)\n";
+        return VK_SUCCESS;
+    }
+
+    VkResult result = vn_call_vkBeginCommandBuffer(&g_ring, remote_cb, &remote_begin);
     if (result == VK_SUCCESS) {
         g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::RECORDING);
         g_command_buffer_state.set_usage_flags(commandBuffer, pBeginInfo->flags);
@@ -247,11 +361,51 @@ VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer commandBuffer)
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    g_state_filter.end_scope(commandBuffer);
+
+    if (g_deferred_recording.enabled()) {
+        // Kept locally until the first submit; see upload_deferred_recording().
+        std::vector<uint8_t> stream;
+        vn_ring_end_capture(&g_ring, reinterpret_cast<uint64_t>(remote_cb), &stream);
+        g_deferred_recording.end(commandBuffer, std::move(stream));
+        g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::EXECUTABLE);
+        ICD_LOG_INFO() << "[Client ICD] Command buffer recording ended (deferred)\n";
+        return VK_SUCCESS;
+    }
+
+    const bool replay = g_replay_cache.enabled();
+    std::vector<uint8_t> stream;
+    uint64_t stream_hash = 0;
+    if (replay) {
+        vn_ring_end_capture(&g_ring, reinterpret_cast<uint64_t>(remote_cb), &stream);
+        if (g_replay_cache.can_reuse(commandBuffer, stream, &stream_hash) &&
+            send_reuse_recording(remote_cb, stream_hash, true)) {
+            g_replay_cache.record_hit(stream.size());
+            g_command_buffer_state.take_reset_elided(commandBuffer);
+            g_deferred_recording.release_pipeline_layouts(commandBuffer);
+            g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::EXECUTABLE);
+            ICD_LOG_INFO() << "[Client ICD] Command buffer recording reused (" << stream.size()
+                           << " bytes not sent)\n";
+            return VK_SUCCESS;
+        }
+        send_reset_elided(commandBuffer, remote_cb);
+        vn_ring_submit_encoded(&g_ring, stream.data(), stream.size());
+    }
+
     VkResult result = vn_call_vkEndCommandBuffer(&g_ring, remote_cb);
+    if (replay) {
+        g_deferred_recording.release_pipeline_layouts(commandBuffer);
+    }
     if (result == VK_SUCCESS) {
+        if (replay) {
+            g_replay_cache.record_miss(commandBuffer, stream_hash, &stream);
+        }
         g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::EXECUTABLE);
         ICD_LOG_INFO() << "[Client ICD] Command buffer recording ended\n";
     } else {
+        if (replay) {
+            g_replay_cache.invalidate(commandBuffer);
+        }
         g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::INVALID);
         ICD_LOG_ERROR() << "[Client ICD] vkEndCommandBuffer failed: " << result << "\n";
     }
@@ -291,6 +445,23 @@ VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandBuffer(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    if (g_replay_cache.enabled() || g_deferred_recording.enabled()) {
+        // Drop an unfinished capture or a recording never uploaded; the
+        // server never saw their begin.
+        vn_ring_end_capture(&g_ring, reinterpret_cast<uint64_t>(remote_cb), nullptr);
+        g_deferred_recording.discard(commandBuffer);
+        if (!(flags & VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT)) {
+            // Kept on the server (as a replay candidate, with the cache on);
+            // the next uploaded begin resets it there implicitly.
+            g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::INITIAL);
+            g_command_buffer_state.set_usage_flags(commandBuffer, 0);
+            g_command_buffer_state.mark_reset_elided(commandBuffer);
+            ICD_LOG_INFO() << "[Client ICD] Command buffer reset (kept on the server)\n";
+            return VK_SUCCESS;
+        }
+        g_replay_cache.invalidate(commandBuffer);
+    }
+
     VkResult result = vn_call_vkResetCommandBuffer(&g_ring, remote_cb, flags);
     if (result == VK_SUCCESS) {
         g_command_buffer_state.set_buffer_state(commandBuffer, CommandBufferLifecycleState::INITIAL);
@@ -913,6 +1084,10 @@ VKAPI_ATTR void VKAPI_CALL vkCmdUpdateBuffer(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdUpdateBuffer\n";
         return;
     }
+    if (record_inline_upload(remote_cb, remote_dst, dstOffset, dataSize, pData)) {
+        ICD_LOG_INFO() << "[Client ICD] vkCmdUpdateBuffer recorded as inline upload\n";
+        return;
+    }
     vn_async_vkCmdUpdateBuffer(&g_ring, remote_cb, remote_dst, dstOffset, dataSize, pData);
     ICD_LOG_INFO() << "[Client ICD] vkCmdUpdateBuffer recorded\n";
 }
@@ -1003,6 +1178,7 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderPass(
     remote_begin.renderPass = remote_render_pass;
     remote_begin.framebuffer = remote_framebuffer;
 
+    g_state_filter.begin_scope(commandBuffer);
     vn_async_vkCmdBeginRenderPass(&g_ring, remote_cb, &remote_begin, contents);
     ICD_LOG_INFO() << "[Client ICD] vkCmdBeginRenderPass recorded\n";
 }
@@ -1027,6 +1203,7 @@ VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderPass(
         return;
     }
 
+    g_state_filter.end_scope(commandBuffer);
     vn_async_vkCmdEndRenderPass(&g_ring, remote_cb);
     ICD_LOG_INFO() << "[Client ICD] vkCmdEndRenderPass recorded\n";
 }
@@ -1061,6 +1238,7 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBeginRendering(
         return;
     }
 
+    g_state_filter.begin_scope(commandBuffer);
     vn_async_vkCmdBeginRendering(&g_ring, remote_cb, &storage.info);
 }
 
@@ -1090,6 +1268,7 @@ VKAPI_ATTR void VKAPI_CALL vkCmdEndRendering(
         return;
     }
 
+    g_state_filter.end_scope(commandBuffer);
     vn_async_vkCmdEndRendering(&g_ring, remote_cb);
 }
 
@@ -1138,6 +1317,13 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(
         return;
     }
 
+    const StateSlot pipeline_slot = pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+                                        ? StateSlot::GraphicsPipeline
+                                        : StateSlot::ComputePipeline;
+    if (g_state_filter.filter(commandBuffer, pipeline_slot, &remote_pipeline, sizeof(remote_pipeline))) {
+        return;
+    }
+
     vn_async_vkCmdBindPipeline(&g_ring, remote_cb, pipelineBindPoint, remote_pipeline);
     ICD_LOG_INFO() << "[Client ICD] Pipeline bound (bindPoint=" << pipelineBindPoint << ")\n";
 }
@@ -1183,6 +1369,7 @@ VKAPI_ATTR void VKAPI_CALL vkCmdPushConstants(
         return;
     }
 
+    g_deferred_recording.note_pipeline_layout(commandBuffer, remote_layout);
     vn_async_vkCmdPushConstants(&g_ring,
                                 remote_cb,
                                 remote_layout,
@@ -1870,6 +2057,13 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(
         return;
     }
 
+    StateBlob vertex_state;
+    vertex_state.add(firstBinding).add(bindingCount);
+    vertex_state.add_array(remote_buffers.data(), bindingCount).add_array(pOffsets, bindingCount);
+    if (g_state_filter.filter(commandBuffer, StateSlot::VertexBuffers, vertex_state.data(), vertex_state.size())) {
+        return;
+    }
+
     vn_async_vkCmdBindVertexBuffers(&g_ring,
                                     remote_cb,
                                     firstBinding,
@@ -1907,6 +2101,12 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetViewport(
         return;
     }
 
+    StateBlob viewport_state;
+    viewport_state.add(uint32_t(0)).add(firstViewport).add(viewportCount).add_array(pViewports, viewportCount);
+    if (g_state_filter.filter(commandBuffer, StateSlot::Viewport, viewport_state.data(), viewport_state.size())) {
+        return;
+    }
+
     vn_async_vkCmdSetViewport(&g_ring, remote_cb, firstViewport, viewportCount, pViewports);
     ICD_LOG_INFO() << "[Client ICD] vkCmdSetViewport recorded\n";
 }
@@ -1939,6 +2139,12 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetScissor(
         return;
     }
 
+    StateBlob scissor_state;
+    scissor_state.add(uint32_t(0)).add(firstScissor).add(scissorCount).add_array(pScissors, scissorCount);
+    if (g_state_filter.filter(commandBuffer, StateSlot::Scissor, scissor_state.data(), scissor_state.size())) {
+        return;
+    }
+
     vn_async_vkCmdSetScissor(&g_ring, remote_cb, firstScissor, scissorCount, pScissors);
     ICD_LOG_INFO() << "[Client ICD] vkCmdSetScissor recorded\n";
 }
@@ -1961,6 +2167,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetCullMode(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetCullMode\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::CullMode, &cullMode, sizeof(cullMode))) {
+        return;
+    }
     vn_async_vkCmdSetCullMode(&g_ring, remote_cb, cullMode);
 }
 
@@ -1988,6 +2197,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetFrontFace(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetFrontFace\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::FrontFace, &frontFace, sizeof(frontFace))) {
+        return;
+    }
     vn_async_vkCmdSetFrontFace(&g_ring, remote_cb, frontFace);
 }
 
@@ -2015,6 +2227,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetPrimitiveTopology(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetPrimitiveTopology\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::PrimitiveTopology, &primitiveTopology, sizeof(primitiveTopology))) {
+        return;
+    }
     vn_async_vkCmdSetPrimitiveTopology(&g_ring, remote_cb, primitiveTopology);
 }
 
@@ -2047,6 +2262,11 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetViewportWithCount(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetViewportWithCount\n";
         return;
     }
+    StateBlob viewport_state;
+    viewport_state.add(uint32_t(1)).add(viewportCount).add_array(pViewports, viewportCount);
+    if (g_state_filter.filter(commandBuffer, StateSlot::Viewport, viewport_state.data(), viewport_state.size())) {
+        return;
+    }
     vn_async_vkCmdSetViewportWithCount(&g_ring, remote_cb, viewportCount, pViewports);
 }
 
@@ -2080,6 +2300,11 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetScissorWithCount(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetScissorWithCount\n";
         return;
     }
+    StateBlob scissor_state;
+    scissor_state.add(uint32_t(1)).add(scissorCount).add_array(pScissors, scissorCount);
+    if (g_state_filter.filter(commandBuffer, StateSlot::Scissor, scissor_state.data(), scissor_state.size())) {
+        return;
+    }
     vn_async_vkCmdSetScissorWithCount(&g_ring, remote_cb, scissorCount, pScissors);
 }
 
@@ -2108,6 +2333,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthTestEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetDepthTestEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::DepthTestEnable, &depthTestEnable, sizeof(depthTestEnable))) {
+        return;
+    }
     vn_async_vkCmdSetDepthTestEnable(&g_ring, remote_cb, depthTestEnable);
 }
 
@@ -2135,6 +2363,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthWriteEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetDepthWriteEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::DepthWriteEnable, &depthWriteEnable, sizeof(depthWriteEnable))) {
+        return;
+    }
     vn_async_vkCmdSetDepthWriteEnable(&g_ring, remote_cb, depthWriteEnable);
 }
 
@@ -2162,6 +2393,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthCompareOp(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetDepthCompareOp\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::DepthCompareOp, &compareOp, sizeof(compareOp))) {
+        return;
+    }
     vn_async_vkCmdSetDepthCompareOp(&g_ring, remote_cb, compareOp);
 }
 
@@ -2189,6 +2423,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthBoundsTestEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetDepthBoundsTestEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::DepthBoundsTestEnable, &depthBoundsTestEnable, sizeof(depthBoundsTestEnable))) {
+        return;
+    }
     vn_async_vkCmdSetDepthBoundsTestEnable(&g_ring, remote_cb, depthBoundsTestEnable);
 }
 
@@ -2216,6 +2453,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetStencilTestEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetStencilTestEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::StencilTestEnable, &stencilTestEnable, sizeof(stencilTestEnable))) {
+        return;
+    }
     vn_async_vkCmdSetStencilTestEnable(&g_ring, remote_cb, stencilTestEnable);
 }
 
@@ -2247,6 +2487,11 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetStencilOp(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetStencilOp\n";
         return;
     }
+    StateBlob stencil_state;
+    stencil_state.add(faceMask).add(failOp).add(passOp).add(depthFailOp).add(compareOp);
+    if (g_state_filter.filter(commandBuffer, StateSlot::StencilOp, stencil_state.data(), stencil_state.size())) {
+        return;
+    }
     vn_async_vkCmdSetStencilOp(&g_ring, remote_cb, faceMask, failOp, passOp, depthFailOp, compareOp);
 }
 
@@ -2278,6 +2523,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetRasterizerDiscardEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetRasterizerDiscardEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::RasterizerDiscardEnable, &rasterizerDiscardEnable, sizeof(rasterizerDiscardEnable))) {
+        return;
+    }
     vn_async_vkCmdSetRasterizerDiscardEnable(&g_ring, remote_cb, rasterizerDiscardEnable);
 }
 
@@ -2305,6 +2553,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetDepthBiasEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetDepthBiasEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::DepthBiasEnable, &depthBiasEnable, sizeof(depthBiasEnable))) {
+        return;
+    }
     vn_async_vkCmdSetDepthBiasEnable(&g_ring, remote_cb, depthBiasEnable);
 }
 
@@ -2332,6 +2583,9 @@ VKAPI_ATTR void VKAPI_CALL vkCmdSetPrimitiveRestartEnable(
         ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdSetPrimitiveRestartEnable\n";
         return;
     }
+    if (g_state_filter.filter(commandBuffer, StateSlot::PrimitiveRestartEnable, &primitiveRestartEnable, sizeof(primitiveRestartEnable))) {
+        return;
+    }
     vn_async_vkCmdSetPrimitiveRestartEnable(&g_ring, remote_cb, primitiveRestartEnable);
 }
 
@@ -2374,6 +2628,338 @@ VKAPI_ATTR void VKAPI_CALL vkCmdDraw(
     ICD_LOG_INFO() << "[Client ICD] vkCmdDraw recorded\n";
 }
 
+VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkIndexType indexType) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdBindIndexBuffer called\n";
+
+    if (!ensure_command_buffer_recording(commandBuffer, "vkCmdBindIndexBuffer")) {
+        return;
+    }
+
+    VkBuffer remote_buffer = g_resource_state.get_remote_buffer(buffer);
+    if (remote_buffer == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer not tracked in vkCmdBindIndexBuffer\n";
+        return;
+    }
+
+    if (!g_resource_state.buffer_is_bound(buffer)) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer not bound for vkCmdBindIndexBuffer\n";
+        return;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdBindIndexBuffer\n";
+        return;
+    }
+
+    StateBlob index_state;
+    index_state.add(remote_buffer).add(offset).add(indexType);
+    if (g_state_filter.filter(commandBuffer, StateSlot::IndexBuffer, index_state.data(), index_state.size())) {
+        return;
+    }
+
+    vn_async_vkCmdBindIndexBuffer(&g_ring, remote_cb, remote_buffer, offset, indexType);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(
+    VkCommandBuffer commandBuffer,
+    uint32_t indexCount,
+    uint32_t instanceCount,
+    uint32_t firstIndex,
+    int32_t vertexOffset,
+    uint32_t firstInstance) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdDrawIndexed called\n";
+
+    if (!ensure_command_buffer_recording(commandBuffer, "vkCmdDrawIndexed")) {
+        return;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdDrawIndexed\n";
+        return;
+    }
+
+    vn_async_vkCmdDrawIndexed(&g_ring,
+                              remote_cb,
+                              indexCount,
+                              instanceCount,
+                              firstIndex,
+                              vertexOffset,
+                              firstInstance);
+}
+
+// Shared by the four indirect draw entry points: checks the command buffer
+// and translates the argument buffer (and count buffer, when present).
+static bool prepare_indirect_draw(VkCommandBuffer commandBuffer,
+                                  VkBuffer buffer,
+                                  VkBuffer countBuffer,
+                                  bool has_count_buffer,
+                                  const char* name,
+                                  VkCommandBuffer* remote_cb,
+                                  VkBuffer* remote_buffer,
+                                  VkBuffer* remote_count_buffer) {
+    if (!ensure_command_buffer_recording(commandBuffer, name)) {
+        return false;
+    }
+
+    *remote_buffer = g_resource_state.get_remote_buffer(buffer);
+    if (*remote_buffer == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer not tracked in " << name << "\n";
+        return false;
+    }
+    if (!g_resource_state.buffer_is_bound(buffer)) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer not bound for " << name << "\n";
+        return false;
+    }
+
+    *remote_count_buffer = VK_NULL_HANDLE;
+    if (has_count_buffer) {
+        *remote_count_buffer = g_resource_state.get_remote_buffer(countBuffer);
+        if (*remote_count_buffer == VK_NULL_HANDLE) {
+            ICD_LOG_ERROR() << "[Client ICD] Count buffer not tracked in " << name << "\n";
+            return false;
+        }
+        if (!g_resource_state.buffer_is_bound(countBuffer)) {
+            ICD_LOG_ERROR() << "[Client ICD] Count buffer not bound for " << name << "\n";
+            return false;
+        }
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return false;
+    }
+
+    *remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (*remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in " << name << "\n";
+        return false;
+    }
+    return true;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndirect(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    uint32_t drawCount,
+    uint32_t stride) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdDrawIndirect called\n";
+
+    VkCommandBuffer remote_cb = VK_NULL_HANDLE;
+    VkBuffer remote_buffer = VK_NULL_HANDLE;
+    VkBuffer remote_count_buffer = VK_NULL_HANDLE;
+    if (!prepare_indirect_draw(commandBuffer,
+                               buffer,
+                               VK_NULL_HANDLE,
+                               false,
+                               "vkCmdDrawIndirect",
+                               &remote_cb,
+                               &remote_buffer,
+                               &remote_count_buffer)) {
+        return;
+    }
+
+    vn_async_vkCmdDrawIndirect(&g_ring, remote_cb, remote_buffer, offset, drawCount, stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirect(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    uint32_t drawCount,
+    uint32_t stride) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdDrawIndexedIndirect called\n";
+
+    VkCommandBuffer remote_cb = VK_NULL_HANDLE;
+    VkBuffer remote_buffer = VK_NULL_HANDLE;
+    VkBuffer remote_count_buffer = VK_NULL_HANDLE;
+    if (!prepare_indirect_draw(commandBuffer,
+                               buffer,
+                               VK_NULL_HANDLE,
+                               false,
+                               "vkCmdDrawIndexedIndirect",
+                               &remote_cb,
+                               &remote_buffer,
+                               &remote_count_buffer)) {
+        return;
+    }
+
+    vn_async_vkCmdDrawIndexedIndirect(&g_ring, remote_cb, remote_buffer, offset, drawCount, stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndirectCount(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdDrawIndirectCount called\n";
+
+    VkCommandBuffer remote_cb = VK_NULL_HANDLE;
+    VkBuffer remote_buffer = VK_NULL_HANDLE;
+    VkBuffer remote_count_buffer = VK_NULL_HANDLE;
+    if (!prepare_indirect_draw(commandBuffer,
+                               buffer,
+                               countBuffer,
+                               true,
+                               "vkCmdDrawIndirectCount",
+                               &remote_cb,
+                               &remote_buffer,
+                               &remote_count_buffer)) {
+        return;
+    }
+
+    vn_async_vkCmdDrawIndirectCount(&g_ring,
+                                    remote_cb,
+                                    remote_buffer,
+                                    offset,
+                                    remote_count_buffer,
+                                    countBufferOffset,
+                                    maxDrawCount,
+                                    stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndirectCountKHR(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+    vkCmdDrawIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirectCount(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdDrawIndexedIndirectCount called\n";
+
+    VkCommandBuffer remote_cb = VK_NULL_HANDLE;
+    VkBuffer remote_buffer = VK_NULL_HANDLE;
+    VkBuffer remote_count_buffer = VK_NULL_HANDLE;
+    if (!prepare_indirect_draw(commandBuffer,
+                               buffer,
+                               countBuffer,
+                               true,
+                               "vkCmdDrawIndexedIndirectCount",
+                               &remote_cb,
+                               &remote_buffer,
+                               &remote_count_buffer)) {
+        return;
+    }
+
+    vn_async_vkCmdDrawIndexedIndirectCount(&g_ring,
+                                           remote_cb,
+                                           remote_buffer,
+                                           offset,
+                                           remote_count_buffer,
+                                           countBufferOffset,
+                                           maxDrawCount,
+                                           stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirectCountKHR(
+    VkCommandBuffer commandBuffer,
+    VkBuffer buffer,
+    VkDeviceSize offset,
+    VkBuffer countBuffer,
+    VkDeviceSize countBufferOffset,
+    uint32_t maxDrawCount,
+    uint32_t stride) {
+    vkCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdExecuteCommands(
+    VkCommandBuffer commandBuffer,
+    uint32_t commandBufferCount,
+    const VkCommandBuffer* pCommandBuffers) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdExecuteCommands called (count=" << commandBufferCount << ")\n";
+
+    if (!ensure_command_buffer_recording(commandBuffer, "vkCmdExecuteCommands")) {
+        return;
+    }
+
+    if (commandBufferCount == 0 || !pCommandBuffers) {
+        ICD_LOG_ERROR() << "[Client ICD] vkCmdExecuteCommands called without command buffers\n";
+        return;
+    }
+
+    if (g_command_buffer_state.get_buffer_level(commandBuffer) != VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+        ICD_LOG_ERROR() << "[Client ICD] vkCmdExecuteCommands requires a primary command buffer\n";
+        return;
+    }
+
+    std::vector<VkCommandBuffer> remote_secondaries(commandBufferCount);
+    for (uint32_t i = 0; i < commandBufferCount; ++i) {
+        VkCommandBuffer secondary = pCommandBuffers[i];
+        if (!g_command_buffer_state.has_command_buffer(secondary)) {
+            ICD_LOG_ERROR() << "[Client ICD] Secondary command buffer not tracked in vkCmdExecuteCommands\n";
+            return;
+        }
+        if (g_command_buffer_state.get_buffer_level(secondary) != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+            ICD_LOG_ERROR() << "[Client ICD] vkCmdExecuteCommands element " << i << " is not a secondary command buffer\n";
+            return;
+        }
+        if (g_command_buffer_state.get_buffer_state(secondary) != CommandBufferLifecycleState::EXECUTABLE) {
+            ICD_LOG_ERROR() << "[Client ICD] vkCmdExecuteCommands element " << i << " is not executable\n";
+            return;
+        }
+        remote_secondaries[i] = get_remote_command_buffer_handle(secondary);
+        if (remote_secondaries[i] == VK_NULL_HANDLE) {
+            ICD_LOG_ERROR() << "[Client ICD] Remote secondary command buffer missing in vkCmdExecuteCommands\n";
+            return;
+        }
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdExecuteCommands\n";
+        return;
+    }
+
+    g_replay_cache.note_secondaries(commandBuffer, commandBufferCount, pCommandBuffers);
+    g_deferred_recording.note_secondaries(commandBuffer, commandBufferCount, pCommandBuffers);
+    g_state_filter.forget_state(commandBuffer);
+
+    vn_async_vkCmdExecuteCommands(&g_ring, remote_cb, commandBufferCount, remote_secondaries.data());
+}
+
 VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(
     VkCommandBuffer commandBuffer,
     VkPipelineBindPoint pipelineBindPoint,
@@ -2426,6 +3012,20 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(
         return;
     }
 
+    g_replay_cache.note_descriptor_sets(commandBuffer, descriptorSetCount, pDescriptorSets);
+
+    StateBlob set_state;
+    set_state.add(remote_layout).add(firstSet).add(descriptorSetCount);
+    set_state.add_array(remote_sets.data(), static_cast<uint32_t>(remote_sets.size()));
+    set_state.add(dynamicOffsetCount).add_array(pDynamicOffsets, pDynamicOffsets ? dynamicOffsetCount : 0);
+    const StateSlot set_slot = pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+                                   ? StateSlot::GraphicsDescriptorSets
+                                   : StateSlot::ComputeDescriptorSets;
+    if (g_state_filter.filter(commandBuffer, set_slot, set_state.data(), set_state.size())) {
+        return;
+    }
+
+    g_deferred_recording.note_pipeline_layout(commandBuffer, remote_layout);
     vn_async_vkCmdBindDescriptorSets(&g_ring,
                                      remote_cb,
                                      pipelineBindPoint,
@@ -2438,6 +3038,110 @@ VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(
     ICD_LOG_INFO() << "[Client ICD] Descriptor sets bound\n";
 }
 
+VKAPI_ATTR void VKAPI_CALL vkCmdPushDescriptorSetKHR(
+    VkCommandBuffer commandBuffer,
+    VkPipelineBindPoint pipelineBindPoint,
+    VkPipelineLayout layout,
+    uint32_t set,
+    uint32_t descriptorWriteCount,
+    const VkWriteDescriptorSet* pDescriptorWrites) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdPushDescriptorSetKHR called (set=" << set
+                   << ", writes=" << descriptorWriteCount << ")\n";
+
+    if (!ensure_command_buffer_recording(commandBuffer, "vkCmdPushDescriptorSetKHR")) {
+        return;
+    }
+
+    if (descriptorWriteCount > 0 && !pDescriptorWrites) {
+        ICD_LOG_ERROR() << "[Client ICD] Descriptor write array missing in vkCmdPushDescriptorSetKHR\n";
+        return;
+    }
+
+    VkPipelineLayout remote_layout = g_pipeline_state.get_remote_pipeline_layout(layout);
+    if (remote_layout == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Pipeline layout not tracked in vkCmdPushDescriptorSetKHR\n";
+        return;
+    }
+
+    DescriptorWriteStorage remote_writes;
+    if (!translate_descriptor_writes(descriptorWriteCount, pDescriptorWrites, layout, set, &remote_writes)) {
+        return;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdPushDescriptorSetKHR\n";
+        return;
+    }
+
+    g_state_filter.forget_slot(commandBuffer,
+                               pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS
+                                   ? StateSlot::GraphicsDescriptorSets
+                                   : StateSlot::ComputeDescriptorSets);
+    g_deferred_recording.note_pipeline_layout(commandBuffer, remote_layout);
+    vn_async_vkCmdPushDescriptorSet(&g_ring,
+                                    remote_cb,
+                                    pipelineBindPoint,
+                                    remote_layout,
+                                    set,
+                                    descriptorWriteCount,
+                                    remote_writes.writes.empty() ? nullptr : remote_writes.writes.data());
+    ICD_LOG_INFO() << "[Client ICD] Descriptor set pushed\n";
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPushDescriptorSetWithTemplateKHR(
+    VkCommandBuffer commandBuffer,
+    VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+    VkPipelineLayout layout,
+    uint32_t set,
+    const void* pData) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCmdPushDescriptorSetWithTemplateKHR called (set=" << set << ")\n";
+
+    if (!ensure_command_buffer_recording(commandBuffer, "vkCmdPushDescriptorSetWithTemplateKHR")) {
+        return;
+    }
+
+    std::shared_ptr<const DescriptorUpdateTemplateInfo> info =
+        g_pipeline_state.get_descriptor_update_template(descriptorUpdateTemplate);
+    VkPipelineLayout remote_layout = g_pipeline_state.get_remote_pipeline_layout(layout);
+    if (!info || remote_layout == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Template or pipeline layout not tracked in vkCmdPushDescriptorSetWithTemplateKHR\n";
+        return;
+    }
+
+    std::vector<uint8_t> data;
+    if ((!pData && info->packed_size > 0) || !pack_descriptor_update_data(*info, pData, &data)) {
+        ICD_LOG_ERROR() << "[Client ICD] Invalid data in vkCmdPushDescriptorSetWithTemplateKHR\n";
+        return;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing in vkCmdPushDescriptorSetWithTemplateKHR\n";
+        return;
+    }
+
+    g_state_filter.forget_slot(commandBuffer,
+                               info->bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS
+                                   ? StateSlot::GraphicsDescriptorSets
+                                   : StateSlot::ComputeDescriptorSets);
+    g_deferred_recording.note_pipeline_layout(commandBuffer, remote_layout);
+    submit_push_descriptor_set_with_template(remote_cb, info->remote_handle, remote_layout, set, data);
+    ICD_LOG_INFO() << "[Client ICD] Descriptor set pushed from template (" << data.size() << " bytes)\n";
+}
+
 VKAPI_ATTR void VKAPI_CALL vkCmdDispatch(
     VkCommandBuffer commandBuffer,
     uint32_t groupCountX,
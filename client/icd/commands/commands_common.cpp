@@ -7,6 +7,11 @@
 NetworkClient g_client;
 vn_ring g_ring = {};
 bool g_connected = false;
+std::atomic<uint64_t> g_shader_store_hits{0};
+std::atomic<uint64_t> g_descriptor_sets_local{0};
+std::atomic<uint64_t> g_descriptor_pool_refusals{0};
+std::atomic<uint64_t> g_staged_memory_transfers{0};
+std::atomic<uint64_t> g_inline_uploads{0};
 
 // Constructor - runs when the shared library is loaded
 __attribute__((constructor))
@@ -15,3 +20,51 @@ static void icd_init() {
     ICD_LOG_INFO() << "VENUS PLUS ICD LOADED!\n";
     ICD_LOG_INFO() << "===========================================\n\n";
 }
+
+void upload_deferred_recording(VkCommandBuffer commandBuffer, std::vector<VkCommandBuffer>* uploaded) {
+    std::vector<uint8_t> stream;
+    std::vector<VkCommandBuffer> secondaries;
+    if (!g_deferred_recording.take(commandBuffer, &stream, &secondaries)) {
+        return;
+    }
+    // The server checks that executed secondaries are ready while it records.
+    for (VkCommandBuffer secondary : secondaries) {
+        upload_deferred_recording(secondary, uploaded);
+    }
+
+    VkCommandBuffer remote_cb = get_remote_command_buffer_handle(commandBuffer);
+    if (remote_cb == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote command buffer missing for deferred recording\n";
+        return;
+    }
+
+    uint64_t stream_hash = 0;
+    if (g_replay_cache.enabled()) {
+        if (g_replay_cache.can_reuse(commandBuffer, stream, &stream_hash) &&
+            send_reuse_recording(remote_cb, stream_hash, false)) {
+            g_replay_cache.record_hit(stream.size());
+            g_command_buffer_state.take_reset_elided(commandBuffer);
+            g_deferred_recording.release_pipeline_layouts(commandBuffer);
+            ICD_LOG_INFO() << "[Client ICD] Deferred recording reused (" << stream.size()
+                           << " bytes not sent)\n";
+            return;
+        }
+    }
+
+    // Begin, the commands and end go out with the submit; a failure on the
+    // server leaves the buffer invalid there and that submit fails.
+    const size_t stream_size = stream.size();
+    send_reset_elided(commandBuffer, remote_cb);
+    vn_ring_submit_encoded(&g_ring, stream.data(), stream_size);
+    vn_async_vkEndCommandBuffer(&g_ring, remote_cb);
+    g_deferred_recording.release_pipeline_layouts(commandBuffer);
+    if (g_replay_cache.enabled()) {
+        // Provisional: the end's result is unknown until the submit, which
+        // invalidates this entry if it fails.
+        g_replay_cache.record_miss(commandBuffer, stream_hash, &stream);
+    }
+    if (uploaded) {
+        uploaded->push_back(commandBuffer);
+    }
+    ICD_LOG_INFO() << "[Client ICD] Deferred recording uploaded (" << stream_size << " bytes)\n";
+}
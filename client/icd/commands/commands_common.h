@@ -14,6 +14,12 @@
 #include "state/resource_state.h"
 #include "state/query_state.h"
 #include "state/pipeline_state.h"
+#include "state/memory_requirements_cache.h"
+#include "state/memory_type_map.h"
+#include "state/physical_device_cache.h"
+#include "state/replay_cache.h"
+#include "state/deferred_recording.h"
+#include "state/state_filter.h"
 #include "state/shadow_buffer.h"
 #include "state/command_buffer_state.h"
 #include "state/sync_state.h"
@@ -21,6 +27,9 @@
 #include "wsi/platform_wsi.h"
 #include "protocol/memory_transfer.h"
 #include "protocol/frame_transfer.h"
+#include "protocol/command_replay.h"
+#include "protocol/shader_cache.h"
+#include "utils/sha256.h"
 #include "branding.h"
 #include "vn_protocol_driver.h"
 #include "vn_ring.h"
@@ -61,6 +70,15 @@ inline bool memory_trace_enabled() {
 extern NetworkClient g_client;
 extern vn_ring g_ring;
 extern bool g_connected;
+// Shader modules the server created from its SPIR-V store by hash alone.
+extern std::atomic<uint64_t> g_shader_store_hits;
+// Descriptor set allocations answered from the client's pool budgets.
+extern std::atomic<uint64_t> g_descriptor_sets_local;
+extern std::atomic<uint64_t> g_descriptor_pool_refusals;
+// Mapped-memory transfers the server staged into device-local memory.
+extern std::atomic<uint64_t> g_staged_memory_transfers;
+// vkCmdUpdateBuffer calls captured as inline upload regions.
+extern std::atomic<uint64_t> g_inline_uploads;
 
 // Common helper functions (inline for performance)
 
@@ -144,6 +162,85 @@ inline VkCommandBuffer get_remote_command_buffer_handle(VkCommandBuffer commandB
     return icd_cb ? icd_cb->remote_handle : VK_NULL_HANDLE;
 }
 
+// Drops the replay-cache entry, deferred recording, state-filter scope and
+// any open capture of a command buffer that is freed (directly, with its pool
+// or with its device).
+inline void forget_command_buffer_recording(VkCommandBuffer commandBuffer) {
+    IcdCommandBuffer* icd_cb = icd_command_buffer_from_handle(commandBuffer);
+    if (icd_cb) {
+        vn_ring_end_capture(&g_ring, reinterpret_cast<uint64_t>(icd_cb->remote_handle), nullptr);
+    }
+    g_replay_cache.remove(commandBuffer);
+    g_deferred_recording.remove(commandBuffer);
+    g_state_filter.end_scope(commandBuffer);
+}
+
+// Asks the server to keep its recording of |remote_cb| instead of receiving
+// the stream again. False when it no longer holds an executable recording;
+// without |wait_for_reply| that only shows in the submit that follows.
+inline bool send_reuse_recording(VkCommandBuffer remote_cb, uint64_t stream_hash, bool wait_for_reply) {
+    // Anything queued before this recording must reach the server first.
+    vn_ring_flush_pending(&g_ring);
+
+    ReuseRecordingRequest request = {};
+    request.command = VENUS_PLUS_CMD_REUSE_RECORDING;
+    request.flags = wait_for_reply ? 0u : VENUS_PLUS_REUSE_RECORDING_NO_REPLY;
+    request.command_buffer = reinterpret_cast<uint64_t>(remote_cb);
+    request.stream_hash = stream_hash;
+    if (!g_client.send(&request, sizeof(request))) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to send reuse recording request\n";
+        return false;
+    }
+    if (!wait_for_reply) {
+        return true;
+    }
+
+    std::vector<uint8_t> reply;
+    if (!g_client.receive(reply) || reply.size() < sizeof(VkResult)) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to receive reuse recording reply\n";
+        return false;
+    }
+    VkResult result = VK_ERROR_DEVICE_LOST;
+    std::memcpy(&result, reply.data(), sizeof(VkResult));
+    return result == VK_SUCCESS;
+}
+
+// Before uploading a recording of |commandBuffer|: when its last reset was
+// kept from the server, lets the begin in the stream reset the server's
+// buffer implicitly. A replay hit needs no begin, so callers only clear the
+// mark there (take_reset_elided()).
+inline void send_reset_elided(VkCommandBuffer commandBuffer, VkCommandBuffer remote_cb) {
+    if (!g_command_buffer_state.take_reset_elided(commandBuffer)) {
+        return;
+    }
+    vn_ring_flush_pending(&g_ring);
+
+    ResetElidedRequest request = {};
+    request.command = VENUS_PLUS_CMD_RESET_ELIDED;
+    request.command_buffer = reinterpret_cast<uint64_t>(remote_cb);
+    if (!g_client.send(&request, sizeof(request))) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to send reset elided marker\n";
+    }
+}
+
+// Sends the recording vkEndCommandBuffer kept for |commandBuffer|, after the
+// secondaries it executes, ahead of the submit that uses it. No-op when
+// nothing is waiting. The command buffers sent in full are appended to
+// |uploaded|. Defined in commands_common.cpp.
+void upload_deferred_recording(VkCommandBuffer commandBuffer, std::vector<VkCommandBuffer>* uploaded);
+
+// A failed submit may mean a recording uploaded for it failed on the server
+// (its end's result only shows there), so none of the command buffers
+// involved is reused from the server without being sent again.
+inline void invalidate_failed_submit(const std::vector<VkCommandBuffer>& command_buffers) {
+    if (!g_replay_cache.enabled()) {
+        return;
+    }
+    for (VkCommandBuffer command_buffer : command_buffers) {
+        g_replay_cache.invalidate(command_buffer);
+    }
+}
+
 inline VkPhysicalDevice get_remote_physical_device_handle(VkPhysicalDevice physicalDevice,
                                                           const char* func_name) {
     InstanceState* state = g_instance_state.get_instance_by_physical_device(physicalDevice);
@@ -337,6 +434,13 @@ struct RenderingInfoStorage {
     bool has_stencil = false;
 };
 
+struct DescriptorWriteStorage {
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorBufferInfo> buffer_infos;
+    std::vector<VkDescriptorImageInfo> image_infos;
+    std::vector<VkBufferView> texel_views;
+};
+
 // Helper function: check payload size
 inline bool check_payload_size(size_t payload_size) {
     if (payload_size > std::numeric_limits<uint32_t>::max()) {
@@ -492,6 +596,55 @@ inline bool populate_dependency_info(const VkDependencyInfo* src,
     return true;
 }
 
+// The device's physical device, with its reported memory types known to
+// g_memory_type_map; VK_NULL_HANDLE when the device is unknown.
+inline VkPhysicalDevice memory_type_physical_device(VkDevice device) {
+    DeviceEntry* entry = g_device_state.get_device(device);
+    if (!entry) {
+        return VK_NULL_HANDLE;
+    }
+    if (!g_memory_type_map.known(entry->physical_device)) {
+        VkPhysicalDeviceMemoryProperties properties;
+        vkGetPhysicalDeviceMemoryProperties(entry->physical_device, &properties);
+    }
+    return entry->physical_device;
+}
+
+// Helper function: server memory type bits as the application sees them.
+// Staged types are offered only to |stageable| resources.
+inline void report_memory_type_bits(VkDevice device, VkMemoryRequirements* requirements, bool stageable) {
+    requirements->memoryTypeBits = g_memory_type_map.reported_bits(
+        memory_type_physical_device(device), requirements->memoryTypeBits, stageable);
+}
+
+// Usage the server needs to stage memory dedicated to a buffer through the
+// buffer itself.
+constexpr VkBufferUsageFlags kStagingBufferUsage =
+    VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+// Helper function: |info| as the server creates the buffer. Without a pNext
+// chain, which may carry usage or external memory of its own, it gets the
+// staging usage when the device reports staged types.
+inline VkBufferCreateInfo staged_buffer_info(VkDevice device, const VkBufferCreateInfo& info) {
+    VkBufferCreateInfo real_info = info;
+    if (!info.pNext && g_memory_type_map.stages(memory_type_physical_device(device))) {
+        real_info.usage |= kStagingBufferUsage;
+    }
+    return real_info;
+}
+
+// Helper function: whether the server can stage memory dedicated to a buffer
+// the server creates with |info|
+inline bool buffer_stageable(const VkBufferCreateInfo& info) {
+    VkBufferUsageFlags2 usage = info.usage;
+    for (auto* next = static_cast<const VkBaseInStructure*>(info.pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_BUFFER_USAGE_FLAGS_2_CREATE_INFO) {
+            usage = reinterpret_cast<const VkBufferUsageFlags2CreateInfo*>(next)->usage;
+        }
+    }
+    return (usage & kStagingBufferUsage) == kStagingBufferUsage;
+}
+
 // Helper function: validate memory offset for buffer/image binding
 inline bool validate_memory_offset(const VkMemoryRequirements& requirements,
                                    VkDeviceSize memory_size,
@@ -562,6 +715,28 @@ VkResult read_memory_data(VkDeviceMemory memory,
 bool send_swapchain_command(const void* request,
                             size_t request_size,
                             std::vector<uint8_t>* reply);
+// Descriptor writes with remote handles. Push descriptor writes have no
+// set; they give the (local) pipeline layout and set they push to, which
+// is null for vkUpdateDescriptorSets.
+bool translate_descriptor_writes(uint32_t count,
+                                 const VkWriteDescriptorSet* writes,
+                                 VkPipelineLayout push_layout,
+                                 uint32_t push_set,
+                                 DescriptorWriteStorage* storage);
+// Application template data in the packed layout of |info|, with remote
+// handles.
+bool pack_descriptor_update_data(const DescriptorUpdateTemplateInfo& info,
+                                 const void* data,
+                                 std::vector<uint8_t>* packed);
+void submit_update_descriptor_set_with_template(VkDevice remote_device,
+                                                VkDescriptorSet remote_set,
+                                                VkDescriptorUpdateTemplate remote_template,
+                                                const std::vector<uint8_t>& data);
+void submit_push_descriptor_set_with_template(VkCommandBuffer remote_cb,
+                                              VkDescriptorUpdateTemplate remote_template,
+                                              VkPipelineLayout remote_layout,
+                                              uint32_t set,
+                                              const std::vector<uint8_t>& data);
 
 inline VkResult flush_host_coherent_mappings(VkDevice device) {
     if (device == VK_NULL_HANDLE) {
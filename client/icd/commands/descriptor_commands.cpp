@@ -3,6 +3,358 @@
 
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
+#include <cstring>
+
+namespace {
+
+enum class DescriptorData { kNone, kBuffer, kImage, kTexelBuffer, kInlineBlock };
+
+DescriptorData descriptor_data(VkDescriptorType type) {
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        return DescriptorData::kBuffer;
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        return DescriptorData::kImage;
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        return DescriptorData::kTexelBuffer;
+    case VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK:
+        return DescriptorData::kInlineBlock;
+    default:
+        return DescriptorData::kNone;
+    }
+}
+
+// Size of one descriptor in template data; inline uniform blocks count
+// bytes. 0 for types the server cannot translate.
+size_t descriptor_data_size(VkDescriptorType type) {
+    switch (descriptor_data(type)) {
+    case DescriptorData::kBuffer:
+        return sizeof(VkDescriptorBufferInfo);
+    case DescriptorData::kImage:
+        return sizeof(VkDescriptorImageInfo);
+    case DescriptorData::kTexelBuffer:
+        return sizeof(VkBufferView);
+    case DescriptorData::kInlineBlock:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Lays the entries out back to back with tight strides, each starting 8-byte
+// aligned so the handles in it are.
+bool pack_descriptor_update_entries(const VkDescriptorUpdateTemplateCreateInfo& info,
+                                    std::vector<VkDescriptorUpdateTemplateEntry>* packed,
+                                    size_t* packed_size) {
+    packed->assign(info.pDescriptorUpdateEntries,
+                   info.pDescriptorUpdateEntries + info.descriptorUpdateEntryCount);
+    size_t offset = 0;
+    for (VkDescriptorUpdateTemplateEntry& entry : *packed) {
+        const size_t element_size = descriptor_data_size(entry.descriptorType);
+        if (element_size == 0) {
+            return false;
+        }
+        entry.offset = offset;
+        entry.stride = element_size;
+        offset += (static_cast<size_t>(entry.descriptorCount) * element_size + 7) & ~static_cast<size_t>(7);
+    }
+    *packed_size = offset;
+    return true;
+}
+
+// Null stays null; false for a handle that is not tracked.
+template <typename T>
+bool to_remote(T handle, T (*lookup)(T), T* out) {
+    *out = handle != VK_NULL_HANDLE ? lookup(handle) : VK_NULL_HANDLE;
+    return handle == VK_NULL_HANDLE || *out != VK_NULL_HANDLE;
+}
+
+VkBuffer remote_buffer(VkBuffer buffer) {
+    return g_resource_state.get_remote_buffer(buffer);
+}
+
+VkImageView remote_image_view(VkImageView view) {
+    return g_resource_state.get_remote_image_view(view);
+}
+
+VkSampler remote_sampler(VkSampler sampler) {
+    return g_resource_state.get_remote_sampler(sampler);
+}
+
+VkBufferView remote_buffer_view(VkBufferView view) {
+    return g_resource_state.get_remote_buffer_view(view);
+}
+
+// |immutable_sampler|: the binding's samplers are immutable.
+bool translate_image_info(VkDescriptorType type,
+                          bool immutable_sampler,
+                          const VkDescriptorImageInfo& src,
+                          VkDescriptorImageInfo* dst) {
+    // Each type reads only its half of the info; the other may be garbage,
+    // as is the sampler of a binding with immutable samplers.
+    dst->imageLayout = src.imageLayout;
+    dst->sampler = VK_NULL_HANDLE;
+    dst->imageView = VK_NULL_HANDLE;
+    const bool uses_sampler = type == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                              (type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && !immutable_sampler);
+    if (uses_sampler && !to_remote(src.sampler, remote_sampler, &dst->sampler)) {
+        ICD_LOG_ERROR() << "[Client ICD] Sampler not tracked for descriptor update\n";
+        return false;
+    }
+    if (type != VK_DESCRIPTOR_TYPE_SAMPLER && !to_remote(src.imageView, remote_image_view, &dst->imageView)) {
+        ICD_LOG_ERROR() << "[Client ICD] Image view not tracked for descriptor update\n";
+        return false;
+    }
+    return true;
+}
+
+bool has_immutable_samplers(const VkDescriptorSetLayoutBinding& binding) {
+    return (binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+            binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) &&
+           binding.pImmutableSamplers;
+}
+
+bool translate_buffer_info(const VkDescriptorBufferInfo& src, VkDescriptorBufferInfo* dst) {
+    *dst = src;
+    if (!to_remote(src.buffer, remote_buffer, &dst->buffer)) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer not tracked for descriptor update\n";
+        return false;
+    }
+    return true;
+}
+
+bool translate_texel_view(VkBufferView src, VkBufferView* dst) {
+    if (!to_remote(src, remote_buffer_view, dst)) {
+        ICD_LOG_ERROR() << "[Client ICD] Buffer view not tracked for descriptor update\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool translate_descriptor_writes(uint32_t count,
+                                 const VkWriteDescriptorSet* writes,
+                                 VkPipelineLayout push_layout,
+                                 uint32_t push_set,
+                                 DescriptorWriteStorage* storage) {
+    // Sized up front: the translated writes point into these arrays.
+    size_t buffer_count = 0;
+    size_t image_count = 0;
+    size_t view_count = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        switch (descriptor_data(writes[i].descriptorType)) {
+        case DescriptorData::kBuffer:
+            buffer_count += writes[i].descriptorCount;
+            break;
+        case DescriptorData::kImage:
+            image_count += writes[i].descriptorCount;
+            break;
+        case DescriptorData::kTexelBuffer:
+            view_count += writes[i].descriptorCount;
+            break;
+        default:
+            break;
+        }
+    }
+    storage->writes.resize(count);
+    storage->buffer_infos.resize(buffer_count);
+    storage->image_infos.resize(image_count);
+    storage->texel_views.resize(view_count);
+    VkDescriptorBufferInfo* buffer_infos = storage->buffer_infos.data();
+    VkDescriptorImageInfo* image_infos = storage->image_infos.data();
+    VkBufferView* texel_views = storage->texel_views.data();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const VkWriteDescriptorSet& src = writes[i];
+        VkWriteDescriptorSet& dst = storage->writes[i];
+        dst = src;
+        if (push_layout == VK_NULL_HANDLE) {
+            dst.dstSet = g_pipeline_state.get_remote_descriptor_set(src.dstSet);
+            if (dst.dstSet == VK_NULL_HANDLE) {
+                ICD_LOG_ERROR() << "[Client ICD] Descriptor set not tracked for descriptor update\n";
+                return false;
+            }
+        }
+        dst.pBufferInfo = nullptr;
+        dst.pImageInfo = nullptr;
+        dst.pTexelBufferView = nullptr;
+
+        switch (descriptor_data(src.descriptorType)) {
+        case DescriptorData::kBuffer:
+            if (!src.pBufferInfo) {
+                ICD_LOG_ERROR() << "[Client ICD] Missing buffer info for descriptor update\n";
+                return false;
+            }
+            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
+                if (!translate_buffer_info(src.pBufferInfo[j], &buffer_infos[j])) {
+                    return false;
+                }
+            }
+            dst.pBufferInfo = buffer_infos;
+            buffer_infos += src.descriptorCount;
+            break;
+        case DescriptorData::kImage: {
+            if (!src.pImageInfo) {
+                ICD_LOG_ERROR() << "[Client ICD] Missing image info for descriptor update\n";
+                return false;
+            }
+            const bool immutable_sampler =
+                src.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER &&
+                (push_layout == VK_NULL_HANDLE
+                     ? g_pipeline_state.has_immutable_samplers(src.dstSet, src.dstBinding)
+                     : g_pipeline_state.has_immutable_samplers(push_layout, push_set, src.dstBinding));
+            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
+                if (!translate_image_info(src.descriptorType, immutable_sampler, src.pImageInfo[j], &image_infos[j])) {
+                    return false;
+                }
+            }
+            dst.pImageInfo = image_infos;
+            image_infos += src.descriptorCount;
+            break;
+        }
+        case DescriptorData::kTexelBuffer:
+            if (!src.pTexelBufferView) {
+                ICD_LOG_ERROR() << "[Client ICD] Missing texel buffer info for descriptor update\n";
+                return false;
+            }
+            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
+                if (!translate_texel_view(src.pTexelBufferView[j], &texel_views[j])) {
+                    return false;
+                }
+            }
+            dst.pTexelBufferView = texel_views;
+            texel_views += src.descriptorCount;
+            break;
+        case DescriptorData::kInlineBlock:
+            // The data travels in the pNext chain.
+            break;
+        default:
+            if (src.descriptorCount > 0) {
+                ICD_LOG_ERROR() << "[Client ICD] Unsupported descriptor type for descriptor update\n";
+                return false;
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool pack_descriptor_update_data(const DescriptorUpdateTemplateInfo& info,
+                                 const void* data,
+                                 std::vector<uint8_t>* packed) {
+    packed->assign(info.packed_size, 0);
+    const uint8_t* src_bytes = static_cast<const uint8_t*>(data);
+    uint8_t* dst_bytes = packed->data();
+    for (size_t i = 0; i < info.entries.size(); ++i) {
+        const VkDescriptorUpdateTemplateEntry& entry = info.entries[i];
+        const VkDescriptorUpdateTemplateEntry& packed_entry = info.packed_entries[i];
+        if (entry.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+            std::memcpy(dst_bytes + packed_entry.offset, src_bytes + entry.offset, entry.descriptorCount);
+            continue;
+        }
+        for (uint32_t j = 0; j < entry.descriptorCount; ++j) {
+            const uint8_t* src = src_bytes + entry.offset + j * entry.stride;
+            uint8_t* dst = dst_bytes + packed_entry.offset + j * packed_entry.stride;
+            switch (descriptor_data(entry.descriptorType)) {
+            case DescriptorData::kBuffer: {
+                VkDescriptorBufferInfo info_in;
+                VkDescriptorBufferInfo info_out;
+                std::memcpy(&info_in, src, sizeof(info_in));
+                if (!translate_buffer_info(info_in, &info_out)) {
+                    return false;
+                }
+                std::memcpy(dst, &info_out, sizeof(info_out));
+                break;
+            }
+            case DescriptorData::kImage: {
+                VkDescriptorImageInfo info_in;
+                VkDescriptorImageInfo info_out;
+                std::memcpy(&info_in, src, sizeof(info_in));
+                if (!translate_image_info(entry.descriptorType, info.immutable_samplers[i], info_in, &info_out)) {
+                    return false;
+                }
+                std::memcpy(dst, &info_out, sizeof(info_out));
+                break;
+            }
+            case DescriptorData::kTexelBuffer: {
+                VkBufferView view_in;
+                VkBufferView view_out;
+                std::memcpy(&view_in, src, sizeof(view_in));
+                if (!translate_texel_view(view_in, &view_out)) {
+                    return false;
+                }
+                std::memcpy(dst, &view_out, sizeof(view_out));
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The protocol has no encoder for commands taking a void*; the server's
+// decoder (dispatch_next_command) reads these two in this form.
+void submit_update_descriptor_set_with_template(VkDevice remote_device,
+                                                VkDescriptorSet remote_set,
+                                                VkDescriptorUpdateTemplate remote_template,
+                                                const std::vector<uint8_t>& data) {
+    const VkCommandTypeEXT type = VK_COMMAND_TYPE_vkUpdateDescriptorSetWithTemplate_EXT;
+    const VkFlags flags = 0;
+    const size_t size = data.size();
+    std::vector<uint8_t> command(vn_sizeof_VkCommandTypeEXT(&type) + vn_sizeof_VkFlags(&flags) +
+                                 vn_sizeof_VkDevice(&remote_device) + vn_sizeof_VkDescriptorSet(&remote_set) +
+                                 vn_sizeof_VkDescriptorUpdateTemplate(&remote_template) + vn_sizeof_size_t(&size) +
+                                 vn_sizeof_blob_array(data.data(), size));
+    struct vn_ring_submit_command submit;
+    vn_cs_encoder* enc = vn_ring_submit_command_init(&g_ring, &submit, command.data(), command.size(), 0);
+    vn_encode_VkCommandTypeEXT(enc, &type);
+    vn_encode_VkFlags(enc, &flags);
+    vn_encode_VkDevice(enc, &remote_device);
+    vn_encode_VkDescriptorSet(enc, &remote_set);
+    vn_encode_VkDescriptorUpdateTemplate(enc, &remote_template);
+    vn_encode_size_t(enc, &size);
+    vn_encode_blob_array(enc, data.data(), size);
+    vn_ring_submit_command(&g_ring, &submit);
+}
+
+void submit_push_descriptor_set_with_template(VkCommandBuffer remote_cb,
+                                              VkDescriptorUpdateTemplate remote_template,
+                                              VkPipelineLayout remote_layout,
+                                              uint32_t set,
+                                              const std::vector<uint8_t>& data) {
+    const VkCommandTypeEXT type = VK_COMMAND_TYPE_vkCmdPushDescriptorSetWithTemplate_EXT;
+    const VkFlags flags = 0;
+    const size_t size = data.size();
+    std::vector<uint8_t> command(vn_sizeof_VkCommandTypeEXT(&type) + vn_sizeof_VkFlags(&flags) +
+                                 vn_sizeof_VkCommandBuffer(&remote_cb) +
+                                 vn_sizeof_VkDescriptorUpdateTemplate(&remote_template) +
+                                 vn_sizeof_VkPipelineLayout(&remote_layout) + vn_sizeof_uint32_t(&set) +
+                                 vn_sizeof_size_t(&size) + vn_sizeof_blob_array(data.data(), size));
+    struct vn_ring_submit_command submit;
+    vn_cs_encoder* enc = vn_ring_submit_command_init(&g_ring, &submit, command.data(), command.size(), 0);
+    vn_encode_VkCommandTypeEXT(enc, &type);
+    vn_encode_VkFlags(enc, &flags);
+    // The command buffer comes first, so the command is captured with the
+    // rest of the recording like any vkCmd*.
+    vn_encode_VkCommandBuffer(enc, &remote_cb);
+    vn_encode_VkDescriptorUpdateTemplate(enc, &remote_template);
+    vn_encode_VkPipelineLayout(enc, &remote_layout);
+    vn_encode_uint32_t(enc, &set);
+    vn_encode_size_t(enc, &size);
+    vn_encode_blob_array(enc, data.data(), size);
+    vn_ring_submit_command(&g_ring, &submit);
+}
 
 extern "C" {
 
@@ -31,11 +383,46 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    // Immutable samplers go out as remote handles. Bindings of other types
+    // ignore the pointer, so it is cleared rather than encoded.
+    VkDescriptorSetLayoutCreateInfo remote_info = *pCreateInfo;
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkSampler> samplers;
+    bool has_pointers = false;
+    size_t sampler_count = 0;
+    for (uint32_t i = 0; i < pCreateInfo->bindingCount; ++i) {
+        has_pointers |= pCreateInfo->pBindings[i].pImmutableSamplers != nullptr;
+        if (has_immutable_samplers(pCreateInfo->pBindings[i])) {
+            sampler_count += pCreateInfo->pBindings[i].descriptorCount;
+        }
+    }
+    if (has_pointers) {
+        bindings.assign(pCreateInfo->pBindings, pCreateInfo->pBindings + pCreateInfo->bindingCount);
+        samplers.resize(sampler_count);
+        VkSampler* next_sampler = samplers.data();
+        for (VkDescriptorSetLayoutBinding& binding : bindings) {
+            if (!has_immutable_samplers(binding)) {
+                binding.pImmutableSamplers = nullptr;
+                continue;
+            }
+            for (uint32_t j = 0; j < binding.descriptorCount; ++j) {
+                next_sampler[j] = remote_sampler(binding.pImmutableSamplers[j]);
+                if (next_sampler[j] == VK_NULL_HANDLE) {
+                    ICD_LOG_ERROR() << "[Client ICD] Immutable sampler not tracked in vkCreateDescriptorSetLayout\n";
+                    return VK_ERROR_INITIALIZATION_FAILED;
+                }
+            }
+            binding.pImmutableSamplers = next_sampler;
+            next_sampler += binding.descriptorCount;
+        }
+        remote_info.pBindings = bindings.data();
+    }
+
     IcdDevice* icd_device = icd_device_from_handle(device);
     VkDescriptorSetLayout remote_layout = VK_NULL_HANDLE;
     VkResult result = vn_call_vkCreateDescriptorSetLayout(&g_ring,
                                                           icd_device->remote_handle,
-                                                          pCreateInfo,
+                                                          &remote_info,
                                                           pAllocator,
                                                           &remote_layout);
     if (result != VK_SUCCESS) {
@@ -44,7 +431,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(
     }
 
     VkDescriptorSetLayout local = g_handle_allocator.allocate<VkDescriptorSetLayout>();
-    g_pipeline_state.add_descriptor_set_layout(device, local, remote_layout);
+    g_pipeline_state.add_descriptor_set_layout(device, local, remote_layout, *pCreateInfo);
     *pSetLayout = local;
     ICD_LOG_INFO() << "[Client ICD] Descriptor set layout created (local=" << local << ")\n";
     return VK_SUCCESS;
@@ -125,7 +512,7 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(
     }
 
     VkDescriptorPool local = g_handle_allocator.allocate<VkDescriptorPool>();
-    g_pipeline_state.add_descriptor_pool(device, local, remote_pool, pCreateInfo->flags);
+    g_pipeline_state.add_descriptor_pool(device, local, remote_pool, *pCreateInfo);
     *pDescriptorPool = local;
     ICD_LOG_INFO() << "[Client ICD] Descriptor pool created (local=" << local << ")\n";
     return VK_SUCCESS;
@@ -195,17 +582,11 @@ VKAPI_ATTR VkResult VKAPI_CALL vkResetDescriptorPool(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    // Resetting cannot fail, so nothing waits for the server.
     IcdDevice* icd_device = icd_device_from_handle(device);
-    VkResult result = vn_call_vkResetDescriptorPool(&g_ring,
-                                                    icd_device->remote_handle,
-                                                    remote_pool,
-                                                    flags);
-    if (result == VK_SUCCESS) {
-        g_pipeline_state.reset_descriptor_pool(descriptorPool);
-    } else {
-        ICD_LOG_ERROR() << "[Client ICD] vkResetDescriptorPool failed: " << result << "\n";
-    }
-    return result;
+    vn_async_vkResetDescriptorPool(&g_ring, icd_device->remote_handle, remote_pool, flags);
+    g_pipeline_state.reset_descriptor_pool(descriptorPool);
+    return VK_SUCCESS;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(
@@ -256,19 +637,42 @@ VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(
         }
     }
 
+    // Within the pool's tracked budget the sets get client-issued handles
+    // and the server creates them behind the reply-less command. A failure
+    // there is kept on the server's pool and returned by the next allocation
+    // that waits, which check_descriptor_allocation() schedules regularly.
+    const DescriptorAllocation allocation = g_pipeline_state.check_descriptor_allocation(*pAllocateInfo);
+    if (allocation == DescriptorAllocation::kOutOfPoolMemory) {
+        ICD_LOG_INFO() << "[Client ICD] Descriptor pool budget exhausted\n";
+        g_descriptor_pool_refusals.fetch_add(1, std::memory_order_relaxed);
+        return VK_ERROR_OUT_OF_POOL_MEMORY;
+    }
+
     VkDescriptorSetAllocateInfo remote_info = *pAllocateInfo;
     remote_info.descriptorPool = remote_pool;
     remote_info.pSetLayouts = remote_layouts.data();
 
     IcdDevice* icd_device = icd_device_from_handle(device);
     std::vector<VkDescriptorSet> remote_sets(pAllocateInfo->descriptorSetCount);
-    VkResult result = vn_call_vkAllocateDescriptorSets(&g_ring,
-                                                       icd_device->remote_handle,
-                                                       &remote_info,
-                                                       remote_sets.data());
-    if (result != VK_SUCCESS) {
-        ICD_LOG_ERROR() << "[Client ICD] vkAllocateDescriptorSets failed: " << result << "\n";
-        return result;
+    if (allocation == DescriptorAllocation::kLocal) {
+        for (VkDescriptorSet& remote_set : remote_sets) {
+            remote_set = g_pipeline_state.next_client_descriptor_set();
+        }
+        vn_async_vkAllocateDescriptorSets(&g_ring,
+                                          icd_device->remote_handle,
+                                          &remote_info,
+                                          remote_sets.data());
+        g_descriptor_sets_local.fetch_add(pAllocateInfo->descriptorSetCount, std::memory_order_relaxed);
+    } else {
+        VkResult result = vn_call_vkAllocateDescriptorSets(&g_ring,
+                                                           icd_device->remote_handle,
+                                                           &remote_info,
+                                                           remote_sets.data());
+        if (result != VK_SUCCESS) {
+            ICD_LOG_ERROR() << "[Client ICD] vkAllocateDescriptorSets failed: " << result << "\n";
+            g_pipeline_state.distrust_descriptor_budget(pAllocateInfo->descriptorPool);
+            return result;
+        }
     }
 
     for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; ++i) {
@@ -277,7 +681,8 @@ VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(
                                             pAllocateInfo->descriptorPool,
                                             pAllocateInfo->pSetLayouts[i],
                                             local,
-                                            remote_sets[i]);
+                                            remote_sets[i],
+                                            pAllocateInfo->pNext != nullptr);
         pDescriptorSets[i] = local;
     }
 
@@ -326,21 +731,18 @@ VKAPI_ATTR VkResult VKAPI_CALL vkFreeDescriptorSets(
         }
     }
 
+    // Freeing cannot fail, so nothing waits for the server.
     IcdDevice* icd_device = icd_device_from_handle(device);
-    VkResult result = vn_call_vkFreeDescriptorSets(&g_ring,
-                                                   icd_device->remote_handle,
-                                                   remote_pool,
-                                                   descriptorSetCount,
-                                                   remote_sets.data());
-    if (result == VK_SUCCESS) {
-        for (uint32_t i = 0; i < descriptorSetCount; ++i) {
-            g_pipeline_state.remove_descriptor_set(pDescriptorSets[i]);
-        }
-        ICD_LOG_INFO() << "[Client ICD] Freed " << descriptorSetCount << " descriptor set(s)\n";
-    } else {
-        ICD_LOG_ERROR() << "[Client ICD] vkFreeDescriptorSets failed: " << result << "\n";
+    vn_async_vkFreeDescriptorSets(&g_ring,
+                                  icd_device->remote_handle,
+                                  remote_pool,
+                                  descriptorSetCount,
+                                  remote_sets.data());
+    for (uint32_t i = 0; i < descriptorSetCount; ++i) {
+        g_pipeline_state.remove_descriptor_set(pDescriptorSets[i]);
     }
-    return result;
+    ICD_LOG_INFO() << "[Client ICD] Freed " << descriptorSetCount << " descriptor set(s)\n";
+    return VK_SUCCESS;
 }
 
 VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(
@@ -374,112 +776,9 @@ VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(
     }
 
     IcdDevice* icd_device = icd_device_from_handle(device);
-    std::vector<VkWriteDescriptorSet> remote_writes(descriptorWriteCount);
-    std::vector<std::vector<VkDescriptorBufferInfo>> buffer_infos(descriptorWriteCount);
-    std::vector<std::vector<VkDescriptorImageInfo>> image_infos(descriptorWriteCount);
-    std::vector<std::vector<VkBufferView>> texel_views(descriptorWriteCount);
-
-    for (uint32_t i = 0; i < descriptorWriteCount; ++i) {
-        const VkWriteDescriptorSet& src = pDescriptorWrites[i];
-        VkWriteDescriptorSet& dst = remote_writes[i];
-        dst = src;
-        dst.dstSet = g_pipeline_state.get_remote_descriptor_set(src.dstSet);
-        if (dst.dstSet == VK_NULL_HANDLE) {
-            ICD_LOG_ERROR() << "[Client ICD] Descriptor set not tracked in vkUpdateDescriptorSets\n";
-            return;
-        }
-
-        switch (src.descriptorType) {
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-            if (!src.pBufferInfo) {
-                ICD_LOG_ERROR() << "[Client ICD] Missing buffer info for descriptor update\n";
-                return;
-            }
-            buffer_infos[i].resize(src.descriptorCount);
-            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
-                buffer_infos[i][j] = src.pBufferInfo[j];
-                if (buffer_infos[i][j].buffer != VK_NULL_HANDLE) {
-                    buffer_infos[i][j].buffer =
-                        g_resource_state.get_remote_buffer(src.pBufferInfo[j].buffer);
-                    if (buffer_infos[i][j].buffer == VK_NULL_HANDLE) {
-                        ICD_LOG_ERROR() << "[Client ICD] Buffer not tracked for descriptor update\n";
-                        return;
-                    }
-                }
-            }
-            dst.pBufferInfo = buffer_infos[i].data();
-            dst.pImageInfo = nullptr;
-            dst.pTexelBufferView = nullptr;
-            break;
-        case VK_DESCRIPTOR_TYPE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-            if (!src.pImageInfo) {
-                ICD_LOG_ERROR() << "[Client ICD] Missing image info for descriptor update\n";
-                return;
-            }
-            image_infos[i].resize(src.descriptorCount);
-            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
-                image_infos[i][j] = src.pImageInfo[j];
-                if (image_infos[i][j].imageView != VK_NULL_HANDLE) {
-                    image_infos[i][j].imageView =
-                        g_resource_state.get_remote_image_view(src.pImageInfo[j].imageView);
-                    if (image_infos[i][j].imageView == VK_NULL_HANDLE) {
-                        ICD_LOG_ERROR() << "[Client ICD] Image view not tracked for descriptor update\n";
-                        return;
-                    }
-                }
-                if (image_infos[i][j].sampler != VK_NULL_HANDLE) {
-                    image_infos[i][j].sampler =
-                        g_resource_state.get_remote_sampler(src.pImageInfo[j].sampler);
-                    if (image_infos[i][j].sampler == VK_NULL_HANDLE) {
-                        ICD_LOG_ERROR() << "[Client ICD] Sampler not tracked for descriptor update\n";
-                        return;
-                    }
-                }
-            }
-            dst.pBufferInfo = nullptr;
-            dst.pImageInfo = image_infos[i].data();
-            dst.pTexelBufferView = nullptr;
-            break;
-        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-            if (!src.pTexelBufferView) {
-                ICD_LOG_ERROR() << "[Client ICD] Missing texel buffer info for descriptor update\n";
-                return;
-            }
-            texel_views[i].resize(src.descriptorCount);
-            for (uint32_t j = 0; j < src.descriptorCount; ++j) {
-                if (src.pTexelBufferView[j] == VK_NULL_HANDLE) {
-                    texel_views[i][j] = VK_NULL_HANDLE;
-                    continue;
-                }
-                texel_views[i][j] =
-                    g_resource_state.get_remote_buffer_view(src.pTexelBufferView[j]);
-                if (texel_views[i][j] == VK_NULL_HANDLE) {
-                    ICD_LOG_ERROR() << "[Client ICD] Buffer view not tracked for descriptor update\n";
-                    return;
-                }
-            }
-            dst.pBufferInfo = nullptr;
-            dst.pImageInfo = nullptr;
-            dst.pTexelBufferView = texel_views[i].data();
-            break;
-        default:
-            if (src.descriptorCount > 0) {
-                ICD_LOG_ERROR() << "[Client ICD] Unsupported descriptor type in vkUpdateDescriptorSets\n";
-                return;
-            }
-            dst.pBufferInfo = nullptr;
-            dst.pImageInfo = nullptr;
-            dst.pTexelBufferView = nullptr;
-            break;
-        }
+    DescriptorWriteStorage remote_writes;
+    if (!translate_descriptor_writes(descriptorWriteCount, pDescriptorWrites, VK_NULL_HANDLE, 0, &remote_writes)) {
+        return;
     }
 
     std::vector<VkCopyDescriptorSet> remote_copies(descriptorCopyCount);
@@ -499,10 +798,166 @@ VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(
     vn_async_vkUpdateDescriptorSets(&g_ring,
                                     icd_device->remote_handle,
                                     descriptorWriteCount,
-                                    remote_writes.data(),
+                                    remote_writes.writes.data(),
                                     descriptorCopyCount,
                                     remote_copies.data());
+    // Recorded command buffers that bind these sets can no longer be replayed as is.
+    for (uint32_t i = 0; i < descriptorWriteCount; ++i) {
+        g_pipeline_state.mark_descriptor_set_updated(pDescriptorWrites[i].dstSet);
+    }
+    for (uint32_t i = 0; i < descriptorCopyCount; ++i) {
+        g_pipeline_state.mark_descriptor_set_updated(pDescriptorCopies[i].dstSet);
+    }
     ICD_LOG_INFO() << "[Client ICD] Descriptor sets updated\n";
 }
 
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorUpdateTemplate(
+    VkDevice device,
+    const VkDescriptorUpdateTemplateCreateInfo* pCreateInfo,
+    const VkAllocationCallbacks* pAllocator,
+    VkDescriptorUpdateTemplate* pDescriptorUpdateTemplate) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCreateDescriptorUpdateTemplate called\n";
+
+    if (!pCreateInfo || !pDescriptorUpdateTemplate ||
+        (pCreateInfo->descriptorUpdateEntryCount > 0 && !pCreateInfo->pDescriptorUpdateEntries)) {
+        ICD_LOG_ERROR() << "[Client ICD] Invalid parameters for vkCreateDescriptorUpdateTemplate\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkCreateDescriptorUpdateTemplate\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    std::vector<VkDescriptorUpdateTemplateEntry> packed_entries;
+    size_t packed_size = 0;
+    if (!pack_descriptor_update_entries(*pCreateInfo, &packed_entries, &packed_size)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unsupported descriptor type in vkCreateDescriptorUpdateTemplate\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo remote_info = *pCreateInfo;
+    remote_info.pDescriptorUpdateEntries = packed_entries.data();
+    remote_info.descriptorSetLayout = VK_NULL_HANDLE;
+    remote_info.pipelineLayout = VK_NULL_HANDLE;
+    if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET) {
+        remote_info.descriptorSetLayout =
+            g_pipeline_state.get_remote_descriptor_set_layout(pCreateInfo->descriptorSetLayout);
+        if (remote_info.descriptorSetLayout == VK_NULL_HANDLE) {
+            ICD_LOG_ERROR() << "[Client ICD] Descriptor set layout not tracked in vkCreateDescriptorUpdateTemplate\n";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    } else {
+        remote_info.pipelineLayout = g_pipeline_state.get_remote_pipeline_layout(pCreateInfo->pipelineLayout);
+        if (remote_info.pipelineLayout == VK_NULL_HANDLE) {
+            ICD_LOG_ERROR() << "[Client ICD] Pipeline layout not tracked in vkCreateDescriptorUpdateTemplate\n";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    VkDescriptorUpdateTemplate remote_template = VK_NULL_HANDLE;
+    VkResult result = vn_call_vkCreateDescriptorUpdateTemplate(&g_ring,
+                                                               icd_device->remote_handle,
+                                                               &remote_info,
+                                                               pAllocator,
+                                                               &remote_template);
+    if (result != VK_SUCCESS) {
+        ICD_LOG_ERROR() << "[Client ICD] vkCreateDescriptorUpdateTemplate failed: " << result << "\n";
+        return result;
+    }
+
+    VkDescriptorUpdateTemplate local = g_handle_allocator.allocate<VkDescriptorUpdateTemplate>();
+    g_pipeline_state.add_descriptor_update_template(
+        device, local, remote_template, *pCreateInfo, std::move(packed_entries), packed_size);
+    *pDescriptorUpdateTemplate = local;
+    ICD_LOG_INFO() << "[Client ICD] Descriptor update template created (local=" << local
+                   << ", packed " << packed_size << " bytes)\n";
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorUpdateTemplate(
+    VkDevice device,
+    VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+    const VkAllocationCallbacks* pAllocator) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkDestroyDescriptorUpdateTemplate called\n";
+
+    if (descriptorUpdateTemplate == VK_NULL_HANDLE) {
+        return;
+    }
+
+    std::shared_ptr<const DescriptorUpdateTemplateInfo> info =
+        g_pipeline_state.get_descriptor_update_template(descriptorUpdateTemplate);
+    g_pipeline_state.remove_descriptor_update_template(descriptorUpdateTemplate);
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server during vkDestroyDescriptorUpdateTemplate\n";
+        return;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkDestroyDescriptorUpdateTemplate\n";
+        return;
+    }
+
+    if (!info) {
+        ICD_LOG_ERROR() << "[Client ICD] Remote descriptor update template handle missing\n";
+        return;
+    }
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    vn_async_vkDestroyDescriptorUpdateTemplate(&g_ring,
+                                               icd_device->remote_handle,
+                                               info->remote_handle,
+                                               pAllocator);
+    ICD_LOG_INFO() << "[Client ICD] Descriptor update template destroyed (local=" << descriptorUpdateTemplate
+                   << ")\n";
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSetWithTemplate(
+    VkDevice device,
+    VkDescriptorSet descriptorSet,
+    VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+    const void* pData) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkUpdateDescriptorSetWithTemplate called\n";
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkUpdateDescriptorSetWithTemplate\n";
+        return;
+    }
+
+    std::shared_ptr<const DescriptorUpdateTemplateInfo> info =
+        g_pipeline_state.get_descriptor_update_template(descriptorUpdateTemplate);
+    VkDescriptorSet remote_set = g_pipeline_state.get_remote_descriptor_set(descriptorSet);
+    if (!info || remote_set == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Template or descriptor set not tracked in vkUpdateDescriptorSetWithTemplate\n";
+        return;
+    }
+
+    std::vector<uint8_t> data;
+    if ((!pData && info->packed_size > 0) || !pack_descriptor_update_data(*info, pData, &data)) {
+        ICD_LOG_ERROR() << "[Client ICD] Invalid data in vkUpdateDescriptorSetWithTemplate\n";
+        return;
+    }
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    submit_update_descriptor_set_with_template(icd_device->remote_handle, remote_set, info->remote_handle, data);
+    // Recorded command buffers that bind this set can no longer be replayed as is.
+    g_pipeline_state.mark_descriptor_set_updated(descriptorSet);
+    ICD_LOG_INFO() << "[Client ICD] Descriptor set updated from template (" << data.size() << " bytes)\n";
+}
+
 } // extern "C"
@@ -4,6 +4,93 @@
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
 
+namespace {
+
+// vkGetDeviceBufferMemoryRequirements is only valid with maintenance4.
+bool maintenance4_enabled(const VkDeviceCreateInfo* info) {
+    for (uint32_t i = 0; i < info->enabledExtensionCount; ++i) {
+        if (std::strcmp(info->ppEnabledExtensionNames[i], VK_KHR_MAINTENANCE_4_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+    for (auto* next = static_cast<const VkBaseInStructure*>(info->pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES &&
+            reinterpret_cast<const VkPhysicalDeviceVulkan13Features*>(next)->maintenance4) {
+            return true;
+        }
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_4_FEATURES &&
+            reinterpret_cast<const VkPhysicalDeviceMaintenance4Features*>(next)->maintenance4) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Asks for the memory requirements of the buffer shapes loaders create most,
+// at the power-of-two sizes staging and streaming buffers usually take, in one
+// round trip. The memory requirements cache answers exactly those queries.
+void prefill_memory_requirements(VkDevice device, VkDevice remote_device) {
+    static const VkBufferUsageFlags kUsages[] = {
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    };
+    static constexpr VkDeviceSize kMinSize = 256;
+    static constexpr VkDeviceSize kMaxSize = 64ull << 20;
+
+    std::vector<VkBufferCreateInfo> infos;
+    for (VkBufferUsageFlags usage : kUsages) {
+        for (VkDeviceSize size = kMinSize; size <= kMaxSize; size *= 2) {
+            VkBufferCreateInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            info.size = size;
+            info.usage = usage;
+            info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            infos.push_back(staged_buffer_info(device, info));
+        }
+    }
+
+    std::vector<VkDeviceBufferMemoryRequirements> queries(infos.size());
+    std::vector<VkMemoryRequirements2> results(infos.size());
+    std::vector<uint8_t> batch;
+    for (size_t i = 0; i < infos.size(); ++i) {
+        queries[i] = {};
+        queries[i].sType = VK_STRUCTURE_TYPE_DEVICE_BUFFER_MEMORY_REQUIREMENTS;
+        queries[i].pCreateInfo = &infos[i];
+        results[i] = {};
+        results[i].sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+
+        const size_t offset = batch.size();
+        batch.resize(offset + vn_sizeof_vkGetDeviceBufferMemoryRequirements(remote_device, &queries[i], &results[i]));
+        vn_cs_encoder enc = {};
+        vn_cs_encoder_init_external(&enc, batch.data() + offset, batch.size() - offset);
+        vn_encode_vkGetDeviceBufferMemoryRequirements(
+            &enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &queries[i], &results[i]);
+        batch.resize(offset + vn_cs_encoder_get_len(&enc));
+    }
+
+    std::vector<uint8_t> reply;
+    if (!vn_ring_call_encoded(&g_ring, batch.data(), batch.size(), &reply)) {
+        return;
+    }
+    vn_cs_decoder dec = {};
+    vn_cs_decoder_init(&dec, reply.data(), reply.size());
+    for (size_t i = 0; i < infos.size(); ++i) {
+        vn_decode_vkGetDeviceBufferMemoryRequirements_reply(&dec, remote_device, &queries[i], &results[i]);
+        if (vn_cs_decoder_get_fatal(&dec)) {
+            break;
+        }
+        g_memory_requirements_cache.store_buffer(device, infos[i], results[i].memoryRequirements, true);
+    }
+    vn_cs_decoder_reset_temp_storage(&dec);
+}
+
+} // namespace
+
 extern "C" {
 
 // Vulkan function implementations
@@ -68,6 +155,9 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(
 
     // Store device mapping
     g_device_state.add_device(*pDevice, icd_device->remote_handle, physicalDevice);
+    if (g_memory_requirements_cache.enabled() && maintenance4_enabled(pCreateInfo)) {
+        prefill_memory_requirements(*pDevice, icd_device->remote_handle);
+    }
 
     ICD_LOG_INFO() << "[Client ICD] Device created successfully (local=" << *pDevice
               << ", remote=" << icd_device->remote_handle << ")\n";
@@ -91,6 +181,7 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(
     std::vector<VkCommandBuffer> buffers_to_free;
     g_command_buffer_state.remove_device(device, &buffers_to_free, nullptr);
     for (VkCommandBuffer buffer : buffers_to_free) {
+        forget_command_buffer_recording(buffer);
         IcdCommandBuffer* icd_cb = icd_command_buffer_from_handle(buffer);
         delete icd_cb;
     }
@@ -99,6 +190,7 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(
         ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
         // Still clean up local resources
         g_resource_state.remove_device_resources(device);
+        g_memory_requirements_cache.remove_device(device);
         g_pipeline_state.remove_device_resources(device);
         g_query_state.remove_device(device);
         g_sync_state.remove_device(device);
@@ -121,6 +213,7 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(
 
     // Drop resource tracking for this device
     g_resource_state.remove_device_resources(device);
+    g_memory_requirements_cache.remove_device(device);
     g_pipeline_state.remove_device_resources(device);
     g_query_state.remove_device(device);
     g_sync_state.remove_device(device);
@@ -216,4 +309,36 @@ VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice device) {
     return result;
 }
 
+// Private query behind venus_plus::ClientStats; see protocol/client_stats.h.
+VKAPI_ATTR void VKAPI_CALL vkGetClientStatsVENUSPLUS(VkDevice device, ClientStats* pStats) {
+    (void)device;
+    if (!pStats) {
+        return;
+    }
+    const StateFilterStats filter = g_state_filter.stats();
+    const CommandReplayStats replay = g_replay_cache.stats();
+    const DeferredRecordingStats deferred = g_deferred_recording.stats();
+    const PhysicalDeviceCacheStats caps = g_physical_device_cache.stats();
+    const MemoryRequirementsCacheStats requirements = g_memory_requirements_cache.stats();
+    *pStats = {};
+    pStats->state_filter_checked = filter.checked;
+    pStats->state_filter_elided = filter.elided;
+    pStats->replay_recordings = replay.recordings;
+    pStats->replay_hits = replay.hits;
+    pStats->replay_misses = replay.misses;
+    pStats->deferred_recordings = deferred.recordings;
+    pStats->deferred_uploads = deferred.uploads;
+    pStats->shader_store_hits = g_shader_store_hits.load(std::memory_order_relaxed);
+    pStats->caps_cache_loaded = caps.loaded;
+    pStats->caps_cache_hits = caps.hits;
+    pStats->caps_cache_misses = caps.misses;
+    pStats->descriptor_sets_local = g_descriptor_sets_local.load(std::memory_order_relaxed);
+    pStats->descriptor_pool_refusals = g_descriptor_pool_refusals.load(std::memory_order_relaxed);
+    pStats->staged_memory_transfers = g_staged_memory_transfers.load(std::memory_order_relaxed);
+    pStats->memory_requirements_hits = requirements.hits;
+    pStats->memory_requirements_misses = requirements.misses;
+    pStats->inline_uploads = g_inline_uploads.load(std::memory_order_relaxed);
+}
+
 } // extern "C"
+
@@ -116,6 +116,8 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    g_state_filter.configure();
+
     // 1. Allocate ICD instance structure (required for version 5 dispatch table)
     IcdInstance* icd_instance = new IcdInstance();
     if (!icd_instance) {
@@ -199,11 +201,20 @@ VKAPI_ATTR void VKAPI_CALL vkGetDeviceBufferMemoryRequirements(
         return;
     }
 
-    IcdDevice* icd_device = icd_device_from_handle(device);
-    vn_call_vkGetDeviceBufferMemoryRequirements(&g_ring,
-                                                icd_device->remote_handle,
-                                                pInfo,
-                                                pMemoryRequirements);
+    // Asked about the buffer vkCreateBuffer would create.
+    const VkBufferCreateInfo real_info = staged_buffer_info(device, *pInfo->pCreateInfo);
+    if (pMemoryRequirements->pNext ||
+        !g_memory_requirements_cache.find_buffer(device, real_info, &pMemoryRequirements->memoryRequirements)) {
+        VkDeviceBufferMemoryRequirements remote_info = *pInfo;
+        remote_info.pCreateInfo = &real_info;
+        IcdDevice* icd_device = icd_device_from_handle(device);
+        vn_call_vkGetDeviceBufferMemoryRequirements(&g_ring,
+                                                    icd_device->remote_handle,
+                                                    &remote_info,
+                                                    pMemoryRequirements);
+        g_memory_requirements_cache.store_buffer(device, real_info, pMemoryRequirements->memoryRequirements);
+    }
+    report_memory_type_bits(device, &pMemoryRequirements->memoryRequirements, buffer_stageable(real_info));
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetDeviceBufferMemoryRequirementsKHR(
@@ -235,11 +246,16 @@ VKAPI_ATTR void VKAPI_CALL vkGetDeviceImageMemoryRequirements(
         return;
     }
 
-    IcdDevice* icd_device = icd_device_from_handle(device);
-    vn_call_vkGetDeviceImageMemoryRequirements(&g_ring,
-                                               icd_device->remote_handle,
-                                               pInfo,
-                                               pMemoryRequirements);
+    if (pMemoryRequirements->pNext ||
+        !g_memory_requirements_cache.find_image(device, *pInfo->pCreateInfo, &pMemoryRequirements->memoryRequirements)) {
+        IcdDevice* icd_device = icd_device_from_handle(device);
+        vn_call_vkGetDeviceImageMemoryRequirements(&g_ring,
+                                                   icd_device->remote_handle,
+                                                   pInfo,
+                                                   pMemoryRequirements);
+        g_memory_requirements_cache.store_image(device, *pInfo->pCreateInfo, pMemoryRequirements->memoryRequirements);
+    }
+    report_memory_type_bits(device, &pMemoryRequirements->memoryRequirements, false);
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetDeviceImageMemoryRequirementsKHR(
@@ -691,6 +707,7 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(
     g_command_buffer_state.remove_pool(commandPool, &buffers_to_free);
 
     for (VkCommandBuffer buffer : buffers_to_free) {
+        forget_command_buffer_recording(buffer);
         IcdCommandBuffer* icd_cb = icd_command_buffer_from_handle(buffer);
         delete icd_cb;
     }
@@ -743,10 +760,33 @@ VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    if (g_replay_cache.enabled() || g_deferred_recording.enabled()) {
+        std::vector<VkCommandBuffer> buffers;
+        g_command_buffer_state.reset_pool(commandPool, &buffers);
+        for (VkCommandBuffer buffer : buffers) {
+            // Drop unfinished captures and recordings never uploaded; the
+            // server never saw their begin.
+            vn_ring_end_capture(&g_ring, reinterpret_cast<uint64_t>(get_remote_command_buffer_handle(buffer)),
+                                nullptr);
+            g_deferred_recording.discard(buffer);
+            if (flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT) {
+                g_replay_cache.invalidate(buffer);
+            } else {
+                g_command_buffer_state.mark_reset_elided(buffer);
+            }
+        }
+        if (!(flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT)) {
+            // The recordings stay on the server (as replay candidates, with
+            // the cache on); each buffer's next uploaded begin resets it there.
+            ICD_LOG_INFO() << "[Client ICD] Command pool reset (recordings kept on the server)\n";
+            return VK_SUCCESS;
+        }
+    }
+
     IcdDevice* icd_device = icd_device_from_handle(device);
     VkResult result = vn_call_vkResetCommandPool(&g_ring, icd_device->remote_handle, remote_pool, flags);
     if (result == VK_SUCCESS) {
-        g_command_buffer_state.reset_pool(commandPool);
+        g_command_buffer_state.reset_pool(commandPool, nullptr);
         ICD_LOG_INFO() << "[Client ICD] Command pool reset\n";
     } else {
         ICD_LOG_ERROR() << "[Client ICD] vkResetCommandPool failed: " << result << "\n";
@@ -5,6 +5,81 @@
 #include "icd/commands/commands_common.h"
 #include <atomic>
 
+namespace {
+
+// Copies of the structs an allocate info's chain may hold ahead of its
+// VkMemoryDedicatedAllocateInfo, so the chain can be rebuilt around a
+// dedicated struct naming the server's image or buffer.
+struct RemoteAllocateChain {
+    VkMemoryDedicatedAllocateInfo dedicated;
+    VkMemoryAllocateFlagsInfo flags;
+    VkMemoryPriorityAllocateInfoEXT priority;
+    VkMemoryOpaqueCaptureAddressAllocateInfo capture_address;
+    VkExportMemoryAllocateInfo export_memory;
+};
+
+template <typename T>
+VkBaseOutStructure* copy_chain_struct(const VkBaseInStructure* source, T* copy) {
+    *copy = *reinterpret_cast<const T*>(source);
+    return reinterpret_cast<VkBaseOutStructure*>(copy);
+}
+
+// Points |info|'s chain at copies in |chain| up to the dedicated struct, whose
+// handles are translated; the rest of the chain is shared. False when a struct
+// the ICD cannot copy comes first.
+bool translate_dedicated_allocation(VkMemoryAllocateInfo* info, RemoteAllocateChain* chain) {
+    bool dedicated = false;
+    for (auto* next = static_cast<const VkBaseInStructure*>(info->pNext); next; next = next->pNext) {
+        dedicated |= next->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    }
+    if (!dedicated) {
+        return true;
+    }
+    VkBaseOutStructure* tail = reinterpret_cast<VkBaseOutStructure*>(info);
+    for (auto* next = static_cast<const VkBaseInStructure*>(info->pNext); next; next = next->pNext) {
+        VkBaseOutStructure* copy = nullptr;
+        switch (next->sType) {
+        case VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO:
+            copy = copy_chain_struct(next, &chain->dedicated);
+            chain->dedicated.image = chain->dedicated.image != VK_NULL_HANDLE
+                                         ? g_resource_state.get_remote_image(chain->dedicated.image)
+                                         : VK_NULL_HANDLE;
+            chain->dedicated.buffer = chain->dedicated.buffer != VK_NULL_HANDLE
+                                          ? g_resource_state.get_remote_buffer(chain->dedicated.buffer)
+                                          : VK_NULL_HANDLE;
+            tail->pNext = copy;
+            return true;
+        case VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO:
+            copy = copy_chain_struct(next, &chain->flags);
+            break;
+        case VK_STRUCTURE_TYPE_MEMORY_PRIORITY_ALLOCATE_INFO_EXT:
+            copy = copy_chain_struct(next, &chain->priority);
+            break;
+        case VK_STRUCTURE_TYPE_MEMORY_OPAQUE_CAPTURE_ADDRESS_ALLOCATE_INFO:
+            copy = copy_chain_struct(next, &chain->capture_address);
+            break;
+        case VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO:
+            copy = copy_chain_struct(next, &chain->export_memory);
+            break;
+        default:
+            return false;
+        }
+        tail->pNext = copy;
+        tail = copy;
+    }
+    return true;
+}
+
+// Counts a transfer the server ran through its staging ring.
+void count_staged_transfer(VkDeviceMemory memory) {
+    VkPhysicalDevice physical_device = memory_type_physical_device(g_resource_state.get_memory_device(memory));
+    if (g_memory_type_map.staged(physical_device, g_resource_state.get_memory_type_index(memory))) {
+        g_staged_memory_transfers.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
 VkResult send_transfer_memory_data(VkDeviceMemory memory,
                                    VkDeviceSize offset,
                                    VkDeviceSize size,
@@ -59,6 +134,9 @@ VkResult send_transfer_memory_data(VkDeviceMemory memory,
 
     VkResult result = VK_ERROR_DEVICE_LOST;
     std::memcpy(&result, reply.data(), sizeof(VkResult));
+    if (result == VK_SUCCESS) {
+        count_staged_transfer(memory);
+    }
     return result;
 }
 
@@ -122,6 +200,7 @@ VkResult read_memory_data(VkDeviceMemory memory,
     }
 
     std::memcpy(dst, reply.data() + sizeof(VkResult), payload_size);
+    count_staged_transfer(memory);
     return VK_SUCCESS;
 }
 
@@ -155,8 +234,34 @@ VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(
     IcdDevice* icd_device = icd_device_from_handle(device);
     VkDevice remote_device = icd_device->remote_handle;
 
+    // The application picks among the reported memory types. Staged ones
+    // are not offered for images or buffers the server cannot stage through.
+    VkPhysicalDevice physical_device = memory_type_physical_device(device);
+    if (g_memory_type_map.staged(physical_device, pAllocateInfo->memoryTypeIndex)) {
+        for (auto* next = static_cast<const VkBaseInStructure*>(pAllocateInfo->pNext); next; next = next->pNext) {
+            if (next->sType != VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO) {
+                continue;
+            }
+            auto* dedicated = reinterpret_cast<const VkMemoryDedicatedAllocateInfo*>(next);
+            if (dedicated->image != VK_NULL_HANDLE ||
+                (dedicated->buffer != VK_NULL_HANDLE && !g_resource_state.is_stageable_buffer(dedicated->buffer))) {
+                ICD_LOG_ERROR() << "[Client ICD] Memory type " << pAllocateInfo->memoryTypeIndex
+                                << " cannot back this dedicated allocation\n";
+                return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
+        }
+    }
+    VkMemoryAllocateInfo remote_info = *pAllocateInfo;
+    remote_info.memoryTypeIndex =
+        g_memory_type_map.server_index(physical_device, pAllocateInfo->memoryTypeIndex);
+    RemoteAllocateChain remote_chain;
+    if (!translate_dedicated_allocation(&remote_info, &remote_chain)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unsupported struct ahead of the dedicated allocation info\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
     VkDeviceMemory remote_memory = VK_NULL_HANDLE;
-    VkResult result = vn_call_vkAllocateMemory(&g_ring, remote_device, pAllocateInfo, pAllocator, &remote_memory);
+    VkResult result = vn_call_vkAllocateMemory(&g_ring, remote_device, &remote_info, pAllocator, &remote_memory);
     if (result != VK_SUCCESS) {
         ICD_LOG_ERROR() << "[Client ICD] vkAllocateMemory failed: " << result << "\n";
         return result;
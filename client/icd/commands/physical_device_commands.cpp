@@ -3,6 +3,248 @@
 
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
+#include <functional>
+#include <string>
+
+namespace {
+
+// Capacities used for the list queries, so their replies can be kept and
+// answer any later call. A device with more falls back to asking directly.
+constexpr uint32_t kCachedQueueFamilyCapacity = 64;
+constexpr uint32_t kCachedExtensionCapacity = 512;
+
+template <typename Size, typename Encode>
+std::vector<uint8_t> encode_query(Size size_fn, Encode encode_fn) {
+    std::vector<uint8_t> command(size_fn());
+    vn_cs_encoder enc = {};
+    vn_cs_encoder_init_external(&enc, command.data(), command.size());
+    encode_fn(&enc);
+    command.resize(vn_cs_encoder_get_len(&enc));
+    return command;
+}
+
+// False when |chain| holds a struct whose answer changes at runtime, such
+// as the memory budget; queries with one bypass the capability cache.
+bool chain_is_static(const void* chain) {
+    for (auto* next = static_cast<const VkBaseInStructure*>(chain); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes the reply to |command| from the capability cache, asking the server
+// and keeping the reply when it is not there yet. A query whose output
+// |chain| is not static always asks the server and keeps nothing.
+template <typename Decode>
+bool cached_query(VkPhysicalDevice remote_device,
+                  const std::vector<uint8_t>& command,
+                  Decode decode_fn,
+                  const void* chain = nullptr) {
+    const bool cacheable = chain_is_static(chain);
+    std::vector<uint8_t> reply;
+    const bool cached = cacheable && g_physical_device_cache.find_reply(remote_device, command, &reply);
+    if (!cached && !vn_ring_call_encoded(&g_ring, command.data(), command.size(), &reply)) {
+        return false;
+    }
+    vn_cs_decoder dec = {};
+    vn_cs_decoder_init(&dec, reply.data(), reply.size());
+    decode_fn(&dec);
+    const bool valid = !vn_cs_decoder_get_fatal(&dec);
+    vn_cs_decoder_reset_temp_storage(&dec);
+    if (valid && cacheable && !cached) {
+        g_physical_device_cache.store_reply(remote_device, command, reply, true);
+    }
+    return valid;
+}
+
+bool query_properties(VkPhysicalDevice remote_device, VkPhysicalDeviceProperties* properties) {
+    const std::vector<uint8_t> command = encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceProperties(remote_device, properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceProperties(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, properties);
+        });
+    return cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceProperties_reply(dec, remote_device, properties);
+    });
+}
+
+bool query_features(VkPhysicalDevice remote_device, VkPhysicalDeviceFeatures* features) {
+    const std::vector<uint8_t> command = encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceFeatures(remote_device, features); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceFeatures(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, features);
+        });
+    return cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceFeatures_reply(dec, remote_device, features);
+    });
+}
+
+bool query_memory_properties(VkPhysicalDevice remote_device, VkPhysicalDeviceMemoryProperties* properties) {
+    const std::vector<uint8_t> command = encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceMemoryProperties(remote_device, properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceMemoryProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, properties);
+        });
+    return cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceMemoryProperties_reply(dec, remote_device, properties);
+    });
+}
+
+std::vector<uint8_t> encode_format_query(VkPhysicalDevice remote_device, VkFormat format, VkFormatProperties* properties) {
+    return encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceFormatProperties(remote_device, format, properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceFormatProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, format, properties);
+        });
+}
+
+// All queue families, as long as there are at most kCachedQueueFamilyCapacity.
+bool query_queue_families(VkPhysicalDevice remote_device, std::vector<VkQueueFamilyProperties>* families) {
+    families->assign(kCachedQueueFamilyCapacity, VkQueueFamilyProperties{});
+    uint32_t count = kCachedQueueFamilyCapacity;
+    const std::vector<uint8_t> command = encode_query(
+        [&] {
+            return vn_sizeof_vkGetPhysicalDeviceQueueFamilyProperties(remote_device, &count, families->data());
+        },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceQueueFamilyProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &count, families->data());
+        });
+    if (!cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+            vn_decode_vkGetPhysicalDeviceQueueFamilyProperties_reply(dec, remote_device, &count, families->data());
+        })) {
+        return false;
+    }
+    families->resize(std::min(count, kCachedQueueFamilyCapacity));
+    return count < kCachedQueueFamilyCapacity;
+}
+
+std::vector<uint8_t> encode_extension_query(VkPhysicalDevice remote_device,
+                                            uint32_t* count,
+                                            VkExtensionProperties* properties) {
+    return encode_query(
+        [&] { return vn_sizeof_vkEnumerateDeviceExtensionProperties(remote_device, nullptr, count, properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkEnumerateDeviceExtensionProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, nullptr, count, properties);
+        });
+}
+
+// Fetches what applications ask every physical device for in one round trip
+// and seeds the capability cache with it: properties, features, memory
+// properties, queue families, extensions and the properties of every core
+// format.
+void prefetch_physical_device(VkPhysicalDevice remote_device) {
+    VkPhysicalDeviceProperties properties = {};
+    VkPhysicalDeviceFeatures features = {};
+    VkPhysicalDeviceMemoryProperties memory_properties = {};
+    VkFormatProperties format_properties = {};
+    uint32_t family_count = kCachedQueueFamilyCapacity;
+    std::vector<VkQueueFamilyProperties> families(kCachedQueueFamilyCapacity);
+    uint32_t extension_count = kCachedExtensionCapacity;
+    std::vector<VkExtensionProperties> extensions(kCachedExtensionCapacity);
+
+    std::vector<std::vector<uint8_t>> commands;
+    std::vector<std::function<void(vn_cs_decoder*)>> decoders;
+    commands.push_back(encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceProperties(remote_device, &properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceProperties(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &properties);
+        }));
+    decoders.push_back([&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceProperties_reply(dec, remote_device, &properties);
+    });
+    commands.push_back(encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceFeatures(remote_device, &features); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceFeatures(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &features);
+        }));
+    decoders.push_back([&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceFeatures_reply(dec, remote_device, &features);
+    });
+    commands.push_back(encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceMemoryProperties(remote_device, &memory_properties); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceMemoryProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &memory_properties);
+        }));
+    decoders.push_back([&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceMemoryProperties_reply(dec, remote_device, &memory_properties);
+    });
+    commands.push_back(encode_query(
+        [&] {
+            return vn_sizeof_vkGetPhysicalDeviceQueueFamilyProperties(remote_device, &family_count, families.data());
+        },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceQueueFamilyProperties(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, &family_count, families.data());
+        }));
+    decoders.push_back([&](vn_cs_decoder* dec) {
+        vn_decode_vkGetPhysicalDeviceQueueFamilyProperties_reply(dec, remote_device, &family_count, families.data());
+    });
+    commands.push_back(encode_extension_query(remote_device, &extension_count, extensions.data()));
+    decoders.push_back([&](vn_cs_decoder* dec) {
+        vn_decode_vkEnumerateDeviceExtensionProperties_reply(
+            dec, remote_device, nullptr, &extension_count, extensions.data());
+    });
+    for (uint32_t format = VK_FORMAT_R4G4_UNORM_PACK8; format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK; ++format) {
+        commands.push_back(encode_format_query(remote_device, static_cast<VkFormat>(format), &format_properties));
+        decoders.push_back([&, format](vn_cs_decoder* dec) {
+            vn_decode_vkGetPhysicalDeviceFormatProperties_reply(
+                dec, remote_device, static_cast<VkFormat>(format), &format_properties);
+        });
+    }
+
+    std::vector<uint8_t> batch;
+    for (const auto& command : commands) {
+        batch.insert(batch.end(), command.begin(), command.end());
+    }
+    std::vector<uint8_t> replies;
+    if (!vn_ring_call_encoded(&g_ring, batch.data(), batch.size(), &replies)) {
+        return;
+    }
+
+    // The replies come back to back; decoding each one tells where it ends.
+    std::vector<std::vector<uint8_t>> slices;
+    vn_cs_decoder dec = {};
+    vn_cs_decoder_init(&dec, replies.data(), replies.size());
+    for (const auto& decode_fn : decoders) {
+        const size_t begin = replies.size() - vn_cs_decoder_bytes_remaining(&dec);
+        decode_fn(&dec);
+        if (vn_cs_decoder_get_fatal(&dec)) {
+            break;
+        }
+        const size_t end = replies.size() - vn_cs_decoder_bytes_remaining(&dec);
+        slices.emplace_back(replies.begin() + begin, replies.begin() + end);
+    }
+    vn_cs_decoder_reset_temp_storage(&dec);
+    if (slices.size() != commands.size()) {
+        ICD_LOG_ERROR() << "[Client ICD] Malformed physical device replies; not caching\n";
+        return;
+    }
+
+    // The branded properties reply hides the real driver version, so the
+    // identity covers every batched reply: a driver update that changes any of
+    // them starts a new file. The build and wire format versions, shared with
+    // the server, cover changes in how either end answers.
+    std::string identity = std::string("venus-plus ") + VENUS_PLUS_VERSION + " wire " +
+                           std::to_string(vn_info_wire_format_version()) + " vk.xml " +
+                           std::to_string(vn_info_vk_xml_version()) + "\n";
+    for (const auto& slice : slices) {
+        identity.append(slice.begin(), slice.end());
+    }
+    g_physical_device_cache.add_device(remote_device, std::vector<uint8_t>(identity.begin(), identity.end()));
+    for (size_t i = 0; i < commands.size(); ++i) {
+        g_physical_device_cache.store_reply(remote_device, commands[i], slices[i], false);
+    }
+    g_physical_device_cache.log_stats();
+}
+
+} // namespace
 
 extern "C" {
 
@@ -83,6 +325,14 @@ VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(
 
     state->physical_devices = std::move(new_entries);
 
+    if (g_physical_device_cache.enabled()) {
+        for (VkPhysicalDevice remote : remote_devices) {
+            if (!g_physical_device_cache.has_device(remote)) {
+                prefetch_physical_device(remote);
+            }
+        }
+    }
+
     for (uint32_t i = 0; i < local_devices.size(); ++i) {
         pPhysicalDevices[i] = local_devices[i];
         ICD_LOG_INFO() << "[Client ICD] Physical device " << i << " local=" << local_devices[i]
@@ -120,7 +370,10 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(
         }
     }
 
-    vn_call_vkGetPhysicalDeviceFeatures(&g_ring, remote_device, pFeatures);
+    if (!query_features(remote_device, pFeatures)) {
+        memset(pFeatures, 0, sizeof(VkPhysicalDeviceFeatures));
+        return;
+    }
     ICD_LOG_INFO() << "[Client ICD] Returned features from server\n";
 }
 
@@ -147,7 +400,25 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(
         return;
     }
 
-    vn_call_vkGetPhysicalDeviceFeatures2(&g_ring, remote_device, pFeatures);
+    if (!pFeatures->pNext) {
+        if (!query_features(remote_device, &pFeatures->features)) {
+            memset(&pFeatures->features, 0, sizeof(VkPhysicalDeviceFeatures));
+        }
+        return;
+    }
+
+    const std::vector<uint8_t> command = encode_query(
+        [&] { return vn_sizeof_vkGetPhysicalDeviceFeatures2(remote_device, pFeatures); },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceFeatures2(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, pFeatures);
+        });
+    if (!cached_query(
+            remote_device,
+            command,
+            [&](vn_cs_decoder* dec) { vn_decode_vkGetPhysicalDeviceFeatures2_reply(dec, remote_device, pFeatures); },
+            pFeatures->pNext)) {
+        memset(&pFeatures->features, 0, sizeof(VkPhysicalDeviceFeatures));
+    }
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2KHR(
@@ -185,7 +456,12 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(
         }
     }
 
-    vn_call_vkGetPhysicalDeviceFormatProperties(&g_ring, remote_device, format, pFormatProperties);
+    const std::vector<uint8_t> command = encode_format_query(remote_device, format, pFormatProperties);
+    if (!cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+            vn_decode_vkGetPhysicalDeviceFormatProperties_reply(dec, remote_device, format, pFormatProperties);
+        })) {
+        memset(pFormatProperties, 0, sizeof(VkFormatProperties));
+    }
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceImageFormatProperties(
@@ -215,8 +491,21 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceImageFormatProperties(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    VkResult result = vn_call_vkGetPhysicalDeviceImageFormatProperties(
-        &g_ring, remote_device, format, type, tiling, usage, flags, pImageFormatProperties);
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    const std::vector<uint8_t> command = encode_query(
+        [&] {
+            return vn_sizeof_vkGetPhysicalDeviceImageFormatProperties(
+                remote_device, format, type, tiling, usage, flags, pImageFormatProperties);
+        },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceImageFormatProperties(enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device,
+                                                               format, type, tiling, usage, flags,
+                                                               pImageFormatProperties);
+        });
+    cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        result = vn_decode_vkGetPhysicalDeviceImageFormatProperties_reply(
+            dec, remote_device, format, type, tiling, usage, flags, pImageFormatProperties);
+    });
     if (result != VK_SUCCESS) {
         ICD_LOG_WARN() << "[Client ICD] vkGetPhysicalDeviceImageFormatProperties returned " << result << "\n";
     }
@@ -246,8 +535,20 @@ VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceImageFormatProperties2(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    VkResult result = vn_call_vkGetPhysicalDeviceImageFormatProperties2(
-        &g_ring, remote_device, pImageFormatInfo, pImageFormatProperties);
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    const std::vector<uint8_t> command = encode_query(
+        [&] {
+            return vn_sizeof_vkGetPhysicalDeviceImageFormatProperties2(
+                remote_device, pImageFormatInfo, pImageFormatProperties);
+        },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceImageFormatProperties2(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, pImageFormatInfo, pImageFormatProperties);
+        });
+    cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        result = vn_decode_vkGetPhysicalDeviceImageFormatProperties2_reply(
+            dec, remote_device, pImageFormatInfo, pImageFormatProperties);
+    });
     if (result != VK_SUCCESS) {
         ICD_LOG_WARN() << "[Client ICD] vkGetPhysicalDeviceImageFormatProperties2 returned " << result << "\n";
     }
@@ -289,7 +590,10 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(
         }
     }
 
-    vn_call_vkGetPhysicalDeviceProperties(&g_ring, remote_device, pProperties);
+    if (!query_properties(remote_device, pProperties)) {
+        memset(pProperties, 0, sizeof(VkPhysicalDeviceProperties));
+        return;
+    }
     ICD_LOG_INFO() << "[Client ICD] Returned device properties from server: " << pProperties->deviceName << "\n";
     vp_branding_apply_properties(pProperties);
 }
@@ -317,7 +621,26 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties2(
         return;
     }
 
-    vn_call_vkGetPhysicalDeviceProperties2(&g_ring, remote_device, pProperties);
+    bool answered = false;
+    if (!pProperties->pNext) {
+        answered = query_properties(remote_device, &pProperties->properties);
+    } else {
+        const std::vector<uint8_t> command = encode_query(
+            [&] { return vn_sizeof_vkGetPhysicalDeviceProperties2(remote_device, pProperties); },
+            [&](vn_cs_encoder* enc) {
+                vn_encode_vkGetPhysicalDeviceProperties2(
+                    enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, pProperties);
+            });
+        answered = cached_query(
+            remote_device,
+            command,
+            [&](vn_cs_decoder* dec) { vn_decode_vkGetPhysicalDeviceProperties2_reply(dec, remote_device, pProperties); },
+            pProperties->pNext);
+    }
+    if (!answered) {
+        memset(&pProperties->properties, 0, sizeof(VkPhysicalDeviceProperties));
+        return;
+    }
     vp_branding_apply_properties2(pProperties);
 }
 
@@ -356,7 +679,18 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(
         }
     }
 
-    vn_call_vkGetPhysicalDeviceQueueFamilyProperties(&g_ring, remote_device, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    std::vector<VkQueueFamilyProperties> families;
+    if (query_queue_families(remote_device, &families)) {
+        if (pQueueFamilyProperties) {
+            *pQueueFamilyPropertyCount = std::min<uint32_t>(*pQueueFamilyPropertyCount, families.size());
+            std::copy_n(families.begin(), *pQueueFamilyPropertyCount, pQueueFamilyProperties);
+        } else {
+            *pQueueFamilyPropertyCount = static_cast<uint32_t>(families.size());
+        }
+    } else {
+        vn_call_vkGetPhysicalDeviceQueueFamilyProperties(
+            &g_ring, remote_device, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    }
 
     if (pQueueFamilyProperties) {
         ICD_LOG_INFO() << "[Client ICD] Returned " << *pQueueFamilyPropertyCount << " queue families from server\n";
@@ -389,8 +723,40 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties2(
         return;
     }
 
-    vn_call_vkGetPhysicalDeviceQueueFamilyProperties2(
-        &g_ring, remote_device, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    // Without extension structs the core list answers this as well.
+    bool chained = false;
+    for (uint32_t i = 0; pQueueFamilyProperties && i < *pQueueFamilyPropertyCount; ++i) {
+        chained = chained || pQueueFamilyProperties[i].pNext;
+    }
+    std::vector<VkQueueFamilyProperties> families;
+    if (!chained && query_queue_families(remote_device, &families)) {
+        if (pQueueFamilyProperties) {
+            *pQueueFamilyPropertyCount = std::min<uint32_t>(*pQueueFamilyPropertyCount, families.size());
+            for (uint32_t i = 0; i < *pQueueFamilyPropertyCount; ++i) {
+                pQueueFamilyProperties[i].queueFamilyProperties = families[i];
+            }
+        } else {
+            *pQueueFamilyPropertyCount = static_cast<uint32_t>(families.size());
+        }
+        return;
+    }
+
+    const std::vector<uint8_t> command = encode_query(
+        [&] {
+            return vn_sizeof_vkGetPhysicalDeviceQueueFamilyProperties2(
+                remote_device, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+        },
+        [&](vn_cs_encoder* enc) {
+            vn_encode_vkGetPhysicalDeviceQueueFamilyProperties2(
+                enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, pQueueFamilyPropertyCount,
+                pQueueFamilyProperties);
+        });
+    if (!cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+            vn_decode_vkGetPhysicalDeviceQueueFamilyProperties2_reply(
+                dec, remote_device, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+        })) {
+        *pQueueFamilyPropertyCount = 0;
+    }
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties2KHR(
@@ -465,8 +831,12 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(
         }
     }
 
-    vn_call_vkGetPhysicalDeviceMemoryProperties(&g_ring, remote_device, pMemoryProperties);
+    if (!query_memory_properties(remote_device, pMemoryProperties)) {
+        memset(pMemoryProperties, 0, sizeof(VkPhysicalDeviceMemoryProperties));
+        return;
+    }
     normalize_memory_properties(pMemoryProperties);
+    g_memory_type_map.report(physicalDevice, pMemoryProperties);
     ICD_LOG_INFO() << "[Client ICD] Returned memory properties from server: "
               << pMemoryProperties->memoryTypeCount << " types, "
               << pMemoryProperties->memoryHeapCount << " heaps\n";
@@ -495,8 +865,32 @@ VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2(
         return;
     }
 
-    vn_call_vkGetPhysicalDeviceMemoryProperties2(&g_ring, remote_device, pMemoryProperties);
+    bool answered = false;
+    if (!pMemoryProperties->pNext) {
+        answered = query_memory_properties(remote_device, &pMemoryProperties->memoryProperties);
+    } else {
+        const std::vector<uint8_t> command = encode_query(
+            [&] { return vn_sizeof_vkGetPhysicalDeviceMemoryProperties2(remote_device, pMemoryProperties); },
+            [&](vn_cs_encoder* enc) {
+                vn_encode_vkGetPhysicalDeviceMemoryProperties2(
+                    enc, VK_COMMAND_GENERATE_REPLY_BIT_EXT, remote_device, pMemoryProperties);
+            });
+        // VK_EXT_memory_budget numbers move as memory is used, so those
+        // queries always reach the server.
+        answered = cached_query(
+            remote_device,
+            command,
+            [&](vn_cs_decoder* dec) {
+                vn_decode_vkGetPhysicalDeviceMemoryProperties2_reply(dec, remote_device, pMemoryProperties);
+            },
+            pMemoryProperties->pNext);
+    }
+    if (!answered) {
+        memset(&pMemoryProperties->memoryProperties, 0, sizeof(VkPhysicalDeviceMemoryProperties));
+        return;
+    }
     normalize_memory_properties(&pMemoryProperties->memoryProperties);
+    g_memory_type_map.report(physicalDevice, &pMemoryProperties->memoryProperties);
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2KHR(
@@ -535,16 +929,29 @@ VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    uint32_t remote_count = 0;
-    VkResult count_result =
-        vn_call_vkEnumerateDeviceExtensionProperties(&g_ring, remote_device, pLayerName, &remote_count, nullptr);
-    if (count_result != VK_SUCCESS) {
-        ICD_LOG_ERROR() << "[Client ICD] Failed to query device extension count: " << count_result << "\n";
-        return count_result;
+    uint32_t remote_count = kCachedExtensionCapacity;
+    std::vector<VkExtensionProperties> remote_props(kCachedExtensionCapacity);
+    VkResult cached_result = VK_ERROR_INITIALIZATION_FAILED;
+    const std::vector<uint8_t> command = encode_extension_query(remote_device, &remote_count, remote_props.data());
+    cached_query(remote_device, command, [&](vn_cs_decoder* dec) {
+        cached_result = vn_decode_vkEnumerateDeviceExtensionProperties_reply(
+            dec, remote_device, pLayerName, &remote_count, remote_props.data());
+    });
+    if (cached_result == VK_SUCCESS) {
+        remote_props.resize(remote_count);
+    } else {
+        // More extensions than the cached list holds; ask for all of them.
+        remote_count = 0;
+        remote_props.clear();
+        VkResult count_result =
+            vn_call_vkEnumerateDeviceExtensionProperties(&g_ring, remote_device, pLayerName, &remote_count, nullptr);
+        if (count_result != VK_SUCCESS) {
+            ICD_LOG_ERROR() << "[Client ICD] Failed to query device extension count: " << count_result << "\n";
+            return count_result;
+        }
     }
 
-    std::vector<VkExtensionProperties> remote_props;
-    if (remote_count > 0) {
+    if (remote_props.empty() && remote_count > 0) {
         remote_props.resize(remote_count);
         uint32_t write_count = remote_count;
         VkResult list_result = vn_call_vkEnumerateDeviceExtensionProperties(
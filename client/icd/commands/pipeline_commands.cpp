@@ -4,6 +4,80 @@
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
 
+namespace {
+
+// VENUS_SHADER_CACHE=off sends every module's code through vkCreateShaderModule.
+bool shader_cache_enabled() {
+    static const bool enabled = []() {
+        const char* env = std::getenv("VENUS_SHADER_CACHE");
+        return !env || (std::strcmp(env, "0") != 0 && std::strcmp(env, "off") != 0 &&
+                        std::strcmp(env, "OFF") != 0);
+    }();
+    return enabled;
+}
+
+// Modules this small go out with their code right away; asking first would
+// cost a round trip to save less than it sends.
+constexpr size_t kShaderInlineUploadBytes = 4096;
+
+VkResult send_create_shader_module(VkDevice remote_device,
+                                   const VkShaderModuleCreateInfo* info,
+                                   const Sha256Digest& hash,
+                                   bool with_code,
+                                   VkShaderModule* remote_module) {
+    CreateShaderModuleRequest request = {};
+    request.command = with_code ? VENUS_PLUS_CMD_CREATE_SHADER_MODULE_WITH_CODE
+                                : VENUS_PLUS_CMD_CREATE_SHADER_MODULE;
+    request.flags = info->flags;
+    request.device = reinterpret_cast<uint64_t>(remote_device);
+    request.code_size = info->codeSize;
+    std::memcpy(request.code_hash, hash.data(), hash.size());
+
+    std::vector<uint8_t> message(sizeof(request) + (with_code ? info->codeSize : 0));
+    std::memcpy(message.data(), &request, sizeof(request));
+    if (with_code) {
+        std::memcpy(message.data() + sizeof(request), info->pCode, info->codeSize);
+    }
+    if (!g_client.send(message.data(), message.size())) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to send shader module request\n";
+        return VK_ERROR_DEVICE_LOST;
+    }
+
+    std::vector<uint8_t> reply_buffer;
+    CreateShaderModuleReply reply = {};
+    if (!g_client.receive(reply_buffer) || reply_buffer.size() < sizeof(reply)) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to receive shader module reply\n";
+        return VK_ERROR_DEVICE_LOST;
+    }
+    std::memcpy(&reply, reply_buffer.data(), sizeof(reply));
+    *remote_module = reinterpret_cast<VkShaderModule>(reply.shader_module);
+    return reply.result;
+}
+
+// Creates the module from the server's SPIR-V store, sending the code only
+// when the server has not seen it before.
+VkResult create_cached_shader_module(VkDevice remote_device,
+                                     const VkShaderModuleCreateInfo* info,
+                                     VkShaderModule* remote_module) {
+    // The request must not overtake a device-level call still in the ring.
+    vn_ring_flush_pending(&g_ring);
+
+    const Sha256Digest hash = sha256(info->pCode, info->codeSize);
+    const bool inline_code = info->codeSize <= kShaderInlineUploadBytes;
+    VkResult result = send_create_shader_module(remote_device, info, hash, inline_code, remote_module);
+    if (result == VK_SUCCESS && !inline_code) {
+        g_shader_store_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (result == VK_INCOMPLETE && !inline_code) {
+        ICD_LOG_INFO() << "[Client ICD] Shader module " << sha256_hex(hash) << " not cached; uploading "
+                       << info->codeSize << " bytes\n";
+        result = send_create_shader_module(remote_device, info, hash, true, remote_module);
+    }
+    return result;
+}
+
+} // namespace
+
 extern "C" {
 
 // Vulkan function implementations
@@ -34,11 +108,15 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(
 
     IcdDevice* icd_device = icd_device_from_handle(device);
     VkShaderModule remote_module = VK_NULL_HANDLE;
-    VkResult result = vn_call_vkCreateShaderModule(&g_ring,
-                                                   icd_device->remote_handle,
-                                                   pCreateInfo,
-                                                   pAllocator,
-                                                   &remote_module);
+    // Chained structs (validation features, module identifiers) still take
+    // the encoded path.
+    VkResult result = shader_cache_enabled() && pCreateInfo->pNext == nullptr
+                          ? create_cached_shader_module(icd_device->remote_handle, pCreateInfo, &remote_module)
+                          : vn_call_vkCreateShaderModule(&g_ring,
+                                                         icd_device->remote_handle,
+                                                         pCreateInfo,
+                                                         pAllocator,
+                                                         &remote_module);
     if (result != VK_SUCCESS) {
         ICD_LOG_ERROR() << "[Client ICD] vkCreateShaderModule failed: " << result << "\n";
         return result;
@@ -178,10 +256,16 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(
     }
 
     IcdDevice* icd_device = icd_device_from_handle(device);
-    vn_async_vkDestroyPipelineLayout(&g_ring,
-                                     icd_device->remote_handle,
-                                     remote_layout,
-                                     pAllocator);
+    VkDevice remote_device = icd_device->remote_handle;
+    // Recordings that used the layout may still be captured or waiting for
+    // their submit (destroying it after use is legal with maintenance4); the
+    // server's layout goes once the last of them has been sent.
+    auto destroy = [remote_device, remote_layout]() {
+        vn_async_vkDestroyPipelineLayout(&g_ring, remote_device, remote_layout, nullptr);
+    };
+    if (!g_deferred_recording.hold_pipeline_layout_destroy(remote_layout, destroy)) {
+        destroy();
+    }
     ICD_LOG_INFO() << "[Client ICD] Pipeline layout destroyed (local=" << pipelineLayout << ")\n";
 }
 
@@ -3,6 +3,74 @@
 
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
+#include "utils/format_info.h"
+
+namespace {
+
+// Answers from the memory requirements cache when the buffer was created
+// without a pNext chain, otherwise asks the server and keeps the answer. The
+// cache holds the server's memory type bits.
+void get_buffer_requirements(VkDevice device,
+                             VkBuffer buffer,
+                             VkBuffer remote_buffer,
+                             VkMemoryRequirements* requirements) {
+    VkBufferCreateInfo info;
+    const bool plain = g_resource_state.get_plain_buffer_info(buffer, &info);
+    if (!plain || !g_memory_requirements_cache.find_buffer(device, info, requirements)) {
+        IcdDevice* icd_device = icd_device_from_handle(device);
+        vn_call_vkGetBufferMemoryRequirements(&g_ring, icd_device->remote_handle, remote_buffer, requirements);
+        if (plain) {
+            g_memory_requirements_cache.store_buffer(device, info, *requirements);
+        }
+    }
+    report_memory_type_bits(device, requirements, g_resource_state.is_stageable_buffer(buffer));
+}
+
+void get_image_requirements(VkDevice device,
+                            VkImage image,
+                            VkImage remote_image,
+                            VkMemoryRequirements* requirements) {
+    VkImageCreateInfo info;
+    const bool plain = g_resource_state.get_plain_image_info(image, &info);
+    if (!plain || !g_memory_requirements_cache.find_image(device, info, requirements)) {
+        IcdDevice* icd_device = icd_device_from_handle(device);
+        vn_call_vkGetImageMemoryRequirements(&g_ring, icd_device->remote_handle, remote_image, requirements);
+        if (plain) {
+            g_memory_requirements_cache.store_image(device, info, *requirements);
+        }
+    }
+    report_memory_type_bits(device, requirements, false);
+}
+
+// Bytes a host image copy region spans in host memory, or 0 when the image
+// is unknown or its format has no listed block size. MEMCPY copies travel
+// tightly packed. Resolves VK_REMAINING_ARRAY_LAYERS in |subresource|.
+size_t host_copy_data_size(VkImage image,
+                           VkHostImageCopyFlags flags,
+                           uint32_t row_length,
+                           uint32_t image_height,
+                           VkImageSubresourceLayers* subresource,
+                           const VkExtent3D& extent) {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t array_layers = 0;
+    venus_plus::FormatBlock block;
+    if (!g_resource_state.get_image_format(image, &format, &array_layers) ||
+        !venus_plus::format_copy_block(format, subresource->aspectMask, &block)) {
+        return 0;
+    }
+    if (subresource->layerCount == VK_REMAINING_ARRAY_LAYERS) {
+        subresource->layerCount =
+            array_layers > subresource->baseArrayLayer ? array_layers - subresource->baseArrayLayer : 0;
+    }
+    if (flags & VK_HOST_IMAGE_COPY_MEMCPY) {
+        row_length = 0;
+        image_height = 0;
+    }
+    return static_cast<size_t>(
+        venus_plus::image_copy_size(block, row_length, image_height, extent, subresource->layerCount));
+}
+
+} // namespace
 
 extern "C" {
 
@@ -34,15 +102,16 @@ VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(
     IcdDevice* icd_device = icd_device_from_handle(device);
     VkDevice remote_device = icd_device->remote_handle;
 
+    const VkBufferCreateInfo real_info = staged_buffer_info(device, *pCreateInfo);
     VkBuffer remote_buffer = VK_NULL_HANDLE;
-    VkResult result = vn_call_vkCreateBuffer(&g_ring, remote_device, pCreateInfo, pAllocator, &remote_buffer);
+    VkResult result = vn_call_vkCreateBuffer(&g_ring, remote_device, &real_info, pAllocator, &remote_buffer);
     if (result != VK_SUCCESS) {
         ICD_LOG_ERROR() << "[Client ICD] vkCreateBuffer failed: " << result << "\n";
         return result;
     }
 
     VkBuffer local_buffer = g_handle_allocator.allocate<VkBuffer>();
-    g_resource_state.add_buffer(device, local_buffer, remote_buffer, *pCreateInfo);
+    g_resource_state.add_buffer(device, local_buffer, remote_buffer, real_info, buffer_stageable(real_info));
     *pBuffer = local_buffer;
 
     ICD_LOG_INFO() << "[Client ICD] Buffer created (local=" << *pBuffer
@@ -118,8 +187,7 @@ VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(
         return;
     }
 
-    IcdDevice* icd_device = icd_device_from_handle(device);
-    vn_call_vkGetBufferMemoryRequirements(&g_ring, icd_device->remote_handle, remote_buffer, pMemoryRequirements);
+    get_buffer_requirements(device, buffer, remote_buffer, pMemoryRequirements);
     g_resource_state.cache_buffer_requirements(buffer, *pMemoryRequirements);
 
     ICD_LOG_INFO() << "[Client ICD] Buffer memory requirements: size=" << pMemoryRequirements->size
@@ -154,6 +222,12 @@ VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(
         return;
     }
 
+    if (!pInfo->pNext && !pMemoryRequirements->pNext) {
+        get_buffer_requirements(device, pInfo->buffer, remote_buffer, &pMemoryRequirements->memoryRequirements);
+        g_resource_state.cache_buffer_requirements(pInfo->buffer, pMemoryRequirements->memoryRequirements);
+        return;
+    }
+
     VkBufferMemoryRequirementsInfo2 remote_info = *pInfo;
     remote_info.buffer = remote_buffer;
 
@@ -162,6 +236,12 @@ VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(
                                            icd_device->remote_handle,
                                            &remote_info,
                                            pMemoryRequirements);
+    VkBufferCreateInfo info;
+    if (!pInfo->pNext && g_resource_state.get_plain_buffer_info(pInfo->buffer, &info)) {
+        g_memory_requirements_cache.store_buffer(device, info, pMemoryRequirements->memoryRequirements);
+    }
+    report_memory_type_bits(
+        device, &pMemoryRequirements->memoryRequirements, g_resource_state.is_stageable_buffer(pInfo->buffer));
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2KHR(
@@ -730,8 +810,7 @@ VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(
         return;
     }
 
-    IcdDevice* icd_device = icd_device_from_handle(device);
-    vn_call_vkGetImageMemoryRequirements(&g_ring, icd_device->remote_handle, remote_image, pMemoryRequirements);
+    get_image_requirements(device, image, remote_image, pMemoryRequirements);
     g_resource_state.cache_image_requirements(image, *pMemoryRequirements);
 
     ICD_LOG_INFO() << "[Client ICD] Image memory requirements: size=" << pMemoryRequirements->size
@@ -766,6 +845,12 @@ VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(
         return;
     }
 
+    if (!pInfo->pNext && !pMemoryRequirements->pNext) {
+        get_image_requirements(device, pInfo->image, remote_image, &pMemoryRequirements->memoryRequirements);
+        g_resource_state.cache_image_requirements(pInfo->image, pMemoryRequirements->memoryRequirements);
+        return;
+    }
+
     VkImageMemoryRequirementsInfo2 remote_info = *pInfo;
     remote_info.image = remote_image;
 
@@ -774,6 +859,11 @@ VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(
                                           icd_device->remote_handle,
                                           &remote_info,
                                           pMemoryRequirements);
+    VkImageCreateInfo info;
+    if (!pInfo->pNext && g_resource_state.get_plain_image_info(pInfo->image, &info)) {
+        g_memory_requirements_cache.store_image(device, info, pMemoryRequirements->memoryRequirements);
+    }
+    report_memory_type_bits(device, &pMemoryRequirements->memoryRequirements, false);
 }
 
 VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2KHR(
@@ -874,4 +964,235 @@ VKAPI_ATTR void VKAPI_CALL vkGetImageSubresourceLayout(
     vn_call_vkGetImageSubresourceLayout(&g_ring, icd_device->remote_handle, remote_image, pSubresource, pLayout);
 }
 
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyMemoryToImage(
+    VkDevice device,
+    const VkCopyMemoryToImageInfo* pCopyMemoryToImageInfo) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCopyMemoryToImage called\n";
+
+    if (!pCopyMemoryToImageInfo ||
+        (pCopyMemoryToImageInfo->regionCount > 0 && !pCopyMemoryToImageInfo->pRegions)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkCopyMemoryToImage\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    const VkCopyMemoryToImageInfo& info = *pCopyMemoryToImageInfo;
+    VkImage remote_image = g_resource_state.get_remote_image(info.dstImage);
+    if (remote_image == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Image not tracked in vkCopyMemoryToImage\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // The texels go with the command, straight into the image on the server.
+    std::vector<VkMemoryToImageCopyMESA> regions(info.regionCount);
+    for (uint32_t i = 0; i < info.regionCount; ++i) {
+        const VkMemoryToImageCopy& source = info.pRegions[i];
+        VkMemoryToImageCopyMESA& region = regions[i];
+        region.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_MESA;
+        region.pNext = nullptr;
+        region.pData = source.pHostPointer;
+        region.memoryRowLength = source.memoryRowLength;
+        region.memoryImageHeight = source.memoryImageHeight;
+        region.imageSubresource = source.imageSubresource;
+        region.imageOffset = source.imageOffset;
+        region.imageExtent = source.imageExtent;
+        region.dataSize = host_copy_data_size(info.dstImage,
+                                              info.flags,
+                                              source.memoryRowLength,
+                                              source.memoryImageHeight,
+                                              &region.imageSubresource,
+                                              source.imageExtent);
+        if (region.dataSize == 0) {
+            ICD_LOG_ERROR() << "[Client ICD] Cannot size host image copy region " << i << "\n";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    VkCopyMemoryToImageInfoMESA remote_info = {};
+    remote_info.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_MESA;
+    remote_info.flags = info.flags;
+    remote_info.dstImage = remote_image;
+    remote_info.dstImageLayout = info.dstImageLayout;
+    remote_info.regionCount = info.regionCount;
+    remote_info.pRegions = regions.data();
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    VkResult result = vn_call_vkCopyMemoryToImageMESA(&g_ring, icd_device->remote_handle, &remote_info);
+    if (result != VK_SUCCESS) {
+        ICD_LOG_ERROR() << "[Client ICD] vkCopyMemoryToImage failed: " << result << "\n";
+    }
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyMemoryToImageEXT(
+    VkDevice device,
+    const VkCopyMemoryToImageInfo* pCopyMemoryToImageInfo) {
+    return vkCopyMemoryToImage(device, pCopyMemoryToImageInfo);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyImageToMemory(
+    VkDevice device,
+    const VkCopyImageToMemoryInfo* pCopyImageToMemoryInfo) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCopyImageToMemory called\n";
+
+    if (!pCopyImageToMemoryInfo ||
+        (pCopyImageToMemoryInfo->regionCount > 0 && !pCopyImageToMemoryInfo->pRegions)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkCopyImageToMemory\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    const VkCopyImageToMemoryInfo& info = *pCopyImageToMemoryInfo;
+    VkImage remote_image = g_resource_state.get_remote_image(info.srcImage);
+    if (remote_image == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Image not tracked in vkCopyImageToMemory\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    // One round trip per region; each reply carries the region's texels.
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    for (uint32_t i = 0; i < info.regionCount; ++i) {
+        const VkImageToMemoryCopy& source = info.pRegions[i];
+        VkCopyImageToMemoryInfoMESA remote_info = {};
+        remote_info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_MEMORY_INFO_MESA;
+        remote_info.flags = info.flags;
+        remote_info.srcImage = remote_image;
+        remote_info.srcImageLayout = info.srcImageLayout;
+        remote_info.memoryRowLength = source.memoryRowLength;
+        remote_info.memoryImageHeight = source.memoryImageHeight;
+        remote_info.imageSubresource = source.imageSubresource;
+        remote_info.imageOffset = source.imageOffset;
+        remote_info.imageExtent = source.imageExtent;
+        const size_t data_size = host_copy_data_size(info.srcImage,
+                                                     info.flags,
+                                                     source.memoryRowLength,
+                                                     source.memoryImageHeight,
+                                                     &remote_info.imageSubresource,
+                                                     source.imageExtent);
+        if (data_size == 0 || !source.pHostPointer) {
+            ICD_LOG_ERROR() << "[Client ICD] Cannot size host image copy region " << i << "\n";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        VkResult result = vn_call_vkCopyImageToMemoryMESA(
+            &g_ring, icd_device->remote_handle, &remote_info, data_size, source.pHostPointer);
+        if (result != VK_SUCCESS) {
+            ICD_LOG_ERROR() << "[Client ICD] vkCopyImageToMemory failed: " << result << "\n";
+            return result;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyImageToMemoryEXT(
+    VkDevice device,
+    const VkCopyImageToMemoryInfo* pCopyImageToMemoryInfo) {
+    return vkCopyImageToMemory(device, pCopyImageToMemoryInfo);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyImageToImage(
+    VkDevice device,
+    const VkCopyImageToImageInfo* pCopyImageToImageInfo) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkCopyImageToImage called\n";
+
+    if (!pCopyImageToImageInfo) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkCopyImageToImage\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkCopyImageToImageInfo remote_info = *pCopyImageToImageInfo;
+    remote_info.srcImage = g_resource_state.get_remote_image(pCopyImageToImageInfo->srcImage);
+    remote_info.dstImage = g_resource_state.get_remote_image(pCopyImageToImageInfo->dstImage);
+    if (remote_info.srcImage == VK_NULL_HANDLE || remote_info.dstImage == VK_NULL_HANDLE) {
+        ICD_LOG_ERROR() << "[Client ICD] Image not tracked in vkCopyImageToImage\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    VkResult result = vn_call_vkCopyImageToImage(&g_ring, icd_device->remote_handle, &remote_info);
+    if (result != VK_SUCCESS) {
+        ICD_LOG_ERROR() << "[Client ICD] vkCopyImageToImage failed: " << result << "\n";
+    }
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCopyImageToImageEXT(
+    VkDevice device,
+    const VkCopyImageToImageInfo* pCopyImageToImageInfo) {
+    return vkCopyImageToImage(device, pCopyImageToImageInfo);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkTransitionImageLayout(
+    VkDevice device,
+    uint32_t transitionCount,
+    const VkHostImageLayoutTransitionInfo* pTransitions) {
+
+    ICD_LOG_INFO() << "[Client ICD] vkTransitionImageLayout called (count=" << transitionCount << ")\n";
+
+    if (transitionCount > 0 && !pTransitions) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!ensure_connected()) {
+        ICD_LOG_ERROR() << "[Client ICD] Not connected to server\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    if (!g_device_state.has_device(device)) {
+        ICD_LOG_ERROR() << "[Client ICD] Unknown device in vkTransitionImageLayout\n";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    std::vector<VkHostImageLayoutTransitionInfo> transitions(pTransitions, pTransitions + transitionCount);
+    for (VkHostImageLayoutTransitionInfo& transition : transitions) {
+        transition.image = g_resource_state.get_remote_image(transition.image);
+        if (transition.image == VK_NULL_HANDLE) {
+            ICD_LOG_ERROR() << "[Client ICD] Image not tracked in vkTransitionImageLayout\n";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+
+    IcdDevice* icd_device = icd_device_from_handle(device);
+    VkResult result = vn_call_vkTransitionImageLayout(
+        &g_ring, icd_device->remote_handle, transitionCount, transitions.data());
+    if (result != VK_SUCCESS) {
+        ICD_LOG_ERROR() << "[Client ICD] vkTransitionImageLayout failed: " << result << "\n";
+    }
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkTransitionImageLayoutEXT(
+    VkDevice device,
+    uint32_t transitionCount,
+    const VkHostImageLayoutTransitionInfo* pTransitions) {
+    return vkTransitionImageLayout(device, transitionCount, pTransitions);
+}
+
 } // extern "C"
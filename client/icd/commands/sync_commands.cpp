@@ -538,6 +538,10 @@ VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(
                     ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit: command buffer not executable\n";
                     return VK_ERROR_VALIDATION_FAILED_EXT;
                 }
+                if (g_command_buffer_state.get_buffer_level(local_cb) != VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+                    ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit: secondary command buffers cannot be submitted\n";
+                    return VK_ERROR_VALIDATION_FAILED_EXT;
+                }
                 VkCommandBuffer remote_cb = get_remote_command_buffer_handle(local_cb);
                 if (remote_cb == VK_NULL_HANDLE) {
                     return VK_ERROR_INITIALIZATION_FAILED;
@@ -593,9 +597,19 @@ VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(
         }
     }
 
+    // Recordings vkEndCommandBuffer kept locally go out just ahead of the submit.
+    std::vector<VkCommandBuffer> submitted;
+    for (uint32_t i = 0; i < submitCount; ++i) {
+        for (uint32_t j = 0; j < pSubmits[i].commandBufferCount; ++j) {
+            submitted.push_back(pSubmits[i].pCommandBuffers[j]);
+            upload_deferred_recording(pSubmits[i].pCommandBuffers[j], &submitted);
+        }
+    }
+
     const VkSubmitInfo* submit_ptr = submitCount > 0 ? remote_submits.data() : nullptr;
     VkResult result = vn_call_vkQueueSubmit(&g_ring, remote_queue, submitCount, submit_ptr, remote_fence);
     if (result != VK_SUCCESS) {
+        invalidate_failed_submit(submitted);
         ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit failed: " << result << "\n";
         return result;
     }
@@ -727,6 +741,10 @@ VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit2(
                     ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit2: command buffer not executable\n";
                     return VK_ERROR_VALIDATION_FAILED_EXT;
                 }
+                if (g_command_buffer_state.get_buffer_level(local_cb) != VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+                    ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit2: secondary command buffers cannot be submitted\n";
+                    return VK_ERROR_VALIDATION_FAILED_EXT;
+                }
                 VkCommandBuffer remote_cb = get_remote_command_buffer_handle(local_cb);
                 if (remote_cb == VK_NULL_HANDLE) {
                     return VK_ERROR_INITIALIZATION_FAILED;
@@ -764,9 +782,19 @@ VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit2(
         }
     }
 
+    // Recordings vkEndCommandBuffer kept locally go out just ahead of the submit.
+    std::vector<VkCommandBuffer> submitted;
+    for (uint32_t i = 0; i < submitCount; ++i) {
+        for (uint32_t j = 0; j < pSubmits[i].commandBufferInfoCount; ++j) {
+            submitted.push_back(pSubmits[i].pCommandBufferInfos[j].commandBuffer);
+            upload_deferred_recording(pSubmits[i].pCommandBufferInfos[j].commandBuffer, &submitted);
+        }
+    }
+
     const VkSubmitInfo2* submit_ptr = submitCount > 0 ? remote_submits.data() : nullptr;
     VkResult result = vn_call_vkQueueSubmit2(&g_ring, remote_queue, submitCount, submit_ptr, remote_fence);
     if (result != VK_SUCCESS) {
+        invalidate_failed_submit(submitted);
         ICD_LOG_ERROR() << "[Client ICD] vkQueueSubmit2 failed: " << result << "\n";
         return result;
     }
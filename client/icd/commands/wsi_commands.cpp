@@ -3,6 +3,7 @@
 
 #include "icd/icd_entrypoints.h"
 #include "icd/commands/commands_common.h"
+#include "wsi/frame_decoder.h"
 
 // Helper functions (must be outside extern "C" to match header declarations)
 
@@ -23,6 +24,153 @@ bool send_swapchain_command(const void* request,
     return true;
 }
 
+namespace {
+
+// Reads |frame.payload_size| uncompressed bytes from the socket directly into
+// the rows of |target|. Always consumes the whole payload so the stream stays
+// in sync, even when the frame cannot be placed.
+bool receive_raw_frame_into(const VenusFrameHeader& frame, const WsiFrameTarget& target) {
+    const size_t visible = frame_visible_size(frame);
+    if (frame.width == 0 || frame.height == 0 || frame.payload_size < visible ||
+        !frame_fits_target(frame, target)) {
+        g_client.skip_payload(frame.payload_size);
+        return false;
+    }
+
+    const uint32_t src_stride = frame_source_stride(frame);
+    const size_t row_bytes = static_cast<size_t>(frame.width) * kFrameBytesPerPixel;
+    if (src_stride == target.stride) {
+        if (!g_client.receive_payload(target.pixels, visible)) {
+            return false;
+        }
+    } else {
+        for (uint32_t y = 0; y < frame.height; ++y) {
+            if (!g_client.receive_payload(target.pixels + static_cast<size_t>(y) * target.stride,
+                                          row_bytes)) {
+                return false;
+            }
+            if (y + 1 < frame.height && !g_client.skip_payload(src_stride - row_bytes)) {
+                return false;
+            }
+        }
+    }
+    return g_client.skip_payload(frame.payload_size - visible);
+}
+
+// Receives the frame that trails a present reply. When the WSI backend can
+// hand out its next buffer, raw payloads go from the socket straight into the
+// shm/dmabuf mapping and RLE payloads are decoded into it; otherwise the frame
+// is staged and passed to handle_frame(). Returns false if the connection
+// state is no longer trustworthy.
+bool receive_present_frame(PlatformWSI* wsi, const VenusFrameHeader& frame, size_t trailing) {
+    thread_local std::vector<uint8_t> staging;
+
+    WsiFrameTarget target;
+    if (wsi && wsi->acquire_frame_target(frame, &target)) {
+        bool filled = false;
+        if (frame.compression == FrameCompressionType::NONE) {
+            filled = receive_raw_frame_into(frame, target);
+        } else {
+            staging.resize(frame.payload_size);
+            if (!g_client.receive_payload(staging.data(), staging.size())) {
+                wsi->release_frame_target(frame, false);
+                return false;
+            }
+            filled = decode_frame_into(frame, staging.data(), target);
+        }
+        if (!filled) {
+            ICD_LOG_ERROR() << "[Client ICD] Failed to decode present frame\n";
+        }
+        wsi->release_frame_target(frame, filled);
+    } else {
+        staging.resize(frame.payload_size);
+        if (!g_client.receive_payload(staging.data(), staging.size())) {
+            return false;
+        }
+        if (wsi) {
+            wsi->handle_frame(frame, staging.data());
+        }
+    }
+    return g_client.skip_payload(trailing);
+}
+
+// One swapchain of a vkQueuePresentKHR call that is sent to the server.
+struct PendingPresent {
+    uint32_t slot = 0; // index into the VkPresentInfoKHR arrays
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    std::shared_ptr<FramePacer> pacer;
+};
+
+// Streams a VENUS_PLUS_CMD_PRESENT_BATCH reply, handing each frame to its
+// swapchain's WSI as it arrives. Per-swapchain results land in |results|,
+// indexed by slot. Returns false if the connection state is no longer
+// trustworthy.
+bool receive_present_batch_reply(const PendingPresent* pending,
+                                 uint32_t pending_count,
+                                 FramePacer::Clock::time_point start,
+                                 std::vector<VkResult>* results) {
+    uint32_t message_size = 0;
+    if (!g_client.receive_header(&message_size)) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to receive swapchain reply";
+        return false;
+    }
+    if (message_size < sizeof(VenusSwapchainPresentBatchReplyHeader)) {
+        ICD_LOG_ERROR() << "[Client ICD] Invalid present reply size\n";
+        g_client.skip_payload(message_size);
+        return false;
+    }
+
+    VenusSwapchainPresentBatchReplyHeader header = {};
+    if (!g_client.receive_payload(&header, sizeof(header))) {
+        ICD_LOG_ERROR() << "[Client ICD] Failed to receive swapchain reply";
+        return false;
+    }
+    size_t remaining = message_size - sizeof(header);
+    if (header.present_count != pending_count) {
+        ICD_LOG_ERROR() << "[Client ICD] Present reply count mismatch\n";
+        g_client.skip_payload(remaining);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < pending_count; ++i) {
+        const PendingPresent& entry = pending[i];
+        VenusSwapchainPresentReply reply = {};
+        if (remaining < sizeof(reply) || !g_client.receive_payload(&reply, sizeof(reply))) {
+            ICD_LOG_ERROR() << "[Client ICD] Present reply truncated\n";
+            g_client.skip_payload(remaining);
+            return false;
+        }
+        remaining -= sizeof(reply);
+        (*results)[entry.slot] = reply.result;
+        if (reply.result != VK_SUCCESS) {
+            continue;
+        }
+        if (remaining < reply.frame.payload_size) {
+            ICD_LOG_ERROR() << "[Client ICD] Present payload truncated\n";
+            g_client.skip_payload(remaining);
+            return false;
+        }
+        remaining -= reply.frame.payload_size;
+
+        auto wsi = g_swapchain_state.get_wsi(entry.swapchain);
+        if (!receive_present_frame(wsi.get(), reply.frame, 0)) {
+            ICD_LOG_ERROR() << "[Client ICD] Failed to receive present payload\n";
+            return false;
+        }
+        if (entry.pacer) {
+            FramePacer::PresentSample sample;
+            sample.start = start;
+            sample.end = FramePacer::Clock::now();
+            sample.server_time_us = reply.server_time_us;
+            sample.payload_bytes = reply.frame.payload_size;
+            entry.pacer->record_present(sample);
+        }
+    }
+    return g_client.skip_payload(remaining);
+}
+
+} // namespace
+
 extern "C" {
 
 // Vulkan function implementations
@@ -411,6 +559,9 @@ VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(
     if (info.wsi) {
         info.wsi->shutdown();
     }
+    if (info.pacer) {
+        info.pacer->log_stats();
+    }
 
     if (!ensure_connected()) {
         ICD_LOG_ERROR() << "[Client ICD] Not connected to server during swapchain destroy\n";
@@ -500,6 +651,10 @@ VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
+    if (auto pacer = g_swapchain_state.get_pacer(swapchain)) {
+        pacer->throttle_acquire();
+    }
+
     VenusSwapchainAcquireRequest request = {};
     request.command = VENUS_PLUS_CMD_ACQUIRE_IMAGE;
     request.swapchain_id = remote_id;
@@ -559,50 +714,118 @@ VKAPI_ATTR VkResult VKAPI_CALL vkQueuePresentKHR(
     }
     (void)remote_queue;
 
-    VkResult final_result = VK_SUCCESS;
-    for (uint32_t i = 0; i < pPresentInfo->swapchainCount; ++i) {
+    const uint32_t swapchain_count = pPresentInfo->swapchainCount;
+    std::vector<VkResult> results(swapchain_count, VK_SUCCESS);
+    std::vector<PendingPresent> pending;
+    std::vector<VenusSwapchainPresentEntry> entries;
+    pending.reserve(swapchain_count);
+    entries.reserve(swapchain_count);
+
+    for (uint32_t i = 0; i < swapchain_count; ++i) {
         VkSwapchainKHR swapchain = pPresentInfo->pSwapchains[i];
-        uint32_t image_index = pPresentInfo->pImageIndices ? pPresentInfo->pImageIndices[i] : 0;
         uint32_t remote_id = g_swapchain_state.get_remote_id(swapchain);
         if (remote_id == 0) {
             ICD_LOG_ERROR() << "[Client ICD] Unknown swapchain in queue present\n";
             return VK_ERROR_INITIALIZATION_FAILED;
         }
 
-        VenusSwapchainPresentRequest request = {};
-        request.command = VENUS_PLUS_CMD_PRESENT;
-        request.swapchain_id = remote_id;
-        request.image_index = image_index;
-
-        std::vector<uint8_t> reply_buffer;
-        if (!send_swapchain_command(&request, sizeof(request), &reply_buffer)) {
-            return VK_ERROR_INITIALIZATION_FAILED;
+        auto pacer = g_swapchain_state.get_pacer(swapchain);
+        FramePacer::PresentPlan plan;
+        if (pacer) {
+            plan = pacer->plan_present();
         }
-        if (reply_buffer.size() < sizeof(VenusSwapchainPresentReply)) {
-            ICD_LOG_ERROR() << "[Client ICD] Invalid present reply size\n";
-            return VK_ERROR_INITIALIZATION_FAILED;
+        if (plan.skip) {
+            // Stale under mailbox semantics: the image is released without
+            // being read back or transferred.
+            pacer->record_drop();
+            continue;
         }
 
-        const auto* reply = reinterpret_cast<const VenusSwapchainPresentReply*>(reply_buffer.data());
-        if (reply->result != VK_SUCCESS) {
-            final_result = reply->result;
-            continue;
+        VenusSwapchainPresentEntry entry = {};
+        entry.swapchain_id = remote_id;
+        entry.image_index = pPresentInfo->pImageIndices ? pPresentInfo->pImageIndices[i] : 0;
+        entry.codec_level = plan.codec_level;
+        entries.push_back(entry);
+
+        PendingPresent present;
+        present.slot = i;
+        present.swapchain = swapchain;
+        present.pacer = std::move(pacer);
+        pending.push_back(std::move(present));
+    }
+
+    std::vector<uint64_t> wait_semaphores;
+    if (pPresentInfo->waitSemaphoreCount > 0 && pPresentInfo->pWaitSemaphores) {
+        wait_semaphores.reserve(pPresentInfo->waitSemaphoreCount);
+        for (uint32_t i = 0; i < pPresentInfo->waitSemaphoreCount; ++i) {
+            VkSemaphore wait_sem = pPresentInfo->pWaitSemaphores[i];
+            VkSemaphore remote = g_sync_state.has_semaphore(wait_sem)
+                                     ? g_sync_state.get_remote_semaphore(wait_sem)
+                                     : VK_NULL_HANDLE;
+            if (remote == VK_NULL_HANDLE) {
+                ICD_LOG_ERROR() << "[Client ICD] vkQueuePresentKHR: wait semaphore not tracked\n";
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            wait_semaphores.push_back(reinterpret_cast<uint64_t>(remote));
         }
+    }
 
-        size_t payload_size = reply_buffer.size() - sizeof(VenusSwapchainPresentReply);
-        if (payload_size < reply->frame.payload_size) {
-            ICD_LOG_ERROR() << "[Client ICD] Present payload truncated\n";
-            final_result = VK_ERROR_INITIALIZATION_FAILED;
-            continue;
+    // All swapchains go out in as few messages as possible; the wait
+    // semaphores ride with the first one.
+    std::vector<uint8_t> request;
+    size_t first = 0;
+    while (first < entries.size() || (first == 0 && !wait_semaphores.empty())) {
+        const uint32_t batch_count = static_cast<uint32_t>(
+            std::min<size_t>(entries.size() - first, kVenusMaxBatchPresents));
+        const uint32_t wait_count = first == 0 ? static_cast<uint32_t>(wait_semaphores.size()) : 0;
+
+        VenusSwapchainPresentBatchHeader header = {};
+        header.command = VENUS_PLUS_CMD_PRESENT_BATCH;
+        header.present_count = batch_count;
+        header.wait_semaphore_count = wait_count;
+
+        const size_t entry_bytes = batch_count * sizeof(VenusSwapchainPresentEntry);
+        const size_t wait_bytes = wait_count * sizeof(uint64_t);
+        request.resize(sizeof(header) + entry_bytes + wait_bytes);
+        std::memcpy(request.data(), &header, sizeof(header));
+        if (entry_bytes > 0) {
+            std::memcpy(request.data() + sizeof(header), entries.data() + first, entry_bytes);
+        }
+        if (wait_bytes > 0) {
+            std::memcpy(request.data() + sizeof(header) + entry_bytes, wait_semaphores.data(), wait_bytes);
         }
 
-        const uint8_t* payload = reply_buffer.data() + sizeof(VenusSwapchainPresentReply);
-        auto wsi = g_swapchain_state.get_wsi(swapchain);
-        if (wsi) {
-            wsi->handle_frame(reply->frame, payload);
+        const auto start = FramePacer::Clock::now();
+        if (!g_client.send(request.data(), request.size())) {
+            ICD_LOG_ERROR() << "[Client ICD] Failed to send swapchain command";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        // The reply carries whole frames; stream it instead of buffering the
+        // message so each payload can land directly in its WSI buffer.
+        if (!receive_present_batch_reply(pending.data() + first, batch_count, start, &results)) {
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        if (first == 0) {
+            // The server's readback submission consumed the wait semaphores.
+            for (uint32_t i = 0; i < wait_count; ++i) {
+                g_sync_state.set_binary_semaphore_signaled(pPresentInfo->pWaitSemaphores[i], false);
+            }
+        }
+        first += batch_count;
+        if (batch_count == 0) {
+            break;
         }
     }
 
+    VkResult final_result = VK_SUCCESS;
+    for (uint32_t i = 0; i < swapchain_count; ++i) {
+        if (pPresentInfo->pResults) {
+            pPresentInfo->pResults[i] = results[i];
+        }
+        if (results[i] != VK_SUCCESS && final_result == VK_SUCCESS) {
+            final_result = results[i];
+        }
+    }
     return final_result;
 }
 
@@ -508,6 +508,21 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, co
         ICD_LOG_INFO() << " -> vkUpdateDescriptorSets\n";
         return (PFN_vkVoidFunction)vkUpdateDescriptorSets;
     }
+    if (strcmp(pName, "vkCreateDescriptorUpdateTemplate") == 0 ||
+        strcmp(pName, "vkCreateDescriptorUpdateTemplateKHR") == 0) {
+        ICD_LOG_INFO() << " -> vkCreateDescriptorUpdateTemplate\n";
+        return (PFN_vkVoidFunction)vkCreateDescriptorUpdateTemplate;
+    }
+    if (strcmp(pName, "vkDestroyDescriptorUpdateTemplate") == 0 ||
+        strcmp(pName, "vkDestroyDescriptorUpdateTemplateKHR") == 0) {
+        ICD_LOG_INFO() << " -> vkDestroyDescriptorUpdateTemplate\n";
+        return (PFN_vkVoidFunction)vkDestroyDescriptorUpdateTemplate;
+    }
+    if (strcmp(pName, "vkUpdateDescriptorSetWithTemplate") == 0 ||
+        strcmp(pName, "vkUpdateDescriptorSetWithTemplateKHR") == 0) {
+        ICD_LOG_INFO() << " -> vkUpdateDescriptorSetWithTemplate\n";
+        return (PFN_vkVoidFunction)vkUpdateDescriptorSetWithTemplate;
+    }
     if (strcmp(pName, "vkCreatePipelineLayout") == 0) {
         ICD_LOG_INFO() << " -> vkCreatePipelineLayout\n";
         return (PFN_vkVoidFunction)vkCreatePipelineLayout;
@@ -620,6 +635,38 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, co
         ICD_LOG_INFO() << " -> vkGetImageSubresourceLayout\n";
         return (PFN_vkVoidFunction)vkGetImageSubresourceLayout;
     }
+    if (strcmp(pName, "vkCopyMemoryToImage") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyMemoryToImage\n";
+        return (PFN_vkVoidFunction)vkCopyMemoryToImage;
+    }
+    if (strcmp(pName, "vkCopyMemoryToImageEXT") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyMemoryToImageEXT\n";
+        return (PFN_vkVoidFunction)vkCopyMemoryToImageEXT;
+    }
+    if (strcmp(pName, "vkCopyImageToMemory") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyImageToMemory\n";
+        return (PFN_vkVoidFunction)vkCopyImageToMemory;
+    }
+    if (strcmp(pName, "vkCopyImageToMemoryEXT") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyImageToMemoryEXT\n";
+        return (PFN_vkVoidFunction)vkCopyImageToMemoryEXT;
+    }
+    if (strcmp(pName, "vkCopyImageToImage") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyImageToImage\n";
+        return (PFN_vkVoidFunction)vkCopyImageToImage;
+    }
+    if (strcmp(pName, "vkCopyImageToImageEXT") == 0) {
+        ICD_LOG_INFO() << " -> vkCopyImageToImageEXT\n";
+        return (PFN_vkVoidFunction)vkCopyImageToImageEXT;
+    }
+    if (strcmp(pName, "vkTransitionImageLayout") == 0) {
+        ICD_LOG_INFO() << " -> vkTransitionImageLayout\n";
+        return (PFN_vkVoidFunction)vkTransitionImageLayout;
+    }
+    if (strcmp(pName, "vkTransitionImageLayoutEXT") == 0) {
+        ICD_LOG_INFO() << " -> vkTransitionImageLayoutEXT\n";
+        return (PFN_vkVoidFunction)vkTransitionImageLayoutEXT;
+    }
     if (strcmp(pName, "vkCreateCommandPool") == 0) {
         ICD_LOG_INFO() << " -> vkCreateCommandPool\n";
         return (PFN_vkVoidFunction)vkCreateCommandPool;
@@ -888,10 +935,56 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, co
         ICD_LOG_INFO() << " -> vkCmdDraw\n";
         return (PFN_vkVoidFunction)vkCmdDraw;
     }
+    if (strcmp(pName, "vkCmdBindIndexBuffer") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdBindIndexBuffer\n";
+        return (PFN_vkVoidFunction)vkCmdBindIndexBuffer;
+    }
+    if (strcmp(pName, "vkCmdDrawIndexed") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndexed\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndexed;
+    }
+    if (strcmp(pName, "vkCmdDrawIndirect") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndirect\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndirect;
+    }
+    if (strcmp(pName, "vkCmdDrawIndexedIndirect") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndexedIndirect\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndexedIndirect;
+    }
+    if (strcmp(pName, "vkCmdDrawIndirectCount") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndirectCount\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndirectCount;
+    }
+    if (strcmp(pName, "vkCmdDrawIndirectCountKHR") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndirectCountKHR\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndirectCountKHR;
+    }
+    if (strcmp(pName, "vkCmdDrawIndexedIndirectCount") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndexedIndirectCount\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndexedIndirectCount;
+    }
+    if (strcmp(pName, "vkCmdDrawIndexedIndirectCountKHR") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdDrawIndexedIndirectCountKHR\n";
+        return (PFN_vkVoidFunction)vkCmdDrawIndexedIndirectCountKHR;
+    }
+    if (strcmp(pName, "vkCmdExecuteCommands") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdExecuteCommands\n";
+        return (PFN_vkVoidFunction)vkCmdExecuteCommands;
+    }
     if (strcmp(pName, "vkCmdBindDescriptorSets") == 0) {
         ICD_LOG_INFO() << " -> vkCmdBindDescriptorSets\n";
         return (PFN_vkVoidFunction)vkCmdBindDescriptorSets;
     }
+    if (strcmp(pName, "vkCmdPushDescriptorSetKHR") == 0 ||
+        strcmp(pName, "vkCmdPushDescriptorSet") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdPushDescriptorSetKHR\n";
+        return (PFN_vkVoidFunction)vkCmdPushDescriptorSetKHR;
+    }
+    if (strcmp(pName, "vkCmdPushDescriptorSetWithTemplateKHR") == 0 ||
+        strcmp(pName, "vkCmdPushDescriptorSetWithTemplate") == 0) {
+        ICD_LOG_INFO() << " -> vkCmdPushDescriptorSetWithTemplateKHR\n";
+        return (PFN_vkVoidFunction)vkCmdPushDescriptorSetWithTemplateKHR;
+    }
     if (strcmp(pName, "vkCmdDispatch") == 0) {
         ICD_LOG_INFO() << " -> vkCmdDispatch\n";
         return (PFN_vkVoidFunction)vkCmdDispatch;
@@ -1068,6 +1161,10 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, co
         ICD_LOG_INFO() << " -> vkDeviceWaitIdle\n";
         return (PFN_vkVoidFunction)vkDeviceWaitIdle;
     }
+    if (strcmp(pName, venus_plus::kGetClientStatsName) == 0) {
+        ICD_LOG_INFO() << " -> vkGetClientStatsVENUSPLUS\n";
+        return (PFN_vkVoidFunction)vkGetClientStatsVENUSPLUS;
+    }
 
     ICD_LOG_INFO() << " -> NOT IMPLEMENTED, returning nullptr\n";
     return nullptr;
@@ -67,12 +67,15 @@ VkCommandPoolCreateFlags CommandBufferState::get_pool_flags(VkCommandPool pool)
     return it->second.flags;
 }
 
-void CommandBufferState::reset_pool(VkCommandPool pool) {
+void CommandBufferState::reset_pool(VkCommandPool pool, std::vector<VkCommandBuffer>* buffers_reset) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = pools_.find(handle_key(pool));
     if (it == pools_.end()) {
         return;
     }
+    if (buffers_reset) {
+        *buffers_reset = it->second.command_buffers;
+    }
     for (VkCommandBuffer buffer : it->second.command_buffers) {
         auto bit = buffers_.find(handle_key(buffer));
         if (bit != buffers_.end()) {
@@ -132,6 +135,15 @@ VkCommandPool CommandBufferState::get_buffer_pool(VkCommandBuffer buffer) const
     return bit->second.pool;
 }
 
+VkCommandBufferLevel CommandBufferState::get_buffer_level(VkCommandBuffer buffer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    if (bit == buffers_.end()) {
+        return VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    }
+    return bit->second.level;
+}
+
 VkCommandBuffer CommandBufferState::get_remote_command_buffer(VkCommandBuffer buffer) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto bit = buffers_.find(handle_key(buffer));
@@ -180,6 +192,25 @@ void CommandBufferState::set_usage_flags(VkCommandBuffer buffer, VkCommandBuffer
     bit->second.usage_flags = flags;
 }
 
+void CommandBufferState::mark_reset_elided(VkCommandBuffer buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    if (bit != buffers_.end()) {
+        bit->second.reset_elided = true;
+    }
+}
+
+bool CommandBufferState::take_reset_elided(VkCommandBuffer buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    if (bit == buffers_.end()) {
+        return false;
+    }
+    bool elided = bit->second.reset_elided;
+    bit->second.reset_elided = false;
+    return elided;
+}
+
 void CommandBufferState::remove_device(VkDevice device,
                                        std::vector<VkCommandBuffer>* buffers_to_free,
                                        std::vector<VkCommandPool>* pools_removed) {
@@ -30,6 +30,8 @@ struct CommandBufferInfo {
     VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     CommandBufferLifecycleState state = CommandBufferLifecycleState::INITIAL;
     VkCommandBufferUsageFlags usage_flags = 0;
+    // A reset kept from the server; see ResetElidedRequest.
+    bool reset_elided = false;
 };
 
 class CommandBufferState {
@@ -40,17 +42,21 @@ public:
     VkCommandPool get_remote_pool(VkCommandPool pool) const;
     VkDevice get_pool_device(VkCommandPool pool) const;
     VkCommandPoolCreateFlags get_pool_flags(VkCommandPool pool) const;
-    void reset_pool(VkCommandPool pool);
+    void reset_pool(VkCommandPool pool, std::vector<VkCommandBuffer>* buffers_reset);
 
     void add_command_buffer(VkCommandPool pool, VkCommandBuffer local, VkCommandBuffer remote, VkCommandBufferLevel level);
     bool remove_command_buffer(VkCommandBuffer buffer);
     bool has_command_buffer(VkCommandBuffer buffer) const;
     VkCommandPool get_buffer_pool(VkCommandBuffer buffer) const;
+    VkCommandBufferLevel get_buffer_level(VkCommandBuffer buffer) const;
     VkCommandBuffer get_remote_command_buffer(VkCommandBuffer buffer) const;
     CommandBufferLifecycleState get_buffer_state(VkCommandBuffer buffer) const;
     void set_buffer_state(VkCommandBuffer buffer, CommandBufferLifecycleState state);
     VkCommandBufferUsageFlags get_usage_flags(VkCommandBuffer buffer) const;
     void set_usage_flags(VkCommandBuffer buffer, VkCommandBufferUsageFlags flags);
+    void mark_reset_elided(VkCommandBuffer buffer);
+    // Returns and clears the mark.
+    bool take_reset_elided(VkCommandBuffer buffer);
 
     void remove_device(VkDevice device,
                        std::vector<VkCommandBuffer>* buffers_to_free,
@@ -0,0 +1,205 @@
+#include "state/deferred_recording.h"
+
+#include "utils/logging.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace venus_plus {
+
+DeferredRecording g_deferred_recording;
+
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    const int parsed = std::atoi(value);
+    return parsed > 0 ? static_cast<uint32_t>(parsed) : fallback;
+}
+
+} // namespace
+
+DeferredRecording::DeferredRecording() {
+    enabled_ = !env_disabled("VENUS_DEFERRED_RECORDING");
+    stats_interval_ = env_uint("VENUS_DEFERRED_RECORDING_STATS", 0);
+}
+
+void DeferredRecording::discard_locked(Entry& entry, DestroyList* ready) {
+    if (entry.pending) {
+        ++stats_.discarded;
+    }
+    entry.pending = false;
+    entry.stream.clear();
+    entry.secondaries.clear();
+    release_layouts_locked(entry, ready);
+}
+
+void DeferredRecording::release_layouts_locked(Entry& entry, DestroyList* ready) {
+    for (uint64_t layout : entry.layouts) {
+        auto it = held_.find(layout);
+        if (it != held_.end() && --it->second.users == 0) {
+            ready->push_back(std::move(it->second.destroy));
+            held_.erase(it);
+        }
+    }
+    entry.layouts.clear();
+}
+
+void DeferredRecording::run(DestroyList& ready) {
+    for (auto& destroy : ready) {
+        destroy();
+    }
+}
+
+void DeferredRecording::begin(VkCommandBuffer command_buffer) {
+    DestroyList ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        discard_locked(entries_[handle_key(command_buffer)], &ready);
+    }
+    run(ready);
+}
+
+void DeferredRecording::note_secondaries(VkCommandBuffer command_buffer,
+                                         uint32_t count,
+                                         const VkCommandBuffer* secondaries) {
+    if (!enabled_ || count == 0 || !secondaries) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it != entries_.end()) {
+        it->second.secondaries.insert(it->second.secondaries.end(), secondaries, secondaries + count);
+    }
+}
+
+void DeferredRecording::end(VkCommandBuffer command_buffer, std::vector<uint8_t>&& stream) {
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[handle_key(command_buffer)];
+        entry.pending = true;
+        entry.stream = std::move(stream);
+        ++stats_.recordings;
+        log = stats_interval_ && stats_.recordings % stats_interval_ == 0;
+    }
+    if (log) {
+        log_stats();
+    }
+}
+
+bool DeferredRecording::take(VkCommandBuffer command_buffer,
+                             std::vector<uint8_t>* stream,
+                             std::vector<VkCommandBuffer>* secondaries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it == entries_.end() || !it->second.pending) {
+        return false;
+    }
+    Entry& entry = it->second;
+    ++stats_.uploads;
+    stats_.bytes_uploaded += entry.stream.size();
+    *stream = std::move(entry.stream);
+    *secondaries = std::move(entry.secondaries);
+    entry.pending = false;
+    entry.stream.clear();
+    entry.secondaries.clear();
+    return true;
+}
+
+void DeferredRecording::discard(VkCommandBuffer command_buffer) {
+    DestroyList ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle_key(command_buffer));
+        if (it != entries_.end()) {
+            discard_locked(it->second, &ready);
+        }
+    }
+    run(ready);
+}
+
+void DeferredRecording::remove(VkCommandBuffer command_buffer) {
+    DestroyList ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle_key(command_buffer));
+        if (it != entries_.end()) {
+            discard_locked(it->second, &ready);
+            entries_.erase(it);
+        }
+    }
+    run(ready);
+}
+
+void DeferredRecording::note_pipeline_layout(VkCommandBuffer command_buffer, VkPipelineLayout remote_layout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it == entries_.end()) {
+        return;
+    }
+    std::vector<uint64_t>& layouts = it->second.layouts;
+    const uint64_t key = handle_key(remote_layout);
+    if (std::find(layouts.begin(), layouts.end(), key) == layouts.end()) {
+        layouts.push_back(key);
+    }
+}
+
+bool DeferredRecording::hold_pipeline_layout_destroy(VkPipelineLayout remote_layout,
+                                                     std::function<void()> destroy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t key = handle_key(remote_layout);
+    uint32_t users = 0;
+    for (const auto& entry : entries_) {
+        const std::vector<uint64_t>& layouts = entry.second.layouts;
+        if (std::find(layouts.begin(), layouts.end(), key) != layouts.end()) {
+            ++users;
+        }
+    }
+    if (users == 0) {
+        return false;
+    }
+    HeldDestroy& held = held_[key];
+    held.users = users;
+    held.destroy = std::move(destroy);
+    return true;
+}
+
+void DeferredRecording::release_pipeline_layouts(VkCommandBuffer command_buffer) {
+    DestroyList ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle_key(command_buffer));
+        if (it != entries_.end()) {
+            release_layouts_locked(it->second, &ready);
+        }
+    }
+    run(ready);
+}
+
+DeferredRecordingStats DeferredRecording::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DeferredRecording::log_stats() const {
+    const DeferredRecordingStats snapshot = stats();
+    VP_LOG_STREAM_INFO(CLIENT) << "[Deferred] recordings=" << snapshot.recordings
+                               << " uploads=" << snapshot.uploads
+                               << " discarded=" << snapshot.discarded
+                               << " bytes_uploaded=" << snapshot.bytes_uploaded;
+}
+
+} // namespace venus_plus
@@ -0,0 +1,96 @@
+#ifndef VENUS_PLUS_DEFERRED_RECORDING_H
+#define VENUS_PLUS_DEFERRED_RECORDING_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+struct DeferredRecordingStats {
+    uint64_t recordings = 0;     // vkEndCommandBuffer calls kept locally
+    uint64_t uploads = 0;        // recordings handed to the server at submit
+    uint64_t discarded = 0;      // re-recorded, reset or freed without a submit
+    uint64_t bytes_uploaded = 0; // encoded command bytes of the uploads
+};
+
+// Holds each command buffer's encoded stream (vkBeginCommandBuffer through the
+// last vkCmd*) from vkEndCommandBuffer until its first submit, so begin and end
+// need no round trip and a recording that is never submitted costs nothing on
+// the wire. Secondaries executed by a recording are uploaded before it.
+// Pipeline layouts may be destroyed right after use (maintenance4, Vulkan
+// 1.3); the server's copy of one stays alive until every captured or
+// deferred recording that uses it has been sent.
+// Tunables: VENUS_DEFERRED_RECORDING=off, VENUS_DEFERRED_RECORDING_STATS=<log every N recordings>.
+class DeferredRecording {
+public:
+    DeferredRecording();
+
+    bool enabled() const { return enabled_; }
+
+    // Starts a new recording; an earlier one still waiting for upload is dropped.
+    void begin(VkCommandBuffer command_buffer);
+    void note_secondaries(VkCommandBuffer command_buffer, uint32_t count, const VkCommandBuffer* secondaries);
+    void end(VkCommandBuffer command_buffer, std::vector<uint8_t>&& stream);
+
+    // Hands out the recording waiting for upload, if any, with the secondaries
+    // it executes.
+    bool take(VkCommandBuffer command_buffer,
+              std::vector<uint8_t>* stream,
+              std::vector<VkCommandBuffer>* secondaries);
+    void discard(VkCommandBuffer command_buffer);
+    void remove(VkCommandBuffer command_buffer);
+
+    // |remote_layout| is used by the recording in progress.
+    void note_pipeline_layout(VkCommandBuffer command_buffer, VkPipelineLayout remote_layout);
+    // False when no unsent recording uses |remote_layout|; otherwise |destroy|
+    // runs once the last of them is sent or dropped.
+    bool hold_pipeline_layout_destroy(VkPipelineLayout remote_layout, std::function<void()> destroy);
+    // The recording of |command_buffer| has been sent (or reused).
+    void release_pipeline_layouts(VkCommandBuffer command_buffer);
+
+    DeferredRecordingStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Entry {
+        bool pending = false;
+        std::vector<uint8_t> stream;
+        std::vector<VkCommandBuffer> secondaries;
+        std::vector<uint64_t> layouts;
+    };
+
+    struct HeldDestroy {
+        uint32_t users = 0;
+        std::function<void()> destroy;
+    };
+
+    template <typename T>
+    static uint64_t handle_key(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    using DestroyList = std::vector<std::function<void()>>;
+
+    void discard_locked(Entry& entry, DestroyList* ready);
+    void release_layouts_locked(Entry& entry, DestroyList* ready);
+    static void run(DestroyList& ready);
+
+    bool enabled_ = true;
+    uint32_t stats_interval_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    std::unordered_map<uint64_t, HeldDestroy> held_;
+    DeferredRecordingStats stats_;
+};
+
+extern DeferredRecording g_deferred_recording;
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_DEFERRED_RECORDING_H
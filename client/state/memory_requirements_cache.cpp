@@ -0,0 +1,177 @@
+#include "state/memory_requirements_cache.h"
+
+#include "utils/logging.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace venus_plus {
+
+MemoryRequirementsCache g_memory_requirements_cache;
+
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    const int parsed = std::atoi(value);
+    return parsed > 0 ? static_cast<uint32_t>(parsed) : fallback;
+}
+
+template <typename T>
+void append(std::string* key, const T& value) {
+    key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename Map>
+void erase_device(Map* map, const std::string& prefix) {
+    for (auto it = map->begin(); it != map->end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = map->erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace
+
+MemoryRequirementsCache::MemoryRequirementsCache() {
+    enabled_ = !env_disabled("VENUS_MEMORY_REQUIREMENTS_CACHE");
+    stats_interval_ = env_uint("VENUS_MEMORY_REQUIREMENTS_STATS", 0);
+}
+
+std::string MemoryRequirementsCache::buffer_key(VkDevice device, const VkBufferCreateInfo& info) {
+    std::string key;
+    append(&key, device);
+    append(&key, info.flags);
+    append(&key, info.usage);
+    append(&key, info.size);
+    return key;
+}
+
+std::string MemoryRequirementsCache::image_key(VkDevice device, const VkImageCreateInfo& info) {
+    std::string key;
+    append(&key, device);
+    append(&key, info.flags);
+    append(&key, info.imageType);
+    append(&key, info.format);
+    append(&key, info.extent);
+    append(&key, info.mipLevels);
+    append(&key, info.arrayLayers);
+    append(&key, info.samples);
+    append(&key, info.tiling);
+    append(&key, info.usage);
+    return key;
+}
+
+void MemoryRequirementsCache::count_lookup_locked(bool* log) {
+    const uint64_t lookups = stats_.hits + stats_.misses;
+    *log = stats_interval_ && lookups % stats_interval_ == 0;
+}
+
+bool MemoryRequirementsCache::find_buffer(VkDevice device, const VkBufferCreateInfo& info, VkMemoryRequirements* out) {
+    if (!enabled_ || info.pNext) {
+        return false;
+    }
+    const std::string key = buffer_key(device, info);
+    bool found = false;
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = buffers_.find(key);
+        if (it != buffers_.end()) {
+            *out = it->second;
+            found = true;
+            ++stats_.hits;
+        } else {
+            ++stats_.misses;
+        }
+        count_lookup_locked(&log);
+    }
+    if (log) {
+        log_stats();
+    }
+    return found;
+}
+
+void MemoryRequirementsCache::store_buffer(VkDevice device,
+                                           const VkBufferCreateInfo& info,
+                                           const VkMemoryRequirements& requirements,
+                                           bool prefill) {
+    // A zero size is what a failed query leaves behind.
+    if (!enabled_ || info.pNext || requirements.size == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffers_.emplace(buffer_key(device, info), requirements).second && prefill) {
+        ++stats_.prefilled;
+    }
+}
+
+bool MemoryRequirementsCache::find_image(VkDevice device, const VkImageCreateInfo& info, VkMemoryRequirements* out) {
+    if (!enabled_ || info.pNext || (info.flags & VK_IMAGE_CREATE_DISJOINT_BIT)) {
+        return false;
+    }
+    const std::string key = image_key(device, info);
+    bool found = false;
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = images_.find(key);
+        if (it != images_.end()) {
+            *out = it->second;
+            found = true;
+            ++stats_.hits;
+        } else {
+            ++stats_.misses;
+        }
+        count_lookup_locked(&log);
+    }
+    if (log) {
+        log_stats();
+    }
+    return found;
+}
+
+void MemoryRequirementsCache::store_image(VkDevice device,
+                                          const VkImageCreateInfo& info,
+                                          const VkMemoryRequirements& requirements) {
+    if (!enabled_ || info.pNext || (info.flags & VK_IMAGE_CREATE_DISJOINT_BIT) || requirements.size == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_.emplace(image_key(device, info), requirements);
+}
+
+void MemoryRequirementsCache::remove_device(VkDevice device) {
+    std::string prefix;
+    append(&prefix, device);
+    std::lock_guard<std::mutex> lock(mutex_);
+    erase_device(&buffers_, prefix);
+    erase_device(&images_, prefix);
+}
+
+MemoryRequirementsCacheStats MemoryRequirementsCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MemoryRequirementsCache::log_stats() const {
+    const MemoryRequirementsCacheStats snapshot = stats();
+    VP_LOG_STREAM_INFO(CLIENT) << "[MemoryRequirements] hits=" << snapshot.hits
+                               << " misses=" << snapshot.misses
+                               << " prefilled=" << snapshot.prefilled;
+}
+
+} // namespace venus_plus
@@ -0,0 +1,63 @@
+#ifndef VENUS_PLUS_MEMORY_REQUIREMENTS_CACHE_H
+#define VENUS_PLUS_MEMORY_REQUIREMENTS_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace venus_plus {
+
+struct MemoryRequirementsCacheStats {
+    uint64_t hits = 0;       // answered from an identical description
+    uint64_t misses = 0;     // queries sent to the server
+    uint64_t prefilled = 0;  // answers fetched when the device was created
+};
+
+// Memory requirements by create info, so a buffer or image described like an
+// earlier one does not need a round trip. Only create infos without a pNext
+// chain are cached, and no disjoint images. Images match on every create-info
+// field, buffers on flags, usage and size. Sizes are never extrapolated: a
+// driver may pad some sizes beyond align(size, alignment).
+// Tunables: VENUS_MEMORY_REQUIREMENTS_CACHE=off,
+// VENUS_MEMORY_REQUIREMENTS_STATS=<every N lookups>.
+class MemoryRequirementsCache {
+public:
+    MemoryRequirementsCache();
+
+    bool enabled() const { return enabled_; }
+
+    bool find_buffer(VkDevice device, const VkBufferCreateInfo& info, VkMemoryRequirements* out);
+    void store_buffer(VkDevice device,
+                      const VkBufferCreateInfo& info,
+                      const VkMemoryRequirements& requirements,
+                      bool prefill = false);
+    bool find_image(VkDevice device, const VkImageCreateInfo& info, VkMemoryRequirements* out);
+    void store_image(VkDevice device, const VkImageCreateInfo& info, const VkMemoryRequirements& requirements);
+
+    void remove_device(VkDevice device);
+
+    MemoryRequirementsCacheStats stats() const;
+    void log_stats() const;
+
+private:
+    static std::string buffer_key(VkDevice device, const VkBufferCreateInfo& info);
+    static std::string image_key(VkDevice device, const VkImageCreateInfo& info);
+    void count_lookup_locked(bool* log);
+
+    bool enabled_ = true;
+    uint32_t stats_interval_ = 0;
+
+    mutable std::mutex mutex_;
+    // Keys start with the device handle, so remove_device can find them.
+    std::unordered_map<std::string, VkMemoryRequirements> buffers_;
+    std::unordered_map<std::string, VkMemoryRequirements> images_;
+    MemoryRequirementsCacheStats stats_;
+};
+
+extern MemoryRequirementsCache g_memory_requirements_cache;
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_MEMORY_REQUIREMENTS_CACHE_H
@@ -0,0 +1,129 @@
+#include "state/memory_type_map.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace venus_plus {
+
+MemoryTypeMap g_memory_type_map;
+
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+} // namespace
+
+MemoryTypeMap::MemoryTypeMap() {
+    enabled_ = !env_disabled("VENUS_DEVICE_LOCAL_MAPPING");
+}
+
+void MemoryTypeMap::build(bool stage, VkPhysicalDeviceMemoryProperties* properties, Layout* layout) {
+    const uint32_t server_count = properties->memoryTypeCount;
+    layout->count = server_count;
+    layout->staged_bits = 0;
+    for (uint32_t i = 0; i < server_count; ++i) {
+        layout->server_index[i] = i;
+    }
+    if (!stage) {
+        return;
+    }
+
+    const VkMemoryPropertyFlags excluded = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                           VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT |
+                                           VK_MEMORY_PROPERTY_PROTECTED_BIT;
+    VkMemoryType* types = properties->memoryTypes;
+    for (uint32_t server = 0; server < server_count && layout->count < VK_MAX_MEMORY_TYPES; ++server) {
+        // Server types keep their order among the reported ones, so this
+        // finds the original as long as nothing was inserted before it.
+        uint32_t original = 0;
+        while (layout->server_index[original] != server || (layout->staged_bits & (1u << original))) {
+            ++original;
+        }
+        const VkMemoryPropertyFlags flags = types[original].propertyFlags;
+        if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) || (flags & excluded)) {
+            continue;
+        }
+        const VkMemoryPropertyFlags staged =
+            flags | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        // After every type whose flags it includes, the original among them;
+        // types whose flags include it already come after those.
+        uint32_t at = 0;
+        for (uint32_t i = 0; i < layout->count; ++i) {
+            if ((types[i].propertyFlags & ~staged) == 0) {
+                at = i + 1;
+            }
+        }
+        for (uint32_t i = layout->count; i > at; --i) {
+            types[i] = types[i - 1];
+            layout->server_index[i] = layout->server_index[i - 1];
+        }
+        types[at].propertyFlags = staged;
+        types[at].heapIndex = types[original].heapIndex;
+        layout->server_index[at] = server;
+        const uint64_t below = (1ull << at) - 1;
+        const uint64_t bits = layout->staged_bits;
+        layout->staged_bits = static_cast<uint32_t>((bits & below) | ((bits & ~below) << 1) | (1ull << at));
+        ++layout->count;
+    }
+    properties->memoryTypeCount = layout->count;
+}
+
+void MemoryTypeMap::report(VkPhysicalDevice physical_device, VkPhysicalDeviceMemoryProperties* properties) {
+    Layout layout;
+    build(enabled_, properties, &layout);
+    std::lock_guard<std::mutex> lock(mutex_);
+    layouts_[physical_device] = layout;
+}
+
+bool MemoryTypeMap::known(VkPhysicalDevice physical_device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return layouts_.count(physical_device) != 0;
+}
+
+bool MemoryTypeMap::stages(VkPhysicalDevice physical_device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layouts_.find(physical_device);
+    return it != layouts_.end() && it->second.staged_bits != 0;
+}
+
+bool MemoryTypeMap::staged(VkPhysicalDevice physical_device, uint32_t reported_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layouts_.find(physical_device);
+    return it != layouts_.end() && reported_index < it->second.count &&
+           (it->second.staged_bits & (1u << reported_index));
+}
+
+uint32_t MemoryTypeMap::reported_bits(VkPhysicalDevice physical_device, uint32_t server_bits, bool stageable) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layouts_.find(physical_device);
+    if (it == layouts_.end()) {
+        return server_bits;
+    }
+    const Layout& layout = it->second;
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < layout.count; ++i) {
+        if ((server_bits & (1u << layout.server_index[i])) && (stageable || !(layout.staged_bits & (1u << i)))) {
+            bits |= 1u << i;
+        }
+    }
+    return bits;
+}
+
+uint32_t MemoryTypeMap::server_index(VkPhysicalDevice physical_device, uint32_t reported_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layouts_.find(physical_device);
+    if (it == layouts_.end() || reported_index >= it->second.count) {
+        return reported_index;
+    }
+    return it->second.server_index[reported_index];
+}
+
+} // namespace venus_plus
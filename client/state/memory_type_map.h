@@ -0,0 +1,61 @@
+#ifndef VENUS_PLUS_MEMORY_TYPE_MAP_H
+#define VENUS_PLUS_MEMORY_TYPE_MAP_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace venus_plus {
+
+// The memory types the ICD reports and the server's types behind them.
+//
+// Mapped memory is a client-side shadow copy either way, and the server
+// stages transfers into memory the host cannot reach
+// (server/memory/staging_transfer.h), so each device-local type without host
+// access is also offered as a HOST_VISIBLE | HOST_COHERENT copy of itself.
+// The copies are inserted after every type whose flags they include, which
+// keeps the order the specification requires, and the other types keep their
+// flags. Memory type bits and indices are translated at the ICD boundary.
+// Only stageable resources are offered the copies: the server reaches memory
+// through a buffer bound over it, or through the dedicated buffer itself,
+// which then needs transfer usage. Images never are.
+// VENUS_DEVICE_LOCAL_MAPPING=off reports the server's types unchanged.
+class MemoryTypeMap {
+public:
+    MemoryTypeMap();
+
+    bool enabled() const { return enabled_; }
+
+    // |properties| holds the server's types on entry and the reported ones
+    // on return.
+    void report(VkPhysicalDevice physical_device, VkPhysicalDeviceMemoryProperties* properties);
+    bool known(VkPhysicalDevice physical_device) const;
+    // True when the device reports staged copies at all.
+    bool stages(VkPhysicalDevice physical_device) const;
+    bool staged(VkPhysicalDevice physical_device, uint32_t reported_index) const;
+
+    uint32_t reported_bits(VkPhysicalDevice physical_device, uint32_t server_bits, bool stageable) const;
+    // Out-of-range indices are passed through for the server to refuse.
+    uint32_t server_index(VkPhysicalDevice physical_device, uint32_t reported_index) const;
+
+private:
+    struct Layout {
+        uint32_t count = 0;
+        uint32_t server_index[VK_MAX_MEMORY_TYPES] = {}; // by reported index
+        uint32_t staged_bits = 0;                        // reported types that are copies
+    };
+
+    static void build(bool stage, VkPhysicalDeviceMemoryProperties* properties, Layout* layout);
+
+    bool enabled_ = true;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<VkPhysicalDevice, Layout> layouts_;
+};
+
+extern MemoryTypeMap g_memory_type_map;
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_MEMORY_TYPE_MAP_H
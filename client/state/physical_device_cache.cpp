@@ -0,0 +1,232 @@
+#include "state/physical_device_cache.h"
+
+#include "utils/logging.h"
+#include "utils/sha256.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace venus_plus {
+
+PhysicalDeviceCache g_physical_device_cache;
+
+namespace {
+
+constexpr uint32_t kFileMagic = 0x43445056u; // "VPDC"
+constexpr uint32_t kFileVersion = 1;
+// Command type and flags precede the physical device handle.
+constexpr size_t kHandleOffset = 2 * sizeof(uint32_t);
+constexpr size_t kCheckSize = 8;
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+std::string default_directory() {
+    const char* value = std::getenv("VENUS_CAPS_CACHE_DIR");
+    if (value) {
+        return value;
+    }
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) {
+        return std::string(xdg) + "/venus-plus";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.cache/venus-plus";
+    }
+    return std::string();
+}
+
+// mkdir -p, for the default directory under ~/.cache.
+bool make_directories(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        const std::string prefix = pos == std::string::npos ? path : path.substr(0, pos);
+        if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (pos == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+// Each record carries the first bytes of the SHA-256 of its key and reply.
+void record_check(const std::string& key, const std::vector<uint8_t>& reply, uint8_t check[kCheckSize]) {
+    std::vector<uint8_t> bytes(key.begin(), key.end());
+    bytes.insert(bytes.end(), reply.begin(), reply.end());
+    const Sha256Digest digest = sha256(bytes.data(), bytes.size());
+    std::memcpy(check, digest.data(), kCheckSize);
+}
+
+} // namespace
+
+PhysicalDeviceCache::PhysicalDeviceCache() {
+    enabled_ = !env_disabled("VENUS_CAPS_CACHE");
+    directory_ = enabled_ ? default_directory() : std::string();
+    if (!directory_.empty() && !make_directories(directory_)) {
+        VP_LOG_STREAM_ERROR(CLIENT) << "[CapsCache] Cannot create " << directory_ << ": "
+                                    << std::strerror(errno) << "; keeping replies in memory only";
+        directory_.clear();
+    }
+}
+
+std::string PhysicalDeviceCache::key(const std::vector<uint8_t>& command) {
+    std::string result(command.begin(), command.end());
+    if (result.size() >= kHandleOffset + sizeof(uint64_t)) {
+        std::memset(&result[kHandleOffset], 0, sizeof(uint64_t));
+    }
+    return result;
+}
+
+bool PhysicalDeviceCache::has_device(VkPhysicalDevice remote_device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_.count(reinterpret_cast<uint64_t>(remote_device)) != 0;
+}
+
+void PhysicalDeviceCache::add_device(VkPhysicalDevice remote_device, const std::vector<uint8_t>& identity) {
+    if (!enabled_) {
+        return;
+    }
+    std::unique_ptr<Device> device(new Device());
+    if (!directory_.empty()) {
+        const Sha256Digest digest = sha256(identity.data(), identity.size());
+        device->path = directory_ + "/caps-" + sha256_hex(digest).substr(0, 32) + ".bin";
+        load_file(device.get());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    devices_[reinterpret_cast<uint64_t>(remote_device)] = std::move(device);
+}
+
+bool PhysicalDeviceCache::find_reply(VkPhysicalDevice remote_device,
+                                     const std::vector<uint8_t>& command,
+                                     std::vector<uint8_t>* reply) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto device_it = devices_.find(reinterpret_cast<uint64_t>(remote_device));
+    if (device_it == devices_.end()) {
+        return false;
+    }
+    auto it = device_it->second->replies.find(key(command));
+    if (it == device_it->second->replies.end()) {
+        ++stats_.misses;
+        return false;
+    }
+    ++stats_.hits;
+    *reply = it->second;
+    return true;
+}
+
+void PhysicalDeviceCache::store_reply(VkPhysicalDevice remote_device,
+                                      const std::vector<uint8_t>& command,
+                                      const std::vector<uint8_t>& reply,
+                                      bool persist) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto device_it = devices_.find(reinterpret_cast<uint64_t>(remote_device));
+    if (device_it == devices_.end()) {
+        return;
+    }
+    Device& device = *device_it->second;
+    const std::string command_key = key(command);
+    if (!device.replies.emplace(command_key, reply).second) {
+        return;
+    }
+    if (persist) {
+        append_file(device, command_key, reply);
+    } else {
+        ++stats_.prefetched;
+    }
+}
+
+void PhysicalDeviceCache::load_file(Device* device) {
+    FILE* file = std::fopen(device->path.c_str(), "rb");
+    if (!file) {
+        return;
+    }
+    uint32_t header[2] = {};
+    if (std::fread(header, sizeof(header), 1, file) != 1 || header[0] != kFileMagic ||
+        header[1] != kFileVersion) {
+        std::fclose(file);
+        VP_LOG_STREAM_ERROR(CLIENT) << "[CapsCache] Ignoring foreign " << device->path;
+        return;
+    }
+    // Records are appended by concurrent processes; stop at the first one
+    // that is cut short or damaged.
+    uint64_t loaded = 0;
+    for (;;) {
+        uint32_t sizes[2] = {};
+        uint8_t check[kCheckSize] = {};
+        if (std::fread(sizes, sizeof(sizes), 1, file) != 1 || std::fread(check, kCheckSize, 1, file) != 1 ||
+            sizes[0] > (1u << 20) || sizes[1] > (1u << 20)) {
+            break;
+        }
+        std::string record_key(sizes[0], '\0');
+        std::vector<uint8_t> reply(sizes[1]);
+        if ((sizes[0] && std::fread(&record_key[0], sizes[0], 1, file) != 1) ||
+            (sizes[1] && std::fread(reply.data(), sizes[1], 1, file) != 1)) {
+            break;
+        }
+        uint8_t expected[kCheckSize] = {};
+        record_check(record_key, reply, expected);
+        if (std::memcmp(check, expected, kCheckSize) != 0) {
+            break;
+        }
+        if (device->replies.emplace(std::move(record_key), std::move(reply)).second) {
+            ++loaded;
+        }
+    }
+    std::fclose(file);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.loaded += loaded;
+}
+
+void PhysicalDeviceCache::append_file(const Device& device, const std::string& key, const std::vector<uint8_t>& reply) {
+    if (device.path.empty()) {
+        return;
+    }
+    FILE* file = std::fopen(device.path.c_str(), "ab");
+    if (!file) {
+        return;
+    }
+    // One buffer and one write, so appends from other processes never land
+    // in the middle of a record.
+    std::vector<uint8_t> record;
+    if (std::ftell(file) == 0) {
+        const uint32_t header[2] = {kFileMagic, kFileVersion};
+        record.insert(record.end(), reinterpret_cast<const uint8_t*>(header),
+                      reinterpret_cast<const uint8_t*>(header) + sizeof(header));
+    }
+    const uint32_t sizes[2] = {static_cast<uint32_t>(key.size()), static_cast<uint32_t>(reply.size())};
+    uint8_t check[kCheckSize] = {};
+    record_check(key, reply, check);
+    record.insert(record.end(), reinterpret_cast<const uint8_t*>(sizes),
+                  reinterpret_cast<const uint8_t*>(sizes) + sizeof(sizes));
+    record.insert(record.end(), check, check + kCheckSize);
+    record.insert(record.end(), key.begin(), key.end());
+    record.insert(record.end(), reply.begin(), reply.end());
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size()) {
+        VP_LOG_STREAM_ERROR(CLIENT) << "[CapsCache] Failed to write " << device.path;
+    }
+    std::fclose(file);
+}
+
+PhysicalDeviceCacheStats PhysicalDeviceCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PhysicalDeviceCache::log_stats() const {
+    const PhysicalDeviceCacheStats snapshot = stats();
+    VP_LOG_STREAM_INFO(CLIENT) << "[CapsCache] prefetched=" << snapshot.prefetched
+                               << " loaded=" << snapshot.loaded
+                               << " hits=" << snapshot.hits
+                               << " misses=" << snapshot.misses;
+}
+
+} // namespace venus_plus
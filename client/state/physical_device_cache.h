@@ -0,0 +1,74 @@
+#ifndef VENUS_PLUS_PHYSICAL_DEVICE_CACHE_H
+#define VENUS_PLUS_PHYSICAL_DEVICE_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+struct PhysicalDeviceCacheStats {
+    uint64_t prefetched = 0; // replies fetched in the enumeration batch
+    uint64_t loaded = 0;     // replies read from cache files
+    uint64_t hits = 0;       // queries answered locally
+    uint64_t misses = 0;     // queries sent to the server
+};
+
+// Server replies to physical-device queries (properties, features, format
+// and image format properties, queue families, extensions), per remote
+// physical device. Enumeration fetches the common ones in one batch; any
+// other query goes to the server once and its reply is kept. Those replies are
+// also appended to a file named after a hash of the device's identity (the
+// client and server versions and the enumeration batch's replies), so later
+// runs against the same GPU, driver and server answer them locally too. A query is keyed by its encoded command with the device
+// handle blanked, so the same query always finds the same reply.
+// Tunables: VENUS_CAPS_CACHE=off, VENUS_CAPS_CACHE_DIR=<dir> (default
+// $XDG_CACHE_HOME/venus-plus or ~/.cache/venus-plus; empty = memory only).
+class PhysicalDeviceCache {
+public:
+    PhysicalDeviceCache();
+
+    bool enabled() const { return enabled_; }
+    bool has_device(VkPhysicalDevice remote_device) const;
+
+    // Starts caching for |remote_device|, identified by |identity|, and loads
+    // what earlier runs saved for that identity.
+    void add_device(VkPhysicalDevice remote_device, const std::vector<uint8_t>& identity);
+    bool find_reply(VkPhysicalDevice remote_device, const std::vector<uint8_t>& command, std::vector<uint8_t>* reply);
+    // |persist| also saves the reply to the device's file.
+    void store_reply(VkPhysicalDevice remote_device,
+                     const std::vector<uint8_t>& command,
+                     const std::vector<uint8_t>& reply,
+                     bool persist);
+
+    PhysicalDeviceCacheStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Device {
+        std::string path;
+        std::unordered_map<std::string, std::vector<uint8_t>> replies;
+    };
+
+    static std::string key(const std::vector<uint8_t>& command);
+    void load_file(Device* device);
+    void append_file(const Device& device, const std::string& key, const std::vector<uint8_t>& reply);
+
+    bool enabled_ = true;
+    std::string directory_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::unique_ptr<Device>> devices_;
+    PhysicalDeviceCacheStats stats_;
+};
+
+extern PhysicalDeviceCache g_physical_device_cache;
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_PHYSICAL_DEVICE_CACHE_H
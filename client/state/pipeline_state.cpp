@@ -1,11 +1,73 @@
 #include "pipeline_state.h"
 
+#include "protocol/client_handles.h"
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 namespace venus_plus {
 
 PipelineState g_pipeline_state;
 
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t descriptor_count(const std::vector<VkDescriptorPoolSize>& sizes, VkDescriptorType type) {
+    for (const VkDescriptorPoolSize& size : sizes) {
+        if (size.type == type) {
+            return size.descriptorCount;
+        }
+    }
+    return 0;
+}
+
+void add_descriptor_count(std::vector<VkDescriptorPoolSize>* sizes, const VkDescriptorPoolSize& count) {
+    auto it = std::find_if(sizes->begin(), sizes->end(), [&](const VkDescriptorPoolSize& size) {
+        return size.type == count.type;
+    });
+    if (it != sizes->end()) {
+        it->descriptorCount += count.descriptorCount;
+    } else {
+        sizes->push_back(count);
+    }
+}
+
+void add_descriptor_counts(std::vector<VkDescriptorPoolSize>* sizes,
+                           const std::vector<VkDescriptorPoolSize>& counts) {
+    for (const VkDescriptorPoolSize& count : counts) {
+        add_descriptor_count(sizes, count);
+    }
+}
+
+bool contains_binding(const ImmutableSamplerBindings& bindings, uint32_t binding) {
+    return bindings && std::binary_search(bindings->begin(), bindings->end(), binding);
+}
+
+void release_descriptor_counts(std::vector<VkDescriptorPoolSize>* sizes,
+                               const std::vector<VkDescriptorPoolSize>& counts) {
+    for (const VkDescriptorPoolSize& count : counts) {
+        for (VkDescriptorPoolSize& size : *sizes) {
+            if (size.type == count.type) {
+                size.descriptorCount -= std::min(size.descriptorCount, count.descriptorCount);
+            }
+        }
+    }
+}
+
+} // namespace
+
+PipelineState::PipelineState() {
+    local_descriptor_sets_ = !env_disabled("VENUS_LOCAL_DESCRIPTOR_SETS");
+}
+
 void PipelineState::add_shader_module(VkDevice device,
                                       VkShaderModule local,
                                       VkShaderModule remote,
@@ -34,12 +96,35 @@ VkShaderModule PipelineState::get_remote_shader_module(VkShaderModule module) co
 
 void PipelineState::add_descriptor_set_layout(VkDevice device,
                                               VkDescriptorSetLayout local,
-                                              VkDescriptorSetLayout remote) {
-    std::lock_guard<std::mutex> lock(mutex_);
+                                              VkDescriptorSetLayout remote,
+                                              const VkDescriptorSetLayoutCreateInfo& create_info) {
     DescriptorSetLayoutInfo info = {};
     info.device = device;
     info.remote_handle = remote;
-    descriptor_set_layouts_[handle_key(local)] = info;
+    info.cost_known = create_info.pNext == nullptr;
+    for (uint32_t i = 0; info.cost_known && i < create_info.bindingCount; ++i) {
+        const VkDescriptorSetLayoutBinding& binding = create_info.pBindings[i];
+        if (binding.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+            info.cost_known = false;
+        } else if (binding.descriptorCount > 0) {
+            add_descriptor_count(&info.cost, VkDescriptorPoolSize{binding.descriptorType, binding.descriptorCount});
+        }
+    }
+    std::vector<uint32_t> immutable_bindings;
+    for (uint32_t i = 0; i < create_info.bindingCount; ++i) {
+        const VkDescriptorSetLayoutBinding& binding = create_info.pBindings[i];
+        if ((binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+             binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) &&
+            binding.descriptorCount > 0 && binding.pImmutableSamplers) {
+            immutable_bindings.push_back(binding.binding);
+        }
+    }
+    if (!immutable_bindings.empty()) {
+        std::sort(immutable_bindings.begin(), immutable_bindings.end());
+        info.immutable_sampler_bindings = std::make_shared<const std::vector<uint32_t>>(std::move(immutable_bindings));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    descriptor_set_layouts_[handle_key(local)] = std::move(info);
 }
 
 void PipelineState::remove_descriptor_set_layout(VkDescriptorSetLayout layout) {
@@ -59,13 +144,19 @@ VkDescriptorSetLayout PipelineState::get_remote_descriptor_set_layout(VkDescript
 void PipelineState::add_descriptor_pool(VkDevice device,
                                         VkDescriptorPool local,
                                         VkDescriptorPool remote,
-                                        VkDescriptorPoolCreateFlags flags) {
-    std::lock_guard<std::mutex> lock(mutex_);
+                                        const VkDescriptorPoolCreateInfo& create_info) {
     DescriptorPoolInfo info = {};
     info.device = device;
     info.remote_handle = remote;
-    info.flags = flags;
-    descriptor_pools_[handle_key(local)] = info;
+    info.flags = create_info.flags;
+    info.chained = create_info.pNext != nullptr;
+    info.budget_known = !info.chained;
+    info.max_sets = create_info.maxSets;
+    for (uint32_t i = 0; i < create_info.poolSizeCount; ++i) {
+        add_descriptor_count(&info.capacity, create_info.pPoolSizes[i]);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    descriptor_pools_[handle_key(local)] = std::move(info);
 }
 
 void PipelineState::remove_descriptor_pool(VkDescriptorPool pool) {
@@ -75,7 +166,11 @@ void PipelineState::remove_descriptor_pool(VkDescriptorPool pool) {
         return;
     }
     for (VkDescriptorSet set : it->second.descriptor_sets) {
-        descriptor_sets_.erase(handle_key(set));
+        auto sit = descriptor_sets_.find(handle_key(set));
+        if (sit != descriptor_sets_.end()) {
+            release_client_descriptor_set_locked(sit->second.remote_handle);
+            descriptor_sets_.erase(sit);
+        }
     }
     descriptor_pools_.erase(it);
 }
@@ -87,9 +182,18 @@ void PipelineState::reset_descriptor_pool(VkDescriptorPool pool) {
         return;
     }
     for (VkDescriptorSet set : it->second.descriptor_sets) {
-        descriptor_sets_.erase(handle_key(set));
+        auto sit = descriptor_sets_.find(handle_key(set));
+        if (sit != descriptor_sets_.end()) {
+            release_client_descriptor_set_locked(sit->second.remote_handle);
+            descriptor_sets_.erase(sit);
+        }
     }
     it->second.descriptor_sets.clear();
+    it->second.budget_known = !it->second.chained;
+    it->second.fragmented = false;
+    it->second.unconfirmed = 0;
+    it->second.used_sets = 0;
+    it->second.used.clear();
 }
 
 VkDescriptorPool PipelineState::get_remote_descriptor_pool(VkDescriptorPool pool) const {
@@ -101,23 +205,106 @@ VkDescriptorPool PipelineState::get_remote_descriptor_pool(VkDescriptorPool pool
     return it->second.remote_handle;
 }
 
+DescriptorAllocation PipelineState::check_descriptor_allocation(const VkDescriptorSetAllocateInfo& info) {
+    if (!local_descriptor_sets_ || info.pNext) {
+        return DescriptorAllocation::kRemote;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pit = descriptor_pools_.find(handle_key(info.descriptorPool));
+    if (pit == descriptor_pools_.end() || !pit->second.budget_known || pit->second.fragmented) {
+        return DescriptorAllocation::kRemote;
+    }
+    DescriptorPoolInfo& pool = pit->second;
+    std::vector<VkDescriptorPoolSize> needed = pool.used;
+    for (uint32_t i = 0; i < info.descriptorSetCount; ++i) {
+        auto lit = descriptor_set_layouts_.find(handle_key(info.pSetLayouts[i]));
+        if (lit == descriptor_set_layouts_.end() || !lit->second.cost_known) {
+            return DescriptorAllocation::kRemote;
+        }
+        add_descriptor_counts(&needed, lit->second.cost);
+    }
+    if (pool.used_sets + info.descriptorSetCount > pool.max_sets) {
+        return DescriptorAllocation::kOutOfPoolMemory;
+    }
+    for (const VkDescriptorPoolSize& size : needed) {
+        if (size.descriptorCount > descriptor_count(pool.capacity, size.type)) {
+            return DescriptorAllocation::kOutOfPoolMemory;
+        }
+    }
+    const size_t fresh = info.descriptorSetCount -
+                         std::min<size_t>(info.descriptorSetCount, free_client_descriptor_sets_.size());
+    if (client_descriptor_set_generations_.size() + fresh > kClientHandleMaxIndex) {
+        return DescriptorAllocation::kRemote;
+    }
+    if (pool.unconfirmed >= kDescriptorAllocationConfirmInterval) {
+        pool.unconfirmed = 0;
+        return DescriptorAllocation::kRemote;
+    }
+    ++pool.unconfirmed;
+    return DescriptorAllocation::kLocal;
+}
+
+VkDescriptorSet PipelineState::next_client_descriptor_set() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t index = 0;
+    if (!free_client_descriptor_sets_.empty()) {
+        index = free_client_descriptor_sets_.back();
+        free_client_descriptor_sets_.pop_back();
+        client_descriptor_set_generations_[index] =
+            (client_descriptor_set_generations_[index] + 1) & kClientHandleMaxGeneration;
+    } else {
+        index = static_cast<uint32_t>(client_descriptor_set_generations_.size());
+        client_descriptor_set_generations_.push_back(0);
+    }
+    return reinterpret_cast<VkDescriptorSet>(make_client_handle(
+        client_handle_tag::kDescriptorSet, client_descriptor_set_generations_[index], index));
+}
+
+void PipelineState::distrust_descriptor_budget(VkDescriptorPool pool) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_pools_.find(handle_key(pool));
+    if (it != descriptor_pools_.end()) {
+        it->second.budget_known = false;
+    }
+}
+
+void PipelineState::release_client_descriptor_set_locked(VkDescriptorSet remote) {
+    const uint64_t handle = handle_key(remote);
+    if (is_client_handle(handle, client_handle_tag::kDescriptorSet)) {
+        free_client_descriptor_sets_.push_back(client_handle_index(handle));
+    }
+}
+
 void PipelineState::add_descriptor_set(VkDevice device,
                                        VkDescriptorPool pool,
                                        VkDescriptorSetLayout layout,
                                        VkDescriptorSet local,
-                                       VkDescriptorSet remote) {
+                                       VkDescriptorSet remote,
+                                       bool variable_counts) {
     std::lock_guard<std::mutex> lock(mutex_);
     DescriptorSetInfo info = {};
     info.device = device;
     info.remote_handle = remote;
     info.parent_pool = pool;
     info.layout = layout;
-    descriptor_sets_[handle_key(local)] = info;
+    info.immutable_sampler_bindings = immutable_sampler_bindings_locked(layout);
+    info.version = next_descriptor_set_version_++;
 
     auto pit = descriptor_pools_.find(handle_key(pool));
     if (pit != descriptor_pools_.end()) {
-        pit->second.descriptor_sets.push_back(local);
+        DescriptorPoolInfo& pool_info = pit->second;
+        pool_info.descriptor_sets.push_back(local);
+        auto lit = descriptor_set_layouts_.find(handle_key(layout));
+        if (!variable_counts && lit != descriptor_set_layouts_.end() && lit->second.cost_known) {
+            info.charged = true;
+            info.cost = lit->second.cost;
+            ++pool_info.used_sets;
+            add_descriptor_counts(&pool_info.used, info.cost);
+        } else {
+            pool_info.budget_known = false;
+        }
     }
+    descriptor_sets_[handle_key(local)] = std::move(info);
 }
 
 void PipelineState::remove_descriptor_set(VkDescriptorSet set) {
@@ -129,9 +316,16 @@ void PipelineState::remove_descriptor_set(VkDescriptorSet set) {
     VkDescriptorPool pool = it->second.parent_pool;
     auto pit = descriptor_pools_.find(handle_key(pool));
     if (pit != descriptor_pools_.end()) {
-        auto& vec = pit->second.descriptor_sets;
+        DescriptorPoolInfo& pool_info = pit->second;
+        auto& vec = pool_info.descriptor_sets;
         vec.erase(std::remove(vec.begin(), vec.end(), set), vec.end());
+        if (it->second.charged) {
+            pool_info.used_sets -= std::min(pool_info.used_sets, 1u);
+            release_descriptor_counts(&pool_info.used, it->second.cost);
+        }
+        pool_info.fragmented = true;
     }
+    release_client_descriptor_set_locked(it->second.remote_handle);
     descriptor_sets_.erase(it);
 }
 
@@ -153,6 +347,85 @@ VkDescriptorPool PipelineState::get_descriptor_set_pool(VkDescriptorSet set) con
     return it->second.parent_pool;
 }
 
+void PipelineState::mark_descriptor_set_updated(VkDescriptorSet set) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_sets_.find(handle_key(set));
+    if (it != descriptor_sets_.end()) {
+        it->second.version = next_descriptor_set_version_++;
+    }
+}
+
+uint64_t PipelineState::get_descriptor_set_version(VkDescriptorSet set) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_sets_.find(handle_key(set));
+    return it != descriptor_sets_.end() ? it->second.version : 0;
+}
+
+bool PipelineState::has_immutable_samplers(VkDescriptorSet set, uint32_t binding) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_sets_.find(handle_key(set));
+    return it != descriptor_sets_.end() && contains_binding(it->second.immutable_sampler_bindings, binding);
+}
+
+bool PipelineState::has_immutable_samplers(VkPipelineLayout layout, uint32_t set_index, uint32_t binding) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return contains_binding(push_immutable_sampler_bindings_locked(layout, set_index), binding);
+}
+
+ImmutableSamplerBindings PipelineState::immutable_sampler_bindings_locked(VkDescriptorSetLayout layout) const {
+    auto it = descriptor_set_layouts_.find(handle_key(layout));
+    return it != descriptor_set_layouts_.end() ? it->second.immutable_sampler_bindings : nullptr;
+}
+
+ImmutableSamplerBindings PipelineState::push_immutable_sampler_bindings_locked(VkPipelineLayout layout,
+                                                                               uint32_t set_index) const {
+    auto it = pipeline_layouts_.find(handle_key(layout));
+    if (it == pipeline_layouts_.end() || set_index >= it->second.set_immutable_sampler_bindings.size()) {
+        return nullptr;
+    }
+    return it->second.set_immutable_sampler_bindings[set_index];
+}
+
+void PipelineState::add_descriptor_update_template(VkDevice device,
+                                                   VkDescriptorUpdateTemplate local,
+                                                   VkDescriptorUpdateTemplate remote,
+                                                   const VkDescriptorUpdateTemplateCreateInfo& info,
+                                                   std::vector<VkDescriptorUpdateTemplateEntry> packed_entries,
+                                                   size_t packed_size) {
+    auto template_info = std::make_shared<DescriptorUpdateTemplateInfo>();
+    template_info->device = device;
+    template_info->remote_handle = remote;
+    if (info.templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR) {
+        template_info->bind_point = info.pipelineBindPoint;
+    }
+    template_info->entries.assign(info.pDescriptorUpdateEntries,
+                                  info.pDescriptorUpdateEntries + info.descriptorUpdateEntryCount);
+    template_info->packed_entries = std::move(packed_entries);
+    template_info->packed_size = packed_size;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const ImmutableSamplerBindings bindings =
+        info.templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR
+            ? push_immutable_sampler_bindings_locked(info.pipelineLayout, info.set)
+            : immutable_sampler_bindings_locked(info.descriptorSetLayout);
+    for (const VkDescriptorUpdateTemplateEntry& entry : template_info->entries) {
+        template_info->immutable_samplers.push_back(entry.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER &&
+                                                    contains_binding(bindings, entry.dstBinding));
+    }
+    descriptor_update_templates_[handle_key(local)] = std::move(template_info);
+}
+
+void PipelineState::remove_descriptor_update_template(VkDescriptorUpdateTemplate update_template) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    descriptor_update_templates_.erase(handle_key(update_template));
+}
+
+std::shared_ptr<const DescriptorUpdateTemplateInfo> PipelineState::get_descriptor_update_template(
+    VkDescriptorUpdateTemplate update_template) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_update_templates_.find(handle_key(update_template));
+    return it != descriptor_update_templates_.end() ? it->second : nullptr;
+}
+
 void PipelineState::add_pipeline_layout(VkDevice device,
                                         VkPipelineLayout local,
                                         VkPipelineLayout remote,
@@ -166,7 +439,13 @@ void PipelineState::add_pipeline_layout(VkDevice device,
                                                 create_info->pPushConstantRanges +
                                                     create_info->pushConstantRangeCount);
     }
-    pipeline_layouts_[handle_key(local)] = layout_info;
+    if (create_info && create_info->pSetLayouts) {
+        for (uint32_t i = 0; i < create_info->setLayoutCount; ++i) {
+            layout_info.set_immutable_sampler_bindings.push_back(
+                immutable_sampler_bindings_locked(create_info->pSetLayouts[i]));
+        }
+    }
+    pipeline_layouts_[handle_key(local)] = std::move(layout_info);
 }
 
 void PipelineState::remove_pipeline_layout(VkPipelineLayout layout) {
@@ -296,6 +575,7 @@ void PipelineState::remove_device_resources(VkDevice device) {
                                       reinterpret_cast<VkDescriptorSet>(it->first)),
                           vec.end());
             }
+            release_client_descriptor_set_locked(it->second.remote_handle);
             it = descriptor_sets_.erase(it);
         } else {
             ++it;
@@ -305,7 +585,11 @@ void PipelineState::remove_device_resources(VkDevice device) {
     for (auto it = descriptor_pools_.begin(); it != descriptor_pools_.end();) {
         if (it->second.device == device) {
             for (VkDescriptorSet set : it->second.descriptor_sets) {
-                descriptor_sets_.erase(handle_key(set));
+                auto sit = descriptor_sets_.find(handle_key(set));
+                if (sit != descriptor_sets_.end()) {
+                    release_client_descriptor_set_locked(sit->second.remote_handle);
+                    descriptor_sets_.erase(sit);
+                }
             }
             it = descriptor_pools_.erase(it);
         } else {
@@ -321,6 +605,14 @@ void PipelineState::remove_device_resources(VkDevice device) {
         }
     }
 
+    for (auto it = descriptor_update_templates_.begin(); it != descriptor_update_templates_.end();) {
+        if (it->second->device == device) {
+            it = descriptor_update_templates_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     for (auto it = pipeline_layouts_.begin(); it != pipeline_layouts_.end();) {
         if (it->second.device == device) {
             it = pipeline_layouts_.erase(it);
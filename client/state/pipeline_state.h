@@ -2,6 +2,7 @@
 #define VENUS_PLUS_PIPELINE_STATE_H
 
 #include <vulkan/vulkan.h>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -14,9 +15,19 @@ struct ShaderModuleInfo {
     size_t code_size = 0;
 };
 
+// Sorted binding numbers of a set layout whose samplers are immutable; null
+// when it has none. Shared with the sets and pipeline layouts made from the
+// layout, which may outlive it.
+using ImmutableSamplerBindings = std::shared_ptr<const std::vector<uint32_t>>;
+
 struct DescriptorSetLayoutInfo {
     VkDevice device = VK_NULL_HANDLE;
     VkDescriptorSetLayout remote_handle = VK_NULL_HANDLE;
+    ImmutableSamplerBindings immutable_sampler_bindings;
+    // What one set takes from a pool, per type. Not known for layouts with
+    // a pNext chain (binding flags, mutable types) or inline uniform blocks.
+    bool cost_known = false;
+    std::vector<VkDescriptorPoolSize> cost;
 };
 
 struct DescriptorPoolInfo {
@@ -24,6 +35,19 @@ struct DescriptorPoolInfo {
     VkDescriptorPool remote_handle = VK_NULL_HANDLE;
     VkDescriptorPoolCreateFlags flags = 0;
     std::vector<VkDescriptorSet> descriptor_sets;
+    // Capacity and what live sets take of it, for pools created without a
+    // pNext chain. |budget_known| drops when a set of unknown cost is
+    // allocated and comes back on reset; |fragmented| is set by a free, after
+    // which the real pool may refuse an allocation the budget allows.
+    bool chained = false;
+    bool budget_known = false;
+    bool fragmented = false;
+    // Allocations sent without waiting since the last one that waited.
+    uint32_t unconfirmed = 0;
+    uint32_t max_sets = 0;
+    uint32_t used_sets = 0;
+    std::vector<VkDescriptorPoolSize> capacity;
+    std::vector<VkDescriptorPoolSize> used;
 };
 
 struct DescriptorSetInfo {
@@ -31,12 +55,42 @@ struct DescriptorSetInfo {
     VkDescriptorSet remote_handle = VK_NULL_HANDLE;
     VkDescriptorPool parent_pool = VK_NULL_HANDLE;
     VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    ImmutableSamplerBindings immutable_sampler_bindings;
+    uint64_t version = 0; // unique per allocation, bumped by every update
+    bool charged = false;  // |cost| counts against the pool's budget
+    std::vector<VkDescriptorPoolSize> cost;
+};
+
+// How vkAllocateDescriptorSets can be answered.
+enum class DescriptorAllocation {
+    kLocal,           // fits the pool's budget; send with client-issued handles
+    kOutOfPoolMemory, // exceeds the pool's budget
+    kRemote,          // the budget cannot decide, or is due a check; ask the server
+};
+
+// Every this many unanswered allocations from a pool, one waits for the
+// server, which reports any of them that failed (see
+// ResourceTracker::allocate_descriptor_sets).
+constexpr uint32_t kDescriptorAllocationConfirmInterval = 32;
+
+// The server's copy of a template takes the entries' data packed back to
+// back with tight strides, so updates carry no padding or unused fields.
+struct DescriptorUpdateTemplateInfo {
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate remote_handle = VK_NULL_HANDLE;
+    VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_MAX_ENUM; // push templates only
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;        // as the application laid out its data
+    std::vector<VkDescriptorUpdateTemplateEntry> packed_entries; // as the server expects it
+    size_t packed_size = 0;
+    // Per entry: its binding's samplers are immutable, so its data's are ignored.
+    std::vector<bool> immutable_samplers;
 };
 
 struct PipelineLayoutInfo {
     VkDevice device = VK_NULL_HANDLE;
     VkPipelineLayout remote_handle = VK_NULL_HANDLE;
     std::vector<VkPushConstantRange> push_constant_ranges;
+    std::vector<ImmutableSamplerBindings> set_immutable_sampler_bindings; // per set
 };
 
 struct PipelineCacheInfo {
@@ -52,30 +106,68 @@ struct PipelineInfo {
 
 class PipelineState {
 public:
+    PipelineState();
+
     void add_shader_module(VkDevice device, VkShaderModule local, VkShaderModule remote, size_t code_size);
     void remove_shader_module(VkShaderModule module);
     VkShaderModule get_remote_shader_module(VkShaderModule module) const;
 
-    void add_descriptor_set_layout(VkDevice device, VkDescriptorSetLayout local, VkDescriptorSetLayout remote);
+    void add_descriptor_set_layout(VkDevice device,
+                                   VkDescriptorSetLayout local,
+                                   VkDescriptorSetLayout remote,
+                                   const VkDescriptorSetLayoutCreateInfo& info);
     void remove_descriptor_set_layout(VkDescriptorSetLayout layout);
     VkDescriptorSetLayout get_remote_descriptor_set_layout(VkDescriptorSetLayout layout) const;
 
     void add_descriptor_pool(VkDevice device,
                              VkDescriptorPool local,
                              VkDescriptorPool remote,
-                             VkDescriptorPoolCreateFlags flags);
+                             const VkDescriptorPoolCreateInfo& info);
     void remove_descriptor_pool(VkDescriptorPool pool);
     void reset_descriptor_pool(VkDescriptorPool pool);
     VkDescriptorPool get_remote_descriptor_pool(VkDescriptorPool pool) const;
 
+    // Pool budgets are kept so sets can be allocated without a round trip;
+    // VENUS_LOCAL_DESCRIPTOR_SETS=off always asks the server. A kLocal answer
+    // counts as an unanswered allocation.
+    DescriptorAllocation check_descriptor_allocation(const VkDescriptorSetAllocateInfo& info);
+    // Handles of freed sets are reused under a new generation.
+    VkDescriptorSet next_client_descriptor_set();
+    // The server refused an allocation the budget allowed, maybe an earlier
+    // unanswered one: ask it for every allocation until the pool is reset.
+    void distrust_descriptor_budget(VkDescriptorPool pool);
+
+    // |variable_counts|: the allocate info chains counts the layout cost
+    // does not cover, so the set is not charged and the pool's budget is
+    // no longer known.
     void add_descriptor_set(VkDevice device,
                             VkDescriptorPool pool,
                             VkDescriptorSetLayout layout,
                             VkDescriptorSet local,
-                            VkDescriptorSet remote);
+                            VkDescriptorSet remote,
+                            bool variable_counts = false);
     void remove_descriptor_set(VkDescriptorSet set);
     VkDescriptorSet get_remote_descriptor_set(VkDescriptorSet set) const;
     VkDescriptorPool get_descriptor_set_pool(VkDescriptorSet set) const;
+    void mark_descriptor_set_updated(VkDescriptorSet set);
+    // 0 for unknown sets.
+    uint64_t get_descriptor_set_version(VkDescriptorSet set) const;
+    // Whether |binding| of |set|, or of set |set_index| of |layout| for push
+    // descriptors, has immutable samplers: writes to it must ignore theirs,
+    // which may be garbage.
+    bool has_immutable_samplers(VkDescriptorSet set, uint32_t binding) const;
+    bool has_immutable_samplers(VkPipelineLayout layout, uint32_t set_index, uint32_t binding) const;
+
+    void add_descriptor_update_template(VkDevice device,
+                                        VkDescriptorUpdateTemplate local,
+                                        VkDescriptorUpdateTemplate remote,
+                                        const VkDescriptorUpdateTemplateCreateInfo& info,
+                                        std::vector<VkDescriptorUpdateTemplateEntry> packed_entries,
+                                        size_t packed_size);
+    void remove_descriptor_update_template(VkDescriptorUpdateTemplate update_template);
+    // Null for unknown templates.
+    std::shared_ptr<const DescriptorUpdateTemplateInfo> get_descriptor_update_template(
+        VkDescriptorUpdateTemplate update_template) const;
 
     void add_pipeline_layout(VkDevice device,
                              VkPipelineLayout local,
@@ -109,14 +201,25 @@ private:
         return reinterpret_cast<uint64_t>(handle);
     }
 
+    void release_client_descriptor_set_locked(VkDescriptorSet remote);
+    ImmutableSamplerBindings immutable_sampler_bindings_locked(VkDescriptorSetLayout layout) const;
+    ImmutableSamplerBindings push_immutable_sampler_bindings_locked(VkPipelineLayout layout,
+                                                                    uint32_t set_index) const;
+
+    bool local_descriptor_sets_ = true;
+
     mutable std::mutex mutex_;
     std::unordered_map<uint64_t, ShaderModuleInfo> shader_modules_;
     std::unordered_map<uint64_t, DescriptorSetLayoutInfo> descriptor_set_layouts_;
     std::unordered_map<uint64_t, DescriptorPoolInfo> descriptor_pools_;
     std::unordered_map<uint64_t, DescriptorSetInfo> descriptor_sets_;
+    std::unordered_map<uint64_t, std::shared_ptr<const DescriptorUpdateTemplateInfo>> descriptor_update_templates_;
     std::unordered_map<uint64_t, PipelineLayoutInfo> pipeline_layouts_;
     std::unordered_map<uint64_t, PipelineInfo> pipelines_;
     std::unordered_map<uint64_t, PipelineCacheInfo> pipeline_caches_;
+    uint64_t next_descriptor_set_version_ = 1;
+    std::vector<uint32_t> client_descriptor_set_generations_; // by handle index
+    std::vector<uint32_t> free_client_descriptor_sets_;
 };
 
 extern PipelineState g_pipeline_state;
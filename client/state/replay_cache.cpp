@@ -0,0 +1,205 @@
+#include "state/replay_cache.h"
+
+#include "state/pipeline_state.h"
+#include "utils/logging.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace venus_plus {
+
+CommandReplayCache g_replay_cache;
+
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    const int parsed = std::atoi(value);
+    return parsed > 0 ? static_cast<uint32_t>(parsed) : fallback;
+}
+
+// 64-bit multiply/xorshift over 8-byte words; the stream is mostly handles
+// and small integers, so whole-word mixing is both fast and well spread.
+uint64_t hash_stream(const std::vector<uint8_t>& stream) {
+    constexpr uint64_t kMultiplier = 0x9fb21c651e98df25ull;
+    uint64_t hash = 0x6a09e667f3bcc909ull ^ static_cast<uint64_t>(stream.size());
+    const uint8_t* data = stream.data();
+    size_t remaining = stream.size();
+    while (remaining >= sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * kMultiplier;
+        hash ^= hash >> 29;
+        data += sizeof(word);
+        remaining -= sizeof(word);
+    }
+    if (remaining > 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, remaining);
+        hash = (hash ^ word) * kMultiplier;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+} // namespace
+
+CommandReplayCache::CommandReplayCache() {
+    enabled_ = !env_disabled("VENUS_REPLAY_CACHE");
+    stats_interval_ = env_uint("VENUS_REPLAY_STATS", 0);
+}
+
+void CommandReplayCache::begin(VkCommandBuffer command_buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[handle_key(command_buffer)];
+    entry.sets.clear();
+    entry.secondaries.clear();
+    entry.pending.clear();
+}
+
+void CommandReplayCache::note_descriptor_sets(VkCommandBuffer command_buffer,
+                                              uint32_t count,
+                                              const VkDescriptorSet* sets) {
+    if (!enabled_ || count == 0 || !sets) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it != entries_.end()) {
+        it->second.sets.insert(it->second.sets.end(), sets, sets + count);
+    }
+}
+
+void CommandReplayCache::note_secondaries(VkCommandBuffer command_buffer,
+                                          uint32_t count,
+                                          const VkCommandBuffer* secondaries) {
+    if (!enabled_ || count == 0 || !secondaries) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it != entries_.end()) {
+        it->second.secondaries.insert(it->second.secondaries.end(), secondaries, secondaries + count);
+    }
+}
+
+bool CommandReplayCache::can_reuse(VkCommandBuffer command_buffer,
+                                   const std::vector<uint8_t>& stream,
+                                   uint64_t* hash) {
+    const uint64_t stream_hash = hash_stream(stream);
+    if (hash) {
+        *hash = stream_hash;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it == entries_.end()) {
+        return false;
+    }
+    Entry& entry = it->second;
+
+    // Versions are read at end: an update between bind and end still counts.
+    entry.pending.clear();
+    entry.pending.reserve(entry.sets.size() + entry.secondaries.size());
+    for (VkDescriptorSet set : entry.sets) {
+        entry.pending.push_back({handle_key(set), g_pipeline_state.get_descriptor_set_version(set)});
+    }
+    for (VkCommandBuffer secondary : entry.secondaries) {
+        auto sit = entries_.find(handle_key(secondary));
+        const bool current = sit != entries_.end() && sit->second.valid;
+        entry.pending.push_back({handle_key(secondary), current ? sit->second.generation : 0});
+    }
+
+    for (const Dependency& dependency : entry.pending) {
+        if (dependency.version == 0) {
+            return false; // unknown set or a secondary without a server recording
+        }
+    }
+    return entry.valid && entry.hash == stream_hash && entry.dependencies == entry.pending &&
+           entry.stream == stream;
+}
+
+void CommandReplayCache::record_hit(size_t bytes) {
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.hits;
+        stats_.bytes_saved += bytes;
+        ++stats_.recordings;
+        log = stats_interval_ && stats_.recordings % stats_interval_ == 0;
+    }
+    if (log) {
+        log_stats();
+    }
+}
+
+void CommandReplayCache::record_miss(VkCommandBuffer command_buffer, uint64_t hash, std::vector<uint8_t>* stream) {
+    const size_t bytes = stream->size();
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle_key(command_buffer));
+        if (it != entries_.end()) {
+            Entry& entry = it->second;
+            entry.valid = true;
+            entry.hash = hash;
+            entry.stream.swap(*stream);
+            entry.generation = next_generation_++;
+            entry.dependencies.swap(entry.pending);
+            entry.pending.clear();
+        }
+        stream->clear();
+        ++stats_.misses;
+        stats_.bytes_sent += bytes;
+        ++stats_.recordings;
+        log = stats_interval_ && stats_.recordings % stats_interval_ == 0;
+    }
+    if (log) {
+        log_stats();
+    }
+}
+
+void CommandReplayCache::invalidate(VkCommandBuffer command_buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(handle_key(command_buffer));
+    if (it != entries_.end()) {
+        it->second.valid = false;
+        it->second.generation = next_generation_++;
+        it->second.dependencies.clear();
+        it->second.stream.clear();
+    }
+}
+
+void CommandReplayCache::remove(VkCommandBuffer command_buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(handle_key(command_buffer));
+}
+
+CommandReplayStats CommandReplayCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CommandReplayCache::log_stats() const {
+    const CommandReplayStats snapshot = stats();
+    const double hit_rate =
+        snapshot.recordings ? 100.0 * static_cast<double>(snapshot.hits) / snapshot.recordings : 0.0;
+    VP_LOG_STREAM_INFO(CLIENT) << "[Replay] recordings=" << snapshot.recordings
+                               << " hits=" << snapshot.hits << " (" << hit_rate << "%)"
+                               << " misses=" << snapshot.misses
+                               << " bytes_sent=" << snapshot.bytes_sent
+                               << " bytes_saved=" << snapshot.bytes_saved;
+}
+
+} // namespace venus_plus
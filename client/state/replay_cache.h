@@ -0,0 +1,99 @@
+#ifndef VENUS_PLUS_REPLAY_CACHE_H
+#define VENUS_PLUS_REPLAY_CACHE_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+struct CommandReplayStats {
+    uint64_t recordings = 0;  // vkEndCommandBuffer calls seen
+    uint64_t hits = 0;        // replaced by a reuse token
+    uint64_t misses = 0;      // sent in full
+    uint64_t bytes_sent = 0;  // encoded command bytes of the misses
+    uint64_t bytes_saved = 0; // encoded command bytes the hits did not send
+};
+
+// Remembers, per command buffer, the encoded command stream
+// (vkBeginCommandBuffer through the last vkCmd*) the server last recorded and
+// its hash. When a re-recording hashes the same, matches those bytes, and the
+// descriptor sets and secondary command buffers it uses are unchanged, the
+// client sends a reuse token and the server keeps its real command buffer
+// instead of recording it again. The hash alone is not trusted, since a
+// collision would replay the wrong commands.
+// Handles in the stream are remote handles, which the server never reuses, so
+// a destroyed and recreated object always changes the hash.
+// Tunables: VENUS_REPLAY_CACHE=off, VENUS_REPLAY_STATS=<log every N recordings>.
+class CommandReplayCache {
+public:
+    CommandReplayCache();
+
+    bool enabled() const { return enabled_; }
+
+    // Starts tracking a new recording of |command_buffer|.
+    void begin(VkCommandBuffer command_buffer);
+    void note_descriptor_sets(VkCommandBuffer command_buffer, uint32_t count, const VkDescriptorSet* sets);
+    void note_secondaries(VkCommandBuffer command_buffer, uint32_t count, const VkCommandBuffer* secondaries);
+
+    // Hashes |stream| into |hash| and returns true when it and everything the
+    // recording depends on match what the server holds for |command_buffer|,
+    // byte for byte.
+    bool can_reuse(VkCommandBuffer command_buffer, const std::vector<uint8_t>& stream, uint64_t* hash);
+    void record_hit(size_t bytes);
+    // The server now holds the recording that hashed to |hash|; takes
+    // |stream|, leaving it empty.
+    void record_miss(VkCommandBuffer command_buffer, uint64_t hash, std::vector<uint8_t>* stream);
+    // The server holds no reusable recording (reset, failed or released).
+    void invalidate(VkCommandBuffer command_buffer);
+    void remove(VkCommandBuffer command_buffer);
+
+    CommandReplayStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Dependency {
+        uint64_t handle = 0;
+        uint64_t version = 0;
+
+        bool operator==(const Dependency& other) const {
+            return handle == other.handle && version == other.version;
+        }
+    };
+
+    struct Entry {
+        bool valid = false;
+        uint64_t hash = 0;
+        std::vector<uint8_t> stream;
+        // Changes whenever the server's recording does; primaries that
+        // execute this buffer depend on it.
+        uint64_t generation = 0;
+        std::vector<Dependency> dependencies;
+        // Collected during the current recording.
+        std::vector<VkDescriptorSet> sets;
+        std::vector<VkCommandBuffer> secondaries;
+        std::vector<Dependency> pending;
+    };
+
+    template <typename T>
+    static uint64_t handle_key(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    bool enabled_ = true;
+    uint32_t stats_interval_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> entries_;
+    uint64_t next_generation_ = 1;
+    CommandReplayStats stats_;
+};
+
+extern CommandReplayCache g_replay_cache;
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_REPLAY_CACHE_H
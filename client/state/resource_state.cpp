@@ -10,14 +10,21 @@ namespace {
 constexpr VkDeviceSize kAutoInvalidateOnWaitThreshold = 16 * 1024 * 1024; // 16 MiB
 }
 
-void ResourceState::add_buffer(VkDevice device, VkBuffer local, VkBuffer remote, const VkBufferCreateInfo& info) {
+void ResourceState::add_buffer(VkDevice device,
+                               VkBuffer local,
+                               VkBuffer remote,
+                               const VkBufferCreateInfo& info,
+                               bool stageable) {
     std::lock_guard<std::mutex> lock(mutex_);
     BufferState state = {};
     state.device = device;
     state.remote_handle = remote;
     state.size = info.size;
     state.usage = info.usage;
+    state.flags = info.flags;
     state.sharing_mode = info.sharingMode;
+    state.chained_create_info = info.pNext != nullptr;
+    state.stageable = stageable;
     state.bound_memory = VK_NULL_HANDLE;
     state.bound_offset = 0;
     state.requirements = {};
@@ -75,6 +82,30 @@ bool ResourceState::get_cached_buffer_requirements(VkBuffer buffer, VkMemoryRequ
     return true;
 }
 
+bool ResourceState::get_plain_buffer_info(VkBuffer buffer, VkBufferCreateInfo* out) const {
+    if (!out) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = buffers_.find(handle_key(buffer));
+    if (it == buffers_.end() || it->second.chained_create_info) {
+        return false;
+    }
+    *out = {};
+    out->sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    out->flags = it->second.flags;
+    out->size = it->second.size;
+    out->usage = it->second.usage;
+    out->sharingMode = it->second.sharing_mode;
+    return true;
+}
+
+bool ResourceState::is_stageable_buffer(VkBuffer buffer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = buffers_.find(handle_key(buffer));
+    return it != buffers_.end() && it->second.stageable;
+}
+
 bool ResourceState::bind_buffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto bit = buffers_.find(handle_key(buffer));
@@ -108,6 +139,7 @@ void ResourceState::add_image(VkDevice device, VkImage local, VkImage remote, co
     state.tiling = info.tiling;
     state.usage = info.usage;
     state.flags = info.flags;
+    state.chained_create_info = info.pNext != nullptr;
     state.bound_memory = VK_NULL_HANDLE;
     state.bound_offset = 0;
     state.requirements = {};
@@ -152,6 +184,44 @@ bool ResourceState::cache_image_requirements(VkImage image, const VkMemoryRequir
     return true;
 }
 
+bool ResourceState::get_plain_image_info(VkImage image, VkImageCreateInfo* out) const {
+    if (!out) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = images_.find(handle_key(image));
+    if (it == images_.end() || it->second.chained_create_info) {
+        return false;
+    }
+    const ImageState& state = it->second;
+    *out = {};
+    out->sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    out->flags = state.flags;
+    out->imageType = state.type;
+    out->format = state.format;
+    out->extent = state.extent;
+    out->mipLevels = state.mip_levels;
+    out->arrayLayers = state.array_layers;
+    out->samples = state.samples;
+    out->tiling = state.tiling;
+    out->usage = state.usage;
+    return true;
+}
+
+bool ResourceState::get_image_format(VkImage image, VkFormat* format, uint32_t* array_layers) const {
+    if (!format || !array_layers) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = images_.find(handle_key(image));
+    if (it == images_.end()) {
+        return false;
+    }
+    *format = it->second.format;
+    *array_layers = it->second.array_layers;
+    return true;
+}
+
 bool ResourceState::get_cached_image_requirements(VkImage image, VkMemoryRequirements* out) const {
     if (!out) {
         return false;
@@ -13,7 +13,10 @@ struct BufferState {
     VkBuffer remote_handle;
     VkDeviceSize size;
     VkBufferUsageFlags usage;
+    VkBufferCreateFlags flags;
     VkSharingMode sharing_mode;
+    bool chained_create_info;  // created with a pNext chain
+    bool stageable;            // memory dedicated to it can be staged
     VkDeviceMemory bound_memory;
     VkDeviceSize bound_offset;
     VkMemoryRequirements requirements;
@@ -32,6 +35,7 @@ struct ImageState {
     VkImageTiling tiling;
     VkImageUsageFlags usage;
     VkImageCreateFlags flags;
+    bool chained_create_info;  // created with a pNext chain
     VkDeviceMemory bound_memory;
     VkDeviceSize bound_offset;
     VkMemoryRequirements requirements;
@@ -82,12 +86,20 @@ struct MemoryState {
 
 class ResourceState {
 public:
-    void add_buffer(VkDevice device, VkBuffer local, VkBuffer remote, const VkBufferCreateInfo& info);
+    void add_buffer(VkDevice device,
+                    VkBuffer local,
+                    VkBuffer remote,
+                    const VkBufferCreateInfo& info,
+                    bool stageable);
     void remove_buffer(VkBuffer buffer);
     bool has_buffer(VkBuffer buffer) const;
     VkBuffer get_remote_buffer(VkBuffer buffer) const;
     bool cache_buffer_requirements(VkBuffer buffer, const VkMemoryRequirements& requirements);
     bool get_cached_buffer_requirements(VkBuffer buffer, VkMemoryRequirements* out) const;
+    // The create info of a buffer created without a pNext chain, less its
+    // queue family indices.
+    bool get_plain_buffer_info(VkBuffer buffer, VkBufferCreateInfo* out) const;
+    bool is_stageable_buffer(VkBuffer buffer) const;
     bool bind_buffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset);
 
     void add_image(VkDevice device, VkImage local, VkImage remote, const VkImageCreateInfo& info);
@@ -96,6 +108,11 @@ public:
     VkImage get_remote_image(VkImage image) const;
     bool cache_image_requirements(VkImage image, const VkMemoryRequirements& requirements);
     bool get_cached_image_requirements(VkImage image, VkMemoryRequirements* out) const;
+    // The create info of an image created without a pNext chain, less its
+    // sharing mode, queue family indices and initial layout.
+    bool get_plain_image_info(VkImage image, VkImageCreateInfo* out) const;
+    // What sizing a host image copy of the image needs.
+    bool get_image_format(VkImage image, VkFormat* format, uint32_t* array_layers) const;
     bool bind_image(VkImage image, VkDeviceMemory memory, VkDeviceSize offset);
 
     void add_image_view(VkDevice device, VkImageView local, VkImageView remote, VkImage image);
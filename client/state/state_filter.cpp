@@ -0,0 +1,144 @@
+#include "state/state_filter.h"
+
+#include "utils/logging.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace venus_plus {
+
+StateFilter g_state_filter;
+
+namespace {
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    const int parsed = std::atoi(value);
+    return parsed > 0 ? static_cast<uint32_t>(parsed) : fallback;
+}
+
+bool is_pipeline_slot(StateSlot slot) {
+    return slot == StateSlot::GraphicsPipeline || slot == StateSlot::ComputePipeline;
+}
+
+bool is_dynamic_state_slot(StateSlot slot) {
+    return static_cast<uint32_t>(slot) >= static_cast<uint32_t>(StateSlot::Viewport);
+}
+
+} // namespace
+
+StateFilter::StateFilter() {
+    configure();
+}
+
+void StateFilter::configure() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = !env_disabled("VENUS_STATE_FILTER");
+    stats_interval_ = env_uint("VENUS_STATE_FILTER_STATS", 0);
+    scopes_.clear();
+}
+
+void StateFilter::begin_scope(VkCommandBuffer command_buffer) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    scopes_[handle_key(command_buffer)] = Scope();
+}
+
+void StateFilter::end_scope(VkCommandBuffer command_buffer) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    scopes_.erase(handle_key(command_buffer));
+}
+
+void StateFilter::forget_state(VkCommandBuffer command_buffer) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = scopes_.find(handle_key(command_buffer));
+    if (it != scopes_.end()) {
+        it->second = Scope();
+    }
+}
+
+void StateFilter::forget_slot(VkCommandBuffer command_buffer, StateSlot slot) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = scopes_.find(handle_key(command_buffer));
+    if (it != scopes_.end()) {
+        it->second.slots[static_cast<size_t>(slot)].clear();
+    }
+}
+
+bool StateFilter::filter(VkCommandBuffer command_buffer, StateSlot slot, const void* args, size_t size) {
+    if (!enabled_ || size == 0) {
+        return false;
+    }
+    bool redundant = false;
+    bool log = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = scopes_.find(handle_key(command_buffer));
+        if (it == scopes_.end()) {
+            return false;
+        }
+        auto& slots = it->second.slots;
+        std::vector<uint8_t>& last = slots[static_cast<size_t>(slot)];
+        redundant = last.size() == size && std::memcmp(last.data(), args, size) == 0;
+        if (!redundant) {
+            if (is_pipeline_slot(slot)) {
+                // A new pipeline may change the layout and which state is
+                // dynamic; only the pipeline itself stays known.
+                for (auto& other : slots) {
+                    other.clear();
+                }
+            } else if (is_dynamic_state_slot(slot)) {
+                slots[static_cast<size_t>(StateSlot::GraphicsPipeline)].clear();
+            }
+            const uint8_t* bytes = static_cast<const uint8_t*>(args);
+            std::vector<uint8_t>& current = slots[static_cast<size_t>(slot)];
+            current.assign(bytes, bytes + size);
+        }
+        ++stats_.checked;
+        if (redundant) {
+            ++stats_.elided;
+        }
+        log = stats_interval_ && stats_.checked % stats_interval_ == 0;
+    }
+    if (log) {
+        log_stats();
+    }
+    return redundant;
+}
+
+StateFilterStats StateFilter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void StateFilter::log_stats() const {
+    const StateFilterStats snapshot = stats();
+    const double elided_rate =
+        snapshot.checked ? 100.0 * static_cast<double>(snapshot.elided) / snapshot.checked : 0.0;
+    VP_LOG_STREAM_INFO(CLIENT) << "[StateFilter] checked=" << snapshot.checked
+                               << " elided=" << snapshot.elided << " (" << elided_rate << "%)";
+}
+
+} // namespace venus_plus
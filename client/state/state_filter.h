@@ -0,0 +1,126 @@
+#ifndef VENUS_PLUS_STATE_FILTER_H
+#define VENUS_PLUS_STATE_FILTER_H
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+struct StateFilterStats {
+    uint64_t checked = 0; // bind/set commands seen inside a render pass
+    uint64_t elided = 0;  // dropped because they repeated the bound state
+};
+
+// One slot per piece of bound state. Commands that write the same state share
+// a slot (vkCmdSetViewport and vkCmdSetViewportWithCount, for example) so a
+// different writer in between never looks redundant.
+enum class StateSlot : uint32_t {
+    GraphicsPipeline,
+    ComputePipeline,
+    GraphicsDescriptorSets,
+    ComputeDescriptorSets,
+    VertexBuffers,
+    IndexBuffer,
+    // Dynamic state; a changed value can interact with a pipeline's static
+    // state, so it also forgets the bound graphics pipeline.
+    Viewport,
+    Scissor,
+    CullMode,
+    FrontFace,
+    PrimitiveTopology,
+    DepthTestEnable,
+    DepthWriteEnable,
+    DepthCompareOp,
+    DepthBoundsTestEnable,
+    StencilTestEnable,
+    StencilOp,
+    RasterizerDiscardEnable,
+    DepthBiasEnable,
+    PrimitiveRestartEnable,
+    Count,
+};
+
+// Drops vkCmdBind*/vkCmdSet* calls whose arguments match what the same command
+// buffer last set for that slot. Filtering only happens inside a render pass
+// or dynamic-rendering scope (or a secondary that continues one), and the
+// scope forgets everything on its boundaries, after vkCmdExecuteCommands and
+// whenever a different pipeline is bound. Arguments are compared after handle
+// translation, as the encoded bytes would be.
+// Tunables: VENUS_STATE_FILTER=off, VENUS_STATE_FILTER_STATS=<log every N checks>.
+class StateFilter {
+public:
+    StateFilter();
+
+    // Reads the tunables again; vkCreateInstance calls this, so a process can
+    // compare runs with the filter on and off.
+    void configure();
+
+    bool enabled() const { return enabled_; }
+
+    // Starts a scope with nothing known; replaces any open one.
+    void begin_scope(VkCommandBuffer command_buffer);
+    void end_scope(VkCommandBuffer command_buffer);
+    // Bound state is undefined after vkCmdExecuteCommands; the scope stays open.
+    void forget_state(VkCommandBuffer command_buffer);
+    // For commands that change a slot's state without going through filter()
+    // (vkCmdPushDescriptorSetKHR changes the bound sets).
+    void forget_slot(VkCommandBuffer command_buffer, StateSlot slot);
+
+    // Returns true when the command is redundant and should not be sent;
+    // otherwise remembers |args| as the slot's state.
+    bool filter(VkCommandBuffer command_buffer, StateSlot slot, const void* args, size_t size);
+
+    StateFilterStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Scope {
+        std::array<std::vector<uint8_t>, static_cast<size_t>(StateSlot::Count)> slots;
+    };
+
+    template <typename T>
+    static uint64_t handle_key(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    std::atomic<bool> enabled_{true};
+    uint32_t stats_interval_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Scope> scopes_;
+    StateFilterStats stats_;
+};
+
+extern StateFilter g_state_filter;
+
+// Builds the comparison blob for a command from its (translated) arguments.
+class StateBlob {
+public:
+    template <typename T>
+    StateBlob& add(const T& value) {
+        return add_array(&value, 1);
+    }
+
+    template <typename T>
+    StateBlob& add_array(const T* values, uint32_t count) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T) * count);
+        return *this;
+    }
+
+    const void* data() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_STATE_FILTER_H
@@ -31,6 +31,7 @@ VkSwapchainKHR SwapchainState::add_swapchain(VkDevice device,
     info.images = std::move(images);
     info.last_acquired = 0;
     info.wsi = std::move(wsi);
+    info.pacer = std::make_shared<FramePacer>(swapchain_id, create_info.presentMode);
 
     VkSwapchainKHR handle = g_handle_allocator.allocate<VkSwapchainKHR>();
     swapchains_[handle_key(handle)] = std::move(info);
@@ -100,6 +101,15 @@ std::shared_ptr<PlatformWSI> SwapchainState::get_wsi(VkSwapchainKHR swapchain) c
     return it->second.wsi;
 }
 
+std::shared_ptr<FramePacer> SwapchainState::get_pacer(VkSwapchainKHR swapchain) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = swapchains_.find(handle_key(swapchain));
+    if (it == swapchains_.end()) {
+        return nullptr;
+    }
+    return it->second.pacer;
+}
+
 uint32_t SwapchainState::get_remote_id(VkSwapchainKHR swapchain) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = swapchains_.find(handle_key(swapchain));
@@ -7,6 +7,7 @@
 #include <vector>
 #include <memory>
 
+#include "wsi/frame_pacer.h"
 #include "wsi/platform_wsi.h"
 
 namespace venus_plus {
@@ -21,6 +22,7 @@ struct SwapchainInfo {
     std::vector<VkImage> images;
     uint32_t last_acquired = 0;
     std::shared_ptr<PlatformWSI> wsi;
+    std::shared_ptr<FramePacer> pacer;
 };
 
 class SwapchainState {
@@ -41,6 +43,7 @@ public:
     bool acquire_image(VkSwapchainKHR swapchain, uint32_t* image_index);
     bool get_info(VkSwapchainKHR swapchain, SwapchainInfo* out_info) const;
     std::shared_ptr<PlatformWSI> get_wsi(VkSwapchainKHR swapchain) const;
+    std::shared_ptr<FramePacer> get_pacer(VkSwapchainKHR swapchain) const;
     uint32_t get_remote_id(VkSwapchainKHR swapchain) const;
     void remove_device_swapchains(VkDevice device, std::vector<SwapchainInfo>* removed);
 
@@ -0,0 +1,193 @@
+#include "wsi/frame_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace venus_plus {
+
+namespace {
+
+// Walks the linear (server-side) byte stream of a frame and maps it onto a
+// strided destination, dropping any source row padding.
+class StridedFrameWriter {
+public:
+    StridedFrameWriter(const VenusFrameHeader& frame, const WsiFrameTarget& target)
+        : dst_(target.pixels),
+          dst_stride_(target.stride),
+          src_stride_(frame_source_stride(frame)),
+          row_bytes_(frame.width * kFrameBytesPerPixel),
+          height_(frame.height) {}
+
+    bool write(const uint8_t* src, size_t count) {
+        return advance(count, [src](uint8_t* dst, size_t n, size_t consumed) {
+            std::memcpy(dst, src + consumed, n);
+        });
+    }
+
+    bool fill(uint8_t value, size_t count) {
+        return advance(count, [value](uint8_t* dst, size_t n, size_t consumed) {
+            (void)consumed;
+            std::memset(dst, value, n);
+        });
+    }
+
+    bool complete() const {
+        if (height_ == 0) {
+            return true;
+        }
+        return row_ >= height_ || (row_ == height_ - 1 && column_ >= row_bytes_);
+    }
+
+    size_t written() const {
+        return static_cast<size_t>(row_) * src_stride_ + column_;
+    }
+
+private:
+    template <typename Emit>
+    bool advance(size_t count, Emit emit) {
+        size_t consumed = 0;
+        while (consumed < count) {
+            if (row_ >= height_) {
+                return false;
+            }
+            const size_t span = std::min<size_t>(count - consumed, src_stride_ - column_);
+            if (column_ < row_bytes_) {
+                const size_t visible = std::min<size_t>(span, row_bytes_ - column_);
+                emit(dst_ + static_cast<size_t>(row_) * dst_stride_ + column_, visible, consumed);
+            }
+            column_ += static_cast<uint32_t>(span);
+            consumed += span;
+            if (column_ == src_stride_) {
+                column_ = 0;
+                ++row_;
+            }
+        }
+        return true;
+    }
+
+    uint8_t* dst_ = nullptr;
+    uint32_t dst_stride_ = 0;
+    uint32_t src_stride_ = 0;
+    uint32_t row_bytes_ = 0;
+    uint32_t height_ = 0;
+    uint32_t row_ = 0;
+    uint32_t column_ = 0;
+};
+
+} // namespace
+
+uint32_t frame_source_stride(const VenusFrameHeader& frame) {
+    const uint32_t packed = frame.width * kFrameBytesPerPixel;
+    return frame.stride >= packed ? frame.stride : packed;
+}
+
+size_t frame_visible_size(const VenusFrameHeader& frame) {
+    if (frame.height == 0) {
+        return 0;
+    }
+    return static_cast<size_t>(frame.height - 1) * frame_source_stride(frame) +
+           static_cast<size_t>(frame.width) * kFrameBytesPerPixel;
+}
+
+bool frame_fits_target(const VenusFrameHeader& frame, const WsiFrameTarget& target) {
+    if (!target.pixels || frame.width > target.width || frame.height > target.height) {
+        return false;
+    }
+    return target.stride >= frame.width * kFrameBytesPerPixel;
+}
+
+bool decompress_rle(const VenusFrameHeader& frame,
+                    const uint8_t* data,
+                    std::vector<uint8_t>* output) {
+    if (!data || !output) {
+        return false;
+    }
+    output->clear();
+    size_t offset = 0;
+    while (offset < frame.payload_size) {
+        if (offset + 2 > frame.payload_size) {
+            return false;
+        }
+        uint8_t tag = data[offset++];
+        uint8_t count = data[offset++];
+        if (tag == 1) {
+            if (offset >= frame.payload_size) {
+                return false;
+            }
+            uint8_t value = data[offset++];
+            output->insert(output->end(), count, value);
+        } else {
+            if (offset + count > frame.payload_size) {
+                return false;
+            }
+            output->insert(output->end(), data + offset, data + offset + count);
+            offset += count;
+        }
+    }
+    if (frame.uncompressed_size != 0 && output->size() != frame.uncompressed_size) {
+        return false;
+    }
+    return true;
+}
+
+bool decode_frame_into(const VenusFrameHeader& frame,
+                       const uint8_t* data,
+                       const WsiFrameTarget& target) {
+    if (!data || frame.width == 0 || frame.height == 0 || !frame_fits_target(frame, target)) {
+        return false;
+    }
+
+    if (frame.compression == FrameCompressionType::NONE) {
+        if (frame.payload_size < frame_visible_size(frame)) {
+            return false;
+        }
+        const uint32_t src_stride = frame_source_stride(frame);
+        const size_t row_bytes = static_cast<size_t>(frame.width) * kFrameBytesPerPixel;
+        if (src_stride == target.stride) {
+            std::memcpy(target.pixels, data, frame_visible_size(frame));
+            return true;
+        }
+        for (uint32_t y = 0; y < frame.height; ++y) {
+            std::memcpy(target.pixels + static_cast<size_t>(y) * target.stride,
+                        data + static_cast<size_t>(y) * src_stride,
+                        row_bytes);
+        }
+        return true;
+    }
+
+    if (frame.compression != FrameCompressionType::RLE) {
+        return false;
+    }
+
+    StridedFrameWriter writer(frame, target);
+    size_t offset = 0;
+    while (offset < frame.payload_size) {
+        if (offset + 2 > frame.payload_size) {
+            return false;
+        }
+        uint8_t tag = data[offset++];
+        uint8_t count = data[offset++];
+        if (tag == 1) {
+            if (offset >= frame.payload_size) {
+                return false;
+            }
+            if (!writer.fill(data[offset++], count)) {
+                return false;
+            }
+        } else {
+            if (offset + count > frame.payload_size) {
+                return false;
+            }
+            if (!writer.write(data + offset, count)) {
+                return false;
+            }
+            offset += count;
+        }
+    }
+    if (frame.uncompressed_size != 0 && writer.written() != frame.uncompressed_size) {
+        return false;
+    }
+    return writer.complete();
+}
+
+} // namespace venus_plus
@@ -0,0 +1,37 @@
+#ifndef VENUS_PLUS_FRAME_DECODER_H
+#define VENUS_PLUS_FRAME_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "protocol/frame_transfer.h"
+#include "wsi/platform_wsi.h"
+
+namespace venus_plus {
+
+constexpr uint32_t kFrameBytesPerPixel = 4;
+
+// Row pitch of the payload sent by the server (falls back to tightly packed rows).
+uint32_t frame_source_stride(const VenusFrameHeader& frame);
+
+// Bytes of |payload_size| that actually carry pixels for an uncompressed frame.
+size_t frame_visible_size(const VenusFrameHeader& frame);
+
+// Checks that |frame| fits in |target| so it can be written without clipping.
+bool frame_fits_target(const VenusFrameHeader& frame, const WsiFrameTarget& target);
+
+// Expands an RLE payload into a linear buffer.
+bool decompress_rle(const VenusFrameHeader& frame,
+                    const uint8_t* data,
+                    std::vector<uint8_t>* output);
+
+// Decodes |data| (raw or RLE) straight into |target|, honoring the target
+// stride, so no intermediate frame buffer is needed.
+bool decode_frame_into(const VenusFrameHeader& frame,
+                       const uint8_t* data,
+                       const WsiFrameTarget& target);
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_FRAME_DECODER_H
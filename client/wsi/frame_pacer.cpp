@@ -0,0 +1,235 @@
+#include "wsi/frame_pacer.h"
+
+#include "utils/logging.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+namespace venus_plus {
+
+namespace {
+
+// Smoothing factor for the latency/transfer moving averages.
+constexpr double kEwmaWeight = 0.125;
+// Frames between policy re-evaluations (hysteresis against flapping).
+constexpr uint32_t kEvaluationFrames = 8;
+// Under pressure the link is kept busy at most 1/kDutyCycleFactor of the time.
+constexpr double kDutyCycleFactor = 2.0;
+
+const char* frame_codec_level_name(FrameCodecLevel level) {
+    switch (level) {
+        case FrameCodecLevel::AUTO:
+            return "auto";
+        case FrameCodecLevel::RAW:
+            return "raw";
+        case FrameCodecLevel::LOSSY:
+            return "lossy";
+    }
+    return "unknown";
+}
+
+bool env_disabled(const char* name) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return false;
+    }
+    return std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 ||
+           std::strcmp(value, "OFF") == 0;
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+    const int parsed = std::atoi(value);
+    return parsed > 0 ? static_cast<uint32_t>(parsed) : fallback;
+}
+
+} // namespace
+
+const char* frame_pacing_policy_name(FramePacingPolicy policy) {
+    switch (policy) {
+        case FramePacingPolicy::kNone:
+            return "none";
+        case FramePacingPolicy::kReduceCodec:
+            return "reduce-codec";
+        case FramePacingPolicy::kDropStale:
+            return "drop-stale";
+        case FramePacingPolicy::kThrottleAcquire:
+            return "throttle-acquire";
+    }
+    return "unknown";
+}
+
+FramePacer::FramePacer(uint32_t swapchain_id, VkPresentModeKHR present_mode)
+    : swapchain_id_(swapchain_id),
+      drop_allowed_(present_mode == VK_PRESENT_MODE_MAILBOX_KHR ||
+                    present_mode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+    enabled_ = !env_disabled("VENUS_FRAME_PACING");
+    budget_us_ = static_cast<double>(env_uint("VENUS_FRAME_LATENCY_MS", 50)) * 1000.0;
+    stats_interval_ = env_uint("VENUS_FRAME_STATS", 0);
+}
+
+void FramePacer::throttle_acquire() {
+    Clock::time_point until;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stats_.policy != FramePacingPolicy::kThrottleAcquire) {
+            return;
+        }
+        until = last_delivery_end_ + idle_gap_locked();
+    }
+    if (Clock::now() >= until) {
+        return;
+    }
+    std::this_thread::sleep_until(until);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.acquires_throttled;
+}
+
+FramePacer::PresentPlan FramePacer::plan_present() {
+    PresentPlan plan;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_) {
+        return plan;
+    }
+    plan.codec_level = stats_.codec_level;
+    if (stats_.policy == FramePacingPolicy::kDropStale) {
+        // Mailbox semantics: a frame arriving before the link had its idle
+        // gap would only queue behind the previous one, so it is dropped.
+        plan.skip = Clock::now() < last_delivery_end_ + idle_gap_locked();
+    }
+    return plan;
+}
+
+void FramePacer::record_present(const PresentSample& sample) {
+    bool log_now = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const double latency_us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::microseconds>(sample.end - sample.start).count());
+        const double server_us = std::min(latency_us, static_cast<double>(sample.server_time_us));
+        const double transfer_us = latency_us - server_us;
+
+        if (stats_.frames_presented == 0) {
+            ewma_latency_us_ = latency_us;
+            ewma_server_us_ = server_us;
+            ewma_transfer_us_ = transfer_us;
+        } else {
+            ewma_latency_us_ += kEwmaWeight * (latency_us - ewma_latency_us_);
+            ewma_server_us_ += kEwmaWeight * (server_us - ewma_server_us_);
+            ewma_transfer_us_ += kEwmaWeight * (transfer_us - ewma_transfer_us_);
+        }
+
+        ++stats_.frames_presented;
+        stats_.payload_bytes += sample.payload_bytes;
+        stats_.avg_latency_ms = ewma_latency_us_ / 1000.0;
+        stats_.avg_server_ms = ewma_server_us_ / 1000.0;
+        stats_.avg_transfer_ms = ewma_transfer_us_ / 1000.0;
+
+        size_t bucket = 0;
+        const double latency_ms = latency_us / 1000.0;
+        while (bucket < kFrameLatencyBucketsMs.size() && latency_ms >= kFrameLatencyBucketsMs[bucket]) {
+            ++bucket;
+        }
+        ++stats_.latency_histogram[bucket];
+
+        last_delivery_end_ = sample.end;
+        if (++frames_since_update_ >= kEvaluationFrames) {
+            frames_since_update_ = 0;
+            update_policy_locked();
+        }
+        log_now = stats_interval_ != 0 && stats_.frames_presented % stats_interval_ == 0;
+    }
+    if (log_now) {
+        log_stats();
+    }
+}
+
+void FramePacer::record_drop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.frames_dropped;
+}
+
+FramePacingStats FramePacer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FramePacer::log_stats() const {
+    const FramePacingStats snapshot = stats();
+    std::ostringstream histogram;
+    for (size_t i = 0; i < snapshot.latency_histogram.size(); ++i) {
+        if (i < kFrameLatencyBucketsMs.size()) {
+            histogram << " <" << kFrameLatencyBucketsMs[i] << "ms:";
+        } else {
+            histogram << " >=" << kFrameLatencyBucketsMs.back() << "ms:";
+        }
+        histogram << snapshot.latency_histogram[i];
+    }
+    VP_LOG_STREAM_INFO(CLIENT) << "[Pacing] swapchain #" << swapchain_id_
+                               << " policy=" << frame_pacing_policy_name(snapshot.policy)
+                               << " codec=" << frame_codec_level_name(snapshot.codec_level)
+                               << " presented=" << snapshot.frames_presented
+                               << " dropped=" << snapshot.frames_dropped
+                               << " throttled=" << snapshot.acquires_throttled
+                               << " bytes=" << snapshot.payload_bytes
+                               << " latency=" << snapshot.avg_latency_ms << "ms"
+                               << " (server " << snapshot.avg_server_ms
+                               << "ms, transfer " << snapshot.avg_transfer_ms << "ms)"
+                               << " histogram:" << histogram.str();
+}
+
+void FramePacer::update_policy_locked() {
+    if (!enabled_) {
+        stats_.policy = FramePacingPolicy::kNone;
+        stats_.codec_level = FrameCodecLevel::AUTO;
+        return;
+    }
+
+    const FramePacingPolicy previous = stats_.policy;
+    if (ewma_latency_us_ > budget_us_) {
+        // Attack the dominant cost first: a slow link wants fewer bytes, a
+        // busy server wants less encoding work.
+        const FrameCodecLevel wanted = ewma_transfer_us_ >= ewma_server_us_
+                                           ? FrameCodecLevel::LOSSY
+                                           : FrameCodecLevel::RAW;
+        if (stats_.codec_level != wanted && stats_.codec_level != FrameCodecLevel::LOSSY) {
+            stats_.codec_level = wanted;
+            stats_.policy = FramePacingPolicy::kReduceCodec;
+        } else {
+            stats_.policy = drop_allowed_ ? FramePacingPolicy::kDropStale
+                                          : FramePacingPolicy::kThrottleAcquire;
+        }
+    } else if (ewma_latency_us_ < budget_us_ * 0.5) {
+        // Relax one step at a time once there is comfortable headroom.
+        if (stats_.policy == FramePacingPolicy::kDropStale ||
+            stats_.policy == FramePacingPolicy::kThrottleAcquire) {
+            stats_.policy = stats_.codec_level != FrameCodecLevel::AUTO
+                                ? FramePacingPolicy::kReduceCodec
+                                : FramePacingPolicy::kNone;
+        } else if (stats_.codec_level != FrameCodecLevel::AUTO) {
+            stats_.codec_level = FrameCodecLevel::AUTO;
+            stats_.policy = FramePacingPolicy::kNone;
+        }
+    }
+
+    if (stats_.policy != previous) {
+        VP_LOG_STREAM_INFO(CLIENT) << "[Pacing] swapchain #" << swapchain_id_ << " policy "
+                                   << frame_pacing_policy_name(previous) << " -> "
+                                   << frame_pacing_policy_name(stats_.policy)
+                                   << " (latency " << ewma_latency_us_ / 1000.0 << "ms, budget "
+                                   << budget_us_ / 1000.0 << "ms)";
+    }
+}
+
+FramePacer::Clock::duration FramePacer::idle_gap_locked() const {
+    const double gap_us = ewma_latency_us_ * (kDutyCycleFactor - 1.0);
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::microseconds(static_cast<int64_t>(std::min(gap_us, budget_us_))));
+}
+
+} // namespace venus_plus
@@ -0,0 +1,96 @@
+#ifndef VENUS_PLUS_FRAME_PACER_H
+#define VENUS_PLUS_FRAME_PACER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vulkan/vulkan.h>
+
+#include "protocol/frame_transfer.h"
+
+namespace venus_plus {
+
+// How the pacer currently reacts to a link that cannot keep up.
+enum class FramePacingPolicy : uint32_t {
+    kNone = 0,          // latency within budget, every frame is delivered
+    kReduceCodec,       // transfer-bound: ask the server for a cheaper/smaller encoding
+    kDropStale,         // MAILBOX/IMMEDIATE: skip frames the link has no room for
+    kThrottleAcquire,   // FIFO: delay vkAcquireNextImageKHR to the link's rate
+};
+
+const char* frame_pacing_policy_name(FramePacingPolicy policy);
+
+// Upper bounds (ms) of the frame latency histogram buckets; the last bucket is open.
+constexpr std::array<uint32_t, 7> kFrameLatencyBucketsMs = {8, 16, 33, 50, 100, 200, 500};
+
+struct FramePacingStats {
+    FramePacingPolicy policy = FramePacingPolicy::kNone;
+    FrameCodecLevel codec_level = FrameCodecLevel::AUTO;
+    uint64_t frames_presented = 0;
+    uint64_t frames_dropped = 0;
+    uint64_t acquires_throttled = 0;
+    uint64_t payload_bytes = 0;
+    double avg_latency_ms = 0.0;
+    double avg_server_ms = 0.0;
+    double avg_transfer_ms = 0.0;
+    std::array<uint64_t, kFrameLatencyBucketsMs.size() + 1> latency_histogram = {};
+};
+
+// Per-swapchain feedback loop between presentation and link capacity.
+// Every delivered frame reports its end-to-end latency (present call until the
+// frame reached the WSI), the server-side readback/encode share and the
+// payload size. When the smoothed latency leaves the budget the pacer first
+// lowers the codec level, then drops stale frames (mailbox-like present
+// modes) or throttles acquire (FIFO) so the link duty cycle stays bounded.
+// Tunables: VENUS_FRAME_PACING=off, VENUS_FRAME_LATENCY_MS=<budget>,
+// VENUS_FRAME_STATS=<log every N frames>.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct PresentPlan {
+        bool skip = false;
+        FrameCodecLevel codec_level = FrameCodecLevel::AUTO;
+    };
+
+    struct PresentSample {
+        Clock::time_point start;
+        Clock::time_point end;
+        uint32_t server_time_us = 0;
+        uint64_t payload_bytes = 0;
+    };
+
+    FramePacer(uint32_t swapchain_id, VkPresentModeKHR present_mode);
+
+    // Blocks until the next frame may be acquired (kThrottleAcquire only).
+    void throttle_acquire();
+    PresentPlan plan_present();
+    void record_present(const PresentSample& sample);
+    void record_drop();
+
+    FramePacingStats stats() const;
+    void log_stats() const;
+
+private:
+    void update_policy_locked();
+    Clock::duration idle_gap_locked() const;
+
+    const uint32_t swapchain_id_;
+    const bool drop_allowed_;
+    bool enabled_ = true;
+    double budget_us_ = 50000.0;
+    uint32_t stats_interval_ = 0;
+
+    mutable std::mutex mutex_;
+    FramePacingStats stats_;
+    double ewma_latency_us_ = 0.0;
+    double ewma_server_us_ = 0.0;
+    double ewma_transfer_us_ = 0.0;
+    uint32_t frames_since_update_ = 0;
+    Clock::time_point last_delivery_end_ = {};
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_FRAME_PACER_H
@@ -0,0 +1,231 @@
+#include "wsi/frame_sink.h"
+
+#include "utils/logging.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace venus_plus {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+double percentile_ms(std::vector<uint32_t> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    const size_t index = std::min(samples.size() - 1,
+                                  static_cast<size_t>(fraction * static_cast<double>(samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index] / 1000.0;
+}
+
+double average_ms(const std::vector<uint32_t>& samples) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    uint64_t total = 0;
+    for (uint32_t value : samples) {
+        total += value;
+    }
+    return static_cast<double>(total) / static_cast<double>(samples.size()) / 1000.0;
+}
+
+uint32_t elapsed_us(BenchmarkFrameSink::Clock::time_point from,
+                    BenchmarkFrameSink::Clock::time_point to) {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+} // namespace
+
+FrameSinkConfig parse_frame_sink_config(const char* value) {
+    FrameSinkConfig config;
+    if (!value || !*value) {
+        return config;
+    }
+
+    std::stringstream stream(value);
+    std::string token;
+    bool first = true;
+    while (std::getline(stream, token, ',')) {
+        std::transform(token.begin(), token.end(), token.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        if (first) {
+            first = false;
+            if (token == "memory" || token == "bench") {
+                config.mode = FrameSinkConfig::Mode::kMemory;
+                continue;
+            }
+            if (token == "file") {
+                continue;
+            }
+        }
+        if (token == "hash") {
+            config.hash = true;
+        } else if (token.compare(0, 5, "dump=") == 0) {
+            const int every = std::atoi(token.c_str() + 5);
+            config.dump_every = every > 0 ? static_cast<uint32_t>(every) : 0;
+        } else if (!token.empty()) {
+            VP_LOG_STREAM_WARN(CLIENT) << "[WSI] Ignoring unknown VENUS_WSI_HEADLESS_SINK option '"
+                                       << token << "'";
+        }
+    }
+    return config;
+}
+
+FrameSinkConfig frame_sink_config_from_env() {
+    return parse_frame_sink_config(std::getenv("VENUS_WSI_HEADLESS_SINK"));
+}
+
+uint64_t hash_frame(const uint8_t* data, size_t size) {
+    uint64_t hash = kFnvOffset;
+    if (!data) {
+        return hash;
+    }
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + offset, sizeof(word));
+        hash = (hash ^ word) * kFnvPrime;
+    }
+    for (; offset < size; ++offset) {
+        hash = (hash ^ data[offset]) * kFnvPrime;
+    }
+    return hash;
+}
+
+BenchmarkFrameSink::BenchmarkFrameSink(const FrameSinkConfig& config)
+    : config_(config) {
+    if (config_.dump_every > 0) {
+        dump_thread_ = std::thread(&BenchmarkFrameSink::dump_loop, this);
+    }
+}
+
+BenchmarkFrameSink::~BenchmarkFrameSink() {
+    finish();
+}
+
+void BenchmarkFrameSink::begin_frame() {
+    frame_start_ = Clock::now();
+}
+
+void BenchmarkFrameSink::end_frame(const VenusFrameHeader& frame, const uint8_t* pixels, size_t size) {
+    const auto now = Clock::now();
+    receive_us_.push_back(elapsed_us(frame_start_, now));
+    if (frames_ == 0) {
+        first_frame_ = now;
+        swapchain_id_ = frame.swapchain_id;
+    } else {
+        interval_us_.push_back(elapsed_us(last_frame_, now));
+    }
+    last_frame_ = now;
+    ++frames_;
+    payload_bytes_ += frame.payload_size;
+    decoded_bytes_ += size;
+
+    if (config_.hash) {
+        const uint64_t hash = hash_frame(pixels, size);
+        combined_hash_ = (combined_hash_ ^ hash) * kFnvPrime;
+        VP_LOG_STREAM_INFO(CLIENT) << "[WSI] Sink frame " << frames_ << " image " << frame.image_index
+                                   << " hash=0x" << std::hex << hash << std::dec;
+    }
+    if (config_.dump_every > 0 && frames_ % config_.dump_every == 0) {
+        queue_dump(frame, pixels, size);
+    }
+}
+
+void BenchmarkFrameSink::queue_dump(const VenusFrameHeader& frame, const uint8_t* pixels, size_t size) {
+    std::lock_guard<std::mutex> lock(dump_mutex_);
+    if (dump_queue_.size() >= kMaxQueuedDumps) {
+        ++dumps_skipped_;
+        return;
+    }
+    DumpJob job;
+    std::ostringstream path;
+    path << "swapchain_" << frame.swapchain_id << "_frame_" << frames_ << ".rgba";
+    job.path = path.str();
+    job.pixels.assign(pixels, pixels + size);
+    dump_queue_.push_back(std::move(job));
+    dump_cv_.notify_one();
+}
+
+void BenchmarkFrameSink::dump_loop() {
+    std::unique_lock<std::mutex> lock(dump_mutex_);
+    while (true) {
+        dump_cv_.wait(lock, [this] { return dump_stop_ || !dump_queue_.empty(); });
+        if (dump_queue_.empty()) {
+            return;
+        }
+        DumpJob job = std::move(dump_queue_.front());
+        dump_queue_.pop_front();
+        lock.unlock();
+
+        std::ofstream file(job.path, std::ios::binary);
+        const bool ok = file.is_open() &&
+                        file.write(reinterpret_cast<const char*>(job.pixels.data()),
+                                   static_cast<std::streamsize>(job.pixels.size()));
+        if (!ok) {
+            VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to write " << job.path;
+        }
+
+        lock.lock();
+        if (ok) {
+            ++dumps_written_;
+        }
+    }
+}
+
+void BenchmarkFrameSink::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    if (dump_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(dump_mutex_);
+            dump_stop_ = true;
+        }
+        dump_cv_.notify_one();
+        dump_thread_.join();
+    }
+    log_report();
+}
+
+void BenchmarkFrameSink::log_report() const {
+    if (frames_ == 0) {
+        return;
+    }
+    const double seconds =
+        std::chrono::duration<double>(last_frame_ - first_frame_).count();
+    const double fps = seconds > 0.0 ? static_cast<double>(frames_ - 1) / seconds : 0.0;
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2)
+           << "[WSI] Sink swapchain #" << swapchain_id_
+           << " frames=" << frames_
+           << " fps=" << fps
+           << " frame_ms avg/p50/p99=" << average_ms(interval_us_) << "/"
+           << percentile_ms(interval_us_, 0.50) << "/" << percentile_ms(interval_us_, 0.99)
+           << " receive_ms avg/p50/p99=" << average_ms(receive_us_) << "/"
+           << percentile_ms(receive_us_, 0.50) << "/" << percentile_ms(receive_us_, 0.99)
+           << " payload_bytes=" << payload_bytes_
+           << " decoded_bytes=" << decoded_bytes_;
+    if (config_.hash) {
+        report << " hash=0x" << std::hex << combined_hash_ << std::dec;
+    }
+    if (config_.dump_every > 0) {
+        report << " dumps=" << dumps_written_ << " skipped=" << dumps_skipped_;
+    }
+    // Benchmark mode is opt-in, so the report is shown at the default level.
+    VP_LOG_STREAM_WARN(CLIENT) << report.str();
+}
+
+} // namespace venus_plus
@@ -0,0 +1,98 @@
+#ifndef VENUS_PLUS_FRAME_SINK_H
+#define VENUS_PLUS_FRAME_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "protocol/frame_transfer.h"
+
+namespace venus_plus {
+
+// Where the headless WSI puts presented frames, from
+// VENUS_WSI_HEADLESS_SINK=<mode>[,hash][,dump=N]:
+//   file   - write swapchain_X_image_Y.rgba on every present (default)
+//   memory - keep frames in memory and report throughput; with |hash| every
+//            frame is hashed for correctness checks, with dump=N every Nth
+//            frame is written on a background thread
+struct FrameSinkConfig {
+    enum class Mode : uint32_t {
+        kFile = 0,
+        kMemory,
+    };
+
+    Mode mode = Mode::kFile;
+    bool hash = false;
+    uint32_t dump_every = 0;
+};
+
+FrameSinkConfig parse_frame_sink_config(const char* value);
+FrameSinkConfig frame_sink_config_from_env();
+
+// 64-bit FNV-1a over |size| bytes, folded a word at a time.
+uint64_t hash_frame(const uint8_t* data, size_t size);
+
+// Benchmark sink for one swapchain. Measures the time between delivered
+// frames (end-to-end frame time), the time spent receiving/decoding each
+// frame into its buffer, and payload vs. decoded bytes. The report is logged
+// by finish().
+class BenchmarkFrameSink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit BenchmarkFrameSink(const FrameSinkConfig& config);
+    ~BenchmarkFrameSink();
+
+    BenchmarkFrameSink(const BenchmarkFrameSink&) = delete;
+    BenchmarkFrameSink& operator=(const BenchmarkFrameSink&) = delete;
+
+    // Called when the frame's buffer is handed out, before the payload is read.
+    void begin_frame();
+    // Called once |pixels| holds the decoded frame.
+    void end_frame(const VenusFrameHeader& frame, const uint8_t* pixels, size_t size);
+    // Stops the dump thread and logs the report.
+    void finish();
+
+private:
+    struct DumpJob {
+        std::string path;
+        std::vector<uint8_t> pixels;
+    };
+
+    void queue_dump(const VenusFrameHeader& frame, const uint8_t* pixels, size_t size);
+    void dump_loop();
+    void log_report() const;
+
+    FrameSinkConfig config_;
+    uint32_t swapchain_id_ = 0;
+    uint64_t frames_ = 0;
+    uint64_t payload_bytes_ = 0;
+    uint64_t decoded_bytes_ = 0;
+    uint64_t combined_hash_ = 0;
+    Clock::time_point frame_start_;
+    Clock::time_point first_frame_;
+    Clock::time_point last_frame_;
+    std::vector<uint32_t> interval_us_;
+    std::vector<uint32_t> receive_us_;
+    bool finished_ = false;
+
+    // Only a few frames may wait for the disk; past that dumps are skipped so
+    // the present path never blocks on I/O.
+    static constexpr size_t kMaxQueuedDumps = 4;
+    std::mutex dump_mutex_;
+    std::condition_variable dump_cv_;
+    std::deque<DumpJob> dump_queue_;
+    std::thread dump_thread_;
+    bool dump_stop_ = false;
+    uint64_t dumps_written_ = 0;
+    uint64_t dumps_skipped_ = 0;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_FRAME_SINK_H
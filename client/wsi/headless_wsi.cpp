@@ -4,8 +4,12 @@
 #include "wsi/linux_wsi.h"
 #endif
 
+#include "wsi/frame_decoder.h"
+#include "wsi/frame_sink.h"
 #include "utils/logging.h"
+#include <algorithm>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <vector>
 
@@ -13,40 +17,6 @@ namespace venus_plus {
 
 namespace {
 
-bool decompress_rle(const VenusFrameHeader& frame,
-                    const uint8_t* data,
-                    std::vector<uint8_t>* output) {
-    if (!data || !output) {
-        return false;
-    }
-    output->clear();
-    size_t offset = 0;
-    while (offset < frame.payload_size) {
-        if (offset + 2 > frame.payload_size) {
-            return false;
-        }
-        uint8_t tag = data[offset++];
-        uint8_t count = data[offset++];
-        if (tag == 1) {
-            if (offset >= frame.payload_size) {
-                return false;
-            }
-            uint8_t value = data[offset++];
-            output->insert(output->end(), count, value);
-        } else {
-            if (offset + count > frame.payload_size) {
-                return false;
-            }
-            output->insert(output->end(), data + offset, data + offset + count);
-            offset += count;
-        }
-    }
-    if (frame.uncompressed_size != 0 && output->size() != frame.uncompressed_size) {
-        return false;
-    }
-    return true;
-}
-
 class HeadlessWSI : public PlatformWSI {
 public:
     bool init(const VkSwapchainCreateInfoKHR& info, uint32_t image_count) override {
@@ -54,6 +24,12 @@ public:
         height_ = info.imageExtent.height;
         format_ = info.imageFormat;
         image_count_ = image_count;
+        stride_ = width_ * kFrameBytesPerPixel;
+        images_.assign(std::max<uint32_t>(1u, image_count_), {});
+        const FrameSinkConfig sink_config = frame_sink_config_from_env();
+        if (sink_config.mode == FrameSinkConfig::Mode::kMemory) {
+            sink_ = std::make_unique<BenchmarkFrameSink>(sink_config);
+        }
         VP_LOG_STREAM_INFO(CLIENT) << "[WSI] Headless WSI initialized (" << width_ << "x"
                                     << height_ << ", images=" << image_count_ << ")";
         return true;
@@ -63,18 +39,40 @@ public:
         if (!data || frame.payload_size == 0) {
             return;
         }
-        const uint8_t* write_ptr = data;
-        size_t write_size = frame.payload_size;
-        std::vector<uint8_t> decoded;
-        if (frame.compression == FrameCompressionType::RLE) {
-            if (!decompress_rle(frame, data, &decoded)) {
-                VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to decompress frame";
-                return;
-            }
-            write_ptr = decoded.data();
-            write_size = decoded.size();
-        } else if (frame.compression != FrameCompressionType::NONE) {
-            VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Unknown compression format";
+        WsiFrameTarget target;
+        if (!acquire_frame_target(frame, &target)) {
+            return;
+        }
+        const bool decoded = decode_frame_into(frame, data, target);
+        if (!decoded) {
+            VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to decode frame";
+        }
+        release_frame_target(frame, decoded);
+    }
+
+    bool acquire_frame_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!target || images_.empty() || width_ == 0 || height_ == 0) {
+            return false;
+        }
+        auto& pixels = images_[frame.image_index % images_.size()];
+        pixels.resize(static_cast<size_t>(stride_) * height_);
+        target->pixels = pixels.data();
+        target->stride = stride_;
+        target->width = width_;
+        target->height = height_;
+        if (sink_) {
+            sink_->begin_frame();
+        }
+        return true;
+    }
+
+    void release_frame_target(const VenusFrameHeader& frame, bool present) override {
+        if (!present || images_.empty()) {
+            return;
+        }
+        const auto& pixels = images_[frame.image_index % images_.size()];
+        if (sink_) {
+            sink_->end_frame(frame, pixels.data(), pixels.size());
             return;
         }
         std::ostringstream path;
@@ -84,12 +82,17 @@ public:
             VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to open " << path.str();
             return;
         }
-        file.write(reinterpret_cast<const char*>(write_ptr),
-                   static_cast<std::streamsize>(write_size));
+        file.write(reinterpret_cast<const char*>(pixels.data()),
+                   static_cast<std::streamsize>(pixels.size()));
         VP_LOG_STREAM_INFO(CLIENT) << "[WSI] Wrote frame to " << path.str();
     }
 
     void shutdown() override {
+        if (sink_) {
+            sink_->finish();
+            sink_.reset();
+        }
+        images_.clear();
         VP_LOG_STREAM_INFO(CLIENT) << "[WSI] Headless WSI shutdown";
     }
 
@@ -97,7 +100,10 @@ private:
     uint32_t width_ = 0;
     uint32_t height_ = 0;
     uint32_t image_count_ = 0;
+    uint32_t stride_ = 0;
     VkFormat format_ = VK_FORMAT_UNDEFINED;
+    std::vector<std::vector<uint8_t>> images_;
+    std::unique_ptr<BenchmarkFrameSink> sink_;
 };
 
 } // namespace
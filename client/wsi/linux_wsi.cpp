@@ -8,6 +8,7 @@
 
 #include "wsi/platform_wsi.h"
 #include "wsi/linux_surface.h"
+#include "wsi/frame_decoder.h"
 #include "utils/logging.h"
 
 #include <algorithm>
@@ -47,41 +48,6 @@ namespace venus_plus {
 
 namespace {
 
-bool decompress_rle(const VenusFrameHeader& frame,
-                    const uint8_t* data,
-                    std::vector<uint8_t>* output) {
-    if (!data || !output) {
-        return false;
-    }
-    output->clear();
-    size_t offset = 0;
-    while (offset < frame.payload_size) {
-        if (offset + 2 > frame.payload_size) {
-            return false;
-        }
-        uint8_t tag = data[offset++];
-        uint8_t count = data[offset++];
-        if (tag == 1) {
-            if (offset >= frame.payload_size) {
-                return false;
-            }
-            uint8_t value = data[offset++];
-            output->insert(output->end(), count, value);
-        } else {
-            if (offset + count > frame.payload_size) {
-                return false;
-            }
-            output->insert(output->end(), data + offset, data + offset + count);
-            offset += count;
-        }
-    }
-    if (frame.uncompressed_size != 0 &&
-        output->size() != frame.uncompressed_size) {
-        return false;
-    }
-    return true;
-}
-
 uint32_t bytes_per_pixel(VkFormat format) {
     switch (format) {
         case VK_FORMAT_B8G8R8A8_UNORM:
@@ -97,25 +63,6 @@ uint32_t clamp_stride(uint32_t width, VkFormat format) {
     return width * bytes_per_pixel(format);
 }
 
-bool copy_rows(uint8_t* dst,
-               uint32_t dst_stride,
-               const uint8_t* src,
-               uint32_t src_stride,
-               uint32_t width,
-               uint32_t height,
-               VkFormat format) {
-    if (!dst || !src) {
-        return false;
-    }
-    uint32_t row_bytes = clamp_stride(width, format);
-    for (uint32_t y = 0; y < height; ++y) {
-        const uint8_t* src_row = src + static_cast<size_t>(y) * src_stride;
-        uint8_t* dst_row = dst + static_cast<size_t>(y) * dst_stride;
-        std::memcpy(dst_row, src_row, row_bytes);
-    }
-    return true;
-}
-
 constexpr uint32_t kMinRenderNode = 128;
 constexpr uint32_t kMaxRenderNode = 191;
 
@@ -185,9 +132,10 @@ public:
                       uint32_t height,
                       VkFormat format,
                       uint32_t image_count) = 0;
-    virtual void present(const VenusFrameHeader& frame,
-                         const uint8_t* data,
-                         uint32_t stride) = 0;
+    // Waits for the buffer backing |frame.image_index| and exposes its mapping.
+    virtual bool acquire_target(const VenusFrameHeader& frame, WsiFrameTarget* target) = 0;
+    // Presents the buffer filled since acquire_target(), or just releases it.
+    virtual void release_target(const VenusFrameHeader& frame, bool present) = 0;
     virtual void shutdown() = 0;
 };
 
@@ -249,20 +197,28 @@ public:
         return true;
     }
 
-    void present(const VenusFrameHeader& frame,
-                 const uint8_t* data,
-                 uint32_t stride) override {
-        if (!conn_ || buffers_.empty() || !data) {
-            return;
+    bool acquire_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!conn_ || buffers_.empty() || !target) {
+            return false;
         }
         process_events(false);
         Buffer& buf = buffers_[frame.image_index % buffers_.size()];
         wait_for_buffer(buf);
         if (!buf.mapped && !remap_buffer(buf)) {
+            return false;
+        }
+        target->pixels = static_cast<uint8_t*>(buf.mapped);
+        target->stride = buf.stride;
+        target->width = width_;
+        target->height = height_;
+        return true;
+    }
+
+    void release_target(const VenusFrameHeader& frame, bool present) override {
+        if (!conn_ || buffers_.empty() || !present) {
             return;
         }
-        copy_rows(static_cast<uint8_t*>(buf.mapped), buf.stride,
-                  data, stride, width_, height_, format_);
+        Buffer& buf = buffers_[frame.image_index % buffers_.size()];
         if (buf.mapped && buf.map_data) {
             gbm_bo_unmap(buf.bo, buf.map_data);
             buf.mapped = nullptr;
@@ -458,16 +414,23 @@ public:
         return true;
     }
 
-    void present(const VenusFrameHeader& frame,
-                 const uint8_t* data,
-                 uint32_t stride) override {
-        if (!conn_ || buffers_.empty() || !data) {
-            return;
+    bool acquire_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!conn_ || buffers_.empty() || !target) {
+            return false;
         }
         CpuBuffer& buf = buffers_[frame.image_index % buffers_.size()];
-        copy_rows(buf.pixels.data(), stride_, data, stride,
-                  width_, height_, VK_FORMAT_B8G8R8A8_UNORM);
+        target->pixels = buf.pixels.data();
+        target->stride = stride_;
+        target->width = width_;
+        target->height = height_;
+        return true;
+    }
 
+    void release_target(const VenusFrameHeader& frame, bool present) override {
+        if (!conn_ || buffers_.empty() || !present) {
+            return;
+        }
+        CpuBuffer& buf = buffers_[frame.image_index % buffers_.size()];
         const uint32_t data_size = stride_ * height_;
         xcb_put_image(conn_, XCB_IMAGE_FORMAT_Z_PIXMAP,
                       window_, gc_, width_, height_,
@@ -536,19 +499,24 @@ public:
         return true;
     }
 
-    void present(const VenusFrameHeader& frame,
-                 const uint8_t* data,
-                 uint32_t stride) override {
-        if (!display_ || !surface_ || buffers_.empty() || !data) {
-            return;
+    bool acquire_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!display_ || !surface_ || buffers_.empty() || !target) {
+            return false;
         }
-
         ShmBuffer& buf = buffers_[frame.image_index % buffers_.size()];
         wait_for_buffer(buf);
+        target->pixels = static_cast<uint8_t*>(buf.data);
+        target->stride = buf.stride;
+        target->width = width_;
+        target->height = height_;
+        return true;
+    }
 
-        copy_rows(static_cast<uint8_t*>(buf.data), buf.stride,
-                  data, stride, width_, height_, VK_FORMAT_B8G8R8A8_UNORM);
-
+    void release_target(const VenusFrameHeader& frame, bool present) override {
+        if (!display_ || !surface_ || buffers_.empty() || !present) {
+            return;
+        }
+        ShmBuffer& buf = buffers_[frame.image_index % buffers_.size()];
         buf.busy = true;
         wl_surface_attach(surface_, buf.buffer, 0, 0);
         wl_surface_damage_buffer(surface_, 0, 0, width_, height_);
@@ -775,20 +743,28 @@ public:
         return true;
     }
 
-    void present(const VenusFrameHeader& frame,
-                 const uint8_t* data,
-                 uint32_t stride) override {
-        if (!surface_ || !display_ || buffers_.empty()) {
-            return;
+    bool acquire_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!surface_ || !display_ || buffers_.empty() || !target) {
+            return false;
         }
         flush_events();
         Buffer& buf = buffers_[frame.image_index % buffers_.size()];
         wait_for_buffer(buf);
         if (!buf.mapped && !remap_buffer(buf)) {
+            return false;
+        }
+        target->pixels = static_cast<uint8_t*>(buf.mapped);
+        target->stride = buf.stride;
+        target->width = width_;
+        target->height = height_;
+        return true;
+    }
+
+    void release_target(const VenusFrameHeader& frame, bool present) override {
+        if (!surface_ || !display_ || buffers_.empty() || !present) {
             return;
         }
-        copy_rows(static_cast<uint8_t*>(buf.mapped), buf.stride,
-                  data, stride, width_, height_, format_);
+        Buffer& buf = buffers_[frame.image_index % buffers_.size()];
         if (buf.mapped && buf.map_data) {
             gbm_bo_unmap(buf.bo, buf.map_data);
             buf.mapped = nullptr;
@@ -1011,31 +987,34 @@ public:
         if (!backend_ || !data) {
             return;
         }
-
-        const uint8_t* payload = data;
-        size_t payload_size = frame.payload_size;
-        if (frame.compression == FrameCompressionType::RLE) {
-            if (!decompress_rle(frame, data, &decode_buffer_)) {
-                VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to decode frame";
-                return;
-            }
-            payload = decode_buffer_.data();
-            payload_size = decode_buffer_.size();
-        } else if (frame.compression != FrameCompressionType::NONE) {
+        if (frame.compression != FrameCompressionType::NONE &&
+            frame.compression != FrameCompressionType::RLE) {
             VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Unsupported compression";
             return;
         }
 
-        uint32_t stride = frame.stride;
-        if (stride == 0) {
-            stride = clamp_stride(frame.width, format_);
-        }
-        if (payload_size < static_cast<size_t>(stride) * frame.height) {
-            VP_LOG_STREAM_WARN(CLIENT) << "[WSI] Frame payload shorter than expected";
+        WsiFrameTarget target;
+        if (!acquire_frame_target(frame, &target)) {
             return;
         }
+        const bool decoded = decode_frame_into(frame, data, target);
+        if (!decoded) {
+            VP_LOG_STREAM_ERROR(CLIENT) << "[WSI] Failed to decode frame";
+        }
+        release_frame_target(frame, decoded);
+    }
 
-        backend_->present(frame, payload, stride);
+    bool acquire_frame_target(const VenusFrameHeader& frame, WsiFrameTarget* target) override {
+        if (!backend_) {
+            return false;
+        }
+        return backend_->acquire_target(frame, target);
+    }
+
+    void release_frame_target(const VenusFrameHeader& frame, bool present) override {
+        if (backend_) {
+            backend_->release_target(frame, present);
+        }
     }
 
     void shutdown() override {
@@ -1111,7 +1090,6 @@ private:
     uint32_t height_ = 0;
     VkFormat format_ = VK_FORMAT_UNDEFINED;
     uint32_t image_count_ = 0;
-    std::vector<uint8_t> decode_buffer_;
 };
 
 } // namespace
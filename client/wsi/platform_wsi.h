@@ -1,6 +1,7 @@
 #ifndef VENUS_PLUS_PLATFORM_WSI_H
 #define VENUS_PLUS_PLATFORM_WSI_H
 
+#include <cstddef>
 #include <memory>
 #include <vulkan/vulkan.h>
 
@@ -8,6 +9,16 @@
 
 namespace venus_plus {
 
+// Destination storage for one presented frame (shm/dmabuf mapping, pixmap
+// staging, ...). Rows are |stride| bytes apart; |width| x |height| pixels of
+// 4 bytes each are writable.
+struct WsiFrameTarget {
+    uint8_t* pixels = nullptr;
+    uint32_t stride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
 class PlatformWSI {
 public:
     virtual ~PlatformWSI() = default;
@@ -15,6 +26,22 @@ public:
     virtual bool init(const VkSwapchainCreateInfoKHR& info, uint32_t image_count) = 0;
     virtual void handle_frame(const VenusFrameHeader& frame, const uint8_t* data) = 0;
     virtual void shutdown() = 0;
+
+    // Zero-copy present path: hands out the buffer the next frame should be
+    // received/decoded into. Every successful acquire must be paired with
+    // release_frame_target(); |present| is false when filling the target
+    // failed and the buffer should be recycled without being shown.
+    // Backends without directly writable storage keep the default and are fed
+    // through handle_frame() instead.
+    virtual bool acquire_frame_target(const VenusFrameHeader& frame, WsiFrameTarget* target) {
+        (void)frame;
+        (void)target;
+        return false;
+    }
+    virtual void release_frame_target(const VenusFrameHeader& frame, bool present) {
+        (void)frame;
+        (void)present;
+    }
 };
 
 std::shared_ptr<PlatformWSI> create_platform_wsi(VkSurfaceKHR surface);
@@ -109,6 +109,52 @@ bool NetworkClient::receive(std::vector<uint8_t>& buffer) {
     return true;
 }
 
+bool NetworkClient::receive_header(uint32_t* payload_size) {
+    if (fd_ < 0) {
+        NETWORK_LOG_ERROR() << "Not connected";
+        return false;
+    }
+    if (!payload_size) {
+        return false;
+    }
+
+    MessageHeader header;
+    if (!read_all(fd_, &header, sizeof(header))) {
+        return false;
+    }
+
+    if (header.magic != MESSAGE_MAGIC) {
+        NETWORK_LOG_ERROR() << "Invalid message magic";
+        return false;
+    }
+
+    *payload_size = header.size;
+    return true;
+}
+
+bool NetworkClient::receive_payload(void* data, size_t size) {
+    if (fd_ < 0) {
+        NETWORK_LOG_ERROR() << "Not connected";
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    return read_all(fd_, data, size);
+}
+
+bool NetworkClient::skip_payload(size_t size) {
+    uint8_t scratch[4096];
+    while (size > 0) {
+        size_t chunk = size < sizeof(scratch) ? size : sizeof(scratch);
+        if (!receive_payload(scratch, chunk)) {
+            return false;
+        }
+        size -= chunk;
+    }
+    return true;
+}
+
 void NetworkClient::disconnect() {
     if (fd_ >= 0) {
         close(fd_);
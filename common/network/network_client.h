@@ -21,6 +21,13 @@ public:
     // Receive message
     bool receive(std::vector<uint8_t>& buffer);
 
+    // Streaming receive: read the next message header, then drain exactly
+    // |payload_size| bytes with one or more receive_payload() calls. Lets
+    // callers place large payloads directly into their final destination.
+    bool receive_header(uint32_t* payload_size);
+    bool receive_payload(void* data, size_t size);
+    bool skip_payload(size_t size);
+
     // Disconnect
     void disconnect();
 
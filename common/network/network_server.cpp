@@ -7,7 +7,9 @@
 #include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstring>
+#include <thread>
 
 #include "utils/logging.h"
 
@@ -66,7 +68,7 @@ bool NetworkServer::start(uint16_t port, const std::string& bind_addr) {
     return true;
 }
 
-void NetworkServer::run(ClientHandler handler) {
+void NetworkServer::run(SessionFactory factory) {
     while (running_) {
         // Accept client
         struct sockaddr_in client_addr;
@@ -88,9 +90,15 @@ void NetworkServer::run(ClientHandler handler) {
         inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
         NETWORK_LOG_INFO() << "Client connected from " << client_ip;
 
-        // Handle client (inline for Phase 1, will thread later)
-        handle_client(client_fd, handler);
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex_);
+            session_fds_.push_back(client_fd);
+        }
+        std::thread(&NetworkServer::serve_session, this, client_fd, factory).detach();
     }
+
+    std::unique_lock<std::mutex> lock(sessions_mutex_);
+    sessions_cv_.wait(lock, [this] { return session_fds_.empty(); });
 }
 
 void NetworkServer::stop() {
@@ -99,6 +107,30 @@ void NetworkServer::stop() {
         close(server_fd_);
         server_fd_ = -1;
     }
+    // Unblock the connection threads; they close their sockets themselves.
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    for (int fd : session_fds_) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void NetworkServer::serve_session(int client_fd, SessionFactory factory) {
+    {
+        ClientHandler handler = factory(client_fd);
+        if (handler) {
+            handle_client(client_fd, handler);
+        }
+        // The handler (and the session it owns) goes away here, before the
+        // server is told the connection is finished.
+    }
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        session_fds_.erase(std::remove(session_fds_.begin(), session_fds_.end(), client_fd),
+                           session_fds_.end());
+        // Closed under the lock so stop() never shuts down a reused fd.
+        close(client_fd);
+    }
+    sessions_cv_.notify_all();
 }
 
 void NetworkServer::handle_client(int client_fd, ClientHandler handler) {
@@ -130,7 +162,6 @@ void NetworkServer::handle_client(int client_fd, ClientHandler handler) {
     }
 
     NETWORK_LOG_INFO() << "Client disconnected";
-    close(client_fd);
 }
 
 bool NetworkServer::send_to_client(int client_fd, const void* data, size_t size) {
@@ -151,4 +182,29 @@ bool NetworkServer::send_to_client(int client_fd, const void* data, size_t size)
     return true;
 }
 
+bool NetworkServer::send_segments_to_client(int client_fd,
+                                            const SendSegment* segments,
+                                            size_t segment_count) {
+    size_t total = 0;
+    for (size_t i = 0; i < segment_count; ++i) {
+        total += segments[i].size;
+    }
+
+    MessageHeader header;
+    header.magic = MESSAGE_MAGIC;
+    header.size = total;
+
+    if (!write_all(client_fd, &header, sizeof(header))) {
+        return false;
+    }
+
+    for (size_t i = 0; i < segment_count; ++i) {
+        if (segments[i].size > 0 && !write_all(client_fd, segments[i].data, segments[i].size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 } // namespace venus_plus
@@ -1,9 +1,12 @@
 #ifndef VENUS_PLUS_NETWORK_SERVER_H
 #define VENUS_PLUS_NETWORK_SERVER_H
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <string>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 namespace venus_plus {
@@ -13,6 +16,17 @@ namespace venus_plus {
 // Returns: true to continue, false to disconnect client
 using ClientHandler = std::function<bool(int, const void*, size_t)>;
 
+// Called on a new connection's own thread before its first message; returns
+// the handler for that connection. Whatever the handler captures lives until
+// the connection closes, so per-client state is created here.
+using SessionFactory = std::function<ClientHandler(int)>;
+
+// One piece of a reply sent with send_segments_to_client().
+struct SendSegment {
+    const void* data;
+    size_t size;
+};
+
 class NetworkServer {
 public:
     NetworkServer();
@@ -21,8 +35,9 @@ public:
     // Start server
     bool start(uint16_t port, const std::string& bind_addr = "0.0.0.0");
 
-    // Run server (blocks until stopped)
-    void run(ClientHandler handler);
+    // Run server (blocks until stopped). Every connection is served by its
+    // own thread; returns once all of them have closed.
+    void run(SessionFactory factory);
 
     // Stop server
     void stop();
@@ -30,11 +45,22 @@ public:
     // Send message to client
     static bool send_to_client(int client_fd, const void* data, size_t size);
 
+    // Send one message whose payload is the concatenation of |segments|,
+    // without assembling it in memory first
+    static bool send_segments_to_client(int client_fd,
+                                        const SendSegment* segments,
+                                        size_t segment_count);
+
 private:
     void handle_client(int client_fd, ClientHandler handler);
+    void serve_session(int client_fd, SessionFactory factory);
 
     int server_fd_;
-    bool running_;
+    std::atomic<bool> running_;
+
+    std::mutex sessions_mutex_;
+    std::condition_variable sessions_cv_;
+    std::vector<int> session_fds_;
 };
 
 } // namespace venus_plus
@@ -0,0 +1,42 @@
+#ifndef VENUS_PLUS_CLIENT_HANDLES_PROTOCOL_H
+#define VENUS_PLUS_CLIENT_HANDLES_PROTOCOL_H
+
+#include <cstdint>
+
+namespace venus_plus {
+
+// Handles the client picks itself so an allocation needs no reply. The client
+// passes them in the output array of the allocating command (e.g.
+// pDescriptorSets of vkAllocateDescriptorSets) and keeps using them; the
+// server tracks the object under its own handle and maps the client's onto
+// it. Handles are laid out like the server's slot map handles:
+//
+//   [63:56] tag   [55:32] generation   [31:0] index
+//
+// The top byte never matches a server handle tag. The client reuses the
+// indices of freed objects under a new generation, so indices stay dense and
+// the server can keep the mapping in an array (server/state/client_handle_table.h).
+namespace client_handle_tag {
+constexpr uint8_t kDescriptorSet = 0x9b;
+} // namespace client_handle_tag
+
+constexpr uint32_t kClientHandleMaxGeneration = 0xffffffu;
+// Indices past this are refused, which bounds the server's table.
+constexpr uint32_t kClientHandleMaxIndex = 1u << 24;
+
+inline uint64_t make_client_handle(uint8_t tag, uint32_t generation, uint32_t index) {
+    return (static_cast<uint64_t>(tag) << 56) |
+           (static_cast<uint64_t>(generation & kClientHandleMaxGeneration) << 32) | index;
+}
+
+inline uint32_t client_handle_index(uint64_t handle) {
+    return static_cast<uint32_t>(handle);
+}
+
+inline bool is_client_handle(uint64_t handle, uint8_t tag) {
+    return static_cast<uint8_t>(handle >> 56) == tag;
+}
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_CLIENT_HANDLES_PROTOCOL_H
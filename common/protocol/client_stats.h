@@ -0,0 +1,39 @@
+#ifndef VENUS_PLUS_CLIENT_STATS_H
+#define VENUS_PLUS_CLIENT_STATS_H
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+namespace venus_plus {
+
+// Counters of the ICD's client-side optimizations, for tests and tools.
+// Not a Vulkan extension: fetch the entry point with
+// vkGetDeviceProcAddr(device, kGetClientStatsName); the loader passes names it
+// does not know through to the ICD. Counters are process-wide.
+struct ClientStats {
+    uint64_t state_filter_checked;
+    uint64_t state_filter_elided;
+    uint64_t replay_recordings;
+    uint64_t replay_hits;
+    uint64_t replay_misses;
+    uint64_t deferred_recordings;
+    uint64_t deferred_uploads;
+    uint64_t shader_store_hits; // modules created without sending their code
+    uint64_t caps_cache_loaded; // physical-device replies read from cache files
+    uint64_t caps_cache_hits;
+    uint64_t caps_cache_misses;
+    uint64_t descriptor_sets_local;   // allocated without waiting for the server
+    uint64_t descriptor_pool_refusals; // OUT_OF_POOL_MEMORY from the tracked budget
+    uint64_t staged_memory_transfers;  // mapped-memory writes and reads of staged types
+    uint64_t memory_requirements_hits; // vkGet*MemoryRequirements answered without the server
+    uint64_t memory_requirements_misses;
+    uint64_t inline_uploads; // vkCmdUpdateBuffer calls sent as inline upload regions
+};
+
+constexpr const char* kGetClientStatsName = "vkGetClientStatsVENUSPLUS";
+
+typedef void(VKAPI_PTR* PFN_vkGetClientStatsVENUSPLUS)(VkDevice device, ClientStats* stats);
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_CLIENT_STATS_H
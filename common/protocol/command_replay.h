@@ -0,0 +1,42 @@
+#ifndef VENUS_PLUS_COMMAND_REPLAY_PROTOCOL_H
+#define VENUS_PLUS_COMMAND_REPLAY_PROTOCOL_H
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "frame_transfer.h"
+
+namespace venus_plus {
+
+// Stands in for vkBeginCommandBuffer..vkEndCommandBuffer when the client
+// re-recorded a command buffer with the same encoded stream as last time.
+// The server keeps its real command buffer as recorded then. The reply is a
+// VkResult: VK_SUCCESS when that recording is still executable, anything else
+// and the client sends the full stream instead. With
+// VENUS_PLUS_REUSE_RECORDING_NO_REPLY there is no reply; a recording that is no
+// longer executable fails the submit that follows.
+enum ReuseRecordingFlags : uint32_t {
+    VENUS_PLUS_REUSE_RECORDING_NO_REPLY = 1u << 0,
+};
+
+struct ReuseRecordingRequest {
+    uint32_t command;         // VenusPlusCommandType
+    uint32_t flags;           // ReuseRecordingFlags
+    uint64_t command_buffer;  // remote VkCommandBuffer handle
+    uint64_t stream_hash;     // hash of the encoded stream, for logging
+};
+
+// Sent ahead of a recording's stream when the client did not forward the
+// reset of the command buffer since its last recording (it kept that one as
+// a replay candidate). The begin in the stream then resets the server's
+// buffer implicitly; without this marker, beginning an executable or invalid
+// buffer fails as it would on a real driver. No reply.
+struct ResetElidedRequest {
+    uint32_t command;         // VenusPlusCommandType
+    uint32_t reserved;
+    uint64_t command_buffer;  // remote VkCommandBuffer handle
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_COMMAND_REPLAY_PROTOCOL_H
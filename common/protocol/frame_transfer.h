@@ -16,6 +16,13 @@ enum VenusPlusCommandType : uint32_t {
     VENUS_PLUS_CMD_DESTROY_SWAPCHAIN    = 0x10000011u,
     VENUS_PLUS_CMD_ACQUIRE_IMAGE        = 0x10000012u,
     VENUS_PLUS_CMD_PRESENT              = 0x10000013u,
+    VENUS_PLUS_CMD_PRESENT_BATCH        = 0x10000014u,
+
+    VENUS_PLUS_CMD_REUSE_RECORDING      = 0x10000020u,
+    VENUS_PLUS_CMD_RESET_ELIDED         = 0x10000021u,
+
+    VENUS_PLUS_CMD_CREATE_SHADER_MODULE           = 0x10000030u,
+    VENUS_PLUS_CMD_CREATE_SHADER_MODULE_WITH_CODE = 0x10000031u,
 };
 
 static constexpr uint32_t kVenusMaxSwapchainImages = 8;
@@ -62,10 +69,18 @@ struct VenusSwapchainAcquireReply {
     uint32_t image_index;
 };
 
+// Encoder effort requested by the client's frame pacing policy.
+enum class FrameCodecLevel : uint32_t {
+    AUTO = 0,  // RLE when it shrinks the frame
+    RAW = 1,   // never compress; cheapest for a busy server
+    LOSSY = 2, // drop the two low bits of every channel before RLE; smallest payload
+};
+
 struct VenusSwapchainPresentRequest {
     uint32_t command;      // VenusPlusCommandType
     uint32_t swapchain_id;
     uint32_t image_index;
+    FrameCodecLevel codec_level;
 };
 
 static constexpr uint32_t kVenusFrameMagic = 0x56504652u; // "VPFR"
@@ -91,9 +106,39 @@ struct VenusFrameHeader {
 struct VenusSwapchainPresentReply {
     VkResult result;
     VenusFrameHeader frame;
+    uint32_t server_time_us; // readback + encode time, lets the client isolate transfer cost
     // Followed by |payload_size| bytes if result == VK_SUCCESS.
 };
 
+// vkQueuePresentKHR with several swapchains travels as one message. Layout:
+//   VenusSwapchainPresentBatchHeader
+//   VenusSwapchainPresentEntry[present_count]
+//   uint64_t wait_semaphores[wait_semaphore_count] // remote VkSemaphore handles
+static constexpr uint32_t kVenusMaxBatchPresents = 16;
+
+struct VenusSwapchainPresentBatchHeader {
+    uint32_t command;      // VenusPlusCommandType
+    uint32_t present_count;
+    uint32_t wait_semaphore_count;
+    uint32_t reserved0;
+};
+
+struct VenusSwapchainPresentEntry {
+    uint32_t swapchain_id;
+    uint32_t image_index;
+    FrameCodecLevel codec_level;
+    uint32_t reserved0;
+};
+
+// Reply layout:
+//   VenusSwapchainPresentBatchReplyHeader
+//   present_count x { VenusSwapchainPresentReply, frame payload }
+// Entries come back in request order; a failed entry carries no payload.
+struct VenusSwapchainPresentBatchReplyHeader {
+    VkResult result;
+    uint32_t present_count;
+};
+
 } // namespace venus_plus
 
 #endif // VENUS_PLUS_FRAME_TRANSFER_PROTOCOL_H
@@ -0,0 +1,26 @@
+#ifndef VENUS_PLUS_INLINE_UPLOAD_PROTOCOL_H
+#define VENUS_PLUS_INLINE_UPLOAD_PROTOCOL_H
+
+/* Included by the C decoder as well. */
+
+/*
+ * Stands in for vkCmdUpdateBuffer calls recorded back to back into one
+ * command buffer. Unlike the VenusPlusCommandType messages it travels inside
+ * the Venus command stream, encoded like any vkCmd*:
+ *
+ *   type, flags (0), commandBuffer, uint32_t region_count,
+ *   region_count x { dstBuffer, dstOffset, dataSize, dataSize bytes of data }
+ *
+ * dataSize follows the vkCmdUpdateBuffer rules. The server copies the data
+ * into staging memory owned by the command buffer and records it as
+ * vkCmdCopyBuffer, one per run of regions with the same destination.
+ */
+#define VENUS_PLUS_CMD_INLINE_UPLOAD 0x10000040u
+
+/* Where region_count sits in the command. */
+#define VENUS_PLUS_INLINE_UPLOAD_COUNT_OFFSET 16u
+
+/* Regions are added to one command while it stays within this size. */
+#define VENUS_PLUS_INLINE_UPLOAD_MAX_COMMAND_SIZE (256u * 1024u)
+
+#endif /* VENUS_PLUS_INLINE_UPLOAD_PROTOCOL_H */
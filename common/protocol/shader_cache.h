@@ -0,0 +1,33 @@
+#ifndef VENUS_PLUS_SHADER_CACHE_PROTOCOL_H
+#define VENUS_PLUS_SHADER_CACHE_PROTOCOL_H
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+#include "frame_transfer.h"
+
+namespace venus_plus {
+
+// Stands in for vkCreateShaderModule. VENUS_PLUS_CMD_CREATE_SHADER_MODULE
+// names the SPIR-V by its SHA-256 only; the server answers VK_INCOMPLETE when
+// it has never seen that code and the client repeats the request as
+// VENUS_PLUS_CMD_CREATE_SHADER_MODULE_WITH_CODE, with code_size bytes of
+// SPIR-V following the header. The server checks the hash of uploaded code
+// before keeping it.
+struct CreateShaderModuleRequest {
+    uint32_t command;       // VenusPlusCommandType
+    uint32_t flags;         // VkShaderModuleCreateFlags
+    uint64_t device;        // remote VkDevice handle
+    uint64_t code_size;     // bytes, a multiple of 4
+    uint8_t code_hash[32];  // SHA-256 of the code
+};
+
+struct CreateShaderModuleReply {
+    VkResult result;        // VK_INCOMPLETE: send the code
+    uint32_t reserved0;
+    uint64_t shader_module; // remote VkShaderModule handle on VK_SUCCESS
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SHADER_CACHE_PROTOCOL_H
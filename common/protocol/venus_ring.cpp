@@ -1,5 +1,7 @@
 #include "vn_ring.h"
 
+#include <cstring>
+
 #include "network/network_client.h"
 #include "utils/logging.h"
 
@@ -9,6 +11,7 @@ using namespace venus_plus;
 
 namespace {
 constexpr size_t kMaxPendingBytes = 256 * 1024; // prevent unbounded buffering
+constexpr size_t kCaptureHeaderSize = 2 * sizeof(uint32_t) + sizeof(uint64_t);
 }
 
 vn_cs_encoder* vn_ring_submit_command_init(struct vn_ring* ring,
@@ -40,12 +43,102 @@ void vn_ring_submit_command(struct vn_ring* ring, struct vn_ring_submit_command*
     }
 
     const uint8_t* bytes = static_cast<const uint8_t*>(submit->cmd_data);
-    ring->pending_buffer.insert(ring->pending_buffer.end(), bytes, bytes + payload_size);
+    if (!submit->reply_size && payload_size >= kCaptureHeaderSize) {
+        // Type and flags, then the first argument's handle.
+        uint64_t handle = 0;
+        std::memcpy(&handle, bytes + 2 * sizeof(uint32_t), sizeof(handle));
+        std::lock_guard<std::mutex> lock(ring->capture_mutex);
+        auto it = ring->captures.find(handle);
+        if (it != ring->captures.end()) {
+            it->second.stream.insert(it->second.stream.end(), bytes, bytes + payload_size);
+            return;
+        }
+    }
+    vn_ring_submit_encoded(ring, bytes, payload_size);
+}
+
+void vn_ring_submit_encoded(struct vn_ring* ring, const uint8_t* data, size_t size) {
+    if (!ring || !data || !size)
+        return;
+
+    ring->pending_buffer.insert(ring->pending_buffer.end(), data, data + size);
     if (ring->pending_buffer.size() >= kMaxPendingBytes) {
         vn_ring_flush_pending(ring);
     }
 }
 
+void vn_ring_begin_capture(struct vn_ring* ring, uint64_t command_buffer) {
+    if (!ring)
+        return;
+
+    std::lock_guard<std::mutex> lock(ring->capture_mutex);
+    ring->captures[command_buffer] = vn_ring_capture();
+}
+
+void vn_ring_end_capture(struct vn_ring* ring, uint64_t command_buffer, std::vector<uint8_t>* out) {
+    if (!ring)
+        return;
+
+    std::lock_guard<std::mutex> lock(ring->capture_mutex);
+    auto it = ring->captures.find(command_buffer);
+    if (it == ring->captures.end()) {
+        if (out)
+            out->clear();
+        return;
+    }
+    if (out)
+        *out = std::move(it->second.stream);
+    ring->captures.erase(it);
+}
+
+bool vn_ring_capture_extendable(struct vn_ring* ring,
+                                uint64_t command_buffer,
+                                const void* data,
+                                size_t size,
+                                size_t count_offset) {
+    if (!ring || !data || count_offset + sizeof(uint32_t) > size)
+        return false;
+
+    std::lock_guard<std::mutex> lock(ring->capture_mutex);
+    auto it = ring->captures.find(command_buffer);
+    if (it == ring->captures.end())
+        return false;
+    vn_ring_capture& capture = it->second;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    capture.extendable_start = capture.stream.size();
+    capture.stream.insert(capture.stream.end(), bytes, bytes + size);
+    capture.extendable_end = capture.stream.size();
+    capture.extendable_count_offset = capture.extendable_start + count_offset;
+    return true;
+}
+
+bool vn_ring_extend_capture(struct vn_ring* ring,
+                            uint64_t command_buffer,
+                            const void* data,
+                            size_t size,
+                            size_t max_command_size) {
+    if (!ring || !data)
+        return false;
+
+    std::lock_guard<std::mutex> lock(ring->capture_mutex);
+    auto it = ring->captures.find(command_buffer);
+    if (it == ring->captures.end())
+        return false;
+    vn_ring_capture& capture = it->second;
+    if (capture.extendable_end == 0 || capture.extendable_end != capture.stream.size() ||
+        capture.extendable_end - capture.extendable_start + size > max_command_size)
+        return false;
+
+    uint32_t count = 0;
+    std::memcpy(&count, capture.stream.data() + capture.extendable_count_offset, sizeof(count));
+    ++count;
+    std::memcpy(capture.stream.data() + capture.extendable_count_offset, &count, sizeof(count));
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    capture.stream.insert(capture.stream.end(), bytes, bytes + size);
+    capture.extendable_end = capture.stream.size();
+    return true;
+}
+
 void vn_ring_flush_pending(struct vn_ring* ring) {
     if (!ring || !ring->client)
         return;
@@ -61,6 +154,23 @@ void vn_ring_flush_pending(struct vn_ring* ring) {
     ring->pending_buffer.clear();
 }
 
+bool vn_ring_call_encoded(struct vn_ring* ring, const uint8_t* data, size_t size, std::vector<uint8_t>* reply) {
+    if (!ring || !ring->client || !data || !size || !reply)
+        return false;
+
+    ring->pending_buffer.insert(ring->pending_buffer.end(), data, data + size);
+    vn_ring_flush_pending(ring);
+    if (!ring->pending_buffer.empty()) {
+        CLIENT_LOG_ERROR() << "Pending buffer not cleared after flush";
+        return false;
+    }
+    if (!ring->client->receive(*reply)) {
+        CLIENT_LOG_ERROR() << "Failed to receive Venus reply";
+        return false;
+    }
+    return true;
+}
+
 vn_cs_decoder* vn_ring_get_command_reply(struct vn_ring* ring, struct vn_ring_submit_command* submit) {
     if (!ring || !submit || !ring->client)
         return nullptr;
@@ -0,0 +1,134 @@
+#include "utils/format_info.h"
+
+namespace venus_plus {
+
+namespace {
+
+bool in_range(VkFormat format, VkFormat first, VkFormat last) {
+    return format >= first && format <= last;
+}
+
+FormatBlock block(uint32_t size, uint32_t width = 1, uint32_t height = 1) {
+    FormatBlock result;
+    result.size = size;
+    result.width = width;
+    result.height = height;
+    return result;
+}
+
+// ASTC footprints in enum order; UNORM/SRGB come in pairs, SFLOAT singly.
+constexpr uint32_t kAstcFootprints[][2] = {
+    {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6},
+    {8, 8}, {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12},
+};
+
+bool uncompressed_block(VkFormat format, FormatBlock* out) {
+    if (format == VK_FORMAT_R4G4_UNORM_PACK8 || in_range(format, VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB) ||
+        format == VK_FORMAT_A8_UNORM) {
+        *out = block(1);
+    } else if (in_range(format, VK_FORMAT_R4G4B4A4_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16) ||
+               in_range(format, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB) ||
+               in_range(format, VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT) ||
+               format == VK_FORMAT_A4R4G4B4_UNORM_PACK16 || format == VK_FORMAT_A4B4G4R4_UNORM_PACK16 ||
+               format == VK_FORMAT_A1B5G5R5_UNORM_PACK16) {
+        *out = block(2);
+    } else if (in_range(format, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB)) {
+        *out = block(3);
+    } else if (in_range(format, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32) ||
+               in_range(format, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT) ||
+               in_range(format, VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT) ||
+               format == VK_FORMAT_B10G11R11_UFLOAT_PACK32 || format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32) {
+        *out = block(4);
+    } else if (in_range(format, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT)) {
+        *out = block(6);
+    } else if (in_range(format, VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT) ||
+               in_range(format, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT) ||
+               in_range(format, VK_FORMAT_R64_UINT, VK_FORMAT_R64_SFLOAT)) {
+        *out = block(8);
+    } else if (in_range(format, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT)) {
+        *out = block(12);
+    } else if (in_range(format, VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT) ||
+               in_range(format, VK_FORMAT_R64G64_UINT, VK_FORMAT_R64G64_SFLOAT)) {
+        *out = block(16);
+    } else if (in_range(format, VK_FORMAT_R64G64B64_UINT, VK_FORMAT_R64G64B64_SFLOAT)) {
+        *out = block(24);
+    } else if (in_range(format, VK_FORMAT_R64G64B64A64_UINT, VK_FORMAT_R64G64B64A64_SFLOAT)) {
+        *out = block(32);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool compressed_block(VkFormat format, FormatBlock* out) {
+    if (in_range(format, VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK) ||
+        in_range(format, VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC4_SNORM_BLOCK) ||
+        in_range(format, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK) ||
+        in_range(format, VK_FORMAT_EAC_R11_UNORM_BLOCK, VK_FORMAT_EAC_R11_SNORM_BLOCK)) {
+        *out = block(8, 4, 4);
+    } else if (in_range(format, VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK) ||
+               in_range(format, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK) ||
+               in_range(format, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK) ||
+               in_range(format, VK_FORMAT_EAC_R11G11_UNORM_BLOCK, VK_FORMAT_EAC_R11G11_SNORM_BLOCK)) {
+        *out = block(16, 4, 4);
+    } else if (in_range(format, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_12x12_SRGB_BLOCK)) {
+        const uint32_t* footprint = kAstcFootprints[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+        *out = block(16, footprint[0], footprint[1]);
+    } else if (in_range(format, VK_FORMAT_ASTC_4x4_SFLOAT_BLOCK, VK_FORMAT_ASTC_12x12_SFLOAT_BLOCK)) {
+        const uint32_t* footprint = kAstcFootprints[format - VK_FORMAT_ASTC_4x4_SFLOAT_BLOCK];
+        *out = block(16, footprint[0], footprint[1]);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Depth and stencil are copied one aspect at a time; packed depth takes four
+// bytes per texel except for 16-bit depth.
+bool depth_stencil_block(VkFormat format, VkImageAspectFlags aspect, FormatBlock* out) {
+    if (format < VK_FORMAT_D16_UNORM || format > VK_FORMAT_D32_SFLOAT_S8_UINT) {
+        return false;
+    }
+    if (format == VK_FORMAT_S8_UINT || aspect == VK_IMAGE_ASPECT_STENCIL_BIT) {
+        *out = block(1);
+    } else if (format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D16_UNORM_S8_UINT) {
+        *out = block(2);
+    } else {
+        *out = block(4);
+    }
+    return true;
+}
+
+} // namespace
+
+bool format_copy_block(VkFormat format, VkImageAspectFlags aspect, FormatBlock* out) {
+    if (!out) {
+        return false;
+    }
+    return depth_stencil_block(format, aspect, out) || uncompressed_block(format, out) ||
+           compressed_block(format, out);
+}
+
+VkDeviceSize image_copy_size(const FormatBlock& block,
+                             uint32_t row_length,
+                             uint32_t image_height,
+                             const VkExtent3D& extent,
+                             uint32_t layers) {
+    if (block.size == 0 || extent.width == 0 || extent.height == 0 || extent.depth == 0 || layers == 0) {
+        return 0;
+    }
+    const uint32_t row_texels = row_length ? row_length : extent.width;
+    const uint32_t image_rows = image_height ? image_height : extent.height;
+    const VkDeviceSize row_blocks = (row_texels + block.width - 1) / block.width;
+    const VkDeviceSize image_blocks = (image_rows + block.height - 1) / block.height;
+    const VkDeviceSize width_blocks = (extent.width + block.width - 1) / block.width;
+    const VkDeviceSize height_blocks = (extent.height + block.height - 1) / block.height;
+    const VkDeviceSize slices = static_cast<VkDeviceSize>(extent.depth) * layers;
+
+    // The last row of the last slice ends at the extent, not the row length.
+    const VkDeviceSize blocks =
+        (slices - 1) * row_blocks * image_blocks + (height_blocks - 1) * row_blocks + width_blocks;
+    return blocks * block.size;
+}
+
+} // namespace venus_plus
@@ -0,0 +1,32 @@
+#ifndef VENUS_PLUS_FORMAT_INFO_H
+#define VENUS_PLUS_FORMAT_INFO_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+namespace venus_plus {
+
+// One texel block as buffer and host image copies lay it out: |size| bytes
+// covering |width| x |height| texels.
+struct FormatBlock {
+    uint32_t size = 0;
+    uint32_t width = 1;
+    uint32_t height = 1;
+};
+
+// The block of |format|; for depth/stencil formats, of the plane |aspect|
+// names. False for formats not listed, such as multi-planar ones.
+bool format_copy_block(VkFormat format, VkImageAspectFlags aspect, FormatBlock* out);
+
+// Bytes a copy of |extent| texels over |layers| layers (or depth slices)
+// spans in memory, with rows |row_length| and images |image_height| texels
+// apart; 0 means tightly packed, as in VkBufferImageCopy.
+VkDeviceSize image_copy_size(const FormatBlock& block,
+                             uint32_t row_length,
+                             uint32_t image_height,
+                             const VkExtent3D& extent,
+                             uint32_t layers);
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_FORMAT_INFO_H
@@ -0,0 +1,361 @@
+#include "utils/log_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+namespace venus_plus {
+
+namespace {
+
+// Per-thread ring size; messages longer than a quarter of it go direct.
+constexpr size_t kRingCapacity = 64 * 1024;
+constexpr size_t kMaxRingMessage = kRingCapacity / 4;
+// How long the drain thread sleeps when nobody wakes it.
+constexpr auto kDrainInterval = std::chrono::milliseconds(10);
+// Marks the unused tail of the ring before a wrap; the low bits hold its size.
+constexpr uint32_t kPaddingFlag = 0x80000000u;
+
+struct RecordHeader {
+    uint32_t size;       // whole record including padding to 8 bytes
+    uint32_t length;     // message bytes following the header
+    int32_t line;
+    uint8_t level;
+    uint8_t category;
+    uint16_t reserved;
+    int64_t timestamp_ns;
+    const char* file;    // __FILE__ literal, outlives the record
+};
+
+struct PendingRecord {
+    RecordHeader header;
+    std::string message;
+};
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+const char* level_str(LogLevel level) {
+    switch (level) {
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::WARN:  return "WARN ";
+        case LogLevel::INFO:  return "INFO ";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::TRACE: return "TRACE";
+        default: return "?????";
+    }
+}
+
+const char* category_str(LogCategory cat) {
+    switch (cat) {
+        case LogCategory::GENERAL:  return "GENERAL ";
+        case LogCategory::NETWORK:  return "NETWORK ";
+        case LogCategory::CLIENT:   return "CLIENT  ";
+        case LogCategory::SERVER:   return "SERVER  ";
+        case LogCategory::PROTOCOL: return "PROTOCOL";
+        case LogCategory::VULKAN:   return "VULKAN  ";
+        case LogCategory::MEMORY:   return "MEMORY  ";
+        case LogCategory::SYNC:     return "SYNC    ";
+        default: return "????????";
+    }
+}
+
+void print_record(const RecordHeader& header, const char* message, size_t length) {
+    const time_t seconds = static_cast<time_t>(header.timestamp_ns / 1000000000);
+    const int ms = static_cast<int>((header.timestamp_ns / 1000000) % 1000);
+    tm local = {};
+    localtime_r(&seconds, &local);
+    char time_buf[32];
+    std::strftime(time_buf, sizeof(time_buf), "%H:%M:%S", &local);
+
+    const char* filename = std::strrchr(header.file, '/');
+    filename = filename ? filename + 1 : header.file;
+
+    std::fprintf(stderr, "[%s.%03d] [%s] [%s] %s:%d: %.*s\n",
+                 time_buf, ms,
+                 level_str(static_cast<LogLevel>(header.level)),
+                 category_str(static_cast<LogCategory>(header.category)),
+                 filename, header.line,
+                 static_cast<int>(length), message);
+}
+
+} // namespace
+
+struct LogSink::Ring {
+    alignas(64) std::atomic<uint64_t> head{0}; // written by the owning thread
+    alignas(64) std::atomic<uint64_t> tail{0}; // written by the drainer
+    std::atomic<bool> retired{false};          // owning thread has exited
+    std::unique_ptr<uint8_t[]> data{new uint8_t[kRingCapacity]};
+
+    // Producer side. Returns false when the record does not fit right now.
+    bool push(const RecordHeader& header_in, const char* message, size_t* used) {
+        RecordHeader header = header_in;
+        header.size = static_cast<uint32_t>((sizeof(RecordHeader) + header.length + 7) & ~size_t(7));
+
+        uint64_t h = head.load(std::memory_order_relaxed);
+        const uint64_t t = tail.load(std::memory_order_acquire);
+        size_t offset = static_cast<size_t>(h % kRingCapacity);
+        const size_t contiguous = kRingCapacity - offset;
+        const size_t needed = header.size + (header.size > contiguous ? contiguous : 0);
+        if (h + needed - t > kRingCapacity) {
+            return false;
+        }
+        if (header.size > contiguous) {
+            const uint32_t padding = kPaddingFlag | static_cast<uint32_t>(contiguous);
+            std::memcpy(data.get() + offset, &padding, sizeof(padding));
+            h += contiguous;
+            offset = 0;
+        }
+        std::memcpy(data.get() + offset, &header, sizeof(header));
+        std::memcpy(data.get() + offset + sizeof(header), message, header.length);
+        h += header.size;
+        head.store(h, std::memory_order_release);
+        *used = static_cast<size_t>(h - t);
+        return true;
+    }
+
+    // Consumer side; only called with the sink's drain mutex held.
+    void pop_all(std::vector<PendingRecord>* out) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        const uint64_t h = head.load(std::memory_order_acquire);
+        while (t < h) {
+            const size_t offset = static_cast<size_t>(t % kRingCapacity);
+            uint32_t size = 0;
+            std::memcpy(&size, data.get() + offset, sizeof(size));
+            if (size & kPaddingFlag) {
+                t += size & ~kPaddingFlag;
+                continue;
+            }
+            PendingRecord record;
+            std::memcpy(&record.header, data.get() + offset, sizeof(RecordHeader));
+            record.message.assign(reinterpret_cast<const char*>(data.get() + offset + sizeof(RecordHeader)),
+                                  record.header.length);
+            out->push_back(std::move(record));
+            t += size;
+        }
+        tail.store(t, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+namespace {
+
+struct ThreadRingHandle {
+    std::shared_ptr<LogSink::Ring> ring;
+    ~ThreadRingHandle() {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRingHandle t_ring;
+
+// Stops the drain thread before exit() or dlclose() tears down this image.
+struct LogSinkShutdown {
+    ~LogSinkShutdown() { LogSink::instance().shutdown(); }
+};
+
+LogSinkShutdown g_log_sink_shutdown;
+
+} // namespace
+
+LogSink& LogSink::instance() {
+    // Intentionally leaked so records logged from static destructors still
+    // have a sink; they are written directly after shutdown().
+    static LogSink* sink = new LogSink();
+    return *sink;
+}
+
+LogSink::LogSink() {
+    const char* sync = std::getenv("VENUS_LOG_SYNC");
+    if (sync && std::strcmp(sync, "0") != 0) {
+        async_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void LogSink::write(LogLevel level,
+                    LogCategory category,
+                    const char* file,
+                    int line,
+                    const char* message,
+                    size_t length) {
+    const int64_t timestamp = now_ns();
+    if (async() && length <= kMaxRingMessage) {
+        RecordHeader header = {};
+        header.length = static_cast<uint32_t>(length);
+        header.line = line;
+        header.level = static_cast<uint8_t>(level);
+        header.category = static_cast<uint8_t>(category);
+        header.timestamp_ns = timestamp;
+        header.file = file;
+
+        size_t used = 0;
+        Ring* ring = thread_ring();
+        if (ring && ring->push(header, message, &used)) {
+            ensure_thread_started();
+            // Errors are shown promptly; a filling ring is drained early.
+            const size_t half = kRingCapacity / 2;
+            const bool crossed_half = used > half && used - length <= half + sizeof(RecordHeader) + 8;
+            if (level <= LogLevel::ERROR || crossed_half) {
+                {
+                    std::lock_guard<std::mutex> lock(wake_mutex_);
+                    wake_requested_ = true;
+                }
+                wake_cv_.notify_one();
+            }
+            return;
+        }
+        direct_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    write_direct(level, category, file, line, timestamp, message, length);
+}
+
+void LogSink::flush() {
+    drain_once();
+}
+
+void LogSink::shutdown() {
+    async_.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex_);
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> wake_lock(wake_mutex_);
+                stop_requested_ = true;
+            }
+            wake_cv_.notify_one();
+            thread_.join();
+        }
+        running_.store(false, std::memory_order_release);
+    }
+    drain_once();
+}
+
+void LogSink::set_async(bool async) {
+    if (!async) {
+        drain_once();
+    }
+    async_.store(async, std::memory_order_relaxed);
+}
+
+LogSink::Ring* LogSink::thread_ring() {
+    if (!t_ring.ring) {
+        auto ring = std::make_shared<Ring>();
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(ring);
+        }
+        t_ring.ring = std::move(ring);
+    }
+    return t_ring.ring.get();
+}
+
+void LogSink::ensure_thread_started() {
+    if (running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    if (running_.load(std::memory_order_relaxed) || stop_requested_) {
+        return;
+    }
+    thread_ = std::thread(&LogSink::drain_loop, this);
+    running_.store(true, std::memory_order_release);
+}
+
+void LogSink::drain_loop() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (!stop_requested_) {
+        wake_cv_.wait_for(lock, kDrainInterval, [this] { return wake_requested_ || stop_requested_; });
+        wake_requested_ = false;
+        lock.unlock();
+        drain_once();
+        lock.lock();
+    }
+}
+
+size_t LogSink::drain_once() {
+    std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    std::vector<PendingRecord> records;
+    std::vector<Ring*> finished;
+    for (const auto& ring : rings) {
+        const bool retired = ring->retired.load(std::memory_order_acquire);
+        ring->pop_all(&records);
+        if (retired && ring->empty()) {
+            finished.push_back(ring.get());
+        }
+    }
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [&](const std::shared_ptr<Ring>& ring) {
+                                        return std::find(finished.begin(), finished.end(), ring.get()) !=
+                                               finished.end();
+                                    }),
+                     rings_.end());
+    }
+
+    if (records.empty()) {
+        return 0;
+    }
+    // Each ring is in order already; interleave threads by time.
+    std::stable_sort(records.begin(), records.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.header.timestamp_ns < b.header.timestamp_ns;
+    });
+    for (const auto& record : records) {
+        print_record(record.header, record.message.data(), record.message.size());
+    }
+    std::fflush(stderr);
+    return records.size();
+}
+
+void LogSink::write_direct(LogLevel level,
+                           LogCategory category,
+                           const char* file,
+                           int line,
+                           int64_t timestamp_ns,
+                           const char* message,
+                           size_t length) {
+    // Flush what this thread queued earlier so its records stay in order.
+    drain_once();
+
+    RecordHeader header = {};
+    header.line = line;
+    header.level = static_cast<uint8_t>(level);
+    header.category = static_cast<uint8_t>(category);
+    header.timestamp_ns = timestamp_ns;
+    header.file = file;
+
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    print_record(header, message, length);
+    std::fflush(stderr);
+}
+
+void log_sink_write(LogLevel level,
+                    LogCategory category,
+                    const char* file,
+                    int line,
+                    const char* message,
+                    size_t length) {
+    LogSink::instance().write(level, category, file, line, message, length);
+}
+
+} // namespace venus_plus
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "utils/logging.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace venus_plus {
+
+// Output side of the logger. Each logging thread appends binary records
+// (level, category, source location, timestamp, message bytes) to its own
+// single-producer ring without taking a lock; a background thread drains the
+// rings, orders records by timestamp and does the timestamp formatting and
+// stderr writes. A record that does not fit its ring is written directly, so
+// nothing is lost under bursts. VENUS_LOG_SYNC=1 writes every record directly
+// on the calling thread.
+class LogSink {
+public:
+    static LogSink& instance();
+
+    void write(LogLevel level,
+               LogCategory category,
+               const char* file,
+               int line,
+               const char* message,
+               size_t length);
+
+    // Blocks until every record queued before the call has been written.
+    void flush();
+    // Stops the drain thread after writing what is queued; later records are
+    // written directly. Runs automatically at exit and library unload.
+    void shutdown();
+
+    void set_async(bool async);
+    bool async() const { return async_.load(std::memory_order_relaxed); }
+
+    // Records that bypassed the rings because they were full or too large.
+    uint64_t direct_writes() const { return direct_writes_.load(std::memory_order_relaxed); }
+
+    struct Ring;
+
+private:
+    LogSink();
+
+    Ring* thread_ring();
+    void ensure_thread_started();
+    void drain_loop();
+    size_t drain_once();
+    void write_direct(LogLevel level,
+                      LogCategory category,
+                      const char* file,
+                      int line,
+                      int64_t timestamp_ns,
+                      const char* message,
+                      size_t length);
+
+    std::atomic<bool> async_{true};
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> direct_writes_{0};
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex drain_mutex_;            // serializes drain passes and direct writes
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool wake_requested_ = false;
+    bool stop_requested_ = false;
+    std::thread thread_;
+    std::mutex thread_mutex_;
+};
+
+} // namespace venus_plus
@@ -13,6 +13,12 @@
 #include <string>
 #include <utility>
 
+// Most verbose level that is compiled in at all (numeric LogLevel value).
+// Statements above it fold to nothing; set via -DVENUS_LOG_MIN_LEVEL=<name>.
+#ifndef VP_LOG_MIN_LEVEL
+#define VP_LOG_MIN_LEVEL 5
+#endif
+
 namespace venus_plus {
 
 // Log levels
@@ -38,6 +44,14 @@ enum class LogCategory {
     COUNT
 };
 
+// Hands a formatted record to the process-wide sink (utils/log_sink.cpp).
+void log_sink_write(LogLevel level,
+                    LogCategory category,
+                    const char* file,
+                    int line,
+                    const char* message,
+                    size_t length);
+
 // Logger singleton
 class Logger {
 public:
@@ -55,6 +69,9 @@ public:
         }
         return category_levels_[idx];
     }
+    bool enabled(LogLevel level, LogCategory category) const {
+        return level <= get_category_level(category);
+    }
     void set_category_level(LogCategory category, LogLevel level) {
         const size_t idx = static_cast<size_t>(category);
         if (idx < category_levels_.size()) {
@@ -72,35 +89,29 @@ public:
 
     void logv(LogLevel level, LogCategory category, const char* file, int line,
               const char* fmt, va_list args) {
-        const LogLevel threshold = get_category_level(category);
-        if (level > threshold) return;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-
-        // Timestamp
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-
-        char time_buf[32];
-        std::strftime(time_buf, sizeof(time_buf), "%H:%M:%S", std::localtime(&time));
-
-        // Extract filename from path
-        const char* filename = std::strrchr(file, '/');
-        filename = filename ? filename + 1 : file;
-
-        // Print header
-        std::fprintf(stderr, "[%s.%03d] [%s] [%s] %s:%d: ",
-                     time_buf, static_cast<int>(ms.count()),
-                     level_str(level), category_str(category),
-                     filename, line);
-
-        // Print message
-        std::vfprintf(stderr, fmt, args);
+        if (!enabled(level, category)) return;
+
+        char buffer[512];
+        va_list copy;
+        va_copy(copy, args);
+        const int length = std::vsnprintf(buffer, sizeof(buffer), fmt, copy);
+        va_end(copy);
+        if (length < 0) {
+            return;
+        }
+        if (static_cast<size_t>(length) < sizeof(buffer)) {
+            log_sink_write(level, category, file, line, buffer, static_cast<size_t>(length));
+            return;
+        }
+        std::string message(static_cast<size_t>(length) + 1, '\0');
+        std::vsnprintf(&message[0], message.size(), fmt, args);
+        log_sink_write(level, category, file, line, message.data(), static_cast<size_t>(length));
+    }
 
-        std::fprintf(stderr, "\n");
-        std::fflush(stderr);
+    void write(LogLevel level, LogCategory category, const char* file, int line,
+               const char* message, size_t length) {
+        if (!enabled(level, category)) return;
+        log_sink_write(level, category, file, line, message, length);
     }
 
 private:
@@ -182,36 +193,19 @@ private:
         }
     }
 
-    const char* level_str(LogLevel level) {
-        switch (level) {
-            case LogLevel::ERROR: return "ERROR";
-            case LogLevel::WARN:  return "WARN ";
-            case LogLevel::INFO:  return "INFO ";
-            case LogLevel::DEBUG: return "DEBUG";
-            case LogLevel::TRACE: return "TRACE";
-            default: return "?????";
-        }
-    }
-
-    const char* category_str(LogCategory cat) {
-        switch (cat) {
-            case LogCategory::GENERAL:  return "GENERAL ";
-            case LogCategory::NETWORK:  return "NETWORK ";
-            case LogCategory::CLIENT:   return "CLIENT  ";
-            case LogCategory::SERVER:   return "SERVER  ";
-            case LogCategory::PROTOCOL: return "PROTOCOL";
-            case LogCategory::VULKAN:   return "VULKAN  ";
-            case LogCategory::MEMORY:   return "MEMORY  ";
-            case LogCategory::SYNC:     return "SYNC    ";
-            default: return "????????";
-        }
-    }
-
     LogLevel level_ = LogLevel::WARN;
     std::array<LogLevel, static_cast<size_t>(LogCategory::COUNT)> category_levels_ = {};
-    std::mutex mutex_;
 };
 
+constexpr bool log_level_compiled(LogLevel level) {
+    return static_cast<int>(level) <= VP_LOG_MIN_LEVEL;
+}
+
+// Cheap gate evaluated before any argument is formatted.
+inline bool log_enabled(LogLevel level, LogCategory category) {
+    return log_level_compiled(level) && Logger::instance().enabled(level, category);
+}
+
 } // namespace venus_plus
 
 namespace venus_plus {
@@ -278,10 +272,8 @@ private:
         while (!message.empty() && (message.back() == '\n' || message.back() == '\r')) {
             message.pop_back();
         }
-        if (!message.empty()) {
-            Logger::instance().log(level_, category_, file_, line_, "%s", message.c_str());
-        } else if (had_raw_output) {
-            Logger::instance().log(level_, category_, file_, line_, "%s", "");
+        if (!message.empty() || had_raw_output) {
+            Logger::instance().write(level_, category_, file_, line_, message.data(), message.size());
         }
         flushed_ = true;
     }
@@ -294,11 +286,20 @@ private:
     bool flushed_ = false;
 };
 
+// Swallows the LogStream expression so the disabled branch of
+// VP_LOG_STREAM can be a plain (void)0.
+struct LogVoidify {
+    void operator&(const LogStream&) const {}
+};
+
 } // namespace venus_plus
 
-// Convenience macros
+// Convenience macros. The level check happens before any argument is
+// evaluated or formatted, so disabled statements cost one branch.
 #define VP_LOG(level, category, ...) \
-    venus_plus::Logger::instance().log(level, category, __FILE__, __LINE__, __VA_ARGS__)
+    (venus_plus::log_enabled(level, category) \
+         ? venus_plus::Logger::instance().log(level, category, __FILE__, __LINE__, __VA_ARGS__) \
+         : (void)0)
 
 #define VP_LOG_ERROR(category, ...) \
     VP_LOG(venus_plus::LogLevel::ERROR, venus_plus::LogCategory::category, __VA_ARGS__)
@@ -320,7 +321,10 @@ private:
     venus_plus::Logger::instance().set_level(venus_plus::LogLevel::level)
 
 #define VP_LOG_STREAM(level, category) \
-    venus_plus::LogStream(venus_plus::LogLevel::level, venus_plus::LogCategory::category, __FILE__, __LINE__)
+    !venus_plus::log_enabled(venus_plus::LogLevel::level, venus_plus::LogCategory::category) \
+        ? (void)0 \
+        : venus_plus::LogVoidify() & \
+              venus_plus::LogStream(venus_plus::LogLevel::level, venus_plus::LogCategory::category, __FILE__, __LINE__)
 
 #define VP_LOG_STREAM_ERROR(category) \
     VP_LOG_STREAM(ERROR, category)
@@ -3,6 +3,13 @@
 
 #include <cstdarg>
 
+extern "C" int vp_log_enabled(vp_log_level level, vp_log_category category) {
+    return venus_plus::Logger::instance().enabled(static_cast<venus_plus::LogLevel>(level),
+                                                  static_cast<venus_plus::LogCategory>(category))
+               ? 1
+               : 0;
+}
+
 extern "C" void vp_log_printf(vp_log_level level,
                                vp_log_category category,
                                const char* file,
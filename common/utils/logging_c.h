@@ -2,6 +2,11 @@
 
 #include <stdarg.h>
 
+/* Most verbose level compiled in; see utils/logging.h. */
+#ifndef VP_LOG_MIN_LEVEL
+#define VP_LOG_MIN_LEVEL 5
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -27,6 +32,8 @@ typedef enum {
     VP_LOG_CATEGORY_COUNT,
 } vp_log_category;
 
+int vp_log_enabled(vp_log_level level, vp_log_category category);
+
 void vp_log_printf(vp_log_level level,
                    vp_log_category category,
                    const char* file,
@@ -40,8 +47,12 @@ void vp_log_printf(vp_log_level level,
 
 #ifndef __cplusplus
 
+/* Arguments are only evaluated and formatted when the level is enabled. */
 #define VP_LOG(level, category, ...) \
-    vp_log_printf(VP_LOG_LEVEL_##level, VP_LOG_CATEGORY_##category, __FILE__, __LINE__, __VA_ARGS__)
+    ((VP_LOG_LEVEL_##level <= VP_LOG_MIN_LEVEL && \
+      vp_log_enabled(VP_LOG_LEVEL_##level, VP_LOG_CATEGORY_##category)) \
+         ? vp_log_printf(VP_LOG_LEVEL_##level, VP_LOG_CATEGORY_##category, __FILE__, __LINE__, __VA_ARGS__) \
+         : (void)0)
 
 #define VP_LOG_ERROR(category, ...) VP_LOG(ERROR, category, __VA_ARGS__)
 #define VP_LOG_WARN(category, ...)  VP_LOG(WARN, category, __VA_ARGS__)
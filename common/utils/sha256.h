@@ -0,0 +1,32 @@
+#ifndef VENUS_PLUS_SHA256_H
+#define VENUS_PLUS_SHA256_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace venus_plus {
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+// SHA-256 (FIPS 180-4) of |size| bytes at |data|.
+Sha256Digest sha256(const void* data, size_t size);
+
+// Lower-case hex of |digest|, e.g. for file names.
+std::string sha256_hex(const Sha256Digest& digest);
+
+struct Sha256DigestHash {
+    size_t operator()(const Sha256Digest& digest) const {
+        // The digest is already uniformly distributed.
+        size_t value = 0;
+        for (size_t i = 0; i < sizeof(value); ++i) {
+            value = (value << 8) | digest[i];
+        }
+        return value;
+    }
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SHA256_H
@@ -3,6 +3,8 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "vn_cs.h"
@@ -22,9 +24,26 @@ struct vn_ring_submit_command {
     std::vector<uint8_t> reply_buffer;
 };
 
+// The commands captured for one command buffer.
+struct vn_ring_capture {
+    std::vector<uint8_t> stream;
+    // Where the command vn_ring_extend_capture may grow starts and ends in
+    // |stream|, and where its item count is; it stops being extendable as
+    // soon as anything is captured after it.
+    size_t extendable_start = 0;
+    size_t extendable_end = 0;
+    size_t extendable_count_offset = 0;
+};
+
 struct vn_ring {
     venus_plus::NetworkClient* client;
     std::vector<uint8_t> pending_buffer;
+    // Asynchronous commands whose first argument is a capturing command
+    // buffer (remote handle) land here instead of in pending_buffer. Guarded
+    // by capture_mutex, so threads recording different command buffers never
+    // touch pending_buffer or the socket.
+    std::mutex capture_mutex;
+    std::unordered_map<uint64_t, vn_ring_capture> captures;
 };
 
 vn_cs_encoder* vn_ring_submit_command_init(struct vn_ring* ring,
@@ -35,6 +54,31 @@ vn_cs_encoder* vn_ring_submit_command_init(struct vn_ring* ring,
 
 void vn_ring_submit_command(struct vn_ring* ring, struct vn_ring_submit_command* submit);
 void vn_ring_flush_pending(struct vn_ring* ring);
+// Diverts the encoded commands for |command_buffer| into a capture until
+// vn_ring_end_capture, which hands them to |out| (or drops them when null).
+void vn_ring_begin_capture(struct vn_ring* ring, uint64_t command_buffer);
+void vn_ring_end_capture(struct vn_ring* ring, uint64_t command_buffer, std::vector<uint8_t>* out);
+// Captures an encoded command for |command_buffer| that later items can be
+// appended to with vn_ring_extend_capture. |count_offset| locates the
+// uint32_t in it that counts them. False, with nothing captured, when
+// |command_buffer| is not being captured.
+bool vn_ring_capture_extendable(struct vn_ring* ring,
+                                uint64_t command_buffer,
+                                const void* data,
+                                size_t size,
+                                size_t count_offset);
+// Appends one item to the extendable command of |command_buffer| as long as
+// it is still the last one captured and stays within |max_command_size|.
+bool vn_ring_extend_capture(struct vn_ring* ring,
+                            uint64_t command_buffer,
+                            const void* data,
+                            size_t size,
+                            size_t max_command_size);
+// Queues already encoded commands, e.g. a capture that has to be sent after all.
+void vn_ring_submit_encoded(struct vn_ring* ring, const uint8_t* data, size_t size);
+// Sends already encoded commands that generate replies, along with anything
+// pending, and receives their replies back to back in |reply|.
+bool vn_ring_call_encoded(struct vn_ring* ring, const uint8_t* data, size_t size, std::vector<uint8_t>* reply);
 vn_cs_decoder* vn_ring_get_command_reply(struct vn_ring* ring, struct vn_ring_submit_command* submit);
 void vn_ring_free_command_reply(struct vn_ring* ring, struct vn_ring_submit_command* submit);
 
@@ -1,14 +1,22 @@
 #include "network/network_server.h"
 #include "memory/memory_transfer.h"
+#include "pipeline_compiler.h"
 #include "renderer_decoder.h"
 #include "server_state.h"
+#include "state/shader_module_store.h"
 #include "protocol/memory_transfer.h"
 #include "protocol/frame_transfer.h"
+#include "protocol/command_replay.h"
+#include "protocol/shader_cache.h"
 #include "wsi/swapchain_manager.h"
 #include "utils/logging.h"
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -17,17 +25,109 @@ using namespace venus_plus;
 #define SERVER_LOG_ERROR() VP_LOG_STREAM_ERROR(SERVER)
 #define SERVER_LOG_INFO() VP_LOG_STREAM_INFO(SERVER)
 
-static ServerState g_server_state;
-static VenusRenderer* g_renderer = nullptr;
-static MemoryTransferHandler g_memory_transfer(&g_server_state);
-static ServerSwapchainManager g_swapchain_manager(&g_server_state);
+static ServerSharedState g_shared_state;
+// Worker threads per session for parallel command-buffer recording; 0 = off.
+static uint32_t g_record_threads = 0;
+// Skip per-command recording-state and range validation (--trusted-client).
+static bool g_trusted_client = false;
+// SPIR-V by hash, for every client (--shader-cache-mb, --shader-cache-dir).
+static ShaderModuleStore g_shader_store;
+// Pipeline compile threads shared by every client (--pipeline-threads); null
+// compiles inline.
+static PipelineCompiler* g_pipeline_compiler = nullptr;
 
-bool handle_client_message(int client_fd, const void* data, size_t size) {
+// Everything one client connection owns. Sessions share only the read-only
+// g_shared_state and the internally locked g_shader_store, so connections
+// decode in parallel on their own threads.
+struct ClientSession {
+    ClientSession()
+        : state(&g_shared_state),
+          memory_transfer(&state),
+          swapchain_manager(&state) {
+        renderer = venus_renderer_create(&state);
+        if (renderer && g_trusted_client) {
+            venus_renderer_set_trusted_client(renderer, true);
+        }
+        if (renderer && g_record_threads > 0 &&
+            !venus_renderer_enable_parallel_recording(renderer, g_record_threads)) {
+            SERVER_LOG_ERROR() << "Failed to start parallel recording; recording inline";
+        }
+        if (renderer && g_pipeline_compiler) {
+            venus_renderer_enable_async_pipelines(renderer, g_pipeline_compiler);
+        }
+    }
+
+    ~ClientSession() {
+        // First, so no recording worker or pipeline compile is still using
+        // the session's objects.
+        if (renderer) {
+            venus_renderer_destroy(renderer);
+        }
+        swapchain_manager.destroy_all();
+        server_state_release_session(&state);
+        g_shader_store.log_stats();
+    }
+
+    ClientSession(const ClientSession&) = delete;
+    ClientSession& operator=(const ClientSession&) = delete;
+
+    ServerState state;
+    VenusRenderer* renderer = nullptr;
+    MemoryTransferHandler memory_transfer;
+    ServerSwapchainManager swapchain_manager;
+};
+
+static CreateShaderModuleReply create_shader_module(ClientSession& session, const void* data, size_t size) {
+    CreateShaderModuleReply reply = {};
+    reply.result = VK_ERROR_INITIALIZATION_FAILED;
+    CreateShaderModuleRequest request = {};
+    std::memcpy(&request, data, sizeof(request));
+    if (request.code_size == 0 || request.code_size % sizeof(uint32_t) != 0) {
+        return reply;
+    }
+    Sha256Digest hash = {};
+    std::memcpy(hash.data(), request.code_hash, hash.size());
+
+    ShaderModuleStore::Code code = g_shader_store.find(hash, request.code_size);
+    if (!code) {
+        if (request.command != VENUS_PLUS_CMD_CREATE_SHADER_MODULE_WITH_CODE) {
+            reply.result = VK_INCOMPLETE;
+            return reply;
+        }
+        const uint8_t* payload = static_cast<const uint8_t*>(data) + sizeof(request);
+        if (size - sizeof(request) != request.code_size) {
+            SERVER_LOG_ERROR() << "Shader module upload of " << size - sizeof(request)
+                               << " bytes, expected " << request.code_size;
+            return reply;
+        }
+        // Only code that matches its name goes into the shared store.
+        if (sha256(payload, request.code_size) != hash) {
+            SERVER_LOG_ERROR() << "Shader module upload does not match its hash";
+            return reply;
+        }
+        code = g_shader_store.insert(hash, payload, request.code_size);
+    }
+
+    VkShaderModuleCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.flags = request.flags;
+    info.codeSize = code->size() * sizeof(uint32_t);
+    info.pCode = code->data();
+    VkShaderModule module = server_state_create_shader_module(
+        &session.state, reinterpret_cast<VkDevice>(request.device), &info, &hash);
+    if (module != VK_NULL_HANDLE) {
+        reply.result = VK_SUCCESS;
+        reply.shader_module = reinterpret_cast<uint64_t>(module);
+    }
+    return reply;
+}
+
+bool handle_client_message(ClientSession& session, int client_fd, const void* data, size_t size) {
     if (size >= sizeof(uint32_t)) {
         uint32_t command = 0;
         std::memcpy(&command, data, sizeof(command));
         if (command == VENUS_PLUS_CMD_TRANSFER_MEMORY_DATA) {
-            VkResult result = g_memory_transfer.handle_transfer_command(data, size);
+            VkResult result = session.memory_transfer.handle_transfer_command(data, size);
             if (!NetworkServer::send_to_client(client_fd, &result, sizeof(result))) {
                 SERVER_LOG_ERROR() << "Failed to send transfer ack";
                 return false;
@@ -35,7 +135,7 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
             return true;
         }
         if (command == VENUS_PLUS_CMD_TRANSFER_MEMORY_BATCH) {
-            VkResult result = g_memory_transfer.handle_transfer_batch_command(data, size);
+            VkResult result = session.memory_transfer.handle_transfer_batch_command(data, size);
             if (!NetworkServer::send_to_client(client_fd, &result, sizeof(result))) {
                 SERVER_LOG_ERROR() << "Failed to send transfer batch ack";
                 return false;
@@ -44,7 +144,7 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
         }
         if (command == VENUS_PLUS_CMD_READ_MEMORY_DATA) {
             std::vector<uint8_t> payload;
-            VkResult result = g_memory_transfer.handle_read_command(data, size, &payload);
+            VkResult result = session.memory_transfer.handle_read_command(data, size, &payload);
             const size_t reply_size = sizeof(VkResult) +
                                       (result == VK_SUCCESS ? payload.size() : 0);
             std::vector<uint8_t> reply(reply_size);
@@ -60,20 +160,70 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
         }
         if (command == VENUS_PLUS_CMD_READ_MEMORY_BATCH) {
             std::vector<uint8_t> payload;
-            VkResult result = g_memory_transfer.handle_read_batch_command(data, size, &payload);
+            VkResult result = session.memory_transfer.handle_read_batch_command(data, size, &payload);
             if (!NetworkServer::send_to_client(client_fd, payload.data(), payload.size())) {
                 SERVER_LOG_ERROR() << "Failed to send read batch reply";
                 return false;
             }
             return true;
         }
+        if (command == VENUS_PLUS_CMD_REUSE_RECORDING) {
+            if (size < sizeof(ReuseRecordingRequest)) {
+                return false;
+            }
+            ReuseRecordingRequest request = {};
+            std::memcpy(&request, data, sizeof(request));
+            VkCommandBuffer command_buffer = reinterpret_cast<VkCommandBuffer>(request.command_buffer);
+            // A deferred end may still be running on a recording worker.
+            venus_renderer_finish_recording(session.renderer);
+            VkResult result = server_state_reuse_command_buffer(&session.state, command_buffer);
+            SERVER_LOG_INFO() << "Reuse recording " << command_buffer << " (hash 0x" << std::hex
+                              << request.stream_hash << std::dec << "): "
+                              << (result == VK_SUCCESS ? "kept" : "not executable");
+            if (request.flags & VENUS_PLUS_REUSE_RECORDING_NO_REPLY) {
+                if (result != VK_SUCCESS) {
+                    SERVER_LOG_ERROR() << "Reused recording " << command_buffer
+                                       << " is not executable; its next submit fails";
+                }
+                return true;
+            }
+            if (!NetworkServer::send_to_client(client_fd, &result, sizeof(result))) {
+                SERVER_LOG_ERROR() << "Failed to send reuse recording reply";
+                return false;
+            }
+            return true;
+        }
+        if (command == VENUS_PLUS_CMD_RESET_ELIDED) {
+            if (size < sizeof(ResetElidedRequest)) {
+                return false;
+            }
+            ResetElidedRequest request = {};
+            std::memcpy(&request, data, sizeof(request));
+            VkCommandBuffer command_buffer = reinterpret_cast<VkCommandBuffer>(request.command_buffer);
+            // Ordered after any deferred end of the previous recording.
+            venus_renderer_finish_recording(session.renderer);
+            server_state_allow_implicit_reset(&session.state, command_buffer);
+            return true;
+        }
+        if (command == VENUS_PLUS_CMD_CREATE_SHADER_MODULE ||
+            command == VENUS_PLUS_CMD_CREATE_SHADER_MODULE_WITH_CODE) {
+            if (size < sizeof(CreateShaderModuleRequest)) {
+                return false;
+            }
+            CreateShaderModuleReply reply = create_shader_module(session, data, size);
+            if (!NetworkServer::send_to_client(client_fd, &reply, sizeof(reply))) {
+                SERVER_LOG_ERROR() << "Failed to send shader module reply";
+                return false;
+            }
+            return true;
+        }
         if (command == VENUS_PLUS_CMD_CREATE_SWAPCHAIN) {
             if (size < sizeof(VenusSwapchainCreateRequest)) {
                 return false;
             }
             auto* request = reinterpret_cast<const VenusSwapchainCreateRequest*>(data);
             VenusSwapchainCreateReply reply = {};
-            VkResult create_result = g_swapchain_manager.create_swapchain(request->create_info, &reply);
+            VkResult create_result = session.swapchain_manager.create_swapchain(request->create_info, &reply);
             reply.result = create_result;
             NetworkServer::send_to_client(client_fd, &reply, sizeof(reply));
             return true;
@@ -83,7 +233,7 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
                 return false;
             }
             auto* request = reinterpret_cast<const VenusSwapchainDestroyRequest*>(data);
-            g_swapchain_manager.destroy_swapchain(request->swapchain_id);
+            session.swapchain_manager.destroy_swapchain(request->swapchain_id);
             VkResult result = VK_SUCCESS;
             NetworkServer::send_to_client(client_fd, &result, sizeof(result));
             return true;
@@ -94,8 +244,8 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
             }
             auto* request = reinterpret_cast<const VenusSwapchainAcquireRequest*>(data);
             VenusSwapchainAcquireReply reply = {};
-            reply.result = g_swapchain_manager.acquire_image(request->swapchain_id,
-                                                             &reply.image_index);
+            reply.result = session.swapchain_manager.acquire_image(request->swapchain_id,
+                                                                   &reply.image_index);
             NetworkServer::send_to_client(client_fd, &reply, sizeof(reply));
             return true;
         }
@@ -106,10 +256,15 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
             auto* request = reinterpret_cast<const VenusSwapchainPresentRequest*>(data);
             VenusSwapchainPresentReply reply = {};
             std::vector<uint8_t> payload;
-            reply.result = g_swapchain_manager.present(request->swapchain_id,
-                                                       request->image_index,
-                                                       &reply.frame,
-                                                       &payload);
+            const auto present_start = std::chrono::steady_clock::now();
+            reply.result = session.swapchain_manager.present(request->swapchain_id,
+                                                             request->image_index,
+                                                             request->codec_level,
+                                                             &reply.frame,
+                                                             &payload);
+            reply.server_time_us = static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - present_start).count());
             std::vector<uint8_t> buffer(sizeof(reply) + (reply.result == VK_SUCCESS ? payload.size() : 0));
             std::memcpy(buffer.data(), &reply, sizeof(reply));
             if (reply.result == VK_SUCCESS && !payload.empty()) {
@@ -118,12 +273,75 @@ bool handle_client_message(int client_fd, const void* data, size_t size) {
             NetworkServer::send_to_client(client_fd, buffer.data(), buffer.size());
             return true;
         }
+        if (command == VENUS_PLUS_CMD_PRESENT_BATCH) {
+            if (size < sizeof(VenusSwapchainPresentBatchHeader)) {
+                return false;
+            }
+            VenusSwapchainPresentBatchHeader header = {};
+            std::memcpy(&header, data, sizeof(header));
+            const size_t expected = sizeof(header) +
+                                    static_cast<size_t>(header.present_count) *
+                                        sizeof(VenusSwapchainPresentEntry) +
+                                    static_cast<size_t>(header.wait_semaphore_count) *
+                                        sizeof(uint64_t);
+            if (header.present_count > kVenusMaxBatchPresents ||
+                size < expected) {
+                SERVER_LOG_ERROR() << "Invalid present batch";
+                return false;
+            }
+            std::vector<VenusSwapchainPresentEntry> entries(header.present_count);
+            std::memcpy(entries.data(),
+                        static_cast<const uint8_t*>(data) + sizeof(header),
+                        entries.size() * sizeof(VenusSwapchainPresentEntry));
+            std::vector<VkSemaphore> wait_semaphores(header.wait_semaphore_count);
+            for (uint32_t i = 0; i < header.wait_semaphore_count; ++i) {
+                uint64_t handle = 0;
+                std::memcpy(&handle,
+                            static_cast<const uint8_t*>(data) + sizeof(header) +
+                                entries.size() * sizeof(VenusSwapchainPresentEntry) +
+                                i * sizeof(uint64_t),
+                            sizeof(handle));
+                wait_semaphores[i] = reinterpret_cast<VkSemaphore>(handle);
+            }
+
+            std::vector<PresentedFrame> frames;
+            const auto present_start = std::chrono::steady_clock::now();
+            VenusSwapchainPresentBatchReplyHeader reply_header = {};
+            reply_header.result = session.swapchain_manager.present_batch(entries.data(),
+                                                                          header.present_count,
+                                                                          wait_semaphores.data(),
+                                                                          header.wait_semaphore_count,
+                                                                          &frames);
+            reply_header.present_count = header.present_count;
+            const uint32_t server_time_us = static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - present_start).count());
+
+            std::vector<VenusSwapchainPresentReply> replies(frames.size());
+            std::vector<SendSegment> segments;
+            segments.reserve(1 + frames.size() * 2);
+            segments.push_back({&reply_header, sizeof(reply_header)});
+            for (size_t i = 0; i < frames.size(); ++i) {
+                replies[i].result = frames[i].result;
+                replies[i].frame = frames[i].header;
+                replies[i].server_time_us = server_time_us;
+                segments.push_back({&replies[i], sizeof(replies[i])});
+                if (frames[i].result == VK_SUCCESS) {
+                    segments.push_back({frames[i].payload.data(), frames[i].payload.size()});
+                }
+            }
+            if (!NetworkServer::send_segments_to_client(client_fd, segments.data(), segments.size())) {
+                SERVER_LOG_ERROR() << "Failed to send present batch reply";
+                return false;
+            }
+            return true;
+        }
     }
 
     uint8_t* reply = nullptr;
     size_t reply_size = 0;
 
-    if (!venus_renderer_handle(g_renderer, data, size, &reply, &reply_size)) {
+    if (!venus_renderer_handle(session.renderer, data, size, &reply, &reply_size)) {
         SERVER_LOG_ERROR() << "Failed to decode Venus command";
         if (reply) {
             std::free(reply);
@@ -149,46 +367,89 @@ int main(int argc, char** argv) {
 
     bool enable_validation = false;
     int port = 5556;
+    size_t shader_cache_mb = 256;
+    std::string shader_cache_dir;
+    bool pipeline_cache = true;
+    size_t pipeline_cache_mb = 64;
+    std::string pipeline_cache_dir;
+    uint32_t pipeline_threads = std::thread::hardware_concurrency();
 
     for (int i = 1; i < argc; ++i) {
         if (std::strcmp(argv[i], "--validation") == 0) {
             enable_validation = true;
         } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--trusted-client") == 0) {
+            g_trusted_client = true;
+        } else if (std::strcmp(argv[i], "--record-threads") == 0 && i + 1 < argc) {
+            g_record_threads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--shader-cache-mb") == 0 && i + 1 < argc) {
+            shader_cache_mb = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--shader-cache-dir") == 0 && i + 1 < argc) {
+            shader_cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--pipeline-cache-dir") == 0 && i + 1 < argc) {
+            pipeline_cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--pipeline-cache-mb") == 0 && i + 1 < argc) {
+            pipeline_cache_mb = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-pipeline-cache") == 0) {
+            pipeline_cache = false;
+        } else if (std::strcmp(argv[i], "--pipeline-threads") == 0 && i + 1 < argc) {
+            pipeline_threads = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--emulate-host-image-copy") == 0) {
+            g_shared_state.emulate_host_image_copy = true;
         }
     }
+    g_shader_store.configure(shader_cache_mb * 1024 * 1024, shader_cache_dir);
+    g_shared_state.pipeline_cache_store.configure(pipeline_cache, pipeline_cache_dir,
+                                                  pipeline_cache_mb * 1024 * 1024);
 
-    if (!g_server_state.initialize_vulkan(enable_validation)) {
+    if (!g_shared_state.initialize(enable_validation)) {
         SERVER_LOG_ERROR() << "Failed to initialize Vulkan on server";
         return 1;
     }
 
     NetworkServer server;
 
-    g_renderer = venus_renderer_create(&g_server_state);
-    if (!g_renderer) {
-        SERVER_LOG_ERROR() << "Failed to initialize renderer decoder";
-        g_server_state.shutdown_vulkan();
-        return 1;
-    }
-
     if (!server.start(port)) {
         SERVER_LOG_ERROR() << "Failed to start server on port " << port;
-        venus_renderer_destroy(g_renderer);
-        g_renderer = nullptr;
-        g_server_state.shutdown_vulkan();
+        g_shared_state.shutdown();
         return 1;
     }
+    g_pipeline_compiler = pipeline_compiler_create(pipeline_threads);
 
     SERVER_LOG_INFO() << "Listening on port " << port
                       << (enable_validation ? " (validation enabled)" : "");
+    if (g_trusted_client) {
+        SERVER_LOG_INFO() << "Trusted clients: recorded commands are not validated";
+    }
+    if (g_record_threads > 0) {
+        SERVER_LOG_INFO() << "Parallel command-buffer recording: " << g_record_threads
+                          << " worker thread(s) per client";
+    }
+    SERVER_LOG_INFO() << "Shader module cache: " << shader_cache_mb << " MiB"
+                      << (shader_cache_dir.empty() ? "" : ", on disk in " + shader_cache_dir);
+    if (pipeline_cache) {
+        SERVER_LOG_INFO() << "Implicit pipeline cache: up to " << pipeline_cache_mb << " MiB per GPU"
+                          << (pipeline_cache_dir.empty() ? "" : ", on disk in " + pipeline_cache_dir);
+    }
+    if (g_pipeline_compiler) {
+        SERVER_LOG_INFO() << "Asynchronous pipeline compilation: " << pipeline_threads << " thread(s)";
+    }
 
-    server.run(handle_client_message);
-
-    venus_renderer_destroy(g_renderer);
-    g_renderer = nullptr;
+    server.run([](int client_fd) -> ClientHandler {
+        auto session = std::make_shared<ClientSession>();
+        if (!session->renderer) {
+            SERVER_LOG_ERROR() << "Failed to initialize renderer decoder for client " << client_fd;
+            return nullptr;
+        }
+        return [session](int fd, const void* data, size_t size) {
+            return handle_client_message(*session, fd, data, size);
+        };
+    });
 
-    g_server_state.shutdown_vulkan();
+    pipeline_compiler_destroy(g_pipeline_compiler);
+    g_pipeline_compiler = nullptr;
+    g_shared_state.shutdown();
 
     return 0;
 }
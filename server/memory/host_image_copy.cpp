@@ -0,0 +1,435 @@
+#include "host_image_copy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "server_state.h"
+#include "utils/format_info.h"
+#include "utils/logging.h"
+
+#define HOST_COPY_LOG_ERROR() VP_LOG_STREAM_ERROR(MEMORY)
+
+namespace venus_plus {
+
+namespace {
+
+// Layouts emulated copies accept; the others need a transition first.
+constexpr VkImageLayout kCopyLayouts[] = {
+    VK_IMAGE_LAYOUT_GENERAL,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+};
+constexpr uint32_t kCopyLayoutCount = sizeof(kCopyLayouts) / sizeof(kCopyLayouts[0]);
+
+void fill_copy_layouts(uint32_t* count, VkImageLayout* layouts) {
+    if (!layouts) {
+        *count = kCopyLayoutCount;
+        return;
+    }
+    *count = std::min(*count, kCopyLayoutCount);
+    std::copy(kCopyLayouts, kCopyLayouts + *count, layouts);
+}
+
+VkImageUsageFlags transfer_usage(VkImageUsageFlags usage) {
+    if (!(usage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT)) {
+        return usage;
+    }
+    return (usage & ~VK_IMAGE_USAGE_HOST_TRANSFER_BIT) | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+           VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+}
+
+// Takes the first struct of type |type| out of the chain after |head| and
+// returns it. The decoder's copy of the chain is ours to edit.
+VkBaseOutStructure* unlink_struct(void* head, VkStructureType type, VkBaseOutStructure** previous) {
+    VkBaseOutStructure* prev = static_cast<VkBaseOutStructure*>(head);
+    while (prev->pNext && prev->pNext->sType != type) {
+        prev = prev->pNext;
+    }
+    VkBaseOutStructure* found = prev->pNext;
+    if (found) {
+        prev->pNext = found->pNext;
+    }
+    *previous = prev;
+    return found;
+}
+
+// The bytes a region spans in host memory, or 0 for a format without a
+// known block size.
+VkDeviceSize region_size(VkFormat format,
+                         VkHostImageCopyFlags flags,
+                         uint32_t row_length,
+                         uint32_t image_height,
+                         const VkImageSubresourceLayers& subresource,
+                         const VkExtent3D& extent,
+                         FormatBlock* block) {
+    if (!format_copy_block(format, subresource.aspectMask, block)) {
+        return 0;
+    }
+    if (flags & VK_HOST_IMAGE_COPY_MEMCPY) {
+        row_length = 0;
+        image_height = 0;
+    }
+    return image_copy_size(*block, row_length, image_height, extent, subresource.layerCount);
+}
+
+VkBufferImageCopy buffer_image_copy(VkHostImageCopyFlags flags,
+                                    uint32_t row_length,
+                                    uint32_t image_height,
+                                    const VkImageSubresourceLayers& subresource,
+                                    const VkOffset3D& offset,
+                                    const VkExtent3D& extent) {
+    VkBufferImageCopy region = {};
+    const bool packed = (flags & VK_HOST_IMAGE_COPY_MEMCPY) != 0;
+    region.bufferRowLength = packed ? 0 : row_length;
+    region.bufferImageHeight = packed ? 0 : image_height;
+    region.imageSubresource = subresource;
+    region.imageOffset = offset;
+    region.imageExtent = extent;
+    return region;
+}
+
+// Emulated copies run on the first queue the client fetched, like staged
+// memory transfers.
+VkResult staging_target(const ServerState* state, VkDevice device, StagingTarget* target) {
+    auto it = state->device_info_map.find(device);
+    if (it == state->device_info_map.end() || it->second.queues.empty()) {
+        HOST_COPY_LOG_ERROR() << "No queue to run host image copies on";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    target->device = device;
+    target->real_device = it->second.real_handle;
+    target->real_queue = it->second.queues.front().real_handle;
+    target->queue_family = it->second.queues.front().family_index;
+    return VK_SUCCESS;
+}
+
+} // namespace
+
+bool host_image_copy_emulated(const ServerSharedState* shared) {
+    return shared && !shared->host_image_copy_native && shared->host_image_copy_emulatable;
+}
+
+VkResult host_image_copy_enumerate_extensions(const ServerSharedState* shared,
+                                              VkPhysicalDevice real_physical_device,
+                                              uint32_t* count,
+                                              VkExtensionProperties* properties) {
+    if (!host_image_copy_emulated(shared)) {
+        return vkEnumerateDeviceExtensionProperties(real_physical_device, nullptr, count, properties);
+    }
+    uint32_t real_count = 0;
+    VkResult result = vkEnumerateDeviceExtensionProperties(real_physical_device, nullptr, &real_count, nullptr);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    std::vector<VkExtensionProperties> extensions(real_count);
+    if (real_count > 0) {
+        result = vkEnumerateDeviceExtensionProperties(real_physical_device, nullptr, &real_count, extensions.data());
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+            return result;
+        }
+        extensions.resize(real_count);
+    }
+    // A driver with the extension still lists it when emulation is forced.
+    extensions.erase(std::remove_if(extensions.begin(),
+                                    extensions.end(),
+                                    [](const VkExtensionProperties& extension) {
+                                        return std::strcmp(extension.extensionName,
+                                                           VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) == 0;
+                                    }),
+                     extensions.end());
+    VkExtensionProperties host_image_copy = {};
+    std::strncpy(host_image_copy.extensionName, VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, VK_MAX_EXTENSION_NAME_SIZE - 1);
+    host_image_copy.specVersion = VK_EXT_HOST_IMAGE_COPY_SPEC_VERSION;
+    extensions.push_back(host_image_copy);
+
+    const uint32_t total = static_cast<uint32_t>(extensions.size());
+    if (!properties) {
+        *count = total;
+        return VK_SUCCESS;
+    }
+    const uint32_t copied = std::min(*count, total);
+    std::copy(extensions.begin(), extensions.begin() + copied, properties);
+    *count = copied;
+    return copied < total ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+void host_image_copy_fill_features(const ServerSharedState* shared, VkPhysicalDeviceFeatures2* features) {
+    if (!host_image_copy_emulated(shared) || !features) {
+        return;
+    }
+    for (auto* next = static_cast<VkBaseOutStructure*>(features->pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES) {
+            reinterpret_cast<VkPhysicalDeviceHostImageCopyFeatures*>(next)->hostImageCopy = VK_TRUE;
+        } else if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_4_FEATURES) {
+            reinterpret_cast<VkPhysicalDeviceVulkan14Features*>(next)->hostImageCopy = VK_TRUE;
+        }
+    }
+}
+
+void host_image_copy_fill_properties(const ServerSharedState* shared, VkPhysicalDeviceProperties2* properties) {
+    if (!host_image_copy_emulated(shared) || !properties) {
+        return;
+    }
+    // Copies go through the driver's own images, so its cache UUID names the
+    // layout as well as anything does.
+    const uint8_t* layout_uuid = shared->physical_device_properties.pipelineCacheUUID;
+    for (auto* next = static_cast<VkBaseOutStructure*>(properties->pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES) {
+            auto* host_copy = reinterpret_cast<VkPhysicalDeviceHostImageCopyProperties*>(next);
+            fill_copy_layouts(&host_copy->copySrcLayoutCount, host_copy->pCopySrcLayouts);
+            fill_copy_layouts(&host_copy->copyDstLayoutCount, host_copy->pCopyDstLayouts);
+            std::memcpy(host_copy->optimalTilingLayoutUUID, layout_uuid, VK_UUID_SIZE);
+            host_copy->identicalMemoryTypeRequirements = VK_FALSE;
+        } else if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_4_PROPERTIES) {
+            auto* vulkan14 = reinterpret_cast<VkPhysicalDeviceVulkan14Properties*>(next);
+            fill_copy_layouts(&vulkan14->copySrcLayoutCount, vulkan14->pCopySrcLayouts);
+            fill_copy_layouts(&vulkan14->copyDstLayoutCount, vulkan14->pCopyDstLayouts);
+            std::memcpy(vulkan14->optimalTilingLayoutUUID, layout_uuid, VK_UUID_SIZE);
+            vulkan14->identicalMemoryTypeRequirements = VK_FALSE;
+        }
+    }
+}
+
+VkResult host_image_copy_get_image_format_properties(const ServerSharedState* shared,
+                                                     VkPhysicalDevice real_physical_device,
+                                                     const VkPhysicalDeviceImageFormatInfo2* info,
+                                                     VkImageFormatProperties2* properties) {
+    if (!host_image_copy_emulated(shared)) {
+        return vkGetPhysicalDeviceImageFormatProperties2(real_physical_device, info, properties);
+    }
+    VkPhysicalDeviceImageFormatInfo2 real_info = *info;
+    real_info.usage = transfer_usage(info->usage);
+
+    VkBaseOutStructure* previous = nullptr;
+    VkBaseOutStructure* query =
+        unlink_struct(properties, VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY, &previous);
+    VkResult result = vkGetPhysicalDeviceImageFormatProperties2(real_physical_device, &real_info, properties);
+    if (query) {
+        query->pNext = previous->pNext;
+        previous->pNext = query;
+        // Staged copies cost the device nothing once they land.
+        auto* performance = reinterpret_cast<VkHostImageCopyDevicePerformanceQuery*>(query);
+        performance->optimalDeviceAccess = VK_TRUE;
+        performance->identicalMemoryLayout = VK_FALSE;
+    }
+    return result;
+}
+
+VkImageUsageFlags host_image_copy_real_usage(const ServerSharedState* shared, VkImageUsageFlags usage) {
+    return host_image_copy_emulated(shared) ? transfer_usage(usage) : usage;
+}
+
+VkResult host_image_copy_create_device(const ServerSharedState* shared,
+                                       VkPhysicalDevice real_physical_device,
+                                       const VkDeviceCreateInfo* info,
+                                       const VkAllocationCallbacks* allocator,
+                                       VkDevice* device) {
+    if (!host_image_copy_emulated(shared)) {
+        return vkCreateDevice(real_physical_device, info, allocator, device);
+    }
+    std::vector<const char*> extensions;
+    for (uint32_t i = 0; i < info->enabledExtensionCount; ++i) {
+        if (std::strcmp(info->ppEnabledExtensionNames[i], VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME) != 0) {
+            extensions.push_back(info->ppEnabledExtensionNames[i]);
+        }
+    }
+    VkDeviceCreateInfo real_info = *info;
+    real_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    real_info.ppEnabledExtensionNames = extensions.empty() ? nullptr : extensions.data();
+
+    VkBaseOutStructure* previous = nullptr;
+    unlink_struct(&real_info, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES, &previous);
+    for (auto* next = reinterpret_cast<VkBaseOutStructure*>(const_cast<void*>(real_info.pNext)); next;
+         next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_4_FEATURES) {
+            reinterpret_cast<VkPhysicalDeviceVulkan14Features*>(next)->hostImageCopy = VK_FALSE;
+        }
+    }
+    return vkCreateDevice(real_physical_device, &real_info, allocator, device);
+}
+
+VkResult host_image_copy_memory_to_image(ServerState* state,
+                                         VkDevice device,
+                                         const VkCopyMemoryToImageInfo* info,
+                                         const size_t* data_sizes) {
+    VkDevice real_device = server_state_get_real_device(state, device);
+    VkImage real_image = server_state_get_real_image(state, info->dstImage);
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    if (real_device == VK_NULL_HANDLE || real_image == VK_NULL_HANDLE ||
+        !state->resource_tracker.get_image_format(info->dstImage, &format)) {
+        HOST_COPY_LOG_ERROR() << "Unknown device or image in vkCopyMemoryToImage";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    uint32_t block_size = 0;
+    std::vector<VkMemoryToImageCopy> regions(info->pRegions, info->pRegions + info->regionCount);
+    std::vector<VkDeviceSize> sizes(info->regionCount);
+    for (uint32_t i = 0; i < info->regionCount; ++i) {
+        VkMemoryToImageCopy& region = regions[i];
+        FormatBlock block;
+        const VkDeviceSize size = region_size(format,
+                                              info->flags,
+                                              region.memoryRowLength,
+                                              region.memoryImageHeight,
+                                              region.imageSubresource,
+                                              region.imageExtent,
+                                              &block);
+        if (size == 0 || data_sizes[i] < size || !region.pHostPointer) {
+            HOST_COPY_LOG_ERROR() << "Host image copy region " << i << " needs " << size << " bytes, got "
+                                  << data_sizes[i];
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+        sizes[i] = size;
+        block_size = std::max(block_size, block.size);
+        if (info->flags & VK_HOST_IMAGE_COPY_MEMCPY) {
+            region.memoryRowLength = 0;
+            region.memoryImageHeight = 0;
+        }
+    }
+
+    if (!host_image_copy_emulated(state->shared)) {
+        VkCopyMemoryToImageInfo real_info = *info;
+        real_info.flags &= ~VK_HOST_IMAGE_COPY_MEMCPY;
+        real_info.dstImage = real_image;
+        real_info.pRegions = regions.data();
+        return state->shared->copy_memory_to_image(real_device, &real_info);
+    }
+
+    StagingTarget target;
+    VkResult result = staging_target(state, device, &target);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    std::vector<ImageUpload> uploads(regions.size());
+    for (size_t i = 0; i < regions.size(); ++i) {
+        const VkMemoryToImageCopy& region = regions[i];
+        uploads[i].region = buffer_image_copy(info->flags,
+                                              region.memoryRowLength,
+                                              region.memoryImageHeight,
+                                              region.imageSubresource,
+                                              region.imageOffset,
+                                              region.imageExtent);
+        uploads[i].data = static_cast<const uint8_t*>(region.pHostPointer);
+        uploads[i].size = sizes[i];
+    }
+    return state->staging_transfer.write_image(target, real_image, info->dstImageLayout, block_size, uploads);
+}
+
+VkResult host_image_copy_image_to_memory(ServerState* state,
+                                         VkDevice device,
+                                         const VkCopyImageToMemoryInfo* info,
+                                         size_t data_size) {
+    VkDevice real_device = server_state_get_real_device(state, device);
+    VkImage real_image = server_state_get_real_image(state, info->srcImage);
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    if (real_device == VK_NULL_HANDLE || real_image == VK_NULL_HANDLE ||
+        !state->resource_tracker.get_image_format(info->srcImage, &format)) {
+        HOST_COPY_LOG_ERROR() << "Unknown device or image in vkCopyImageToMemory";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (info->regionCount != 1 || !info->pRegions[0].pHostPointer) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    VkImageToMemoryCopy region = info->pRegions[0];
+    FormatBlock block;
+    const VkDeviceSize size = region_size(format,
+                                          info->flags,
+                                          region.memoryRowLength,
+                                          region.memoryImageHeight,
+                                          region.imageSubresource,
+                                          region.imageExtent,
+                                          &block);
+    if (size == 0 || data_size < size) {
+        HOST_COPY_LOG_ERROR() << "Host image copy needs " << size << " bytes, got " << data_size;
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (info->flags & VK_HOST_IMAGE_COPY_MEMCPY) {
+        region.memoryRowLength = 0;
+        region.memoryImageHeight = 0;
+    }
+
+    if (!host_image_copy_emulated(state->shared)) {
+        VkCopyImageToMemoryInfo real_info = *info;
+        real_info.flags &= ~VK_HOST_IMAGE_COPY_MEMCPY;
+        real_info.srcImage = real_image;
+        real_info.pRegions = &region;
+        return state->shared->copy_image_to_memory(real_device, &real_info);
+    }
+
+    StagingTarget target;
+    VkResult result = staging_target(state, device, &target);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    const VkBufferImageCopy copy = buffer_image_copy(info->flags,
+                                                     region.memoryRowLength,
+                                                     region.memoryImageHeight,
+                                                     region.imageSubresource,
+                                                     region.imageOffset,
+                                                     region.imageExtent);
+    return state->staging_transfer.read_image(target,
+                                              real_image,
+                                              info->srcImageLayout,
+                                              copy,
+                                              static_cast<uint8_t*>(region.pHostPointer),
+                                              size);
+}
+
+VkResult host_image_copy_image_to_image(ServerState* state, VkDevice device, const VkCopyImageToImageInfo* info) {
+    VkDevice real_device = server_state_get_real_device(state, device);
+    VkCopyImageToImageInfo real_info = *info;
+    real_info.srcImage = server_state_get_real_image(state, info->srcImage);
+    real_info.dstImage = server_state_get_real_image(state, info->dstImage);
+    if (real_device == VK_NULL_HANDLE || real_info.srcImage == VK_NULL_HANDLE ||
+        real_info.dstImage == VK_NULL_HANDLE) {
+        HOST_COPY_LOG_ERROR() << "Unknown device or image in vkCopyImageToImage";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    // Image to image copies move texels between images, so the flag changes
+    // nothing here.
+    if (!host_image_copy_emulated(state->shared)) {
+        return state->shared->copy_image_to_image(real_device, &real_info);
+    }
+
+    StagingTarget target;
+    VkResult result = staging_target(state, device, &target);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    return state->staging_transfer.copy_image(target, real_info);
+}
+
+VkResult host_image_copy_transition_layout(ServerState* state,
+                                           VkDevice device,
+                                           uint32_t count,
+                                           const VkHostImageLayoutTransitionInfo* transitions) {
+    VkDevice real_device = server_state_get_real_device(state, device);
+    if (real_device == VK_NULL_HANDLE) {
+        HOST_COPY_LOG_ERROR() << "Unknown device in vkTransitionImageLayout";
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    std::vector<VkHostImageLayoutTransitionInfo> real_transitions(transitions, transitions + count);
+    for (VkHostImageLayoutTransitionInfo& transition : real_transitions) {
+        VkImage client_image = transition.image;
+        transition.image = server_state_get_real_image(state, client_image);
+        if (transition.image == VK_NULL_HANDLE) {
+            HOST_COPY_LOG_ERROR() << "Unknown image in vkTransitionImageLayout";
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+    }
+    if (!host_image_copy_emulated(state->shared)) {
+        return state->shared->transition_image_layout(real_device, count, real_transitions.data());
+    }
+
+    StagingTarget target;
+    VkResult result = staging_target(state, device, &target);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    return state->staging_transfer.transition_image(target, count, real_transitions.data());
+}
+
+} // namespace venus_plus
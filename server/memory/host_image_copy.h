@@ -0,0 +1,62 @@
+#ifndef VENUS_PLUS_SERVER_HOST_IMAGE_COPY_H
+#define VENUS_PLUS_SERVER_HOST_IMAGE_COPY_H
+
+#include <cstddef>
+#include <vulkan/vulkan.h>
+
+struct ServerState;
+struct ServerSharedState;
+
+namespace venus_plus {
+
+// VK_EXT_host_image_copy for the client. A driver with the extension runs
+// the copies itself. For any other with Vulkan 1.3, or VK_KHR_copy_commands2
+// and VK_KHR_format_feature_flags2, which the extension requires, the server
+// advertises the extension anyway, keeps it and
+// VK_IMAGE_USAGE_HOST_TRANSFER_BIT away from the driver, and runs each copy as
+// transfer commands through StagingTransfer.
+//
+// Texel data travels tightly packed unless the region gives a row length or
+// image height; VK_HOST_IMAGE_COPY_MEMCPY copies travel packed as well,
+// since the client cannot size the driver's own layout.
+bool host_image_copy_emulated(const ServerSharedState* shared);
+
+// Capability queries, adjusted when the extension is emulated.
+VkResult host_image_copy_enumerate_extensions(const ServerSharedState* shared,
+                                              VkPhysicalDevice real_physical_device,
+                                              uint32_t* count,
+                                              VkExtensionProperties* properties);
+void host_image_copy_fill_features(const ServerSharedState* shared, VkPhysicalDeviceFeatures2* features);
+void host_image_copy_fill_properties(const ServerSharedState* shared, VkPhysicalDeviceProperties2* properties);
+VkResult host_image_copy_get_image_format_properties(const ServerSharedState* shared,
+                                                     VkPhysicalDevice real_physical_device,
+                                                     const VkPhysicalDeviceImageFormatInfo2* info,
+                                                     VkImageFormatProperties2* properties);
+// The usage to create a real image with.
+VkImageUsageFlags host_image_copy_real_usage(const ServerSharedState* shared, VkImageUsageFlags usage);
+VkResult host_image_copy_create_device(const ServerSharedState* shared,
+                                       VkPhysicalDevice real_physical_device,
+                                       const VkDeviceCreateInfo* info,
+                                       const VkAllocationCallbacks* allocator,
+                                       VkDevice* device);
+
+// The copies, with the client's handles. |data_sizes| holds the bytes behind
+// each region's pHostPointer; |data_size| those behind the one region of an
+// image to memory copy.
+VkResult host_image_copy_memory_to_image(ServerState* state,
+                                         VkDevice device,
+                                         const VkCopyMemoryToImageInfo* info,
+                                         const size_t* data_sizes);
+VkResult host_image_copy_image_to_memory(ServerState* state,
+                                         VkDevice device,
+                                         const VkCopyImageToMemoryInfo* info,
+                                         size_t data_size);
+VkResult host_image_copy_image_to_image(ServerState* state, VkDevice device, const VkCopyImageToImageInfo* info);
+VkResult host_image_copy_transition_layout(ServerState* state,
+                                           VkDevice device,
+                                           uint32_t count,
+                                           const VkHostImageLayoutTransitionInfo* transitions);
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SERVER_HOST_IMAGE_COPY_H
@@ -35,7 +35,9 @@ VkResult MemoryTransferHandler::handle_transfer_command(const void* data, size_t
     }
 
     const uint8_t* payload = reinterpret_cast<const uint8_t*>(data) + sizeof(header);
-    return write_memory(header, payload, payload_size);
+    VkResult result = write_memory(header, payload, payload_size);
+    VkResult staged = state_->staging_transfer.finish();
+    return result != VK_SUCCESS ? result : staged;
 }
 
 VkResult MemoryTransferHandler::handle_transfer_batch_command(const void* data, size_t size) {
@@ -83,12 +85,14 @@ VkResult MemoryTransferHandler::handle_transfer_batch_command(const void* data,
             payload + consumed,
             static_cast<size_t>(range.size));
         if (result != VK_SUCCESS) {
+            state_->staging_transfer.finish();
             return result;
         }
         consumed += static_cast<size_t>(range.size);
     }
 
-    return VK_SUCCESS;
+    // Staged ranges are copied together, and land before the reply.
+    return state_->staging_transfer.finish();
 }
 
 VkResult MemoryTransferHandler::handle_read_command(const void* data,
@@ -201,6 +205,17 @@ VkResult MemoryTransferHandler::write_memory(const TransferMemoryDataHeader& hea
         return VK_SUCCESS;
     }
 
+    if (needs_staging(type_index)) {
+        StagingTarget target;
+        VkResult result = get_staging_target(reinterpret_cast<VkDeviceMemory>(header.memory_handle),
+                                             real_device,
+                                             &target);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        return state_->staging_transfer.write(target, header.offset, payload, payload_size);
+    }
+
     void* mapped_base = nullptr;
     VkDeviceSize mapped_size = 0;
     VkResult map_result = state_->resource_tracker.get_memory_mapping(
@@ -263,6 +278,21 @@ VkResult MemoryTransferHandler::read_memory(const ReadMemoryDataRequest& request
 
     out_payload->resize(static_cast<size_t>(request.size));
 
+    if (needs_staging(type_index)) {
+        StagingTarget target;
+        VkResult result = get_staging_target(reinterpret_cast<VkDeviceMemory>(request.memory_handle),
+                                             real_device,
+                                             &target);
+        if (result == VK_SUCCESS) {
+            result = state_->staging_transfer.read(target, request.offset, out_payload->data(), request.size);
+        }
+        if (result != VK_SUCCESS) {
+            MEMORY_LOG_ERROR() << "Failed to read memory through staging: " << result;
+            out_payload->clear();
+        }
+        return result;
+    }
+
     void* mapped_base = nullptr;
     VkDeviceSize mapped_size = 0;
     VkResult map_result = state_->resource_tracker.get_memory_mapping(
@@ -293,4 +323,40 @@ VkResult MemoryTransferHandler::read_memory(const ReadMemoryDataRequest& request
     return VK_SUCCESS;
 }
 
+bool MemoryTransferHandler::needs_staging(uint32_t type_index) const {
+    if (!state_->shared) {
+        return false;
+    }
+    const VkPhysicalDeviceMemoryProperties& properties = state_->shared->physical_device_memory_properties;
+    return type_index < properties.memoryTypeCount &&
+           !(properties.memoryTypes[type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+}
+
+VkResult MemoryTransferHandler::get_staging_target(VkDeviceMemory memory,
+                                                   VkDevice real_device,
+                                                   StagingTarget* target) const {
+    // The copies go to the first queue the client fetched, so they are
+    // ordered with its work without queue family ownership transfers.
+    for (const auto& entry : state_->device_info_map) {
+        const DeviceInfo& info = entry.second;
+        if (info.real_handle != real_device) {
+            continue;
+        }
+        if (info.queues.empty()) {
+            MEMORY_LOG_ERROR() << "No queue to stage memory transfers on";
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        target->device = info.client_handle;
+        target->real_device = real_device;
+        target->real_queue = info.queues.front().real_handle;
+        target->queue_family = info.queues.front().family_index;
+        VkResult result = state_->resource_tracker.get_memory_transfer_buffer(memory, &target->buffer);
+        if (result != VK_SUCCESS) {
+            MEMORY_LOG_ERROR() << "Memory cannot be reached by transfers: " << result;
+        }
+        return result;
+    }
+    return VK_ERROR_MEMORY_MAP_FAILED;
+}
+
 } // namespace venus_plus
@@ -5,6 +5,7 @@
 #include <vector>
 #include <vulkan/vulkan.h>
 
+#include "memory/staging_transfer.h"
 #include "protocol/memory_transfer.h"
 
 struct ServerState;
@@ -25,6 +26,9 @@ public:
 private:
     VkResult write_memory(const TransferMemoryDataHeader& header, const uint8_t* payload, size_t payload_size);
     VkResult read_memory(const ReadMemoryDataRequest& request, std::vector<uint8_t>* out_payload);
+    // Memory of a type the host cannot map is reached through staging.
+    bool needs_staging(uint32_t type_index) const;
+    VkResult get_staging_target(VkDeviceMemory memory, VkDevice real_device, StagingTarget* target) const;
 
     ServerState* state_;
 };
@@ -0,0 +1,611 @@
+#include "staging_transfer.h"
+
+#include "utils/logging.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#define STAGING_LOG_ERROR() VP_LOG_STREAM_ERROR(MEMORY)
+
+namespace venus_plus {
+
+namespace {
+
+constexpr VkDeviceSize kSlotSize = 4 * 1024 * 1024;
+constexpr size_t kSlotCount = 2;
+constexpr VkDeviceSize kCopyAlignment = 16;
+
+// Orders the copies after everything submitted earlier on the queue, which
+// covers the client's own work and the previous slot.
+void barrier_before_copies(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void barrier_between_copies(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// Makes the copied bytes visible to the client's later submissions and, for
+// reads, to the host once the fence signals.
+void barrier_after_copies(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// Copies take GENERAL, SHARED_PRESENT or their transfer layout; an image in
+// any other layout is moved to |transfer| for the copy.
+VkImageLayout copy_layout(VkImageLayout layout, VkImageLayout transfer) {
+    if (layout == VK_IMAGE_LAYOUT_GENERAL || layout == VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR || layout == transfer) {
+        return layout;
+    }
+    return transfer;
+}
+
+VkImageSubresourceRange subresource_range(const VkImageSubresourceLayers& layers) {
+    VkImageSubresourceRange range = {};
+    range.aspectMask = layers.aspectMask;
+    range.baseMipLevel = layers.mipLevel;
+    range.levelCount = 1;
+    range.baseArrayLayer = layers.baseArrayLayer;
+    range.layerCount = layers.layerCount;
+    return range;
+}
+
+// Host layout transitions and copies have no pipeline stage to wait on, so
+// the barriers order against everything.
+void image_layout_barrier(VkCommandBuffer command_buffer,
+                          VkImage image,
+                          const VkImageSubresourceRange& range,
+                          VkImageLayout old_layout,
+                          VkImageLayout new_layout) {
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+} // namespace
+
+StagingTransfer::StagingTransfer(const VkPhysicalDeviceMemoryProperties* memory_properties)
+    : memory_properties_(memory_properties) {}
+
+StagingTransfer::~StagingTransfer() {
+    for (auto& entry : rings_) {
+        destroy_ring(*entry.second);
+    }
+}
+
+bool StagingTransfer::create_ring(const StagingTarget& target, Ring* ring) const {
+    ring->real_device = target.real_device;
+    ring->real_queue = target.real_queue;
+    ring->slots.resize(kSlotCount);
+
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = target.queue_family;
+    if (vkCreateCommandPool(ring->real_device, &pool_info, nullptr, &ring->pool) != VK_SUCCESS) {
+        return false;
+    }
+
+    for (Slot& slot : ring->slots) {
+        VkCommandBufferAllocateInfo cb_info = {};
+        cb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cb_info.commandPool = ring->pool;
+        cb_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cb_info.commandBufferCount = 1;
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkAllocateCommandBuffers(ring->real_device, &cb_info, &slot.command_buffer) != VK_SUCCESS ||
+            vkCreateFence(ring->real_device, &fence_info, nullptr, &slot.fence) != VK_SUCCESS) {
+            return false;
+        }
+
+        HostBuffer staging;
+        const bool created = create_host_buffer(ring->real_device, kSlotSize, &staging);
+        // Handed over even when incomplete, for destroy_ring to free.
+        slot.buffer = staging.buffer;
+        slot.memory = staging.memory;
+        slot.mapped = staging.mapped;
+        if (!created) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StagingTransfer::create_host_buffer(VkDevice real_device, VkDeviceSize size, HostBuffer* out) const {
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(real_device, &buffer_info, nullptr, &out->buffer) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(real_device, out->buffer, &requirements);
+    const VkMemoryPropertyFlags wanted =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t type_index = UINT32_MAX;
+    for (uint32_t i = 0; memory_properties_ && i < memory_properties_->memoryTypeCount; ++i) {
+        if ((requirements.memoryTypeBits & (1u << i)) &&
+            (memory_properties_->memoryTypes[i].propertyFlags & wanted) == wanted) {
+            type_index = i;
+            break;
+        }
+    }
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex = type_index;
+    void* mapped = nullptr;
+    if (type_index == UINT32_MAX ||
+        vkAllocateMemory(real_device, &alloc_info, nullptr, &out->memory) != VK_SUCCESS ||
+        vkBindBufferMemory(real_device, out->buffer, out->memory, 0) != VK_SUCCESS ||
+        vkMapMemory(real_device, out->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        return false;
+    }
+    out->mapped = static_cast<uint8_t*>(mapped);
+    return true;
+}
+
+void StagingTransfer::destroy_host_buffer(VkDevice real_device, HostBuffer& buffer) {
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(real_device, buffer.buffer, nullptr);
+    }
+    if (buffer.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(real_device, buffer.memory, nullptr);
+    }
+    buffer = HostBuffer();
+}
+
+void StagingTransfer::destroy_ring(Ring& ring) {
+    for (Slot& slot : ring.slots) {
+        if (slot.pending) {
+            vkWaitForFences(ring.real_device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+        }
+        if (slot.fence != VK_NULL_HANDLE) {
+            vkDestroyFence(ring.real_device, slot.fence, nullptr);
+        }
+        if (slot.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(ring.real_device, slot.buffer, nullptr);
+        }
+        if (slot.memory != VK_NULL_HANDLE) {
+            // Freeing the memory unmaps it.
+            vkFreeMemory(ring.real_device, slot.memory, nullptr);
+        }
+    }
+    ring.slots.clear();
+    if (ring.pool != VK_NULL_HANDLE) {
+        // Frees the slots' command buffers with it.
+        vkDestroyCommandPool(ring.real_device, ring.pool, nullptr);
+        ring.pool = VK_NULL_HANDLE;
+    }
+}
+
+StagingTransfer::Ring* StagingTransfer::ring_locked(const StagingTarget& target) {
+    auto it = rings_.find(handle_key(target.device));
+    if (it != rings_.end()) {
+        return it->second.get();
+    }
+    auto ring = std::make_unique<Ring>();
+    if (!create_ring(target, ring.get())) {
+        STAGING_LOG_ERROR() << "[StagingTransfer] Failed to create staging slots";
+        destroy_ring(*ring);
+        return nullptr;
+    }
+    Ring* result = ring.get();
+    rings_[handle_key(target.device)] = std::move(ring);
+    return result;
+}
+
+VkResult StagingTransfer::wait_slot(Ring& ring, Slot& slot) {
+    if (!slot.pending) {
+        return VK_SUCCESS;
+    }
+    VkResult result = vkWaitForFences(ring.real_device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    slot.pending = false;
+    return vkResetFences(ring.real_device, 1, &slot.fence);
+}
+
+VkResult StagingTransfer::begin_slot(Ring& ring, Slot& slot) {
+    VkResult result = wait_slot(ring, slot);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    result = vkBeginCommandBuffer(slot.command_buffer, &begin_info);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    barrier_before_copies(slot.command_buffer);
+    slot.used = 0;
+    slot.written.clear();
+    slot.recording = true;
+    return VK_SUCCESS;
+}
+
+VkResult StagingTransfer::submit_slot(Ring& ring, Slot& slot) {
+    barrier_after_copies(slot.command_buffer);
+    slot.recording = false;
+    VkResult result = vkEndCommandBuffer(slot.command_buffer);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &slot.command_buffer;
+    result = vkQueueSubmit(ring.real_queue, 1, &submit_info, slot.fence);
+    if (result == VK_SUCCESS) {
+        slot.pending = true;
+    }
+    return result;
+}
+
+VkResult StagingTransfer::write(const StagingTarget& target,
+                                VkDeviceSize offset,
+                                const uint8_t* data,
+                                VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    while (size > 0) {
+        Slot& slot = ring->slots[ring->current];
+        if (slot.recording && slot.used >= kSlotSize) {
+            VkResult result = submit_slot(*ring, slot);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+            ring->current = (ring->current + 1) % ring->slots.size();
+            continue;
+        }
+        if (!slot.recording) {
+            VkResult result = begin_slot(*ring, slot);
+            if (result != VK_SUCCESS) {
+                return result;
+            }
+        }
+
+        const VkDeviceSize chunk = std::min(size, kSlotSize - slot.used);
+        std::memcpy(slot.mapped + slot.used, data, static_cast<size_t>(chunk));
+        const bool overlaps = std::any_of(slot.written.begin(), slot.written.end(), [&](const WrittenRange& range) {
+            return range.buffer == target.buffer && offset < range.offset + range.size &&
+                   range.offset < offset + chunk;
+        });
+        if (overlaps) {
+            barrier_between_copies(slot.command_buffer);
+            slot.written.clear();
+        }
+        VkBufferCopy region = {};
+        region.srcOffset = slot.used;
+        region.dstOffset = offset;
+        region.size = chunk;
+        vkCmdCopyBuffer(slot.command_buffer, slot.buffer, target.buffer, 1, &region);
+        slot.written.push_back({target.buffer, offset, chunk});
+
+        slot.used = std::min(kSlotSize, (slot.used + chunk + kCopyAlignment - 1) & ~(kCopyAlignment - 1));
+        offset += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return VK_SUCCESS;
+}
+
+VkResult StagingTransfer::read(const StagingTarget& target, VkDeviceSize offset, uint8_t* data, VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    // Recorded writes go first; the barrier at the start of the read's slot
+    // orders it after them.
+    Slot& recorded = ring->slots[ring->current];
+    if (recorded.recording) {
+        VkResult result = submit_slot(*ring, recorded);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        ring->current = (ring->current + 1) % ring->slots.size();
+    }
+    while (size > 0) {
+        Slot& slot = ring->slots[ring->current];
+        VkResult result = begin_slot(*ring, slot);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        const VkDeviceSize chunk = std::min(size, kSlotSize);
+        VkBufferCopy region = {};
+        region.srcOffset = offset;
+        region.dstOffset = 0;
+        region.size = chunk;
+        vkCmdCopyBuffer(slot.command_buffer, target.buffer, slot.buffer, 1, &region);
+        result = submit_slot(*ring, slot);
+        if (result == VK_SUCCESS) {
+            result = wait_slot(*ring, slot);
+        }
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        std::memcpy(data, slot.mapped, static_cast<size_t>(chunk));
+        ring->current = (ring->current + 1) % ring->slots.size();
+        offset += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return VK_SUCCESS;
+}
+
+VkResult StagingTransfer::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    VkResult status = VK_SUCCESS;
+    for (auto& entry : rings_) {
+        Ring& ring = *entry.second;
+        Slot& current = ring.slots[ring.current];
+        if (current.recording) {
+            VkResult result = submit_slot(ring, current);
+            if (result != VK_SUCCESS && status == VK_SUCCESS) {
+                status = result;
+            }
+            ring.current = (ring.current + 1) % ring.slots.size();
+        }
+        for (Slot& slot : ring.slots) {
+            VkResult result = wait_slot(ring, slot);
+            if (result != VK_SUCCESS && status == VK_SUCCESS) {
+                status = result;
+            }
+        }
+    }
+    return status;
+}
+
+VkResult StagingTransfer::begin_image_work(Ring& ring, Slot** slot) {
+    Slot& recorded = ring.slots[ring.current];
+    if (recorded.recording) {
+        VkResult result = submit_slot(ring, recorded);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        ring.current = (ring.current + 1) % ring.slots.size();
+    }
+    *slot = &ring.slots[ring.current];
+    return begin_slot(ring, **slot);
+}
+
+VkResult StagingTransfer::end_image_work(Ring& ring, Slot& slot) {
+    VkResult result = submit_slot(ring, slot);
+    if (result == VK_SUCCESS) {
+        result = wait_slot(ring, slot);
+    }
+    ring.current = (ring.current + 1) % ring.slots.size();
+    return result;
+}
+
+VkResult StagingTransfer::write_image(const StagingTarget& target,
+                                      VkImage image,
+                                      VkImageLayout layout,
+                                      uint32_t block_size,
+                                      const std::vector<ImageUpload>& uploads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    Slot* slot = nullptr;
+    VkResult result = begin_image_work(*ring, &slot);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    const VkImageLayout transfer_layout = copy_layout(layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const VkDeviceSize alignment = std::lcm<VkDeviceSize>(std::max(block_size, 1u), kCopyAlignment);
+    // Regions larger than a slot get a buffer of their own until the end.
+    std::vector<HostBuffer> oversized;
+    for (const ImageUpload& upload : uploads) {
+        VkBuffer source = slot->buffer;
+        VkDeviceSize offset = (slot->used + alignment - 1) / alignment * alignment;
+        if (upload.size > kSlotSize) {
+            HostBuffer buffer;
+            const bool created = create_host_buffer(ring->real_device, upload.size, &buffer);
+            oversized.push_back(buffer);
+            if (!created) {
+                result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+                break;
+            }
+            std::memcpy(buffer.mapped, upload.data, static_cast<size_t>(upload.size));
+            source = buffer.buffer;
+            offset = 0;
+        } else {
+            if (offset + upload.size > kSlotSize) {
+                // Run what the slot holds and fill it again.
+                result = submit_slot(*ring, *slot);
+                if (result == VK_SUCCESS) {
+                    result = begin_slot(*ring, *slot);
+                }
+                if (result != VK_SUCCESS) {
+                    break;
+                }
+                offset = 0;
+            }
+            std::memcpy(slot->mapped + offset, upload.data, static_cast<size_t>(upload.size));
+            slot->used = offset + upload.size;
+        }
+
+        VkBufferImageCopy region = upload.region;
+        region.bufferOffset = offset;
+        const VkImageSubresourceRange range = subresource_range(region.imageSubresource);
+        if (transfer_layout != layout) {
+            image_layout_barrier(slot->command_buffer, image, range, layout, transfer_layout);
+        }
+        vkCmdCopyBufferToImage(slot->command_buffer, source, image, transfer_layout, 1, &region);
+        if (transfer_layout != layout) {
+            image_layout_barrier(slot->command_buffer, image, range, transfer_layout, layout);
+        }
+    }
+
+    if (slot->recording) {
+        VkResult end_result = end_image_work(*ring, *slot);
+        if (result == VK_SUCCESS) {
+            result = end_result;
+        }
+    }
+    for (HostBuffer& buffer : oversized) {
+        destroy_host_buffer(ring->real_device, buffer);
+    }
+    return result;
+}
+
+VkResult StagingTransfer::read_image(const StagingTarget& target,
+                                     VkImage image,
+                                     VkImageLayout layout,
+                                     const VkBufferImageCopy& region,
+                                     uint8_t* data,
+                                     VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    HostBuffer oversized;
+    if (size > kSlotSize && !create_host_buffer(ring->real_device, size, &oversized)) {
+        destroy_host_buffer(ring->real_device, oversized);
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    Slot* slot = nullptr;
+    VkResult result = begin_image_work(*ring, &slot);
+    if (result == VK_SUCCESS) {
+        VkBuffer destination = oversized.buffer != VK_NULL_HANDLE ? oversized.buffer : slot->buffer;
+        const uint8_t* mapped = oversized.mapped ? oversized.mapped : slot->mapped;
+        const VkImageLayout transfer_layout = copy_layout(layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        const VkImageSubresourceRange range = subresource_range(region.imageSubresource);
+        VkBufferImageCopy copy = region;
+        copy.bufferOffset = 0;
+        if (transfer_layout != layout) {
+            image_layout_barrier(slot->command_buffer, image, range, layout, transfer_layout);
+        }
+        vkCmdCopyImageToBuffer(slot->command_buffer, image, transfer_layout, destination, 1, &copy);
+        if (transfer_layout != layout) {
+            image_layout_barrier(slot->command_buffer, image, range, transfer_layout, layout);
+        }
+        result = end_image_work(*ring, *slot);
+        if (result == VK_SUCCESS) {
+            std::memcpy(data, mapped, static_cast<size_t>(size));
+        }
+    }
+    destroy_host_buffer(ring->real_device, oversized);
+    return result;
+}
+
+VkResult StagingTransfer::copy_image(const StagingTarget& target, const VkCopyImageToImageInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    Slot* slot = nullptr;
+    VkResult result = begin_image_work(*ring, &slot);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    const VkImageLayout src_layout = copy_layout(info.srcImageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    const VkImageLayout dst_layout = copy_layout(info.dstImageLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    for (uint32_t i = 0; i < info.regionCount; ++i) {
+        const VkImageCopy2& source = info.pRegions[i];
+        VkImageCopy region = {};
+        region.srcSubresource = source.srcSubresource;
+        region.srcOffset = source.srcOffset;
+        region.dstSubresource = source.dstSubresource;
+        region.dstOffset = source.dstOffset;
+        region.extent = source.extent;
+        const VkImageSubresourceRange src_range = subresource_range(region.srcSubresource);
+        const VkImageSubresourceRange dst_range = subresource_range(region.dstSubresource);
+        if (src_layout != info.srcImageLayout) {
+            image_layout_barrier(slot->command_buffer, info.srcImage, src_range, info.srcImageLayout, src_layout);
+        }
+        if (dst_layout != info.dstImageLayout) {
+            image_layout_barrier(slot->command_buffer, info.dstImage, dst_range, info.dstImageLayout, dst_layout);
+        }
+        vkCmdCopyImage(slot->command_buffer, info.srcImage, src_layout, info.dstImage, dst_layout, 1, &region);
+        if (src_layout != info.srcImageLayout) {
+            image_layout_barrier(slot->command_buffer, info.srcImage, src_range, src_layout, info.srcImageLayout);
+        }
+        if (dst_layout != info.dstImageLayout) {
+            image_layout_barrier(slot->command_buffer, info.dstImage, dst_range, dst_layout, info.dstImageLayout);
+        }
+    }
+    return end_image_work(*ring, *slot);
+}
+
+VkResult StagingTransfer::transition_image(const StagingTarget& target,
+                                           uint32_t count,
+                                           const VkHostImageLayoutTransitionInfo* transitions) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring* ring = ring_locked(target);
+    if (!ring) {
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+    Slot* slot = nullptr;
+    VkResult result = begin_image_work(*ring, &slot);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        image_layout_barrier(slot->command_buffer,
+                             transitions[i].image,
+                             transitions[i].subresourceRange,
+                             transitions[i].oldLayout,
+                             transitions[i].newLayout);
+    }
+    return end_image_work(*ring, *slot);
+}
+
+void StagingTransfer::remove_device(VkDevice device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rings_.find(handle_key(device));
+    if (it == rings_.end()) {
+        return;
+    }
+    destroy_ring(*it->second);
+    rings_.erase(it);
+}
+
+} // namespace venus_plus
@@ -0,0 +1,133 @@
+#ifndef VENUS_PLUS_SERVER_STAGING_TRANSFER_H
+#define VENUS_PLUS_SERVER_STAGING_TRANSFER_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+// Where a staged transfer lands: |buffer| spans the client's allocation and
+// the copies run on |real_queue|.
+struct StagingTarget {
+    VkDevice device = VK_NULL_HANDLE;
+    VkDevice real_device = VK_NULL_HANDLE;
+    VkQueue real_queue = VK_NULL_HANDLE;
+    uint32_t queue_family = 0;
+    VkBuffer buffer = VK_NULL_HANDLE; // real handle
+};
+
+// One region of a host copy into an image: |size| bytes at |data|, laid out
+// as |region| describes apart from its bufferOffset.
+struct ImageUpload {
+    VkBufferImageCopy region = {};
+    const uint8_t* data = nullptr;
+    VkDeviceSize size = 0;
+};
+
+// Moves mapped-memory traffic in and out of memory the host cannot map. Each
+// device gets a small ring of host-visible staging slots with a command
+// buffer and fence apiece: writes fill a slot with vkCmdCopyBuffer regions
+// and move on to the next when it is full, so copying one slot overlaps
+// filling the other; finish() submits the rest and waits. Reads copy a slot's
+// worth at a time and wait for it before handing the bytes back.
+class StagingTransfer {
+public:
+    explicit StagingTransfer(const VkPhysicalDeviceMemoryProperties* memory_properties);
+    ~StagingTransfer();
+
+    VkResult write(const StagingTarget& target, VkDeviceSize offset, const uint8_t* data, VkDeviceSize size);
+    VkResult read(const StagingTarget& target, VkDeviceSize offset, uint8_t* data, VkDeviceSize size);
+    // Submits every recorded write and waits until all of them completed.
+    VkResult finish();
+    // Destroys the ring of |device|; call before the real device goes.
+    void remove_device(VkDevice device);
+
+    // Host image copies for a driver without VK_EXT_host_image_copy, run as
+    // transfer commands on the target's queue (|target.buffer| is unused).
+    // An image held in a layout copies cannot use moves to a transfer layout
+    // for the copy and back. Each call returns once the queue finished, as a
+    // host copy is done when it returns. |block_size| is the format's texel
+    // block size, which staging offsets must be a multiple of.
+    VkResult write_image(const StagingTarget& target,
+                         VkImage image,
+                         VkImageLayout layout,
+                         uint32_t block_size,
+                         const std::vector<ImageUpload>& uploads);
+    VkResult read_image(const StagingTarget& target,
+                        VkImage image,
+                        VkImageLayout layout,
+                        const VkBufferImageCopy& region,
+                        uint8_t* data,
+                        VkDeviceSize size);
+    VkResult copy_image(const StagingTarget& target, const VkCopyImageToImageInfo& info);
+    VkResult transition_image(const StagingTarget& target,
+                              uint32_t count,
+                              const VkHostImageLayoutTransitionInfo* transitions);
+
+private:
+    // Host-visible, coherent and persistently mapped.
+    struct HostBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+    };
+
+    struct WrittenRange {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        VkDeviceSize used = 0;
+        bool recording = false;
+        bool pending = false; // submitted, fence not yet waited
+        // Written so far in this recording; an overlapping write needs a
+        // barrier first.
+        std::vector<WrittenRange> written;
+    };
+
+    struct Ring {
+        VkDevice real_device = VK_NULL_HANDLE;
+        VkQueue real_queue = VK_NULL_HANDLE;
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<Slot> slots;
+        size_t current = 0;
+    };
+
+    template <typename T>
+    static uint64_t handle_key(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    Ring* ring_locked(const StagingTarget& target);
+    bool create_ring(const StagingTarget& target, Ring* ring) const;
+    static void destroy_ring(Ring& ring);
+    bool create_host_buffer(VkDevice real_device, VkDeviceSize size, HostBuffer* out) const;
+    static void destroy_host_buffer(VkDevice real_device, HostBuffer& buffer);
+    static VkResult wait_slot(Ring& ring, Slot& slot);
+    static VkResult begin_slot(Ring& ring, Slot& slot);
+    static VkResult submit_slot(Ring& ring, Slot& slot);
+    // Image work starts a slot of its own after any recorded writes and
+    // ends by waiting for it.
+    static VkResult begin_image_work(Ring& ring, Slot** slot);
+    static VkResult end_image_work(Ring& ring, Slot& slot);
+
+    const VkPhysicalDeviceMemoryProperties* memory_properties_ = nullptr;
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::unique_ptr<Ring>> rings_; // by device
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SERVER_STAGING_TRANSFER_H
@@ -0,0 +1,215 @@
+#include "parallel_recorder.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Job {
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<uint8_t> commands;
+    bool end = false;
+};
+
+struct Bucket {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    std::vector<uint8_t> commands;
+};
+
+struct Worker {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    bool stop = false;
+};
+
+} // namespace
+
+struct ParallelRecorder {
+    parallel_recorder_replay_fn replay = nullptr;
+    void* user = nullptr;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Decode thread only.
+    std::unordered_map<VkCommandBuffer, Bucket> buckets;
+
+    // Queued or running jobs per pool; workers decrement.
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    std::unordered_map<VkCommandPool, uint32_t> pending;
+    std::atomic<uint32_t> pending_total{0};
+
+    void run_worker(uint32_t index) {
+        Worker& worker = *workers[index];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        for (;;) {
+            worker.cv.wait(lock, [&] { return worker.stop || !worker.jobs.empty(); });
+            if (worker.jobs.empty()) {
+                return;
+            }
+            Job job = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            lock.unlock();
+
+            replay(user, index, job.command_buffer, job.commands.data(), job.commands.size(), job.end);
+            finish(job.pool);
+
+            lock.lock();
+        }
+    }
+
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            ++pending[job.pool];
+            pending_total.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Pool handles carry their slot index in the low bits.
+        const uint64_t key = reinterpret_cast<uint64_t>(job.pool);
+        Worker& worker = *workers[static_cast<uint32_t>(key) % workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.jobs.push_back(std::move(job));
+        }
+        worker.cv.notify_one();
+    }
+
+    void finish(VkCommandPool pool) {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            auto it = pending.find(pool);
+            if (it != pending.end() && --it->second == 0) {
+                pending.erase(it);
+            }
+            pending_total.fetch_sub(1, std::memory_order_release);
+        }
+        pending_cv.notify_all();
+    }
+};
+
+extern "C" {
+
+struct ParallelRecorder* parallel_recorder_create(uint32_t worker_count,
+                                                  parallel_recorder_replay_fn replay,
+                                                  void* user) {
+    if (worker_count == 0 || !replay) {
+        return nullptr;
+    }
+    auto* recorder = new ParallelRecorder();
+    recorder->replay = replay;
+    recorder->user = user;
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        recorder->workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        recorder->workers[i]->thread = std::thread(&ParallelRecorder::run_worker, recorder, i);
+    }
+    return recorder;
+}
+
+void parallel_recorder_destroy(struct ParallelRecorder* recorder) {
+    if (!recorder) {
+        return;
+    }
+    for (auto& worker : recorder->workers) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stop = true;
+        }
+        worker->cv.notify_one();
+    }
+    // Workers drain their queues before they stop.
+    for (auto& worker : recorder->workers) {
+        worker->thread.join();
+    }
+    delete recorder;
+}
+
+uint32_t parallel_recorder_worker_count(const struct ParallelRecorder* recorder) {
+    return recorder ? static_cast<uint32_t>(recorder->workers.size()) : 0;
+}
+
+void parallel_recorder_begin(struct ParallelRecorder* recorder,
+                             VkCommandBuffer command_buffer,
+                             VkCommandPool pool) {
+    Bucket& bucket = recorder->buckets[command_buffer];
+    bucket.pool = pool;
+    bucket.commands.clear();
+}
+
+bool parallel_recorder_is_capturing(const struct ParallelRecorder* recorder,
+                                    VkCommandBuffer command_buffer) {
+    return recorder->buckets.find(command_buffer) != recorder->buckets.end();
+}
+
+void parallel_recorder_append(struct ParallelRecorder* recorder,
+                              VkCommandBuffer command_buffer,
+                              const void* command,
+                              size_t size) {
+    auto it = recorder->buckets.find(command_buffer);
+    if (it == recorder->buckets.end()) {
+        return;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(command);
+    it->second.commands.insert(it->second.commands.end(), bytes, bytes + size);
+}
+
+bool parallel_recorder_end(struct ParallelRecorder* recorder, VkCommandBuffer command_buffer) {
+    auto it = recorder->buckets.find(command_buffer);
+    if (it == recorder->buckets.end()) {
+        return false;
+    }
+    if (it->second.commands.empty()) {
+        recorder->buckets.erase(it);
+        return false;
+    }
+    Job job;
+    job.command_buffer = command_buffer;
+    job.pool = it->second.pool;
+    job.commands = std::move(it->second.commands);
+    job.end = true;
+    recorder->buckets.erase(it);
+    recorder->submit(std::move(job));
+    return true;
+}
+
+void parallel_recorder_detach(struct ParallelRecorder* recorder, VkCommandBuffer command_buffer) {
+    auto it = recorder->buckets.find(command_buffer);
+    if (it == recorder->buckets.end()) {
+        return;
+    }
+    if (!it->second.commands.empty()) {
+        Job job;
+        job.command_buffer = command_buffer;
+        job.pool = it->second.pool;
+        job.commands = std::move(it->second.commands);
+        recorder->submit(std::move(job));
+    }
+    recorder->buckets.erase(it);
+}
+
+void parallel_recorder_wait_pool(struct ParallelRecorder* recorder, VkCommandPool pool) {
+    if (recorder->pending_total.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(recorder->pending_mutex);
+    recorder->pending_cv.wait(lock, [&] { return recorder->pending.find(pool) == recorder->pending.end(); });
+}
+
+void parallel_recorder_wait_all(struct ParallelRecorder* recorder) {
+    if (recorder->pending_total.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(recorder->pending_mutex);
+    recorder->pending_cv.wait(lock, [&] { return recorder->pending_total.load(std::memory_order_relaxed) == 0; });
+}
+
+} // extern "C"
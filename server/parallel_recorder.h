@@ -0,0 +1,60 @@
+#ifndef VENUS_PLUS_PARALLEL_RECORDER_H
+#define VENUS_PLUS_PARALLEL_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <vulkan/vulkan.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Replays the encoded vkCmd* stream captured for one command buffer on worker
+// |worker|, then ends the command buffer when |end| is set.
+typedef void (*parallel_recorder_replay_fn)(void* user,
+                                            uint32_t worker,
+                                            VkCommandBuffer command_buffer,
+                                            const uint8_t* commands,
+                                            size_t size,
+                                            bool end);
+
+// Buckets the commands recorded into each command buffer between begin and
+// end on the decode thread, and replays every finished bucket on a worker.
+// All buckets of one command pool go to the same worker in order, so a pool
+// is never used from two threads at once. Only the decode thread calls in.
+struct ParallelRecorder;
+
+struct ParallelRecorder* parallel_recorder_create(uint32_t worker_count,
+                                                  parallel_recorder_replay_fn replay,
+                                                  void* user);
+// Waits for outstanding buckets and stops the workers.
+void parallel_recorder_destroy(struct ParallelRecorder* recorder);
+uint32_t parallel_recorder_worker_count(const struct ParallelRecorder* recorder);
+
+// Starts bucketing |command_buffer|, which belongs to |pool|.
+void parallel_recorder_begin(struct ParallelRecorder* recorder,
+                             VkCommandBuffer command_buffer,
+                             VkCommandPool pool);
+bool parallel_recorder_is_capturing(const struct ParallelRecorder* recorder,
+                                    VkCommandBuffer command_buffer);
+void parallel_recorder_append(struct ParallelRecorder* recorder,
+                              VkCommandBuffer command_buffer,
+                              const void* command,
+                              size_t size);
+// Hands the bucket to its worker, which ends the command buffer after the
+// replay. Returns false (and queues nothing) when the bucket is empty, in
+// which case the caller ends the command buffer itself.
+bool parallel_recorder_end(struct ParallelRecorder* recorder, VkCommandBuffer command_buffer);
+// Hands what was bucketed so far to the worker without ending the command
+// buffer and stops bucketing it; later commands for it are decoded inline.
+void parallel_recorder_detach(struct ParallelRecorder* recorder, VkCommandBuffer command_buffer);
+
+void parallel_recorder_wait_pool(struct ParallelRecorder* recorder, VkCommandPool pool);
+void parallel_recorder_wait_all(struct ParallelRecorder* recorder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VENUS_PLUS_PARALLEL_RECORDER_H
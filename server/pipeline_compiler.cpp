@@ -0,0 +1,101 @@
+#include "pipeline_compiler.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Job {
+    const void* owner = nullptr;
+    pipeline_compiler_job_fn run = nullptr;
+    void* data = nullptr;
+};
+
+} // namespace
+
+struct PipelineCompiler {
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable job_cv;
+    std::deque<Job> jobs;
+    bool stop = false;
+
+    // Queued or running jobs per owner.
+    std::condition_variable pending_cv;
+    std::unordered_map<const void*, uint32_t> pending;
+
+    void run_thread() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            job_cv.wait(lock, [&] { return stop || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            Job job = jobs.front();
+            jobs.pop_front();
+            lock.unlock();
+
+            job.run(job.data);
+
+            lock.lock();
+            auto it = pending.find(job.owner);
+            if (it != pending.end() && --it->second == 0) {
+                pending.erase(it);
+                pending_cv.notify_all();
+            }
+        }
+    }
+};
+
+extern "C" {
+
+struct PipelineCompiler* pipeline_compiler_create(uint32_t thread_count) {
+    if (thread_count == 0) {
+        return nullptr;
+    }
+    auto* compiler = new PipelineCompiler();
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        compiler->threads.emplace_back(&PipelineCompiler::run_thread, compiler);
+    }
+    return compiler;
+}
+
+void pipeline_compiler_destroy(struct PipelineCompiler* compiler) {
+    if (!compiler) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(compiler->mutex);
+        compiler->stop = true;
+    }
+    compiler->job_cv.notify_all();
+    // Threads drain the queue before they stop.
+    for (std::thread& thread : compiler->threads) {
+        thread.join();
+    }
+    delete compiler;
+}
+
+void pipeline_compiler_submit(struct PipelineCompiler* compiler,
+                              const void* owner,
+                              pipeline_compiler_job_fn run,
+                              void* job) {
+    {
+        std::lock_guard<std::mutex> lock(compiler->mutex);
+        ++compiler->pending[owner];
+        compiler->jobs.push_back(Job{owner, run, job});
+    }
+    compiler->job_cv.notify_one();
+}
+
+void pipeline_compiler_wait(struct PipelineCompiler* compiler, const void* owner) {
+    std::unique_lock<std::mutex> lock(compiler->mutex);
+    compiler->pending_cv.wait(lock, [&] { return compiler->pending.find(owner) == compiler->pending.end(); });
+}
+
+} // extern "C"
@@ -0,0 +1,33 @@
+#ifndef VENUS_PLUS_PIPELINE_COMPILER_H
+#define VENUS_PLUS_PIPELINE_COMPILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*pipeline_compiler_job_fn)(void* job);
+
+// Threads shared by every session that compile pipelines behind handles the
+// client already has. Jobs start in submission order, so a job never waits
+// for one queued after it. Each job belongs to an owner (the session's
+// renderer) that can wait for its own jobs.
+struct PipelineCompiler;
+
+struct PipelineCompiler* pipeline_compiler_create(uint32_t thread_count);
+// Finishes queued jobs and stops the threads.
+void pipeline_compiler_destroy(struct PipelineCompiler* compiler);
+
+// Runs |run|(|job|) on a compiler thread.
+void pipeline_compiler_submit(struct PipelineCompiler* compiler,
+                              const void* owner,
+                              pipeline_compiler_job_fn run,
+                              void* job);
+void pipeline_compiler_wait(struct PipelineCompiler* compiler, const void* owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VENUS_PLUS_PIPELINE_COMPILER_H
@@ -2,25 +2,62 @@
 
 #include "renderer_decoder.h"
 
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "server_state_bridge.h"
+#include "parallel_recorder.h"
+#include "pipeline_compiler.h"
 #include "branding.h"
+#include "protocol/inline_upload.h"
 #include "vn_protocol_renderer.h"
 #include "vn_cs.h"
 #include "utils/logging_c.h"
 
+// Dispatch context plus what the handlers need to know about the session.
+struct server_dispatch_context {
+    struct vn_dispatch_context ctx;    // must stay first
+    bool trusted;
+    struct VenusRenderer* renderer;
+};
+
 struct VenusRenderer {
-    struct vn_dispatch_context ctx;
+    struct server_dispatch_context dispatch;
     struct vn_cs_decoder* decoder;
     struct vn_cs_encoder* encoder;
     struct ServerState* state;
+
+    // Parallel recording (off unless enabled): record_ctx skips over bucketed
+    // vkCmd* commands on the decode thread; worker_ctx replays them.
+    struct ParallelRecorder* recorder;
+    struct vn_dispatch_context record_ctx;
+    struct server_dispatch_context* worker_ctx;
+    uint32_t worker_count;
+
+    // Asynchronous pipeline creation (off unless enabled): the stream being
+    // handled and where the command in dispatch starts in it, so the
+    // vkCreate*Pipelines handlers can pass their command on to a compiler
+    // thread.
+    struct PipelineCompiler* compiler;
+    const uint8_t* stream;
+    size_t stream_size;
+    size_t command_offset;
 };
 
-static bool command_buffer_recording_guard(struct ServerState* state,
+// Trusted clients (--trusted-client) validate on their side; their recorded
+// commands only get handle translation here.
+static inline bool dispatch_is_trusted(const struct vn_dispatch_context* ctx) {
+    return ((const struct server_dispatch_context*)ctx)->trusted;
+}
+
+static bool command_buffer_recording_guard(struct vn_dispatch_context* ctx,
                                            VkCommandBuffer command_buffer,
                                            const char* name) {
+    if (dispatch_is_trusted(ctx)) {
+        return true;
+    }
+    struct ServerState* state = (struct ServerState*)ctx->data;
     if (!server_state_bridge_command_buffer_is_recording(state, command_buffer)) {
         VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: %s requires command buffer in RECORDING state", name);
         server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
@@ -523,7 +560,7 @@ static void server_dispatch_vkGetPhysicalDeviceImageFormatProperties(
                                                          args->format,
                                                          args->type,
                                                          args->tiling,
-                                                         args->usage,
+                                                         server_state_bridge_get_real_image_usage(state, args->usage),
                                                          args->flags,
                                                          args->pImageFormatProperties);
     if (args->ret != VK_SUCCESS) {
@@ -552,9 +589,10 @@ static void server_dispatch_vkGetPhysicalDeviceImageFormatProperties2(
         return;
     }
 
-    args->ret = vkGetPhysicalDeviceImageFormatProperties2(real_device,
-                                                          args->pImageFormatInfo,
-                                                          args->pImageFormatProperties);
+    args->ret = server_state_bridge_get_image_format_properties2(state,
+                                                                 real_device,
+                                                                 args->pImageFormatInfo,
+                                                                 args->pImageFormatProperties);
     if (args->ret != VK_SUCCESS) {
         VP_LOG_WARN(SERVER, "[Venus Server]   -> vkGetPhysicalDeviceImageFormatProperties2 returned %d", args->ret);
     }
@@ -576,6 +614,7 @@ static void server_dispatch_vkGetPhysicalDeviceProperties2(
         return;
     }
     vkGetPhysicalDeviceProperties2(real_device, args->pProperties);
+    server_state_bridge_fill_host_image_copy_properties(state, args->pProperties);
     vp_branding_apply_properties2(args->pProperties);
 }
 
@@ -595,6 +634,7 @@ static void server_dispatch_vkGetPhysicalDeviceFeatures2(
         return;
     }
     vkGetPhysicalDeviceFeatures2(real_device, args->pFeatures);
+    server_state_bridge_fill_host_image_copy_features(state, args->pFeatures);
 }
 
 static void server_dispatch_vkGetPhysicalDeviceQueueFamilyProperties2(
@@ -662,8 +702,8 @@ static void server_dispatch_vkEnumerateDeviceExtensionProperties(
         return;
     }
 
-    args->ret = vkEnumerateDeviceExtensionProperties(
-        real_device, args->pLayerName, args->pPropertyCount, args->pProperties);
+    args->ret = server_state_bridge_enumerate_device_extensions(
+        state, real_device, args->pPropertyCount, args->pProperties);
     if (args->ret == VK_SUCCESS || args->ret == VK_INCOMPLETE) {
         VP_LOG_INFO(SERVER,
                     "[Venus Server]   -> Returned %u extensions%s",
@@ -730,7 +770,8 @@ static void server_dispatch_vkCreateDevice(
     }
 
     VkDevice real_device = VK_NULL_HANDLE;
-    VkResult create_result = vkCreateDevice(real_physical, args->pCreateInfo, args->pAllocator, &real_device);
+    VkResult create_result = server_state_bridge_create_real_device(
+        state, real_physical, args->pCreateInfo, args->pAllocator, &real_device);
     if (create_result != VK_SUCCESS) {
         args->ret = create_result;
         VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: vkCreateDevice failed: %d", create_result);
@@ -759,6 +800,8 @@ static void server_dispatch_vkDestroyDevice(
         VkDevice real_device = server_state_bridge_get_real_device(state, args->device);
         if (real_device != VK_NULL_HANDLE) {
             vkDeviceWaitIdle(real_device);
+            server_state_bridge_release_device_pipeline_cache(state, args->device);
+            server_state_bridge_release_device_uploads(state, args->device);
             vkDestroyDevice(real_device, args->pAllocator);
         }
         server_state_bridge_remove_device(state, args->device);
@@ -1117,7 +1160,11 @@ static void server_dispatch_vkGetDeviceImageMemoryRequirements(
         return;
     }
 
-    vkGetDeviceImageMemoryRequirements(real_device, args->pInfo, args->pMemoryRequirements);
+    VkImageCreateInfo create_info = *args->pInfo->pCreateInfo;
+    create_info.usage = server_state_bridge_get_real_image_usage(state, create_info.usage);
+    VkDeviceImageMemoryRequirements info = *args->pInfo;
+    info.pCreateInfo = &create_info;
+    vkGetDeviceImageMemoryRequirements(real_device, &info, args->pMemoryRequirements);
 }
 
 static void server_dispatch_vkGetDeviceImageSparseMemoryRequirements(
@@ -1424,77 +1471,174 @@ static bool write_uses_buffer(VkDescriptorType type) {
     }
 }
 
-static void server_dispatch_vkUpdateDescriptorSets(struct vn_dispatch_context* ctx,
-                                                   struct vn_command_vkUpdateDescriptorSets* args) {
-    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkUpdateDescriptorSets (writes=%u, copies=%u)",
-           args->descriptorWriteCount,
-           args->descriptorCopyCount);
-    struct ServerState* state = (struct ServerState*)ctx->data;
-    VkDevice real_device = server_state_bridge_get_real_device(state, args->device);
-    if (real_device == VK_NULL_HANDLE) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown device");
-        return;
+static bool write_uses_image(VkDescriptorType type) {
+    switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        return true;
+    default:
+        return false;
     }
+}
 
-    VkWriteDescriptorSet* writes = NULL;
-    VkDescriptorBufferInfo** buffer_arrays = NULL;
-    VkCopyDescriptorSet* copies = NULL;
-    VkResult result = VK_SUCCESS;
-
-    if (args->descriptorWriteCount > 0) {
-        writes = calloc(args->descriptorWriteCount, sizeof(*writes));
-        buffer_arrays = calloc(args->descriptorWriteCount, sizeof(*buffer_arrays));
-        if (!writes || !buffer_arrays) {
-            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory for descriptor writes");
-            result = VK_ERROR_OUT_OF_HOST_MEMORY;
-            goto cleanup;
+static bool write_uses_texel_buffer(VkDescriptorType type) {
+    return type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+           type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+}
+
+// Copies |count| writes with every handle they reference made real, in one
+// allocation the caller frees. Null handles stay null (nullDescriptor, and
+// the half of an image info its type ignores). Push descriptor writes have
+// no set, so |translate_sets| is false for them.
+static VkWriteDescriptorSet* translate_descriptor_writes(struct ServerState* state,
+                                                         uint32_t count,
+                                                         const VkWriteDescriptorSet* src_writes,
+                                                         bool translate_sets) {
+    size_t buffer_count = 0;
+    size_t image_count = 0;
+    size_t view_count = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const VkWriteDescriptorSet* src = &src_writes[i];
+        if (write_uses_buffer(src->descriptorType)) {
+            buffer_count += src->descriptorCount;
+        } else if (write_uses_image(src->descriptorType)) {
+            image_count += src->descriptorCount;
+        } else if (write_uses_texel_buffer(src->descriptorType)) {
+            view_count += src->descriptorCount;
         }
     }
 
-    for (uint32_t i = 0; i < args->descriptorWriteCount; ++i) {
-        const VkWriteDescriptorSet* src = &args->pDescriptorWrites[i];
-        writes[i] = *src;
-        writes[i].dstSet = server_state_bridge_get_real_descriptor_set(state, src->dstSet);
-        if (writes[i].dstSet == VK_NULL_HANDLE) {
-            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown descriptor set in write %u", i);
-            result = VK_ERROR_INITIALIZATION_FAILED;
-            goto cleanup;
+    const size_t size = count * sizeof(VkWriteDescriptorSet) +
+                        buffer_count * sizeof(VkDescriptorBufferInfo) +
+                        image_count * sizeof(VkDescriptorImageInfo) + view_count * sizeof(VkBufferView);
+    VkWriteDescriptorSet* writes = malloc(size ? size : 1);
+    if (!writes) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory for descriptor writes");
+        return NULL;
+    }
+    VkDescriptorBufferInfo* buffer_infos = (VkDescriptorBufferInfo*)(writes + count);
+    VkDescriptorImageInfo* image_infos = (VkDescriptorImageInfo*)(buffer_infos + buffer_count);
+    VkBufferView* views = (VkBufferView*)(image_infos + image_count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const VkWriteDescriptorSet* src = &src_writes[i];
+        VkWriteDescriptorSet* dst = &writes[i];
+        *dst = *src;
+        if (translate_sets) {
+            dst->dstSet = server_state_bridge_get_real_descriptor_set(state, src->dstSet);
+            if (dst->dstSet == VK_NULL_HANDLE) {
+                VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown descriptor set in write %u", i);
+                goto fail;
+            }
         }
 
         if (write_uses_buffer(src->descriptorType)) {
             if (!src->pBufferInfo) {
                 VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Missing buffer info in write %u", i);
-                result = VK_ERROR_INITIALIZATION_FAILED;
-                goto cleanup;
-            }
-            buffer_arrays[i] =
-                calloc(src->descriptorCount ? src->descriptorCount : 1, sizeof(VkDescriptorBufferInfo));
-            if (!buffer_arrays[i]) {
-                VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory for buffer infos");
-                result = VK_ERROR_OUT_OF_HOST_MEMORY;
-                goto cleanup;
+                goto fail;
             }
             for (uint32_t j = 0; j < src->descriptorCount; ++j) {
-                buffer_arrays[i][j] = src->pBufferInfo[j];
-                buffer_arrays[i][j].buffer =
-                    server_state_bridge_get_real_buffer(state, src->pBufferInfo[j].buffer);
-                if (buffer_arrays[i][j].buffer == VK_NULL_HANDLE) {
+                buffer_infos[j] = src->pBufferInfo[j];
+                if (src->pBufferInfo[j].buffer == VK_NULL_HANDLE) {
+                    continue;
+                }
+                buffer_infos[j].buffer = server_state_bridge_get_real_buffer(state, src->pBufferInfo[j].buffer);
+                if (buffer_infos[j].buffer == VK_NULL_HANDLE) {
                     VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown buffer in write %u", i);
-                    result = VK_ERROR_INITIALIZATION_FAILED;
-                    goto cleanup;
+                    goto fail;
                 }
             }
-            writes[i].pBufferInfo = buffer_arrays[i];
-            writes[i].pImageInfo = NULL;
-            writes[i].pTexelBufferView = NULL;
+            dst->pBufferInfo = buffer_infos;
+            dst->pImageInfo = NULL;
+            dst->pTexelBufferView = NULL;
+            buffer_infos += src->descriptorCount;
+        } else if (write_uses_image(src->descriptorType)) {
+            if (!src->pImageInfo) {
+                VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Missing image info in write %u", i);
+                goto fail;
+            }
+            const bool uses_sampler = src->descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                                      src->descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            const bool uses_view = src->descriptorType != VK_DESCRIPTOR_TYPE_SAMPLER;
+            for (uint32_t j = 0; j < src->descriptorCount; ++j) {
+                const VkDescriptorImageInfo* info = &src->pImageInfo[j];
+                image_infos[j] = *info;
+                image_infos[j].sampler = VK_NULL_HANDLE;
+                image_infos[j].imageView = VK_NULL_HANDLE;
+                if (uses_sampler && info->sampler != VK_NULL_HANDLE) {
+                    image_infos[j].sampler = server_state_bridge_get_real_sampler(state, info->sampler);
+                    if (image_infos[j].sampler == VK_NULL_HANDLE) {
+                        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown sampler in write %u", i);
+                        goto fail;
+                    }
+                }
+                if (uses_view && info->imageView != VK_NULL_HANDLE) {
+                    image_infos[j].imageView = server_state_bridge_get_real_image_view(state, info->imageView);
+                    if (image_infos[j].imageView == VK_NULL_HANDLE) {
+                        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown image view in write %u", i);
+                        goto fail;
+                    }
+                }
+            }
+            dst->pBufferInfo = NULL;
+            dst->pImageInfo = image_infos;
+            dst->pTexelBufferView = NULL;
+            image_infos += src->descriptorCount;
+        } else if (write_uses_texel_buffer(src->descriptorType)) {
+            if (!src->pTexelBufferView) {
+                VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Missing texel buffer view in write %u", i);
+                goto fail;
+            }
+            for (uint32_t j = 0; j < src->descriptorCount; ++j) {
+                views[j] = VK_NULL_HANDLE;
+                if (src->pTexelBufferView[j] == VK_NULL_HANDLE) {
+                    continue;
+                }
+                views[j] = server_state_bridge_get_real_buffer_view(state, src->pTexelBufferView[j]);
+                if (views[j] == VK_NULL_HANDLE) {
+                    VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown buffer view in write %u", i);
+                    goto fail;
+                }
+            }
+            dst->pBufferInfo = NULL;
+            dst->pImageInfo = NULL;
+            dst->pTexelBufferView = views;
+            views += src->descriptorCount;
         }
     }
+    return writes;
 
+fail:
+    free(writes);
+    return NULL;
+}
+
+static void server_dispatch_vkUpdateDescriptorSets(struct vn_dispatch_context* ctx,
+                                                   struct vn_command_vkUpdateDescriptorSets* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkUpdateDescriptorSets (writes=%u, copies=%u)",
+           args->descriptorWriteCount,
+           args->descriptorCopyCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    VkDevice real_device = server_state_bridge_get_real_device(state, args->device);
+    if (real_device == VK_NULL_HANDLE) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown device");
+        return;
+    }
+
+    VkWriteDescriptorSet* writes =
+        translate_descriptor_writes(state, args->descriptorWriteCount, args->pDescriptorWrites, true);
+    if (!writes) {
+        return;
+    }
+
+    VkCopyDescriptorSet* copies = NULL;
     if (args->descriptorCopyCount > 0) {
         copies = calloc(args->descriptorCopyCount, sizeof(*copies));
         if (!copies) {
             VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory for descriptor copies");
-            result = VK_ERROR_OUT_OF_HOST_MEMORY;
             goto cleanup;
         }
     }
@@ -1507,7 +1651,6 @@ static void server_dispatch_vkUpdateDescriptorSets(struct vn_dispatch_context* c
             server_state_bridge_get_real_descriptor_set(state, args->pDescriptorCopies[i].dstSet);
         if (copies[i].srcSet == VK_NULL_HANDLE || copies[i].dstSet == VK_NULL_HANDLE) {
             VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown descriptor set in copy %u", i);
-            result = VK_ERROR_INITIALIZATION_FAILED;
             goto cleanup;
         }
     }
@@ -1520,15 +1663,43 @@ static void server_dispatch_vkUpdateDescriptorSets(struct vn_dispatch_context* c
     VP_LOG_INFO(SERVER, "[Venus Server]   -> Descriptor sets updated");
 
 cleanup:
-    if (buffer_arrays) {
-        for (uint32_t i = 0; i < args->descriptorWriteCount; ++i) {
-            free(buffer_arrays[i]);
-        }
-        free(buffer_arrays);
-    }
     free(writes);
     free(copies);
-    (void)result;
+}
+
+static void server_dispatch_vkCreateDescriptorUpdateTemplate(
+    struct vn_dispatch_context* ctx,
+    struct vn_command_vkCreateDescriptorUpdateTemplate* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCreateDescriptorUpdateTemplate");
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    args->ret = VK_SUCCESS;
+
+    if (!args->pCreateInfo || !args->pDescriptorUpdateTemplate) {
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Missing create info or output pointer");
+        return;
+    }
+
+    VkDescriptorUpdateTemplate update_template =
+        server_state_bridge_create_descriptor_update_template(state, args->device, args->pCreateInfo);
+    if (update_template == VK_NULL_HANDLE) {
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Failed to create descriptor update template");
+        return;
+    }
+    *args->pDescriptorUpdateTemplate = update_template;
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> Descriptor update template created: %p", (void*)update_template);
+}
+
+static void server_dispatch_vkDestroyDescriptorUpdateTemplate(
+    struct vn_dispatch_context* ctx,
+    struct vn_command_vkDestroyDescriptorUpdateTemplate* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkDestroyDescriptorUpdateTemplate (template: %p)",
+           (void*)args->descriptorUpdateTemplate);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (args->descriptorUpdateTemplate != VK_NULL_HANDLE) {
+        server_state_bridge_destroy_descriptor_update_template(state, args->descriptorUpdateTemplate);
+    }
 }
 
 static void server_dispatch_vkCreatePipelineLayout(struct vn_dispatch_context* ctx,
@@ -1763,6 +1934,153 @@ static void server_dispatch_vkDestroyFramebuffer(struct vn_dispatch_context* ctx
     }
 }
 
+struct pipeline_compile_job {
+    struct pipeline_compile_batch* batch;
+    uint32_t first;
+    uint32_t count;
+};
+
+// One vkCreate*Pipelines command, copied and decoded once for all of its
+// compile jobs. Each job compiles create infos [first, first + count) into
+// the handles reserved for them; the last job to finish frees the batch,
+// jobs included.
+struct pipeline_compile_batch {
+    atomic_uint jobs_left;
+    struct ServerState* state;
+    VkPipelineCache real_cache;
+    VkPipelineBindPoint bind_point;
+    struct vn_cs_decoder* decoder; // owns the decoded create infos
+    struct vn_command_vkCreateComputePipelines compute;
+    struct vn_command_vkCreateGraphicsPipelines graphics;
+    VkPipeline* pipelines;
+    struct pipeline_compile_job* jobs;
+    uint8_t command[];
+};
+
+static void free_pipeline_compile_batch(struct pipeline_compile_batch* batch) {
+    vn_cs_decoder_destroy(batch->decoder);
+    free(batch->pipelines);
+    free(batch->jobs);
+    free(batch);
+}
+
+static void release_pipeline_compile_batch(struct pipeline_compile_batch* batch) {
+    if (atomic_fetch_sub_explicit(&batch->jobs_left, 1, memory_order_acq_rel) == 1)
+        free_pipeline_compile_batch(batch);
+}
+
+static void run_pipeline_compile_job(void* data) {
+    struct pipeline_compile_job* job = (struct pipeline_compile_job*)data;
+    struct pipeline_compile_batch* batch = job->batch;
+    if (batch->bind_point == VK_PIPELINE_BIND_POINT_COMPUTE) {
+        server_state_bridge_compile_compute_pipelines(batch->state,
+                                                      batch->real_cache,
+                                                      job->count,
+                                                      batch->compute.pCreateInfos + job->first,
+                                                      batch->pipelines + job->first);
+    } else {
+        server_state_bridge_compile_graphics_pipelines(batch->state,
+                                                       batch->real_cache,
+                                                       job->count,
+                                                       batch->graphics.pCreateInfos + job->first,
+                                                       batch->pipelines + job->first);
+    }
+    release_pipeline_compile_batch(batch);
+}
+
+// Decodes the copy of the command in |batch| into its own temp storage, which
+// lives as long as the batch.
+static bool decode_pipeline_compile_batch(struct pipeline_compile_batch* batch, size_t command_size, uint32_t count) {
+    batch->decoder = vn_cs_decoder_create();
+    if (!batch->decoder)
+        return false;
+    vn_cs_decoder_init(batch->decoder, batch->command, command_size);
+    VkCommandTypeEXT type;
+    VkCommandFlagsEXT flags;
+    vn_decode_VkCommandTypeEXT(batch->decoder, &type);
+    vn_decode_VkFlags(batch->decoder, &flags);
+    const void* infos = NULL;
+    uint32_t info_count = 0;
+    if (batch->bind_point == VK_PIPELINE_BIND_POINT_COMPUTE && type == VK_COMMAND_TYPE_vkCreateComputePipelines_EXT) {
+        vn_decode_vkCreateComputePipelines_args_temp(batch->decoder, &batch->compute);
+        infos = batch->compute.pCreateInfos;
+        info_count = batch->compute.createInfoCount;
+    } else if (batch->bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS &&
+               type == VK_COMMAND_TYPE_vkCreateGraphicsPipelines_EXT) {
+        vn_decode_vkCreateGraphicsPipelines_args_temp(batch->decoder, &batch->graphics);
+        infos = batch->graphics.pCreateInfos;
+        info_count = batch->graphics.createInfoCount;
+    }
+    return !vn_cs_decoder_get_fatal(batch->decoder) && infos && info_count == count;
+}
+
+// Whether a pipeline can be compiled after the reply. Callers that have to
+// see how the compile went (early-return flags, creation feedback) are
+// answered synchronously.
+static bool pipeline_create_info_can_defer(VkPipelineCreateFlags flags, const void* pNext) {
+    if (flags & (VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT |
+                 VK_PIPELINE_CREATE_EARLY_RETURN_ON_FAILURE_BIT))
+        return false;
+    for (const VkBaseInStructure* ext = (const VkBaseInStructure*)pNext; ext; ext = ext->pNext) {
+        if (ext->sType == VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO)
+            return false;
+    }
+    return true;
+}
+
+static bool pipeline_create_info_uses_base_index(VkPipelineCreateFlags flags, int32_t base_index) {
+    return (flags & VK_PIPELINE_CREATE_DERIVATIVE_BIT) && base_index >= 0;
+}
+
+// Reserves the handles and queues the compile of the command in dispatch.
+// Each pipeline gets its own job unless one derives from another in the same
+// batch. Returns false to have the caller create the pipelines inline.
+static bool defer_pipeline_creation(struct vn_dispatch_context* ctx,
+                                    VkDevice device,
+                                    VkPipelineCache cache,
+                                    VkPipelineBindPoint bind_point,
+                                    uint32_t count,
+                                    bool batched,
+                                    VkPipeline* pPipelines) {
+    struct VenusRenderer* renderer = ((struct server_dispatch_context*)ctx)->renderer;
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!renderer || !renderer->compiler || !renderer->stream || count == 0)
+        return false;
+
+    const size_t command_end = renderer->stream_size - vn_cs_decoder_bytes_remaining(ctx->decoder);
+    const size_t command_size = command_end - renderer->command_offset;
+    const uint32_t per_job = batched ? count : 1;
+    const uint32_t job_count = (count + per_job - 1) / per_job;
+    struct pipeline_compile_batch* batch =
+        (struct pipeline_compile_batch*)calloc(1, sizeof(*batch) + command_size);
+    if (!batch)
+        return false;
+    batch->state = state;
+    batch->bind_point = bind_point;
+    batch->pipelines = (VkPipeline*)malloc(count * sizeof(*batch->pipelines));
+    // Everything is allocated before the handles are reserved, so a failure
+    // leaves nothing to undo and the caller still creates them inline.
+    batch->jobs = (struct pipeline_compile_job*)malloc(job_count * sizeof(*batch->jobs));
+    memcpy(batch->command, renderer->stream + renderer->command_offset, command_size);
+    if (!batch->pipelines || !batch->jobs || !decode_pipeline_compile_batch(batch, command_size, count) ||
+        server_state_bridge_reserve_pipelines(state, device, cache, bind_point, count, pPipelines, &batch->real_cache) !=
+            VK_SUCCESS) {
+        free_pipeline_compile_batch(batch);
+        return false;
+    }
+    memcpy(batch->pipelines, pPipelines, count * sizeof(*batch->pipelines));
+    atomic_init(&batch->jobs_left, job_count);
+
+    for (uint32_t i = 0; i < job_count; ++i) {
+        struct pipeline_compile_job* job = &batch->jobs[i];
+        job->batch = batch;
+        job->first = i * per_job;
+        job->count = per_job;
+        pipeline_compiler_submit(renderer->compiler, renderer, run_pipeline_compile_job, job);
+    }
+    return true;
+}
+
 static void server_dispatch_vkCreateComputePipelines(struct vn_dispatch_context* ctx,
                                                      struct vn_command_vkCreateComputePipelines* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCreateComputePipelines (count=%u)",
@@ -1776,6 +2094,27 @@ static void server_dispatch_vkCreateComputePipelines(struct vn_dispatch_context*
         return;
     }
 
+    bool can_defer = true;
+    bool batch = false;
+    for (uint32_t i = 0; i < args->createInfoCount; ++i) {
+        const VkComputePipelineCreateInfo* info = &args->pCreateInfos[i];
+        can_defer = can_defer && pipeline_create_info_can_defer(info->flags, info->pNext);
+        batch = batch || pipeline_create_info_uses_base_index(info->flags, info->basePipelineIndex);
+    }
+    // Unknown handles fail inline, where the error reaches the reply.
+    can_defer = can_defer && server_state_bridge_can_defer_compute_pipelines(
+                                 state, args->pipelineCache, args->createInfoCount, args->pCreateInfos);
+    if (can_defer && defer_pipeline_creation(ctx,
+                                             args->device,
+                                             args->pipelineCache,
+                                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                                             args->createInfoCount,
+                                             batch,
+                                             args->pPipelines)) {
+        VP_LOG_INFO(SERVER, "[Venus Server]   -> Compute pipeline(s) queued for compilation");
+        return;
+    }
+
     args->ret = server_state_bridge_create_compute_pipelines(state,
                                                              args->device,
                                                              args->pipelineCache,
@@ -1802,6 +2141,27 @@ static void server_dispatch_vkCreateGraphicsPipelines(struct vn_dispatch_context
         return;
     }
 
+    bool can_defer = true;
+    bool batch = false;
+    for (uint32_t i = 0; i < args->createInfoCount; ++i) {
+        const VkGraphicsPipelineCreateInfo* info = &args->pCreateInfos[i];
+        can_defer = can_defer && pipeline_create_info_can_defer(info->flags, info->pNext);
+        batch = batch || pipeline_create_info_uses_base_index(info->flags, info->basePipelineIndex);
+    }
+    // Unknown handles fail inline, where the error reaches the reply.
+    can_defer = can_defer && server_state_bridge_can_defer_graphics_pipelines(
+                                 state, args->pipelineCache, args->createInfoCount, args->pCreateInfos);
+    if (can_defer && defer_pipeline_creation(ctx,
+                                             args->device,
+                                             args->pipelineCache,
+                                             VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                             args->createInfoCount,
+                                             batch,
+                                             args->pPipelines)) {
+        VP_LOG_INFO(SERVER, "[Venus Server]   -> Graphics pipeline(s) queued for compilation");
+        return;
+    }
+
     args->ret = server_state_bridge_create_graphics_pipelines(state,
                                                               args->device,
                                                               args->pipelineCache,
@@ -1877,6 +2237,119 @@ static void server_dispatch_vkGetImageSubresourceLayout(struct vn_dispatch_conte
     }
 }
 
+// Host image copies. The MESA variants carry the texel data inline: the
+// client's bytes arrive with the command and image reads return in the reply.
+static void server_dispatch_vkCopyMemoryToImageMESA(struct vn_dispatch_context* ctx,
+                                                    struct vn_command_vkCopyMemoryToImageMESA* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCopyMemoryToImageMESA");
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    const VkCopyMemoryToImageInfoMESA* info = args->pCopyMemoryToImageInfo;
+    if (!info || (info->regionCount > 0 && !info->pRegions)) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: pCopyMemoryToImageInfo is NULL");
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        return;
+    }
+
+    const uint32_t count = info->regionCount;
+    VkMemoryToImageCopy* regions =
+        vn_cs_decoder_alloc_temp_array(ctx->decoder, sizeof(*regions), count ? count : 1);
+    size_t* data_sizes = vn_cs_decoder_alloc_temp_array(ctx->decoder, sizeof(*data_sizes), count ? count : 1);
+    if (!regions || !data_sizes) {
+        args->ret = VK_ERROR_OUT_OF_HOST_MEMORY;
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const VkMemoryToImageCopyMESA* region = &info->pRegions[i];
+        regions[i] = (VkMemoryToImageCopy){
+            .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY,
+            .pHostPointer = region->pData,
+            .memoryRowLength = region->memoryRowLength,
+            .memoryImageHeight = region->memoryImageHeight,
+            .imageSubresource = region->imageSubresource,
+            .imageOffset = region->imageOffset,
+            .imageExtent = region->imageExtent,
+        };
+        data_sizes[i] = region->pData ? region->dataSize : 0;
+    }
+    const VkCopyMemoryToImageInfo copy_info = {
+        .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO,
+        .flags = info->flags,
+        .dstImage = info->dstImage,
+        .dstImageLayout = info->dstImageLayout,
+        .regionCount = count,
+        .pRegions = regions,
+    };
+    args->ret = server_state_bridge_copy_memory_to_image(state, args->device, &copy_info, data_sizes);
+    if (args->ret != VK_SUCCESS) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> vkCopyMemoryToImage failed: %d", args->ret);
+    }
+}
+
+static void server_dispatch_vkCopyImageToMemoryMESA(struct vn_dispatch_context* ctx,
+                                                    struct vn_command_vkCopyImageToMemoryMESA* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCopyImageToMemoryMESA");
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    const VkCopyImageToMemoryInfoMESA* info = args->pCopyImageToMemoryInfo;
+    if (!info || !args->pData) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: pCopyImageToMemoryInfo or pData is NULL");
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        return;
+    }
+
+    const VkImageToMemoryCopy region = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_TO_MEMORY_COPY,
+        .pHostPointer = args->pData,
+        .memoryRowLength = info->memoryRowLength,
+        .memoryImageHeight = info->memoryImageHeight,
+        .imageSubresource = info->imageSubresource,
+        .imageOffset = info->imageOffset,
+        .imageExtent = info->imageExtent,
+    };
+    const VkCopyImageToMemoryInfo copy_info = {
+        .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_MEMORY_INFO,
+        .flags = info->flags,
+        .srcImage = info->srcImage,
+        .srcImageLayout = info->srcImageLayout,
+        .regionCount = 1,
+        .pRegions = &region,
+    };
+    args->ret = server_state_bridge_copy_image_to_memory(state, args->device, &copy_info, args->dataSize);
+    if (args->ret != VK_SUCCESS) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> vkCopyImageToMemory failed: %d", args->ret);
+    }
+}
+
+static void server_dispatch_vkCopyImageToImage(struct vn_dispatch_context* ctx,
+                                               struct vn_command_vkCopyImageToImage* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCopyImageToImage");
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!args->pCopyImageToImageInfo) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: pCopyImageToImageInfo is NULL");
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        return;
+    }
+    args->ret = server_state_bridge_copy_image_to_image(state, args->device, args->pCopyImageToImageInfo);
+    if (args->ret != VK_SUCCESS) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> vkCopyImageToImage failed: %d", args->ret);
+    }
+}
+
+static void server_dispatch_vkTransitionImageLayout(struct vn_dispatch_context* ctx,
+                                                    struct vn_command_vkTransitionImageLayout* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkTransitionImageLayout (count=%u)", args->transitionCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (args->transitionCount > 0 && !args->pTransitions) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: pTransitions is NULL");
+        args->ret = VK_ERROR_INITIALIZATION_FAILED;
+        return;
+    }
+    args->ret = server_state_bridge_transition_image_layout(
+        state, args->device, args->transitionCount, args->pTransitions);
+    if (args->ret != VK_SUCCESS) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> vkTransitionImageLayout failed: %d", args->ret);
+    }
+}
+
 static void server_dispatch_vkCreateCommandPool(struct vn_dispatch_context* ctx,
                                                 struct vn_command_vkCreateCommandPool* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCreateCommandPool");
@@ -1946,6 +2419,10 @@ static void server_dispatch_vkBeginCommandBuffer(struct vn_dispatch_context* ctx
                                                  struct vn_command_vkBeginCommandBuffer* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkBeginCommandBuffer (%p)", (void*)args->commandBuffer);
     struct ServerState* state = (struct ServerState*)ctx->data;
+    if (dispatch_is_trusted(ctx)) {
+        // Trusted clients enforce the reset rules themselves.
+        server_state_bridge_allow_implicit_reset(state, args->commandBuffer);
+    }
     args->ret = server_state_bridge_begin_command_buffer(state, args->commandBuffer, args->pBeginInfo);
     if (args->ret == VK_SUCCESS) {
         VP_LOG_INFO(SERVER, "[Venus Server]   -> Command buffer recording started");
@@ -1982,14 +2459,14 @@ static void server_dispatch_vkCmdCopyBuffer(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdCopyBuffer* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyBuffer (%u regions)", args->regionCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyBuffer")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyBuffer")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_copy_buffer(state,
-                                                      args->srcBuffer,
-                                                      args->dstBuffer,
-                                                      args->regionCount,
-                                                      args->pRegions)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_copy_buffer(state,
+                                                                                   args->srcBuffer,
+                                                                                   args->dstBuffer,
+                                                                                   args->regionCount,
+                                                                                   args->pRegions)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2008,7 +2485,7 @@ static void server_dispatch_vkCmdCopyBuffer2(struct vn_dispatch_context* ctx,
                                              struct vn_command_vkCmdCopyBuffer2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyBuffer2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyBuffer2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyBuffer2")) {
         return;
     }
     if (!args->pCopyBufferInfo || args->pCopyBufferInfo->regionCount == 0 ||
@@ -2017,21 +2494,23 @@ static void server_dispatch_vkCmdCopyBuffer2(struct vn_dispatch_context* ctx,
         return;
     }
 
-    VkBufferCopy* regions = clone_buffer_copy2_array(args->pCopyBufferInfo->regionCount,
-                                                     args->pCopyBufferInfo->pRegions);
-    if (!regions) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyBuffer2");
-        return;
-    }
-    bool valid = server_state_bridge_validate_cmd_copy_buffer(state,
-                                                              args->pCopyBufferInfo->srcBuffer,
-                                                              args->pCopyBufferInfo->dstBuffer,
-                                                              args->pCopyBufferInfo->regionCount,
-                                                              regions);
-    free(regions);
-    if (!valid) {
-        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
-        return;
+    if (!dispatch_is_trusted(ctx)) {
+        VkBufferCopy* regions = clone_buffer_copy2_array(args->pCopyBufferInfo->regionCount,
+                                                         args->pCopyBufferInfo->pRegions);
+        if (!regions) {
+            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyBuffer2");
+            return;
+        }
+        bool valid = server_state_bridge_validate_cmd_copy_buffer(state,
+                                                                  args->pCopyBufferInfo->srcBuffer,
+                                                                  args->pCopyBufferInfo->dstBuffer,
+                                                                  args->pCopyBufferInfo->regionCount,
+                                                                  regions);
+        free(regions);
+        if (!valid) {
+            server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+            return;
+        }
     }
 
     VkCommandBuffer real_cb =
@@ -2053,14 +2532,14 @@ static void server_dispatch_vkCmdCopyImage(struct vn_dispatch_context* ctx,
                                            struct vn_command_vkCmdCopyImage* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyImage (%u regions)", args->regionCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyImage")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyImage")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_copy_image(state,
-                                                     args->srcImage,
-                                                     args->dstImage,
-                                                     args->regionCount,
-                                                     args->pRegions)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_copy_image(state,
+                                                                                  args->srcImage,
+                                                                                  args->dstImage,
+                                                                                  args->regionCount,
+                                                                                  args->pRegions)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2085,7 +2564,7 @@ static void server_dispatch_vkCmdCopyImage2(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdCopyImage2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyImage2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyImage2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyImage2")) {
         return;
     }
     if (!args->pCopyImageInfo || args->pCopyImageInfo->regionCount == 0 ||
@@ -2094,21 +2573,23 @@ static void server_dispatch_vkCmdCopyImage2(struct vn_dispatch_context* ctx,
         return;
     }
 
-    VkImageCopy* regions = clone_image_copy2_array(args->pCopyImageInfo->regionCount,
-                                                   args->pCopyImageInfo->pRegions);
-    if (!regions) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyImage2");
-        return;
-    }
-    bool valid = server_state_bridge_validate_cmd_copy_image(state,
-                                                             args->pCopyImageInfo->srcImage,
-                                                             args->pCopyImageInfo->dstImage,
-                                                             args->pCopyImageInfo->regionCount,
-                                                             regions);
-    free(regions);
-    if (!valid) {
-        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
-        return;
+    if (!dispatch_is_trusted(ctx)) {
+        VkImageCopy* regions = clone_image_copy2_array(args->pCopyImageInfo->regionCount,
+                                                       args->pCopyImageInfo->pRegions);
+        if (!regions) {
+            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyImage2");
+            return;
+        }
+        bool valid = server_state_bridge_validate_cmd_copy_image(state,
+                                                                 args->pCopyImageInfo->srcImage,
+                                                                 args->pCopyImageInfo->dstImage,
+                                                                 args->pCopyImageInfo->regionCount,
+                                                                 regions);
+        free(regions);
+        if (!valid) {
+            server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+            return;
+        }
     }
 
     VkCommandBuffer real_cb =
@@ -2130,14 +2611,14 @@ static void server_dispatch_vkCmdBlitImage(struct vn_dispatch_context* ctx,
                                            struct vn_command_vkCmdBlitImage* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBlitImage (%u regions)", args->regionCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBlitImage")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBlitImage")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_blit_image(state,
-                                                     args->srcImage,
-                                                     args->dstImage,
-                                                     args->regionCount,
-                                                     args->pRegions)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_blit_image(state,
+                                                                                  args->srcImage,
+                                                                                  args->dstImage,
+                                                                                  args->regionCount,
+                                                                                  args->pRegions)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2163,7 +2644,7 @@ static void server_dispatch_vkCmdBlitImage2(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdBlitImage2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBlitImage2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBlitImage2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBlitImage2")) {
         return;
     }
     if (!args->pBlitImageInfo || args->pBlitImageInfo->regionCount == 0 ||
@@ -2172,21 +2653,23 @@ static void server_dispatch_vkCmdBlitImage2(struct vn_dispatch_context* ctx,
         return;
     }
 
-    VkImageBlit* regions = clone_image_blit2_array(args->pBlitImageInfo->regionCount,
-                                                   args->pBlitImageInfo->pRegions);
-    if (!regions) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdBlitImage2");
-        return;
-    }
-    bool valid = server_state_bridge_validate_cmd_blit_image(state,
-                                                             args->pBlitImageInfo->srcImage,
-                                                             args->pBlitImageInfo->dstImage,
-                                                             args->pBlitImageInfo->regionCount,
-                                                             regions);
-    free(regions);
-    if (!valid) {
-        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
-        return;
+    if (!dispatch_is_trusted(ctx)) {
+        VkImageBlit* regions = clone_image_blit2_array(args->pBlitImageInfo->regionCount,
+                                                       args->pBlitImageInfo->pRegions);
+        if (!regions) {
+            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdBlitImage2");
+            return;
+        }
+        bool valid = server_state_bridge_validate_cmd_blit_image(state,
+                                                                 args->pBlitImageInfo->srcImage,
+                                                                 args->pBlitImageInfo->dstImage,
+                                                                 args->pBlitImageInfo->regionCount,
+                                                                 regions);
+        free(regions);
+        if (!valid) {
+            server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+            return;
+        }
     }
 
     VkCommandBuffer real_cb =
@@ -2208,14 +2691,14 @@ static void server_dispatch_vkCmdCopyBufferToImage(struct vn_dispatch_context* c
                                                    struct vn_command_vkCmdCopyBufferToImage* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyBufferToImage (%u regions)", args->regionCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyBufferToImage")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyBufferToImage")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_copy_buffer_to_image(state,
-                                                               args->srcBuffer,
-                                                               args->dstImage,
-                                                               args->regionCount,
-                                                               args->pRegions)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_copy_buffer_to_image(state,
+                                                                                            args->srcBuffer,
+                                                                                            args->dstImage,
+                                                                                            args->regionCount,
+                                                                                            args->pRegions)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2239,7 +2722,7 @@ static void server_dispatch_vkCmdCopyBufferToImage2(struct vn_dispatch_context*
                                                     struct vn_command_vkCmdCopyBufferToImage2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyBufferToImage2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyBufferToImage2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyBufferToImage2")) {
         return;
     }
     if (!args->pCopyBufferToImageInfo || args->pCopyBufferToImageInfo->regionCount == 0 ||
@@ -2248,21 +2731,23 @@ static void server_dispatch_vkCmdCopyBufferToImage2(struct vn_dispatch_context*
         return;
     }
 
-    VkBufferImageCopy* regions = clone_buffer_image_copy2_array(args->pCopyBufferToImageInfo->regionCount,
-                                                                args->pCopyBufferToImageInfo->pRegions);
-    if (!regions) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyBufferToImage2");
-        return;
-    }
-    bool valid = server_state_bridge_validate_cmd_copy_buffer_to_image(state,
-                                                                       args->pCopyBufferToImageInfo->srcBuffer,
-                                                                       args->pCopyBufferToImageInfo->dstImage,
-                                                                       args->pCopyBufferToImageInfo->regionCount,
-                                                                       regions);
-    free(regions);
-    if (!valid) {
-        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
-        return;
+    if (!dispatch_is_trusted(ctx)) {
+        VkBufferImageCopy* regions = clone_buffer_image_copy2_array(args->pCopyBufferToImageInfo->regionCount,
+                                                                    args->pCopyBufferToImageInfo->pRegions);
+        if (!regions) {
+            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyBufferToImage2");
+            return;
+        }
+        bool valid = server_state_bridge_validate_cmd_copy_buffer_to_image(state,
+                                                                           args->pCopyBufferToImageInfo->srcBuffer,
+                                                                           args->pCopyBufferToImageInfo->dstImage,
+                                                                           args->pCopyBufferToImageInfo->regionCount,
+                                                                           regions);
+        free(regions);
+        if (!valid) {
+            server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+            return;
+        }
     }
 
     VkCommandBuffer real_cb =
@@ -2284,14 +2769,14 @@ static void server_dispatch_vkCmdCopyImageToBuffer(struct vn_dispatch_context* c
                                                    struct vn_command_vkCmdCopyImageToBuffer* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyImageToBuffer (%u regions)", args->regionCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyImageToBuffer")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyImageToBuffer")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_copy_image_to_buffer(state,
-                                                               args->srcImage,
-                                                               args->dstBuffer,
-                                                               args->regionCount,
-                                                               args->pRegions)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_copy_image_to_buffer(state,
+                                                                                            args->srcImage,
+                                                                                            args->dstBuffer,
+                                                                                            args->regionCount,
+                                                                                            args->pRegions)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2315,7 +2800,7 @@ static void server_dispatch_vkCmdCopyImageToBuffer2(struct vn_dispatch_context*
                                                     struct vn_command_vkCmdCopyImageToBuffer2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyImageToBuffer2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyImageToBuffer2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyImageToBuffer2")) {
         return;
     }
     if (!args->pCopyImageToBufferInfo || args->pCopyImageToBufferInfo->regionCount == 0 ||
@@ -2324,21 +2809,23 @@ static void server_dispatch_vkCmdCopyImageToBuffer2(struct vn_dispatch_context*
         return;
     }
 
-    VkBufferImageCopy* regions = clone_buffer_image_copy2_array(args->pCopyImageToBufferInfo->regionCount,
-                                                                args->pCopyImageToBufferInfo->pRegions);
-    if (!regions) {
-        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyImageToBuffer2");
-        return;
-    }
-    bool valid = server_state_bridge_validate_cmd_copy_image_to_buffer(state,
-                                                                       args->pCopyImageToBufferInfo->srcImage,
-                                                                       args->pCopyImageToBufferInfo->dstBuffer,
-                                                                       args->pCopyImageToBufferInfo->regionCount,
-                                                                       regions);
-    free(regions);
-    if (!valid) {
-        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
-        return;
+    if (!dispatch_is_trusted(ctx)) {
+        VkBufferImageCopy* regions = clone_buffer_image_copy2_array(args->pCopyImageToBufferInfo->regionCount,
+                                                                    args->pCopyImageToBufferInfo->pRegions);
+        if (!regions) {
+            VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory in vkCmdCopyImageToBuffer2");
+            return;
+        }
+        bool valid = server_state_bridge_validate_cmd_copy_image_to_buffer(state,
+                                                                           args->pCopyImageToBufferInfo->srcImage,
+                                                                           args->pCopyImageToBufferInfo->dstBuffer,
+                                                                           args->pCopyImageToBufferInfo->regionCount,
+                                                                           regions);
+        free(regions);
+        if (!valid) {
+            server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+            return;
+        }
     }
 
     VkCommandBuffer real_cb =
@@ -2360,7 +2847,7 @@ static void server_dispatch_vkCmdResolveImage2(struct vn_dispatch_context* ctx,
                                                struct vn_command_vkCmdResolveImage2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdResolveImage2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdResolveImage2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdResolveImage2")) {
         return;
     }
     if (!args->pResolveImageInfo || args->pResolveImageInfo->regionCount == 0 ||
@@ -2388,10 +2875,10 @@ static void server_dispatch_vkCmdFillBuffer(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdFillBuffer* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdFillBuffer");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdFillBuffer")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdFillBuffer")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_fill_buffer(state, args->dstBuffer, args->dstOffset, args->size)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_fill_buffer(state, args->dstBuffer, args->dstOffset, args->size)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2409,14 +2896,14 @@ static void server_dispatch_vkCmdUpdateBuffer(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdUpdateBuffer* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdUpdateBuffer (size=%llu)", (unsigned long long)args->dataSize);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdUpdateBuffer")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdUpdateBuffer")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_update_buffer(state,
-                                                        args->dstBuffer,
-                                                        args->dstOffset,
-                                                        args->dataSize,
-                                                        args->pData)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_update_buffer(state,
+                                                                                     args->dstBuffer,
+                                                                                     args->dstOffset,
+                                                                                     args->dataSize,
+                                                                                     args->pData)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2430,17 +2917,219 @@ static void server_dispatch_vkCmdUpdateBuffer(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdUpdateBuffer recorded");
 }
 
+// VENUS_PLUS_CMD_INLINE_UPLOAD (see protocol/inline_upload.h): a run of
+// vkCmdUpdateBuffer calls the client packed into one command. The data is
+// decoded straight into staging memory owned by the command buffer and
+// copied with as few vkCmdCopyBuffer calls as the regions allow.
+struct inline_upload_range {
+    VkBuffer dst;
+    VkDeviceSize begin;
+    VkDeviceSize end;
+};
+
+struct inline_upload_run {
+    VkBuffer src;
+    VkBuffer dst;
+    VkDeviceSize dst_begin;
+    VkDeviceSize dst_end;
+    uint32_t count;
+    VkBufferCopy* regions;
+    // What the runs recorded since the last barrier write.
+    struct inline_upload_range* written;
+    uint32_t written_count;
+};
+
+// The smallest region: three 8-byte words and 4 bytes of data.
+#define INLINE_UPLOAD_MIN_REGION_SIZE 28u
+
+static void flush_inline_upload_run(VkCommandBuffer real_cb, struct inline_upload_run* run) {
+    if (run->count > 0) {
+        vkCmdCopyBuffer(real_cb, run->src, run->dst, run->count, run->regions);
+        struct inline_upload_range* range = &run->written[run->written_count++];
+        range->dst = run->dst;
+        range->begin = run->dst_begin;
+        range->end = run->dst_end;
+    }
+    run->count = 0;
+}
+
+// The updates were recorded in order, so a region that overlaps an earlier
+// run waits for it: copies are not ordered among themselves.
+static void order_inline_upload_region(VkCommandBuffer real_cb,
+                                       struct inline_upload_run* run,
+                                       VkBuffer dst,
+                                       VkDeviceSize offset,
+                                       VkDeviceSize size) {
+    for (uint32_t i = 0; i < run->written_count; ++i) {
+        const struct inline_upload_range* range = &run->written[i];
+        if (range->dst == dst && offset < range->end && offset + size > range->begin) {
+            const VkMemoryBarrier barrier = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            };
+            vkCmdPipelineBarrier(real_cb, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1,
+                                 &barrier, 0, NULL, 0, NULL);
+            run->written_count = 0;
+            return;
+        }
+    }
+}
+
+// Reads the command's header; false when the stream is damaged.
+static bool decode_inline_upload_header(struct vn_cs_decoder* dec,
+                                        VkCommandBuffer* command_buffer,
+                                        uint32_t* region_count) {
+    VkCommandTypeEXT cmd_type;
+    VkCommandFlagsEXT cmd_flags;
+    vn_decode_VkCommandTypeEXT(dec, &cmd_type);
+    vn_decode_VkFlags(dec, &cmd_flags);
+    vn_decode_VkCommandBuffer_lookup(dec, command_buffer);
+    vn_decode_uint32_t(dec, region_count);
+    if (vn_cs_decoder_get_fatal(dec) || (cmd_flags & VK_COMMAND_GENERATE_REPLY_BIT_EXT) ||
+        *region_count > vn_cs_decoder_bytes_remaining(dec) / INLINE_UPLOAD_MIN_REGION_SIZE) {
+        vn_cs_decoder_set_fatal(dec);
+        return false;
+    }
+    return true;
+}
+
+static bool decode_inline_upload_region(struct vn_cs_decoder* dec,
+                                        VkBuffer* dst,
+                                        VkDeviceSize* offset,
+                                        VkDeviceSize* size) {
+    vn_decode_VkBuffer_lookup(dec, dst);
+    vn_decode_VkDeviceSize(dec, offset);
+    vn_decode_VkDeviceSize(dec, size);
+    if (vn_cs_decoder_get_fatal(dec) || *size > vn_cs_decoder_bytes_remaining(dec)) {
+        vn_cs_decoder_set_fatal(dec);
+        return false;
+    }
+    return true;
+}
+
+static void skip_inline_upload_data(struct vn_cs_decoder* dec, VkDeviceSize size) {
+    vn_cs_decoder_read(dec, ((size_t)size + 3) & ~(size_t)3, NULL, 0);
+}
+
+// Moves over the command without recording it, for parallel recording.
+static void skip_inline_upload(struct vn_cs_decoder* dec) {
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    uint32_t region_count = 0;
+    if (!decode_inline_upload_header(dec, &command_buffer, &region_count)) {
+        return;
+    }
+    for (uint32_t i = 0; i < region_count; ++i) {
+        VkBuffer dst = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        if (!decode_inline_upload_region(dec, &dst, &offset, &size)) {
+            return;
+        }
+        skip_inline_upload_data(dec, size);
+    }
+}
+
+static void server_dispatch_inline_upload(struct vn_dispatch_context* ctx) {
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    struct vn_cs_decoder* dec = ctx->decoder;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    uint32_t region_count = 0;
+    if (!decode_inline_upload_header(dec, &command_buffer, &region_count)) {
+        return;
+    }
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching inline upload (%u regions)", region_count);
+
+    VkCommandBuffer real_cb = VK_NULL_HANDLE;
+    if (command_buffer_recording_guard(ctx, command_buffer, "inline upload")) {
+        real_cb = get_real_command_buffer(state, command_buffer, "inline upload");
+    }
+    struct inline_upload_run run = {0};
+    if (region_count > 0) {
+        run.regions = (VkBufferCopy*)vn_cs_decoder_alloc_temp_array(dec, sizeof(VkBufferCopy), region_count);
+        run.written = (struct inline_upload_range*)vn_cs_decoder_alloc_temp_array(
+            dec, sizeof(struct inline_upload_range), region_count);
+        if (!run.regions || !run.written) {
+            vn_cs_decoder_set_fatal(dec);
+            return;
+        }
+    }
+
+    // After a failure the rest is only decoded past; the buffer is invalid.
+    bool failed = real_cb == VK_NULL_HANDLE;
+    for (uint32_t i = 0; i < region_count; ++i) {
+        VkBuffer dst = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        if (!decode_inline_upload_region(dec, &dst, &offset, &size)) {
+            return;
+        }
+        VkBuffer staging = VK_NULL_HANDLE;
+        VkDeviceSize staging_offset = 0;
+        void* data = NULL;
+        if (failed || size == 0 ||
+            !server_state_bridge_allocate_inline_upload(state, command_buffer, size, &staging,
+                                                        &staging_offset, &data)) {
+            if (!failed) {
+                VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: No staging space for inline upload");
+                server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
+                failed = true;
+            }
+            skip_inline_upload_data(dec, size);
+            continue;
+        }
+        vn_decode_blob_array(dec, data, (size_t)size);
+        if (vn_cs_decoder_get_fatal(dec)) {
+            return;
+        }
+        VkBuffer real_dst = VK_NULL_HANDLE;
+        if (dispatch_is_trusted(ctx) ||
+            server_state_bridge_validate_cmd_update_buffer(state, dst, offset, size, data)) {
+            real_dst = get_real_buffer(state, dst, "inline upload");
+        }
+        if (real_dst == VK_NULL_HANDLE) {
+            server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
+            failed = true;
+            continue;
+        }
+
+        // One copy may not write a byte twice, so a region that overlaps the
+        // run starts a new one, ordered after it.
+        if (run.count > 0 && (run.src != staging || run.dst != real_dst ||
+                              (offset < run.dst_end && offset + size > run.dst_begin))) {
+            flush_inline_upload_run(real_cb, &run);
+        }
+        if (run.count == 0) {
+            order_inline_upload_region(real_cb, &run, real_dst, offset, size);
+            run.src = staging;
+            run.dst = real_dst;
+            run.dst_begin = offset;
+            run.dst_end = offset + size;
+        } else {
+            run.dst_begin = offset < run.dst_begin ? offset : run.dst_begin;
+            run.dst_end = offset + size > run.dst_end ? offset + size : run.dst_end;
+        }
+        VkBufferCopy* region = &run.regions[run.count++];
+        region->srcOffset = staging_offset;
+        region->dstOffset = offset;
+        region->size = size;
+    }
+    if (!failed) {
+        flush_inline_upload_run(real_cb, &run);
+    }
+}
+
 static void server_dispatch_vkCmdClearColorImage(struct vn_dispatch_context* ctx,
                                                  struct vn_command_vkCmdClearColorImage* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdClearColorImage (ranges=%u)", args->rangeCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdClearColorImage")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdClearColorImage")) {
         return;
     }
-    if (!server_state_bridge_validate_cmd_clear_color_image(state,
-                                                            args->image,
-                                                            args->rangeCount,
-                                                            args->pRanges)) {
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_clear_color_image(state,
+                                                                                         args->image,
+                                                                                         args->rangeCount,
+                                                                                         args->pRanges)) {
         server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
         return;
     }
@@ -2463,7 +3152,7 @@ static void server_dispatch_vkCmdBeginRenderPass(struct vn_dispatch_context* ctx
                                                  struct vn_command_vkCmdBeginRenderPass* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBeginRenderPass");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBeginRenderPass")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBeginRenderPass")) {
         return;
     }
     if (!args->pRenderPassBegin) {
@@ -2490,7 +3179,7 @@ static void server_dispatch_vkCmdEndRenderPass(struct vn_dispatch_context* ctx,
                                                struct vn_command_vkCmdEndRenderPass* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdEndRenderPass");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdEndRenderPass")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdEndRenderPass")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2506,7 +3195,7 @@ static void server_dispatch_vkCmdBeginRendering(struct vn_dispatch_context* ctx,
                                                 struct vn_command_vkCmdBeginRendering* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBeginRendering");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBeginRendering")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBeginRendering")) {
         return;
     }
     if (!args->pRenderingInfo) {
@@ -2574,7 +3263,7 @@ static void server_dispatch_vkCmdEndRendering(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdEndRendering* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdEndRendering");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdEndRendering")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdEndRendering")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2589,7 +3278,7 @@ static void server_dispatch_vkCmdBindPipeline(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdBindPipeline* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBindPipeline");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBindPipeline")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBindPipeline")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdBindPipeline");
@@ -2609,7 +3298,7 @@ static void server_dispatch_vkCmdBindVertexBuffers(struct vn_dispatch_context* c
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBindVertexBuffers (count=%u)",
            args->bindingCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBindVertexBuffers")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBindVertexBuffers")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2648,7 +3337,7 @@ static void server_dispatch_vkCmdBindDescriptorSets(struct vn_dispatch_context*
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBindDescriptorSets (count=%u)",
            args->descriptorSetCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBindDescriptorSets")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBindDescriptorSets")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2690,11 +3379,172 @@ static void server_dispatch_vkCmdBindDescriptorSets(struct vn_dispatch_context*
     free(real_sets);
 }
 
+static void server_dispatch_vkCmdPushDescriptorSet(struct vn_dispatch_context* ctx,
+                                                   struct vn_command_vkCmdPushDescriptorSet* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdPushDescriptorSetKHR (set=%u, writes=%u)",
+           args->set, args->descriptorWriteCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdPushDescriptorSetKHR")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdPushDescriptorSetKHR");
+    if (!real_cb) {
+        return;
+    }
+    PFN_vkCmdPushDescriptorSetKHR push = server_state_bridge_get_cmd_push_descriptor_set(state);
+    VkPipelineLayout real_layout = server_state_bridge_get_real_pipeline_layout(state, args->layout);
+    if (!push || real_layout == VK_NULL_HANDLE) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: %s",
+                     push ? "Unknown pipeline layout" : "VK_KHR_push_descriptor unavailable");
+        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+        return;
+    }
+    VkWriteDescriptorSet* writes =
+        translate_descriptor_writes(state, args->descriptorWriteCount, args->pDescriptorWrites, false);
+    if (!writes) {
+        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+        return;
+    }
+    push(real_cb, args->pipelineBindPoint, real_layout, args->set, args->descriptorWriteCount, writes);
+    free(writes);
+}
+
+// vkUpdateDescriptorSetWithTemplate and vkCmdPushDescriptorSetWithTemplateKHR
+// take a void* the Venus protocol cannot describe, so the generated decoder
+// has no entry for them. The client sends the data packed to the layout the
+// template was created with, as a blob:
+//
+//   vkUpdateDescriptorSetWithTemplate:  device, set, template, size, data
+//   vkCmdPushDescriptorSetWithTemplate: commandBuffer, template, layout, set, size, data
+//
+// and the template's entries tell where the handles in it are.
+static bool decode_descriptor_update_data(struct vn_cs_decoder* dec, void** data, size_t* size) {
+    vn_decode_size_t(dec, size);
+    if (vn_cs_decoder_get_fatal(dec) || *size > vn_cs_decoder_bytes_remaining(dec)) {
+        vn_cs_decoder_set_fatal(dec);
+        return false;
+    }
+    *data = vn_cs_decoder_alloc_temp(dec, *size ? *size : 1);
+    if (!*data) {
+        vn_cs_decoder_set_fatal(dec);
+        return false;
+    }
+    vn_decode_blob_array(dec, *data, *size);
+    return !vn_cs_decoder_get_fatal(dec);
+}
+
+static void server_dispatch_vkUpdateDescriptorSetWithTemplate(struct vn_dispatch_context* ctx) {
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate update_template = VK_NULL_HANDLE;
+    void* data = NULL;
+    size_t size = 0;
+    vn_decode_VkDevice_lookup(ctx->decoder, &device);
+    vn_decode_VkDescriptorSet_lookup(ctx->decoder, &set);
+    vn_decode_VkDescriptorUpdateTemplate_lookup(ctx->decoder, &update_template);
+    if (!decode_descriptor_update_data(ctx->decoder, &data, &size)) {
+        return;
+    }
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkUpdateDescriptorSetWithTemplate (set: %p, %zu bytes)",
+           (void*)set, size);
+
+    VkDescriptorSet real_set = server_state_bridge_get_real_descriptor_set(state, set);
+    VkDevice real_device = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate real_template = VK_NULL_HANDLE;
+    if (real_set == VK_NULL_HANDLE ||
+        !server_state_bridge_translate_descriptor_update_data(state, update_template, data, size,
+                                                              &real_device, &real_template)) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Unknown set, template or descriptor handle");
+        return;
+    }
+    vkUpdateDescriptorSetWithTemplate(real_device, real_set, real_template, data);
+}
+
+static void server_dispatch_vkCmdPushDescriptorSetWithTemplate(struct vn_dispatch_context* ctx) {
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate update_template = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t set = 0;
+    void* data = NULL;
+    size_t size = 0;
+    vn_decode_VkCommandBuffer_lookup(ctx->decoder, &command_buffer);
+    vn_decode_VkDescriptorUpdateTemplate_lookup(ctx->decoder, &update_template);
+    vn_decode_VkPipelineLayout_lookup(ctx->decoder, &layout);
+    vn_decode_uint32_t(ctx->decoder, &set);
+    if (!decode_descriptor_update_data(ctx->decoder, &data, &size)) {
+        return;
+    }
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdPushDescriptorSetWithTemplateKHR (set=%u, %zu bytes)",
+           set, size);
+
+    if (!command_buffer_recording_guard(ctx, command_buffer, "vkCmdPushDescriptorSetWithTemplateKHR")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, command_buffer, "vkCmdPushDescriptorSetWithTemplateKHR");
+    if (!real_cb) {
+        return;
+    }
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR push =
+        server_state_bridge_get_cmd_push_descriptor_set_with_template(state);
+    VkPipelineLayout real_layout = server_state_bridge_get_real_pipeline_layout(state, layout);
+    VkDevice real_device = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate real_template = VK_NULL_HANDLE;
+    if (!push || real_layout == VK_NULL_HANDLE ||
+        !server_state_bridge_translate_descriptor_update_data(state, update_template, data, size,
+                                                              &real_device, &real_template)) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: %s",
+                     push ? "Unknown layout, template or descriptor handle" : "VK_KHR_push_descriptor unavailable");
+        server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
+        return;
+    }
+    push(real_cb, real_template, real_layout, set, data);
+}
+
+// vn_dispatch_command plus the template commands it has no entry for and
+// inline uploads.
+static void dispatch_next_command(struct vn_dispatch_context* ctx) {
+    uint32_t header[2] = {0};
+    if (vn_cs_decoder_bytes_remaining(ctx->decoder) >= sizeof(header)) {
+        vn_cs_decoder_peek(ctx->decoder, sizeof(header), header, sizeof(header));
+    }
+    if (header[0] == VENUS_PLUS_CMD_INLINE_UPLOAD) {
+        server_dispatch_inline_upload(ctx);
+        vn_cs_decoder_reset_temp_pool(ctx->decoder);
+        return;
+    }
+    const VkCommandTypeEXT type = (VkCommandTypeEXT)header[0];
+    if (type != VK_COMMAND_TYPE_vkUpdateDescriptorSetWithTemplate_EXT &&
+        type != VK_COMMAND_TYPE_vkCmdPushDescriptorSetWithTemplate_EXT) {
+        vn_dispatch_command(ctx);
+        return;
+    }
+
+    VkCommandTypeEXT cmd_type;
+    VkCommandFlagsEXT cmd_flags;
+    vn_decode_VkCommandTypeEXT(ctx->decoder, &cmd_type);
+    vn_decode_VkFlags(ctx->decoder, &cmd_flags);
+    if (cmd_flags & VK_COMMAND_GENERATE_REPLY_BIT_EXT) {
+        // Neither returns anything; the client never asks.
+        vn_cs_decoder_set_fatal(ctx->decoder);
+        return;
+    }
+    if (cmd_type == VK_COMMAND_TYPE_vkUpdateDescriptorSetWithTemplate_EXT) {
+        server_dispatch_vkUpdateDescriptorSetWithTemplate(ctx);
+    } else {
+        server_dispatch_vkCmdPushDescriptorSetWithTemplate(ctx);
+    }
+    vn_cs_decoder_reset_temp_pool(ctx->decoder);
+}
+
 static void server_dispatch_vkCmdPushConstants(struct vn_dispatch_context* ctx,
                                                struct vn_command_vkCmdPushConstants* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdPushConstants");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdPushConstants")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdPushConstants")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2717,7 +3567,7 @@ static void server_dispatch_vkCmdDispatch(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDispatch (%u, %u, %u)",
            args->groupCountX, args->groupCountY, args->groupCountZ);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdDispatch")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDispatch")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdDispatch");
@@ -2731,7 +3581,7 @@ static void server_dispatch_vkCmdDispatchIndirect(struct vn_dispatch_context* ct
                                                   struct vn_command_vkCmdDispatchIndirect* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDispatchIndirect");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdDispatchIndirect")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDispatchIndirect")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2747,7 +3597,7 @@ static void server_dispatch_vkCmdDispatchBase(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdDispatchBase* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDispatchBase");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdDispatchBase")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDispatchBase")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2769,7 +3619,7 @@ static void server_dispatch_vkCmdSetViewport(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetViewport (count=%u)",
            args->viewportCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetViewport")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetViewport")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2790,7 +3640,7 @@ static void server_dispatch_vkCmdSetScissor(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetScissor (count=%u)",
            args->scissorCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetScissor")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetScissor")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2810,7 +3660,7 @@ static void server_dispatch_vkCmdSetCullMode(struct vn_dispatch_context* ctx,
                                              struct vn_command_vkCmdSetCullMode* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetCullMode");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetCullMode")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetCullMode")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetCullMode");
@@ -2824,7 +3674,7 @@ static void server_dispatch_vkCmdSetFrontFace(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdSetFrontFace* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetFrontFace");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetFrontFace")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetFrontFace")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetFrontFace");
@@ -2838,7 +3688,7 @@ static void server_dispatch_vkCmdSetPrimitiveTopology(struct vn_dispatch_context
                                                       struct vn_command_vkCmdSetPrimitiveTopology* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetPrimitiveTopology");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetPrimitiveTopology")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetPrimitiveTopology")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2854,7 +3704,7 @@ static void server_dispatch_vkCmdSetViewportWithCount(struct vn_dispatch_context
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetViewportWithCount (count=%u)",
            args->viewportCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetViewportWithCount")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetViewportWithCount")) {
         return;
     }
     if (!args->pViewports || args->viewportCount == 0) {
@@ -2874,7 +3724,7 @@ static void server_dispatch_vkCmdSetScissorWithCount(struct vn_dispatch_context*
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetScissorWithCount (count=%u)",
            args->scissorCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetScissorWithCount")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetScissorWithCount")) {
         return;
     }
     if (!args->pScissors || args->scissorCount == 0) {
@@ -2893,7 +3743,7 @@ static void server_dispatch_vkCmdSetDepthTestEnable(struct vn_dispatch_context*
                                                     struct vn_command_vkCmdSetDepthTestEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetDepthTestEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetDepthTestEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetDepthTestEnable")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2908,7 +3758,7 @@ static void server_dispatch_vkCmdSetDepthWriteEnable(struct vn_dispatch_context*
                                                      struct vn_command_vkCmdSetDepthWriteEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetDepthWriteEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetDepthWriteEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetDepthWriteEnable")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2923,7 +3773,7 @@ static void server_dispatch_vkCmdSetDepthCompareOp(struct vn_dispatch_context* c
                                                    struct vn_command_vkCmdSetDepthCompareOp* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetDepthCompareOp");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetDepthCompareOp")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetDepthCompareOp")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -2939,7 +3789,7 @@ static void server_dispatch_vkCmdSetDepthBoundsTestEnable(
     struct vn_command_vkCmdSetDepthBoundsTestEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetDepthBoundsTestEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetDepthBoundsTestEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetDepthBoundsTestEnable")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetDepthBoundsTestEnable");
@@ -2953,7 +3803,7 @@ static void server_dispatch_vkCmdSetStencilTestEnable(struct vn_dispatch_context
                                                       struct vn_command_vkCmdSetStencilTestEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetStencilTestEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetStencilTestEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetStencilTestEnable")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetStencilTestEnable");
@@ -2967,7 +3817,7 @@ static void server_dispatch_vkCmdSetStencilOp(struct vn_dispatch_context* ctx,
                                               struct vn_command_vkCmdSetStencilOp* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetStencilOp");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetStencilOp")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetStencilOp")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetStencilOp");
@@ -2987,7 +3837,7 @@ static void server_dispatch_vkCmdSetRasterizerDiscardEnable(
     struct vn_command_vkCmdSetRasterizerDiscardEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetRasterizerDiscardEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetRasterizerDiscardEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetRasterizerDiscardEnable")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetRasterizerDiscardEnable");
@@ -3001,7 +3851,7 @@ static void server_dispatch_vkCmdSetDepthBiasEnable(struct vn_dispatch_context*
                                                     struct vn_command_vkCmdSetDepthBiasEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetDepthBiasEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetDepthBiasEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetDepthBiasEnable")) {
         return;
     }
     VkCommandBuffer real_cb = get_real_command_buffer(state, args->commandBuffer, "vkCmdSetDepthBiasEnable");
@@ -3016,7 +3866,7 @@ static void server_dispatch_vkCmdSetPrimitiveRestartEnable(
     struct vn_command_vkCmdSetPrimitiveRestartEnable* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetPrimitiveRestartEnable");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetPrimitiveRestartEnable")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetPrimitiveRestartEnable")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3032,7 +3882,7 @@ static void server_dispatch_vkCmdDraw(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDraw (verts=%u inst=%u)",
            args->vertexCount, args->instanceCount);
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdDraw")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDraw")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3048,11 +3898,196 @@ static void server_dispatch_vkCmdDraw(struct vn_dispatch_context* ctx,
     VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDraw recorded");
 }
 
+static void server_dispatch_vkCmdBindIndexBuffer(struct vn_dispatch_context* ctx,
+                                                 struct vn_command_vkCmdBindIndexBuffer* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBindIndexBuffer (type=%d)",
+           args->indexType);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBindIndexBuffer")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdBindIndexBuffer");
+    VkBuffer real_buffer = get_real_buffer(state, args->buffer, "vkCmdBindIndexBuffer");
+    if (real_cb == VK_NULL_HANDLE || real_buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkCmdBindIndexBuffer(real_cb, real_buffer, args->offset, args->indexType);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdBindIndexBuffer recorded");
+}
+
+static void server_dispatch_vkCmdDrawIndexed(struct vn_dispatch_context* ctx,
+                                             struct vn_command_vkCmdDrawIndexed* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDrawIndexed (indices=%u inst=%u)",
+           args->indexCount, args->instanceCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDrawIndexed")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdDrawIndexed");
+    if (!real_cb) {
+        return;
+    }
+    vkCmdDrawIndexed(real_cb,
+                     args->indexCount,
+                     args->instanceCount,
+                     args->firstIndex,
+                     args->vertexOffset,
+                     args->firstInstance);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDrawIndexed recorded");
+}
+
+static void server_dispatch_vkCmdDrawIndirect(struct vn_dispatch_context* ctx,
+                                              struct vn_command_vkCmdDrawIndirect* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDrawIndirect (draws=%u)",
+           args->drawCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDrawIndirect")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdDrawIndirect");
+    VkBuffer real_buffer = get_real_buffer(state, args->buffer, "vkCmdDrawIndirect");
+    if (real_cb == VK_NULL_HANDLE || real_buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkCmdDrawIndirect(real_cb, real_buffer, args->offset, args->drawCount, args->stride);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDrawIndirect recorded");
+}
+
+static void server_dispatch_vkCmdDrawIndexedIndirect(struct vn_dispatch_context* ctx,
+                                                     struct vn_command_vkCmdDrawIndexedIndirect* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDrawIndexedIndirect (draws=%u)",
+           args->drawCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDrawIndexedIndirect")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdDrawIndexedIndirect");
+    VkBuffer real_buffer = get_real_buffer(state, args->buffer, "vkCmdDrawIndexedIndirect");
+    if (real_cb == VK_NULL_HANDLE || real_buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkCmdDrawIndexedIndirect(real_cb, real_buffer, args->offset, args->drawCount, args->stride);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDrawIndexedIndirect recorded");
+}
+
+static void server_dispatch_vkCmdDrawIndirectCount(struct vn_dispatch_context* ctx,
+                                                   struct vn_command_vkCmdDrawIndirectCount* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDrawIndirectCount (max=%u)",
+           args->maxDrawCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDrawIndirectCount")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdDrawIndirectCount");
+    VkBuffer real_buffer = get_real_buffer(state, args->buffer, "vkCmdDrawIndirectCount");
+    VkBuffer real_count_buffer =
+        get_real_buffer(state, args->countBuffer, "vkCmdDrawIndirectCount");
+    if (real_cb == VK_NULL_HANDLE || real_buffer == VK_NULL_HANDLE ||
+        real_count_buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    PFN_vkCmdDrawIndirectCount draw = server_state_bridge_get_cmd_draw_indirect_count(state);
+    if (!draw) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Draw indirect count unavailable");
+        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+        return;
+    }
+    draw(real_cb,
+         real_buffer,
+         args->offset,
+         real_count_buffer,
+         args->countBufferOffset,
+         args->maxDrawCount,
+         args->stride);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDrawIndirectCount recorded");
+}
+
+static void server_dispatch_vkCmdDrawIndexedIndirectCount(
+    struct vn_dispatch_context* ctx,
+    struct vn_command_vkCmdDrawIndexedIndirectCount* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdDrawIndexedIndirectCount (max=%u)",
+           args->maxDrawCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdDrawIndexedIndirectCount")) {
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdDrawIndexedIndirectCount");
+    VkBuffer real_buffer = get_real_buffer(state, args->buffer, "vkCmdDrawIndexedIndirectCount");
+    VkBuffer real_count_buffer =
+        get_real_buffer(state, args->countBuffer, "vkCmdDrawIndexedIndirectCount");
+    if (real_cb == VK_NULL_HANDLE || real_buffer == VK_NULL_HANDLE ||
+        real_count_buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    PFN_vkCmdDrawIndexedIndirectCount draw = server_state_bridge_get_cmd_draw_indexed_indirect_count(state);
+    if (!draw) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Draw indirect count unavailable");
+        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+        return;
+    }
+    draw(real_cb,
+         real_buffer,
+         args->offset,
+         real_count_buffer,
+         args->countBufferOffset,
+         args->maxDrawCount,
+         args->stride);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdDrawIndexedIndirectCount recorded");
+}
+
+static void server_dispatch_vkCmdExecuteCommands(struct vn_dispatch_context* ctx,
+                                                 struct vn_command_vkCmdExecuteCommands* args) {
+    VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdExecuteCommands (count=%u)",
+           args->commandBufferCount);
+    struct ServerState* state = (struct ServerState*)ctx->data;
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdExecuteCommands")) {
+        return;
+    }
+    if (args->commandBufferCount == 0 || !args->pCommandBuffers) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Invalid parameters for vkCmdExecuteCommands");
+        return;
+    }
+    if (!dispatch_is_trusted(ctx) && !server_state_bridge_validate_cmd_execute_commands(state,
+                                                                                        args->commandBuffer,
+                                                                                        args->commandBufferCount,
+                                                                                        args->pCommandBuffers)) {
+        server_state_bridge_mark_command_buffer_invalid(state, args->commandBuffer);
+        return;
+    }
+    VkCommandBuffer real_cb =
+        get_real_command_buffer(state, args->commandBuffer, "vkCmdExecuteCommands");
+    if (!real_cb) {
+        return;
+    }
+    VkCommandBuffer* real_secondaries = calloc(args->commandBufferCount, sizeof(*real_secondaries));
+    if (!real_secondaries) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Out of memory for secondary command buffers");
+        return;
+    }
+    for (uint32_t i = 0; i < args->commandBufferCount; ++i) {
+        real_secondaries[i] =
+            get_real_command_buffer(state, args->pCommandBuffers[i], "vkCmdExecuteCommands");
+        if (real_secondaries[i] == VK_NULL_HANDLE) {
+            free(real_secondaries);
+            return;
+        }
+    }
+    vkCmdExecuteCommands(real_cb, args->commandBufferCount, real_secondaries);
+    free(real_secondaries);
+    VP_LOG_INFO(SERVER, "[Venus Server]   -> vkCmdExecuteCommands recorded");
+}
+
 static void server_dispatch_vkCmdPipelineBarrier(struct vn_dispatch_context* ctx,
                                                  struct vn_command_vkCmdPipelineBarrier* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdPipelineBarrier");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdPipelineBarrier")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdPipelineBarrier")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3122,7 +4157,7 @@ static void server_dispatch_vkCmdPipelineBarrier2(struct vn_dispatch_context* ct
                                                   struct vn_command_vkCmdPipelineBarrier2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdPipelineBarrier2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdPipelineBarrier2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdPipelineBarrier2")) {
         return;
     }
     if (!args->pDependencyInfo) {
@@ -3163,7 +4198,7 @@ static void server_dispatch_vkCmdResetQueryPool(struct vn_dispatch_context* ctx,
                                                 struct vn_command_vkCmdResetQueryPool* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdResetQueryPool");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdResetQueryPool")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdResetQueryPool")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3179,7 +4214,7 @@ static void server_dispatch_vkCmdBeginQuery(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdBeginQuery* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdBeginQuery");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdBeginQuery")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdBeginQuery")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3195,7 +4230,7 @@ static void server_dispatch_vkCmdEndQuery(struct vn_dispatch_context* ctx,
                                           struct vn_command_vkCmdEndQuery* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdEndQuery");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdEndQuery")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdEndQuery")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3211,7 +4246,7 @@ static void server_dispatch_vkCmdWriteTimestamp(struct vn_dispatch_context* ctx,
                                                 struct vn_command_vkCmdWriteTimestamp* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdWriteTimestamp");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdWriteTimestamp")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdWriteTimestamp")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3227,7 +4262,7 @@ static void server_dispatch_vkCmdWriteTimestamp2(struct vn_dispatch_context* ctx
                                                  struct vn_command_vkCmdWriteTimestamp2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdWriteTimestamp2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdWriteTimestamp2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdWriteTimestamp2")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3244,7 +4279,7 @@ static void server_dispatch_vkCmdCopyQueryPoolResults(struct vn_dispatch_context
                                                       struct vn_command_vkCmdCopyQueryPoolResults* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdCopyQueryPoolResults");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdCopyQueryPoolResults")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdCopyQueryPoolResults")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3268,7 +4303,7 @@ static void server_dispatch_vkCmdSetEvent(struct vn_dispatch_context* ctx,
                                           struct vn_command_vkCmdSetEvent* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetEvent");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetEvent")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetEvent")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3284,7 +4319,7 @@ static void server_dispatch_vkCmdSetEvent2(struct vn_dispatch_context* ctx,
                                            struct vn_command_vkCmdSetEvent2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdSetEvent2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdSetEvent2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdSetEvent2")) {
         return;
     }
     if (!args->pDependencyInfo) {
@@ -3323,7 +4358,7 @@ static void server_dispatch_vkCmdResetEvent(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdResetEvent* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdResetEvent");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdResetEvent")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdResetEvent")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3339,7 +4374,7 @@ static void server_dispatch_vkCmdResetEvent2(struct vn_dispatch_context* ctx,
                                              struct vn_command_vkCmdResetEvent2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdResetEvent2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdResetEvent2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdResetEvent2")) {
         return;
     }
     VkCommandBuffer real_cb =
@@ -3355,7 +4390,7 @@ static void server_dispatch_vkCmdWaitEvents(struct vn_dispatch_context* ctx,
                                             struct vn_command_vkCmdWaitEvents* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdWaitEvents");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdWaitEvents")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdWaitEvents")) {
         return;
     }
 
@@ -3448,7 +4483,7 @@ static void server_dispatch_vkCmdWaitEvents2(struct vn_dispatch_context* ctx,
                                              struct vn_command_vkCmdWaitEvents2* args) {
     VP_LOG_INFO(SERVER, "[Venus Server] Dispatching vkCmdWaitEvents2");
     struct ServerState* state = (struct ServerState*)ctx->data;
-    if (!command_buffer_recording_guard(state, args->commandBuffer, "vkCmdWaitEvents2")) {
+    if (!command_buffer_recording_guard(ctx, args->commandBuffer, "vkCmdWaitEvents2")) {
         return;
     }
     if (args->eventCount == 0 || !args->pEvents || !args->pDependencyInfos) {
@@ -3691,12 +4726,291 @@ static void server_dispatch_vkDeviceWaitIdle(struct vn_dispatch_context* ctx,
     args->ret = server_state_bridge_device_wait_idle(state, args->device);
 }
 
+/* Parallel recording */
+
+// Commands recorded into a command buffer, which parallel recording may
+// bucket and replay on a worker.
+#define SERVER_RECORDED_COMMANDS(X) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyBuffer2) \
+    X(vkCmdCopyImage) \
+    X(vkCmdCopyImage2) \
+    X(vkCmdBlitImage) \
+    X(vkCmdBlitImage2) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyBufferToImage2) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdCopyImageToBuffer2) \
+    X(vkCmdResolveImage2) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdUpdateBuffer) \
+    X(vkCmdClearColorImage) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdBeginRendering) \
+    X(vkCmdEndRendering) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdPushDescriptorSet) \
+    X(vkCmdPushConstants) \
+    X(vkCmdDispatch) \
+    X(vkCmdDispatchIndirect) \
+    X(vkCmdDispatchBase) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetViewportWithCount) \
+    X(vkCmdSetScissor) \
+    X(vkCmdSetScissorWithCount) \
+    X(vkCmdSetCullMode) \
+    X(vkCmdSetFrontFace) \
+    X(vkCmdSetPrimitiveTopology) \
+    X(vkCmdSetDepthTestEnable) \
+    X(vkCmdSetDepthWriteEnable) \
+    X(vkCmdSetDepthCompareOp) \
+    X(vkCmdSetDepthBoundsTestEnable) \
+    X(vkCmdSetStencilTestEnable) \
+    X(vkCmdSetStencilOp) \
+    X(vkCmdSetRasterizerDiscardEnable) \
+    X(vkCmdSetDepthBiasEnable) \
+    X(vkCmdSetPrimitiveRestartEnable) \
+    X(vkCmdDraw) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndirect) \
+    X(vkCmdDrawIndexedIndirect) \
+    X(vkCmdDrawIndirectCount) \
+    X(vkCmdDrawIndexedIndirectCount) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdPipelineBarrier2) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdBeginQuery) \
+    X(vkCmdEndQuery) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCmdWriteTimestamp2) \
+    X(vkCmdCopyQueryPoolResults) \
+    X(vkCmdSetEvent) \
+    X(vkCmdSetEvent2) \
+    X(vkCmdResetEvent) \
+    X(vkCmdResetEvent2) \
+    X(vkCmdWaitEvents) \
+    X(vkCmdWaitEvents2)
+
+#define SERVER_SKIP_RECORDED_COMMAND(name)                                              \
+    static void record_dispatch_##name(struct vn_dispatch_context* ctx,                 \
+                                       struct vn_command_##name* args) {                \
+        (void)ctx;                                                                      \
+        (void)args;                                                                     \
+    }
+SERVER_RECORDED_COMMANDS(SERVER_SKIP_RECORDED_COMMAND)
+#undef SERVER_SKIP_RECORDED_COMMAND
+
+static void venus_renderer_destroy_parallel_recording(struct VenusRenderer* renderer);
+
+static bool is_recorded_command(VkCommandTypeEXT type) {
+    switch (type) {
+#define SERVER_RECORDED_COMMAND_CASE(name) case VK_COMMAND_TYPE_##name##_EXT:
+    SERVER_RECORDED_COMMANDS(SERVER_RECORDED_COMMAND_CASE)
+#undef SERVER_RECORDED_COMMAND_CASE
+        return true;
+    default:
+        return false;
+    }
+}
+
+// vkEndCommandBuffer for a bucketed command buffer: the worker ends it after
+// the replay, so the reply is sent before the real result is known. A failed
+// replay or end leaves the buffer invalid and the submit that uses it fails.
+static void record_dispatch_vkEndCommandBuffer(struct vn_dispatch_context* ctx,
+                                               struct vn_command_vkEndCommandBuffer* args) {
+    struct VenusRenderer* renderer = (struct VenusRenderer*)ctx->data;
+    if (!parallel_recorder_end(renderer->recorder, args->commandBuffer)) {
+        server_dispatch_vkEndCommandBuffer(&renderer->dispatch.ctx, args);
+        return;
+    }
+    VP_LOG_INFO(SERVER, "[Venus Server] vkEndCommandBuffer (%p) deferred to recording worker",
+                (void*)args->commandBuffer);
+    args->ret = VK_SUCCESS;
+}
+
+static void replay_recorded_commands(void* user,
+                                     uint32_t worker,
+                                     VkCommandBuffer command_buffer,
+                                     const uint8_t* commands,
+                                     size_t size,
+                                     bool end) {
+    struct VenusRenderer* renderer = (struct VenusRenderer*)user;
+    struct vn_dispatch_context* ctx = &renderer->worker_ctx[worker].ctx;
+    struct ServerState* state = renderer->state;
+
+    vn_cs_decoder_init(ctx->decoder, commands, size);
+    vn_cs_encoder_init_dynamic(ctx->encoder);
+    while (vn_cs_decoder_bytes_remaining(ctx->decoder) > 0 && !vn_cs_decoder_get_fatal(ctx->decoder)) {
+        dispatch_next_command(ctx);
+    }
+    const bool failed = vn_cs_decoder_get_fatal(ctx->decoder);
+    vn_cs_decoder_reset_temp_storage(ctx->decoder);
+    if (failed) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Replay of %p failed on recording worker %u",
+                     (void*)command_buffer, worker);
+        server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
+        return;
+    }
+    if (!end) {
+        return;
+    }
+    VkResult result = server_state_bridge_end_command_buffer(state, command_buffer);
+    if (result != VK_SUCCESS) {
+        VP_LOG_ERROR(SERVER, "[Venus Server]   -> ERROR: Deferred vkEndCommandBuffer (%p) failed (result=%d)",
+                     (void*)command_buffer, result);
+        server_state_bridge_mark_command_buffer_invalid(state, command_buffer);
+    }
+}
+
+// Routes the next command when parallel recording is on. Returns true when it
+// was consumed here; otherwise the caller dispatches it inline, after every
+// bucket has been replayed so the command sees finished command buffers.
+static bool record_next_command(struct VenusRenderer* renderer, const uint8_t* stream, size_t stream_size) {
+    struct ParallelRecorder* recorder = renderer->recorder;
+    struct ServerState* state = renderer->state;
+    struct vn_cs_decoder* dec = renderer->decoder;
+
+    // Every vkCmd*, vkBeginCommandBuffer and vkEndCommandBuffer starts with
+    // type, flags and the command buffer id.
+    uint32_t header[4] = {0};
+    const size_t remaining = vn_cs_decoder_bytes_remaining(dec);
+    if (remaining < sizeof(header)) {
+        parallel_recorder_wait_all(recorder);
+        return false;
+    }
+    vn_cs_decoder_peek(dec, sizeof(header), header, sizeof(header));
+    const VkCommandTypeEXT type = (VkCommandTypeEXT)header[0];
+    const VkCommandFlagsEXT flags = header[1];
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    memcpy(&command_buffer, &header[2], sizeof(command_buffer));
+
+    if (type == VK_COMMAND_TYPE_vkBeginCommandBuffer_EXT) {
+        // Only this buffer's pool has to be idle; other pools keep replaying.
+        VkCommandPool pool = server_state_bridge_get_command_buffer_pool(state, command_buffer);
+        parallel_recorder_detach(recorder, command_buffer);
+        parallel_recorder_wait_pool(recorder, pool);
+        vn_dispatch_command(&renderer->dispatch.ctx);
+        if (pool != VK_NULL_HANDLE && !vn_cs_decoder_get_fatal(dec) &&
+            server_state_bridge_command_buffer_is_recording(state, command_buffer)) {
+            parallel_recorder_begin(recorder, command_buffer, pool);
+        }
+        return true;
+    }
+
+    const bool inline_upload = header[0] == VENUS_PLUS_CMD_INLINE_UPLOAD;
+    const bool recorded = inline_upload || is_recorded_command(type);
+    if (!recorded && type != VK_COMMAND_TYPE_vkEndCommandBuffer_EXT) {
+        // Not replayed on workers (vkCmdExecuteCommands needs its secondaries
+        // finished, for one): if this is a vkCmd* for a bucketed buffer, hand
+        // off what it has so far and decode the rest of it inline.
+        parallel_recorder_detach(recorder, command_buffer);
+        parallel_recorder_wait_all(recorder);
+        return false;
+    }
+    if (!parallel_recorder_is_capturing(recorder, command_buffer)) {
+        parallel_recorder_wait_all(recorder);
+        return false;
+    }
+    if (recorded && (flags & VK_COMMAND_GENERATE_REPLY_BIT_EXT)) {
+        // The client waits for this one; finish the buffer inline from here.
+        parallel_recorder_detach(recorder, command_buffer);
+        parallel_recorder_wait_all(recorder);
+        return false;
+    }
+
+    const size_t start = stream_size - remaining;
+    if (inline_upload) {
+        skip_inline_upload(dec);
+    } else {
+        vn_dispatch_command(&renderer->record_ctx);
+    }
+    if (recorded && !vn_cs_decoder_get_fatal(dec)) {
+        const size_t end = stream_size - vn_cs_decoder_bytes_remaining(dec);
+        parallel_recorder_append(recorder, command_buffer, stream + start, end - start);
+    }
+    return true;
+}
+
+bool venus_renderer_enable_parallel_recording(struct VenusRenderer* renderer, uint32_t worker_count) {
+    if (!renderer || renderer->recorder || worker_count == 0)
+        return false;
+
+    renderer->worker_ctx = (struct server_dispatch_context*)calloc(worker_count, sizeof(*renderer->worker_ctx));
+    if (!renderer->worker_ctx)
+        return false;
+    renderer->worker_count = worker_count;
+    for (uint32_t i = 0; i < worker_count; ++i) {
+        renderer->worker_ctx[i] = renderer->dispatch;
+        struct vn_dispatch_context* ctx = &renderer->worker_ctx[i].ctx;
+        ctx->decoder = vn_cs_decoder_create();
+        ctx->encoder = vn_cs_encoder_create();
+        if (!ctx->decoder || !ctx->encoder) {
+            venus_renderer_destroy_parallel_recording(renderer);
+            return false;
+        }
+    }
+
+    memset(&renderer->record_ctx, 0, sizeof(renderer->record_ctx));
+    renderer->record_ctx.data = renderer;
+    renderer->record_ctx.encoder = renderer->encoder;
+    renderer->record_ctx.decoder = renderer->decoder;
+#define SERVER_SET_RECORD_DISPATCH(name) renderer->record_ctx.dispatch_##name = record_dispatch_##name;
+    SERVER_RECORDED_COMMANDS(SERVER_SET_RECORD_DISPATCH)
+#undef SERVER_SET_RECORD_DISPATCH
+    renderer->record_ctx.dispatch_vkEndCommandBuffer = record_dispatch_vkEndCommandBuffer;
+
+    renderer->recorder = parallel_recorder_create(worker_count, replay_recorded_commands, renderer);
+    if (!renderer->recorder) {
+        venus_renderer_destroy_parallel_recording(renderer);
+        return false;
+    }
+    return true;
+}
+
+void venus_renderer_set_trusted_client(struct VenusRenderer* renderer, bool trusted) {
+    if (!renderer)
+        return;
+    renderer->dispatch.trusted = trusted;
+    for (uint32_t i = 0; i < renderer->worker_count; ++i) {
+        renderer->worker_ctx[i].trusted = trusted;
+    }
+}
+
+void venus_renderer_enable_async_pipelines(struct VenusRenderer* renderer, struct PipelineCompiler* compiler) {
+    if (!renderer)
+        return;
+    renderer->compiler = compiler;
+}
+
+void venus_renderer_finish_recording(struct VenusRenderer* renderer) {
+    if (!renderer || !renderer->recorder)
+        return;
+    parallel_recorder_wait_all(renderer->recorder);
+}
+
+static void venus_renderer_destroy_parallel_recording(struct VenusRenderer* renderer) {
+    parallel_recorder_destroy(renderer->recorder);
+    renderer->recorder = NULL;
+    for (uint32_t i = 0; i < renderer->worker_count; ++i) {
+        vn_cs_decoder_destroy(renderer->worker_ctx[i].ctx.decoder);
+        vn_cs_encoder_destroy(renderer->worker_ctx[i].ctx.encoder);
+    }
+    free(renderer->worker_ctx);
+    renderer->worker_ctx = NULL;
+    renderer->worker_count = 0;
+}
+
 struct VenusRenderer* venus_renderer_create(struct ServerState* state) {
     struct VenusRenderer* renderer = (struct VenusRenderer*)calloc(1, sizeof(*renderer));
     if (!renderer)
         return NULL;
 
     renderer->state = state;
+    renderer->dispatch.renderer = renderer;
     renderer->decoder = vn_cs_decoder_create();
     renderer->encoder = vn_cs_encoder_create();
     if (!renderer->decoder || !renderer->encoder) {
@@ -3706,181 +5020,195 @@ struct VenusRenderer* venus_renderer_create(struct ServerState* state) {
         return NULL;
     }
 
-    renderer->ctx.data = state;
-    renderer->ctx.debug_log = NULL;
-    renderer->ctx.encoder = renderer->encoder;
-    renderer->ctx.decoder = renderer->decoder;
+    renderer->dispatch.ctx.data = state;
+    renderer->dispatch.ctx.debug_log = NULL;
+    renderer->dispatch.ctx.encoder = renderer->encoder;
+    renderer->dispatch.ctx.decoder = renderer->decoder;
 
     // Phase 2 handlers
-    renderer->ctx.dispatch_vkCreateInstance = server_dispatch_vkCreateInstance;
-    renderer->ctx.dispatch_vkDestroyInstance = server_dispatch_vkDestroyInstance;
-    renderer->ctx.dispatch_vkEnumerateInstanceVersion = server_dispatch_vkEnumerateInstanceVersion;
-    renderer->ctx.dispatch_vkEnumerateInstanceExtensionProperties =
+    renderer->dispatch.ctx.dispatch_vkCreateInstance = server_dispatch_vkCreateInstance;
+    renderer->dispatch.ctx.dispatch_vkDestroyInstance = server_dispatch_vkDestroyInstance;
+    renderer->dispatch.ctx.dispatch_vkEnumerateInstanceVersion = server_dispatch_vkEnumerateInstanceVersion;
+    renderer->dispatch.ctx.dispatch_vkEnumerateInstanceExtensionProperties =
         server_dispatch_vkEnumerateInstanceExtensionProperties;
-    renderer->ctx.dispatch_vkEnumerateInstanceLayerProperties = server_dispatch_vkEnumerateInstanceLayerProperties;
-    renderer->ctx.dispatch_vkEnumeratePhysicalDevices = server_dispatch_vkEnumeratePhysicalDevices;
+    renderer->dispatch.ctx.dispatch_vkEnumerateInstanceLayerProperties = server_dispatch_vkEnumerateInstanceLayerProperties;
+    renderer->dispatch.ctx.dispatch_vkEnumeratePhysicalDevices = server_dispatch_vkEnumeratePhysicalDevices;
 
     // Phase 3 handlers: Physical device queries
-    renderer->ctx.dispatch_vkGetPhysicalDeviceProperties = server_dispatch_vkGetPhysicalDeviceProperties;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceFeatures = server_dispatch_vkGetPhysicalDeviceFeatures;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceQueueFamilyProperties = server_dispatch_vkGetPhysicalDeviceQueueFamilyProperties;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceMemoryProperties = server_dispatch_vkGetPhysicalDeviceMemoryProperties;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceFormatProperties = server_dispatch_vkGetPhysicalDeviceFormatProperties;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceImageFormatProperties = server_dispatch_vkGetPhysicalDeviceImageFormatProperties;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceImageFormatProperties2 = server_dispatch_vkGetPhysicalDeviceImageFormatProperties2;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceProperties2 = server_dispatch_vkGetPhysicalDeviceProperties2;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceFeatures2 = server_dispatch_vkGetPhysicalDeviceFeatures2;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceQueueFamilyProperties2 = server_dispatch_vkGetPhysicalDeviceQueueFamilyProperties2;
-    renderer->ctx.dispatch_vkGetPhysicalDeviceMemoryProperties2 = server_dispatch_vkGetPhysicalDeviceMemoryProperties2;
-    renderer->ctx.dispatch_vkEnumerateDeviceExtensionProperties = server_dispatch_vkEnumerateDeviceExtensionProperties;
-    renderer->ctx.dispatch_vkEnumerateDeviceLayerProperties = server_dispatch_vkEnumerateDeviceLayerProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceProperties = server_dispatch_vkGetPhysicalDeviceProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceFeatures = server_dispatch_vkGetPhysicalDeviceFeatures;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceQueueFamilyProperties = server_dispatch_vkGetPhysicalDeviceQueueFamilyProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceMemoryProperties = server_dispatch_vkGetPhysicalDeviceMemoryProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceFormatProperties = server_dispatch_vkGetPhysicalDeviceFormatProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceImageFormatProperties = server_dispatch_vkGetPhysicalDeviceImageFormatProperties;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceImageFormatProperties2 = server_dispatch_vkGetPhysicalDeviceImageFormatProperties2;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceProperties2 = server_dispatch_vkGetPhysicalDeviceProperties2;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceFeatures2 = server_dispatch_vkGetPhysicalDeviceFeatures2;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceQueueFamilyProperties2 = server_dispatch_vkGetPhysicalDeviceQueueFamilyProperties2;
+    renderer->dispatch.ctx.dispatch_vkGetPhysicalDeviceMemoryProperties2 = server_dispatch_vkGetPhysicalDeviceMemoryProperties2;
+    renderer->dispatch.ctx.dispatch_vkEnumerateDeviceExtensionProperties = server_dispatch_vkEnumerateDeviceExtensionProperties;
+    renderer->dispatch.ctx.dispatch_vkEnumerateDeviceLayerProperties = server_dispatch_vkEnumerateDeviceLayerProperties;
 
     // Phase 3 handlers: Device management
-    renderer->ctx.dispatch_vkCreateDevice = server_dispatch_vkCreateDevice;
-    renderer->ctx.dispatch_vkDestroyDevice = server_dispatch_vkDestroyDevice;
-    renderer->ctx.dispatch_vkGetDeviceQueue = server_dispatch_vkGetDeviceQueue;
+    renderer->dispatch.ctx.dispatch_vkCreateDevice = server_dispatch_vkCreateDevice;
+    renderer->dispatch.ctx.dispatch_vkDestroyDevice = server_dispatch_vkDestroyDevice;
+    renderer->dispatch.ctx.dispatch_vkGetDeviceQueue = server_dispatch_vkGetDeviceQueue;
 
     // Phase 4 handlers: Memory and resources
-    renderer->ctx.dispatch_vkAllocateMemory = server_dispatch_vkAllocateMemory;
-    renderer->ctx.dispatch_vkFreeMemory = server_dispatch_vkFreeMemory;
-    renderer->ctx.dispatch_vkCreateBuffer = server_dispatch_vkCreateBuffer;
-    renderer->ctx.dispatch_vkDestroyBuffer = server_dispatch_vkDestroyBuffer;
-    renderer->ctx.dispatch_vkGetBufferMemoryRequirements = server_dispatch_vkGetBufferMemoryRequirements;
-    renderer->ctx.dispatch_vkGetBufferMemoryRequirements2 = server_dispatch_vkGetBufferMemoryRequirements2;
-    renderer->ctx.dispatch_vkBindBufferMemory = server_dispatch_vkBindBufferMemory;
-    renderer->ctx.dispatch_vkGetBufferDeviceAddress = server_dispatch_vkGetBufferDeviceAddress;
-    renderer->ctx.dispatch_vkGetBufferOpaqueCaptureAddress = server_dispatch_vkGetBufferOpaqueCaptureAddress;
-    renderer->ctx.dispatch_vkGetDeviceMemoryOpaqueCaptureAddress =
+    renderer->dispatch.ctx.dispatch_vkAllocateMemory = server_dispatch_vkAllocateMemory;
+    renderer->dispatch.ctx.dispatch_vkFreeMemory = server_dispatch_vkFreeMemory;
+    renderer->dispatch.ctx.dispatch_vkCreateBuffer = server_dispatch_vkCreateBuffer;
+    renderer->dispatch.ctx.dispatch_vkDestroyBuffer = server_dispatch_vkDestroyBuffer;
+    renderer->dispatch.ctx.dispatch_vkGetBufferMemoryRequirements = server_dispatch_vkGetBufferMemoryRequirements;
+    renderer->dispatch.ctx.dispatch_vkGetBufferMemoryRequirements2 = server_dispatch_vkGetBufferMemoryRequirements2;
+    renderer->dispatch.ctx.dispatch_vkBindBufferMemory = server_dispatch_vkBindBufferMemory;
+    renderer->dispatch.ctx.dispatch_vkGetBufferDeviceAddress = server_dispatch_vkGetBufferDeviceAddress;
+    renderer->dispatch.ctx.dispatch_vkGetBufferOpaqueCaptureAddress = server_dispatch_vkGetBufferOpaqueCaptureAddress;
+    renderer->dispatch.ctx.dispatch_vkGetDeviceMemoryOpaqueCaptureAddress =
         server_dispatch_vkGetDeviceMemoryOpaqueCaptureAddress;
-    renderer->ctx.dispatch_vkCreateImage = server_dispatch_vkCreateImage;
-    renderer->ctx.dispatch_vkDestroyImage = server_dispatch_vkDestroyImage;
-    renderer->ctx.dispatch_vkGetImageMemoryRequirements2 = server_dispatch_vkGetImageMemoryRequirements2;
-    renderer->ctx.dispatch_vkGetImageMemoryRequirements = server_dispatch_vkGetImageMemoryRequirements;
-    renderer->ctx.dispatch_vkGetDeviceBufferMemoryRequirements =
+    renderer->dispatch.ctx.dispatch_vkCreateImage = server_dispatch_vkCreateImage;
+    renderer->dispatch.ctx.dispatch_vkDestroyImage = server_dispatch_vkDestroyImage;
+    renderer->dispatch.ctx.dispatch_vkGetImageMemoryRequirements2 = server_dispatch_vkGetImageMemoryRequirements2;
+    renderer->dispatch.ctx.dispatch_vkGetImageMemoryRequirements = server_dispatch_vkGetImageMemoryRequirements;
+    renderer->dispatch.ctx.dispatch_vkGetDeviceBufferMemoryRequirements =
         server_dispatch_vkGetDeviceBufferMemoryRequirements;
-    renderer->ctx.dispatch_vkGetDeviceImageMemoryRequirements =
+    renderer->dispatch.ctx.dispatch_vkGetDeviceImageMemoryRequirements =
         server_dispatch_vkGetDeviceImageMemoryRequirements;
-    renderer->ctx.dispatch_vkGetDeviceImageSparseMemoryRequirements =
+    renderer->dispatch.ctx.dispatch_vkGetDeviceImageSparseMemoryRequirements =
         server_dispatch_vkGetDeviceImageSparseMemoryRequirements;
-    renderer->ctx.dispatch_vkBindImageMemory = server_dispatch_vkBindImageMemory;
-    renderer->ctx.dispatch_vkGetImageSubresourceLayout = server_dispatch_vkGetImageSubresourceLayout;
-    renderer->ctx.dispatch_vkCreateImageView = server_dispatch_vkCreateImageView;
-    renderer->ctx.dispatch_vkDestroyImageView = server_dispatch_vkDestroyImageView;
-    renderer->ctx.dispatch_vkCreateBufferView = server_dispatch_vkCreateBufferView;
-    renderer->ctx.dispatch_vkDestroyBufferView = server_dispatch_vkDestroyBufferView;
-    renderer->ctx.dispatch_vkCreateSampler = server_dispatch_vkCreateSampler;
-    renderer->ctx.dispatch_vkDestroySampler = server_dispatch_vkDestroySampler;
-    renderer->ctx.dispatch_vkCreateShaderModule = server_dispatch_vkCreateShaderModule;
-    renderer->ctx.dispatch_vkDestroyShaderModule = server_dispatch_vkDestroyShaderModule;
-    renderer->ctx.dispatch_vkCreateDescriptorSetLayout = server_dispatch_vkCreateDescriptorSetLayout;
-    renderer->ctx.dispatch_vkDestroyDescriptorSetLayout = server_dispatch_vkDestroyDescriptorSetLayout;
-    renderer->ctx.dispatch_vkCreateDescriptorPool = server_dispatch_vkCreateDescriptorPool;
-    renderer->ctx.dispatch_vkDestroyDescriptorPool = server_dispatch_vkDestroyDescriptorPool;
-    renderer->ctx.dispatch_vkResetDescriptorPool = server_dispatch_vkResetDescriptorPool;
-    renderer->ctx.dispatch_vkAllocateDescriptorSets = server_dispatch_vkAllocateDescriptorSets;
-    renderer->ctx.dispatch_vkFreeDescriptorSets = server_dispatch_vkFreeDescriptorSets;
-    renderer->ctx.dispatch_vkUpdateDescriptorSets = server_dispatch_vkUpdateDescriptorSets;
-    renderer->ctx.dispatch_vkCreatePipelineLayout = server_dispatch_vkCreatePipelineLayout;
-    renderer->ctx.dispatch_vkDestroyPipelineLayout = server_dispatch_vkDestroyPipelineLayout;
-    renderer->ctx.dispatch_vkCreatePipelineCache = server_dispatch_vkCreatePipelineCache;
-    renderer->ctx.dispatch_vkDestroyPipelineCache = server_dispatch_vkDestroyPipelineCache;
-    renderer->ctx.dispatch_vkGetPipelineCacheData = server_dispatch_vkGetPipelineCacheData;
-    renderer->ctx.dispatch_vkMergePipelineCaches = server_dispatch_vkMergePipelineCaches;
-    renderer->ctx.dispatch_vkCreateRenderPass = server_dispatch_vkCreateRenderPass;
-    renderer->ctx.dispatch_vkCreateRenderPass2 = server_dispatch_vkCreateRenderPass2;
-    renderer->ctx.dispatch_vkDestroyRenderPass = server_dispatch_vkDestroyRenderPass;
-    renderer->ctx.dispatch_vkCreateFramebuffer = server_dispatch_vkCreateFramebuffer;
-    renderer->ctx.dispatch_vkDestroyFramebuffer = server_dispatch_vkDestroyFramebuffer;
-    renderer->ctx.dispatch_vkCreateComputePipelines = server_dispatch_vkCreateComputePipelines;
-    renderer->ctx.dispatch_vkCreateGraphicsPipelines = server_dispatch_vkCreateGraphicsPipelines;
-    renderer->ctx.dispatch_vkDestroyPipeline = server_dispatch_vkDestroyPipeline;
-    renderer->ctx.dispatch_vkCreateCommandPool = server_dispatch_vkCreateCommandPool;
-    renderer->ctx.dispatch_vkDestroyCommandPool = server_dispatch_vkDestroyCommandPool;
-    renderer->ctx.dispatch_vkResetCommandPool = server_dispatch_vkResetCommandPool;
-    renderer->ctx.dispatch_vkAllocateCommandBuffers = server_dispatch_vkAllocateCommandBuffers;
-    renderer->ctx.dispatch_vkFreeCommandBuffers = server_dispatch_vkFreeCommandBuffers;
-    renderer->ctx.dispatch_vkBeginCommandBuffer = server_dispatch_vkBeginCommandBuffer;
-    renderer->ctx.dispatch_vkEndCommandBuffer = server_dispatch_vkEndCommandBuffer;
-    renderer->ctx.dispatch_vkResetCommandBuffer = server_dispatch_vkResetCommandBuffer;
-    renderer->ctx.dispatch_vkCmdCopyBuffer = server_dispatch_vkCmdCopyBuffer;
-    renderer->ctx.dispatch_vkCmdCopyBuffer2 = server_dispatch_vkCmdCopyBuffer2;
-    renderer->ctx.dispatch_vkCmdCopyImage = server_dispatch_vkCmdCopyImage;
-    renderer->ctx.dispatch_vkCmdCopyImage2 = server_dispatch_vkCmdCopyImage2;
-    renderer->ctx.dispatch_vkCmdBlitImage = server_dispatch_vkCmdBlitImage;
-    renderer->ctx.dispatch_vkCmdBlitImage2 = server_dispatch_vkCmdBlitImage2;
-    renderer->ctx.dispatch_vkCmdCopyBufferToImage = server_dispatch_vkCmdCopyBufferToImage;
-    renderer->ctx.dispatch_vkCmdCopyBufferToImage2 = server_dispatch_vkCmdCopyBufferToImage2;
-    renderer->ctx.dispatch_vkCmdCopyImageToBuffer = server_dispatch_vkCmdCopyImageToBuffer;
-    renderer->ctx.dispatch_vkCmdCopyImageToBuffer2 = server_dispatch_vkCmdCopyImageToBuffer2;
-    renderer->ctx.dispatch_vkCmdResolveImage2 = server_dispatch_vkCmdResolveImage2;
-    renderer->ctx.dispatch_vkCmdFillBuffer = server_dispatch_vkCmdFillBuffer;
-    renderer->ctx.dispatch_vkCmdUpdateBuffer = server_dispatch_vkCmdUpdateBuffer;
-    renderer->ctx.dispatch_vkCmdClearColorImage = server_dispatch_vkCmdClearColorImage;
-    renderer->ctx.dispatch_vkCmdBeginRenderPass = server_dispatch_vkCmdBeginRenderPass;
-    renderer->ctx.dispatch_vkCmdEndRenderPass = server_dispatch_vkCmdEndRenderPass;
-    renderer->ctx.dispatch_vkCmdBeginRendering = server_dispatch_vkCmdBeginRendering;
-    renderer->ctx.dispatch_vkCmdEndRendering = server_dispatch_vkCmdEndRendering;
-    renderer->ctx.dispatch_vkCmdBindPipeline = server_dispatch_vkCmdBindPipeline;
-    renderer->ctx.dispatch_vkCmdBindVertexBuffers = server_dispatch_vkCmdBindVertexBuffers;
-    renderer->ctx.dispatch_vkCmdBindDescriptorSets = server_dispatch_vkCmdBindDescriptorSets;
-    renderer->ctx.dispatch_vkCmdPushConstants = server_dispatch_vkCmdPushConstants;
-    renderer->ctx.dispatch_vkCmdDispatch = server_dispatch_vkCmdDispatch;
-    renderer->ctx.dispatch_vkCmdDispatchIndirect = server_dispatch_vkCmdDispatchIndirect;
-    renderer->ctx.dispatch_vkCmdDispatchBase = server_dispatch_vkCmdDispatchBase;
-    renderer->ctx.dispatch_vkCmdSetViewport = server_dispatch_vkCmdSetViewport;
-    renderer->ctx.dispatch_vkCmdSetViewportWithCount = server_dispatch_vkCmdSetViewportWithCount;
-    renderer->ctx.dispatch_vkCmdSetScissor = server_dispatch_vkCmdSetScissor;
-    renderer->ctx.dispatch_vkCmdSetScissorWithCount = server_dispatch_vkCmdSetScissorWithCount;
-    renderer->ctx.dispatch_vkCmdSetCullMode = server_dispatch_vkCmdSetCullMode;
-    renderer->ctx.dispatch_vkCmdSetFrontFace = server_dispatch_vkCmdSetFrontFace;
-    renderer->ctx.dispatch_vkCmdSetPrimitiveTopology = server_dispatch_vkCmdSetPrimitiveTopology;
-    renderer->ctx.dispatch_vkCmdSetDepthTestEnable = server_dispatch_vkCmdSetDepthTestEnable;
-    renderer->ctx.dispatch_vkCmdSetDepthWriteEnable = server_dispatch_vkCmdSetDepthWriteEnable;
-    renderer->ctx.dispatch_vkCmdSetDepthCompareOp = server_dispatch_vkCmdSetDepthCompareOp;
-    renderer->ctx.dispatch_vkCmdSetDepthBoundsTestEnable = server_dispatch_vkCmdSetDepthBoundsTestEnable;
-    renderer->ctx.dispatch_vkCmdSetStencilTestEnable = server_dispatch_vkCmdSetStencilTestEnable;
-    renderer->ctx.dispatch_vkCmdSetStencilOp = server_dispatch_vkCmdSetStencilOp;
-    renderer->ctx.dispatch_vkCmdSetRasterizerDiscardEnable = server_dispatch_vkCmdSetRasterizerDiscardEnable;
-    renderer->ctx.dispatch_vkCmdSetDepthBiasEnable = server_dispatch_vkCmdSetDepthBiasEnable;
-    renderer->ctx.dispatch_vkCmdSetPrimitiveRestartEnable = server_dispatch_vkCmdSetPrimitiveRestartEnable;
-    renderer->ctx.dispatch_vkCmdDraw = server_dispatch_vkCmdDraw;
-    renderer->ctx.dispatch_vkCmdPipelineBarrier = server_dispatch_vkCmdPipelineBarrier;
-    renderer->ctx.dispatch_vkCmdPipelineBarrier2 = server_dispatch_vkCmdPipelineBarrier2;
-    renderer->ctx.dispatch_vkCmdResetQueryPool = server_dispatch_vkCmdResetQueryPool;
-    renderer->ctx.dispatch_vkCmdBeginQuery = server_dispatch_vkCmdBeginQuery;
-    renderer->ctx.dispatch_vkCmdEndQuery = server_dispatch_vkCmdEndQuery;
-    renderer->ctx.dispatch_vkCmdWriteTimestamp = server_dispatch_vkCmdWriteTimestamp;
-    renderer->ctx.dispatch_vkCmdWriteTimestamp2 = server_dispatch_vkCmdWriteTimestamp2;
-    renderer->ctx.dispatch_vkCmdCopyQueryPoolResults = server_dispatch_vkCmdCopyQueryPoolResults;
-    renderer->ctx.dispatch_vkCmdSetEvent = server_dispatch_vkCmdSetEvent;
-    renderer->ctx.dispatch_vkCmdSetEvent2 = server_dispatch_vkCmdSetEvent2;
-    renderer->ctx.dispatch_vkCmdResetEvent = server_dispatch_vkCmdResetEvent;
-    renderer->ctx.dispatch_vkCmdResetEvent2 = server_dispatch_vkCmdResetEvent2;
-    renderer->ctx.dispatch_vkCmdWaitEvents = server_dispatch_vkCmdWaitEvents;
-    renderer->ctx.dispatch_vkCmdWaitEvents2 = server_dispatch_vkCmdWaitEvents2;
-    renderer->ctx.dispatch_vkCreateFence = server_dispatch_vkCreateFence;
-    renderer->ctx.dispatch_vkDestroyFence = server_dispatch_vkDestroyFence;
-    renderer->ctx.dispatch_vkGetFenceStatus = server_dispatch_vkGetFenceStatus;
-    renderer->ctx.dispatch_vkResetFences = server_dispatch_vkResetFences;
-    renderer->ctx.dispatch_vkWaitForFences = server_dispatch_vkWaitForFences;
-    renderer->ctx.dispatch_vkCreateSemaphore = server_dispatch_vkCreateSemaphore;
-    renderer->ctx.dispatch_vkDestroySemaphore = server_dispatch_vkDestroySemaphore;
-    renderer->ctx.dispatch_vkGetSemaphoreCounterValue = server_dispatch_vkGetSemaphoreCounterValue;
-    renderer->ctx.dispatch_vkSignalSemaphore = server_dispatch_vkSignalSemaphore;
-    renderer->ctx.dispatch_vkWaitSemaphores = server_dispatch_vkWaitSemaphores;
-    renderer->ctx.dispatch_vkCreateEvent = server_dispatch_vkCreateEvent;
-    renderer->ctx.dispatch_vkDestroyEvent = server_dispatch_vkDestroyEvent;
-    renderer->ctx.dispatch_vkGetEventStatus = server_dispatch_vkGetEventStatus;
-    renderer->ctx.dispatch_vkSetEvent = server_dispatch_vkSetEvent;
-    renderer->ctx.dispatch_vkResetEvent = server_dispatch_vkResetEvent;
-    renderer->ctx.dispatch_vkQueueSubmit = server_dispatch_vkQueueSubmit;
-    renderer->ctx.dispatch_vkQueueSubmit2 = server_dispatch_vkQueueSubmit2;
-    renderer->ctx.dispatch_vkQueueWaitIdle = server_dispatch_vkQueueWaitIdle;
-    renderer->ctx.dispatch_vkDeviceWaitIdle = server_dispatch_vkDeviceWaitIdle;
-    renderer->ctx.dispatch_vkCreateQueryPool = server_dispatch_vkCreateQueryPool;
-    renderer->ctx.dispatch_vkDestroyQueryPool = server_dispatch_vkDestroyQueryPool;
-    renderer->ctx.dispatch_vkResetQueryPool = server_dispatch_vkResetQueryPool;
-    renderer->ctx.dispatch_vkGetQueryPoolResults = server_dispatch_vkGetQueryPoolResults;
+    renderer->dispatch.ctx.dispatch_vkBindImageMemory = server_dispatch_vkBindImageMemory;
+    renderer->dispatch.ctx.dispatch_vkGetImageSubresourceLayout = server_dispatch_vkGetImageSubresourceLayout;
+    renderer->dispatch.ctx.dispatch_vkCopyMemoryToImageMESA = server_dispatch_vkCopyMemoryToImageMESA;
+    renderer->dispatch.ctx.dispatch_vkCopyImageToMemoryMESA = server_dispatch_vkCopyImageToMemoryMESA;
+    renderer->dispatch.ctx.dispatch_vkCopyImageToImage = server_dispatch_vkCopyImageToImage;
+    renderer->dispatch.ctx.dispatch_vkTransitionImageLayout = server_dispatch_vkTransitionImageLayout;
+    renderer->dispatch.ctx.dispatch_vkCreateImageView = server_dispatch_vkCreateImageView;
+    renderer->dispatch.ctx.dispatch_vkDestroyImageView = server_dispatch_vkDestroyImageView;
+    renderer->dispatch.ctx.dispatch_vkCreateBufferView = server_dispatch_vkCreateBufferView;
+    renderer->dispatch.ctx.dispatch_vkDestroyBufferView = server_dispatch_vkDestroyBufferView;
+    renderer->dispatch.ctx.dispatch_vkCreateSampler = server_dispatch_vkCreateSampler;
+    renderer->dispatch.ctx.dispatch_vkDestroySampler = server_dispatch_vkDestroySampler;
+    renderer->dispatch.ctx.dispatch_vkCreateShaderModule = server_dispatch_vkCreateShaderModule;
+    renderer->dispatch.ctx.dispatch_vkDestroyShaderModule = server_dispatch_vkDestroyShaderModule;
+    renderer->dispatch.ctx.dispatch_vkCreateDescriptorSetLayout = server_dispatch_vkCreateDescriptorSetLayout;
+    renderer->dispatch.ctx.dispatch_vkDestroyDescriptorSetLayout = server_dispatch_vkDestroyDescriptorSetLayout;
+    renderer->dispatch.ctx.dispatch_vkCreateDescriptorPool = server_dispatch_vkCreateDescriptorPool;
+    renderer->dispatch.ctx.dispatch_vkDestroyDescriptorPool = server_dispatch_vkDestroyDescriptorPool;
+    renderer->dispatch.ctx.dispatch_vkResetDescriptorPool = server_dispatch_vkResetDescriptorPool;
+    renderer->dispatch.ctx.dispatch_vkAllocateDescriptorSets = server_dispatch_vkAllocateDescriptorSets;
+    renderer->dispatch.ctx.dispatch_vkFreeDescriptorSets = server_dispatch_vkFreeDescriptorSets;
+    renderer->dispatch.ctx.dispatch_vkUpdateDescriptorSets = server_dispatch_vkUpdateDescriptorSets;
+    renderer->dispatch.ctx.dispatch_vkCreateDescriptorUpdateTemplate = server_dispatch_vkCreateDescriptorUpdateTemplate;
+    renderer->dispatch.ctx.dispatch_vkDestroyDescriptorUpdateTemplate = server_dispatch_vkDestroyDescriptorUpdateTemplate;
+    renderer->dispatch.ctx.dispatch_vkCreatePipelineLayout = server_dispatch_vkCreatePipelineLayout;
+    renderer->dispatch.ctx.dispatch_vkDestroyPipelineLayout = server_dispatch_vkDestroyPipelineLayout;
+    renderer->dispatch.ctx.dispatch_vkCreatePipelineCache = server_dispatch_vkCreatePipelineCache;
+    renderer->dispatch.ctx.dispatch_vkDestroyPipelineCache = server_dispatch_vkDestroyPipelineCache;
+    renderer->dispatch.ctx.dispatch_vkGetPipelineCacheData = server_dispatch_vkGetPipelineCacheData;
+    renderer->dispatch.ctx.dispatch_vkMergePipelineCaches = server_dispatch_vkMergePipelineCaches;
+    renderer->dispatch.ctx.dispatch_vkCreateRenderPass = server_dispatch_vkCreateRenderPass;
+    renderer->dispatch.ctx.dispatch_vkCreateRenderPass2 = server_dispatch_vkCreateRenderPass2;
+    renderer->dispatch.ctx.dispatch_vkDestroyRenderPass = server_dispatch_vkDestroyRenderPass;
+    renderer->dispatch.ctx.dispatch_vkCreateFramebuffer = server_dispatch_vkCreateFramebuffer;
+    renderer->dispatch.ctx.dispatch_vkDestroyFramebuffer = server_dispatch_vkDestroyFramebuffer;
+    renderer->dispatch.ctx.dispatch_vkCreateComputePipelines = server_dispatch_vkCreateComputePipelines;
+    renderer->dispatch.ctx.dispatch_vkCreateGraphicsPipelines = server_dispatch_vkCreateGraphicsPipelines;
+    renderer->dispatch.ctx.dispatch_vkDestroyPipeline = server_dispatch_vkDestroyPipeline;
+    renderer->dispatch.ctx.dispatch_vkCreateCommandPool = server_dispatch_vkCreateCommandPool;
+    renderer->dispatch.ctx.dispatch_vkDestroyCommandPool = server_dispatch_vkDestroyCommandPool;
+    renderer->dispatch.ctx.dispatch_vkResetCommandPool = server_dispatch_vkResetCommandPool;
+    renderer->dispatch.ctx.dispatch_vkAllocateCommandBuffers = server_dispatch_vkAllocateCommandBuffers;
+    renderer->dispatch.ctx.dispatch_vkFreeCommandBuffers = server_dispatch_vkFreeCommandBuffers;
+    renderer->dispatch.ctx.dispatch_vkBeginCommandBuffer = server_dispatch_vkBeginCommandBuffer;
+    renderer->dispatch.ctx.dispatch_vkEndCommandBuffer = server_dispatch_vkEndCommandBuffer;
+    renderer->dispatch.ctx.dispatch_vkResetCommandBuffer = server_dispatch_vkResetCommandBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyBuffer = server_dispatch_vkCmdCopyBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyBuffer2 = server_dispatch_vkCmdCopyBuffer2;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyImage = server_dispatch_vkCmdCopyImage;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyImage2 = server_dispatch_vkCmdCopyImage2;
+    renderer->dispatch.ctx.dispatch_vkCmdBlitImage = server_dispatch_vkCmdBlitImage;
+    renderer->dispatch.ctx.dispatch_vkCmdBlitImage2 = server_dispatch_vkCmdBlitImage2;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyBufferToImage = server_dispatch_vkCmdCopyBufferToImage;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyBufferToImage2 = server_dispatch_vkCmdCopyBufferToImage2;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyImageToBuffer = server_dispatch_vkCmdCopyImageToBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyImageToBuffer2 = server_dispatch_vkCmdCopyImageToBuffer2;
+    renderer->dispatch.ctx.dispatch_vkCmdResolveImage2 = server_dispatch_vkCmdResolveImage2;
+    renderer->dispatch.ctx.dispatch_vkCmdFillBuffer = server_dispatch_vkCmdFillBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdUpdateBuffer = server_dispatch_vkCmdUpdateBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdClearColorImage = server_dispatch_vkCmdClearColorImage;
+    renderer->dispatch.ctx.dispatch_vkCmdBeginRenderPass = server_dispatch_vkCmdBeginRenderPass;
+    renderer->dispatch.ctx.dispatch_vkCmdEndRenderPass = server_dispatch_vkCmdEndRenderPass;
+    renderer->dispatch.ctx.dispatch_vkCmdBeginRendering = server_dispatch_vkCmdBeginRendering;
+    renderer->dispatch.ctx.dispatch_vkCmdEndRendering = server_dispatch_vkCmdEndRendering;
+    renderer->dispatch.ctx.dispatch_vkCmdBindPipeline = server_dispatch_vkCmdBindPipeline;
+    renderer->dispatch.ctx.dispatch_vkCmdBindVertexBuffers = server_dispatch_vkCmdBindVertexBuffers;
+    renderer->dispatch.ctx.dispatch_vkCmdBindDescriptorSets = server_dispatch_vkCmdBindDescriptorSets;
+    renderer->dispatch.ctx.dispatch_vkCmdPushDescriptorSet = server_dispatch_vkCmdPushDescriptorSet;
+    renderer->dispatch.ctx.dispatch_vkCmdPushConstants = server_dispatch_vkCmdPushConstants;
+    renderer->dispatch.ctx.dispatch_vkCmdDispatch = server_dispatch_vkCmdDispatch;
+    renderer->dispatch.ctx.dispatch_vkCmdDispatchIndirect = server_dispatch_vkCmdDispatchIndirect;
+    renderer->dispatch.ctx.dispatch_vkCmdDispatchBase = server_dispatch_vkCmdDispatchBase;
+    renderer->dispatch.ctx.dispatch_vkCmdSetViewport = server_dispatch_vkCmdSetViewport;
+    renderer->dispatch.ctx.dispatch_vkCmdSetViewportWithCount = server_dispatch_vkCmdSetViewportWithCount;
+    renderer->dispatch.ctx.dispatch_vkCmdSetScissor = server_dispatch_vkCmdSetScissor;
+    renderer->dispatch.ctx.dispatch_vkCmdSetScissorWithCount = server_dispatch_vkCmdSetScissorWithCount;
+    renderer->dispatch.ctx.dispatch_vkCmdSetCullMode = server_dispatch_vkCmdSetCullMode;
+    renderer->dispatch.ctx.dispatch_vkCmdSetFrontFace = server_dispatch_vkCmdSetFrontFace;
+    renderer->dispatch.ctx.dispatch_vkCmdSetPrimitiveTopology = server_dispatch_vkCmdSetPrimitiveTopology;
+    renderer->dispatch.ctx.dispatch_vkCmdSetDepthTestEnable = server_dispatch_vkCmdSetDepthTestEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetDepthWriteEnable = server_dispatch_vkCmdSetDepthWriteEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetDepthCompareOp = server_dispatch_vkCmdSetDepthCompareOp;
+    renderer->dispatch.ctx.dispatch_vkCmdSetDepthBoundsTestEnable = server_dispatch_vkCmdSetDepthBoundsTestEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetStencilTestEnable = server_dispatch_vkCmdSetStencilTestEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetStencilOp = server_dispatch_vkCmdSetStencilOp;
+    renderer->dispatch.ctx.dispatch_vkCmdSetRasterizerDiscardEnable = server_dispatch_vkCmdSetRasterizerDiscardEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetDepthBiasEnable = server_dispatch_vkCmdSetDepthBiasEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdSetPrimitiveRestartEnable = server_dispatch_vkCmdSetPrimitiveRestartEnable;
+    renderer->dispatch.ctx.dispatch_vkCmdDraw = server_dispatch_vkCmdDraw;
+    renderer->dispatch.ctx.dispatch_vkCmdBindIndexBuffer = server_dispatch_vkCmdBindIndexBuffer;
+    renderer->dispatch.ctx.dispatch_vkCmdDrawIndexed = server_dispatch_vkCmdDrawIndexed;
+    renderer->dispatch.ctx.dispatch_vkCmdDrawIndirect = server_dispatch_vkCmdDrawIndirect;
+    renderer->dispatch.ctx.dispatch_vkCmdDrawIndexedIndirect = server_dispatch_vkCmdDrawIndexedIndirect;
+    renderer->dispatch.ctx.dispatch_vkCmdDrawIndirectCount = server_dispatch_vkCmdDrawIndirectCount;
+    renderer->dispatch.ctx.dispatch_vkCmdDrawIndexedIndirectCount = server_dispatch_vkCmdDrawIndexedIndirectCount;
+    renderer->dispatch.ctx.dispatch_vkCmdExecuteCommands = server_dispatch_vkCmdExecuteCommands;
+    renderer->dispatch.ctx.dispatch_vkCmdPipelineBarrier = server_dispatch_vkCmdPipelineBarrier;
+    renderer->dispatch.ctx.dispatch_vkCmdPipelineBarrier2 = server_dispatch_vkCmdPipelineBarrier2;
+    renderer->dispatch.ctx.dispatch_vkCmdResetQueryPool = server_dispatch_vkCmdResetQueryPool;
+    renderer->dispatch.ctx.dispatch_vkCmdBeginQuery = server_dispatch_vkCmdBeginQuery;
+    renderer->dispatch.ctx.dispatch_vkCmdEndQuery = server_dispatch_vkCmdEndQuery;
+    renderer->dispatch.ctx.dispatch_vkCmdWriteTimestamp = server_dispatch_vkCmdWriteTimestamp;
+    renderer->dispatch.ctx.dispatch_vkCmdWriteTimestamp2 = server_dispatch_vkCmdWriteTimestamp2;
+    renderer->dispatch.ctx.dispatch_vkCmdCopyQueryPoolResults = server_dispatch_vkCmdCopyQueryPoolResults;
+    renderer->dispatch.ctx.dispatch_vkCmdSetEvent = server_dispatch_vkCmdSetEvent;
+    renderer->dispatch.ctx.dispatch_vkCmdSetEvent2 = server_dispatch_vkCmdSetEvent2;
+    renderer->dispatch.ctx.dispatch_vkCmdResetEvent = server_dispatch_vkCmdResetEvent;
+    renderer->dispatch.ctx.dispatch_vkCmdResetEvent2 = server_dispatch_vkCmdResetEvent2;
+    renderer->dispatch.ctx.dispatch_vkCmdWaitEvents = server_dispatch_vkCmdWaitEvents;
+    renderer->dispatch.ctx.dispatch_vkCmdWaitEvents2 = server_dispatch_vkCmdWaitEvents2;
+    renderer->dispatch.ctx.dispatch_vkCreateFence = server_dispatch_vkCreateFence;
+    renderer->dispatch.ctx.dispatch_vkDestroyFence = server_dispatch_vkDestroyFence;
+    renderer->dispatch.ctx.dispatch_vkGetFenceStatus = server_dispatch_vkGetFenceStatus;
+    renderer->dispatch.ctx.dispatch_vkResetFences = server_dispatch_vkResetFences;
+    renderer->dispatch.ctx.dispatch_vkWaitForFences = server_dispatch_vkWaitForFences;
+    renderer->dispatch.ctx.dispatch_vkCreateSemaphore = server_dispatch_vkCreateSemaphore;
+    renderer->dispatch.ctx.dispatch_vkDestroySemaphore = server_dispatch_vkDestroySemaphore;
+    renderer->dispatch.ctx.dispatch_vkGetSemaphoreCounterValue = server_dispatch_vkGetSemaphoreCounterValue;
+    renderer->dispatch.ctx.dispatch_vkSignalSemaphore = server_dispatch_vkSignalSemaphore;
+    renderer->dispatch.ctx.dispatch_vkWaitSemaphores = server_dispatch_vkWaitSemaphores;
+    renderer->dispatch.ctx.dispatch_vkCreateEvent = server_dispatch_vkCreateEvent;
+    renderer->dispatch.ctx.dispatch_vkDestroyEvent = server_dispatch_vkDestroyEvent;
+    renderer->dispatch.ctx.dispatch_vkGetEventStatus = server_dispatch_vkGetEventStatus;
+    renderer->dispatch.ctx.dispatch_vkSetEvent = server_dispatch_vkSetEvent;
+    renderer->dispatch.ctx.dispatch_vkResetEvent = server_dispatch_vkResetEvent;
+    renderer->dispatch.ctx.dispatch_vkQueueSubmit = server_dispatch_vkQueueSubmit;
+    renderer->dispatch.ctx.dispatch_vkQueueSubmit2 = server_dispatch_vkQueueSubmit2;
+    renderer->dispatch.ctx.dispatch_vkQueueWaitIdle = server_dispatch_vkQueueWaitIdle;
+    renderer->dispatch.ctx.dispatch_vkDeviceWaitIdle = server_dispatch_vkDeviceWaitIdle;
+    renderer->dispatch.ctx.dispatch_vkCreateQueryPool = server_dispatch_vkCreateQueryPool;
+    renderer->dispatch.ctx.dispatch_vkDestroyQueryPool = server_dispatch_vkDestroyQueryPool;
+    renderer->dispatch.ctx.dispatch_vkResetQueryPool = server_dispatch_vkResetQueryPool;
+    renderer->dispatch.ctx.dispatch_vkGetQueryPoolResults = server_dispatch_vkGetQueryPoolResults;
 
     return renderer;
 }
@@ -3888,6 +5216,10 @@ struct VenusRenderer* venus_renderer_create(struct ServerState* state) {
 void venus_renderer_destroy(struct VenusRenderer* renderer) {
     if (!renderer)
         return;
+    // Queued compiles decode their copy of the command against this session.
+    if (renderer->compiler)
+        pipeline_compiler_wait(renderer->compiler, renderer);
+    venus_renderer_destroy_parallel_recording(renderer);
     vn_cs_decoder_destroy(renderer->decoder);
     vn_cs_encoder_destroy(renderer->encoder);
     free(renderer);
@@ -3903,11 +5235,17 @@ bool venus_renderer_handle(struct VenusRenderer* renderer,
 
     vn_cs_decoder_init(renderer->decoder, data, size);
     vn_cs_encoder_init_dynamic(renderer->encoder);
+    renderer->stream = (const uint8_t*)data;
+    renderer->stream_size = size;
 
     while (vn_cs_decoder_bytes_remaining(renderer->decoder) > 0 &&
            !vn_cs_decoder_get_fatal(renderer->decoder)) {
-        vn_dispatch_command(&renderer->ctx);
+        if (renderer->recorder && record_next_command(renderer, (const uint8_t*)data, size))
+            continue;
+        renderer->command_offset = size - vn_cs_decoder_bytes_remaining(renderer->decoder);
+        dispatch_next_command(&renderer->dispatch.ctx);
     }
+    renderer->stream = NULL;
 
     if (vn_cs_decoder_get_fatal(renderer->decoder)) {
         vn_cs_decoder_reset_temp_storage(renderer->decoder);
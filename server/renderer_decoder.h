@@ -9,11 +9,26 @@
 extern "C" {
 #endif
 
+struct PipelineCompiler;
 struct ServerState;
 struct VenusRenderer;
 
 struct VenusRenderer* venus_renderer_create(struct ServerState* state);
 void venus_renderer_destroy(struct VenusRenderer* renderer);
+// Buckets each command buffer's vkCmd* stream between begin and end and
+// replays the buckets on |worker_count| threads. Off by default.
+bool venus_renderer_enable_parallel_recording(struct VenusRenderer* renderer, uint32_t worker_count);
+// Recorded commands get handle translation only: no recording-state guard
+// and no copy/fill/update/clear range validation. For clients whose ICD has
+// already validated the same state.
+void venus_renderer_set_trusted_client(struct VenusRenderer* renderer, bool trusted);
+// vkCreate*Pipelines reply with handles right away and the pipelines are
+// compiled on |compiler|'s threads; the first use of one waits for it. Off by
+// default.
+void venus_renderer_enable_async_pipelines(struct VenusRenderer* renderer, struct PipelineCompiler* compiler);
+// Waits until every bucketed command buffer has been replayed and ended, so
+// its state can be inspected outside the command stream.
+void venus_renderer_finish_recording(struct VenusRenderer* renderer);
 bool venus_renderer_handle(struct VenusRenderer* renderer,
                            const void* data,
                            size_t size,
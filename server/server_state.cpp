@@ -1,19 +1,28 @@
 #include "server_state.h"
 #include "server_state_bridge.h"
+#include "memory/host_image_copy.h"
 #include "utils/logging.h"
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #define SERVER_LOG_ERROR() VP_LOG_STREAM_ERROR(SERVER)
 #define SERVER_LOG_INFO() VP_LOG_STREAM_INFO(SERVER)
 
-ServerState::ServerState()
-    : resource_tracker(),
+ServerState::ServerState(const ServerSharedState* shared_state)
+    : shared(shared_state),
+      instance_map(venus_plus::handle_tag::kInstance),
+      physical_device_map(venus_plus::handle_tag::kPhysicalDevice),
+      device_map(venus_plus::handle_tag::kDevice),
+      queue_map(venus_plus::handle_tag::kQueue),
+      resource_tracker(),
       command_buffer_state(),
-      command_validator(&resource_tracker) {}
+      command_validator(&resource_tracker),
+      upload_arena(shared_state ? &shared_state->physical_device_memory_properties : nullptr),
+      staging_transfer(shared_state ? &shared_state->physical_device_memory_properties : nullptr) {}
 
-bool ServerState::initialize_vulkan(bool enable_validation) {
+bool ServerSharedState::initialize(bool enable_validation) {
     venus_plus::VulkanContextCreateInfo info = {};
     info.enable_validation = enable_validation;
     if (!vulkan_context.initialize(info)) {
@@ -71,17 +80,80 @@ bool ServerState::initialize_vulkan(bool enable_validation) {
                                                  queue_family_properties.data());
     }
 
+    cmd_push_descriptor_set = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+        vkGetInstanceProcAddr(real_instance, "vkCmdPushDescriptorSetKHR"));
+    cmd_push_descriptor_set_with_template = reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+        vkGetInstanceProcAddr(real_instance, "vkCmdPushDescriptorSetWithTemplateKHR"));
+
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(real_physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    if (extension_count > 0) {
+        vkEnumerateDeviceExtensionProperties(real_physical_device, nullptr, &extension_count, extensions.data());
+    }
+    auto has_extension = [&](const char* name) {
+        return std::any_of(extensions.begin(), extensions.end(), [name](const VkExtensionProperties& extension) {
+            return std::strcmp(extension.extensionName, name) == 0;
+        });
+    };
+
+    if (VK_API_VERSION_MAJOR(physical_device_properties.apiVersion) > 1 ||
+        VK_API_VERSION_MINOR(physical_device_properties.apiVersion) >= 2) {
+        cmd_draw_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndirectCount>(
+            vkGetInstanceProcAddr(real_instance, "vkCmdDrawIndirectCount"));
+        cmd_draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+            vkGetInstanceProcAddr(real_instance, "vkCmdDrawIndexedIndirectCount"));
+    } else if (has_extension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+        cmd_draw_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndirectCount>(
+            vkGetInstanceProcAddr(real_instance, "vkCmdDrawIndirectCountKHR"));
+        cmd_draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+            vkGetInstanceProcAddr(real_instance, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+
+    if (has_extension(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME)) {
+        copy_memory_to_image = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(
+            vkGetInstanceProcAddr(real_instance, "vkCopyMemoryToImageEXT"));
+        copy_image_to_memory = reinterpret_cast<PFN_vkCopyImageToMemoryEXT>(
+            vkGetInstanceProcAddr(real_instance, "vkCopyImageToMemoryEXT"));
+        copy_image_to_image = reinterpret_cast<PFN_vkCopyImageToImageEXT>(
+            vkGetInstanceProcAddr(real_instance, "vkCopyImageToImageEXT"));
+        transition_image_layout = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(
+            vkGetInstanceProcAddr(real_instance, "vkTransitionImageLayoutEXT"));
+    }
+    host_image_copy_native = !emulate_host_image_copy && copy_memory_to_image && copy_image_to_memory &&
+                             copy_image_to_image && transition_image_layout;
+    host_image_copy_emulatable = VK_API_VERSION_MAJOR(physical_device_properties.apiVersion) > 1 ||
+                                 VK_API_VERSION_MINOR(physical_device_properties.apiVersion) >= 3 ||
+                                 (has_extension(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME) &&
+                                  has_extension(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME));
+    const char* host_image_copy_mode = "unavailable";
+    if (host_image_copy_native) {
+        host_image_copy_mode = "native";
+    } else if (host_image_copy_emulatable) {
+        host_image_copy_mode = "emulated";
+    }
+    SERVER_LOG_INFO() << "Host image copy: " << host_image_copy_mode;
+
     SERVER_LOG_INFO() << "Selected GPU: " << physical_device_properties.deviceName;
+    pipeline_cache_store.load(venus_plus::PipelineCacheKey::from_properties(physical_device_properties));
     return true;
 }
 
-void ServerState::shutdown_vulkan() {
+void ServerSharedState::shutdown() {
+    pipeline_cache_store.log_stats();
     queue_family_properties.clear();
-    physical_device_info_map.clear();
-    instance_info_map.clear();
+    cmd_push_descriptor_set = nullptr;
+    cmd_push_descriptor_set_with_template = nullptr;
+    cmd_draw_indirect_count = nullptr;
+    cmd_draw_indexed_indirect_count = nullptr;
+    host_image_copy_native = false;
+    host_image_copy_emulatable = false;
+    copy_memory_to_image = nullptr;
+    copy_image_to_memory = nullptr;
+    copy_image_to_image = nullptr;
+    transition_image_layout = nullptr;
     real_physical_device = VK_NULL_HANDLE;
     real_instance = VK_NULL_HANDLE;
-    fake_device_handle = VK_NULL_HANDLE;
     vulkan_context.shutdown();
 }
 
@@ -109,15 +181,49 @@ static const VkTimelineSemaphoreSubmitInfo* find_timeline_submit_info(const void
     return nullptr;
 }
 
+void server_state_release_session(ServerState* state) {
+    std::vector<VkDevice> devices;
+    devices.reserve(state->device_info_map.size());
+    for (const auto& entry : state->device_info_map) {
+        devices.push_back(entry.first);
+    }
+    if (!devices.empty()) {
+        SERVER_LOG_INFO() << "Releasing " << devices.size() << " device(s) left by the client";
+    }
+    for (VkDevice device : devices) {
+        VkDevice real_device = server_state_get_real_device(state, device);
+        if (real_device != VK_NULL_HANDLE) {
+            vkDeviceWaitIdle(real_device);
+        }
+        state->command_buffer_state.remove_device(device);
+        state->upload_arena.remove_device(device);
+        state->staging_transfer.remove_device(device);
+        state->resource_tracker.remove_device(device);
+        state->sync_manager.remove_device(device);
+        server_state_release_device_pipeline_cache(state, device);
+        if (real_device != VK_NULL_HANDLE) {
+            vkDestroyDevice(real_device, nullptr);
+        }
+        server_state_remove_device(state, device);
+    }
+    std::vector<VkInstance> instances;
+    for (const auto& entry : state->instance_info_map) {
+        instances.push_back(entry.first);
+    }
+    for (VkInstance instance : instances) {
+        server_state_remove_instance(state, instance);
+    }
+}
+
 VkInstance server_state_alloc_instance(ServerState* state) {
-    if (state->real_instance == VK_NULL_HANDLE) {
+    if (!state->vulkan_ready()) {
         return VK_NULL_HANDLE;
     }
-    VkInstance handle = reinterpret_cast<VkInstance>(state->next_instance_handle++);
-    state->instance_map.insert(handle, state->real_instance);
+    VkInstance real_instance = state->shared->real_instance;
+    VkInstance handle = state->instance_map.issue(real_instance);
     InstanceInfo info = {};
     info.client_handle = handle;
-    info.real_handle = state->real_instance;
+    info.real_handle = real_instance;
     state->instance_info_map[handle] = info;
     return handle;
 }
@@ -137,19 +243,18 @@ VkInstance server_state_get_real_instance(const ServerState* state, VkInstance i
 
 VkPhysicalDevice server_state_get_fake_device(ServerState* state) {
     if (state->fake_device_handle == VK_NULL_HANDLE) {
-        if (state->real_physical_device == VK_NULL_HANDLE) {
+        if (!state->vulkan_ready()) {
             return VK_NULL_HANDLE;
         }
-        state->fake_device_handle =
-            reinterpret_cast<VkPhysicalDevice>(state->next_physical_device_handle++);
-        state->physical_device_map.insert(state->fake_device_handle, state->real_physical_device);
+        const ServerSharedState* shared = state->shared;
+        state->fake_device_handle = state->physical_device_map.issue(shared->real_physical_device);
 
         PhysicalDeviceInfo info = {};
         info.client_handle = state->fake_device_handle;
-        info.real_handle = state->real_physical_device;
-        info.properties = state->physical_device_properties;
-        info.memory_properties = state->physical_device_memory_properties;
-        info.queue_families = state->queue_family_properties;
+        info.real_handle = shared->real_physical_device;
+        info.properties = shared->physical_device_properties;
+        info.memory_properties = shared->physical_device_memory_properties;
+        info.queue_families = shared->queue_family_properties;
         state->physical_device_info_map[info.client_handle] = info;
     }
     return state->fake_device_handle;
@@ -167,19 +272,46 @@ VkDevice server_state_alloc_device(ServerState* state,
     if (real_device == VK_NULL_HANDLE) {
         return VK_NULL_HANDLE;
     }
-    VkDevice handle = reinterpret_cast<VkDevice>(state->next_device_handle++);
-    state->device_map.insert(handle, real_device);
+    VkDevice handle = state->device_map.issue(real_device);
 
     DeviceInfo info = {};
     info.client_handle = handle;
     info.real_handle = real_device;
     info.client_physical_device = physical_device;
     info.real_physical_device = server_state_get_real_physical_device(state, physical_device);
+    if (info.real_physical_device != VK_NULL_HANDLE) {
+        VkPhysicalDeviceProperties properties = {};
+        vkGetPhysicalDeviceProperties(info.real_physical_device, &properties);
+        info.pipeline_cache_key = PipelineCacheKey::from_properties(properties);
+        info.pipeline_cache =
+            state->shared->pipeline_cache_store.create_cache(real_device, info.pipeline_cache_key);
+        info.last_pipeline_cache_save = std::chrono::steady_clock::now();
+    }
     state->device_info_map[handle] = info;
 
     return handle;
 }
 
+void server_state_release_device_pipeline_cache(ServerState* state, VkDevice device) {
+    // Compiles may still be using the cache, and the device.
+    state->resource_tracker.wait_for_pipeline_compiles();
+    auto it = state->device_info_map.find(device);
+    if (it == state->device_info_map.end() || it->second.pipeline_cache == VK_NULL_HANDLE) {
+        return;
+    }
+    DeviceInfo& info = it->second;
+    if (info.pipelines_since_save > 0) {
+        state->shared->pipeline_cache_store.save(info.real_handle, info.pipeline_cache, info.pipeline_cache_key);
+    }
+    vkDestroyPipelineCache(info.real_handle, info.pipeline_cache, nullptr);
+    info.pipeline_cache = VK_NULL_HANDLE;
+}
+
+void server_state_release_device_uploads(ServerState* state, VkDevice device) {
+    state->upload_arena.remove_device(device);
+    state->staging_transfer.remove_device(device);
+}
+
 void server_state_remove_device(ServerState* state, VkDevice device) {
     // Remove all queues associated with this device
     auto it = state->device_info_map.find(device);
@@ -219,8 +351,7 @@ VkQueue server_state_alloc_queue(ServerState* state,
     if (real_queue == VK_NULL_HANDLE) {
         return VK_NULL_HANDLE;
     }
-    VkQueue handle = reinterpret_cast<VkQueue>(state->next_queue_handle++);
-    state->queue_map.insert(handle, real_queue);
+    VkQueue handle = state->queue_map.issue(real_queue);
 
     QueueInfo queue_info = {};
     queue_info.client_handle = handle;
@@ -300,7 +431,9 @@ VkImage server_state_create_image(ServerState* state, VkDevice device, const VkI
         return VK_NULL_HANDLE;
     }
     VkDevice real_device = server_state_get_real_device(state, device);
-    return state->resource_tracker.create_image(device, real_device, *info);
+    VkImageCreateInfo real_info = *info;
+    real_info.usage = host_image_copy_real_usage(state->shared, info->usage);
+    return state->resource_tracker.create_image(device, real_device, real_info);
 }
 
 bool server_state_destroy_image(ServerState* state, VkImage image) {
@@ -415,12 +548,13 @@ VkDeviceMemory server_state_get_real_memory(const ServerState* state, VkDeviceMe
 
 VkShaderModule server_state_create_shader_module(ServerState* state,
                                                  VkDevice device,
-                                                 const VkShaderModuleCreateInfo* info) {
+                                                 const VkShaderModuleCreateInfo* info,
+                                                 const Sha256Digest* code_hash) {
     if (!info) {
         return VK_NULL_HANDLE;
     }
     VkDevice real_device = server_state_get_real_device(state, device);
-    return state->resource_tracker.create_shader_module(device, real_device, *info);
+    return state->resource_tracker.create_shader_module(device, real_device, *info, code_hash);
 }
 
 bool server_state_destroy_shader_module(ServerState* state, VkShaderModule module) {
@@ -511,6 +645,32 @@ VkDescriptorSet server_state_get_real_descriptor_set(const ServerState* state,
     return state->resource_tracker.get_real_descriptor_set(set);
 }
 
+VkDescriptorUpdateTemplate server_state_create_descriptor_update_template(
+    ServerState* state,
+    VkDevice device,
+    const VkDescriptorUpdateTemplateCreateInfo* info) {
+    if (!info || (info->descriptorUpdateEntryCount > 0 && !info->pDescriptorUpdateEntries)) {
+        return VK_NULL_HANDLE;
+    }
+    VkDevice real_device = server_state_get_real_device(state, device);
+    return state->resource_tracker.create_descriptor_update_template(device, real_device, *info);
+}
+
+bool server_state_destroy_descriptor_update_template(ServerState* state,
+                                                     VkDescriptorUpdateTemplate update_template) {
+    return state->resource_tracker.destroy_descriptor_update_template(update_template);
+}
+
+bool server_state_translate_descriptor_update_data(const ServerState* state,
+                                                   VkDescriptorUpdateTemplate update_template,
+                                                   void* data,
+                                                   size_t size,
+                                                   VkDevice* real_device,
+                                                   VkDescriptorUpdateTemplate* real_template) {
+    return state->resource_tracker.translate_descriptor_update_data(
+        update_template, data, size, real_device, real_template);
+}
+
 VkPipelineLayout server_state_create_pipeline_layout(ServerState* state,
                                                      VkDevice device,
                                                      const VkPipelineLayoutCreateInfo* info) {
@@ -537,10 +697,29 @@ VkPipelineCache server_state_create_pipeline_cache(ServerState* state,
         return VK_NULL_HANDLE;
     }
     VkDevice real_device = server_state_get_real_device(state, device);
-    return state->resource_tracker.create_pipeline_cache(device, real_device, info);
+    VkPipelineCache cache = state->resource_tracker.create_pipeline_cache(device, real_device, info);
+    // Application caches start with everything the implicit cache knows.
+    auto it = state->device_info_map.find(device);
+    if (cache != VK_NULL_HANDLE && it != state->device_info_map.end() &&
+        it->second.pipeline_cache != VK_NULL_HANDLE) {
+        VkPipelineCache real_cache = state->resource_tracker.get_real_pipeline_cache(cache);
+        vkMergePipelineCaches(real_device, real_cache, 1, &it->second.pipeline_cache);
+    }
+    return cache;
 }
 
 bool server_state_destroy_pipeline_cache(ServerState* state, VkPipelineCache cache) {
+    // And hand what they compiled back to it, so it is saved too. Pending
+    // compiles may be using either cache.
+    state->resource_tracker.wait_for_pipeline_compiles();
+    auto it = state->device_info_map.find(state->resource_tracker.get_pipeline_cache_device(cache));
+    if (it != state->device_info_map.end() && it->second.pipeline_cache != VK_NULL_HANDLE) {
+        VkPipelineCache real_cache = state->resource_tracker.get_real_pipeline_cache(cache);
+        if (real_cache != VK_NULL_HANDLE &&
+            vkMergePipelineCaches(it->second.real_handle, it->second.pipeline_cache, 1, &real_cache) == VK_SUCCESS) {
+            ++it->second.pipelines_since_save;
+        }
+    }
     return state->resource_tracker.destroy_pipeline_cache(cache);
 }
 
@@ -559,6 +738,8 @@ VkResult server_state_get_pipeline_cache_data(ServerState* state,
     if (real_device == VK_NULL_HANDLE || real_cache == VK_NULL_HANDLE) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
+    // The data should hold every pipeline the application created.
+    state->resource_tracker.wait_for_pipeline_compiles();
     return vkGetPipelineCacheData(real_device, real_cache, pDataSize, pData);
 }
 
@@ -575,6 +756,8 @@ VkResult server_state_merge_pipeline_caches(ServerState* state,
     if (real_device == VK_NULL_HANDLE || real_dst == VK_NULL_HANDLE) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
+    // Compiles may be writing to the destination.
+    state->resource_tracker.wait_for_pipeline_compiles();
     std::vector<VkPipelineCache> real_src(src_count);
     for (uint32_t i = 0; i < src_count; ++i) {
         real_src[i] = state->resource_tracker.get_real_pipeline_cache(src_caches[i]);
@@ -706,6 +889,44 @@ VkFramebuffer server_state_get_real_framebuffer(const ServerState* state,
     return state->resource_tracker.get_real_framebuffer(framebuffer);
 }
 
+// Pipelines created through the implicit cache are saved once this many have
+// accumulated, or when the last save is this old.
+static constexpr uint32_t kPipelineCacheSavePipelines = 256;
+static constexpr std::chrono::seconds kPipelineCacheSaveInterval(30);
+
+// The client's cache translated, or the device's implicit cache when the
+// client passed none (*implicit is set then).
+static VkPipelineCache resolve_pipeline_cache(ServerState* state,
+                                              VkDevice device,
+                                              VkPipelineCache cache,
+                                              DeviceInfo** implicit) {
+    *implicit = nullptr;
+    if (cache != VK_NULL_HANDLE) {
+        return state->resource_tracker.get_real_pipeline_cache(cache);
+    }
+    auto it = state->device_info_map.find(device);
+    if (it == state->device_info_map.end()) {
+        return VK_NULL_HANDLE;
+    }
+    *implicit = &it->second;
+    return it->second.pipeline_cache;
+}
+
+static void note_implicit_pipelines(ServerState* state, DeviceInfo* info, uint32_t count) {
+    if (!info || info->pipeline_cache == VK_NULL_HANDLE) {
+        return;
+    }
+    info->pipelines_since_save += count;
+    const auto now = std::chrono::steady_clock::now();
+    if (info->pipelines_since_save < kPipelineCacheSavePipelines &&
+        now - info->last_pipeline_cache_save < kPipelineCacheSaveInterval) {
+        return;
+    }
+    state->shared->pipeline_cache_store.save(info->real_handle, info->pipeline_cache, info->pipeline_cache_key);
+    info->pipelines_since_save = 0;
+    info->last_pipeline_cache_save = now;
+}
+
 VkResult server_state_create_compute_pipelines(ServerState* state,
                                                VkDevice device,
                                                VkPipelineCache cache,
@@ -716,7 +937,14 @@ VkResult server_state_create_compute_pipelines(ServerState* state,
         return VK_ERROR_INITIALIZATION_FAILED;
     }
     VkDevice real_device = server_state_get_real_device(state, device);
-    return state->resource_tracker.create_compute_pipelines(device, real_device, cache, count, infos, out_pipelines);
+    DeviceInfo* implicit = nullptr;
+    VkPipelineCache real_cache = resolve_pipeline_cache(state, device, cache, &implicit);
+    VkResult result =
+        state->resource_tracker.create_compute_pipelines(device, real_device, real_cache, count, infos, out_pipelines);
+    if (result == VK_SUCCESS) {
+        note_implicit_pipelines(state, implicit, count);
+    }
+    return result;
 }
 
 bool server_state_destroy_pipeline(ServerState* state, VkPipeline pipeline) {
@@ -737,12 +965,74 @@ VkResult server_state_create_graphics_pipelines(ServerState* state,
         return VK_ERROR_INITIALIZATION_FAILED;
     }
     VkDevice real_device = server_state_get_real_device(state, device);
-    return state->resource_tracker.create_graphics_pipelines(device,
-                                                             real_device,
-                                                             cache,
-                                                             count,
-                                                             infos,
-                                                             out_pipelines);
+    DeviceInfo* implicit = nullptr;
+    VkPipelineCache real_cache = resolve_pipeline_cache(state, device, cache, &implicit);
+    VkResult result = state->resource_tracker.create_graphics_pipelines(device,
+                                                                        real_device,
+                                                                        real_cache,
+                                                                        count,
+                                                                        infos,
+                                                                        out_pipelines);
+    if (result == VK_SUCCESS) {
+        note_implicit_pipelines(state, implicit, count);
+    }
+    return result;
+}
+
+VkResult server_state_reserve_pipelines(ServerState* state,
+                                        VkDevice device,
+                                        VkPipelineCache cache,
+                                        VkPipelineBindPoint bind_point,
+                                        uint32_t count,
+                                        VkPipeline* out_pipelines,
+                                        VkPipelineCache* out_real_cache) {
+    VkDevice real_device = server_state_get_real_device(state, device);
+    if (!out_pipelines || !out_real_cache || real_device == VK_NULL_HANDLE) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    DeviceInfo* implicit = nullptr;
+    *out_real_cache = resolve_pipeline_cache(state, device, cache, &implicit);
+    state->resource_tracker.reserve_pipelines(device, real_device, bind_point, count, out_pipelines);
+    // Saves from here miss the pipelines still compiling; the next one
+    // picks them up.
+    note_implicit_pipelines(state, implicit, count);
+    return VK_SUCCESS;
+}
+
+void server_state_compile_compute_pipelines(ServerState* state,
+                                            VkPipelineCache real_cache,
+                                            uint32_t count,
+                                            const VkComputePipelineCreateInfo* infos,
+                                            const VkPipeline* pipelines) {
+    state->resource_tracker.compile_compute_pipelines(real_cache, count, infos, pipelines);
+}
+
+void server_state_compile_graphics_pipelines(ServerState* state,
+                                             VkPipelineCache real_cache,
+                                             uint32_t count,
+                                             const VkGraphicsPipelineCreateInfo* infos,
+                                             const VkPipeline* pipelines) {
+    state->resource_tracker.compile_graphics_pipelines(real_cache, count, infos, pipelines);
+}
+
+bool server_state_can_defer_compute_pipelines(const ServerState* state,
+                                              VkPipelineCache cache,
+                                              uint32_t count,
+                                              const VkComputePipelineCreateInfo* infos) {
+    if (cache != VK_NULL_HANDLE && state->resource_tracker.pipeline_cache_externally_synchronized(cache)) {
+        return false;
+    }
+    return state->resource_tracker.compute_infos_resolvable(count, infos);
+}
+
+bool server_state_can_defer_graphics_pipelines(const ServerState* state,
+                                               VkPipelineCache cache,
+                                               uint32_t count,
+                                               const VkGraphicsPipelineCreateInfo* infos) {
+    if (cache != VK_NULL_HANDLE && state->resource_tracker.pipeline_cache_externally_synchronized(cache)) {
+        return false;
+    }
+    return state->resource_tracker.graphics_infos_resolvable(count, infos);
 }
 
 VkCommandPool server_state_create_command_pool(ServerState* state,
@@ -756,12 +1046,14 @@ VkCommandPool server_state_create_command_pool(ServerState* state,
 }
 
 bool server_state_destroy_command_pool(ServerState* state, VkCommandPool pool) {
+    state->upload_arena.release_pool(pool);
     return state->command_buffer_state.destroy_pool(pool);
 }
 
 VkResult server_state_reset_command_pool(ServerState* state,
                                          VkCommandPool pool,
                                          VkCommandPoolResetFlags flags) {
+    state->upload_arena.release_pool(pool);
     return state->command_buffer_state.reset_pool(pool, flags);
 }
 
@@ -792,13 +1084,44 @@ void server_state_free_command_buffers(ServerState* state,
         return;
     }
     std::vector<VkCommandBuffer> temp(buffers, buffers + commandBufferCount);
+    for (VkCommandBuffer buffer : temp) {
+        state->upload_arena.release(buffer);
+    }
     state->command_buffer_state.free_command_buffers(pool, temp);
 }
 
 VkResult server_state_begin_command_buffer(ServerState* state,
                                            VkCommandBuffer commandBuffer,
                                            const VkCommandBufferBeginInfo* info) {
-    return state->command_buffer_state.begin(commandBuffer, info);
+    if (!info) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    VkCommandBufferBeginInfo real_info = *info;
+    VkCommandBufferInheritanceInfo inheritance = {};
+    if (state->command_buffer_state.get_level(commandBuffer) != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+        // Ignored for primary buffers; never hand client handles to the driver.
+        real_info.pInheritanceInfo = nullptr;
+    } else if (info->pInheritanceInfo) {
+        inheritance = *info->pInheritanceInfo;
+        if (inheritance.renderPass != VK_NULL_HANDLE) {
+            inheritance.renderPass = server_state_get_real_render_pass(state, inheritance.renderPass);
+            if (inheritance.renderPass == VK_NULL_HANDLE) {
+                SERVER_LOG_ERROR() << "vkBeginCommandBuffer: unknown inheritance render pass";
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
+        if (inheritance.framebuffer != VK_NULL_HANDLE) {
+            inheritance.framebuffer = server_state_get_real_framebuffer(state, inheritance.framebuffer);
+            if (inheritance.framebuffer == VK_NULL_HANDLE) {
+                SERVER_LOG_ERROR() << "vkBeginCommandBuffer: unknown inheritance framebuffer";
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
+        real_info.pInheritanceInfo = &inheritance;
+    }
+    // Begin resets the buffer, so the previous recording's uploads are done.
+    state->upload_arena.release(commandBuffer);
+    return state->command_buffer_state.begin(commandBuffer, &real_info);
 }
 
 VkResult server_state_end_command_buffer(ServerState* state, VkCommandBuffer commandBuffer) {
@@ -808,9 +1131,21 @@ VkResult server_state_end_command_buffer(ServerState* state, VkCommandBuffer com
 VkResult server_state_reset_command_buffer(ServerState* state,
                                            VkCommandBuffer commandBuffer,
                                            VkCommandBufferResetFlags flags) {
+    state->upload_arena.release(commandBuffer);
     return state->command_buffer_state.reset_buffer(commandBuffer, flags);
 }
 
+VkResult server_state_reuse_command_buffer(ServerState* state, VkCommandBuffer commandBuffer) {
+    if (state->command_buffer_state.get_state(commandBuffer) != ServerCommandBufferState::EXECUTABLE) {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
+    return VK_SUCCESS;
+}
+
+void server_state_allow_implicit_reset(ServerState* state, VkCommandBuffer commandBuffer) {
+    state->command_buffer_state.allow_implicit_reset(commandBuffer);
+}
+
 bool server_state_command_buffer_is_recording(const ServerState* state, VkCommandBuffer commandBuffer) {
     return state->command_buffer_state.is_recording(commandBuffer);
 }
@@ -823,6 +1158,48 @@ VkCommandBuffer server_state_get_real_command_buffer(const ServerState* state, V
     return state->command_buffer_state.get_real_buffer(commandBuffer);
 }
 
+VkCommandPool server_state_get_command_buffer_pool(const ServerState* state, VkCommandBuffer commandBuffer) {
+    return state->command_buffer_state.get_pool(commandBuffer);
+}
+
+bool server_state_allocate_inline_upload(ServerState* state,
+                                         VkCommandBuffer commandBuffer,
+                                         VkDeviceSize size,
+                                         UploadAllocation* out) {
+    VkDevice device = VK_NULL_HANDLE;
+    VkDevice real_device = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    if (!state->command_buffer_state.get_owner(commandBuffer, &device, &real_device, &pool)) {
+        return false;
+    }
+    return state->upload_arena.allocate(device, real_device, pool, commandBuffer, size, out);
+}
+
+bool server_state_validate_cmd_execute_commands(ServerState* state,
+                                                VkCommandBuffer commandBuffer,
+                                                uint32_t commandBufferCount,
+                                                const VkCommandBuffer* commandBuffers) {
+    const CommandBufferState& buffers = state->command_buffer_state;
+    if (buffers.get_level(commandBuffer) != VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+        SERVER_LOG_ERROR() << "Validation error: vkCmdExecuteCommands recorded into a secondary command buffer";
+        return false;
+    }
+    for (uint32_t i = 0; i < commandBufferCount; ++i) {
+        if (!buffers.buffer_exists(commandBuffers[i]) ||
+            buffers.get_level(commandBuffers[i]) != VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+            SERVER_LOG_ERROR() << "Validation error: vkCmdExecuteCommands element " << i
+                               << " is not a secondary command buffer";
+            return false;
+        }
+        if (buffers.get_state(commandBuffers[i]) != ServerCommandBufferState::EXECUTABLE) {
+            SERVER_LOG_ERROR() << "Validation error: vkCmdExecuteCommands element " << i
+                               << " is not executable";
+            return false;
+        }
+    }
+    return true;
+}
+
 static bool log_validation_result(bool result, const std::string& error_message) {
     if (!result && !error_message.empty()) {
         SERVER_LOG_ERROR() << "Validation error: " << error_message;
@@ -1367,7 +1744,8 @@ VkResult server_state_bridge_allocate_descriptor_sets(struct ServerState* state,
     if (!info || !pDescriptorSets) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
-    std::vector<VkDescriptorSet> sets;
+    // The client may have named the sets itself.
+    std::vector<VkDescriptorSet> sets(pDescriptorSets, pDescriptorSets + info->descriptorSetCount);
     VkResult result = venus_plus::server_state_allocate_descriptor_sets(state, device, info, &sets);
     if (result != VK_SUCCESS) {
         return result;
@@ -1391,6 +1769,46 @@ VkDescriptorSet server_state_bridge_get_real_descriptor_set(const struct ServerS
     return venus_plus::server_state_get_real_descriptor_set(state, set);
 }
 
+VkDescriptorUpdateTemplate server_state_bridge_create_descriptor_update_template(
+    struct ServerState* state,
+    VkDevice device,
+    const VkDescriptorUpdateTemplateCreateInfo* info) {
+    return venus_plus::server_state_create_descriptor_update_template(state, device, info);
+}
+
+void server_state_bridge_destroy_descriptor_update_template(struct ServerState* state,
+                                                            VkDescriptorUpdateTemplate update_template) {
+    venus_plus::server_state_destroy_descriptor_update_template(state, update_template);
+}
+
+bool server_state_bridge_translate_descriptor_update_data(const struct ServerState* state,
+                                                          VkDescriptorUpdateTemplate update_template,
+                                                          void* data,
+                                                          size_t size,
+                                                          VkDevice* real_device,
+                                                          VkDescriptorUpdateTemplate* real_template) {
+    return venus_plus::server_state_translate_descriptor_update_data(
+        state, update_template, data, size, real_device, real_template);
+}
+
+PFN_vkCmdPushDescriptorSetKHR server_state_bridge_get_cmd_push_descriptor_set(const struct ServerState* state) {
+    return state->shared ? state->shared->cmd_push_descriptor_set : nullptr;
+}
+
+PFN_vkCmdPushDescriptorSetWithTemplateKHR server_state_bridge_get_cmd_push_descriptor_set_with_template(
+    const struct ServerState* state) {
+    return state->shared ? state->shared->cmd_push_descriptor_set_with_template : nullptr;
+}
+
+PFN_vkCmdDrawIndirectCount server_state_bridge_get_cmd_draw_indirect_count(const struct ServerState* state) {
+    return state->shared ? state->shared->cmd_draw_indirect_count : nullptr;
+}
+
+PFN_vkCmdDrawIndexedIndirectCount server_state_bridge_get_cmd_draw_indexed_indirect_count(
+    const struct ServerState* state) {
+    return state->shared ? state->shared->cmd_draw_indexed_indirect_count : nullptr;
+}
+
 VkPipelineLayout server_state_bridge_create_pipeline_layout(struct ServerState* state,
                                                             VkDevice device,
                                                             const VkPipelineLayoutCreateInfo* info) {
@@ -1526,6 +1944,46 @@ VkResult server_state_bridge_create_graphics_pipelines(struct ServerState* state
     return VK_SUCCESS;
 }
 
+VkResult server_state_bridge_reserve_pipelines(struct ServerState* state,
+                                               VkDevice device,
+                                               VkPipelineCache cache,
+                                               VkPipelineBindPoint bindPoint,
+                                               uint32_t count,
+                                               VkPipeline* pPipelines,
+                                               VkPipelineCache* pRealCache) {
+    return venus_plus::server_state_reserve_pipelines(state, device, cache, bindPoint, count, pPipelines, pRealCache);
+}
+
+void server_state_bridge_compile_compute_pipelines(struct ServerState* state,
+                                                   VkPipelineCache realCache,
+                                                   uint32_t count,
+                                                   const VkComputePipelineCreateInfo* pCreateInfos,
+                                                   const VkPipeline* pPipelines) {
+    venus_plus::server_state_compile_compute_pipelines(state, realCache, count, pCreateInfos, pPipelines);
+}
+
+void server_state_bridge_compile_graphics_pipelines(struct ServerState* state,
+                                                    VkPipelineCache realCache,
+                                                    uint32_t count,
+                                                    const VkGraphicsPipelineCreateInfo* pCreateInfos,
+                                                    const VkPipeline* pPipelines) {
+    venus_plus::server_state_compile_graphics_pipelines(state, realCache, count, pCreateInfos, pPipelines);
+}
+
+bool server_state_bridge_can_defer_compute_pipelines(const struct ServerState* state,
+                                                     VkPipelineCache cache,
+                                                     uint32_t count,
+                                                     const VkComputePipelineCreateInfo* pCreateInfos) {
+    return venus_plus::server_state_can_defer_compute_pipelines(state, cache, count, pCreateInfos);
+}
+
+bool server_state_bridge_can_defer_graphics_pipelines(const struct ServerState* state,
+                                                      VkPipelineCache cache,
+                                                      uint32_t count,
+                                                      const VkGraphicsPipelineCreateInfo* pCreateInfos) {
+    return venus_plus::server_state_can_defer_graphics_pipelines(state, cache, count, pCreateInfos);
+}
+
 // Phase 3: C bridge functions for device management
 VkDevice server_state_bridge_alloc_device(struct ServerState* state,
                                           VkPhysicalDevice physical_device,
@@ -1537,6 +1995,14 @@ void server_state_bridge_remove_device(struct ServerState* state, VkDevice devic
     venus_plus::server_state_remove_device(state, device);
 }
 
+void server_state_bridge_release_device_pipeline_cache(struct ServerState* state, VkDevice device) {
+    venus_plus::server_state_release_device_pipeline_cache(state, device);
+}
+
+void server_state_bridge_release_device_uploads(struct ServerState* state, VkDevice device) {
+    venus_plus::server_state_release_device_uploads(state, device);
+}
+
 bool server_state_bridge_device_exists(const struct ServerState* state, VkDevice device) {
     return venus_plus::server_state_device_exists(state, device);
 }
@@ -1600,6 +2066,72 @@ bool server_state_bridge_get_image_subresource_layout(struct ServerState* state,
     return venus_plus::server_state_get_image_subresource_layout(state, image, subresource, layout);
 }
 
+VkResult server_state_bridge_enumerate_device_extensions(const struct ServerState* state,
+                                                         VkPhysicalDevice real_physical_device,
+                                                         uint32_t* count,
+                                                         VkExtensionProperties* properties) {
+    return venus_plus::host_image_copy_enumerate_extensions(state->shared, real_physical_device, count, properties);
+}
+
+void server_state_bridge_fill_host_image_copy_features(const struct ServerState* state,
+                                                       VkPhysicalDeviceFeatures2* features) {
+    venus_plus::host_image_copy_fill_features(state->shared, features);
+}
+
+void server_state_bridge_fill_host_image_copy_properties(const struct ServerState* state,
+                                                         VkPhysicalDeviceProperties2* properties) {
+    venus_plus::host_image_copy_fill_properties(state->shared, properties);
+}
+
+VkResult server_state_bridge_get_image_format_properties2(const struct ServerState* state,
+                                                          VkPhysicalDevice real_physical_device,
+                                                          const VkPhysicalDeviceImageFormatInfo2* info,
+                                                          VkImageFormatProperties2* properties) {
+    return venus_plus::host_image_copy_get_image_format_properties(state->shared,
+                                                                   real_physical_device,
+                                                                   info,
+                                                                   properties);
+}
+
+VkImageUsageFlags server_state_bridge_get_real_image_usage(const struct ServerState* state, VkImageUsageFlags usage) {
+    return venus_plus::host_image_copy_real_usage(state->shared, usage);
+}
+
+VkResult server_state_bridge_create_real_device(const struct ServerState* state,
+                                                VkPhysicalDevice real_physical_device,
+                                                const VkDeviceCreateInfo* info,
+                                                const VkAllocationCallbacks* allocator,
+                                                VkDevice* device) {
+    return venus_plus::host_image_copy_create_device(state->shared, real_physical_device, info, allocator, device);
+}
+
+VkResult server_state_bridge_copy_memory_to_image(struct ServerState* state,
+                                                  VkDevice device,
+                                                  const VkCopyMemoryToImageInfo* info,
+                                                  const size_t* data_sizes) {
+    return venus_plus::host_image_copy_memory_to_image(state, device, info, data_sizes);
+}
+
+VkResult server_state_bridge_copy_image_to_memory(struct ServerState* state,
+                                                  VkDevice device,
+                                                  const VkCopyImageToMemoryInfo* info,
+                                                  size_t data_size) {
+    return venus_plus::host_image_copy_image_to_memory(state, device, info, data_size);
+}
+
+VkResult server_state_bridge_copy_image_to_image(struct ServerState* state,
+                                                 VkDevice device,
+                                                 const VkCopyImageToImageInfo* info) {
+    return venus_plus::host_image_copy_image_to_image(state, device, info);
+}
+
+VkResult server_state_bridge_transition_image_layout(struct ServerState* state,
+                                                     VkDevice device,
+                                                     uint32_t count,
+                                                     const VkHostImageLayoutTransitionInfo* transitions) {
+    return venus_plus::host_image_copy_transition_layout(state, device, count, transitions);
+}
+
 VkImageView server_state_bridge_create_image_view(struct ServerState* state,
                                                   VkDevice device,
                                                   const VkImageViewCreateInfo* info) {
@@ -1674,6 +2206,10 @@ VkResult server_state_bridge_reset_command_buffer(struct ServerState* state,
     return venus_plus::server_state_reset_command_buffer(state, commandBuffer, flags);
 }
 
+void server_state_bridge_allow_implicit_reset(struct ServerState* state, VkCommandBuffer commandBuffer) {
+    venus_plus::server_state_allow_implicit_reset(state, commandBuffer);
+}
+
 bool server_state_bridge_command_buffer_is_recording(const struct ServerState* state, VkCommandBuffer commandBuffer) {
     return venus_plus::server_state_command_buffer_is_recording(state, commandBuffer);
 }
@@ -1682,6 +2218,37 @@ void server_state_bridge_mark_command_buffer_invalid(struct ServerState* state,
     venus_plus::server_state_mark_command_buffer_invalid(state, commandBuffer);
 }
 
+VkCommandPool server_state_bridge_get_command_buffer_pool(const struct ServerState* state,
+                                                          VkCommandBuffer commandBuffer) {
+    return venus_plus::server_state_get_command_buffer_pool(state, commandBuffer);
+}
+
+bool server_state_bridge_allocate_inline_upload(struct ServerState* state,
+                                                VkCommandBuffer commandBuffer,
+                                                VkDeviceSize size,
+                                                VkBuffer* real_buffer,
+                                                VkDeviceSize* offset,
+                                                void** data) {
+    venus_plus::UploadAllocation allocation;
+    if (!venus_plus::server_state_allocate_inline_upload(state, commandBuffer, size, &allocation)) {
+        return false;
+    }
+    *real_buffer = allocation.buffer;
+    *offset = allocation.offset;
+    *data = allocation.data;
+    return true;
+}
+
+bool server_state_bridge_validate_cmd_execute_commands(struct ServerState* state,
+                                                       VkCommandBuffer commandBuffer,
+                                                       uint32_t commandBufferCount,
+                                                       const VkCommandBuffer* pCommandBuffers) {
+    return venus_plus::server_state_validate_cmd_execute_commands(state,
+                                                                  commandBuffer,
+                                                                  commandBufferCount,
+                                                                  pCommandBuffers);
+}
+
 bool server_state_bridge_validate_cmd_copy_buffer(struct ServerState* state,
                                                   VkBuffer srcBuffer,
                                                   VkBuffer dstBuffer,
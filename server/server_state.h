@@ -1,13 +1,17 @@
 #ifndef VENUS_PLUS_SERVER_STATE_H
 #define VENUS_PLUS_SERVER_STATE_H
 
+#include "memory/staging_transfer.h"
 #include "state/handle_map.h"
 #include "state/resource_tracker.h"
 #include "state/command_buffer_state.h"
 #include "state/command_validator.h"
+#include "state/pipeline_cache_store.h"
 #include "state/sync_manager.h"
+#include "state/upload_arena.h"
 #include "vulkan/vulkan_context.h"
 #include <vulkan/vulkan.h>
+#include <chrono>
 #include <cstdint>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +29,11 @@ struct DeviceInfo {
     VkPhysicalDevice client_physical_device = VK_NULL_HANDLE;
     VkPhysicalDevice real_physical_device = VK_NULL_HANDLE;
     std::vector<QueueInfo> queues;
+    // Implicit pipeline cache, used when the client passes none.
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+    venus_plus::PipelineCacheKey pipeline_cache_key;
+    uint32_t pipelines_since_save = 0;
+    std::chrono::steady_clock::time_point last_pipeline_cache_save;
 };
 
 struct PhysicalDeviceInfo {
@@ -40,12 +49,56 @@ struct InstanceInfo {
     VkInstance real_handle = VK_NULL_HANDLE;
 };
 
+// Vulkan state every client session uses: the real instance and the physical
+// device the server exposes. initialize() fills it before the first client
+// connects; after that it is read-only, so sessions read it without locking.
+// The pipeline cache store is the exception and locks internally.
+struct ServerSharedState {
+    bool initialize(bool enable_validation);
+    void shutdown();
+    bool ready() const { return real_physical_device != VK_NULL_HANDLE; }
+
+    venus_plus::VulkanContext vulkan_context;
+    VkInstance real_instance = VK_NULL_HANDLE;
+    VkPhysicalDevice real_physical_device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties physical_device_properties = {};
+    VkPhysicalDeviceMemoryProperties physical_device_memory_properties = {};
+    std::vector<VkQueueFamilyProperties> queue_family_properties;
+    // VK_KHR_push_descriptor entry points, valid for every device of
+    // real_instance; null when the driver lacks the extension.
+    PFN_vkCmdPushDescriptorSetKHR cmd_push_descriptor_set = nullptr;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR cmd_push_descriptor_set_with_template = nullptr;
+    // vkCmdDraw*IndirectCount: core from Vulkan 1.2, VK_KHR_draw_indirect_count
+    // before that; null when the GPU has neither.
+    PFN_vkCmdDrawIndirectCount cmd_draw_indirect_count = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCount cmd_draw_indexed_indirect_count = nullptr;
+    // VK_EXT_host_image_copy entry points when the driver has the extension;
+    // without it the server emulates the extension (memory/host_image_copy.h).
+    // emulate_host_image_copy, set before initialize(), emulates it anyway
+    // (--emulate-host-image-copy), so both paths can be tested on one GPU.
+    bool emulate_host_image_copy = false;
+    bool host_image_copy_native = false;
+    // Whether the driver has what the extension depends on, Vulkan 1.3 or
+    // VK_KHR_copy_commands2 and VK_KHR_format_feature_flags2; without it the
+    // extension is not emulated.
+    bool host_image_copy_emulatable = false;
+    PFN_vkCopyMemoryToImageEXT copy_memory_to_image = nullptr;
+    PFN_vkCopyImageToMemoryEXT copy_image_to_memory = nullptr;
+    PFN_vkCopyImageToImageEXT copy_image_to_image = nullptr;
+    PFN_vkTransitionImageLayoutEXT transition_image_layout = nullptr;
+    // Configured before initialize(), which loads the selected GPU's data.
+    mutable venus_plus::PipelineCacheStore pipeline_cache_store;
+};
+
+// Objects of one client connection. Each session owns its handle tables and
+// is decoded by its connection's thread, so the per-subsystem mutexes below
+// only see that session's traffic.
 struct ServerState {
-    ServerState();
+    explicit ServerState(const ServerSharedState* shared_state);
+
+    bool vulkan_ready() const { return shared && shared->ready(); }
 
-    bool initialize_vulkan(bool enable_validation);
-    void shutdown_vulkan();
-    bool vulkan_ready() const { return real_physical_device != VK_NULL_HANDLE; }
+    const ServerSharedState* shared = nullptr;
 
     venus_plus::HandleMap<VkInstance> instance_map;
     venus_plus::HandleMap<VkPhysicalDevice> physical_device_map;
@@ -57,26 +110,25 @@ struct ServerState {
     std::unordered_map<VkDevice, DeviceInfo> device_info_map;
     std::unordered_map<VkQueue, QueueInfo> queue_info_map;
 
-    uint64_t next_instance_handle = 1;
-    uint64_t next_physical_device_handle = 0x1000;
-    uint64_t next_device_handle = 0x2000;
-    uint64_t next_queue_handle = 0x3000;
     VkPhysicalDevice fake_device_handle = VK_NULL_HANDLE;
-    VkPhysicalDevice real_physical_device = VK_NULL_HANDLE;
-    VkInstance real_instance = VK_NULL_HANDLE;
-    VkPhysicalDeviceProperties physical_device_properties = {};
-    VkPhysicalDeviceMemoryProperties physical_device_memory_properties = {};
-    std::vector<VkQueueFamilyProperties> queue_family_properties;
 
-    venus_plus::VulkanContext vulkan_context;
     venus_plus::ResourceTracker resource_tracker;
     venus_plus::CommandBufferState command_buffer_state;
     venus_plus::CommandValidator command_validator;
     venus_plus::SyncManager sync_manager;
+    // Staging for inline uploads, owned by the command buffers that copy it.
+    venus_plus::UploadArena upload_arena;
+    // Staging for mapped-memory transfers into memory the host cannot map
+    // and for emulated host image copies.
+    venus_plus::StagingTransfer staging_transfer;
 };
 
 namespace venus_plus {
 
+// Destroys every device the client left behind, with the objects tracked for
+// it, and forgets its instances. Called when the connection closes.
+void server_state_release_session(ServerState* state);
+
 VkInstance server_state_alloc_instance(ServerState* state);
 void server_state_remove_instance(ServerState* state, VkInstance instance);
 bool server_state_instance_exists(const ServerState* state, VkInstance instance);
@@ -89,6 +141,12 @@ VkDevice server_state_alloc_device(ServerState* state,
                                    VkPhysicalDevice physical_device,
                                    VkDevice real_device);
 void server_state_remove_device(ServerState* state, VkDevice device);
+// Saves and destroys the device's implicit pipeline cache; call before the
+// real device is destroyed.
+void server_state_release_device_pipeline_cache(ServerState* state, VkDevice device);
+// Frees the device's inline upload and memory transfer staging; call before
+// the real device is destroyed.
+void server_state_release_device_uploads(ServerState* state, VkDevice device);
 bool server_state_device_exists(const ServerState* state, VkDevice device);
 VkPhysicalDevice server_state_get_device_physical_device(const ServerState* state, VkDevice device);
 VkDevice server_state_get_real_device(const ServerState* state, VkDevice device);
@@ -117,7 +175,7 @@ bool server_state_get_image_subresource_layout(ServerState* state, VkImage image
 VkBuffer server_state_get_real_buffer(const ServerState* state, VkBuffer buffer);
 VkImage server_state_get_real_image(const ServerState* state, VkImage image);
 VkDeviceMemory server_state_get_real_memory(const ServerState* state, VkDeviceMemory memory);
-VkShaderModule server_state_create_shader_module(ServerState* state, VkDevice device, const VkShaderModuleCreateInfo* info);
+VkShaderModule server_state_create_shader_module(ServerState* state, VkDevice device, const VkShaderModuleCreateInfo* info, const Sha256Digest* code_hash = nullptr);
 bool server_state_destroy_shader_module(ServerState* state, VkShaderModule module);
 VkShaderModule server_state_get_real_shader_module(const ServerState* state, VkShaderModule module);
 VkDescriptorSetLayout server_state_create_descriptor_set_layout(ServerState* state, VkDevice device, const VkDescriptorSetLayoutCreateInfo* info);
@@ -137,6 +195,16 @@ VkResult server_state_free_descriptor_sets(ServerState* state,
                                            uint32_t descriptorSetCount,
                                            const VkDescriptorSet* pDescriptorSets);
 VkDescriptorSet server_state_get_real_descriptor_set(const ServerState* state, VkDescriptorSet set);
+VkDescriptorUpdateTemplate server_state_create_descriptor_update_template(ServerState* state,
+                                                                         VkDevice device,
+                                                                         const VkDescriptorUpdateTemplateCreateInfo* info);
+bool server_state_destroy_descriptor_update_template(ServerState* state, VkDescriptorUpdateTemplate update_template);
+bool server_state_translate_descriptor_update_data(const ServerState* state,
+                                                   VkDescriptorUpdateTemplate update_template,
+                                                   void* data,
+                                                   size_t size,
+                                                   VkDevice* real_device,
+                                                   VkDescriptorUpdateTemplate* real_template);
 VkPipelineLayout server_state_create_pipeline_layout(ServerState* state, VkDevice device, const VkPipelineLayoutCreateInfo* info);
 bool server_state_destroy_pipeline_layout(ServerState* state, VkPipelineLayout layout);
 VkPipelineLayout server_state_get_real_pipeline_layout(const ServerState* state, VkPipelineLayout layout);
@@ -163,6 +231,36 @@ VkResult server_state_create_compute_pipelines(ServerState* state,
                                                std::vector<VkPipeline>* out_pipelines);
 bool server_state_destroy_pipeline(ServerState* state, VkPipeline pipeline);
 VkPipeline server_state_get_real_pipeline(const ServerState* state, VkPipeline pipeline);
+// Asynchronous pipeline creation. Reserving issues the handles and resolves
+// the cache on the decode thread; the compile calls only touch the resource
+// tracker and may run on any thread.
+VkResult server_state_reserve_pipelines(ServerState* state,
+                                        VkDevice device,
+                                        VkPipelineCache cache,
+                                        VkPipelineBindPoint bind_point,
+                                        uint32_t count,
+                                        VkPipeline* out_pipelines,
+                                        VkPipelineCache* out_real_cache);
+void server_state_compile_compute_pipelines(ServerState* state,
+                                            VkPipelineCache real_cache,
+                                            uint32_t count,
+                                            const VkComputePipelineCreateInfo* infos,
+                                            const VkPipeline* pipelines);
+void server_state_compile_graphics_pipelines(ServerState* state,
+                                             VkPipelineCache real_cache,
+                                             uint32_t count,
+                                             const VkGraphicsPipelineCreateInfo* infos,
+                                             const VkPipeline* pipelines);
+// Whether the pipelines may be reserved and compiled later: every object they
+// name exists, and |cache| may be used from several threads at once.
+bool server_state_can_defer_compute_pipelines(const ServerState* state,
+                                              VkPipelineCache cache,
+                                              uint32_t count,
+                                              const VkComputePipelineCreateInfo* infos);
+bool server_state_can_defer_graphics_pipelines(const ServerState* state,
+                                               VkPipelineCache cache,
+                                               uint32_t count,
+                                               const VkGraphicsPipelineCreateInfo* infos);
 
 VkCommandPool server_state_create_command_pool(ServerState* state, VkDevice device, const VkCommandPoolCreateInfo* info);
 bool server_state_destroy_command_pool(ServerState* state, VkCommandPool pool);
@@ -172,9 +270,23 @@ void server_state_free_command_buffers(ServerState* state, VkCommandPool pool, u
 VkResult server_state_begin_command_buffer(ServerState* state, VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* info);
 VkResult server_state_end_command_buffer(ServerState* state, VkCommandBuffer commandBuffer);
 VkResult server_state_reset_command_buffer(ServerState* state, VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags);
+// Keeps the existing recording for a client replay hit: VK_SUCCESS when
+// |commandBuffer| is executable.
+VkResult server_state_reuse_command_buffer(ServerState* state, VkCommandBuffer commandBuffer);
+// The client did not forward a reset of |commandBuffer|: its next begin may
+// reset it from EXECUTABLE or INVALID.
+void server_state_allow_implicit_reset(ServerState* state, VkCommandBuffer commandBuffer);
 bool server_state_command_buffer_is_recording(const ServerState* state, VkCommandBuffer commandBuffer);
 void server_state_mark_command_buffer_invalid(ServerState* state, VkCommandBuffer commandBuffer);
 VkCommandBuffer server_state_get_real_command_buffer(const ServerState* state, VkCommandBuffer commandBuffer);
+VkCommandPool server_state_get_command_buffer_pool(const ServerState* state, VkCommandBuffer commandBuffer);
+// Staging space |commandBuffer| copies inline upload data from. It stays
+// valid until the buffer is begun, reset or freed again.
+bool server_state_allocate_inline_upload(ServerState* state,
+                                         VkCommandBuffer commandBuffer,
+                                         VkDeviceSize size,
+                                         UploadAllocation* out);
+bool server_state_validate_cmd_execute_commands(ServerState* state, VkCommandBuffer commandBuffer, uint32_t commandBufferCount, const VkCommandBuffer* commandBuffers);
 bool server_state_validate_cmd_copy_buffer(ServerState* state, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* regions);
 bool server_state_validate_cmd_copy_image(ServerState* state, VkImage srcImage, VkImage dstImage, uint32_t regionCount, const VkImageCopy* regions);
 bool server_state_validate_cmd_blit_image(ServerState* state, VkImage srcImage, VkImage dstImage, uint32_t regionCount, const VkImageBlit* regions);
@@ -67,6 +67,27 @@ VkResult server_state_bridge_free_descriptor_sets(struct ServerState* state,
                                                   const VkDescriptorSet* pDescriptorSets);
 VkDescriptorSet server_state_bridge_get_real_descriptor_set(const struct ServerState* state,
                                                             VkDescriptorSet set);
+VkDescriptorUpdateTemplate server_state_bridge_create_descriptor_update_template(
+    struct ServerState* state,
+    VkDevice device,
+    const VkDescriptorUpdateTemplateCreateInfo* info);
+void server_state_bridge_destroy_descriptor_update_template(struct ServerState* state,
+                                                            VkDescriptorUpdateTemplate update_template);
+// Turns the server handles in packed template data into real ones, in place.
+bool server_state_bridge_translate_descriptor_update_data(const struct ServerState* state,
+                                                          VkDescriptorUpdateTemplate update_template,
+                                                          void* data,
+                                                          size_t size,
+                                                          VkDevice* real_device,
+                                                          VkDescriptorUpdateTemplate* real_template);
+// Null when the GPU has no VK_KHR_push_descriptor.
+PFN_vkCmdPushDescriptorSetKHR server_state_bridge_get_cmd_push_descriptor_set(const struct ServerState* state);
+PFN_vkCmdPushDescriptorSetWithTemplateKHR server_state_bridge_get_cmd_push_descriptor_set_with_template(
+    const struct ServerState* state);
+// Null when the GPU has neither Vulkan 1.2 nor VK_KHR_draw_indirect_count.
+PFN_vkCmdDrawIndirectCount server_state_bridge_get_cmd_draw_indirect_count(const struct ServerState* state);
+PFN_vkCmdDrawIndexedIndirectCount server_state_bridge_get_cmd_draw_indexed_indirect_count(
+    const struct ServerState* state);
 VkPipelineLayout server_state_bridge_create_pipeline_layout(struct ServerState* state,
                                                             VkDevice device,
                                                             const VkPipelineLayoutCreateInfo* info);
@@ -102,12 +123,39 @@ VkResult server_state_bridge_create_graphics_pipelines(struct ServerState* state
                                                        uint32_t createInfoCount,
                                                        const VkGraphicsPipelineCreateInfo* pCreateInfos,
                                                        VkPipeline* pPipelines);
+VkResult server_state_bridge_reserve_pipelines(struct ServerState* state,
+                                               VkDevice device,
+                                               VkPipelineCache cache,
+                                               VkPipelineBindPoint bindPoint,
+                                               uint32_t count,
+                                               VkPipeline* pPipelines,
+                                               VkPipelineCache* pRealCache);
+void server_state_bridge_compile_compute_pipelines(struct ServerState* state,
+                                                   VkPipelineCache realCache,
+                                                   uint32_t count,
+                                                   const VkComputePipelineCreateInfo* pCreateInfos,
+                                                   const VkPipeline* pPipelines);
+void server_state_bridge_compile_graphics_pipelines(struct ServerState* state,
+                                                    VkPipelineCache realCache,
+                                                    uint32_t count,
+                                                    const VkGraphicsPipelineCreateInfo* pCreateInfos,
+                                                    const VkPipeline* pPipelines);
+bool server_state_bridge_can_defer_compute_pipelines(const struct ServerState* state,
+                                                     VkPipelineCache cache,
+                                                     uint32_t count,
+                                                     const VkComputePipelineCreateInfo* pCreateInfos);
+bool server_state_bridge_can_defer_graphics_pipelines(const struct ServerState* state,
+                                                      VkPipelineCache cache,
+                                                      uint32_t count,
+                                                      const VkGraphicsPipelineCreateInfo* pCreateInfos);
 
 // Phase 3: Device and queue management
 VkDevice server_state_bridge_alloc_device(struct ServerState* state,
                                           VkPhysicalDevice physical_device,
                                           VkDevice real_device);
 void server_state_bridge_remove_device(struct ServerState* state, VkDevice device);
+void server_state_bridge_release_device_pipeline_cache(struct ServerState* state, VkDevice device);
+void server_state_bridge_release_device_uploads(struct ServerState* state, VkDevice device);
 bool server_state_bridge_device_exists(const struct ServerState* state, VkDevice device);
 VkQueue server_state_bridge_alloc_queue(struct ServerState* state,
                                         VkDevice device,
@@ -129,6 +177,43 @@ bool server_state_bridge_get_image_memory_requirements(struct ServerState* state
 VkResult server_state_bridge_bind_image_memory(struct ServerState* state, VkImage image, VkDeviceMemory memory, VkDeviceSize offset);
 bool server_state_bridge_get_image_subresource_layout(struct ServerState* state, VkImage image, const VkImageSubresource* subresource, VkSubresourceLayout* layout);
 
+// VK_EXT_host_image_copy, run by the driver or emulated with transfer
+// commands when it lacks the extension. Capability queries and device
+// creation go through these to hide the emulation from the driver.
+VkResult server_state_bridge_enumerate_device_extensions(const struct ServerState* state,
+                                                         VkPhysicalDevice real_physical_device,
+                                                         uint32_t* count,
+                                                         VkExtensionProperties* properties);
+void server_state_bridge_fill_host_image_copy_features(const struct ServerState* state,
+                                                       VkPhysicalDeviceFeatures2* features);
+void server_state_bridge_fill_host_image_copy_properties(const struct ServerState* state,
+                                                         VkPhysicalDeviceProperties2* properties);
+VkResult server_state_bridge_get_image_format_properties2(const struct ServerState* state,
+                                                          VkPhysicalDevice real_physical_device,
+                                                          const VkPhysicalDeviceImageFormatInfo2* info,
+                                                          VkImageFormatProperties2* properties);
+VkImageUsageFlags server_state_bridge_get_real_image_usage(const struct ServerState* state, VkImageUsageFlags usage);
+VkResult server_state_bridge_create_real_device(const struct ServerState* state,
+                                                VkPhysicalDevice real_physical_device,
+                                                const VkDeviceCreateInfo* info,
+                                                const VkAllocationCallbacks* allocator,
+                                                VkDevice* device);
+VkResult server_state_bridge_copy_memory_to_image(struct ServerState* state,
+                                                  VkDevice device,
+                                                  const VkCopyMemoryToImageInfo* info,
+                                                  const size_t* data_sizes);
+VkResult server_state_bridge_copy_image_to_memory(struct ServerState* state,
+                                                  VkDevice device,
+                                                  const VkCopyImageToMemoryInfo* info,
+                                                  size_t data_size);
+VkResult server_state_bridge_copy_image_to_image(struct ServerState* state,
+                                                 VkDevice device,
+                                                 const VkCopyImageToImageInfo* info);
+VkResult server_state_bridge_transition_image_layout(struct ServerState* state,
+                                                     VkDevice device,
+                                                     uint32_t count,
+                                                     const VkHostImageLayoutTransitionInfo* transitions);
+
 VkCommandPool server_state_bridge_create_command_pool(struct ServerState* state, VkDevice device, const VkCommandPoolCreateInfo* info);
 bool server_state_bridge_destroy_command_pool(struct ServerState* state, VkCommandPool commandPool);
 VkResult server_state_bridge_reset_command_pool(struct ServerState* state, VkCommandPool commandPool, VkCommandPoolResetFlags flags);
@@ -137,8 +222,18 @@ void server_state_bridge_free_command_buffers(struct ServerState* state, VkComma
 VkResult server_state_bridge_begin_command_buffer(struct ServerState* state, VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* info);
 VkResult server_state_bridge_end_command_buffer(struct ServerState* state, VkCommandBuffer commandBuffer);
 VkResult server_state_bridge_reset_command_buffer(struct ServerState* state, VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags);
+void server_state_bridge_allow_implicit_reset(struct ServerState* state, VkCommandBuffer commandBuffer);
 bool server_state_bridge_command_buffer_is_recording(const struct ServerState* state, VkCommandBuffer commandBuffer);
 void server_state_bridge_mark_command_buffer_invalid(struct ServerState* state, VkCommandBuffer commandBuffer);
+VkCommandPool server_state_bridge_get_command_buffer_pool(const struct ServerState* state,
+                                                          VkCommandBuffer commandBuffer);
+bool server_state_bridge_allocate_inline_upload(struct ServerState* state,
+                                                VkCommandBuffer commandBuffer,
+                                                VkDeviceSize size,
+                                                VkBuffer* real_buffer,
+                                                VkDeviceSize* offset,
+                                                void** data);
+bool server_state_bridge_validate_cmd_execute_commands(struct ServerState* state, VkCommandBuffer commandBuffer, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers);
 bool server_state_bridge_validate_cmd_copy_buffer(struct ServerState* state, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* pRegions);
 bool server_state_bridge_validate_cmd_copy_image(struct ServerState* state, VkImage srcImage, VkImage dstImage, uint32_t regionCount, const VkImageCopy* pRegions);
 bool server_state_bridge_validate_cmd_blit_image(struct ServerState* state, VkImage srcImage, VkImage dstImage, uint32_t regionCount, const VkImageBlit* pRegions);
@@ -0,0 +1,148 @@
+#ifndef VENUS_PLUS_CLIENT_HANDLE_TABLE_H
+#define VENUS_PLUS_CLIENT_HANDLE_TABLE_H
+
+#include "protocol/client_handles.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace venus_plus {
+
+// Client-issued handles of one type (protocol/client_handles.h) and the
+// server table keys behind them. The handle's index picks the slot, so a
+// lookup is an array index plus a compare, as in SlotMap::translate().
+//
+// insert(), erase() and clear() must be serialized by the owner. translate()
+// takes no lock and may run concurrently with them: each slot publishes the
+// handle and its key as atomics, and a lookup re-checks the handle after
+// reading the key.
+class ClientHandleTable {
+public:
+    static constexpr uint32_t kPageBits = 10;
+    static constexpr uint32_t kPageSize = 1u << kPageBits;
+
+    ClientHandleTable() = default;
+    ClientHandleTable(const ClientHandleTable&) = delete;
+    ClientHandleTable& operator=(const ClientHandleTable&) = delete;
+
+    // False when |handle|'s index is out of range or already holds a live
+    // handle.
+    bool insert(uint64_t handle, uint64_t key) {
+        const uint32_t index = client_handle_index(handle);
+        if (handle == 0 || index >= kClientHandleMaxIndex) {
+            return false;
+        }
+        while ((index >> kPageBits) >= pages_.size()) {
+            add_page();
+        }
+        Slot* s = slot(index);
+        if (s->handle.load(std::memory_order_relaxed) != 0) {
+            return false;
+        }
+        s->key.store(key, std::memory_order_release);
+        s->handle.store(handle, std::memory_order_release);
+        ++size_;
+        return true;
+    }
+
+    void erase(uint64_t handle) {
+        Slot* s = live_slot(handle);
+        if (!s) {
+            return;
+        }
+        s->handle.store(0, std::memory_order_release);
+        --size_;
+    }
+
+    void clear() {
+        for (auto& page : pages_) {
+            for (Slot& s : page->slots) {
+                s.handle.store(0, std::memory_order_release);
+            }
+        }
+        size_ = 0;
+    }
+
+    bool contains(uint64_t handle) const { return translate(handle) != 0; }
+    size_t size() const { return size_; }
+
+    // Lock-free lookup; 0 when |handle| is not live.
+    uint64_t translate(uint64_t handle) const {
+        const uint32_t index = client_handle_index(handle);
+        const Directory* directory = directory_.load(std::memory_order_acquire);
+        if (handle == 0 || !directory || (index >> kPageBits) >= directory->capacity) {
+            return 0;
+        }
+        const Page* page = directory->pages[index >> kPageBits].load(std::memory_order_acquire);
+        if (!page) {
+            return 0;
+        }
+        const Slot& s = page->slots[index & (kPageSize - 1)];
+        if (s.handle.load(std::memory_order_acquire) != handle) {
+            return 0;
+        }
+        const uint64_t key = s.key.load(std::memory_order_acquire);
+        // A concurrent erase (and reuse) of the slot changes its handle first.
+        return s.handle.load(std::memory_order_relaxed) == handle ? key : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> handle{0}; // live client handle, 0 while free
+        std::atomic<uint64_t> key{0};
+    };
+
+    struct Page {
+        Slot slots[kPageSize];
+    };
+
+    struct Directory {
+        explicit Directory(size_t count) : capacity(count), pages(new std::atomic<const Page*>[count]) {
+            for (size_t i = 0; i < count; ++i) {
+                pages[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        size_t capacity;
+        std::unique_ptr<std::atomic<const Page*>[]> pages;
+    };
+
+    Slot* slot(uint32_t index) { return &pages_[index >> kPageBits]->slots[index & (kPageSize - 1)]; }
+
+    Slot* live_slot(uint64_t handle) {
+        const uint32_t index = client_handle_index(handle);
+        if (handle == 0 || (index >> kPageBits) >= pages_.size()) {
+            return nullptr;
+        }
+        Slot* s = slot(index);
+        return s->handle.load(std::memory_order_relaxed) == handle ? s : nullptr;
+    }
+
+    void add_page() {
+        const size_t page_index = pages_.size();
+        pages_.push_back(std::unique_ptr<Page>(new Page()));
+        Directory* directory = directory_.load(std::memory_order_relaxed);
+        if (!directory || page_index >= directory->capacity) {
+            // Old directories stay alive: readers may still hold them.
+            std::unique_ptr<Directory> grown(new Directory(directory ? directory->capacity * 2 : 4));
+            for (size_t i = 0; i < page_index; ++i) {
+                grown->pages[i].store(pages_[i].get(), std::memory_order_relaxed);
+            }
+            directory = grown.get();
+            directories_.push_back(std::move(grown));
+        }
+        directory->pages[page_index].store(pages_.back().get(), std::memory_order_release);
+        directory_.store(directory, std::memory_order_release);
+    }
+
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<std::unique_ptr<Directory>> directories_;
+    std::atomic<Directory*> directory_{nullptr};
+    size_t size_ = 0;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_CLIENT_HANDLE_TABLE_H
@@ -5,36 +5,36 @@
 namespace venus_plus {
 
 CommandBufferState::CommandBufferState()
-    : next_pool_handle_(0x50000000ull),
-      next_buffer_handle_(0x60000000ull) {}
+    : pools_(handle_tag::kCommandPool),
+      buffers_(handle_tag::kCommandBuffer) {}
 
-VkCommandPool CommandBufferState::new_command_pool_handle() {
-    return reinterpret_cast<VkCommandPool>(next_pool_handle_++);
-}
-
-VkCommandBuffer CommandBufferState::new_command_buffer_handle() {
-    return reinterpret_cast<VkCommandBuffer>(next_buffer_handle_++);
+void CommandBufferState::set_state_locked(BufferMap::iterator it, ServerCommandBufferState state) {
+    it->second.state = state;
+    buffers_.set_flags(it->first, static_cast<uint32_t>(state));
 }
 
 VkCommandPool CommandBufferState::create_pool(VkDevice device,
                                               VkDevice real_device,
                                               const VkCommandPoolCreateInfo& info) {
+    // Buffers are always individually resettable on the driver side so a
+    // begin can implicitly reset one whose client-side reset was elided.
+    // |flags| keeps what the client asked for.
+    VkCommandPoolCreateInfo real_info = info;
+    real_info.flags |= VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     VkCommandPool real_pool = VK_NULL_HANDLE;
-    VkResult result = vkCreateCommandPool(real_device, &info, nullptr, &real_pool);
+    VkResult result = vkCreateCommandPool(real_device, &real_info, nullptr, &real_pool);
     if (result != VK_SUCCESS) {
         return VK_NULL_HANDLE;
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkCommandPool handle = new_command_pool_handle();
     PoolEntry entry;
     entry.device = device;
     entry.real_device = real_device;
     entry.real_pool = real_pool;
     entry.flags = info.flags;
     entry.queue_family_index = info.queueFamilyIndex;
-    pools_[handle_key(handle)] = entry;
-    return handle;
+    return reinterpret_cast<VkCommandPool>(pools_.insert(entry, handle_key(real_pool)));
 }
 
 bool CommandBufferState::destroy_pool(VkCommandPool pool) {
@@ -66,7 +66,7 @@ VkResult CommandBufferState::reset_pool(VkCommandPool pool, VkCommandPoolResetFl
     for (VkCommandBuffer buffer : pit->second.buffers) {
         auto bit = buffers_.find(handle_key(buffer));
         if (bit != buffers_.end()) {
-            bit->second.state = ServerCommandBufferState::INITIAL;
+            set_state_locked(bit, ServerCommandBufferState::INITIAL);
         }
     }
     return VK_SUCCESS;
@@ -102,7 +102,6 @@ VkResult CommandBufferState::allocate_command_buffers(VkDevice device,
     out_buffers->clear();
     out_buffers->reserve(info.commandBufferCount);
     for (uint32_t i = 0; i < info.commandBufferCount; ++i) {
-        VkCommandBuffer handle = new_command_buffer_handle();
         BufferEntry entry;
         entry.device = device;
         entry.real_device = pit->second.real_device;
@@ -110,7 +109,9 @@ VkResult CommandBufferState::allocate_command_buffers(VkDevice device,
         entry.real_buffer = real_buffers[i];
         entry.level = info.level;
         entry.state = ServerCommandBufferState::INITIAL;
-        buffers_[handle_key(handle)] = entry;
+        const uint64_t key = buffers_.insert(entry, handle_key(real_buffers[i]),
+                                             static_cast<uint32_t>(entry.state));
+        VkCommandBuffer handle = reinterpret_cast<VkCommandBuffer>(key);
         pit->second.buffers.push_back(handle);
         out_buffers->push_back(handle);
     }
@@ -157,29 +158,41 @@ VkResult CommandBufferState::begin(VkCommandBuffer buffer, const VkCommandBuffer
     }
 
     VkCommandBufferBeginInfo real_info = *info;
+    // The client keeps replayable recordings here across resets it does not
+    // forward and marks those buffers first (allow_implicit_reset()); their
+    // begin resets them implicitly (the real pool is always resettable).
+    bool implicit_reset = bit->second.implicit_reset_allowed;
+    bit->second.implicit_reset_allowed = false;
 
-    VkResult result = VK_SUCCESS;
     switch (bit->second.state) {
         case ServerCommandBufferState::INITIAL:
-            result = vkBeginCommandBuffer(bit->second.real_buffer, &real_info);
-            if (result == VK_SUCCESS) {
-                bit->second.state = ServerCommandBufferState::RECORDING;
-            }
-            return result;
+            break;
         case ServerCommandBufferState::EXECUTABLE:
-            if (info->flags & VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT) {
-                result = vkBeginCommandBuffer(bit->second.real_buffer, &real_info);
-                if (result == VK_SUCCESS) {
-                    bit->second.state = ServerCommandBufferState::RECORDING;
-                }
-                return result;
+            if (!implicit_reset && !(info->flags & VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT)) {
+                return VK_ERROR_VALIDATION_FAILED_EXT;
             }
-            return VK_ERROR_VALIDATION_FAILED_EXT;
+            break;
         case ServerCommandBufferState::RECORDING:
             return VK_ERROR_VALIDATION_FAILED_EXT;
         case ServerCommandBufferState::INVALID:
         default:
-            return VK_ERROR_INITIALIZATION_FAILED;
+            if (!implicit_reset) {
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+            break;
+    }
+    VkResult result = vkBeginCommandBuffer(bit->second.real_buffer, &real_info);
+    if (result == VK_SUCCESS) {
+        set_state_locked(bit, ServerCommandBufferState::RECORDING);
+    }
+    return result;
+}
+
+void CommandBufferState::allow_implicit_reset(VkCommandBuffer buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    if (bit != buffers_.end()) {
+        bit->second.implicit_reset_allowed = true;
     }
 }
 
@@ -194,7 +207,7 @@ VkResult CommandBufferState::end(VkCommandBuffer buffer) {
     }
     VkResult result = vkEndCommandBuffer(bit->second.real_buffer);
     if (result == VK_SUCCESS) {
-        bit->second.state = ServerCommandBufferState::EXECUTABLE;
+        set_state_locked(bit, ServerCommandBufferState::EXECUTABLE);
     }
     return result;
 }
@@ -216,58 +229,85 @@ VkResult CommandBufferState::reset_buffer(VkCommandBuffer buffer, VkCommandBuffe
 
     VkResult result = vkResetCommandBuffer(bit->second.real_buffer, 0);
     if (result == VK_SUCCESS) {
-        bit->second.state = ServerCommandBufferState::INITIAL;
+        set_state_locked(bit, ServerCommandBufferState::INITIAL);
     }
     return result;
 }
 
 bool CommandBufferState::is_recording(VkCommandBuffer buffer) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto bit = buffers_.find(handle_key(buffer));
-    if (bit == buffers_.end()) {
-        return false;
-    }
-    return bit->second.state == ServerCommandBufferState::RECORDING;
+    return get_state(buffer) == ServerCommandBufferState::RECORDING;
 }
 
 bool CommandBufferState::buffer_exists(VkCommandBuffer buffer) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return buffers_.find(handle_key(buffer)) != buffers_.end();
+    return buffers_.contains(handle_key(buffer));
 }
 
 ServerCommandBufferState CommandBufferState::get_state(VkCommandBuffer buffer) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto bit = buffers_.find(handle_key(buffer));
-    if (bit == buffers_.end()) {
+    uint32_t state = 0;
+    if (!buffers_.translate(handle_key(buffer), nullptr, &state)) {
         return ServerCommandBufferState::INVALID;
     }
-    return bit->second.state;
+    return static_cast<ServerCommandBufferState>(state);
 }
 
 void CommandBufferState::invalidate(VkCommandBuffer buffer) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto bit = buffers_.find(handle_key(buffer));
     if (bit != buffers_.end()) {
-        bit->second.state = ServerCommandBufferState::INVALID;
+        set_state_locked(bit, ServerCommandBufferState::INVALID);
     }
 }
 
 VkCommandBuffer CommandBufferState::get_real_buffer(VkCommandBuffer buffer) const {
+    return reinterpret_cast<VkCommandBuffer>(buffers_.translate(handle_key(buffer)));
+}
+
+VkCommandPool CommandBufferState::get_real_pool(VkCommandPool pool) const {
+    return reinterpret_cast<VkCommandPool>(pools_.translate(handle_key(pool)));
+}
+
+VkCommandPool CommandBufferState::get_pool(VkCommandBuffer buffer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    return bit != buffers_.end() ? bit->second.pool : VK_NULL_HANDLE;
+}
+
+VkCommandBufferLevel CommandBufferState::get_level(VkCommandBuffer buffer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto bit = buffers_.find(handle_key(buffer));
+    return bit != buffers_.end() ? bit->second.level : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+}
+
+bool CommandBufferState::get_owner(VkCommandBuffer buffer,
+                                   VkDevice* device,
+                                   VkDevice* real_device,
+                                   VkCommandPool* pool) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto bit = buffers_.find(handle_key(buffer));
     if (bit == buffers_.end()) {
-        return VK_NULL_HANDLE;
+        return false;
     }
-    return bit->second.real_buffer;
+    *device = bit->second.device;
+    *real_device = bit->second.real_device;
+    *pool = bit->second.pool;
+    return true;
 }
 
-VkCommandPool CommandBufferState::get_real_pool(VkCommandPool pool) const {
+void CommandBufferState::remove_device(VkDevice device) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto pit = pools_.find(handle_key(pool));
-    if (pit == pools_.end()) {
-        return VK_NULL_HANDLE;
+    for (auto pit = pools_.begin(); pit != pools_.end();) {
+        if (pit->second.device != device) {
+            ++pit;
+            continue;
+        }
+        for (VkCommandBuffer buffer : pit->second.buffers) {
+            buffers_.erase(handle_key(buffer));
+        }
+        if (pit->second.real_pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(pit->second.real_device, pit->second.real_pool, nullptr);
+        }
+        pit = pools_.erase(pit);
     }
-    return pit->second.real_pool;
 }
 
 } // namespace venus_plus
@@ -3,9 +3,10 @@
 
 #include <vulkan/vulkan.h>
 #include <mutex>
-#include <unordered_map>
 #include <vector>
 
+#include "slot_map.h"
+
 namespace venus_plus {
 
 enum class ServerCommandBufferState {
@@ -32,6 +33,9 @@ public:
     void free_command_buffers(VkCommandPool pool, const std::vector<VkCommandBuffer>& buffers);
 
     VkResult begin(VkCommandBuffer buffer, const VkCommandBufferBeginInfo* info);
+    // Lets the next begin() of |buffer| reset it from EXECUTABLE or INVALID,
+    // for a client that did not forward the reset in between.
+    void allow_implicit_reset(VkCommandBuffer buffer);
     VkResult end(VkCommandBuffer buffer);
     VkResult reset_buffer(VkCommandBuffer buffer, VkCommandBufferResetFlags flags);
 
@@ -41,6 +45,12 @@ public:
     ServerCommandBufferState get_state(VkCommandBuffer buffer) const;
     VkCommandBuffer get_real_buffer(VkCommandBuffer buffer) const;
     VkCommandPool get_real_pool(VkCommandPool pool) const;
+    VkCommandPool get_pool(VkCommandBuffer buffer) const;
+    VkCommandBufferLevel get_level(VkCommandBuffer buffer) const;
+    // The device (client and real handle) and pool |buffer| belongs to.
+    bool get_owner(VkCommandBuffer buffer, VkDevice* device, VkDevice* real_device, VkCommandPool* pool) const;
+    // Destroys the pools (and with them the buffers) of |device|.
+    void remove_device(VkDevice device);
 
 private:
     struct PoolEntry {
@@ -59,6 +69,7 @@ private:
         VkCommandBuffer real_buffer = VK_NULL_HANDLE;
         VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         ServerCommandBufferState state = ServerCommandBufferState::INITIAL;
+        bool implicit_reset_allowed = false;
     };
 
     template <typename T>
@@ -66,14 +77,16 @@ private:
         return reinterpret_cast<uint64_t>(handle);
     }
 
-    VkCommandPool new_command_pool_handle();
-    VkCommandBuffer new_command_buffer_handle();
+    using BufferMap = SlotMap<BufferEntry>;
+
+    // Keeps the lock-free copy of the state (the slot's flags word) in step.
+    void set_state_locked(BufferMap::iterator it, ServerCommandBufferState state);
 
+    // Writers hold mutex_; is_recording(), get_state() and get_real_*() read
+    // the slot maps' translation and flags words without it.
     mutable std::mutex mutex_;
-    std::unordered_map<uint64_t, PoolEntry> pools_;
-    std::unordered_map<uint64_t, BufferEntry> buffers_;
-    uint64_t next_pool_handle_;
-    uint64_t next_buffer_handle_;
+    SlotMap<PoolEntry> pools_;
+    BufferMap buffers_;
 };
 
 } // namespace venus_plus
@@ -2,48 +2,42 @@
 #define VENUS_PLUS_HANDLE_MAP_H
 
 #include <vulkan/vulkan.h>
-#include <unordered_map>
 #include <mutex>
 #include <cstdint>
 
+#include "slot_map.h"
+
 namespace venus_plus {
 
-// Thread-safe bidirectional handle mapping
-// Maps client handles to server handles (which are fake for Phase 2-6)
+// Thread-safe handle mapping
+// Issues client handles for server (real) handles. Lookups are lock-free;
+// issue/remove/clear are serialized internally.
 template<typename T>
 class HandleMap {
 public:
-    // Insert a mapping
-    void insert(T client_handle, T server_handle) {
+    explicit HandleMap(uint8_t tag) : map_(tag) {}
+
+    // Issue a new client handle that maps to server_handle
+    T issue(T server_handle) {
         std::lock_guard<std::mutex> lock(mutex_);
-        uint64_t client_key = handle_to_uint64(client_handle);
         uint64_t server_value = handle_to_uint64(server_handle);
-        map_[client_key] = server_value;
+        return uint64_to_handle<T>(map_.insert(server_value, server_value));
     }
 
     // Lookup server handle from client handle
     T lookup(T client_handle) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        uint64_t client_key = handle_to_uint64(client_handle);
-        auto it = map_.find(client_key);
-        if (it == map_.end()) {
-            return VK_NULL_HANDLE;
-        }
-        return uint64_to_handle<T>(it->second);
+        return uint64_to_handle<T>(map_.translate(handle_to_uint64(client_handle)));
     }
 
     // Check if mapping exists
     bool exists(T client_handle) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        uint64_t client_key = handle_to_uint64(client_handle);
-        return map_.find(client_key) != map_.end();
+        return map_.contains(handle_to_uint64(client_handle));
     }
 
     // Remove mapping
     void remove(T client_handle) {
         std::lock_guard<std::mutex> lock(mutex_);
-        uint64_t client_key = handle_to_uint64(client_handle);
-        map_.erase(client_key);
+        map_.erase(handle_to_uint64(client_handle));
     }
 
     // Clear all mappings
@@ -72,7 +66,7 @@ private:
     }
 
     mutable std::mutex mutex_;
-    std::unordered_map<uint64_t, uint64_t> map_;
+    SlotMap<uint64_t> map_;
 };
 
 } // namespace venus_plus
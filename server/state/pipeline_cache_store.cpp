@@ -0,0 +1,302 @@
+#include "pipeline_cache_store.h"
+
+#include "utils/logging.h"
+#include "utils/sha256.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PIPELINE_CACHE_LOG_ERROR() VP_LOG_STREAM_ERROR(SERVER)
+#define PIPELINE_CACHE_LOG_INFO() VP_LOG_STREAM_INFO(SERVER)
+
+namespace venus_plus {
+
+namespace {
+
+constexpr uint32_t kFileMagic = 0x43505056u; // "VPPC"
+constexpr uint32_t kFileVersion = 1;
+
+// Precedes the driver's data in a cache file.
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint32_t reserved0;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+    uint8_t data_hash[32];
+};
+
+// The driver's data starts with VkPipelineCacheHeaderVersionOne; data for
+// another GPU or driver build is useless, so it is never kept.
+bool driver_header_matches(const std::vector<uint8_t>& data, const PipelineCacheKey& key) {
+    constexpr size_t kDriverHeaderSize = 16 + VK_UUID_SIZE;
+    if (data.size() < kDriverHeaderSize) {
+        return false;
+    }
+    uint32_t words[4] = {};
+    std::memcpy(words, data.data(), sizeof(words));
+    return words[0] >= kDriverHeaderSize && words[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           words[2] == key.vendor_id && words[3] == key.device_id &&
+           std::memcmp(data.data() + 16, key.uuid, VK_UUID_SIZE) == 0;
+}
+
+// Reads at most |max_bytes| of |cache|'s data. When that cuts it short the
+// driver writes only whole entries (VK_INCOMPLETE), which still make a valid
+// cache, and |trimmed| is set.
+bool get_cache_data(VkDevice real_device,
+                    VkPipelineCache cache,
+                    size_t max_bytes,
+                    std::vector<uint8_t>* data,
+                    bool* trimmed) {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(real_device, cache, &size, nullptr) != VK_SUCCESS) {
+        return false;
+    }
+    *trimmed = size > max_bytes;
+    size = std::min(size, max_bytes);
+    data->resize(size);
+    if (size == 0) {
+        return true;
+    }
+    const VkResult result = vkGetPipelineCacheData(real_device, cache, &size, data->data());
+    if (result != VK_SUCCESS && !(result == VK_INCOMPLETE && *trimmed)) {
+        return false;
+    }
+    data->resize(size);
+    return true;
+}
+
+} // namespace
+
+PipelineCacheKey PipelineCacheKey::from_properties(const VkPhysicalDeviceProperties& properties) {
+    PipelineCacheKey key;
+    key.vendor_id = properties.vendorID;
+    key.device_id = properties.deviceID;
+    key.driver_version = properties.driverVersion;
+    std::memcpy(key.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return key;
+}
+
+std::string PipelineCacheKey::name() const {
+    char ids[32];
+    std::snprintf(ids, sizeof(ids), "%04x-%04x-%08x-", vendor_id, device_id, driver_version);
+    std::string result = ids;
+    static const char kHex[] = "0123456789abcdef";
+    for (uint8_t byte : uuid) {
+        result.push_back(kHex[byte >> 4]);
+        result.push_back(kHex[byte & 0xf]);
+    }
+    return result;
+}
+
+void PipelineCacheStore::configure(bool enabled, const std::string& directory, size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+    directory_ = enabled ? directory : std::string();
+    max_bytes_ = max_bytes;
+    if (!directory_.empty() && ::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        PIPELINE_CACHE_LOG_ERROR() << "[PipelineCache] Cannot create " << directory_ << ": "
+                                   << std::strerror(errno) << "; keeping pipelines in memory only";
+        directory_.clear();
+    }
+}
+
+std::string PipelineCacheStore::file_path(const PipelineCacheKey& key) const {
+    return directory_ + "/pipelines-" + key.name() + ".bin";
+}
+
+PipelineCacheStore::Entry& PipelineCacheStore::entry_locked(const PipelineCacheKey& key) {
+    Entry& entry = entries_[key.name()];
+    if (!entry.loaded) {
+        entry.loaded = true;
+        if (!directory_.empty() && read_file(key, &entry.data)) {
+            ++stats_.loads;
+            stats_.bytes += entry.data.size();
+            PIPELINE_CACHE_LOG_INFO() << "[PipelineCache] Loaded " << entry.data.size() << " bytes from "
+                                      << file_path(key);
+        }
+    }
+    return entry;
+}
+
+void PipelineCacheStore::load(const PipelineCacheKey& key) {
+    if (!enabled_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry_locked(key);
+}
+
+VkPipelineCache PipelineCacheStore::create_cache(VkDevice real_device, const PipelineCacheKey& key) {
+    if (!enabled_ || real_device == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    std::vector<uint8_t> data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        data = entry_locked(key).data;
+    }
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = data.size();
+    info.pInitialData = data.empty() ? nullptr : data.data();
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineCache(real_device, &info, nullptr, &cache);
+    if (result != VK_SUCCESS && !data.empty()) {
+        // Drivers should ignore data they cannot use, but not all do.
+        info.initialDataSize = 0;
+        info.pInitialData = nullptr;
+        result = vkCreatePipelineCache(real_device, &info, nullptr, &cache);
+    }
+    if (result != VK_SUCCESS) {
+        PIPELINE_CACHE_LOG_ERROR() << "[PipelineCache] vkCreatePipelineCache failed: " << result;
+        return VK_NULL_HANDLE;
+    }
+    return cache;
+}
+
+void PipelineCacheStore::save(VkDevice real_device, VkPipelineCache cache, const PipelineCacheKey& key) {
+    if (!enabled_ || real_device == VK_NULL_HANDLE || cache == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // |cache| is folded into a scratch cache seeded with what other sessions
+    // saved since it was created, so the last session to save does not drop
+    // their pipelines. |cache| itself is only ever a merge source, which lets
+    // pipeline compiles keep using it meanwhile.
+    std::vector<uint8_t> stored;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stored = entry_locked(key).data;
+    }
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = stored.size();
+    info.pInitialData = stored.empty() ? nullptr : stored.data();
+    VkPipelineCache merged = VK_NULL_HANDLE;
+    VkResult result = vkCreatePipelineCache(real_device, &info, nullptr, &merged);
+    if (result != VK_SUCCESS && !stored.empty()) {
+        info.initialDataSize = 0;
+        info.pInitialData = nullptr;
+        result = vkCreatePipelineCache(real_device, &info, nullptr, &merged);
+    }
+    if (result != VK_SUCCESS) {
+        return;
+    }
+    std::vector<uint8_t> data;
+    bool trimmed = false;
+    const bool valid = vkMergePipelineCaches(real_device, merged, 1, &cache) == VK_SUCCESS &&
+                       get_cache_data(real_device, merged, max_bytes_, &data, &trimmed) &&
+                       driver_header_matches(data, key);
+    vkDestroyPipelineCache(real_device, merged, nullptr);
+    if (!valid) {
+        return;
+    }
+
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (trimmed) {
+            ++stats_.trimmed;
+            PIPELINE_CACHE_LOG_INFO() << "[PipelineCache] Cache trimmed to " << data.size() << " bytes (limit "
+                                      << max_bytes_ << ")";
+        }
+        Entry& entry = entry_locked(key);
+        if (entry.data == data) {
+            return;
+        }
+        stats_.bytes = stats_.bytes - entry.data.size() + data.size();
+        entry.data = data;
+        ++stats_.saves;
+        directory = directory_;
+    }
+    if (!directory.empty()) {
+        write_file(key, data);
+    }
+}
+
+bool PipelineCacheStore::read_file(const PipelineCacheKey& key, std::vector<uint8_t>* data) {
+    const std::string path = file_path(key);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    PipelineCacheFileHeader header = {};
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == kFileMagic &&
+                 header.version == kFileVersion && header.vendor_id == key.vendor_id &&
+                 header.device_id == key.device_id && header.driver_version == key.driver_version &&
+                 std::memcmp(header.uuid, key.uuid, VK_UUID_SIZE) == 0 && header.data_size <= max_bytes_;
+    if (valid) {
+        data->resize(header.data_size);
+        valid = std::fread(data->data(), 1, data->size(), file) == data->size() && std::fgetc(file) == EOF;
+    }
+    std::fclose(file);
+    if (valid) {
+        const Sha256Digest hash = sha256(data->data(), data->size());
+        valid = std::memcmp(hash.data(), header.data_hash, hash.size()) == 0 && driver_header_matches(*data, key);
+    }
+    if (!valid) {
+        PIPELINE_CACHE_LOG_ERROR() << "[PipelineCache] Ignoring damaged or foreign " << path;
+        data->clear();
+        ++stats_.rejected;
+    }
+    return valid;
+}
+
+void PipelineCacheStore::write_file(const PipelineCacheKey& key, const std::vector<uint8_t>& data) const {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = file_path(key);
+    }
+    PipelineCacheFileHeader header = {};
+    header.magic = kFileMagic;
+    header.version = kFileVersion;
+    header.vendor_id = key.vendor_id;
+    header.device_id = key.device_id;
+    header.driver_version = key.driver_version;
+    std::memcpy(header.uuid, key.uuid, VK_UUID_SIZE);
+    header.data_size = data.size();
+    const Sha256Digest hash = sha256(data.data(), data.size());
+    std::memcpy(header.data_hash, hash.data(), hash.size());
+
+    // Written under a temporary name and renamed, so a crash never leaves a
+    // partial file behind.
+    const std::string temp_path = path + ".tmp." + std::to_string(::getpid()) + "." +
+                                  std::to_string(reinterpret_cast<uintptr_t>(data.data()));
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        PIPELINE_CACHE_LOG_ERROR() << "[PipelineCache] Cannot write " << temp_path << ": "
+                                   << std::strerror(errno);
+        return;
+    }
+    const bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                         std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        PIPELINE_CACHE_LOG_ERROR() << "[PipelineCache] Failed to save " << path;
+        std::remove(temp_path.c_str());
+    }
+}
+
+PipelineCacheStoreStats PipelineCacheStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PipelineCacheStore::log_stats() const {
+    const PipelineCacheStoreStats snapshot = stats();
+    PIPELINE_CACHE_LOG_INFO() << "[PipelineCache] loads=" << snapshot.loads
+                              << " rejected=" << snapshot.rejected
+                              << " saves=" << snapshot.saves
+                              << " trimmed=" << snapshot.trimmed
+                              << " bytes=" << snapshot.bytes;
+}
+
+} // namespace venus_plus
@@ -0,0 +1,83 @@
+#ifndef VENUS_PLUS_SERVER_PIPELINE_CACHE_STORE_H
+#define VENUS_PLUS_SERVER_PIPELINE_CACHE_STORE_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+// What a driver's pipeline cache data is valid for.
+struct PipelineCacheKey {
+    uint32_t vendor_id = 0;
+    uint32_t device_id = 0;
+    uint32_t driver_version = 0;
+    uint8_t uuid[VK_UUID_SIZE] = {};
+
+    static PipelineCacheKey from_properties(const VkPhysicalDeviceProperties& properties);
+    // e.g. "10de-2484-86c08000-<uuid hex>", used as the file name stem.
+    std::string name() const;
+};
+
+struct PipelineCacheStoreStats {
+    uint64_t loads = 0;      // cache files accepted
+    uint64_t rejected = 0;   // cache files ignored as damaged or foreign
+    uint64_t saves = 0;      // times the stored data grew
+    uint64_t trimmed = 0;    // saves cut down to the size limit
+    uint64_t bytes = 0;      // data currently held, all keys
+};
+
+// The server's implicit pipeline cache. Every device gets a real
+// VkPipelineCache seeded from what earlier sessions compiled on the same
+// GPU and driver, and pipelines created without an application cache go
+// through it. Sessions fold their cache back in periodically and when the
+// device goes away; with a directory the data is also kept on disk, one file
+// per key, checked against the key and a SHA-256 when read.
+class PipelineCacheStore {
+public:
+    PipelineCacheStore() = default;
+
+    // An empty |directory| keeps the data in memory only.
+    void configure(bool enabled, const std::string& directory, size_t max_bytes);
+    bool enabled() const { return enabled_; }
+
+    // Reads the file for |key| ahead of the first device.
+    void load(const PipelineCacheKey& key);
+
+    // A new real cache holding the stored data for |key|; VK_NULL_HANDLE when
+    // disabled or on failure.
+    VkPipelineCache create_cache(VkDevice real_device, const PipelineCacheKey& key);
+    // Keeps the stored data merged with |cache|, writing it out when it
+    // changed. |cache| is only read.
+    void save(VkDevice real_device, VkPipelineCache cache, const PipelineCacheKey& key);
+
+    PipelineCacheStoreStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Entry {
+        bool loaded = false;
+        std::vector<uint8_t> data;
+    };
+
+    Entry& entry_locked(const PipelineCacheKey& key);
+    bool read_file(const PipelineCacheKey& key, std::vector<uint8_t>* data);
+    void write_file(const PipelineCacheKey& key, const std::vector<uint8_t>& data) const;
+    std::string file_path(const PipelineCacheKey& key) const;
+
+    bool enabled_ = true;
+    std::string directory_;
+    size_t max_bytes_ = 0;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    PipelineCacheStoreStats stats_;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SERVER_PIPELINE_CACHE_STORE_H
@@ -1,30 +1,106 @@
 #include "resource_tracker.h"
 
 #include "binding_validator.h"
+#include "protocol/client_handles.h"
 #include "utils/logging.h"
 #include <algorithm>
+#include <cstring>
 
 #define RESOURCE_LOG_ERROR() VP_LOG_STREAM_ERROR(SERVER)
 
 namespace venus_plus {
 
+namespace {
+
+constexpr VkBufferUsageFlags kTransferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+} // namespace
+
 ResourceTracker::ResourceTracker()
-    : next_buffer_handle_(0x40000000ull),
-      next_image_handle_(0x50000000ull),
-      next_memory_handle_(0x60000000ull),
-      next_image_view_handle_(0x76000000ull),
-      next_buffer_view_handle_(0x77000000ull),
-      next_sampler_handle_(0x78000000ull),
-      next_shader_module_handle_(0x70000000ull),
-      next_descriptor_set_layout_handle_(0x71000000ull),
-      next_descriptor_pool_handle_(0x72000000ull),
-      next_descriptor_set_handle_(0x73000000ull),
-      next_pipeline_layout_handle_(0x74000000ull),
-      next_pipeline_handle_(0x75000000ull),
-      next_render_pass_handle_(0x7a000000ull),
-      next_framebuffer_handle_(0x7b000000ull),
-      next_pipeline_cache_handle_(0x7c000000ull),
-      next_query_pool_handle_(0x7d000000ull) {}
+    : buffers_(handle_tag::kBuffer),
+      images_(handle_tag::kImage),
+      image_views_(handle_tag::kImageView),
+      buffer_views_(handle_tag::kBufferView),
+      samplers_(handle_tag::kSampler),
+      render_passes_(handle_tag::kRenderPass),
+      framebuffers_(handle_tag::kFramebuffer),
+      memories_(handle_tag::kDeviceMemory),
+      shader_modules_(handle_tag::kShaderModule),
+      descriptor_set_layouts_(handle_tag::kDescriptorSetLayout),
+      descriptor_pools_(handle_tag::kDescriptorPool),
+      descriptor_sets_(handle_tag::kDescriptorSet),
+      descriptor_update_templates_(handle_tag::kDescriptorUpdateTemplate),
+      pipeline_layouts_(handle_tag::kPipelineLayout),
+      pipelines_(handle_tag::kPipeline),
+      pipeline_caches_(handle_tag::kPipelineCache),
+      query_pools_(handle_tag::kQueryPool) {}
+
+void ResourceTracker::remove_device(VkDevice device) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    compile_cv_.wait(lock, [this] { return pending_compiles_.load(std::memory_order_acquire) == 0; });
+    remove_device_objects_locked(pipelines_, device, [](const PipelineResource& r) {
+        vkDestroyPipeline(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(pipeline_layouts_, device, [](const PipelineLayoutResource& r) {
+        vkDestroyPipelineLayout(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(pipeline_caches_, device, [](const PipelineCacheResource& r) {
+        vkDestroyPipelineCache(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(shader_modules_, device, [this](const ShaderModuleResource& r) {
+        release_shader_module_locked(r);
+    });
+    // Sets go away with their pool.
+    remove_device_objects_locked(descriptor_sets_, device, [this](const DescriptorSetResource& r) {
+        if (r.client_handle != VK_NULL_HANDLE) {
+            client_descriptor_sets_.erase(handle_key(r.client_handle));
+        }
+    });
+    remove_device_objects_locked(descriptor_update_templates_, device,
+                                 [](const DescriptorUpdateTemplateResource& r) {
+                                     vkDestroyDescriptorUpdateTemplate(r.real_device, r.real_handle, nullptr);
+                                 });
+    remove_device_objects_locked(descriptor_pools_, device, [](const DescriptorPoolResource& r) {
+        vkDestroyDescriptorPool(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(descriptor_set_layouts_, device,
+                                 [](const DescriptorSetLayoutResource& r) {
+                                     vkDestroyDescriptorSetLayout(r.real_device, r.real_handle, nullptr);
+                                 });
+    remove_device_objects_locked(query_pools_, device, [](const QueryPoolResource& r) {
+        vkDestroyQueryPool(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(framebuffers_, device, [](const FramebufferResource& r) {
+        vkDestroyFramebuffer(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(render_passes_, device, [](const RenderPassResource& r) {
+        vkDestroyRenderPass(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(image_views_, device, [](const ImageViewResource& r) {
+        vkDestroyImageView(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(buffer_views_, device, [](const BufferViewResource& r) {
+        vkDestroyBufferView(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(samplers_, device, [](const SamplerResource& r) {
+        vkDestroySampler(r.real_device, r.real_handle, nullptr);
+    });
+    // External (swapchain) images belong to the swapchain manager.
+    remove_device_objects_locked(images_, device, [](const ImageResource& r) {
+        if (!r.external) {
+            vkDestroyImage(r.real_device, r.real_handle, nullptr);
+        }
+    });
+    remove_device_objects_locked(buffers_, device, [](const BufferResource& r) {
+        vkDestroyBuffer(r.real_device, r.real_handle, nullptr);
+    });
+    remove_device_objects_locked(memories_, device, [](const MemoryResource& r) {
+        if (r.transfer_buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(r.real_device, r.transfer_buffer, nullptr);
+        }
+        vkFreeMemory(r.real_device, r.real_handle, nullptr);
+    });
+}
 
 VkBuffer ResourceTracker::create_buffer(VkDevice device,
                                         VkDevice real_device,
@@ -40,15 +116,25 @@ VkBuffer ResourceTracker::create_buffer(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkBuffer handle = reinterpret_cast<VkBuffer>(next_buffer_handle_++);
     BufferResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.size = info.size;
     resource.usage = info.usage;
-    buffers_[handle_key(handle)] = resource;
+    // Memory dedicated to the buffer is reached through the buffer itself
+    // when the client maps memory the host cannot (see
+    // get_memory_transfer_buffer). The client adds the usage when it offers
+    // such memory; usage in the chain replaces info.usage.
+    VkBufferUsageFlags2 usage = info.usage;
+    for (auto* next = static_cast<const VkBaseInStructure*>(info.pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_BUFFER_USAGE_FLAGS_2_CREATE_INFO) {
+            usage = reinterpret_cast<const VkBufferUsageFlags2CreateInfo*>(next)->usage;
+        }
+    }
+    resource.transfer_usage = (usage & kTransferUsage) == kTransferUsage;
+    VkBuffer handle =
+        reinterpret_cast<VkBuffer>(buffers_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -107,11 +193,9 @@ VkImage ResourceTracker::create_image(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkImage handle = reinterpret_cast<VkImage>(next_image_handle_++);
     ImageResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.type = info.imageType;
     resource.format = info.format;
@@ -121,20 +205,18 @@ VkImage ResourceTracker::create_image(VkDevice device,
     resource.samples = info.samples;
     resource.tiling = info.tiling;
     resource.usage = info.usage;
-    images_[handle_key(handle)] = resource;
+    VkImage handle = reinterpret_cast<VkImage>(images_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
-void ResourceTracker::register_external_image(VkDevice device,
-                                              VkDevice real_device,
-                                              VkImage client_handle,
-                                              VkImage real_handle,
-                                              const VkImageCreateInfo& info) {
+VkImage ResourceTracker::register_external_image(VkDevice device,
+                                                 VkDevice real_device,
+                                                 VkImage real_handle,
+                                                 const VkImageCreateInfo& info) {
     std::lock_guard<std::mutex> lock(mutex_);
     ImageResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = client_handle;
     resource.real_handle = real_handle;
     resource.type = info.imageType;
     resource.format = info.format;
@@ -145,7 +227,7 @@ void ResourceTracker::register_external_image(VkDevice device,
     resource.tiling = info.tiling;
     resource.usage = info.usage;
     resource.external = true;
-    images_[handle_key(client_handle)] = resource;
+    return reinterpret_cast<VkImage>(images_.insert(resource, handle_key(real_handle)));
 }
 
 void ResourceTracker::unregister_external_image(VkImage image) {
@@ -218,15 +300,14 @@ VkImageView ResourceTracker::create_image_view(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkImageView handle = reinterpret_cast<VkImageView>(next_image_view_handle_++);
     ImageViewResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.image = client_image;
     resource.real_image = real_image;
-    image_views_[handle_key(handle)] = resource;
+    VkImageView handle =
+        reinterpret_cast<VkImageView>(image_views_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -244,12 +325,7 @@ bool ResourceTracker::destroy_image_view(VkImageView view) {
 }
 
 VkImageView ResourceTracker::get_real_image_view(VkImageView view) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = image_views_.find(handle_key(view));
-    if (it == image_views_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkImageView>(image_views_.translate(handle_key(view)));
 }
 
 VkBufferView ResourceTracker::create_buffer_view(VkDevice device,
@@ -270,18 +346,17 @@ VkBufferView ResourceTracker::create_buffer_view(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkBufferView handle = reinterpret_cast<VkBufferView>(next_buffer_view_handle_++);
     BufferViewResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.buffer = client_buffer;
     resource.real_buffer = real_buffer;
     resource.format = info.format;
     resource.offset = info.offset;
     resource.range = info.range;
-    buffer_views_[handle_key(handle)] = resource;
+    VkBufferView handle =
+        reinterpret_cast<VkBufferView>(buffer_views_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -299,12 +374,7 @@ bool ResourceTracker::destroy_buffer_view(VkBufferView view) {
 }
 
 VkBufferView ResourceTracker::get_real_buffer_view(VkBufferView view) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = buffer_views_.find(handle_key(view));
-    if (it == buffer_views_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkBufferView>(buffer_views_.translate(handle_key(view)));
 }
 
 VkSampler ResourceTracker::create_sampler(VkDevice device,
@@ -321,13 +391,12 @@ VkSampler ResourceTracker::create_sampler(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkSampler handle = reinterpret_cast<VkSampler>(next_sampler_handle_++);
     SamplerResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
-    samplers_[handle_key(handle)] = resource;
+    VkSampler handle =
+        reinterpret_cast<VkSampler>(samplers_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -345,12 +414,7 @@ bool ResourceTracker::destroy_sampler(VkSampler sampler) {
 }
 
 VkSampler ResourceTracker::get_real_sampler(VkSampler sampler) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = samplers_.find(handle_key(sampler));
-    if (it == samplers_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkSampler>(samplers_.translate(handle_key(sampler)));
 }
 
 VkRenderPass ResourceTracker::create_render_pass(VkDevice device,
@@ -367,13 +431,12 @@ VkRenderPass ResourceTracker::create_render_pass(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkRenderPass handle = reinterpret_cast<VkRenderPass>(next_render_pass_handle_++);
     RenderPassResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
-    render_passes_[handle_key(handle)] = resource;
+    VkRenderPass handle =
+        reinterpret_cast<VkRenderPass>(render_passes_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -391,36 +454,37 @@ VkRenderPass ResourceTracker::create_render_pass2(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkRenderPass handle = reinterpret_cast<VkRenderPass>(next_render_pass_handle_++);
     RenderPassResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
-    render_passes_[handle_key(handle)] = resource;
+    VkRenderPass handle =
+        reinterpret_cast<VkRenderPass>(render_passes_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
 bool ResourceTracker::destroy_render_pass(VkRenderPass render_pass) {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (!render_passes_.contains(handle_key(render_pass))) {
+        return false;
+    }
+    destroy_after_compiles_locked([this, render_pass] { destroy_render_pass_locked(render_pass); });
+    return true;
+}
+
+void ResourceTracker::destroy_render_pass_locked(VkRenderPass render_pass) {
     auto it = render_passes_.find(handle_key(render_pass));
     if (it == render_passes_.end()) {
-        return false;
+        return;
     }
     if (it->second.real_handle != VK_NULL_HANDLE) {
         vkDestroyRenderPass(it->second.real_device, it->second.real_handle, nullptr);
     }
     render_passes_.erase(it);
-    return true;
 }
 
 VkRenderPass ResourceTracker::get_real_render_pass(VkRenderPass render_pass) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = render_passes_.find(handle_key(render_pass));
-    if (it == render_passes_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkRenderPass>(render_passes_.translate(handle_key(render_pass)));
 }
 
 VkFramebuffer ResourceTracker::create_framebuffer(VkDevice device,
@@ -437,17 +501,16 @@ VkFramebuffer ResourceTracker::create_framebuffer(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkFramebuffer handle = reinterpret_cast<VkFramebuffer>(next_framebuffer_handle_++);
     FramebufferResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.render_pass = info.renderPass;
     if (info.attachmentCount > 0 && info.pAttachments) {
         resource.attachments.assign(info.pAttachments, info.pAttachments + info.attachmentCount);
     }
-    framebuffers_[handle_key(handle)] = resource;
+    VkFramebuffer handle =
+        reinterpret_cast<VkFramebuffer>(framebuffers_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -465,12 +528,7 @@ bool ResourceTracker::destroy_framebuffer(VkFramebuffer framebuffer) {
 }
 
 VkFramebuffer ResourceTracker::get_real_framebuffer(VkFramebuffer framebuffer) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = framebuffers_.find(handle_key(framebuffer));
-    if (it == framebuffers_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkFramebuffer>(framebuffers_.translate(handle_key(framebuffer)));
 }
 
 VkDeviceMemory ResourceTracker::allocate_memory(VkDevice device,
@@ -479,6 +537,20 @@ VkDeviceMemory ResourceTracker::allocate_memory(VkDevice device,
     if (real_device == VK_NULL_HANDLE) {
         return VK_NULL_HANDLE;
     }
+    // The dedicated image or buffer arrives as a server handle. The chain is
+    // the decoder's copy, so it is translated in place.
+    VkImage dedicated_image = VK_NULL_HANDLE;
+    VkBuffer dedicated_buffer = VK_NULL_HANDLE;
+    for (auto* next = static_cast<const VkBaseInStructure*>(info.pNext); next; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO) {
+            auto* dedicated =
+                const_cast<VkMemoryDedicatedAllocateInfo*>(reinterpret_cast<const VkMemoryDedicatedAllocateInfo*>(next));
+            dedicated_image = dedicated->image;
+            dedicated_buffer = dedicated->buffer;
+            dedicated->image = dedicated_image != VK_NULL_HANDLE ? get_real_image(dedicated_image) : VK_NULL_HANDLE;
+            dedicated->buffer = dedicated_buffer != VK_NULL_HANDLE ? get_real_buffer(dedicated_buffer) : VK_NULL_HANDLE;
+        }
+    }
     VkDeviceMemory real_handle = VK_NULL_HANDLE;
     VkResult result = vkAllocateMemory(real_device, &info, nullptr, &real_handle);
     if (result != VK_SUCCESS) {
@@ -487,15 +559,16 @@ VkDeviceMemory ResourceTracker::allocate_memory(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkDeviceMemory handle = reinterpret_cast<VkDeviceMemory>(next_memory_handle_++);
     MemoryResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_handle;
     resource.size = info.allocationSize;
     resource.type_index = info.memoryTypeIndex;
-    memories_[handle_key(handle)] = resource;
+    resource.dedicated_image = dedicated_image != VK_NULL_HANDLE;
+    resource.dedicated_buffer = dedicated_buffer;
+    VkDeviceMemory handle =
+        reinterpret_cast<VkDeviceMemory>(memories_.insert(resource, handle_key(real_handle)));
     return handle;
 }
 
@@ -532,6 +605,9 @@ bool ResourceTracker::free_memory(VkDeviceMemory memory) {
         it->second.mapped_size = 0;
     }
 
+    if (it->second.transfer_buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(real_device, it->second.transfer_buffer, nullptr);
+    }
     if (real_handle != VK_NULL_HANDLE) {
         vkFreeMemory(real_device, real_handle, nullptr);
     }
@@ -676,41 +752,37 @@ bool ResourceTracker::get_image_subresource_layout(VkImage image,
     return true;
 }
 
-bool ResourceTracker::buffer_exists(VkBuffer buffer) const {
+bool ResourceTracker::get_image_format(VkImage image, VkFormat* format) const {
+    if (!format) {
+        return false;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
-    return buffers_.find(handle_key(buffer)) != buffers_.end();
+    auto it = images_.find(handle_key(image));
+    if (it == images_.end()) {
+        return false;
+    }
+    *format = it->second.format;
+    return true;
+}
+
+bool ResourceTracker::buffer_exists(VkBuffer buffer) const {
+    return buffers_.contains(handle_key(buffer));
 }
 
 VkBuffer ResourceTracker::get_real_buffer(VkBuffer buffer) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = buffers_.find(handle_key(buffer));
-    if (it == buffers_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkBuffer>(buffers_.translate(handle_key(buffer)));
 }
 
 bool ResourceTracker::image_exists(VkImage image) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return images_.find(handle_key(image)) != images_.end();
+    return images_.contains(handle_key(image));
 }
 
 VkImage ResourceTracker::get_real_image(VkImage image) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = images_.find(handle_key(image));
-    if (it == images_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkImage>(images_.translate(handle_key(image)));
 }
 
 VkDeviceMemory ResourceTracker::get_real_memory(VkDeviceMemory memory) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = memories_.find(handle_key(memory));
-    if (it == memories_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkDeviceMemory>(memories_.translate(handle_key(memory)));
 }
 
 bool ResourceTracker::get_memory_info(VkDeviceMemory memory,
@@ -770,6 +842,46 @@ VkResult ResourceTracker::get_memory_mapping(VkDeviceMemory memory,
     return VK_SUCCESS;
 }
 
+VkResult ResourceTracker::get_memory_transfer_buffer(VkDeviceMemory memory, VkBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = memories_.find(handle_key(memory));
+    if (it == memories_.end() || !buffer || it->second.dedicated_image) {
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+    MemoryResource& mem = it->second;
+    if (mem.dedicated_buffer != VK_NULL_HANDLE) {
+        auto buffer_it = buffers_.find(handle_key(mem.dedicated_buffer));
+        if (buffer_it == buffers_.end() || !buffer_it->second.transfer_usage) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        *buffer = buffer_it->second.real_handle;
+        return VK_SUCCESS;
+    }
+    if (mem.transfer_buffer == VK_NULL_HANDLE) {
+        VkBufferCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.size = mem.size;
+        info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer transfer_buffer = VK_NULL_HANDLE;
+        VkResult result = vkCreateBuffer(mem.real_device, &info, nullptr, &transfer_buffer);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        // Memory types that only back images cannot take the buffer.
+        VkMemoryRequirements requirements = {};
+        vkGetBufferMemoryRequirements(mem.real_device, transfer_buffer, &requirements);
+        if (!(requirements.memoryTypeBits & (1u << mem.type_index)) || requirements.size > mem.size ||
+            vkBindBufferMemory(mem.real_device, transfer_buffer, mem.real_handle, 0) != VK_SUCCESS) {
+            vkDestroyBuffer(mem.real_device, transfer_buffer, nullptr);
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mem.transfer_buffer = transfer_buffer;
+    }
+    *buffer = mem.transfer_buffer;
+    return VK_SUCCESS;
+}
+
 bool ResourceTracker::ranges_overlap(VkDeviceSize offset_a, VkDeviceSize size_a, VkDeviceSize offset_b, VkDeviceSize size_b) {
     if (size_a == 0 || size_b == 0) {
         return false;
@@ -814,10 +926,31 @@ VkDeviceSize ResourceTracker::compute_layer_pitch_locked(const ImageResource& im
 
 VkShaderModule ResourceTracker::create_shader_module(VkDevice device,
                                                      VkDevice real_device,
-                                                     const VkShaderModuleCreateInfo& info) {
+                                                     const VkShaderModuleCreateInfo& info,
+                                                     const Sha256Digest* code_hash) {
     if (real_device == VK_NULL_HANDLE) {
         return VK_NULL_HANDLE;
     }
+    // Only plain create infos are shared; anything chained may make two
+    // modules of the same code differ.
+    const bool shareable = code_hash && info.pNext == nullptr && info.flags == 0;
+    if (shareable) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto shared_it = shared_shader_modules_.find({real_device, *code_hash});
+        if (shared_it != shared_shader_modules_.end()) {
+            ++shared_it->second.refs;
+            ShaderModuleResource resource = {};
+            resource.handle_device = device;
+            resource.real_device = real_device;
+            resource.real_handle = shared_it->second.real_handle;
+            resource.code_size = info.codeSize;
+            resource.shared = true;
+            resource.code_hash = *code_hash;
+            return reinterpret_cast<VkShaderModule>(
+                shader_modules_.insert(resource, handle_key(resource.real_handle)));
+        }
+    }
+
     VkShaderModule real_module = VK_NULL_HANDLE;
     VkResult result = vkCreateShaderModule(real_device, &info, nullptr, &real_module);
     if (result != VK_SUCCESS) {
@@ -826,37 +959,66 @@ VkShaderModule ResourceTracker::create_shader_module(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkShaderModule handle = reinterpret_cast<VkShaderModule>(next_shader_module_handle_++);
     ShaderModuleResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_module;
     resource.code_size = info.codeSize;
-    shader_modules_[handle_key(handle)] = resource;
+    if (shareable) {
+        auto inserted = shared_shader_modules_.insert({{real_device, *code_hash}, {real_module, 1}});
+        if (inserted.second) {
+            resource.shared = true;
+            resource.code_hash = *code_hash;
+        } else {
+            // Another thread created the same module meanwhile; use that one.
+            vkDestroyShaderModule(real_device, real_module, nullptr);
+            ++inserted.first->second.refs;
+            resource.real_handle = inserted.first->second.real_handle;
+            resource.shared = true;
+            resource.code_hash = *code_hash;
+        }
+    }
+    VkShaderModule handle =
+        reinterpret_cast<VkShaderModule>(shader_modules_.insert(resource, handle_key(resource.real_handle)));
     return handle;
 }
 
+void ResourceTracker::release_shader_module_locked(const ShaderModuleResource& module) {
+    if (module.real_handle == VK_NULL_HANDLE) {
+        return;
+    }
+    if (module.shared) {
+        auto shared_it = shared_shader_modules_.find({module.real_device, module.code_hash});
+        if (shared_it != shared_shader_modules_.end() && --shared_it->second.refs > 0) {
+            return;
+        }
+        if (shared_it != shared_shader_modules_.end()) {
+            shared_shader_modules_.erase(shared_it);
+        }
+    }
+    vkDestroyShaderModule(module.real_device, module.real_handle, nullptr);
+}
+
 bool ResourceTracker::destroy_shader_module(VkShaderModule module) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = shader_modules_.find(handle_key(module));
-    if (it == shader_modules_.end()) {
+    if (!shader_modules_.contains(handle_key(module))) {
         return false;
     }
-    if (it->second.real_handle != VK_NULL_HANDLE) {
-        vkDestroyShaderModule(it->second.real_device, it->second.real_handle, nullptr);
-    }
-    shader_modules_.erase(it);
+    destroy_after_compiles_locked([this, module] { destroy_shader_module_locked(module); });
     return true;
 }
 
-VkShaderModule ResourceTracker::get_real_shader_module(VkShaderModule module) const {
-    std::lock_guard<std::mutex> lock(mutex_);
+void ResourceTracker::destroy_shader_module_locked(VkShaderModule module) {
     auto it = shader_modules_.find(handle_key(module));
     if (it == shader_modules_.end()) {
-        return VK_NULL_HANDLE;
+        return;
     }
-    return it->second.real_handle;
+    release_shader_module_locked(it->second);
+    shader_modules_.erase(it);
+}
+
+VkShaderModule ResourceTracker::get_real_shader_module(VkShaderModule module) const {
+    return reinterpret_cast<VkShaderModule>(shader_modules_.translate(handle_key(module)));
 }
 
 VkDescriptorSetLayout ResourceTracker::create_descriptor_set_layout(
@@ -868,22 +1030,49 @@ VkDescriptorSetLayout ResourceTracker::create_descriptor_set_layout(
         return VK_NULL_HANDLE;
     }
 
+    // Immutable samplers arrive as server handles.
+    VkDescriptorSetLayoutCreateInfo real_info = info;
+    std::vector<VkDescriptorSetLayoutBinding> bindings(info.pBindings, info.pBindings + info.bindingCount);
+    std::vector<VkSampler> samplers;
+    for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+        if (binding.pImmutableSamplers) {
+            samplers.insert(samplers.end(), binding.pImmutableSamplers,
+                            binding.pImmutableSamplers + binding.descriptorCount);
+        }
+    }
+    if (!samplers.empty()) {
+        VkSampler* next_sampler = samplers.data();
+        for (VkDescriptorSetLayoutBinding& binding : bindings) {
+            if (!binding.pImmutableSamplers) {
+                continue;
+            }
+            for (uint32_t i = 0; i < binding.descriptorCount; ++i) {
+                next_sampler[i] = get_real_sampler(next_sampler[i]);
+                if (next_sampler[i] == VK_NULL_HANDLE) {
+                    RESOURCE_LOG_ERROR() << "Unknown immutable sampler in descriptor set layout";
+                    return VK_NULL_HANDLE;
+                }
+            }
+            binding.pImmutableSamplers = next_sampler;
+            next_sampler += binding.descriptorCount;
+        }
+        real_info.pBindings = bindings.data();
+    }
+
     VkDescriptorSetLayout real_layout = VK_NULL_HANDLE;
-    VkResult result = vkCreateDescriptorSetLayout(real_device, &info, nullptr, &real_layout);
+    VkResult result = vkCreateDescriptorSetLayout(real_device, &real_info, nullptr, &real_layout);
     if (result != VK_SUCCESS) {
         RESOURCE_LOG_ERROR() << "vkCreateDescriptorSetLayout failed: " << result;
         return VK_NULL_HANDLE;
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkDescriptorSetLayout handle =
-        reinterpret_cast<VkDescriptorSetLayout>(next_descriptor_set_layout_handle_++);
     DescriptorSetLayoutResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_layout;
-    descriptor_set_layouts_[handle_key(handle)] = resource;
+    VkDescriptorSetLayout handle =
+        reinterpret_cast<VkDescriptorSetLayout>(descriptor_set_layouts_.insert(resource, handle_key(real_layout)));
     return handle;
 }
 
@@ -902,12 +1091,7 @@ bool ResourceTracker::destroy_descriptor_set_layout(VkDescriptorSetLayout layout
 
 VkDescriptorSetLayout
 ResourceTracker::get_real_descriptor_set_layout(VkDescriptorSetLayout layout) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = descriptor_set_layouts_.find(handle_key(layout));
-    if (it == descriptor_set_layouts_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkDescriptorSetLayout>(descriptor_set_layouts_.translate(handle_key(layout)));
 }
 
 VkDescriptorPool ResourceTracker::create_descriptor_pool(
@@ -927,15 +1111,14 @@ VkDescriptorPool ResourceTracker::create_descriptor_pool(
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkDescriptorPool handle =
-        reinterpret_cast<VkDescriptorPool>(next_descriptor_pool_handle_++);
     DescriptorPoolResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_pool;
     resource.flags = info.flags;
-    descriptor_pools_[handle_key(handle)] = resource;
+    resource.client_allocation_error = VK_SUCCESS;
+    VkDescriptorPool handle =
+        reinterpret_cast<VkDescriptorPool>(descriptor_pools_.insert(resource, handle_key(real_pool)));
     return handle;
 }
 
@@ -946,7 +1129,7 @@ bool ResourceTracker::destroy_descriptor_pool(VkDescriptorPool pool) {
         return false;
     }
     for (VkDescriptorSet set : it->second.descriptor_sets) {
-        descriptor_sets_.erase(handle_key(set));
+        erase_descriptor_set_locked(handle_key(set));
     }
     if (it->second.real_handle != VK_NULL_HANDLE) {
         vkDestroyDescriptorPool(it->second.real_device, it->second.real_handle, nullptr);
@@ -965,20 +1148,16 @@ VkResult ResourceTracker::reset_descriptor_pool(VkDescriptorPool pool,
     VkResult result = vkResetDescriptorPool(it->second.real_device, it->second.real_handle, flags);
     if (result == VK_SUCCESS) {
         for (VkDescriptorSet set : it->second.descriptor_sets) {
-            descriptor_sets_.erase(handle_key(set));
+            erase_descriptor_set_locked(handle_key(set));
         }
         it->second.descriptor_sets.clear();
+        it->second.client_allocation_error = VK_SUCCESS;
     }
     return result;
 }
 
 VkDescriptorPool ResourceTracker::get_real_descriptor_pool(VkDescriptorPool pool) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = descriptor_pools_.find(handle_key(pool));
-    if (it == descriptor_pools_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkDescriptorPool>(descriptor_pools_.translate(handle_key(pool)));
 }
 
 VkResult ResourceTracker::allocate_descriptor_sets(
@@ -996,12 +1175,38 @@ VkResult ResourceTracker::allocate_descriptor_sets(
     VkDescriptorPool pool_handle = VK_NULL_HANDLE;
     VkDevice pool_real_device = VK_NULL_HANDLE;
 
+    std::vector<VkDescriptorSet> client_sets(info.descriptorSetCount, VK_NULL_HANDLE);
+    bool has_client_sets = false;
+    if (out_sets->size() == info.descriptorSetCount) {
+        for (uint32_t i = 0; i < info.descriptorSetCount; ++i) {
+            if (is_client_handle(handle_key((*out_sets)[i]), client_handle_tag::kDescriptorSet)) {
+                client_sets[i] = (*out_sets)[i];
+                has_client_sets = true;
+            }
+        }
+    }
+
     {
         std::lock_guard<std::mutex> lock(mutex_);
         auto pool_it = descriptor_pools_.find(handle_key(info.descriptorPool));
         if (pool_it == descriptor_pools_.end()) {
             return VK_ERROR_INITIALIZATION_FAILED;
         }
+        if (pool_it->second.client_allocation_error != VK_SUCCESS) {
+            // Reported once the client waits for an answer.
+            const VkResult error = pool_it->second.client_allocation_error;
+            if (!has_client_sets) {
+                pool_it->second.client_allocation_error = VK_SUCCESS;
+            }
+            return error;
+        }
+        for (VkDescriptorSet client_set : client_sets) {
+            if (client_set != VK_NULL_HANDLE && client_descriptor_sets_.contains(handle_key(client_set))) {
+                RESOURCE_LOG_ERROR() << "Client descriptor set handle " << client_set << " already in use";
+                pool_it->second.client_allocation_error = VK_ERROR_INITIALIZATION_FAILED;
+                return VK_ERROR_INITIALIZATION_FAILED;
+            }
+        }
         pool_handle = pool_it->second.real_handle;
         pool_real_device = pool_it->second.real_device;
         for (uint32_t i = 0; i < info.descriptorSetCount; ++i) {
@@ -1019,6 +1224,13 @@ VkResult ResourceTracker::allocate_descriptor_sets(
     std::vector<VkDescriptorSet> real_sets(info.descriptorSetCount);
     VkResult result = vkAllocateDescriptorSets(pool_real_device, &real_info, real_sets.data());
     if (result != VK_SUCCESS) {
+        if (has_client_sets) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto pool_it = descriptor_pools_.find(handle_key(info.descriptorPool));
+            if (pool_it != descriptor_pools_.end()) {
+                pool_it->second.client_allocation_error = result;
+            }
+        }
         return result;
     }
 
@@ -1030,17 +1242,20 @@ VkResult ResourceTracker::allocate_descriptor_sets(
             return VK_ERROR_INITIALIZATION_FAILED;
         }
         for (uint32_t i = 0; i < info.descriptorSetCount; ++i) {
-            VkDescriptorSet handle =
-                reinterpret_cast<VkDescriptorSet>(next_descriptor_set_handle_++);
             DescriptorSetResource resource = {};
             resource.handle_device = device;
             resource.real_device = real_device;
-            resource.handle = handle;
             resource.real_handle = real_sets[i];
             resource.pool = info.descriptorPool;
             resource.layout = info.pSetLayouts[i];
-            descriptor_sets_[handle_key(handle)] = resource;
+            resource.client_handle = client_sets[i];
+            VkDescriptorSet handle =
+                reinterpret_cast<VkDescriptorSet>(descriptor_sets_.insert(resource, handle_key(real_sets[i])));
             pool_it->second.descriptor_sets.push_back(handle);
+            if (client_sets[i] != VK_NULL_HANDLE &&
+                client_descriptor_sets_.insert(handle_key(client_sets[i]), handle_key(handle))) {
+                handle = client_sets[i];
+            }
             (*out_sets)[i] = handle;
         }
     }
@@ -1068,7 +1283,7 @@ VkResult ResourceTracker::free_descriptor_sets(
         real_pool = pool_it->second.real_handle;
         pool_real_device = pool_it->second.real_device;
         for (size_t i = 0; i < sets.size(); ++i) {
-            auto set_it = descriptor_sets_.find(handle_key(sets[i]));
+            auto set_it = descriptor_sets_.find(descriptor_set_key_locked(sets[i]));
             if (set_it == descriptor_sets_.end()) {
                 return VK_ERROR_INITIALIZATION_FAILED;
             }
@@ -1090,20 +1305,184 @@ VkResult ResourceTracker::free_descriptor_sets(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
     for (VkDescriptorSet set : sets) {
-        descriptor_sets_.erase(handle_key(set));
+        const uint64_t key = descriptor_set_key_locked(set);
+        erase_descriptor_set_locked(key);
         auto& vec = pool_it->second.descriptor_sets;
-        vec.erase(std::remove(vec.begin(), vec.end(), set), vec.end());
+        vec.erase(std::remove(vec.begin(), vec.end(), reinterpret_cast<VkDescriptorSet>(key)), vec.end());
     }
     return VK_SUCCESS;
 }
 
 VkDescriptorSet ResourceTracker::get_real_descriptor_set(VkDescriptorSet set) const {
+    uint64_t key = handle_key(set);
+    if (is_client_handle(key, client_handle_tag::kDescriptorSet)) {
+        key = client_descriptor_sets_.translate(key);
+    }
+    return reinterpret_cast<VkDescriptorSet>(descriptor_sets_.translate(key));
+}
+
+VkDescriptorUpdateTemplate ResourceTracker::create_descriptor_update_template(
+    VkDevice device,
+    VkDevice real_device,
+    const VkDescriptorUpdateTemplateCreateInfo& info) {
+
+    if (real_device == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo real_info = info;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (info.templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET) {
+            auto it = descriptor_set_layouts_.find(handle_key(info.descriptorSetLayout));
+            if (it == descriptor_set_layouts_.end()) {
+                return VK_NULL_HANDLE;
+            }
+            real_info.descriptorSetLayout = it->second.real_handle;
+        } else {
+            auto it = pipeline_layouts_.find(handle_key(info.pipelineLayout));
+            if (it == pipeline_layouts_.end()) {
+                return VK_NULL_HANDLE;
+            }
+            real_info.pipelineLayout = it->second.real_handle;
+        }
+    }
+
+    DescriptorUpdateTemplateResource resource = {};
+    resource.entries.assign(info.pDescriptorUpdateEntries,
+                            info.pDescriptorUpdateEntries + info.descriptorUpdateEntryCount);
+    for (const VkDescriptorUpdateTemplateEntry& entry : resource.entries) {
+        size_t end = entry.offset;
+        if (entry.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+            end += entry.descriptorCount;
+        } else if (entry.descriptorCount > 0) {
+            size_t element_size = sizeof(VkBufferView);
+            if (entry.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+                entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) {
+                element_size = sizeof(VkDescriptorBufferInfo);
+            } else if (entry.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER &&
+                       entry.descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER) {
+                element_size = sizeof(VkDescriptorImageInfo);
+            }
+            end += static_cast<size_t>(entry.descriptorCount - 1) * entry.stride + element_size;
+        }
+        resource.data_size = std::max(resource.data_size, end);
+    }
+
+    VkDescriptorUpdateTemplate real_template = VK_NULL_HANDLE;
+    VkResult result = vkCreateDescriptorUpdateTemplate(real_device, &real_info, nullptr, &real_template);
+    if (result != VK_SUCCESS) {
+        RESOURCE_LOG_ERROR() << "vkCreateDescriptorUpdateTemplate failed: " << result;
+        return VK_NULL_HANDLE;
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = descriptor_sets_.find(handle_key(set));
+    resource.handle_device = device;
+    resource.real_device = real_device;
+    resource.real_handle = real_template;
+    return reinterpret_cast<VkDescriptorUpdateTemplate>(
+        descriptor_update_templates_.insert(std::move(resource), handle_key(real_template)));
+}
+
+bool ResourceTracker::destroy_descriptor_update_template(VkDescriptorUpdateTemplate update_template) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_update_templates_.find(handle_key(update_template));
+    if (it == descriptor_update_templates_.end()) {
+        return false;
+    }
+    vkDestroyDescriptorUpdateTemplate(it->second.real_device, it->second.real_handle, nullptr);
+    descriptor_update_templates_.erase(it);
+    return true;
+}
+
+bool ResourceTracker::translate_descriptor_update_data(VkDescriptorUpdateTemplate update_template,
+                                                       void* data,
+                                                       size_t size,
+                                                       VkDevice* real_device,
+                                                       VkDescriptorUpdateTemplate* real_template) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = descriptor_update_templates_.find(handle_key(update_template));
+    if (it == descriptor_update_templates_.end() || size < it->second.data_size) {
+        return false;
+    }
+    // Null handles stay null (nullDescriptor, immutable samplers, the unused
+    // half of a sampler or image descriptor).
+    auto known = [](uint64_t handle, uint64_t real) { return handle == 0 || real != 0; };
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    for (const VkDescriptorUpdateTemplateEntry& entry : it->second.entries) {
+        if (entry.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) {
+            continue;
+        }
+        for (uint32_t i = 0; i < entry.descriptorCount; ++i) {
+            uint8_t* element = bytes + entry.offset + static_cast<size_t>(i) * entry.stride;
+            switch (entry.descriptorType) {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC: {
+                VkDescriptorBufferInfo info;
+                std::memcpy(&info, element, sizeof(info));
+                VkBuffer real = info.buffer != VK_NULL_HANDLE ? get_real_buffer(info.buffer) : VK_NULL_HANDLE;
+                if (!known(handle_key(info.buffer), handle_key(real))) {
+                    return false;
+                }
+                info.buffer = real;
+                std::memcpy(element, &info, sizeof(info));
+                break;
+            }
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: {
+                VkBufferView view;
+                std::memcpy(&view, element, sizeof(view));
+                VkBufferView real = view != VK_NULL_HANDLE ? get_real_buffer_view(view) : VK_NULL_HANDLE;
+                if (!known(handle_key(view), handle_key(real))) {
+                    return false;
+                }
+                std::memcpy(element, &real, sizeof(real));
+                break;
+            }
+            default: {
+                VkDescriptorImageInfo info;
+                std::memcpy(&info, element, sizeof(info));
+                VkSampler sampler = info.sampler != VK_NULL_HANDLE ? get_real_sampler(info.sampler) : VK_NULL_HANDLE;
+                VkImageView view =
+                    info.imageView != VK_NULL_HANDLE ? get_real_image_view(info.imageView) : VK_NULL_HANDLE;
+                if (!known(handle_key(info.sampler), handle_key(sampler)) ||
+                    !known(handle_key(info.imageView), handle_key(view))) {
+                    return false;
+                }
+                info.sampler = sampler;
+                info.imageView = view;
+                std::memcpy(element, &info, sizeof(info));
+                break;
+            }
+            }
+        }
+    }
+    *real_device = it->second.real_device;
+    *real_template = it->second.real_handle;
+    return true;
+}
+
+uint64_t ResourceTracker::descriptor_set_key_locked(VkDescriptorSet set) const {
+    const uint64_t key = handle_key(set);
+    if (!is_client_handle(key, client_handle_tag::kDescriptorSet)) {
+        return key;
+    }
+    return client_descriptor_sets_.translate(key);
+}
+
+void ResourceTracker::erase_descriptor_set_locked(uint64_t key) {
+    auto it = descriptor_sets_.find(key);
     if (it == descriptor_sets_.end()) {
-        return VK_NULL_HANDLE;
+        return;
     }
-    return it->second.real_handle;
+    if (it->second.client_handle != VK_NULL_HANDLE) {
+        client_descriptor_sets_.erase(handle_key(it->second.client_handle));
+    }
+    descriptor_sets_.erase(it);
 }
 
 VkPipelineLayout ResourceTracker::create_pipeline_layout(
@@ -1137,37 +1516,136 @@ VkPipelineLayout ResourceTracker::create_pipeline_layout(
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkPipelineLayout handle =
-        reinterpret_cast<VkPipelineLayout>(next_pipeline_layout_handle_++);
     PipelineLayoutResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_layout;
-    pipeline_layouts_[handle_key(handle)] = resource;
+    VkPipelineLayout handle =
+        reinterpret_cast<VkPipelineLayout>(pipeline_layouts_.insert(resource, handle_key(real_layout)));
     return handle;
 }
 
 bool ResourceTracker::destroy_pipeline_layout(VkPipelineLayout layout) {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (!pipeline_layouts_.contains(handle_key(layout))) {
+        return false;
+    }
+    destroy_after_compiles_locked([this, layout] { destroy_pipeline_layout_locked(layout); });
+    return true;
+}
+
+void ResourceTracker::destroy_pipeline_layout_locked(VkPipelineLayout layout) {
     auto it = pipeline_layouts_.find(handle_key(layout));
     if (it == pipeline_layouts_.end()) {
-        return false;
+        return;
     }
     if (it->second.real_handle != VK_NULL_HANDLE) {
         vkDestroyPipelineLayout(it->second.real_device, it->second.real_handle, nullptr);
     }
     pipeline_layouts_.erase(it);
-    return true;
 }
 
 VkPipelineLayout ResourceTracker::get_real_pipeline_layout(VkPipelineLayout layout) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = pipeline_layouts_.find(handle_key(layout));
-    if (it == pipeline_layouts_.end()) {
-        return VK_NULL_HANDLE;
+    return reinterpret_cast<VkPipelineLayout>(pipeline_layouts_.translate(handle_key(layout)));
+}
+
+bool ResourceTracker::real_pipeline_locked(std::unique_lock<std::mutex>& lock,
+                                           VkPipeline pipeline,
+                                           VkPipeline* real_pipeline) const {
+    auto it = pipelines_.find(handle_key(pipeline));
+    while (it != pipelines_.end() && it->second.compiling) {
+        compile_cv_.wait(lock);
+        it = pipelines_.find(handle_key(pipeline));
+    }
+    if (it == pipelines_.end()) {
+        return false;
+    }
+    *real_pipeline = it->second.real_handle;
+    return true;
+}
+
+bool ResourceTracker::translate_compute_infos_locked(std::unique_lock<std::mutex>& lock,
+                                                     uint32_t count,
+                                                     const VkComputePipelineCreateInfo* infos,
+                                                     std::vector<VkComputePipelineCreateInfo>* real_infos) const {
+    real_infos->resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        // The base goes first: waiting for it drops the lock.
+        VkPipeline base = VK_NULL_HANDLE;
+        if (infos[i].basePipelineHandle != VK_NULL_HANDLE &&
+            !real_pipeline_locked(lock, infos[i].basePipelineHandle, &base)) {
+            return false;
+        }
+
+        VkComputePipelineCreateInfo& real_info = (*real_infos)[i];
+        real_info = infos[i];
+        real_info.basePipelineHandle = base;
+        auto module_it = shader_modules_.find(handle_key(infos[i].stage.module));
+        if (module_it == shader_modules_.end()) {
+            return false;
+        }
+        real_info.stage.module = module_it->second.real_handle;
+
+        auto layout_it = pipeline_layouts_.find(handle_key(infos[i].layout));
+        if (layout_it == pipeline_layouts_.end()) {
+            return false;
+        }
+        real_info.layout = layout_it->second.real_handle;
     }
-    return it->second.real_handle;
+    return true;
+}
+
+bool ResourceTracker::translate_graphics_infos_locked(
+    std::unique_lock<std::mutex>& lock,
+    uint32_t count,
+    const VkGraphicsPipelineCreateInfo* infos,
+    std::vector<VkGraphicsPipelineCreateInfo>* real_infos,
+    std::vector<std::vector<VkPipelineShaderStageCreateInfo>>* stage_infos) const {
+    real_infos->resize(count);
+    stage_infos->resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        // The base goes first: waiting for it drops the lock.
+        VkPipeline base = VK_NULL_HANDLE;
+        if (infos[i].basePipelineHandle != VK_NULL_HANDLE &&
+            !real_pipeline_locked(lock, infos[i].basePipelineHandle, &base)) {
+            return false;
+        }
+
+        VkGraphicsPipelineCreateInfo& real_info = (*real_infos)[i];
+        real_info = infos[i];
+        real_info.basePipelineHandle = base;
+
+        std::vector<VkPipelineShaderStageCreateInfo>& stages = (*stage_infos)[i];
+        stages.resize(infos[i].stageCount);
+        for (uint32_t j = 0; j < infos[i].stageCount; ++j) {
+            stages[j] = infos[i].pStages[j];
+            auto module_it = shader_modules_.find(handle_key(infos[i].pStages[j].module));
+            if (module_it == shader_modules_.end()) {
+                return false;
+            }
+            stages[j].module = module_it->second.real_handle;
+        }
+        if (!stages.empty()) {
+            real_info.pStages = stages.data();
+        }
+
+        if (infos[i].layout != VK_NULL_HANDLE) {
+            auto layout_it = pipeline_layouts_.find(handle_key(infos[i].layout));
+            if (layout_it == pipeline_layouts_.end()) {
+                return false;
+            }
+            real_info.layout = layout_it->second.real_handle;
+        }
+
+        if (infos[i].renderPass != VK_NULL_HANDLE) {
+            auto rp_it = render_passes_.find(handle_key(infos[i].renderPass));
+            if (rp_it == render_passes_.end()) {
+                return false;
+            }
+            real_info.renderPass = rp_it->second.real_handle;
+        }
+    }
+    return true;
 }
 
 VkResult ResourceTracker::create_compute_pipelines(
@@ -1182,30 +1660,11 @@ VkResult ResourceTracker::create_compute_pipelines(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    std::vector<VkComputePipelineCreateInfo> real_infos(count);
+    std::vector<VkComputePipelineCreateInfo> real_infos;
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (uint32_t i = 0; i < count; ++i) {
-            real_infos[i] = infos[i];
-            auto module_it = shader_modules_.find(handle_key(infos[i].stage.module));
-            if (module_it == shader_modules_.end()) {
-                return VK_ERROR_INITIALIZATION_FAILED;
-            }
-            real_infos[i].stage.module = module_it->second.real_handle;
-
-            auto layout_it = pipeline_layouts_.find(handle_key(infos[i].layout));
-            if (layout_it == pipeline_layouts_.end()) {
-                return VK_ERROR_INITIALIZATION_FAILED;
-            }
-            real_infos[i].layout = layout_it->second.real_handle;
-
-            if (infos[i].basePipelineHandle != VK_NULL_HANDLE) {
-                auto base_it = pipelines_.find(handle_key(infos[i].basePipelineHandle));
-                if (base_it == pipelines_.end()) {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
-                real_infos[i].basePipelineHandle = base_it->second.real_handle;
-            }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!translate_compute_infos_locked(lock, count, infos, &real_infos)) {
+            return VK_ERROR_INITIALIZATION_FAILED;
         }
     }
 
@@ -1228,14 +1687,13 @@ VkResult ResourceTracker::create_compute_pipelines(
     std::lock_guard<std::mutex> lock(mutex_);
     out_pipelines->resize(count);
     for (uint32_t i = 0; i < count; ++i) {
-        VkPipeline handle = reinterpret_cast<VkPipeline>(next_pipeline_handle_++);
         PipelineResource resource = {};
         resource.handle_device = device;
         resource.real_device = real_device;
-        resource.handle = handle;
         resource.real_handle = real_handles[i];
         resource.bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
-        pipelines_[handle_key(handle)] = resource;
+        VkPipeline handle =
+            reinterpret_cast<VkPipeline>(pipelines_.insert(resource, handle_key(real_handles[i])));
         (*out_pipelines)[i] = handle;
     }
     return VK_SUCCESS;
@@ -1253,50 +1711,12 @@ VkResult ResourceTracker::create_graphics_pipelines(
         return VK_ERROR_INITIALIZATION_FAILED;
     }
 
-    std::vector<VkGraphicsPipelineCreateInfo> real_infos(count);
-    std::vector<std::vector<VkPipelineShaderStageCreateInfo>> stage_infos(count);
-
+    std::vector<VkGraphicsPipelineCreateInfo> real_infos;
+    std::vector<std::vector<VkPipelineShaderStageCreateInfo>> stage_infos;
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        for (uint32_t i = 0; i < count; ++i) {
-            real_infos[i] = infos[i];
-
-            stage_infos[i].resize(infos[i].stageCount);
-            for (uint32_t j = 0; j < infos[i].stageCount; ++j) {
-                stage_infos[i][j] = infos[i].pStages[j];
-                auto module_it = shader_modules_.find(handle_key(infos[i].pStages[j].module));
-                if (module_it == shader_modules_.end()) {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
-                stage_infos[i][j].module = module_it->second.real_handle;
-            }
-            if (!stage_infos[i].empty()) {
-                real_infos[i].pStages = stage_infos[i].data();
-            }
-
-            if (infos[i].layout != VK_NULL_HANDLE) {
-                auto layout_it = pipeline_layouts_.find(handle_key(infos[i].layout));
-                if (layout_it == pipeline_layouts_.end()) {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
-                real_infos[i].layout = layout_it->second.real_handle;
-            }
-
-            if (infos[i].renderPass != VK_NULL_HANDLE) {
-                auto rp_it = render_passes_.find(handle_key(infos[i].renderPass));
-                if (rp_it == render_passes_.end()) {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
-                real_infos[i].renderPass = rp_it->second.real_handle;
-            }
-
-            if (infos[i].basePipelineHandle != VK_NULL_HANDLE) {
-                auto base_it = pipelines_.find(handle_key(infos[i].basePipelineHandle));
-                if (base_it == pipelines_.end()) {
-                    return VK_ERROR_INITIALIZATION_FAILED;
-                }
-                real_infos[i].basePipelineHandle = base_it->second.real_handle;
-            }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!translate_graphics_infos_locked(lock, count, infos, &real_infos, &stage_infos)) {
+            return VK_ERROR_INITIALIZATION_FAILED;
         }
     }
 
@@ -1319,39 +1739,205 @@ VkResult ResourceTracker::create_graphics_pipelines(
     std::lock_guard<std::mutex> lock(mutex_);
     out_pipelines->resize(count);
     for (uint32_t i = 0; i < count; ++i) {
-        VkPipeline handle = reinterpret_cast<VkPipeline>(next_pipeline_handle_++);
         PipelineResource resource = {};
         resource.handle_device = device;
         resource.real_device = real_device;
-        resource.handle = handle;
         resource.real_handle = real_handles[i];
         resource.bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        pipelines_[handle_key(handle)] = resource;
+        VkPipeline handle =
+            reinterpret_cast<VkPipeline>(pipelines_.insert(resource, handle_key(real_handles[i])));
         (*out_pipelines)[i] = handle;
     }
     return VK_SUCCESS;
 }
 
+void ResourceTracker::reserve_pipelines(VkDevice device,
+                                        VkDevice real_device,
+                                        VkPipelineBindPoint bind_point,
+                                        uint32_t count,
+                                        VkPipeline* out_pipelines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < count; ++i) {
+        PipelineResource resource = {};
+        resource.handle_device = device;
+        resource.real_device = real_device;
+        resource.real_handle = VK_NULL_HANDLE;
+        resource.bind_point = bind_point;
+        resource.compiling = true;
+        out_pipelines[i] = reinterpret_cast<VkPipeline>(pipelines_.insert(resource));
+    }
+    pending_compiles_.fetch_add(count, std::memory_order_acq_rel);
+}
+
+VkDevice ResourceTracker::reserved_pipelines_device(uint32_t count, const VkPipeline* pipelines) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count == 0) {
+        return VK_NULL_HANDLE;
+    }
+    auto it = pipelines_.find(handle_key(pipelines[0]));
+    return it != pipelines_.end() ? it->second.real_device : VK_NULL_HANDLE;
+}
+
+void ResourceTracker::compile_compute_pipelines(VkPipelineCache cache,
+                                                uint32_t count,
+                                                const VkComputePipelineCreateInfo* infos,
+                                                const VkPipeline* pipelines) {
+    const VkDevice real_device = reserved_pipelines_device(count, pipelines);
+    std::vector<VkComputePipelineCreateInfo> real_infos;
+    bool translated = false;
+    if (real_device != VK_NULL_HANDLE && infos) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        translated = translate_compute_infos_locked(lock, count, infos, &real_infos);
+    }
+
+    std::vector<VkPipeline> real_handles(count, VK_NULL_HANDLE);
+    if (translated) {
+        VkResult result = vkCreateComputePipelines(real_device,
+                                                   cache,
+                                                   count,
+                                                   real_infos.data(),
+                                                   nullptr,
+                                                   real_handles.data());
+        if (result != VK_SUCCESS) {
+            RESOURCE_LOG_ERROR() << "Deferred vkCreateComputePipelines failed: " << result;
+        }
+    } else {
+        RESOURCE_LOG_ERROR() << "Deferred compute pipeline references unknown objects";
+    }
+    finish_pipeline_compiles(count, pipelines, real_handles.data());
+}
+
+void ResourceTracker::compile_graphics_pipelines(VkPipelineCache cache,
+                                                 uint32_t count,
+                                                 const VkGraphicsPipelineCreateInfo* infos,
+                                                 const VkPipeline* pipelines) {
+    const VkDevice real_device = reserved_pipelines_device(count, pipelines);
+    std::vector<VkGraphicsPipelineCreateInfo> real_infos;
+    std::vector<std::vector<VkPipelineShaderStageCreateInfo>> stage_infos;
+    bool translated = false;
+    if (real_device != VK_NULL_HANDLE && infos) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        translated = translate_graphics_infos_locked(lock, count, infos, &real_infos, &stage_infos);
+    }
+
+    std::vector<VkPipeline> real_handles(count, VK_NULL_HANDLE);
+    if (translated) {
+        VkResult result = vkCreateGraphicsPipelines(real_device,
+                                                    cache,
+                                                    count,
+                                                    real_infos.data(),
+                                                    nullptr,
+                                                    real_handles.data());
+        if (result != VK_SUCCESS) {
+            RESOURCE_LOG_ERROR() << "Deferred vkCreateGraphicsPipelines failed: " << result;
+        }
+    } else {
+        RESOURCE_LOG_ERROR() << "Deferred graphics pipeline references unknown objects";
+    }
+    finish_pipeline_compiles(count, pipelines, real_handles.data());
+}
+
+void ResourceTracker::finish_pipeline_compiles(uint32_t count,
+                                               const VkPipeline* pipelines,
+                                               const VkPipeline* real_pipelines) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t finished = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        auto it = pipelines_.find(handle_key(pipelines[i]));
+        if (it == pipelines_.end() || !it->second.compiling) {
+            continue;
+        }
+        it->second.real_handle = real_pipelines[i];
+        it->second.compiling = false;
+        pipelines_.set_translation(handle_key(pipelines[i]), handle_key(real_pipelines[i]));
+        ++finished;
+    }
+    if (pending_compiles_.fetch_sub(finished, std::memory_order_acq_rel) == finished) {
+        std::vector<std::function<void()>> destroys;
+        destroys.swap(deferred_destroys_);
+        for (auto& destroy : destroys) {
+            destroy();
+        }
+    }
+    compile_cv_.notify_all();
+}
+
+void ResourceTracker::wait_for_pipeline_compiles() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    compile_cv_.wait(lock, [this] { return pending_compiles_.load(std::memory_order_acquire) == 0; });
+}
+
+bool ResourceTracker::compute_infos_resolvable(uint32_t count, const VkComputePipelineCreateInfo* infos) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < count; ++i) {
+        if ((infos[i].basePipelineHandle != VK_NULL_HANDLE &&
+             !pipelines_.contains(handle_key(infos[i].basePipelineHandle))) ||
+            !shader_modules_.contains(handle_key(infos[i].stage.module)) ||
+            !pipeline_layouts_.contains(handle_key(infos[i].layout))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ResourceTracker::graphics_infos_resolvable(uint32_t count, const VkGraphicsPipelineCreateInfo* infos) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (infos[i].basePipelineHandle != VK_NULL_HANDLE &&
+            !pipelines_.contains(handle_key(infos[i].basePipelineHandle))) {
+            return false;
+        }
+        for (uint32_t j = 0; j < infos[i].stageCount; ++j) {
+            if (!shader_modules_.contains(handle_key(infos[i].pStages[j].module))) {
+                return false;
+            }
+        }
+        if ((infos[i].layout != VK_NULL_HANDLE && !pipeline_layouts_.contains(handle_key(infos[i].layout))) ||
+            (infos[i].renderPass != VK_NULL_HANDLE && !render_passes_.contains(handle_key(infos[i].renderPass)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ResourceTracker::destroy_after_compiles_locked(std::function<void()> destroy) {
+    if (pending_compiles_.load(std::memory_order_acquire) != 0) {
+        deferred_destroys_.push_back(std::move(destroy));
+        return;
+    }
+    destroy();
+}
+
 bool ResourceTracker::destroy_pipeline(VkPipeline pipeline) {
     std::lock_guard<std::mutex> lock(mutex_);
+    if (!pipelines_.contains(handle_key(pipeline))) {
+        return false;
+    }
+    destroy_after_compiles_locked([this, pipeline] { destroy_pipeline_locked(pipeline); });
+    return true;
+}
+
+void ResourceTracker::destroy_pipeline_locked(VkPipeline pipeline) {
     auto it = pipelines_.find(handle_key(pipeline));
     if (it == pipelines_.end()) {
-        return false;
+        return;
     }
     if (it->second.real_handle != VK_NULL_HANDLE) {
         vkDestroyPipeline(it->second.real_device, it->second.real_handle, nullptr);
     }
     pipelines_.erase(it);
-    return true;
 }
 
 VkPipeline ResourceTracker::get_real_pipeline(VkPipeline pipeline) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = pipelines_.find(handle_key(pipeline));
-    if (it == pipelines_.end()) {
-        return VK_NULL_HANDLE;
+    VkPipeline real_pipeline = reinterpret_cast<VkPipeline>(pipelines_.translate(handle_key(pipeline)));
+    if (real_pipeline != VK_NULL_HANDLE || pending_compiles_.load(std::memory_order_acquire) == 0) {
+        return real_pipeline;
     }
-    return it->second.real_handle;
+    // Possibly still compiling.
+    std::unique_lock<std::mutex> lock(mutex_);
+    real_pipeline = VK_NULL_HANDLE;
+    real_pipeline_locked(lock, pipeline, &real_pipeline);
+    return real_pipeline;
 }
 
 VkPipelineCache ResourceTracker::create_pipeline_cache(VkDevice device,
@@ -1367,13 +1953,14 @@ VkPipelineCache ResourceTracker::create_pipeline_cache(VkDevice device,
         return VK_NULL_HANDLE;
     }
     std::lock_guard<std::mutex> lock(mutex_);
-    VkPipelineCache handle = reinterpret_cast<VkPipelineCache>(next_pipeline_cache_handle_++);
     PipelineCacheResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_cache;
-    pipeline_caches_[handle_key(handle)] = resource;
+    resource.externally_synchronized =
+        (info->flags & VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT) != 0;
+    VkPipelineCache handle =
+        reinterpret_cast<VkPipelineCache>(pipeline_caches_.insert(resource, handle_key(real_cache)));
     return handle;
 }
 
@@ -1391,12 +1978,13 @@ bool ResourceTracker::destroy_pipeline_cache(VkPipelineCache cache) {
 }
 
 VkPipelineCache ResourceTracker::get_real_pipeline_cache(VkPipelineCache cache) const {
+    return reinterpret_cast<VkPipelineCache>(pipeline_caches_.translate(handle_key(cache)));
+}
+
+VkDevice ResourceTracker::get_pipeline_cache_device(VkPipelineCache cache) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = pipeline_caches_.find(handle_key(cache));
-    if (it == pipeline_caches_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return it != pipeline_caches_.end() ? it->second.handle_device : VK_NULL_HANDLE;
 }
 
 VkDevice ResourceTracker::get_pipeline_cache_real_device(VkPipelineCache cache) const {
@@ -1408,6 +1996,12 @@ VkDevice ResourceTracker::get_pipeline_cache_real_device(VkPipelineCache cache)
     return it->second.real_device;
 }
 
+bool ResourceTracker::pipeline_cache_externally_synchronized(VkPipelineCache cache) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = pipeline_caches_.find(handle_key(cache));
+    return it != pipeline_caches_.end() && it->second.externally_synchronized;
+}
+
 VkQueryPool ResourceTracker::create_query_pool(VkDevice device,
                                                VkDevice real_device,
                                                const VkQueryPoolCreateInfo* info) {
@@ -1422,16 +2016,15 @@ VkQueryPool ResourceTracker::create_query_pool(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkQueryPool handle = reinterpret_cast<VkQueryPool>(next_query_pool_handle_++);
     QueryPoolResource resource = {};
     resource.handle_device = device;
     resource.real_device = real_device;
-    resource.handle = handle;
     resource.real_handle = real_pool;
     resource.type = info->queryType;
     resource.query_count = info->queryCount;
     resource.statistics = info->pipelineStatistics;
-    query_pools_[handle_key(handle)] = resource;
+    VkQueryPool handle =
+        reinterpret_cast<VkQueryPool>(query_pools_.insert(resource, handle_key(real_pool)));
     return handle;
 }
 
@@ -1449,12 +2042,7 @@ bool ResourceTracker::destroy_query_pool(VkQueryPool pool) {
 }
 
 VkQueryPool ResourceTracker::get_real_query_pool(VkQueryPool pool) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = query_pools_.find(handle_key(pool));
-    if (it == query_pools_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_handle;
+    return reinterpret_cast<VkQueryPool>(query_pools_.translate(handle_key(pool)));
 }
 
 VkDevice ResourceTracker::get_query_pool_real_device(VkQueryPool pool) const {
@@ -1,7 +1,13 @@
 #ifndef VENUS_PLUS_RESOURCE_TRACKER_H
 #define VENUS_PLUS_RESOURCE_TRACKER_H
 
+#include "client_handle_table.h"
 #include "memory_requirements.h"
+#include "slot_map.h"
+#include "utils/sha256.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -14,6 +20,10 @@ class ResourceTracker {
 public:
     ResourceTracker();
 
+    // Destroys every object still tracked for |client_device|, children
+    // first. Used when a client session ends without cleaning up.
+    void remove_device(VkDevice client_device);
+
     VkBuffer create_buffer(VkDevice client_device,
                            VkDevice real_device,
                            const VkBufferCreateInfo& info);
@@ -24,16 +34,18 @@ public:
     VkImage create_image(VkDevice client_device,
                          VkDevice real_device,
                          const VkImageCreateInfo& info);
-    void register_external_image(VkDevice client_device,
-                                 VkDevice real_device,
-                                 VkImage client_handle,
-                                 VkImage real_handle,
-                                 const VkImageCreateInfo& info);
+    // Tracks an image the server created itself (swapchain images) and
+    // returns the handle to give the client for it.
+    VkImage register_external_image(VkDevice client_device,
+                                    VkDevice real_device,
+                                    VkImage real_handle,
+                                    const VkImageCreateInfo& info);
     void unregister_external_image(VkImage image);
     bool destroy_image(VkImage image);
     bool get_image_requirements(VkImage image, VkMemoryRequirements* requirements);
     bool get_image_subresource_layout(VkImage image, const VkImageSubresource& subresource, VkSubresourceLayout* layout) const;
     VkImage get_real_image(VkImage image) const;
+    bool get_image_format(VkImage image, VkFormat* format) const;
     VkImageView create_image_view(VkDevice client_device,
                                   VkDevice real_device,
                                   const VkImageViewCreateInfo& info,
@@ -87,10 +99,19 @@ public:
     bool buffer_exists(VkBuffer buffer) const;
     bool image_exists(VkImage image) const;
     VkResult get_memory_mapping(VkDeviceMemory memory, void** mapped_ptr, VkDeviceSize* size);
-
+    // A real buffer spanning the whole allocation, for copying into and out
+    // of memory the host cannot map: the buffer the memory is dedicated to,
+    // or one created on first use and destroyed with the memory. Memory
+    // dedicated to an image, or to a buffer without transfer usage, has none.
+    VkResult get_memory_transfer_buffer(VkDeviceMemory memory, VkBuffer* buffer);
+
+    // With |code_hash| (the SHA-256 of info.pCode), modules of the same code
+    // on the same real device share one real VkShaderModule, destroyed with
+    // the last handle that uses it.
     VkShaderModule create_shader_module(VkDevice device,
                                         VkDevice real_device,
-                                        const VkShaderModuleCreateInfo& info);
+                                        const VkShaderModuleCreateInfo& info,
+                                        const Sha256Digest* code_hash = nullptr);
     bool destroy_shader_module(VkShaderModule module);
     VkShaderModule get_real_shader_module(VkShaderModule module) const;
 
@@ -107,14 +128,34 @@ public:
     VkResult reset_descriptor_pool(VkDescriptorPool pool, VkDescriptorPoolResetFlags flags);
     VkDescriptorPool get_real_descriptor_pool(VkDescriptorPool pool) const;
 
+    // Entries of |out_sets| that hold client-issued handles on entry (see
+    // protocol/client_handles.h) name the new sets by those handles; all
+    // other entries are overwritten with server handles. The client does not
+    // wait for such allocations, so when one fails the pool keeps the error
+    // and the next allocation from it returns that instead.
     VkResult allocate_descriptor_sets(VkDevice device,
                                       VkDevice real_device,
                                       const VkDescriptorSetAllocateInfo& info,
                                       std::vector<VkDescriptorSet>* out_sets);
     VkResult free_descriptor_sets(VkDescriptorPool pool,
                                   const std::vector<VkDescriptorSet>& sets);
+    // Lock-free, for client-issued handles too.
     VkDescriptorSet get_real_descriptor_set(VkDescriptorSet set) const;
 
+    // The template's entries are kept so update data can be translated here.
+    VkDescriptorUpdateTemplate create_descriptor_update_template(VkDevice device,
+                                                                 VkDevice real_device,
+                                                                 const VkDescriptorUpdateTemplateCreateInfo& info);
+    bool destroy_descriptor_update_template(VkDescriptorUpdateTemplate update_template);
+    // Rewrites the server handles in |data|, laid out as |update_template|
+    // describes, to real ones. False when |size| is too small for the
+    // template or an object is not tracked.
+    bool translate_descriptor_update_data(VkDescriptorUpdateTemplate update_template,
+                                          void* data,
+                                          size_t size,
+                                          VkDevice* real_device,
+                                          VkDescriptorUpdateTemplate* real_template) const;
+
     VkPipelineLayout create_pipeline_layout(VkDevice device,
                                             VkDevice real_device,
                                             const VkPipelineLayoutCreateInfo& info);
@@ -134,14 +175,45 @@ public:
                                        const VkGraphicsPipelineCreateInfo* infos,
                                        std::vector<VkPipeline>* out_pipelines);
     bool destroy_pipeline(VkPipeline pipeline);
+    // Waits for the pipeline when it is still being compiled.
     VkPipeline get_real_pipeline(VkPipeline pipeline) const;
 
+    // Asynchronous creation: reserve_pipelines() hands out handles at once and
+    // compile_*_pipelines() later creates the real pipelines behind them, from
+    // any thread. A pipeline that fails to compile keeps a null real handle.
+    // While any compile is pending, destroying shader modules, pipeline
+    // layouts, render passes and pipelines is held back, since a compile may
+    // still read them.
+    void reserve_pipelines(VkDevice device,
+                           VkDevice real_device,
+                           VkPipelineBindPoint bind_point,
+                           uint32_t count,
+                           VkPipeline* out_pipelines);
+    void compile_compute_pipelines(VkPipelineCache cache,
+                                   uint32_t count,
+                                   const VkComputePipelineCreateInfo* infos,
+                                   const VkPipeline* pipelines);
+    void compile_graphics_pipelines(VkPipelineCache cache,
+                                    uint32_t count,
+                                    const VkGraphicsPipelineCreateInfo* infos,
+                                    const VkPipeline* pipelines);
+    void wait_for_pipeline_compiles();
+    // Whether every object the create infos name is known, so that a deferred
+    // compile can only fail in the driver. Base pipelines may still be
+    // compiling.
+    bool compute_infos_resolvable(uint32_t count, const VkComputePipelineCreateInfo* infos) const;
+    bool graphics_infos_resolvable(uint32_t count, const VkGraphicsPipelineCreateInfo* infos) const;
+
     VkPipelineCache create_pipeline_cache(VkDevice device,
                                           VkDevice real_device,
                                           const VkPipelineCacheCreateInfo* info);
     bool destroy_pipeline_cache(VkPipelineCache cache);
     VkPipelineCache get_real_pipeline_cache(VkPipelineCache cache) const;
+    VkDevice get_pipeline_cache_device(VkPipelineCache cache) const;
     VkDevice get_pipeline_cache_real_device(VkPipelineCache cache) const;
+    // Created with VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT: the
+    // driver may not lock it, so only one thread at a time may use it.
+    bool pipeline_cache_externally_synchronized(VkPipelineCache cache) const;
 
     VkQueryPool create_query_pool(VkDevice device,
                                   VkDevice real_device,
@@ -156,10 +228,10 @@ private:
     struct BufferResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkBuffer handle;
         VkBuffer real_handle;
         VkDeviceSize size;
-        VkBufferUsageFlags usage;
+        VkBufferUsageFlags usage; // as the client created it
+        bool transfer_usage = false; // the real buffer can be copied to and from
         bool bound = false;
         VkDeviceMemory bound_memory = VK_NULL_HANDLE;
         VkDeviceSize bound_offset = 0;
@@ -170,7 +242,6 @@ private:
     struct ImageResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkImage handle;
         VkImage real_handle;
         VkImageType type;
         VkFormat format;
@@ -191,7 +262,6 @@ private:
     struct ImageViewResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkImageView handle;
         VkImageView real_handle;
         VkImage image;
         VkImage real_image;
@@ -200,7 +270,6 @@ private:
     struct BufferViewResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkBufferView handle;
         VkBufferView real_handle;
         VkBuffer buffer;
         VkBuffer real_buffer;
@@ -212,21 +281,18 @@ private:
     struct SamplerResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkSampler handle;
         VkSampler real_handle;
     };
 
     struct RenderPassResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkRenderPass handle;
         VkRenderPass real_handle;
     };
 
     struct FramebufferResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkFramebuffer handle;
         VkFramebuffer real_handle;
         VkRenderPass render_pass;
         std::vector<VkImageView> attachments;
@@ -247,12 +313,14 @@ private:
     struct MemoryResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkDeviceMemory handle;
         VkDeviceMemory real_handle;
         VkDeviceSize size;
         uint32_t type_index;
         void* mapped_ptr = nullptr;
         VkDeviceSize mapped_size = 0;
+        VkBuffer transfer_buffer = VK_NULL_HANDLE; // real handle
+        bool dedicated_image = false; // no buffer may be bound to it
+        VkBuffer dedicated_buffer = VK_NULL_HANDLE; // the only buffer it takes
         std::vector<BufferBinding> buffer_bindings;
         std::vector<ImageBinding> image_bindings;
     };
@@ -260,62 +328,88 @@ private:
     struct ShaderModuleResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkShaderModule handle;
         VkShaderModule real_handle;
         size_t code_size;
+        bool shared = false;
+        Sha256Digest code_hash = {};
+    };
+
+    struct SharedShaderModuleKey {
+        VkDevice real_device;
+        Sha256Digest code_hash;
+
+        bool operator==(const SharedShaderModuleKey& other) const {
+            return real_device == other.real_device && code_hash == other.code_hash;
+        }
+    };
+
+    struct SharedShaderModuleKeyHash {
+        size_t operator()(const SharedShaderModuleKey& key) const {
+            return Sha256DigestHash()(key.code_hash) ^ std::hash<VkDevice>()(key.real_device);
+        }
+    };
+
+    struct SharedShaderModule {
+        VkShaderModule real_handle;
+        uint32_t refs;
     };
 
     struct DescriptorSetLayoutResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkDescriptorSetLayout handle;
         VkDescriptorSetLayout real_handle;
     };
 
     struct DescriptorPoolResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkDescriptorPool handle;
         VkDescriptorPool real_handle;
         VkDescriptorPoolCreateFlags flags;
         std::vector<VkDescriptorSet> descriptor_sets;
+        VkResult client_allocation_error; // of an unanswered allocation, until reported
     };
 
     struct DescriptorSetResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkDescriptorSet handle;
         VkDescriptorSet real_handle;
         VkDescriptorPool pool;
         VkDescriptorSetLayout layout;
+        VkDescriptorSet client_handle; // VK_NULL_HANDLE unless client-issued
+    };
+
+    struct DescriptorUpdateTemplateResource {
+        VkDevice handle_device;
+        VkDevice real_device;
+        VkDescriptorUpdateTemplate real_handle;
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        size_t data_size; // bytes the entries reach
     };
 
     struct PipelineLayoutResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkPipelineLayout handle;
         VkPipelineLayout real_handle;
     };
 
     struct PipelineResource {
         VkDevice handle_device;
         VkDevice real_device;
-    VkPipeline handle;
-    VkPipeline real_handle;
-    VkPipelineBindPoint bind_point;
-};
+        VkPipeline real_handle;
+        VkPipelineBindPoint bind_point;
+        bool compiling = false;
+    };
 
     struct PipelineCacheResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkPipelineCache handle;
         VkPipelineCache real_handle;
+        bool externally_synchronized;
     };
 
     struct QueryPoolResource {
         VkDevice handle_device;
         VkDevice real_device;
-        VkQueryPool handle;
         VkQueryPool real_handle;
         VkQueryType type;
         uint32_t query_count;
@@ -327,6 +421,18 @@ private:
         return reinterpret_cast<uint64_t>(handle);
     }
 
+    template <typename Map, typename Destroy>
+    static void remove_device_objects_locked(Map& map, VkDevice device, Destroy destroy) {
+        for (auto it = map.begin(); it != map.end();) {
+            if (it->second.handle_device == device) {
+                destroy(it->second);
+                it = map.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
     static bool ranges_overlap(VkDeviceSize offset_a, VkDeviceSize size_a, VkDeviceSize offset_b, VkDeviceSize size_b);
 
     bool check_memory_overlap_locked(const MemoryResource& memory,
@@ -336,39 +442,63 @@ private:
 
     VkDeviceSize compute_layer_pitch_locked(const ImageResource& image) const;
 
+    void release_shader_module_locked(const ShaderModuleResource& module);
+
+    // Table key of a set named by a server or client-issued handle; 0 when
+    // unknown.
+    uint64_t descriptor_set_key_locked(VkDescriptorSet set) const;
+    void erase_descriptor_set_locked(uint64_t key);
+
+    // Real handles for create infos; false when something is not tracked.
+    // Both may drop |lock| to wait for a base pipeline still compiling.
+    bool translate_compute_infos_locked(std::unique_lock<std::mutex>& lock,
+                                        uint32_t count,
+                                        const VkComputePipelineCreateInfo* infos,
+                                        std::vector<VkComputePipelineCreateInfo>* real_infos) const;
+    bool translate_graphics_infos_locked(std::unique_lock<std::mutex>& lock,
+                                         uint32_t count,
+                                         const VkGraphicsPipelineCreateInfo* infos,
+                                         std::vector<VkGraphicsPipelineCreateInfo>* real_infos,
+                                         std::vector<std::vector<VkPipelineShaderStageCreateInfo>>* stage_infos) const;
+    bool real_pipeline_locked(std::unique_lock<std::mutex>& lock, VkPipeline pipeline, VkPipeline* real_pipeline) const;
+    VkDevice reserved_pipelines_device(uint32_t count, const VkPipeline* pipelines) const;
+    void finish_pipeline_compiles(uint32_t count, const VkPipeline* pipelines, const VkPipeline* real_pipelines);
+    // Runs |destroy| now, or once no compile is pending.
+    void destroy_after_compiles_locked(std::function<void()> destroy);
+
+    void destroy_shader_module_locked(VkShaderModule module);
+    void destroy_pipeline_layout_locked(VkPipelineLayout layout);
+    void destroy_render_pass_locked(VkRenderPass render_pass);
+    void destroy_pipeline_locked(VkPipeline pipeline);
+
+    // Guards every table below. get_real_*() and *_exists() skip it and read
+    // the tables' lock-free translation words instead.
     mutable std::mutex mutex_;
-    std::unordered_map<uint64_t, BufferResource> buffers_;
-    std::unordered_map<uint64_t, ImageResource> images_;
-    std::unordered_map<uint64_t, ImageViewResource> image_views_;
-    std::unordered_map<uint64_t, BufferViewResource> buffer_views_;
-    std::unordered_map<uint64_t, SamplerResource> samplers_;
-    std::unordered_map<uint64_t, RenderPassResource> render_passes_;
-    std::unordered_map<uint64_t, FramebufferResource> framebuffers_;
-    std::unordered_map<uint64_t, MemoryResource> memories_;
-    std::unordered_map<uint64_t, ShaderModuleResource> shader_modules_;
-    std::unordered_map<uint64_t, DescriptorSetLayoutResource> descriptor_set_layouts_;
-    std::unordered_map<uint64_t, DescriptorPoolResource> descriptor_pools_;
-    std::unordered_map<uint64_t, DescriptorSetResource> descriptor_sets_;
-    std::unordered_map<uint64_t, PipelineLayoutResource> pipeline_layouts_;
-    std::unordered_map<uint64_t, PipelineResource> pipelines_;
-    std::unordered_map<uint64_t, PipelineCacheResource> pipeline_caches_;
-    std::unordered_map<uint64_t, QueryPoolResource> query_pools_;
-    uint64_t next_buffer_handle_;
-    uint64_t next_image_handle_;
-    uint64_t next_memory_handle_;
-    uint64_t next_image_view_handle_;
-    uint64_t next_buffer_view_handle_;
-    uint64_t next_sampler_handle_;
-    uint64_t next_shader_module_handle_;
-    uint64_t next_descriptor_set_layout_handle_;
-    uint64_t next_descriptor_pool_handle_;
-    uint64_t next_descriptor_set_handle_;
-    uint64_t next_pipeline_layout_handle_;
-    uint64_t next_pipeline_handle_;
-    uint64_t next_render_pass_handle_;
-    uint64_t next_framebuffer_handle_;
-    uint64_t next_pipeline_cache_handle_;
-    uint64_t next_query_pool_handle_;
+    SlotMap<BufferResource> buffers_;
+    SlotMap<ImageResource> images_;
+    SlotMap<ImageViewResource> image_views_;
+    SlotMap<BufferViewResource> buffer_views_;
+    SlotMap<SamplerResource> samplers_;
+    SlotMap<RenderPassResource> render_passes_;
+    SlotMap<FramebufferResource> framebuffers_;
+    SlotMap<MemoryResource> memories_;
+    SlotMap<ShaderModuleResource> shader_modules_;
+    std::unordered_map<SharedShaderModuleKey, SharedShaderModule, SharedShaderModuleKeyHash> shared_shader_modules_;
+    SlotMap<DescriptorSetLayoutResource> descriptor_set_layouts_;
+    SlotMap<DescriptorPoolResource> descriptor_pools_;
+    SlotMap<DescriptorSetResource> descriptor_sets_;
+    ClientHandleTable client_descriptor_sets_; // client handle -> descriptor_sets_ key
+    SlotMap<DescriptorUpdateTemplateResource> descriptor_update_templates_;
+    SlotMap<PipelineLayoutResource> pipeline_layouts_;
+    SlotMap<PipelineResource> pipelines_;
+    SlotMap<PipelineCacheResource> pipeline_caches_;
+    SlotMap<QueryPoolResource> query_pools_;
+
+    // Reserved pipelines not yet compiled; read without |mutex_| by
+    // get_real_pipeline().
+    std::atomic<uint32_t> pending_compiles_{0};
+    mutable std::condition_variable compile_cv_;
+    std::vector<std::function<void()>> deferred_destroys_;
 };
 
 } // namespace venus_plus
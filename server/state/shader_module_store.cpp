@@ -0,0 +1,162 @@
+#include "shader_module_store.h"
+
+#include "utils/logging.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace venus_plus {
+
+void ShaderModuleStore::configure(size_t capacity_bytes, const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_bytes_ = capacity_bytes;
+    directory_ = directory;
+    if (!directory_.empty() && ::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[ShaderStore] Cannot create " << directory_ << ": "
+                                    << std::strerror(errno) << "; disk cache off";
+        directory_.clear();
+    }
+}
+
+ShaderModuleStore::Code ShaderModuleStore::find(const Sha256Digest& hash, size_t code_size) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(hash);
+        if (it != entries_.end() && it->second.code->size() * sizeof(uint32_t) == code_size) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            ++stats_.hits;
+            return it->second.code;
+        }
+        directory = directory_;
+    }
+
+    Code code = directory.empty() ? nullptr : load_file(hash, code_size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!code) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.disk_hits;
+    return insert_locked(hash, std::move(code));
+}
+
+ShaderModuleStore::Code ShaderModuleStore::insert(const Sha256Digest& hash, const void* code, size_t code_size) {
+    auto words = std::make_shared<std::vector<uint32_t>>(code_size / sizeof(uint32_t));
+    std::memcpy(words->data(), code, words->size() * sizeof(uint32_t));
+    Code stored = std::move(words);
+
+    bool write_file = false;
+    Code result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.inserts;
+        write_file = !directory_.empty();
+        result = insert_locked(hash, stored);
+    }
+    if (write_file) {
+        store_file(hash, stored);
+    }
+    return result;
+}
+
+ShaderModuleStore::Code ShaderModuleStore::insert_locked(const Sha256Digest& hash, Code code) {
+    auto it = entries_.find(hash);
+    if (it != entries_.end()) {
+        // Another session got there first.
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return it->second.code;
+    }
+    const size_t bytes = code->size() * sizeof(uint32_t);
+    if (bytes > capacity_bytes_) {
+        return code;
+    }
+    while (stats_.bytes + bytes > capacity_bytes_ && !lru_.empty()) {
+        auto victim = entries_.find(lru_.back());
+        stats_.bytes -= victim->second.code->size() * sizeof(uint32_t);
+        entries_.erase(victim);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+    lru_.push_front(hash);
+    entries_[hash] = Entry{code, lru_.begin()};
+    stats_.bytes += bytes;
+    return code;
+}
+
+std::string ShaderModuleStore::file_path(const Sha256Digest& hash) const {
+    return directory_ + "/" + sha256_hex(hash) + ".spv";
+}
+
+ShaderModuleStore::Code ShaderModuleStore::load_file(const Sha256Digest& hash, size_t code_size) const {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = file_path(hash);
+    }
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return nullptr;
+    }
+    // |code_size| comes from the client: nothing is allocated until the file
+    // is known to hold exactly that many bytes of whole words.
+    struct stat info = {};
+    if (::fstat(::fileno(file), &info) != 0 || !S_ISREG(info.st_mode) || code_size == 0 ||
+        code_size % sizeof(uint32_t) != 0 || static_cast<uint64_t>(info.st_size) != code_size) {
+        std::fclose(file);
+        return nullptr;
+    }
+    auto words = std::make_shared<std::vector<uint32_t>>(code_size / sizeof(uint32_t));
+    const size_t bytes = words->size() * sizeof(uint32_t);
+    const bool complete = std::fread(words->data(), 1, bytes, file) == bytes && std::fgetc(file) == EOF;
+    std::fclose(file);
+    if (!complete || sha256(words->data(), bytes) != hash) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[ShaderStore] Ignoring damaged " << path;
+        return nullptr;
+    }
+    return words;
+}
+
+void ShaderModuleStore::store_file(const Sha256Digest& hash, const Code& code) const {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = file_path(hash);
+    }
+    // Written under a temporary name and renamed, so a reader never sees a
+    // partial file.
+    const std::string temp_path = path + ".tmp." + std::to_string(::getpid()) + "." +
+                                  std::to_string(reinterpret_cast<uintptr_t>(code.get()));
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[ShaderStore] Cannot write " << temp_path << ": "
+                                    << std::strerror(errno);
+        return;
+    }
+    const size_t bytes = code->size() * sizeof(uint32_t);
+    const bool written = std::fwrite(code->data(), 1, bytes, file) == bytes;
+    const bool closed = std::fclose(file) == 0;
+    if (!written || !closed || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[ShaderStore] Failed to store " << path;
+        std::remove(temp_path.c_str());
+    }
+}
+
+ShaderModuleStoreStats ShaderModuleStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ShaderModuleStore::log_stats() const {
+    const ShaderModuleStoreStats snapshot = stats();
+    VP_LOG_STREAM_INFO(SERVER) << "[ShaderStore] hits=" << snapshot.hits
+                               << " disk_hits=" << snapshot.disk_hits
+                               << " misses=" << snapshot.misses
+                               << " inserts=" << snapshot.inserts
+                               << " evictions=" << snapshot.evictions
+                               << " bytes=" << snapshot.bytes;
+}
+
+} // namespace venus_plus
@@ -0,0 +1,68 @@
+#ifndef VENUS_PLUS_SERVER_SHADER_MODULE_STORE_H
+#define VENUS_PLUS_SERVER_SHADER_MODULE_STORE_H
+
+#include "utils/sha256.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+struct ShaderModuleStoreStats {
+    uint64_t hits = 0;         // found in memory
+    uint64_t disk_hits = 0;    // loaded from the cache directory
+    uint64_t misses = 0;       // the client had to send the code
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes = 0;        // SPIR-V bytes currently held in memory
+};
+
+// SPIR-V by SHA-256, shared by every client session so a shader any client
+// uploaded once is never sent again. Memory use is capped by an LRU over
+// code bytes; with a cache directory, code is also kept as <hash>.spv files
+// and survives restarts. Files are checked against their name on load.
+class ShaderModuleStore {
+public:
+    using Code = std::shared_ptr<const std::vector<uint32_t>>;
+
+    ShaderModuleStore() = default;
+
+    // |capacity_bytes| 0 keeps nothing in memory; an empty |directory| keeps
+    // nothing on disk.
+    void configure(size_t capacity_bytes, const std::string& directory);
+
+    Code find(const Sha256Digest& hash, size_t code_size);
+    // The caller has checked that |hash| is the SHA-256 of |code|.
+    Code insert(const Sha256Digest& hash, const void* code, size_t code_size);
+
+    ShaderModuleStoreStats stats() const;
+    void log_stats() const;
+
+private:
+    struct Entry {
+        Code code;
+        std::list<Sha256Digest>::iterator lru;
+    };
+
+    Code insert_locked(const Sha256Digest& hash, Code code);
+    Code load_file(const Sha256Digest& hash, size_t code_size) const;
+    void store_file(const Sha256Digest& hash, const Code& code) const;
+    std::string file_path(const Sha256Digest& hash) const;
+
+    size_t capacity_bytes_ = 0;
+    std::string directory_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Sha256Digest, Entry, Sha256DigestHash> entries_;
+    std::list<Sha256Digest> lru_; // front = most recently used
+    ShaderModuleStoreStats stats_;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SERVER_SHADER_MODULE_STORE_H
@@ -0,0 +1,336 @@
+#ifndef VENUS_PLUS_SLOT_MAP_H
+#define VENUS_PLUS_SLOT_MAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace venus_plus {
+
+// Per-table tags so handles issued by different tables never collide.
+namespace handle_tag {
+constexpr uint8_t kInstance = 0x01;
+constexpr uint8_t kPhysicalDevice = 0x02;
+constexpr uint8_t kDevice = 0x03;
+constexpr uint8_t kQueue = 0x04;
+constexpr uint8_t kBuffer = 0x10;
+constexpr uint8_t kImage = 0x11;
+constexpr uint8_t kImageView = 0x12;
+constexpr uint8_t kBufferView = 0x13;
+constexpr uint8_t kSampler = 0x14;
+constexpr uint8_t kRenderPass = 0x15;
+constexpr uint8_t kFramebuffer = 0x16;
+constexpr uint8_t kDeviceMemory = 0x17;
+constexpr uint8_t kShaderModule = 0x18;
+constexpr uint8_t kDescriptorSetLayout = 0x19;
+constexpr uint8_t kDescriptorPool = 0x1a;
+constexpr uint8_t kDescriptorSet = 0x1b;
+constexpr uint8_t kPipelineLayout = 0x1c;
+constexpr uint8_t kPipeline = 0x1d;
+constexpr uint8_t kPipelineCache = 0x1e;
+constexpr uint8_t kQueryPool = 0x1f;
+constexpr uint8_t kCommandPool = 0x20;
+constexpr uint8_t kCommandBuffer = 0x21;
+constexpr uint8_t kFence = 0x22;
+constexpr uint8_t kSemaphore = 0x23;
+constexpr uint8_t kEvent = 0x24;
+constexpr uint8_t kDescriptorUpdateTemplate = 0x25;
+} // namespace handle_tag
+
+// Table of server-issued handles. The handle itself says where its entry
+// lives:
+//
+//   [63:56] table tag   [55:32] generation   [31:0] slot index
+//
+// so a lookup is an array index plus a compare against the slot's current
+// handle instead of a hash probe. Slots sit in fixed-size pages that never
+// move. Erasing an entry bumps its slot's generation, so stale handles (and
+// handles issued by a table with another tag) miss instead of aliasing a new
+// object.
+//
+// Writers - insert(), erase(), clear(), set_flags() and anything that touches
+// an entry through find() or iteration - must be serialized by the owner,
+// normally under the owner's mutex. translate() and contains() take no lock
+// and may run concurrently with writers: each slot publishes its handle, a
+// translation word (usually the real driver handle) and an owner-defined flags
+// word as atomics, and a lookup re-checks the handle after reading them.
+template <typename Value>
+class SlotMap {
+public:
+    using key_type = uint64_t;
+    using mapped_type = Value;
+    using value_type = std::pair<uint64_t, Value>;
+
+    static constexpr uint32_t kPageBits = 8;
+    static constexpr uint32_t kPageSize = 1u << kPageBits;
+    static constexpr uint32_t kMaxGeneration = 0xffffffu;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using value_type = typename SlotMap::value_type;
+        using Map = typename std::conditional<Const, const SlotMap, SlotMap>::type;
+        using reference = typename std::conditional<Const, const value_type&, value_type&>::type;
+        using pointer = typename std::conditional<Const, const value_type*, value_type*>::type;
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(Map* map, uint32_t index) : map_(map), index_(index) {}
+        template <bool C = Const, typename = typename std::enable_if<C>::type>
+        Iterator(const Iterator<false>& other) : map_(other.map_), index_(other.index_) {}
+
+        reference operator*() const { return map_->slot(index_)->entry; }
+        pointer operator->() const { return &map_->slot(index_)->entry; }
+        Iterator& operator++() {
+            index_ = map_->next_live(index_ + 1);
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+    private:
+        friend class SlotMap;
+        friend class Iterator<!Const>;
+        Map* map_ = nullptr;
+        uint32_t index_ = kEndIndex;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    explicit SlotMap(uint8_t tag) : tag_(static_cast<uint64_t>(tag) << 56) {}
+    ~SlotMap() = default;
+
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    // Stores |value| in a free slot and returns its new handle (never 0).
+    uint64_t insert(Value value, uint64_t translation = 0, uint32_t flags = 0) {
+        uint32_t index = 0;
+        if (!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = slot_count_;
+            if ((index & (kPageSize - 1)) == 0) {
+                add_page();
+            }
+            ++slot_count_;
+        }
+        Slot* s = slot(index);
+        const uint64_t key = make_key(s->generation, index);
+        s->entry.first = key;
+        s->entry.second = std::move(value);
+        s->flags.store(flags, std::memory_order_relaxed);
+        // Release so a reader that sees the new translation also sees the
+        // earlier erase of this slot's previous handle.
+        s->translation.store(translation, std::memory_order_release);
+        s->key.store(key, std::memory_order_release);
+        ++size_;
+        return key;
+    }
+
+    iterator find(uint64_t key) { return iterator(this, live_index(key)); }
+    const_iterator find(uint64_t key) const { return const_iterator(this, live_index(key)); }
+
+    size_t erase(uint64_t key) {
+        const uint32_t index = live_index(key);
+        if (index == kEndIndex) {
+            return 0;
+        }
+        release(index);
+        return 1;
+    }
+
+    iterator erase(iterator it) {
+        const uint32_t index = it.index_;
+        release(index);
+        return iterator(this, next_live(index + 1));
+    }
+
+    iterator erase(const_iterator it) {
+        const uint32_t index = it.index_;
+        release(index);
+        return iterator(this, next_live(index + 1));
+    }
+
+    void clear() {
+        for (uint32_t i = 0; i < slot_count_; ++i) {
+            if (slot(i)->key.load(std::memory_order_relaxed) != 0) {
+                release(i);
+            }
+        }
+    }
+
+    iterator begin() { return iterator(this, next_live(0)); }
+    iterator end() { return iterator(this, kEndIndex); }
+    const_iterator begin() const { return const_iterator(this, next_live(0)); }
+    const_iterator end() const { return const_iterator(this, kEndIndex); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Replaces the translation word of a live entry. Writer side.
+    void set_translation(uint64_t key, uint64_t translation) {
+        const uint32_t index = live_index(key);
+        if (index != kEndIndex) {
+            slot(index)->translation.store(translation, std::memory_order_release);
+        }
+    }
+
+    // Replaces the flags word of a live entry. Writer side.
+    void set_flags(uint64_t key, uint32_t flags) {
+        const uint32_t index = live_index(key);
+        if (index != kEndIndex) {
+            slot(index)->flags.store(flags, std::memory_order_release);
+        }
+    }
+
+    // Lock-free lookup. Returns false when |key| is not a live handle of this
+    // table; otherwise fills the translation and flags published for it.
+    bool translate(uint64_t key, uint64_t* translation, uint32_t* flags = nullptr) const {
+        const Slot* s = find_slot(key);
+        if (!s || s->key.load(std::memory_order_acquire) != key) {
+            return false;
+        }
+        const uint64_t value = s->translation.load(std::memory_order_acquire);
+        const uint32_t bits = s->flags.load(std::memory_order_acquire);
+        // A concurrent erase (and reuse) of the slot changes its key first.
+        if (s->key.load(std::memory_order_relaxed) != key) {
+            return false;
+        }
+        if (translation) {
+            *translation = value;
+        }
+        if (flags) {
+            *flags = bits;
+        }
+        return true;
+    }
+
+    uint64_t translate(uint64_t key) const {
+        uint64_t value = 0;
+        return translate(key, &value) ? value : 0;
+    }
+
+    bool contains(uint64_t key) const { return translate(key, nullptr); }
+
+private:
+    static constexpr uint32_t kEndIndex = 0xffffffffu;
+
+    struct Slot {
+        std::atomic<uint64_t> key{0};          // live handle, 0 while free
+        std::atomic<uint64_t> translation{0};
+        std::atomic<uint32_t> flags{0};
+        uint32_t generation = 1;               // writer side only
+        value_type entry{};
+    };
+
+    struct Page {
+        Slot slots[kPageSize];
+    };
+
+    struct Directory {
+        explicit Directory(size_t count)
+            : capacity(count), pages(new std::atomic<const Page*>[count]) {
+            for (size_t i = 0; i < count; ++i) {
+                pages[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        size_t capacity;
+        std::unique_ptr<std::atomic<const Page*>[]> pages;
+    };
+
+    uint64_t make_key(uint32_t generation, uint32_t index) const {
+        return tag_ | (static_cast<uint64_t>(generation) << 32) | index;
+    }
+
+    Slot* slot(uint32_t index) { return &pages_[index >> kPageBits]->slots[index & (kPageSize - 1)]; }
+    const Slot* slot(uint32_t index) const {
+        return &pages_[index >> kPageBits]->slots[index & (kPageSize - 1)];
+    }
+
+    // Reader path: only atomics, no writer-owned containers.
+    const Slot* find_slot(uint64_t key) const {
+        if (key == 0 || (key & 0xff00000000000000ull) != tag_) {
+            return nullptr;
+        }
+        const uint32_t index = static_cast<uint32_t>(key);
+        const Directory* directory = directory_.load(std::memory_order_acquire);
+        const size_t page = index >> kPageBits;
+        if (!directory || page >= directory->capacity) {
+            return nullptr;
+        }
+        const Page* p = directory->pages[page].load(std::memory_order_acquire);
+        return p ? &p->slots[index & (kPageSize - 1)] : nullptr;
+    }
+
+    uint32_t live_index(uint64_t key) const {
+        if (key == 0 || (key & 0xff00000000000000ull) != tag_) {
+            return kEndIndex;
+        }
+        const uint32_t index = static_cast<uint32_t>(key);
+        if (index >= slot_count_ || slot(index)->key.load(std::memory_order_relaxed) != key) {
+            return kEndIndex;
+        }
+        return index;
+    }
+
+    uint32_t next_live(uint32_t index) const {
+        for (; index < slot_count_; ++index) {
+            if (slot(index)->key.load(std::memory_order_relaxed) != 0) {
+                return index;
+            }
+        }
+        return kEndIndex;
+    }
+
+    void release(uint32_t index) {
+        Slot* s = slot(index);
+        s->key.store(0, std::memory_order_release);
+        s->entry.first = 0;
+        s->entry.second = Value();
+        --size_;
+        // A slot whose generation would wrap is retired rather than reused,
+        // so a handle is never issued twice.
+        if (s->generation < kMaxGeneration) {
+            ++s->generation;
+            free_.push_back(index);
+        }
+    }
+
+    void add_page() {
+        const size_t page_index = pages_.size();
+        pages_.push_back(std::unique_ptr<Page>(new Page()));
+        Directory* directory = directory_.load(std::memory_order_relaxed);
+        if (!directory || page_index >= directory->capacity) {
+            // Old directories stay alive: readers may still hold them.
+            std::unique_ptr<Directory> grown(new Directory(directory ? directory->capacity * 2 : 4));
+            for (size_t i = 0; i < page_index; ++i) {
+                grown->pages[i].store(pages_[i].get(), std::memory_order_relaxed);
+            }
+            directory = grown.get();
+            directories_.push_back(std::move(grown));
+        }
+        directory->pages[page_index].store(pages_.back().get(), std::memory_order_release);
+        directory_.store(directory, std::memory_order_release);
+    }
+
+    const uint64_t tag_;
+    std::vector<std::unique_ptr<Page>> pages_;
+    std::vector<std::unique_ptr<Directory>> directories_;
+    std::atomic<Directory*> directory_{nullptr};
+    std::vector<uint32_t> free_;
+    uint32_t slot_count_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SLOT_MAP_H
@@ -6,9 +6,9 @@
 namespace venus_plus {
 
 SyncManager::SyncManager()
-    : next_fence_handle_(0x80000000ull),
-      next_semaphore_handle_(0x90000000ull),
-      next_event_handle_(0xa0000000ull) {}
+    : fences_(handle_tag::kFence),
+      semaphores_(handle_tag::kSemaphore),
+      events_(handle_tag::kEvent) {}
 
 VkFence SyncManager::create_fence(VkDevice device,
                                   VkDevice real_device,
@@ -20,14 +20,12 @@ VkFence SyncManager::create_fence(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkFence handle = reinterpret_cast<VkFence>(next_fence_handle_++);
     FenceEntry entry;
     entry.device = device;
     entry.real_device = real_device;
     entry.real_fence = real_fence;
     entry.signaled = (info.flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
-    fences_[handle_key(handle)] = entry;
-    return handle;
+    return reinterpret_cast<VkFence>(fences_.insert(entry, handle_key(real_fence)));
 }
 
 bool SyncManager::destroy_fence(VkFence fence) {
@@ -124,17 +122,11 @@ VkResult SyncManager::wait_for_fences(VkDevice real_device,
 }
 
 bool SyncManager::fence_exists(VkFence fence) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return fences_.find(handle_key(fence)) != fences_.end();
+    return fences_.contains(handle_key(fence));
 }
 
 VkFence SyncManager::get_real_fence(VkFence fence) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = fences_.find(handle_key(fence));
-    if (it == fences_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_fence;
+    return reinterpret_cast<VkFence>(fences_.translate(handle_key(fence)));
 }
 
 VkDevice SyncManager::get_fence_real_device(VkFence fence) const {
@@ -201,7 +193,6 @@ VkSemaphore SyncManager::create_semaphore(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkSemaphore handle = reinterpret_cast<VkSemaphore>(next_semaphore_handle_++);
     SemaphoreEntry entry;
     entry.device = device;
     entry.real_device = real_device;
@@ -209,8 +200,7 @@ VkSemaphore SyncManager::create_semaphore(VkDevice device,
     entry.type = type;
     entry.binary_signaled = false;
     entry.timeline_value = initial_value;
-    semaphores_[handle_key(handle)] = entry;
-    return handle;
+    return reinterpret_cast<VkSemaphore>(semaphores_.insert(entry, handle_key(real_semaphore)));
 }
 
 bool SyncManager::destroy_semaphore(VkSemaphore semaphore) {
@@ -227,8 +217,7 @@ bool SyncManager::destroy_semaphore(VkSemaphore semaphore) {
 }
 
 bool SyncManager::semaphore_exists(VkSemaphore semaphore) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return semaphores_.find(handle_key(semaphore)) != semaphores_.end();
+    return semaphores_.contains(handle_key(semaphore));
 }
 
 VkSemaphoreType SyncManager::get_semaphore_type(VkSemaphore semaphore) const {
@@ -241,12 +230,16 @@ VkSemaphoreType SyncManager::get_semaphore_type(VkSemaphore semaphore) const {
 }
 
 VkSemaphore SyncManager::get_real_semaphore(VkSemaphore semaphore) const {
+    return reinterpret_cast<VkSemaphore>(semaphores_.translate(handle_key(semaphore)));
+}
+
+VkDevice SyncManager::get_semaphore_real_device(VkSemaphore semaphore) const {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = semaphores_.find(handle_key(semaphore));
     if (it == semaphores_.end()) {
         return VK_NULL_HANDLE;
     }
-    return it->second.real_semaphore;
+    return it->second.real_device;
 }
 
 void SyncManager::consume_binary_semaphore(VkSemaphore semaphore) {
@@ -317,14 +310,12 @@ VkEvent SyncManager::create_event(VkDevice device,
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
-    VkEvent handle = reinterpret_cast<VkEvent>(next_event_handle_++);
     EventEntry entry;
     entry.device = device;
     entry.real_device = real_device;
     entry.real_event = real_event;
     entry.signaled = false;
-    events_[handle_key(handle)] = entry;
-    return handle;
+    return reinterpret_cast<VkEvent>(events_.insert(entry, handle_key(real_event)));
 }
 
 bool SyncManager::destroy_event(VkEvent event) {
@@ -341,12 +332,7 @@ bool SyncManager::destroy_event(VkEvent event) {
 }
 
 VkEvent SyncManager::get_real_event(VkEvent event) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = events_.find(handle_key(event));
-    if (it == events_.end()) {
-        return VK_NULL_HANDLE;
-    }
-    return it->second.real_event;
+    return reinterpret_cast<VkEvent>(events_.translate(handle_key(event)));
 }
 
 VkDevice SyncManager::get_event_real_device(VkEvent event) const {
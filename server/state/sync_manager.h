@@ -3,7 +3,8 @@
 
 #include <vulkan/vulkan.h>
 #include <mutex>
-#include <unordered_map>
+
+#include "slot_map.h"
 
 namespace venus_plus {
 
@@ -35,6 +36,7 @@ public:
     bool semaphore_exists(VkSemaphore semaphore) const;
     VkSemaphoreType get_semaphore_type(VkSemaphore semaphore) const;
     VkSemaphore get_real_semaphore(VkSemaphore semaphore) const;
+    VkDevice get_semaphore_real_device(VkSemaphore semaphore) const;
     void consume_binary_semaphore(VkSemaphore semaphore);
     void signal_binary_semaphore(VkSemaphore semaphore);
     VkResult get_timeline_value(VkSemaphore semaphore, uint64_t* out_value) const;
@@ -57,6 +59,8 @@ private:
         return reinterpret_cast<uint64_t>(handle);
     }
 
+    // Writers hold mutex_; get_real_*() and *_exists() translate through the
+    // slot maps without it.
     mutable std::mutex mutex_;
 
     struct FenceEntry {
@@ -82,12 +86,9 @@ private:
         bool signaled = false;
     };
 
-    std::unordered_map<uint64_t, FenceEntry> fences_;
-    std::unordered_map<uint64_t, SemaphoreEntry> semaphores_;
-    std::unordered_map<uint64_t, EventEntry> events_;
-    uint64_t next_fence_handle_;
-    uint64_t next_semaphore_handle_;
-    uint64_t next_event_handle_;
+    SlotMap<FenceEntry> fences_;
+    SlotMap<SemaphoreEntry> semaphores_;
+    SlotMap<EventEntry> events_;
 };
 
 } // namespace venus_plus
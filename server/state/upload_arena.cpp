@@ -0,0 +1,173 @@
+#include "upload_arena.h"
+
+#include "utils/logging.h"
+#include <algorithm>
+
+namespace venus_plus {
+
+namespace {
+
+constexpr VkDeviceSize kChunkSize = 1024 * 1024;
+constexpr VkDeviceSize kAlignment = 4;
+// Free chunks kept per device; any more are destroyed when released.
+constexpr size_t kMaxFreeChunks = 16;
+
+} // namespace
+
+UploadArena::UploadArena(const VkPhysicalDeviceMemoryProperties* memory_properties)
+    : memory_properties_(memory_properties) {}
+
+std::unique_ptr<UploadArena::Chunk> UploadArena::create_chunk(VkDevice device,
+                                                              VkDevice real_device,
+                                                              VkDeviceSize size) const {
+    auto chunk = std::make_unique<Chunk>();
+    chunk->device = device;
+    chunk->real_device = real_device;
+    chunk->size = size;
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(real_device, &buffer_info, nullptr, &chunk->buffer) != VK_SUCCESS) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[UploadArena] Failed to create staging buffer";
+        return nullptr;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(real_device, chunk->buffer, &requirements);
+    const VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t type_index = UINT32_MAX;
+    for (uint32_t i = 0; memory_properties_ && i < memory_properties_->memoryTypeCount; ++i) {
+        if ((requirements.memoryTypeBits & (1u << i)) &&
+            (memory_properties_->memoryTypes[i].propertyFlags & wanted) == wanted) {
+            type_index = i;
+            break;
+        }
+    }
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex = type_index;
+    void* mapped = nullptr;
+    if (type_index == UINT32_MAX ||
+        vkAllocateMemory(real_device, &alloc_info, nullptr, &chunk->memory) != VK_SUCCESS ||
+        vkBindBufferMemory(real_device, chunk->buffer, chunk->memory, 0) != VK_SUCCESS ||
+        vkMapMemory(real_device, chunk->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        VP_LOG_STREAM_ERROR(SERVER) << "[UploadArena] Failed to allocate " << size << " bytes of staging memory";
+        destroy_chunk(*chunk);
+        return nullptr;
+    }
+    chunk->mapped = static_cast<uint8_t*>(mapped);
+    return chunk;
+}
+
+void UploadArena::destroy_chunk(Chunk& chunk) {
+    if (chunk.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(chunk.real_device, chunk.buffer, nullptr);
+    }
+    if (chunk.memory != VK_NULL_HANDLE) {
+        // Freeing the memory unmaps it.
+        vkFreeMemory(chunk.real_device, chunk.memory, nullptr);
+    }
+    chunk.buffer = VK_NULL_HANDLE;
+    chunk.memory = VK_NULL_HANDLE;
+    chunk.mapped = nullptr;
+}
+
+bool UploadArena::allocate(VkDevice device,
+                           VkDevice real_device,
+                           VkCommandPool pool,
+                           VkCommandBuffer command_buffer,
+                           VkDeviceSize size,
+                           UploadAllocation* out) {
+    if (!out || size == 0 || real_device == VK_NULL_HANDLE) {
+        return false;
+    }
+    const VkDeviceSize aligned = (size + kAlignment - 1) & ~(kAlignment - 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Owner& owner = owners_[handle_key(command_buffer)];
+    owner.pool = pool;
+    Chunk* chunk = owner.chunks.empty() ? nullptr : owner.chunks.back().get();
+    if (!chunk || chunk->used + aligned > chunk->size) {
+        std::unique_ptr<Chunk> next;
+        auto& free_list = free_chunks_[handle_key(device)];
+        if (aligned <= kChunkSize && !free_list.empty()) {
+            next = std::move(free_list.back());
+            free_list.pop_back();
+        } else {
+            next = create_chunk(device, real_device, std::max(kChunkSize, aligned));
+        }
+        if (!next) {
+            return false;
+        }
+        next->used = 0;
+        owner.chunks.push_back(std::move(next));
+        chunk = owner.chunks.back().get();
+    }
+    out->buffer = chunk->buffer;
+    out->offset = chunk->used;
+    out->data = chunk->mapped + chunk->used;
+    chunk->used += aligned;
+    return true;
+}
+
+void UploadArena::recycle_locked(Owner& owner) {
+    for (auto& chunk : owner.chunks) {
+        auto& free_list = free_chunks_[handle_key(chunk->device)];
+        if (chunk->size == kChunkSize && free_list.size() < kMaxFreeChunks) {
+            free_list.push_back(std::move(chunk));
+        } else {
+            destroy_chunk(*chunk);
+        }
+    }
+    owner.chunks.clear();
+}
+
+void UploadArena::release(VkCommandBuffer command_buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = owners_.find(handle_key(command_buffer));
+    if (it == owners_.end()) {
+        return;
+    }
+    recycle_locked(it->second);
+    owners_.erase(it);
+}
+
+void UploadArena::release_pool(VkCommandPool pool) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = owners_.begin(); it != owners_.end();) {
+        if (it->second.pool != pool) {
+            ++it;
+            continue;
+        }
+        recycle_locked(it->second);
+        it = owners_.erase(it);
+    }
+}
+
+void UploadArena::remove_device(VkDevice device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = owners_.begin(); it != owners_.end();) {
+        auto& chunks = it->second.chunks;
+        if (chunks.empty() || chunks.front()->device != device) {
+            ++it;
+            continue;
+        }
+        for (auto& chunk : chunks) {
+            destroy_chunk(*chunk);
+        }
+        it = owners_.erase(it);
+    }
+    auto free_it = free_chunks_.find(handle_key(device));
+    if (free_it != free_chunks_.end()) {
+        for (auto& chunk : free_it->second) {
+            destroy_chunk(*chunk);
+        }
+        free_chunks_.erase(free_it);
+    }
+}
+
+} // namespace venus_plus
@@ -0,0 +1,76 @@
+#ifndef VENUS_PLUS_SERVER_UPLOAD_ARENA_H
+#define VENUS_PLUS_SERVER_UPLOAD_ARENA_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace venus_plus {
+
+// Space in a staging chunk: |data| is mapped, and the GPU reads it from
+// |buffer| at |offset|.
+struct UploadAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE; // real handle
+    VkDeviceSize offset = 0;
+    uint8_t* data = nullptr;
+};
+
+// Host-visible staging memory for data that arrives inside a command stream
+// and is copied on the GPU by the command buffer it was recorded into. Each
+// command buffer fills chunks of its own, which stay untouched until the
+// buffer is begun, reset or freed again: the points where Vulkan guarantees
+// it is no longer pending. The chunks then go back to the device's free list
+// for the next recording, so a steady frame loop cycles through a fixed set.
+class UploadArena {
+public:
+    explicit UploadArena(const VkPhysicalDeviceMemoryProperties* memory_properties);
+
+    bool allocate(VkDevice device,
+                  VkDevice real_device,
+                  VkCommandPool pool,
+                  VkCommandBuffer command_buffer,
+                  VkDeviceSize size,
+                  UploadAllocation* out);
+    void release(VkCommandBuffer command_buffer);
+    void release_pool(VkCommandPool pool);
+    // Destroys every chunk of |device|; call before the real device goes.
+    void remove_device(VkDevice device);
+
+private:
+    struct Chunk {
+        VkDevice device = VK_NULL_HANDLE;
+        VkDevice real_device = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+        VkDeviceSize size = 0;
+        VkDeviceSize used = 0;
+    };
+
+    struct Owner {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<std::unique_ptr<Chunk>> chunks; // back() is being filled
+    };
+
+    template <typename T>
+    static uint64_t handle_key(T handle) {
+        return reinterpret_cast<uint64_t>(handle);
+    }
+
+    std::unique_ptr<Chunk> create_chunk(VkDevice device, VkDevice real_device, VkDeviceSize size) const;
+    static void destroy_chunk(Chunk& chunk);
+    void recycle_locked(Owner& owner);
+
+    const VkPhysicalDeviceMemoryProperties* memory_properties_ = nullptr;
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Owner> owners_;
+    std::unordered_map<uint64_t, std::vector<std::unique_ptr<Chunk>>> free_chunks_; // by device
+};
+
+} // namespace venus_plus
+
+#endif // VENUS_PLUS_SERVER_UPLOAD_ARENA_H
@@ -116,6 +116,17 @@ void ServerSwapchainManager::destroy_swapchain(uint32_t id) {
     }
 }
 
+void ServerSwapchainManager::destroy_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : swapchains_) {
+        free_resources(entry.second);
+    }
+    if (!swapchains_.empty()) {
+        SERVER_LOG_INFO() << "[Swapchain] Destroyed " << swapchains_.size() << " leftover swapchain(s)";
+    }
+    swapchains_.clear();
+}
+
 VkResult ServerSwapchainManager::acquire_image(uint32_t id, uint32_t* image_index) {
     if (!image_index) {
         return VK_ERROR_INITIALIZATION_FAILED;
@@ -133,36 +144,197 @@ VkResult ServerSwapchainManager::acquire_image(uint32_t id, uint32_t* image_inde
 
 VkResult ServerSwapchainManager::present(uint32_t id,
                                          uint32_t image_index,
+                                         FrameCodecLevel codec_level,
                                          VenusFrameHeader* header,
                                          std::vector<uint8_t>* payload) {
     if (!header || !payload) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = swapchains_.find(id);
-    if (it == swapchains_.end()) {
-        return VK_ERROR_INITIALIZATION_FAILED;
+    VenusSwapchainPresentEntry entry = {};
+    entry.swapchain_id = id;
+    entry.image_index = image_index;
+    entry.codec_level = codec_level;
+
+    std::vector<PresentedFrame> frames;
+    VkResult result = present_batch(&entry, 1, nullptr, 0, &frames);
+    if (frames.empty()) {
+        return result;
     }
-    if (image_index >= it->second.image_count) {
+    *header = frames[0].header;
+    *payload = std::move(frames[0].payload);
+    return frames[0].result;
+}
+
+VkResult ServerSwapchainManager::present_batch(const VenusSwapchainPresentEntry* entries,
+                                               uint32_t entry_count,
+                                               const VkSemaphore* wait_semaphores,
+                                               uint32_t wait_semaphore_count,
+                                               std::vector<PresentedFrame>* frames) {
+    if (!frames || (entry_count > 0 && !entries) ||
+        (wait_semaphore_count > 0 && !wait_semaphores)) {
         return VK_ERROR_INITIALIZATION_FAILED;
     }
+    frames->clear();
+    frames->resize(entry_count);
 
-    auto& swapchain = it->second;
-    auto& image = swapchain.images[image_index];
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    if (!image.image || !image.staging_buffer) {
-        return VK_ERROR_INITIALIZATION_FAILED;
+    // Swapchains of one device share a submission, recorded into the command
+    // buffer and fence of the first swapchain seen for that device.
+    struct SubmitGroup {
+        ServerSwapchain* owner = nullptr;
+        std::vector<uint32_t> entries;
+        std::vector<VkSemaphore> wait_semaphores;
+        bool submitted = false;
+    };
+    std::vector<SubmitGroup> groups;
+    std::vector<ServerSwapchain*> targets(entry_count, nullptr);
+
+    for (uint32_t i = 0; i < entry_count; ++i) {
+        auto it = swapchains_.find(entries[i].swapchain_id);
+        if (it == swapchains_.end() || entries[i].image_index >= it->second.image_count) {
+            continue;
+        }
+        const auto& image = it->second.images[entries[i].image_index];
+        if (!image.image || !image.staging_buffer) {
+            continue;
+        }
+        targets[i] = &it->second;
+
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const SubmitGroup& g) {
+            return g.owner->device == it->second.device;
+        });
+        if (group == groups.end()) {
+            groups.push_back({});
+            group = groups.end() - 1;
+            group->owner = &it->second;
+        }
+        group->entries.push_back(i);
+    }
+
+    // The readback waits on the present semaphores instead of idling the
+    // device, so only the image's own rendering is waited for. Semaphores
+    // of a device with nothing to read back are still consumed.
+    for (uint32_t i = 0; i < wait_semaphore_count; ++i) {
+        VkSemaphore real = VK_NULL_HANDLE;
+        VkDevice device = VK_NULL_HANDLE;
+        if (state_) {
+            real = state_->sync_manager.get_real_semaphore(wait_semaphores[i]);
+            device = state_->sync_manager.get_semaphore_real_device(wait_semaphores[i]);
+        }
+        if (real == VK_NULL_HANDLE) {
+            SERVER_LOG_ERROR() << "[Swapchain] Unknown present wait semaphore";
+            continue;
+        }
+        state_->sync_manager.consume_binary_semaphore(wait_semaphores[i]);
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const SubmitGroup& g) {
+            return g.owner->device == device;
+        });
+        if (group != groups.end()) {
+            group->wait_semaphores.push_back(real);
+        } else {
+            // Any swapchain of the device has a queue the device was
+            // created with; without one there is nothing to submit on.
+            VkQueue queue = VK_NULL_HANDLE;
+            for (const auto& entry : swapchains_) {
+                if (entry.second.device == device) {
+                    queue = entry.second.queue;
+                    break;
+                }
+            }
+            VkPipelineStageFlags stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+            VkSubmitInfo wait_only = {};
+            wait_only.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            wait_only.waitSemaphoreCount = 1;
+            wait_only.pWaitSemaphores = &real;
+            wait_only.pWaitDstStageMask = &stage;
+            if (queue != VK_NULL_HANDLE) {
+                vkQueueSubmit(queue, 1, &wait_only, VK_NULL_HANDLE);
+            } else {
+                SERVER_LOG_ERROR() << "[Swapchain] No queue to consume a present wait semaphore on";
+            }
+        }
     }
 
-    vkDeviceWaitIdle(swapchain.device);
+    // The first command of each readback is a barrier whose source stage is
+    // COLOR_ATTACHMENT_OUTPUT, so the wait must cover that stage to chain
+    // with it; TRANSFER covers the copy itself.
+    const VkPipelineStageFlags kReadbackWaitStage =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
 
-    vkResetCommandPool(swapchain.device, swapchain.command_pool, 0);
+    for (auto& group : groups) {
+        ServerSwapchain& owner = *group.owner;
+
+        // Without semaphores (legacy single presents, or a present that
+        // waits on nothing) the readback has nothing to chain with, and the
+        // image may still be rendered on another queue: idle the device.
+        if (group.wait_semaphores.empty()) {
+            vkDeviceWaitIdle(owner.device);
+        }
 
-    VkCommandBufferBeginInfo begin_info = {};
-    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(swapchain.command_buffer, &begin_info);
+        vkResetCommandPool(owner.device, owner.command_pool, 0);
+
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(owner.command_buffer, &begin_info);
+        for (uint32_t index : group.entries) {
+            const ServerSwapchain& swapchain = *targets[index];
+            record_readback(owner.command_buffer,
+                            swapchain,
+                            swapchain.images[entries[index].image_index]);
+        }
+        vkEndCommandBuffer(owner.command_buffer);
+
+        std::vector<VkPipelineStageFlags> wait_stages(group.wait_semaphores.size(),
+                                                      kReadbackWaitStage);
+        VkSubmitInfo submit_info = {};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.waitSemaphoreCount = static_cast<uint32_t>(group.wait_semaphores.size());
+        submit_info.pWaitSemaphores = group.wait_semaphores.data();
+        submit_info.pWaitDstStageMask = wait_stages.data();
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &owner.command_buffer;
+
+        VkResult submit_result = vkQueueSubmit(owner.queue, 1, &submit_info, owner.copy_fence);
+        if (submit_result != VK_SUCCESS) {
+            SERVER_LOG_ERROR() << "[Swapchain] Readback submission failed: " << submit_result;
+            for (uint32_t index : group.entries) {
+                (*frames)[index].result = submit_result;
+                targets[index] = nullptr;
+            }
+            continue;
+        }
+        group.submitted = true;
+    }
 
+    for (auto& group : groups) {
+        if (!group.submitted) {
+            continue;
+        }
+        ServerSwapchain& owner = *group.owner;
+        vkWaitForFences(owner.device, 1, &owner.copy_fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(owner.device, 1, &owner.copy_fence);
+    }
+
+    VkResult batch_result = VK_SUCCESS;
+    for (uint32_t i = 0; i < entry_count; ++i) {
+        PresentedFrame& frame = (*frames)[i];
+        if (targets[i]) {
+            encode_frame(*targets[i], entries[i].image_index, entries[i].codec_level, &frame);
+            frame.result = VK_SUCCESS;
+            SERVER_LOG_INFO() << "[Swapchain] Present swapchain #" << entries[i].swapchain_id
+                              << " image " << entries[i].image_index;
+        } else if (batch_result == VK_SUCCESS) {
+            batch_result = frame.result;
+        }
+    }
+    return batch_result;
+}
+
+void ServerSwapchainManager::record_readback(VkCommandBuffer command_buffer,
+                                             const ServerSwapchain& swapchain,
+                                             const ServerSwapchain::ImageResources& image) const {
     VkImageSubresourceRange range = {};
     range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     range.baseMipLevel = 0;
@@ -181,7 +353,7 @@ VkResult ServerSwapchainManager::present(uint32_t id,
     pre_copy.image = image.image;
     pre_copy.subresourceRange = range;
 
-    vkCmdPipelineBarrier(swapchain.command_buffer,
+    vkCmdPipelineBarrier(command_buffer,
                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
                          VK_PIPELINE_STAGE_TRANSFER_BIT,
                          0,
@@ -199,7 +371,7 @@ VkResult ServerSwapchainManager::present(uint32_t id,
     region.imageSubresource.layerCount = 1;
     region.imageExtent = make_extent(swapchain.width, swapchain.height);
 
-    vkCmdCopyImageToBuffer(swapchain.command_buffer,
+    vkCmdCopyImageToBuffer(command_buffer,
                            image.image,
                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                            image.staging_buffer,
@@ -217,54 +389,50 @@ VkResult ServerSwapchainManager::present(uint32_t id,
     post_copy.image = image.image;
     post_copy.subresourceRange = range;
 
-    vkCmdPipelineBarrier(swapchain.command_buffer,
+    vkCmdPipelineBarrier(command_buffer,
                          VK_PIPELINE_STAGE_TRANSFER_BIT,
                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
                          0,
                          0, nullptr,
                          0, nullptr,
                          1, &post_copy);
+}
 
-    vkEndCommandBuffer(swapchain.command_buffer);
-
-    VkSubmitInfo submit_info = {};
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &swapchain.command_buffer;
-
-    vkQueueSubmit(swapchain.queue, 1, &submit_info, swapchain.copy_fence);
-    vkWaitForFences(swapchain.device, 1, &swapchain.copy_fence, VK_TRUE, UINT64_MAX);
-    vkResetFences(swapchain.device, 1, &swapchain.copy_fence);
-
-    std::vector<uint8_t> frame(static_cast<size_t>(image.staging_size));
-    std::memcpy(frame.data(), image.staging_ptr, static_cast<size_t>(image.staging_size));
-
-    header->magic = kVenusFrameMagic;
-    header->swapchain_id = id;
-    header->image_index = image_index;
-    header->width = swapchain.width;
-    header->height = swapchain.height;
-    header->format = static_cast<uint32_t>(swapchain.format);
-    header->stride = swapchain.width * 4u;
+void ServerSwapchainManager::encode_frame(const ServerSwapchain& swapchain,
+                                          uint32_t image_index,
+                                          FrameCodecLevel codec_level,
+                                          PresentedFrame* frame) const {
+    const auto& image = swapchain.images[image_index];
+    std::vector<uint8_t> pixels(static_cast<size_t>(image.staging_size));
+    std::memcpy(pixels.data(), image.staging_ptr, static_cast<size_t>(image.staging_size));
+
+    VenusFrameHeader& header = frame->header;
+    header.magic = kVenusFrameMagic;
+    header.swapchain_id = swapchain.id;
+    header.image_index = image_index;
+    header.width = swapchain.width;
+    header.height = swapchain.height;
+    header.format = static_cast<uint32_t>(swapchain.format);
+    header.stride = swapchain.width * 4u;
 
     FrameCompressionType compression = FrameCompressionType::NONE;
     std::vector<uint8_t> compressed;
-    compress_frame(frame, &compressed, &compression);
+    if (codec_level == FrameCodecLevel::LOSSY) {
+        quantize_frame(&pixels);
+    }
+    if (codec_level != FrameCodecLevel::RAW) {
+        compress_frame(pixels, &compressed, &compression);
+    }
 
-    const std::vector<uint8_t>* send_buffer = &frame;
+    header.uncompressed_size = static_cast<uint32_t>(pixels.size());
     if (compression != FrameCompressionType::NONE && !compressed.empty()) {
-        send_buffer = &compressed;
+        frame->payload = std::move(compressed);
     } else {
         compression = FrameCompressionType::NONE;
+        frame->payload = std::move(pixels);
     }
-
-    header->compression = compression;
-    header->payload_size = static_cast<uint32_t>(send_buffer->size());
-    header->uncompressed_size = static_cast<uint32_t>(frame.size());
-
-    payload->assign(send_buffer->begin(), send_buffer->end());
-    SERVER_LOG_INFO() << "[Swapchain] Present swapchain #" << id << " image " << image_index;
-    return VK_SUCCESS;
+    header.compression = compression;
+    header.payload_size = static_cast<uint32_t>(frame->payload.size());
 }
 
 void ServerSwapchainManager::compress_frame(const std::vector<uint8_t>& input,
@@ -311,6 +479,16 @@ void ServerSwapchainManager::compress_frame(const std::vector<uint8_t>& input,
     }
 }
 
+void ServerSwapchainManager::quantize_frame(std::vector<uint8_t>* frame) const {
+    if (!frame) {
+        return;
+    }
+    // Clearing the low bits turns gradients into long runs for the RLE pass.
+    for (uint8_t& value : *frame) {
+        value &= 0xFCu;
+    }
+}
+
 bool ServerSwapchainManager::allocate_resources(ServerSwapchain& swapchain,
                                                 const VenusSwapchainCreateInfo& info,
                                                 VenusSwapchainCreateReply* reply) {
@@ -381,16 +559,14 @@ bool ServerSwapchainManager::allocate_resources(ServerSwapchain& swapchain,
         vkBindBufferMemory(swapchain.device, image.staging_buffer, image.staging_memory, 0);
         vkMapMemory(swapchain.device, image.staging_memory, 0, buffer_alloc.allocationSize, 0, &image.staging_ptr);
 
-        if (reply && i < kVenusMaxSwapchainImages) {
-            reply->images[i].image_handle = reinterpret_cast<uint64_t>(image.image);
+        image.client_image = image.image;
+        if (state_) {
+            image.client_image = state_->resource_tracker.register_external_image(
+                swapchain.client_device, swapchain.device, image.image, image_info);
         }
 
-        if (state_) {
-            state_->resource_tracker.register_external_image(swapchain.client_device,
-                                                             swapchain.device,
-                                                             image.image,
-                                                             image.image,
-                                                             image_info);
+        if (reply && i < kVenusMaxSwapchainImages) {
+            reply->images[i].image_handle = reinterpret_cast<uint64_t>(image.client_image);
         }
     }
 
@@ -403,8 +579,9 @@ void ServerSwapchainManager::free_resources(ServerSwapchain& swapchain) {
     }
 
     for (auto& image : swapchain.images) {
-        if (state_) {
-            state_->resource_tracker.unregister_external_image(image.image);
+        if (state_ && image.client_image) {
+            state_->resource_tracker.unregister_external_image(image.client_image);
+            image.client_image = VK_NULL_HANDLE;
         }
         if (image.staging_ptr) {
             vkUnmapMemory(swapchain.device, image.staging_memory);
@@ -438,7 +615,7 @@ uint32_t ServerSwapchainManager::find_memory_type(uint32_t type_bits,
     if (!state_) {
         return 0;
     }
-    const auto& props = state_->physical_device_memory_properties;
+    const auto& props = state_->shared->physical_device_memory_properties;
     for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
         if ((type_bits & (1u << i)) &&
             (props.memoryTypes[i].propertyFlags & flags) == flags) {
@@ -28,6 +28,7 @@ struct ServerSwapchain {
 
     struct ImageResources {
         VkImage image = VK_NULL_HANDLE;
+        VkImage client_image = VK_NULL_HANDLE;  // handle issued by the resource tracker
         VkDeviceMemory memory = VK_NULL_HANDLE;
         VkBuffer staging_buffer = VK_NULL_HANDLE;
         VkDeviceMemory staging_memory = VK_NULL_HANDLE;
@@ -38,22 +39,48 @@ struct ServerSwapchain {
     std::vector<ImageResources> images;
 };
 
+// Result of reading back one swapchain image.
+struct PresentedFrame {
+    VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+    VenusFrameHeader header = {};
+    std::vector<uint8_t> payload;
+};
+
 class ServerSwapchainManager {
 public:
     explicit ServerSwapchainManager(ServerState* state);
     VkResult create_swapchain(const VenusSwapchainCreateInfo& info,
                               VenusSwapchainCreateReply* reply);
     void destroy_swapchain(uint32_t id);
+    // Frees every swapchain still alive (the client disconnected).
+    void destroy_all();
     VkResult acquire_image(uint32_t id, uint32_t* image_index);
     VkResult present(uint32_t id,
                      uint32_t image_index,
+                     FrameCodecLevel codec_level,
                      VenusFrameHeader* header,
                      std::vector<uint8_t>* payload);
+    // Reads back every entry with a single submission per device and fills
+    // |frames| in entry order. The submission waits on the (client handle)
+    // |wait_semaphores| of its device. Returns the first per-entry failure.
+    VkResult present_batch(const VenusSwapchainPresentEntry* entries,
+                           uint32_t entry_count,
+                           const VkSemaphore* wait_semaphores,
+                           uint32_t wait_semaphore_count,
+                           std::vector<PresentedFrame>* frames);
 
 private:
+    void record_readback(VkCommandBuffer command_buffer,
+                         const ServerSwapchain& swapchain,
+                         const ServerSwapchain::ImageResources& image) const;
+    void encode_frame(const ServerSwapchain& swapchain,
+                      uint32_t image_index,
+                      FrameCodecLevel codec_level,
+                      PresentedFrame* frame) const;
     void compress_frame(const std::vector<uint8_t>& input,
                         std::vector<uint8_t>* output,
                         FrameCompressionType* mode) const;
+    void quantize_frame(std::vector<uint8_t>* frame) const;
 
     bool allocate_resources(ServerSwapchain& swapchain,
                             const VenusSwapchainCreateInfo& info,
@@ -0,0 +1,13 @@
+#ifndef VENUS_TEST_APP_DECODE_THROUGHPUT_BENCHMARK_H
+#define VENUS_TEST_APP_DECODE_THROUGHPUT_BENCHMARK_H
+
+#include <cstdint>
+
+// Records |commands| transfer commands (fill, update and copy in turn) into
+// one command buffer, submits and waits, and reports server decode
+// throughput in commands/s. Run it against `venus-server` and
+// `venus-server --trusted-client` to compare validated and fast-path
+// dispatch.
+bool run_decode_throughput_benchmark(uint32_t commands);
+
+#endif // VENUS_TEST_APP_DECODE_THROUGHPUT_BENCHMARK_H
@@ -0,0 +1,148 @@
+#include "handle_table_benchmark.h"
+
+#include "logging.h"
+#include "state/slot_map.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using venus_plus::SlotMap;
+
+// Roughly the shape of a tracked resource.
+struct Entry {
+    uint64_t device = 0;
+    uint64_t real_handle = 0;
+    uint64_t size = 0;
+    uint32_t usage = 0;
+    bool bound = false;
+};
+
+constexpr uint32_t kLiveObjects = 4096;
+constexpr uint8_t kBenchTag = 0x7f;
+
+// How the tables looked before: hash map behind a mutex, counter handles.
+class LockedMap {
+public:
+    uint64_t insert(const Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint64_t handle = next_handle_++;
+        map_[handle] = entry;
+        return handle;
+    }
+    void erase(uint64_t handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        map_.erase(handle);
+    }
+    uint64_t translate(uint64_t handle) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = map_.find(handle);
+        return it == map_.end() ? 0 : it->second.real_handle;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Entry> map_;
+    uint64_t next_handle_ = 0x40000000ull;
+};
+
+class SlotTable {
+public:
+    SlotTable() : map_(kBenchTag) {}
+    uint64_t insert(const Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return map_.insert(entry, entry.real_handle);
+    }
+    void erase(uint64_t handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        map_.erase(handle);
+    }
+    uint64_t translate(uint64_t handle) const { return map_.translate(handle); }
+
+private:
+    std::mutex mutex_;
+    SlotMap<Entry> map_;
+};
+
+// Decode order is not sequential in handle order; walk the live set with a
+// cheap LCG so neither table gets a purely linear pattern.
+template <typename Table>
+double measure(Table& table, const std::vector<uint64_t>& handles, uint32_t lookups, bool churn) {
+    std::atomic<bool> stop{false};
+    std::thread writer;
+    if (churn) {
+        writer = std::thread([&table, &stop] {
+            Entry entry;
+            entry.real_handle = 0xdead0000ull;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint64_t handle = table.insert(entry);
+                table.erase(handle);
+            }
+        });
+    }
+
+    uint64_t checksum = 0;
+    uint32_t state = 12345;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; ++i) {
+        state = state * 1664525u + 1013904223u;
+        checksum += table.translate(handles[state % handles.size()]);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    stop.store(true, std::memory_order_relaxed);
+    if (writer.joinable()) {
+        writer.join();
+    }
+    if (checksum == 0) {
+        TEST_LOG_ERROR() << "Handle table benchmark: every lookup missed";
+        return 0.0;
+    }
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    return seconds > 0.0 ? lookups / seconds : 0.0;
+}
+
+template <typename Table>
+std::vector<uint64_t> populate(Table& table) {
+    std::vector<uint64_t> handles;
+    handles.reserve(kLiveObjects);
+    for (uint32_t i = 0; i < kLiveObjects; ++i) {
+        Entry entry;
+        entry.real_handle = 0x10000ull + i;
+        handles.push_back(table.insert(entry));
+    }
+    return handles;
+}
+
+} // namespace
+
+bool run_handle_table_benchmark(uint32_t lookups) {
+    if (lookups == 0) {
+        lookups = 1;
+    }
+    LockedMap locked;
+    SlotTable slots;
+    const std::vector<uint64_t> locked_handles = populate(locked);
+    const std::vector<uint64_t> slot_handles = populate(slots);
+
+    const double locked_rate = measure(locked, locked_handles, lookups, false);
+    const double slot_rate = measure(slots, slot_handles, lookups, false);
+    const double locked_churn = measure(locked, locked_handles, lookups, true);
+    const double slot_churn = measure(slots, slot_handles, lookups, true);
+    if (locked_rate == 0.0 || slot_rate == 0.0 || locked_churn == 0.0 || slot_churn == 0.0) {
+        return false;
+    }
+
+    TEST_LOG_INFO() << "Handle table benchmark (" << lookups << " lookups, " << kLiveObjects
+                    << " live objects)";
+    TEST_LOG_INFO() << "  mutex + unordered_map:          " << locked_rate / 1e6 << " M lookups/s";
+    TEST_LOG_INFO() << "  slot map:                       " << slot_rate / 1e6 << " M lookups/s";
+    TEST_LOG_INFO() << "  mutex + unordered_map, writer:  " << locked_churn / 1e6 << " M lookups/s";
+    TEST_LOG_INFO() << "  slot map, writer:               " << slot_churn / 1e6 << " M lookups/s";
+    return true;
+}
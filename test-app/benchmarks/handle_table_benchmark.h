@@ -0,0 +1,12 @@
+#ifndef VENUS_TEST_APP_HANDLE_TABLE_BENCHMARK_H
+#define VENUS_TEST_APP_HANDLE_TABLE_BENCHMARK_H
+
+#include <cstdint>
+
+// Measures server handle translation (client handle -> real handle) as
+// lookups per second: the previous mutex-guarded unordered_map against the
+// generation-checked slot map, alone and with a thread creating and
+// destroying objects in the same table.
+bool run_handle_table_benchmark(uint32_t lookups);
+
+#endif // VENUS_TEST_APP_HANDLE_TABLE_BENCHMARK_H
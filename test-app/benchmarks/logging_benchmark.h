@@ -0,0 +1,10 @@
+#ifndef VENUS_TEST_APP_LOGGING_BENCHMARK_H
+#define VENUS_TEST_APP_LOGGING_BENCHMARK_H
+
+#include <cstdint>
+
+// Measures the per-call cost of log statements whose level is disabled, and
+// of enabled statements through the asynchronous and the synchronous sink.
+bool run_logging_benchmark(uint32_t iterations);
+
+#endif // VENUS_TEST_APP_LOGGING_BENCHMARK_H
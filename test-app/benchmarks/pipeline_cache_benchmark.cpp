@@ -0,0 +1,124 @@
+#include "pipeline_cache_benchmark.h"
+
+#include "features/feature_harness.h"
+#include "logging.h"
+
+#include <chrono>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSize = 64;
+
+// Blend factors whose pairs give distinct pipelines; drivers fold the blend
+// state into the fragment shader they compile.
+constexpr VkBlendFactor kFactors[] = {
+    VK_BLEND_FACTOR_ZERO,
+    VK_BLEND_FACTOR_ONE,
+    VK_BLEND_FACTOR_SRC_COLOR,
+    VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,
+    VK_BLEND_FACTOR_DST_COLOR,
+    VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR,
+    VK_BLEND_FACTOR_SRC_ALPHA,
+    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+    VK_BLEND_FACTOR_DST_ALPHA,
+    VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA,
+    VK_BLEND_FACTOR_CONSTANT_COLOR,
+    VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR,
+    VK_BLEND_FACTOR_SRC_ALPHA_SATURATE,
+};
+constexpr uint32_t kFactorCount = sizeof(kFactors) / sizeof(kFactors[0]);
+constexpr uint32_t kMaxPipelines = kFactorCount * kFactorCount;
+
+VkPipelineColorBlendAttachmentState blend_state(uint32_t index) {
+    VkPipelineColorBlendAttachmentState blend = features::opaque_blend_state();
+    blend.blendEnable = VK_TRUE;
+    blend.srcColorBlendFactor = kFactors[index % kFactorCount];
+    blend.dstColorBlendFactor = kFactors[index / kFactorCount];
+    blend.colorBlendOp = VK_BLEND_OP_ADD;
+    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blend.alphaBlendOp = VK_BLEND_OP_ADD;
+    return blend;
+}
+
+// Average milliseconds from create to the first draw's fence, or a negative
+// value on failure.
+double run_pass(const features::Device& device,
+                const features::TriangleTarget& target,
+                VkCommandBuffer command_buffer,
+                uint32_t pipelines) {
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VkRect2D area = {};
+    area.extent = {kSize, kSize};
+
+    std::vector<VkPipeline> created;
+    double total_ms = 0.0;
+    bool ok = true;
+    for (uint32_t i = 0; i < pipelines && ok; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        ok = features::create_triangle_pipeline(device, target, blend_state(i), &pipeline);
+        if (ok) {
+            created.push_back(pipeline);
+            vkBeginCommandBuffer(command_buffer, &begin_info);
+            features::cmd_begin_triangle_pass(command_buffer, target);
+            features::cmd_draw_triangle(command_buffer, target, area, pipeline);
+            features::cmd_end_triangle_pass(command_buffer, target);
+            ok = vkEndCommandBuffer(command_buffer) == VK_SUCCESS &&
+                 features::submit_and_wait(device, command_buffer);
+        }
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    for (VkPipeline pipeline : created) {
+        vkDestroyPipeline(device.device, pipeline, nullptr);
+    }
+    if (!ok) {
+        TEST_LOG_ERROR() << "✗ Pipeline " << created.size() << " could not be created or used";
+        return -1.0;
+    }
+    return total_ms / pipelines;
+}
+
+} // namespace
+
+bool run_pipeline_cache_benchmark(uint32_t pipelines) {
+    if (pipelines == 0 || pipelines > kMaxPipelines) {
+        TEST_LOG_ERROR() << "Error: pipeline count must be 1.." << kMaxPipelines;
+        return false;
+    }
+    TEST_LOG_INFO() << "Pipeline cache benchmark (" << pipelines << " pipelines, create through first fence)";
+
+    features::Device device;
+    features::TriangleTarget target;
+    auto cleanup = [&]() {
+        features::destroy_triangle_target(device, &target);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Pipeline Cache Benchmark", {}, &device) ||
+        !features::create_triangle_target(device, kSize, kSize, &target)) {
+        cleanup();
+        return false;
+    }
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    if (command_buffer == VK_NULL_HANDLE) {
+        cleanup();
+        return false;
+    }
+
+    const double first_ms = run_pass(device, target, command_buffer, pipelines);
+    const double second_ms = first_ms < 0.0 ? -1.0 : run_pass(device, target, command_buffer, pipelines);
+    cleanup();
+    if (second_ms < 0.0) {
+        return false;
+    }
+
+    TEST_LOG_INFO() << "  First pass:  " << first_ms << " ms per pipeline until usable";
+    TEST_LOG_INFO() << "  Second pass: " << second_ms << " ms per pipeline until usable";
+    if (second_ms > 0.0) {
+        TEST_LOG_INFO() << "  Speedup:     " << first_ms / second_ms << "x";
+    }
+    TEST_LOG_INFO() << "✅ Pipeline cache benchmark complete";
+    return true;
+}
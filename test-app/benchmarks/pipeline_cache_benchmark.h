@@ -0,0 +1,16 @@
+#ifndef VENUS_TEST_APP_PIPELINE_CACHE_BENCHMARK_H
+#define VENUS_TEST_APP_PIPELINE_CACHE_BENCHMARK_H
+
+#include <cstdint>
+
+// Creates |pipelines| graphics pipelines that differ in their blend state and
+// times each until it is usable: create, record a draw with it, submit and
+// wait for the fence. The server may return from vkCreateGraphicsPipelines
+// before the compile finishes, so the create call alone measures only a round
+// trip. The same pipelines are then created again in the same session, where
+// the server's implicit pipeline cache holds them. Against a fresh server the
+// first pass is cold; compare with --no-pipeline-cache, and with
+// --pipeline-threads 0 for inline compiles.
+bool run_pipeline_cache_benchmark(uint32_t pipelines);
+
+#endif // VENUS_TEST_APP_PIPELINE_CACHE_BENCHMARK_H
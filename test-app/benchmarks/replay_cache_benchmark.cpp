@@ -0,0 +1,206 @@
+#include "replay_cache_benchmark.h"
+
+#include "logging.h"
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+constexpr VkDeviceSize kBufferSize = 64 * 1024;
+
+} // namespace
+
+bool run_replay_cache_benchmark(uint32_t frames, uint32_t commands) {
+    TEST_LOG_INFO() << "Replay cache benchmark (" << frames << " frames, " << commands
+                    << " commands per frame)";
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkBuffer buffers[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+
+    auto cleanup = [&]() {
+        if (pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device, pool, nullptr);
+        }
+        for (VkBuffer buffer : buffers) {
+            if (buffer != VK_NULL_HANDLE) {
+                vkDestroyBuffer(device, buffer, nullptr);
+            }
+        }
+        if (memory != VK_NULL_HANDLE) {
+            vkFreeMemory(device, memory, nullptr);
+        }
+        if (device != VK_NULL_HANDLE) {
+            vkDestroyDevice(device, nullptr);
+        }
+        if (instance != VK_NULL_HANDLE) {
+            vkDestroyInstance(instance, nullptr);
+        }
+    };
+
+    VkApplicationInfo app_info = {};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "Replay Cache Benchmark";
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "VenusPlus";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+    if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateInstance failed";
+        cleanup();
+        return false;
+    }
+
+    uint32_t phys_count = 1;
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    vkEnumeratePhysicalDevices(instance, &phys_count, &physical_device);
+    if (physical_device == VK_NULL_HANDLE) {
+        TEST_LOG_ERROR() << "✗ No physical devices available";
+        cleanup();
+        return false;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = 0;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &queue_priority;
+
+    VkDeviceCreateInfo device_info = {};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    if (vkCreateDevice(physical_device, &device_info, nullptr, &device) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateDevice failed";
+        cleanup();
+        return false;
+    }
+    VkQueue queue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, 0, 0, &queue);
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = kBufferSize;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    for (VkBuffer& buffer : buffers) {
+        if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+            TEST_LOG_ERROR() << "✗ vkCreateBuffer failed";
+            cleanup();
+            return false;
+        }
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(device, buffers[0], &requirements);
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    const VkDeviceSize stride = (requirements.size + alignment - 1) / alignment * alignment;
+    uint32_t memory_type = 0;
+    while (memory_type < 32 && !(requirements.memoryTypeBits & (1u << memory_type))) {
+        ++memory_type;
+    }
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = stride * 2;
+    alloc_info.memoryTypeIndex = memory_type;
+    if (vkAllocateMemory(device, &alloc_info, nullptr, &memory) != VK_SUCCESS ||
+        vkBindBufferMemory(device, buffers[0], memory, 0) != VK_SUCCESS ||
+        vkBindBufferMemory(device, buffers[1], memory, stride) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Buffer memory setup failed";
+        cleanup();
+        return false;
+    }
+
+    // The usual engine pattern: one transient pool reset every frame.
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = 0;
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &pool) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateCommandPool failed";
+        cleanup();
+        return false;
+    }
+    VkCommandBufferAllocateInfo cb_info = {};
+    cb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cb_info.commandPool = pool;
+    cb_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cb_info.commandBufferCount = 1;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device, &cb_info, &command_buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkAllocateCommandBuffers failed";
+        cleanup();
+        return false;
+    }
+
+    VkBufferCopy region = {};
+    region.size = kBufferSize / 2;
+
+    // Returns the average frame time in seconds, or a negative value on failure.
+    auto run_frames = [&](bool changing) -> double {
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            VkResult result = vkResetCommandPool(device, pool, 0);
+            VkCommandBufferBeginInfo begin_info = {};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            if (result == VK_SUCCESS) {
+                result = vkBeginCommandBuffer(command_buffer, &begin_info);
+            }
+            if (result != VK_SUCCESS) {
+                TEST_LOG_ERROR() << "✗ Frame " << frame << " begin failed: " << result;
+                return -1.0;
+            }
+            const uint32_t fill_value = changing ? frame : 0;
+            for (uint32_t i = 0; i < commands; ++i) {
+                if (i % 2 == 0) {
+                    vkCmdFillBuffer(command_buffer, buffers[0], 0, kBufferSize, fill_value + i);
+                } else {
+                    vkCmdCopyBuffer(command_buffer, buffers[0], buffers[1], 1, &region);
+                }
+            }
+            result = vkEndCommandBuffer(command_buffer);
+
+            VkSubmitInfo submit_info = {};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &command_buffer;
+            if (result == VK_SUCCESS) {
+                result = vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE);
+            }
+            if (result == VK_SUCCESS) {
+                result = vkQueueWaitIdle(queue);
+            }
+            if (result != VK_SUCCESS) {
+                TEST_LOG_ERROR() << "✗ Frame " << frame << " failed: " << result;
+                return -1.0;
+            }
+        }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return frames > 0 ? seconds / frames : 0.0;
+    };
+
+    const double identical = run_frames(false);
+    const double changing = identical < 0.0 ? -1.0 : run_frames(true);
+    if (identical < 0.0 || changing < 0.0) {
+        cleanup();
+        return false;
+    }
+
+    TEST_LOG_INFO() << "  identical frames: " << identical * 1000.0 << " ms/frame";
+    TEST_LOG_INFO() << "  changing frames:  " << changing * 1000.0 << " ms/frame";
+    TEST_LOG_INFO() << "  speedup:          " << (identical > 0.0 ? changing / identical : 0.0) << "x";
+
+    cleanup();
+    return true;
+}
@@ -0,0 +1,14 @@
+#ifndef VENUS_TEST_APP_REPLAY_CACHE_BENCHMARK_H
+#define VENUS_TEST_APP_REPLAY_CACHE_BENCHMARK_H
+
+#include <cstdint>
+
+// Re-records one command buffer of |commands| transfer commands every frame
+// for |frames| frames (reset pool, record, submit, wait), once with identical
+// contents and once with a fill value that changes per frame, and reports
+// the average frame time of each. Identical frames are what the ICD's replay
+// cache turns into reuse tokens; run with VENUS_REPLAY_CACHE=off to compare,
+// and VENUS_REPLAY_STATS=<N> for the client's hit rate and bytes saved.
+bool run_replay_cache_benchmark(uint32_t frames, uint32_t commands);
+
+#endif // VENUS_TEST_APP_REPLAY_CACHE_BENCHMARK_H
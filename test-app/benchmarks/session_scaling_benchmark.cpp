@@ -0,0 +1,311 @@
+#include "session_scaling_benchmark.h"
+
+#include "logging.h"
+#include "utils/log_sink.h"
+#include <vulkan/vulkan.h>
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Generous: a server that serves one connection at a time never gets there.
+constexpr int kSetupTimeoutMs = 30000;
+constexpr int kRunTimeoutMs = 300000;
+constexpr VkDeviceSize kFillBufferSize = 64 * 1024;
+
+bool read_full(int fd, void* data, size_t size, int timeout_ms) {
+    uint8_t* out = static_cast<uint8_t*>(data);
+    size_t done = 0;
+    while (done < size) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        const ssize_t n = read(fd, out + done, size - done);
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool write_full(int fd, const void* data, size_t size) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = write(fd, in + done, size - done);
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Body of one client process. Reports 'r' (or 'e') on ready_fd once its
+// device and command buffer exist, waits for the go byte, then records,
+// submits and waits, and writes the elapsed seconds to result_fd.
+int run_client(uint32_t commands, int ready_fd, int go_fd, int result_fd) {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+
+    auto cleanup = [&]() {
+        if (pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device, pool, nullptr);
+        }
+        if (buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, buffer, nullptr);
+        }
+        if (memory != VK_NULL_HANDLE) {
+            vkFreeMemory(device, memory, nullptr);
+        }
+        if (device != VK_NULL_HANDLE) {
+            vkDestroyDevice(device, nullptr);
+        }
+        if (instance != VK_NULL_HANDLE) {
+            vkDestroyInstance(instance, nullptr);
+        }
+    };
+    auto fail = [&](const char* what) {
+        TEST_LOG_ERROR() << "✗ " << what << " failed in client " << getpid();
+        const char status = 'e';
+        write_full(ready_fd, &status, 1);
+        cleanup();
+        return 1;
+    };
+
+    VkApplicationInfo app_info = {};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "Session Scaling Benchmark";
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "VenusPlus";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+    if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+        return fail("vkCreateInstance");
+    }
+
+    uint32_t phys_count = 1;
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    vkEnumeratePhysicalDevices(instance, &phys_count, &physical_device);
+    if (physical_device == VK_NULL_HANDLE) {
+        return fail("vkEnumeratePhysicalDevices");
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = 0;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &queue_priority;
+
+    VkDeviceCreateInfo device_info = {};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    if (vkCreateDevice(physical_device, &device_info, nullptr, &device) != VK_SUCCESS) {
+        return fail("vkCreateDevice");
+    }
+    VkQueue queue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, 0, 0, &queue);
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = kFillBufferSize;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS) {
+        return fail("vkCreateBuffer");
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(device, buffer, &requirements);
+    uint32_t memory_type = 0;
+    while (memory_type < 32 && !(requirements.memoryTypeBits & (1u << memory_type))) {
+        ++memory_type;
+    }
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex = memory_type;
+    if (vkAllocateMemory(device, &alloc_info, nullptr, &memory) != VK_SUCCESS ||
+        vkBindBufferMemory(device, buffer, memory, 0) != VK_SUCCESS) {
+        return fail("buffer memory setup");
+    }
+
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex = 0;
+    if (vkCreateCommandPool(device, &pool_info, nullptr, &pool) != VK_SUCCESS) {
+        return fail("vkCreateCommandPool");
+    }
+    VkCommandBufferAllocateInfo cb_info = {};
+    cb_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cb_info.commandPool = pool;
+    cb_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cb_info.commandBufferCount = 1;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device, &cb_info, &command_buffer) != VK_SUCCESS) {
+        return fail("vkAllocateCommandBuffers");
+    }
+
+    const char ready = 'r';
+    char go = 0;
+    if (!write_full(ready_fd, &ready, 1) || !read_full(go_fd, &go, 1, -1)) {
+        cleanup();
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    for (uint32_t i = 0; i < commands; ++i) {
+        vkCmdFillBuffer(command_buffer, buffer, 0, kFillBufferSize, i);
+    }
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    VkResult result = vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE);
+    if (result == VK_SUCCESS) {
+        result = vkQueueWaitIdle(queue);
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (result != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ submit failed in client " << getpid() << ": " << result;
+        cleanup();
+        return 1;
+    }
+
+    write_full(result_fd, &seconds, sizeof(seconds));
+    cleanup();
+    return 0;
+}
+
+// Runs one round with |clients| concurrent processes. Returns false if any of
+// them failed; otherwise fills the wall time from go to the last result.
+bool run_round(uint32_t clients, uint32_t commands, double* wall_seconds, double* slowest_seconds) {
+    int ready_pipe[2];
+    int go_pipe[2];
+    int result_pipe[2];
+    if (pipe(ready_pipe) != 0 || pipe(go_pipe) != 0 || pipe(result_pipe) != 0) {
+        TEST_LOG_ERROR() << "✗ pipe() failed: " << strerror(errno);
+        return false;
+    }
+
+    // Children inherit the log sink; have nothing queued that both would print.
+    venus_plus::LogSink::instance().flush();
+
+    std::vector<pid_t> children;
+    for (uint32_t i = 0; i < clients; ++i) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            TEST_LOG_ERROR() << "✗ fork() failed: " << strerror(errno);
+            break;
+        }
+        if (pid == 0) {
+            // The parent's drain thread does not exist here.
+            venus_plus::LogSink::instance().set_async(false);
+            close(ready_pipe[0]);
+            close(go_pipe[1]);
+            close(result_pipe[0]);
+            _exit(run_client(commands, ready_pipe[1], go_pipe[0], result_pipe[1]));
+        }
+        children.push_back(pid);
+    }
+    close(ready_pipe[1]);
+    close(go_pipe[0]);
+    close(result_pipe[1]);
+
+    bool ok = children.size() == clients;
+    for (size_t i = 0; ok && i < children.size(); ++i) {
+        char status = 0;
+        if (!read_full(ready_pipe[0], &status, 1, kSetupTimeoutMs) || status != 'r') {
+            TEST_LOG_ERROR() << "✗ " << clients << " clients did not all connect; "
+                             << "does the server serve connections concurrently?";
+            ok = false;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (ok) {
+        const std::vector<char> go(children.size(), 'g');
+        ok = write_full(go_pipe[1], go.data(), go.size());
+    }
+    *slowest_seconds = 0.0;
+    for (size_t i = 0; ok && i < children.size(); ++i) {
+        double seconds = 0.0;
+        if (!read_full(result_pipe[0], &seconds, sizeof(seconds), kRunTimeoutMs)) {
+            TEST_LOG_ERROR() << "✗ a client failed during the run";
+            ok = false;
+        } else if (seconds > *slowest_seconds) {
+            *slowest_seconds = seconds;
+        }
+    }
+    *wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Closing the go pipe releases children still waiting for it.
+    close(ready_pipe[0]);
+    close(go_pipe[1]);
+    close(result_pipe[0]);
+    for (pid_t pid : children) {
+        if (!ok) {
+            kill(pid, SIGTERM);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+bool run_session_scaling_benchmark(uint32_t max_clients, uint32_t commands) {
+    TEST_LOG_INFO() << "Session scaling benchmark (1.." << max_clients << " clients, "
+                    << commands << " vkCmdFillBuffer each)";
+    if (max_clients == 0 || commands == 0) {
+        TEST_LOG_ERROR() << "✗ clients and commands must be non-zero";
+        return false;
+    }
+
+    double single_rate = 0.0;
+    for (uint32_t clients = 1; clients <= max_clients; ++clients) {
+        double wall_seconds = 0.0;
+        double slowest_seconds = 0.0;
+        if (!run_round(clients, commands, &wall_seconds, &slowest_seconds)) {
+            return false;
+        }
+        const double total = static_cast<double>(clients) * commands;
+        const double rate = wall_seconds > 0.0 ? total / wall_seconds : 0.0;
+        if (clients == 1) {
+            single_rate = rate;
+        }
+        TEST_LOG_INFO() << "  " << clients << " client(s): " << rate / 1e6 << " M commands/s aggregate, "
+                        << "slowest client " << slowest_seconds * 1000.0 << " ms, scaling x"
+                        << (single_rate > 0.0 ? rate / single_rate : 0.0);
+    }
+    return true;
+}
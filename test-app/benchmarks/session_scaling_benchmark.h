@@ -0,0 +1,13 @@
+#ifndef VENUS_TEST_APP_SESSION_SCALING_BENCHMARK_H
+#define VENUS_TEST_APP_SESSION_SCALING_BENCHMARK_H
+
+#include <cstdint>
+
+// Measures aggregate server throughput as the number of concurrent clients
+// grows from 1 to max_clients. Each client is a separate process (and so a
+// separate connection and server session) that records |commands|
+// vkCmdFillBuffer calls, submits them and waits; the report is commands/s
+// across all clients per client count.
+bool run_session_scaling_benchmark(uint32_t max_clients, uint32_t commands);
+
+#endif // VENUS_TEST_APP_SESSION_SCALING_BENCHMARK_H
@@ -0,0 +1,179 @@
+#include "wsi_present_benchmark.h"
+
+#include "logging.h"
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+namespace {
+
+struct CpuSample {
+    double user_ms = 0.0;
+    double system_ms = 0.0;
+};
+
+CpuSample sample_process_cpu() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    CpuSample sample;
+    sample.user_ms = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0;
+    sample.system_ms = usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    return sample;
+}
+
+// The headless file sink dumps every presented image to the working directory.
+void remove_headless_frames() {
+    namespace fs = std::filesystem;
+    for (const auto& entry : fs::directory_iterator(fs::current_path())) {
+        const std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.rfind("swapchain_", 0) == 0 &&
+            entry.path().extension() == ".rgba") {
+            std::error_code ec;
+            fs::remove(entry.path(), ec);
+        }
+    }
+}
+
+} // namespace
+
+bool run_wsi_present_benchmark(uint32_t frame_count, uint32_t width, uint32_t height) {
+    TEST_LOG_INFO() << "WSI present benchmark (" << width << "x" << height << ", "
+                    << frame_count << " frames, headless)";
+
+    // Measure the present path, not the disk: unless the caller picked a sink,
+    // keep frames in memory. The ICD reads this when the swapchain is created.
+    setenv("VENUS_WSI_HEADLESS_SINK", "memory", 0);
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+
+    auto cleanup = [&]() {
+        if (swapchain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(device, swapchain, nullptr);
+        }
+        if (device != VK_NULL_HANDLE) {
+            vkDestroyDevice(device, nullptr);
+        }
+        if (instance != VK_NULL_HANDLE) {
+            vkDestroyInstance(instance, nullptr);
+        }
+        remove_headless_frames();
+    };
+
+    VkApplicationInfo app_info = {};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "WSI Present Benchmark";
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "VenusPlus";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+    if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateInstance failed";
+        cleanup();
+        return false;
+    }
+
+    uint32_t phys_count = 0;
+    vkEnumeratePhysicalDevices(instance, &phys_count, nullptr);
+    if (phys_count == 0) {
+        TEST_LOG_ERROR() << "✗ No physical devices available";
+        cleanup();
+        return false;
+    }
+    std::vector<VkPhysicalDevice> physical_devices(phys_count);
+    vkEnumeratePhysicalDevices(instance, &phys_count, physical_devices.data());
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = 0;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &queue_priority;
+
+    const char* device_extensions[] = { "VK_KHR_swapchain" };
+    VkDeviceCreateInfo device_info = {};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    device_info.enabledExtensionCount = 1;
+    device_info.ppEnabledExtensionNames = device_extensions;
+    if (vkCreateDevice(physical_devices[0], &device_info, nullptr, &device) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateDevice failed";
+        cleanup();
+        return false;
+    }
+    VkQueue queue = VK_NULL_HANDLE;
+    vkGetDeviceQueue(device, 0, 0, &queue);
+
+    VkSwapchainCreateInfoKHR swapchain_info = {};
+    swapchain_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapchain_info.surface = VK_NULL_HANDLE;
+    swapchain_info.minImageCount = 2;
+    swapchain_info.imageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+    swapchain_info.imageColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+    swapchain_info.imageExtent = {width, height};
+    swapchain_info.imageArrayLayers = 1;
+    swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchain_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    swapchain_info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapchain_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    swapchain_info.clipped = VK_TRUE;
+    if (vkCreateSwapchainKHR(device, &swapchain_info, nullptr, &swapchain) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateSwapchainKHR failed";
+        cleanup();
+        return false;
+    }
+
+    const CpuSample cpu_start = sample_process_cpu();
+    const auto wall_start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frame_count; ++frame) {
+        uint32_t image_index = 0;
+        VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX,
+                                                VK_NULL_HANDLE, VK_NULL_HANDLE, &image_index);
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            TEST_LOG_ERROR() << "✗ vkAcquireNextImageKHR failed at frame " << frame << ": " << result;
+            cleanup();
+            return false;
+        }
+
+        VkPresentInfoKHR present_info = {};
+        present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        present_info.swapchainCount = 1;
+        present_info.pSwapchains = &swapchain;
+        present_info.pImageIndices = &image_index;
+        result = vkQueuePresentKHR(queue, &present_info);
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            TEST_LOG_ERROR() << "✗ vkQueuePresentKHR failed at frame " << frame << ": " << result;
+            cleanup();
+            return false;
+        }
+    }
+    const auto wall_end = std::chrono::steady_clock::now();
+    const CpuSample cpu_end = sample_process_cpu();
+
+    const double frames = frame_count > 0 ? static_cast<double>(frame_count) : 1.0;
+    const double wall_ms =
+        std::chrono::duration<double, std::milli>(wall_end - wall_start).count();
+    const double user_ms = cpu_end.user_ms - cpu_start.user_ms;
+    const double system_ms = cpu_end.system_ms - cpu_start.system_ms;
+
+    TEST_LOG_INFO() << "  frames:            " << frame_count;
+    TEST_LOG_INFO() << "  wall per frame:    " << wall_ms / frames << " ms ("
+                    << (wall_ms > 0.0 ? frames * 1000.0 / wall_ms : 0.0) << " fps)";
+    TEST_LOG_INFO() << "  client CPU/frame:  " << (user_ms + system_ms) / frames << " ms (user "
+                    << user_ms / frames << ", sys " << system_ms / frames << ")";
+
+    cleanup();
+    return true;
+}
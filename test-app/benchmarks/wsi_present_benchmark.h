@@ -0,0 +1,10 @@
+#ifndef VENUS_TEST_APP_WSI_PRESENT_BENCHMARK_H
+#define VENUS_TEST_APP_WSI_PRESENT_BENCHMARK_H
+
+#include <cstdint>
+
+// Presents |frame_count| frames through a headless swapchain and reports the
+// client-side CPU time spent per frame (receive + decode + WSI hand-off).
+bool run_wsi_present_benchmark(uint32_t frame_count, uint32_t width, uint32_t height);
+
+#endif // VENUS_TEST_APP_WSI_PRESENT_BENCHMARK_H
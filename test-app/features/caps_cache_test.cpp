@@ -0,0 +1,217 @@
+#include "caps_cache_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+const VkFormat kFormats[] = {
+    VK_FORMAT_R8G8B8A8_UNORM,
+    VK_FORMAT_B8G8R8A8_SRGB,
+    VK_FORMAT_R16G16B16A16_SFLOAT,
+    VK_FORMAT_D32_SFLOAT,
+    VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+};
+
+// How a run's VK_EXT_memory_budget queries were answered.
+constexpr uint64_t kBudgetUnsupported = 0;
+constexpr uint64_t kBudgetFromServer = 1;
+constexpr uint64_t kBudgetFromCache = 2;
+
+struct RunResult {
+    uint64_t loaded = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t checksum = 0;
+    uint64_t budget = kBudgetUnsupported;
+};
+
+// FNV-1a over the answers.
+void fold(uint64_t* checksum, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        *checksum = (*checksum ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+bool run_child(const std::string& directory, const std::string& result_path, RunResult* result) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        TEST_LOG_ERROR() << "✗ fork failed";
+        return false;
+    }
+    if (pid == 0) {
+        setenv("VENUS_CAPS_CACHE_DIR", directory.c_str(), 1);
+        execl("/proc/self/exe", "venus-test-app", "--caps-cache-run", result_path.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        TEST_LOG_ERROR() << "✗ Capability cache run failed";
+        return false;
+    }
+    FILE* file = std::fopen(result_path.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    const int fields = std::fscanf(file,
+                                   "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                                   &result->loaded,
+                                   &result->hits,
+                                   &result->misses,
+                                   &result->checksum,
+                                   &result->budget);
+    std::fclose(file);
+    return fields == 5;
+}
+
+void remove_directory(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (dir) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+                unlink((directory + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
+// Asks for the memory budget twice; the capability cache must see neither
+// query, since budgets change while the process runs.
+uint64_t query_budget(const features::Device& device) {
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(device.physical_device, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> extensions(count);
+    vkEnumerateDeviceExtensionProperties(device.physical_device, nullptr, &count, extensions.data());
+    bool supported = false;
+    for (const VkExtensionProperties& extension : extensions) {
+        supported |= std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+    }
+    venus_plus::ClientStats before = {};
+    if (!supported || !features::get_client_stats(device, &before)) {
+        return kBudgetUnsupported;
+    }
+    for (int i = 0; i < 2; ++i) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(device.physical_device, &properties);
+    }
+    venus_plus::ClientStats after = {};
+    features::get_client_stats(device, &after);
+    return after.caps_cache_hits == before.caps_cache_hits && after.caps_cache_misses == before.caps_cache_misses
+               ? kBudgetFromServer
+               : kBudgetFromCache;
+}
+
+} // namespace
+
+int run_caps_cache_child(const char* result_path) {
+    features::Device device;
+    venus_plus::ClientStats stats = {};
+    if (!features::create_device("Caps Cache Run", {}, &device)) {
+        return 1;
+    }
+
+    uint64_t checksum = 14695981039346656037ull;
+    for (VkFormat format : kFormats) {
+        for (VkImageTiling tiling : {VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_TILING_LINEAR}) {
+            VkImageFormatProperties properties = {};
+            const VkResult result = vkGetPhysicalDeviceImageFormatProperties(device.physical_device,
+                                                                              format,
+                                                                              VK_IMAGE_TYPE_2D,
+                                                                              tiling,
+                                                                              VK_IMAGE_USAGE_SAMPLED_BIT |
+                                                                                  VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                                                              0,
+                                                                              &properties);
+            fold(&checksum, &result, sizeof(result));
+            fold(&checksum, &properties, sizeof(properties));
+        }
+    }
+    const bool have_stats = features::get_client_stats(device, &stats);
+    const uint64_t budget = query_budget(device);
+    features::destroy_device(&device);
+    if (!have_stats) {
+        return 1;
+    }
+
+    FILE* file = std::fopen(result_path, "w");
+    if (!file) {
+        return 1;
+    }
+    std::fprintf(file,
+                 "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+                 stats.caps_cache_loaded,
+                 stats.caps_cache_hits,
+                 stats.caps_cache_misses,
+                 checksum,
+                 budget);
+    return std::fclose(file) == 0 ? 0 : 1;
+}
+
+bool run_caps_cache_test() {
+    TEST_LOG_INFO() << "Capability cache test";
+    const char* cache = std::getenv("VENUS_CAPS_CACHE");
+    if (cache && (std::strcmp(cache, "0") == 0 || std::strcmp(cache, "off") == 0 || std::strcmp(cache, "OFF") == 0)) {
+        TEST_LOG_INFO() << "  VENUS_CAPS_CACHE is off, skipping";
+        return true;
+    }
+
+    char directory_template[] = "/tmp/venus-caps-test-XXXXXX";
+    if (!mkdtemp(directory_template)) {
+        TEST_LOG_ERROR() << "✗ Cannot create a cache directory";
+        return false;
+    }
+    const std::string directory = directory_template;
+    // Next to the caps-*.bin files; the cache only reads those.
+    const std::string result_path = directory + "/result.txt";
+
+    RunResult first;
+    RunResult second;
+    const bool ran = run_child(directory, result_path, &first) && run_child(directory, result_path, &second);
+    remove_directory(directory);
+    if (!ran) {
+        return false;
+    }
+
+    TEST_LOG_INFO() << "  first run: loaded=" << first.loaded << " hits=" << first.hits << " misses=" << first.misses;
+    TEST_LOG_INFO() << "  second run: loaded=" << second.loaded << " hits=" << second.hits
+                    << " misses=" << second.misses;
+    if (first.misses == 0 || first.loaded != 0) {
+        TEST_LOG_ERROR() << "✗ First run did not go to the server";
+        return false;
+    }
+    if (second.loaded < first.misses || second.misses != 0) {
+        TEST_LOG_ERROR() << "✗ Second run did not answer from the cache file";
+        return false;
+    }
+    if (second.checksum != first.checksum) {
+        TEST_LOG_ERROR() << "✗ Cached answers differ from the server's";
+        return false;
+    }
+    if (first.budget == kBudgetFromCache || second.budget == kBudgetFromCache) {
+        TEST_LOG_ERROR() << "✗ Memory budget answered through the capability cache";
+        return false;
+    }
+    if (second.budget == kBudgetUnsupported) {
+        TEST_LOG_INFO() << "  Device lacks " << VK_EXT_MEMORY_BUDGET_EXTENSION_NAME << ", budget not checked";
+    }
+    TEST_LOG_INFO() << "✅ Second run answered " << second.hits << " queries from " << second.loaded
+                    << " saved replies";
+    return true;
+}
@@ -0,0 +1,15 @@
+#ifndef VENUS_TEST_APP_CAPS_CACHE_TEST_H
+#define VENUS_TEST_APP_CAPS_CACHE_TEST_H
+
+// Runs the test app twice against a fresh capability cache directory, each
+// run asking for image format properties the enumeration batch leaves out:
+// the second run must load them from the file the first one wrote, answer
+// every query locally, and answer the same. Memory budget queries must skip
+// the cache in both runs.
+bool run_caps_cache_test();
+
+// One of those runs (--caps-cache-run FILE): queries, then writes the cache
+// counters and a checksum of the answers to |result_path|.
+int run_caps_cache_child(const char* result_path);
+
+#endif // VENUS_TEST_APP_CAPS_CACHE_TEST_H
@@ -0,0 +1,270 @@
+#include "deferred_pipeline_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+#include "phase09/shaders/simple_add_spirv.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kElementCount = 1024;
+constexpr uint32_t kWorkgroupSize = 256;
+constexpr VkDeviceSize kBufferSize = kElementCount * sizeof(float);
+constexpr uint32_t kBufferBindings = 3;
+// The first call creates kSeparateCount pipelines, one compile job each; the
+// second creates kDerivedCount, the last deriving from the first by index,
+// which the server compiles as one job.
+constexpr uint32_t kSeparateCount = 4;
+constexpr uint32_t kDerivedCount = 2;
+constexpr uint32_t kPipelineCount = kSeparateCount + kDerivedCount;
+constexpr uint32_t kTargetSize = 64;
+
+struct Resources {
+    features::Buffer inputs[2];
+    features::Buffer outputs[kPipelineCount];
+    VkShaderModule shader = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet sets[kPipelineCount] = {};
+    VkPipeline pipelines[kPipelineCount] = {};
+    features::TriangleTarget target;
+    VkPipeline triangle_pipeline = VK_NULL_HANDLE;
+};
+
+void destroy_resources(const features::Device& device, Resources* res) {
+    if (device.device == VK_NULL_HANDLE) {
+        return;
+    }
+    vkDestroyPipeline(device.device, res->triangle_pipeline, nullptr);
+    features::destroy_triangle_target(device, &res->target);
+    for (VkPipeline pipeline : res->pipelines) {
+        vkDestroyPipeline(device.device, pipeline, nullptr);
+    }
+    vkDestroyDescriptorPool(device.device, res->pool, nullptr);
+    vkDestroyPipelineLayout(device.device, res->layout, nullptr);
+    vkDestroyDescriptorSetLayout(device.device, res->set_layout, nullptr);
+    vkDestroyShaderModule(device.device, res->shader, nullptr);
+    for (features::Buffer& buffer : res->inputs) {
+        features::destroy_buffer(device, &buffer);
+    }
+    for (features::Buffer& buffer : res->outputs) {
+        features::destroy_buffer(device, &buffer);
+    }
+}
+
+// Buffers, the layout and one descriptor set per pipeline, each writing its
+// own output; everything the pipelines need before they exist.
+bool create_resources(const features::Device& device, Resources* res) {
+    for (uint32_t i = 0; i < 2; ++i) {
+        if (!features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &res->inputs[i])) {
+            return false;
+        }
+        float* values = static_cast<float*>(res->inputs[i].mapped);
+        for (uint32_t j = 0; j < kElementCount; ++j) {
+            values[j] = static_cast<float>((i + 1) * j);
+        }
+    }
+    for (features::Buffer& output : res->outputs) {
+        if (!features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &output)) {
+            return false;
+        }
+        float* values = static_cast<float*>(output.mapped);
+        std::fill(values, values + kElementCount, -1.0f);
+    }
+
+    VkShaderModuleCreateInfo shader_info = {};
+    shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_info.codeSize = sizeof(kSimpleAddSpirv);
+    shader_info.pCode = kSimpleAddSpirv;
+    VkDescriptorSetLayoutBinding bindings[kBufferBindings] = {};
+    for (uint32_t i = 0; i < kBufferBindings; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo set_layout_info = {};
+    set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_layout_info.bindingCount = kBufferBindings;
+    set_layout_info.pBindings = bindings;
+    if (vkCreateShaderModule(device.device, &shader_info, nullptr, &res->shader) != VK_SUCCESS ||
+        vkCreateDescriptorSetLayout(device.device, &set_layout_info, nullptr, &res->set_layout) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Creating the shader or set layout failed";
+        return false;
+    }
+    VkPipelineLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &res->set_layout;
+    if (vkCreatePipelineLayout(device.device, &layout_info, nullptr, &res->layout) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreatePipelineLayout failed";
+        return false;
+    }
+
+    const VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, kBufferBindings * kPipelineCount};
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = kPipelineCount;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(device.device, &pool_info, nullptr, &res->pool) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateDescriptorPool failed";
+        return false;
+    }
+    std::vector<VkDescriptorSetLayout> set_layouts(kPipelineCount, res->set_layout);
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = res->pool;
+    set_info.descriptorSetCount = kPipelineCount;
+    set_info.pSetLayouts = set_layouts.data();
+    if (vkAllocateDescriptorSets(device.device, &set_info, res->sets) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkAllocateDescriptorSets failed";
+        return false;
+    }
+    for (uint32_t i = 0; i < kPipelineCount; ++i) {
+        const VkDescriptorBufferInfo infos[kBufferBindings] = {
+            {res->inputs[0].buffer, 0, VK_WHOLE_SIZE},
+            {res->inputs[1].buffer, 0, VK_WHOLE_SIZE},
+            {res->outputs[i].buffer, 0, VK_WHOLE_SIZE},
+        };
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = res->sets[i];
+        write.descriptorCount = kBufferBindings;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = infos;
+        vkUpdateDescriptorSets(device.device, 1, &write, 0, nullptr);
+    }
+
+    if (!features::create_triangle_target(device, kTargetSize, kTargetSize, &res->target)) {
+        TEST_LOG_ERROR() << "✗ Creating the triangle target failed";
+        return false;
+    }
+    return true;
+}
+
+bool create_compute_pipelines(const features::Device& device, Resources* res) {
+    std::vector<VkComputePipelineCreateInfo> infos(kPipelineCount);
+    for (VkComputePipelineCreateInfo& info : infos) {
+        info = {};
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = res->shader;
+        info.stage.pName = "main";
+        info.layout = res->layout;
+        info.basePipelineIndex = -1;
+    }
+    VkComputePipelineCreateInfo* derived = infos.data() + kSeparateCount;
+    derived[0].flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+    derived[kDerivedCount - 1].flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+    derived[kDerivedCount - 1].basePipelineIndex = 0;
+
+    if (vkCreateComputePipelines(device.device, VK_NULL_HANDLE, kSeparateCount, infos.data(), nullptr,
+                                 res->pipelines) != VK_SUCCESS ||
+        vkCreateComputePipelines(device.device, VK_NULL_HANDLE, kDerivedCount, derived, nullptr,
+                                 res->pipelines + kSeparateCount) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateComputePipelines failed";
+        return false;
+    }
+    return true;
+}
+
+// Records every dispatch and the triangle into one command buffer, right
+// after the pipelines were created.
+bool record_and_submit(const features::Device& device, const Resources& res) {
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if (command_buffer == VK_NULL_HANDLE || vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        return false;
+    }
+    for (uint32_t i = 0; i < kPipelineCount; ++i) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, res.pipelines[i]);
+        vkCmdBindDescriptorSets(
+            command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, res.layout, 0, 1, &res.sets[i], 0, nullptr);
+        vkCmdDispatch(command_buffer, kElementCount / kWorkgroupSize, 1, 1);
+    }
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    features::cmd_begin_triangle_pass(command_buffer, res.target);
+    VkRect2D area = {};
+    area.extent = {kTargetSize, kTargetSize};
+    features::cmd_draw_triangle(command_buffer, res.target, area, res.triangle_pipeline);
+    features::cmd_end_triangle_pass(command_buffer, res.target);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Submitting the work failed";
+        return false;
+    }
+    return true;
+}
+
+bool check_results(const Resources& res) {
+    const float* a = static_cast<const float*>(res.inputs[0].mapped);
+    const float* b = static_cast<const float*>(res.inputs[1].mapped);
+    for (uint32_t i = 0; i < kPipelineCount; ++i) {
+        const float* result = static_cast<const float*>(res.outputs[i].mapped);
+        for (uint32_t j = 0; j < kElementCount; ++j) {
+            if (result[j] != a[j] + b[j]) {
+                TEST_LOG_ERROR() << "✗ Pipeline " << i << ": element " << j << " is " << result[j] << ", expected "
+                                 << a[j] + b[j];
+                return false;
+            }
+        }
+    }
+    const std::vector<uint8_t> pixels = features::read_pixels(res.target);
+    if (!features::pixel_lit(pixels, res.target, kTargetSize / 2, kTargetSize / 2)) {
+        TEST_LOG_ERROR() << "✗ The new graphics pipeline drew no triangle";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_deferred_pipeline_test() {
+    TEST_LOG_INFO() << "Deferred pipeline creation test";
+
+    features::Device device;
+    Resources res;
+    auto cleanup = [&]() {
+        destroy_resources(device, &res);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Deferred Pipeline Test", {}, &device) || !create_resources(device, &res)) {
+        cleanup();
+        return false;
+    }
+    // Nothing waits between creating the pipelines and submitting work that
+    // binds them.
+    if (!create_compute_pipelines(device, &res) ||
+        !features::create_triangle_pipeline(device, res.target, features::opaque_blend_state(),
+                                            &res.triangle_pipeline)) {
+        TEST_LOG_ERROR() << "✗ Creating the pipelines failed";
+        cleanup();
+        return false;
+    }
+    const bool passed = record_and_submit(device, res) && check_results(res);
+    cleanup();
+    if (passed) {
+        TEST_LOG_INFO() << "✅ " << kPipelineCount << " compute pipelines and a graphics pipeline"
+                        << " worked as soon as they were created";
+    }
+    return passed;
+}
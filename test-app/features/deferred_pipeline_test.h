@@ -0,0 +1,11 @@
+#ifndef VENUS_TEST_APP_DEFERRED_PIPELINE_TEST_H
+#define VENUS_TEST_APP_DEFERRED_PIPELINE_TEST_H
+
+// Creates compute pipelines in one call of a job each and in one call where
+// a pipeline derives from another by index, then a graphics pipeline, and
+// records and submits work with every one of them straight after creation,
+// while the server may still be compiling them. Checks each dispatch's
+// output and the drawn triangle.
+bool run_deferred_pipeline_test();
+
+#endif // VENUS_TEST_APP_DEFERRED_PIPELINE_TEST_H
@@ -0,0 +1,141 @@
+#include "descriptor_pool_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kPoolSets = 4;
+// Past the client's confirmation interval, so some allocations wait.
+constexpr uint32_t kLargePoolSets = 64;
+
+VkDescriptorPool create_pool(const features::Device& device, uint32_t sets) {
+    VkDescriptorPoolSize size = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, sets};
+    VkDescriptorPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.maxSets = sets;
+    info.poolSizeCount = 1;
+    info.pPoolSizes = &size;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    vkCreateDescriptorPool(device.device, &info, nullptr, &pool);
+    return pool;
+}
+
+// Allocates |count| sets of one uniform buffer each, one set per call.
+bool fill(const features::Device& device, VkDescriptorPool pool, VkDescriptorSetLayout layout, uint32_t count) {
+    VkDescriptorSetAllocateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.descriptorPool = pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &layout;
+    for (uint32_t i = 0; i < count; ++i) {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        const VkResult result = vkAllocateDescriptorSets(device.device, &info, &set);
+        if (result != VK_SUCCESS || set == VK_NULL_HANDLE) {
+            TEST_LOG_ERROR() << "✗ Allocation " << i + 1 << " of " << count << " failed: " << result;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_descriptor_pool_test() {
+    TEST_LOG_INFO() << "Descriptor pool budget test";
+
+    const char* local = std::getenv("VENUS_LOCAL_DESCRIPTOR_SETS");
+    if (local && (std::strcmp(local, "0") == 0 || std::strcmp(local, "off") == 0 || std::strcmp(local, "OFF") == 0)) {
+        TEST_LOG_INFO() << "  VENUS_LOCAL_DESCRIPTOR_SETS is off, skipping";
+        return true;
+    }
+
+    features::Device device;
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorPool large_pool = VK_NULL_HANDLE;
+    auto cleanup = [&]() {
+        if (pool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(device.device, pool, nullptr);
+        }
+        if (large_pool != VK_NULL_HANDLE) {
+            vkDestroyDescriptorPool(device.device, large_pool, nullptr);
+        }
+        if (layout != VK_NULL_HANDLE) {
+            vkDestroyDescriptorSetLayout(device.device, layout, nullptr);
+        }
+        features::destroy_device(&device);
+    };
+    venus_plus::ClientStats start = {};
+    if (!features::create_device("Descriptor Pool Test", {}, &device) ||
+        !features::get_client_stats(device, &start)) {
+        cleanup();
+        return false;
+    }
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    VkDescriptorSetLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device.device, &layout_info, nullptr, &layout) != VK_SUCCESS ||
+        (pool = create_pool(device, kPoolSets)) == VK_NULL_HANDLE ||
+        (large_pool = create_pool(device, kLargePoolSets)) == VK_NULL_HANDLE) {
+        TEST_LOG_ERROR() << "✗ Failed to create the descriptor set layout or pools";
+        cleanup();
+        return false;
+    }
+
+    if (!fill(device, pool, layout, kPoolSets)) {
+        cleanup();
+        return false;
+    }
+    VkDescriptorSetAllocateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.descriptorPool = pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &layout;
+    VkDescriptorSet extra = VK_NULL_HANDLE;
+    const VkResult refused = vkAllocateDescriptorSets(device.device, &info, &extra);
+    venus_plus::ClientStats full = {};
+    features::get_client_stats(device, &full);
+    if (refused != VK_ERROR_OUT_OF_POOL_MEMORY) {
+        TEST_LOG_ERROR() << "✗ Allocation past the pool's budget returned " << refused
+                         << " instead of VK_ERROR_OUT_OF_POOL_MEMORY";
+        cleanup();
+        return false;
+    }
+    if (full.descriptor_sets_local - start.descriptor_sets_local != kPoolSets ||
+        full.descriptor_pool_refusals - start.descriptor_pool_refusals != 1) {
+        TEST_LOG_ERROR() << "✗ Expected " << kPoolSets << " local allocations and 1 local refusal, got "
+                         << full.descriptor_sets_local - start.descriptor_sets_local << " and "
+                         << full.descriptor_pool_refusals - start.descriptor_pool_refusals;
+        cleanup();
+        return false;
+    }
+
+    // The reset frees the small pool's handles for reuse. Some of the large
+    // pool's allocations wait for the server, which would report any earlier
+    // one it refused, such as one given a handle still in use.
+    for (VkDescriptorPool reset : {pool, large_pool}) {
+        if (vkResetDescriptorPool(device.device, reset, 0) != VK_SUCCESS ||
+            !fill(device, large_pool, layout, kLargePoolSets)) {
+            TEST_LOG_ERROR() << "✗ Refilling the large pool failed";
+            cleanup();
+            return false;
+        }
+    }
+    venus_plus::ClientStats end = {};
+    features::get_client_stats(device, &end);
+    cleanup();
+
+    TEST_LOG_INFO() << "✅ Pool budget refused locally; " << end.descriptor_sets_local - start.descriptor_sets_local
+                    << " of " << kPoolSets + 2 * kLargePoolSets << " sets allocated without a round trip";
+    return true;
+}
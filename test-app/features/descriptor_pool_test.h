@@ -0,0 +1,10 @@
+#ifndef VENUS_TEST_APP_DESCRIPTOR_POOL_TEST_H
+#define VENUS_TEST_APP_DESCRIPTOR_POOL_TEST_H
+
+// Exhausts a small descriptor pool: the allocation past its budget must fail
+// with VK_ERROR_OUT_OF_POOL_MEMORY without asking the server. Then fills a
+// larger pool twice, reusing the freed set handles and passing the points
+// where the client waits on the server, and checks every allocation succeeds.
+bool run_descriptor_pool_test();
+
+#endif // VENUS_TEST_APP_DESCRIPTOR_POOL_TEST_H
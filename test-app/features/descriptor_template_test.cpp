@@ -0,0 +1,452 @@
+#include "descriptor_template_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+#include "phase09/shaders/simple_add_spirv.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kElementCount = 1024;
+constexpr uint32_t kWorkgroupSize = 256;
+constexpr VkDeviceSize kBufferSize = kElementCount * sizeof(float);
+// simple_add.comp reads bindings 0 and 1 and writes binding 2. Binding 3 is
+// a combined image sampler with an immutable sampler, which it does not read.
+constexpr uint32_t kBufferBindings = 3;
+constexpr uint32_t kSamplerBinding = 3;
+// Output k should come out as the sum of inputs k and k + 1.
+constexpr uint32_t kOutputCount = 3;
+constexpr uint32_t kInputCount = kOutputCount + 1;
+
+// Template data as an application might lay it out: the image first and the
+// buffer infos padded apart, so the ICD has to repack it.
+struct TemplateData {
+    VkDescriptorImageInfo image;
+    struct {
+        VkDescriptorBufferInfo info;
+        uint64_t padding;
+    } buffers[kBufferBindings];
+};
+
+struct Resources {
+    features::Buffer inputs[kInputCount];
+    features::Buffer outputs[kOutputCount];
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory image_memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkShaderModule shader = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate set_template = VK_NULL_HANDLE;
+    // Push descriptor variants, when the device supports them.
+    VkDescriptorSetLayout push_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout push_layout = VK_NULL_HANDLE;
+    VkPipeline push_pipeline = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate push_template = VK_NULL_HANDLE;
+};
+
+void destroy_resources(const features::Device& device, Resources* res) {
+    if (device.device == VK_NULL_HANDLE) {
+        return;
+    }
+    vkDestroyDescriptorUpdateTemplate(device.device, res->push_template, nullptr);
+    vkDestroyPipeline(device.device, res->push_pipeline, nullptr);
+    vkDestroyPipelineLayout(device.device, res->push_layout, nullptr);
+    vkDestroyDescriptorSetLayout(device.device, res->push_set_layout, nullptr);
+    vkDestroyDescriptorUpdateTemplate(device.device, res->set_template, nullptr);
+    vkDestroyDescriptorPool(device.device, res->pool, nullptr);
+    vkDestroyPipeline(device.device, res->pipeline, nullptr);
+    vkDestroyPipelineLayout(device.device, res->layout, nullptr);
+    vkDestroyDescriptorSetLayout(device.device, res->set_layout, nullptr);
+    vkDestroyShaderModule(device.device, res->shader, nullptr);
+    vkDestroySampler(device.device, res->sampler, nullptr);
+    vkDestroyImageView(device.device, res->view, nullptr);
+    vkDestroyImage(device.device, res->image, nullptr);
+    vkFreeMemory(device.device, res->image_memory, nullptr);
+    for (features::Buffer& buffer : res->inputs) {
+        features::destroy_buffer(device, &buffer);
+    }
+    for (features::Buffer& buffer : res->outputs) {
+        features::destroy_buffer(device, &buffer);
+    }
+}
+
+// A 1x1 image, never written or read, and the immutable sampler that goes
+// with it.
+bool create_sampled_image(const features::Device& device, Resources* res) {
+    VkImageCreateInfo image_info = {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.extent = {1, 1, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device.device, &image_info, nullptr, &res->image) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(device.device, res->image, &requirements);
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex = features::find_memory_type(device, requirements.memoryTypeBits, 0);
+    if (alloc_info.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(device.device, &alloc_info, nullptr, &res->image_memory) != VK_SUCCESS ||
+        vkBindImageMemory(device.device, res->image, res->image_memory, 0) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkImageViewCreateInfo view_info = {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = res->image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device.device, &view_info, nullptr, &res->view) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkSamplerCreateInfo sampler_info = {};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    return vkCreateSampler(device.device, &sampler_info, nullptr, &res->sampler) == VK_SUCCESS;
+}
+
+bool create_set_layout(const features::Device& device,
+                       VkSampler immutable_sampler,
+                       VkDescriptorSetLayoutCreateFlags flags,
+                       VkDescriptorSetLayout* layout) {
+    VkDescriptorSetLayoutBinding bindings[kBufferBindings + 1] = {};
+    for (uint32_t i = 0; i < kBufferBindings; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[kBufferBindings].binding = kSamplerBinding;
+    bindings[kBufferBindings].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[kBufferBindings].descriptorCount = 1;
+    bindings[kBufferBindings].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[kBufferBindings].pImmutableSamplers = &immutable_sampler;
+
+    VkDescriptorSetLayoutCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.flags = flags;
+    info.bindingCount = kBufferBindings + 1;
+    info.pBindings = bindings;
+    return vkCreateDescriptorSetLayout(device.device, &info, nullptr, layout) == VK_SUCCESS;
+}
+
+bool create_pipeline(const features::Device& device,
+                     VkShaderModule shader,
+                     VkDescriptorSetLayout set_layout,
+                     VkPipelineLayout* layout,
+                     VkPipeline* pipeline) {
+    VkPipelineLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 1;
+    layout_info.pSetLayouts = &set_layout;
+    if (vkCreatePipelineLayout(device.device, &layout_info, nullptr, layout) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipeline_info = {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = shader;
+    pipeline_info.stage.pName = "main";
+    pipeline_info.layout = *layout;
+    return vkCreateComputePipelines(device.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, pipeline) ==
+           VK_SUCCESS;
+}
+
+// Entries for TemplateData. The buffer entry runs over bindings 0 to 2.
+bool create_template(const features::Device& device,
+                     VkDescriptorUpdateTemplateType type,
+                     VkDescriptorSetLayout set_layout,
+                     VkPipelineLayout pipeline_layout,
+                     VkDescriptorUpdateTemplate* update_template) {
+    VkDescriptorUpdateTemplateEntry entries[2] = {};
+    entries[0].dstBinding = 0;
+    entries[0].descriptorCount = kBufferBindings;
+    entries[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    entries[0].offset = offsetof(TemplateData, buffers);
+    entries[0].stride = sizeof(TemplateData::buffers[0]);
+    entries[1].dstBinding = kSamplerBinding;
+    entries[1].descriptorCount = 1;
+    entries[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    entries[1].offset = offsetof(TemplateData, image);
+    entries[1].stride = sizeof(VkDescriptorImageInfo);
+
+    VkDescriptorUpdateTemplateCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    info.descriptorUpdateEntryCount = 2;
+    info.pDescriptorUpdateEntries = entries;
+    info.templateType = type;
+    info.descriptorSetLayout = set_layout;
+    info.pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+    info.pipelineLayout = pipeline_layout;
+    info.set = 0;
+    return vkCreateDescriptorUpdateTemplate(device.device, &info, nullptr, update_template) == VK_SUCCESS;
+}
+
+bool create_resources(const features::Device& device, bool push_descriptors, Resources* res) {
+    for (uint32_t i = 0; i < kInputCount; ++i) {
+        if (!features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &res->inputs[i])) {
+            return false;
+        }
+        float* values = static_cast<float*>(res->inputs[i].mapped);
+        for (uint32_t j = 0; j < kElementCount; ++j) {
+            values[j] = static_cast<float>(i * kElementCount + j);
+        }
+    }
+    for (features::Buffer& output : res->outputs) {
+        if (!features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &output)) {
+            return false;
+        }
+    }
+    if (!create_sampled_image(device, res)) {
+        TEST_LOG_ERROR() << "✗ Creating the sampled image failed";
+        return false;
+    }
+
+    VkShaderModuleCreateInfo shader_info = {};
+    shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_info.codeSize = sizeof(kSimpleAddSpirv);
+    shader_info.pCode = kSimpleAddSpirv;
+    if (vkCreateShaderModule(device.device, &shader_info, nullptr, &res->shader) != VK_SUCCESS ||
+        !create_set_layout(device, res->sampler, 0, &res->set_layout) ||
+        !create_pipeline(device, res->shader, res->set_layout, &res->layout, &res->pipeline) ||
+        !create_template(device,
+                         VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+                         res->set_layout,
+                         VK_NULL_HANDLE,
+                         &res->set_template)) {
+        TEST_LOG_ERROR() << "✗ Creating the pipeline or descriptor update template failed";
+        return false;
+    }
+
+    const VkDescriptorPoolSize pool_sizes[] = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, kBufferBindings},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
+    };
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+    if (vkCreateDescriptorPool(device.device, &pool_info, nullptr, &res->pool) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateDescriptorPool failed";
+        return false;
+    }
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = res->pool;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &res->set_layout;
+    if (vkAllocateDescriptorSets(device.device, &set_info, &res->set) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkAllocateDescriptorSets failed";
+        return false;
+    }
+
+    if (push_descriptors &&
+        (!create_set_layout(device,
+                            res->sampler,
+                            VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR,
+                            &res->push_set_layout) ||
+         !create_pipeline(device, res->shader, res->push_set_layout, &res->push_layout, &res->push_pipeline) ||
+         !create_template(device,
+                          VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR,
+                          res->push_set_layout,
+                          res->push_layout,
+                          &res->push_template))) {
+        TEST_LOG_ERROR() << "✗ Creating the push descriptor pipeline or template failed";
+        return false;
+    }
+    return true;
+}
+
+void fill_buffer_infos(const Resources& res, uint32_t output, VkDescriptorBufferInfo* infos) {
+    const VkBuffer buffers[kBufferBindings] = {
+        res.inputs[output].buffer, res.inputs[output + 1].buffer, res.outputs[output].buffer};
+    for (uint32_t i = 0; i < kBufferBindings; ++i) {
+        infos[i] = {buffers[i], 0, VK_WHOLE_SIZE};
+    }
+}
+
+// The sampler is garbage: the binding's sampler is immutable, so it must be
+// ignored.
+VkDescriptorImageInfo garbage_sampler_info(const Resources& res) {
+    VkDescriptorImageInfo info = {};
+    std::memset(&info.sampler, 0xcd, sizeof(info.sampler));
+    info.imageView = res.view;
+    info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    return info;
+}
+
+TemplateData template_data(const Resources& res, uint32_t output) {
+    TemplateData data;
+    std::memset(&data, 0xcd, sizeof(data));
+    data.image = garbage_sampler_info(res);
+    VkDescriptorBufferInfo infos[kBufferBindings];
+    fill_buffer_infos(res, output, infos);
+    for (uint32_t i = 0; i < kBufferBindings; ++i) {
+        data.buffers[i].info = infos[i];
+    }
+    return data;
+}
+
+// Binds |pipeline| and the descriptors |bind| records, dispatches over every
+// element, and checks output |output| holds the sum of its inputs.
+bool dispatch_and_check(const features::Device& device,
+                        const Resources& res,
+                        uint32_t output,
+                        VkPipeline pipeline,
+                        const char* path,
+                        const std::function<void(VkCommandBuffer)>& bind) {
+    float* result = static_cast<float*>(res.outputs[output].mapped);
+    std::fill(result, result + kElementCount, -1.0f);
+
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if (command_buffer == VK_NULL_HANDLE || vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        return false;
+    }
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    bind(command_buffer);
+    vkCmdDispatch(command_buffer, kElementCount / kWorkgroupSize, 1, 1);
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ " << path << ": submitting the dispatch failed";
+        return false;
+    }
+
+    const float* a = static_cast<const float*>(res.inputs[output].mapped);
+    const float* b = static_cast<const float*>(res.inputs[output + 1].mapped);
+    for (uint32_t i = 0; i < kElementCount; ++i) {
+        if (result[i] != a[i] + b[i]) {
+            TEST_LOG_ERROR() << "✗ " << path << ": element " << i << " is " << result[i] << ", expected "
+                             << a[i] + b[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_descriptor_template_test() {
+    TEST_LOG_INFO() << "Descriptor update template test";
+
+    uint32_t api_version = 0;
+    std::vector<std::string> extensions;
+    if (!features::query_physical_device(&api_version, &extensions)) {
+        return false;
+    }
+    const bool push_descriptors = std::find(extensions.begin(), extensions.end(),
+                                            VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) != extensions.end();
+    features::DeviceOptions options;
+    if (push_descriptors) {
+        options.extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    }
+
+    features::Device device;
+    Resources res;
+    auto cleanup = [&]() {
+        destroy_resources(device, &res);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Descriptor Template Test", options, &device) ||
+        !create_resources(device, push_descriptors, &res)) {
+        cleanup();
+        return false;
+    }
+
+    const TemplateData set_data = template_data(res, 0);
+    vkUpdateDescriptorSetWithTemplate(device.device, res.set, res.set_template, &set_data);
+    bool passed = dispatch_and_check(device, res, 0, res.pipeline, "Set template", [&](VkCommandBuffer cb) {
+        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, res.layout, 0, 1, &res.set, 0, nullptr);
+    });
+
+    if (passed && push_descriptors) {
+        auto push_set = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+            vkGetDeviceProcAddr(device.device, "vkCmdPushDescriptorSetKHR"));
+        auto push_with_template = reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+            vkGetDeviceProcAddr(device.device, "vkCmdPushDescriptorSetWithTemplateKHR"));
+        if (!push_set || !push_with_template) {
+            TEST_LOG_ERROR() << "✗ Push descriptor entry points missing";
+            passed = false;
+        } else {
+            passed = dispatch_and_check(device, res, 1, res.push_pipeline, "vkCmdPushDescriptorSetKHR",
+                                        [&](VkCommandBuffer cb) {
+                VkDescriptorBufferInfo buffer_infos[kBufferBindings];
+                fill_buffer_infos(res, 1, buffer_infos);
+                const VkDescriptorImageInfo image_info = garbage_sampler_info(res);
+                VkWriteDescriptorSet writes[2] = {};
+                writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[0].dstBinding = 0;
+                writes[0].descriptorCount = kBufferBindings;
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[0].pBufferInfo = buffer_infos;
+                writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[1].dstBinding = kSamplerBinding;
+                writes[1].descriptorCount = 1;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[1].pImageInfo = &image_info;
+                push_set(cb, VK_PIPELINE_BIND_POINT_COMPUTE, res.push_layout, 0, 2, writes);
+            }) && dispatch_and_check(device, res, 2, res.push_pipeline, "Push descriptor template",
+                                     [&](VkCommandBuffer cb) {
+                const TemplateData push_data = template_data(res, 2);
+                push_with_template(cb, res.push_template, res.push_layout, 0, &push_data);
+            });
+        }
+    } else if (passed) {
+        TEST_LOG_INFO() << "  Device lacks " << VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME
+                        << ", checking the set template only";
+    }
+
+    cleanup();
+    if (passed) {
+        TEST_LOG_INFO() << "✅ Templates" << (push_descriptors ? " and push descriptors" : "")
+                        << " bind what the dispatch reads, ignoring garbage immutable-sampler handles";
+    }
+    return passed;
+}
@@ -0,0 +1,12 @@
+#ifndef VENUS_TEST_APP_DESCRIPTOR_TEMPLATE_TEST_H
+#define VENUS_TEST_APP_DESCRIPTOR_TEMPLATE_TEST_H
+
+// Binds the storage buffers of a compute dispatch through a descriptor
+// update template, and, where VK_KHR_push_descriptor is supported, through
+// vkCmdPushDescriptorSetKHR and a push descriptor template. Each layout also
+// has a combined image sampler binding with an immutable sampler, written
+// with a garbage sampler the ICD and server must ignore. Checks every
+// dispatch's output.
+bool run_descriptor_template_test();
+
+#endif // VENUS_TEST_APP_DESCRIPTOR_TEMPLATE_TEST_H
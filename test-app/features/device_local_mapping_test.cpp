@@ -0,0 +1,176 @@
+#include "device_local_mapping_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr VkDeviceSize kSize = 64 * 1024;
+constexpr uint32_t kFillValue = 0x5a5a5a5au;
+
+constexpr VkMemoryPropertyFlags kStagedFlags =
+    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+// Whether the ICD reports staged copies: it does for every device-local type
+// the host cannot reach that is neither lazily allocated nor protected.
+bool has_staged_types(const features::Device& device) {
+    const VkMemoryPropertyFlags excluded = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                           VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT |
+                                           VK_MEMORY_PROPERTY_PROTECTED_BIT;
+    for (uint32_t i = 0; i < device.memory_properties.memoryTypeCount; ++i) {
+        const VkMemoryPropertyFlags flags = device.memory_properties.memoryTypes[i].propertyFlags;
+        if ((flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) && !(flags & excluded)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The last type in |type_bits| with exactly the staged flags. The ICD puts
+// each staged copy after every type whose flags it includes, so a GPU's own
+// DEVICE_LOCAL | HOST_VISIBLE | HOST_COHERENT type comes before it; the
+// staged transfer counter confirms the pick.
+uint32_t find_staged_type(const features::Device& device, uint32_t type_bits) {
+    uint32_t found = UINT32_MAX;
+    for (uint32_t i = 0; i < device.memory_properties.memoryTypeCount; ++i) {
+        if ((type_bits & (1u << i)) && device.memory_properties.memoryTypes[i].propertyFlags == kStagedFlags) {
+            found = i;
+        }
+    }
+    return found;
+}
+
+bool round_trip(const features::Device& device, bool dedicated) {
+    const char* kind = dedicated ? "dedicated" : "plain";
+    venus_plus::ClientStats before = {};
+    if (!features::get_client_stats(device, &before)) {
+        TEST_LOG_ERROR() << "✗ Client stats unavailable";
+        return false;
+    }
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = kSize;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    features::Buffer local;
+    features::Buffer readback;
+    auto cleanup = [&]() {
+        features::destroy_buffer(device, &local);
+        features::destroy_buffer(device, &readback);
+    };
+    if (vkCreateBuffer(device.device, &buffer_info, nullptr, &local.buffer) != VK_SUCCESS ||
+        !features::create_host_buffer(device, kSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &readback)) {
+        TEST_LOG_ERROR() << "✗ Buffer creation failed";
+        cleanup();
+        return false;
+    }
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(device.device, local.buffer, &requirements);
+    VkMemoryDedicatedAllocateInfo dedicated_info = {};
+    dedicated_info.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicated_info.buffer = local.buffer;
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = dedicated ? &dedicated_info : nullptr;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex = find_staged_type(device, requirements.memoryTypeBits);
+    if (alloc_info.memoryTypeIndex == UINT32_MAX) {
+        TEST_LOG_ERROR() << "✗ No staged device-local memory type offered for a buffer";
+        cleanup();
+        return false;
+    }
+    if (vkAllocateMemory(device.device, &alloc_info, nullptr, &local.memory) != VK_SUCCESS ||
+        vkBindBufferMemory(device.device, local.buffer, local.memory, 0) != VK_SUCCESS ||
+        vkMapMemory(device.device, local.memory, 0, VK_WHOLE_SIZE, 0, &local.mapped) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Mapping " << kind << " memory of type " << alloc_info.memoryTypeIndex << " failed";
+        cleanup();
+        return false;
+    }
+
+    // Host to device: the copy sees what was written through the mapping.
+    uint8_t* bytes = static_cast<uint8_t*>(local.mapped);
+    for (VkDeviceSize i = 0; i < kSize; ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    VkBufferCopy region = {0, 0, kSize};
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    vkCmdCopyBuffer(command_buffer, local.buffer, readback.buffer, 1, &region);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Copying out of " << kind << " device-local memory failed";
+        cleanup();
+        return false;
+    }
+    const uint8_t* copied = static_cast<const uint8_t*>(readback.mapped);
+    for (VkDeviceSize i = 0; i < kSize; ++i) {
+        if (copied[i] != static_cast<uint8_t>(i * 7 + 3)) {
+            TEST_LOG_ERROR() << "✗ GPU read byte " << i << " of " << kind
+                             << " device-local memory differs from what was written";
+            cleanup();
+            return false;
+        }
+    }
+
+    // Device to host: the mapping sees what the GPU wrote.
+    vkResetCommandBuffer(command_buffer, 0);
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    vkCmdFillBuffer(command_buffer, local.buffer, 0, kSize, kFillValue);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Filling " << kind << " device-local memory failed";
+        cleanup();
+        return false;
+    }
+    const uint32_t* words = static_cast<const uint32_t*>(local.mapped);
+    for (VkDeviceSize i = 0; i < kSize / sizeof(uint32_t); ++i) {
+        if (words[i] != kFillValue) {
+            TEST_LOG_ERROR() << "✗ Mapped word " << i << " of " << kind
+                             << " device-local memory misses what the GPU wrote";
+            cleanup();
+            return false;
+        }
+    }
+    cleanup();
+
+    venus_plus::ClientStats after = {};
+    if (!features::get_client_stats(device, &after) || after.staged_memory_transfers <= before.staged_memory_transfers) {
+        TEST_LOG_ERROR() << "✗ Memory type " << alloc_info.memoryTypeIndex << " of the " << kind
+                         << " allocation was not staged by the server";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_device_local_mapping_test() {
+    TEST_LOG_INFO() << "Device-local mapping test";
+
+    const char* mapping = std::getenv("VENUS_DEVICE_LOCAL_MAPPING");
+    if (mapping &&
+        (std::strcmp(mapping, "0") == 0 || std::strcmp(mapping, "off") == 0 || std::strcmp(mapping, "OFF") == 0)) {
+        TEST_LOG_INFO() << "  VENUS_DEVICE_LOCAL_MAPPING is off, skipping";
+        return true;
+    }
+
+    features::Device device;
+    if (!features::create_device("Device Local Mapping Test", {}, &device)) {
+        return false;
+    }
+    if (!has_staged_types(device)) {
+        TEST_LOG_INFO() << "  Every device-local memory type is host-visible already, no staged types; skipping";
+        features::destroy_device(&device);
+        return true;
+    }
+    const bool passed = round_trip(device, false) && round_trip(device, true);
+    features::destroy_device(&device);
+    if (passed) {
+        TEST_LOG_INFO() << "✅ Device-local memory maps, writes and reads back, plain and dedicated";
+    }
+    return passed;
+}
@@ -0,0 +1,11 @@
+#ifndef VENUS_TEST_APP_DEVICE_LOCAL_MAPPING_TEST_H
+#define VENUS_TEST_APP_DEVICE_LOCAL_MAPPING_TEST_H
+
+// Maps memory of a staged type, the copy the ICD reports of device-local
+// memory the host cannot reach: writes through the mapping and checks the GPU
+// reads it, then has the GPU fill the buffer and checks the mapping reads that
+// back, and that the client counted staged transfers. Runs once with a plain
+// and once with a dedicated allocation; skipped on GPUs without such memory.
+bool run_device_local_mapping_test();
+
+#endif // VENUS_TEST_APP_DEVICE_LOCAL_MAPPING_TEST_H
@@ -0,0 +1,566 @@
+#include "feature_harness.h"
+
+#include "logging.h"
+#include "phase10/shaders/triangle_spirv.h"
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace features {
+
+namespace {
+
+struct Vertex {
+    float position[2];
+    float color[3];
+};
+
+const std::array<Vertex, 3> kVertices = {{
+    {{0.0f, -0.6f}, {1.0f, 0.0f, 0.0f}},
+    {{0.6f, 0.6f}, {0.0f, 1.0f, 0.0f}},
+    {{-0.6f, 0.6f}, {0.0f, 0.0f, 1.0f}},
+}};
+
+bool create_image(const Device& device, TriangleTarget* target) {
+    VkImageCreateInfo image_info = {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.extent = {target->width, target->height, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device.device, &image_info, nullptr, &target->image) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(device.device, target->image, &requirements);
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex =
+        find_memory_type(device, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (alloc_info.memoryTypeIndex == UINT32_MAX) {
+        alloc_info.memoryTypeIndex = find_memory_type(device, requirements.memoryTypeBits, 0);
+    }
+    if (alloc_info.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(device.device, &alloc_info, nullptr, &target->image_memory) != VK_SUCCESS ||
+        vkBindImageMemory(device.device, target->image, target->image_memory, 0) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkImageViewCreateInfo view_info = {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = target->image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+    return vkCreateImageView(device.device, &view_info, nullptr, &target->view) == VK_SUCCESS;
+}
+
+bool create_render_pass(const Device& device, TriangleTarget* target) {
+    VkAttachmentDescription color_attachment = {};
+    color_attachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    color_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference color_ref = {};
+    color_ref.attachment = 0;
+    color_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color_ref;
+
+    VkRenderPassCreateInfo rp_info = {};
+    rp_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    rp_info.attachmentCount = 1;
+    rp_info.pAttachments = &color_attachment;
+    rp_info.subpassCount = 1;
+    rp_info.pSubpasses = &subpass;
+    if (vkCreateRenderPass(device.device, &rp_info, nullptr, &target->render_pass) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkFramebufferCreateInfo fb_info = {};
+    fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fb_info.renderPass = target->render_pass;
+    fb_info.attachmentCount = 1;
+    fb_info.pAttachments = &target->view;
+    fb_info.width = target->width;
+    fb_info.height = target->height;
+    fb_info.layers = 1;
+    return vkCreateFramebuffer(device.device, &fb_info, nullptr, &target->framebuffer) == VK_SUCCESS;
+}
+
+bool create_pipeline(const Device& device, const std::vector<uint32_t>* vertex_spirv, TriangleTarget* target) {
+    VkShaderModuleCreateInfo shader_info = {};
+    shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_info.codeSize = vertex_spirv ? vertex_spirv->size() * sizeof(uint32_t) : sizeof(kVertexShaderSpv);
+    shader_info.pCode = vertex_spirv ? vertex_spirv->data() : kVertexShaderSpv;
+    if (vkCreateShaderModule(device.device, &shader_info, nullptr, &target->vertex_shader) != VK_SUCCESS) {
+        return false;
+    }
+    shader_info.codeSize = sizeof(kFragmentShaderSpv);
+    shader_info.pCode = kFragmentShaderSpv;
+    if (vkCreateShaderModule(device.device, &shader_info, nullptr, &target->fragment_shader) != VK_SUCCESS) {
+        return false;
+    }
+
+    VkPipelineLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    if (vkCreatePipelineLayout(device.device, &layout_info, nullptr, &target->layout) != VK_SUCCESS) {
+        return false;
+    }
+
+    return create_triangle_pipeline(device, *target, opaque_blend_state(), &target->pipeline);
+}
+
+} // namespace
+
+VkPipelineColorBlendAttachmentState opaque_blend_state() {
+    VkPipelineColorBlendAttachmentState blend = {};
+    blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+                           VK_COLOR_COMPONENT_A_BIT;
+    return blend;
+}
+
+bool create_triangle_pipeline(const Device& device,
+                              const TriangleTarget& target,
+                              const VkPipelineColorBlendAttachmentState& blend,
+                              VkPipeline* pipeline) {
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = target.vertex_shader;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = target.fragment_shader;
+    stages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding = {};
+    binding.binding = 0;
+    binding.stride = sizeof(Vertex);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription attribs[2] = {};
+    attribs[0].location = 0;
+    attribs[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attribs[0].offset = offsetof(Vertex, position);
+    attribs[1].location = 1;
+    attribs[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attribs[1].offset = offsetof(Vertex, color);
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = 2;
+    vertex_input.pVertexAttributeDescriptions = attribs;
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewport_state = {};
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo raster = {};
+    raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    raster.polygonMode = VK_POLYGON_MODE_FILL;
+    raster.cullMode = VK_CULL_MODE_NONE;
+    raster.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    raster.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendStateCreateInfo color_blend = {};
+    color_blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blend.attachmentCount = 1;
+    color_blend.pAttachments = &blend;
+
+    const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic_state = {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkGraphicsPipelineCreateInfo pipeline_info = {};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.stageCount = 2;
+    pipeline_info.pStages = stages;
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &raster;
+    pipeline_info.pMultisampleState = &multisample;
+    pipeline_info.pColorBlendState = &color_blend;
+    pipeline_info.pDynamicState = &dynamic_state;
+    pipeline_info.layout = target.layout;
+    pipeline_info.renderPass = target.render_pass;
+    return vkCreateGraphicsPipelines(device.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, pipeline) ==
+           VK_SUCCESS;
+}
+
+
+bool query_physical_device(uint32_t* api_version,
+                           std::vector<std::string>* extensions,
+                           VkPhysicalDeviceFeatures* features) {
+    VkApplicationInfo app_info = {};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "Feature Query";
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+    VkInstance instance = VK_NULL_HANDLE;
+    if (vkCreateInstance(&instance_info, nullptr, &instance) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateInstance failed";
+        return false;
+    }
+
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    uint32_t phys_count = 1;
+    vkEnumeratePhysicalDevices(instance, &phys_count, &physical_device);
+    if (physical_device == VK_NULL_HANDLE) {
+        TEST_LOG_ERROR() << "✗ No physical devices available";
+        vkDestroyInstance(instance, nullptr);
+        return false;
+    }
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    *api_version = properties.apiVersion;
+    if (features) {
+        vkGetPhysicalDeviceFeatures(physical_device, features);
+    }
+
+    uint32_t count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> available(count);
+    vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &count, available.data());
+    extensions->clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        extensions->push_back(available[i].extensionName);
+    }
+    vkDestroyInstance(instance, nullptr);
+    return true;
+}
+
+bool create_device(const char* name, const DeviceOptions& options, Device* out) {
+    *out = Device();
+
+    VkApplicationInfo app_info = {};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = name;
+    app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.pEngineName = "VenusPlus";
+    app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = options.api_version;
+
+    VkInstanceCreateInfo instance_info = {};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+    if (vkCreateInstance(&instance_info, nullptr, &out->instance) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateInstance failed";
+        return false;
+    }
+
+    uint32_t phys_count = 1;
+    vkEnumeratePhysicalDevices(out->instance, &phys_count, &out->physical_device);
+    if (out->physical_device == VK_NULL_HANDLE) {
+        TEST_LOG_ERROR() << "✗ No physical devices available";
+        destroy_device(out);
+        return false;
+    }
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(out->physical_device, &properties);
+    out->api_version = properties.apiVersion;
+    vkGetPhysicalDeviceMemoryProperties(out->physical_device, &out->memory_properties);
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info = {};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = 0;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &queue_priority;
+
+    VkDeviceCreateInfo device_info = {};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.pNext = options.next;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    device_info.enabledExtensionCount = static_cast<uint32_t>(options.extensions.size());
+    device_info.ppEnabledExtensionNames = options.extensions.empty() ? nullptr : options.extensions.data();
+    if (vkCreateDevice(out->physical_device, &device_info, nullptr, &out->device) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateDevice failed";
+        destroy_device(out);
+        return false;
+    }
+    vkGetDeviceQueue(out->device, 0, 0, &out->queue);
+
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = 0;
+    if (vkCreateCommandPool(out->device, &pool_info, nullptr, &out->pool) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateCommandPool failed";
+        destroy_device(out);
+        return false;
+    }
+    return true;
+}
+
+void destroy_device(Device* device) {
+    if (device->pool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device->device, device->pool, nullptr);
+    }
+    if (device->device != VK_NULL_HANDLE) {
+        vkDestroyDevice(device->device, nullptr);
+    }
+    if (device->instance != VK_NULL_HANDLE) {
+        vkDestroyInstance(device->instance, nullptr);
+    }
+    *device = Device();
+}
+
+uint32_t find_memory_type(const Device& device, uint32_t type_bits, VkMemoryPropertyFlags flags) {
+    const VkPhysicalDeviceMemoryProperties& props = device.memory_properties;
+    for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+        if ((type_bits & (1u << i)) && (props.memoryTypes[i].propertyFlags & flags) == flags) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+bool create_host_buffer(const Device& device, VkDeviceSize size, VkBufferUsageFlags usage, Buffer* out) {
+    *out = Buffer();
+    out->size = size;
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device.device, &buffer_info, nullptr, &out->buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateBuffer failed";
+        return false;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(device.device, out->buffer, &requirements);
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex =
+        find_memory_type(device,
+                         requirements.memoryTypeBits,
+                         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (alloc_info.memoryTypeIndex == UINT32_MAX ||
+        vkAllocateMemory(device.device, &alloc_info, nullptr, &out->memory) != VK_SUCCESS ||
+        vkBindBufferMemory(device.device, out->buffer, out->memory, 0) != VK_SUCCESS ||
+        vkMapMemory(device.device, out->memory, 0, VK_WHOLE_SIZE, 0, &out->mapped) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Host-visible buffer memory setup failed";
+        return false;
+    }
+    return true;
+}
+
+void destroy_buffer(const Device& device, Buffer* buffer) {
+    if (buffer->buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device.device, buffer->buffer, nullptr);
+    }
+    if (buffer->memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device.device, buffer->memory, nullptr);
+    }
+    *buffer = Buffer();
+}
+
+VkCommandBuffer allocate_command_buffer(const Device& device, VkCommandBufferLevel level) {
+    VkCommandBufferAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = device.pool;
+    alloc_info.level = level;
+    alloc_info.commandBufferCount = 1;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(device.device, &alloc_info, &command_buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkAllocateCommandBuffers failed";
+        return VK_NULL_HANDLE;
+    }
+    return command_buffer;
+}
+
+bool submit_and_wait(const Device& device, VkCommandBuffer command_buffer) {
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkFence fence = VK_NULL_HANDLE;
+    if (vkCreateFence(device.device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateFence failed";
+        return false;
+    }
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer;
+    VkResult result = vkQueueSubmit(device.queue, 1, &submit_info, fence);
+    if (result == VK_SUCCESS) {
+        result = vkWaitForFences(device.device, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    vkDestroyFence(device.device, fence, nullptr);
+    if (result != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Submit failed: " << result;
+        return false;
+    }
+    return true;
+}
+
+bool get_client_stats(const Device& device, venus_plus::ClientStats* stats) {
+    auto get_stats = reinterpret_cast<venus_plus::PFN_vkGetClientStatsVENUSPLUS>(
+        vkGetDeviceProcAddr(device.device, venus_plus::kGetClientStatsName));
+    if (!get_stats) {
+        TEST_LOG_ERROR() << "✗ " << venus_plus::kGetClientStatsName << " is not available";
+        return false;
+    }
+    get_stats(device.device, stats);
+    return true;
+}
+
+bool create_triangle_target(const Device& device,
+                            uint32_t width,
+                            uint32_t height,
+                            TriangleTarget* out,
+                            const std::vector<uint32_t>* vertex_spirv) {
+    *out = TriangleTarget();
+    out->width = width;
+    out->height = height;
+    if (!create_image(device, out) || !create_render_pass(device, out) ||
+        !create_pipeline(device, vertex_spirv, out)) {
+        TEST_LOG_ERROR() << "✗ Triangle target setup failed";
+        return false;
+    }
+    if (!create_host_buffer(device, sizeof(kVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &out->vertices) ||
+        !create_host_buffer(device,
+                            static_cast<VkDeviceSize>(width) * height * 4u,
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                            &out->readback)) {
+        return false;
+    }
+    std::memcpy(out->vertices.mapped, kVertices.data(), sizeof(kVertices));
+    return true;
+}
+
+void destroy_triangle_target(const Device& device, TriangleTarget* target) {
+    destroy_buffer(device, &target->readback);
+    destroy_buffer(device, &target->vertices);
+    if (target->pipeline) vkDestroyPipeline(device.device, target->pipeline, nullptr);
+    if (target->layout) vkDestroyPipelineLayout(device.device, target->layout, nullptr);
+    if (target->fragment_shader) vkDestroyShaderModule(device.device, target->fragment_shader, nullptr);
+    if (target->vertex_shader) vkDestroyShaderModule(device.device, target->vertex_shader, nullptr);
+    if (target->framebuffer) vkDestroyFramebuffer(device.device, target->framebuffer, nullptr);
+    if (target->render_pass) vkDestroyRenderPass(device.device, target->render_pass, nullptr);
+    if (target->view) vkDestroyImageView(device.device, target->view, nullptr);
+    if (target->image) vkDestroyImage(device.device, target->image, nullptr);
+    if (target->image_memory) vkFreeMemory(device.device, target->image_memory, nullptr);
+    *target = TriangleTarget();
+}
+
+void cmd_begin_triangle_pass(VkCommandBuffer command_buffer, const TriangleTarget& target) {
+    VkClearValue clear_color = {};
+    clear_color.color = {{0.05f, 0.05f, 0.05f, 1.0f}};
+
+    VkRenderPassBeginInfo rp_begin = {};
+    rp_begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    rp_begin.renderPass = target.render_pass;
+    rp_begin.framebuffer = target.framebuffer;
+    rp_begin.renderArea.extent = {target.width, target.height};
+    rp_begin.clearValueCount = 1;
+    rp_begin.pClearValues = &clear_color;
+    vkCmdBeginRenderPass(command_buffer, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void cmd_end_triangle_pass(VkCommandBuffer command_buffer, const TriangleTarget& target) {
+    vkCmdEndRenderPass(command_buffer);
+
+    VkBufferImageCopy copy_region = {};
+    copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy_region.imageSubresource.layerCount = 1;
+    copy_region.imageExtent = {target.width, target.height, 1};
+    vkCmdCopyImageToBuffer(command_buffer,
+                           target.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           target.readback.buffer,
+                           1,
+                           &copy_region);
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = target.readback.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         0, nullptr,
+                         1, &barrier,
+                         0, nullptr);
+}
+
+void cmd_draw_triangle(VkCommandBuffer command_buffer,
+                       const TriangleTarget& target,
+                       const VkRect2D& area,
+                       VkPipeline pipeline) {
+    VkViewport viewport = {};
+    viewport.x = static_cast<float>(area.offset.x);
+    viewport.y = static_cast<float>(area.offset.y);
+    viewport.width = static_cast<float>(area.extent.width);
+    viewport.height = static_cast<float>(area.extent.height);
+    viewport.maxDepth = 1.0f;
+    const VkDeviceSize offset = 0;
+    vkCmdBindPipeline(command_buffer,
+                      VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      pipeline != VK_NULL_HANDLE ? pipeline : target.pipeline);
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, &target.vertices.buffer, &offset);
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &area);
+    vkCmdDraw(command_buffer, static_cast<uint32_t>(kVertices.size()), 1, 0, 0);
+}
+
+std::vector<uint8_t> read_pixels(const TriangleTarget& target) {
+    const uint8_t* data = static_cast<const uint8_t*>(target.readback.mapped);
+    return std::vector<uint8_t>(data, data + target.readback.size);
+}
+
+bool pixel_lit(const std::vector<uint8_t>& pixels, const TriangleTarget& target, uint32_t x, uint32_t y) {
+    const size_t offset = (static_cast<size_t>(y) * target.width + x) * 4;
+    if (offset + 4 > pixels.size()) {
+        return false;
+    }
+    const uint8_t* pixel = pixels.data() + offset;
+    return pixel[0] >= 32 || pixel[1] >= 32 || pixel[2] >= 32;
+}
+
+} // namespace features
@@ -0,0 +1,116 @@
+#ifndef VENUS_TEST_APP_FEATURE_HARNESS_H
+#define VENUS_TEST_APP_FEATURE_HARNESS_H
+
+#include "protocol/client_stats.h"
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scaffolding shared by the feature tests: each test checks one client or
+// server optimization in isolation, on its own instance and device.
+namespace features {
+
+struct DeviceOptions {
+    uint32_t api_version = VK_API_VERSION_1_1;
+    std::vector<const char*> extensions;
+    // Chained into VkDeviceCreateInfo::pNext (feature structs).
+    const void* next = nullptr;
+};
+
+// One device with one queue of family 0, and a resettable command pool.
+struct Device {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool pool = VK_NULL_HANDLE;
+    uint32_t api_version = 0; // of the physical device
+    VkPhysicalDeviceMemoryProperties memory_properties = {};
+};
+
+// The first physical device's API version, extensions and, when |features|
+// is given, core features, read through a throwaway instance, for tests that
+// enable what the device supports.
+bool query_physical_device(uint32_t* api_version,
+                           std::vector<std::string>* extensions,
+                           VkPhysicalDeviceFeatures* features = nullptr);
+
+bool create_device(const char* name, const DeviceOptions& options, Device* out);
+void destroy_device(Device* device);
+
+uint32_t find_memory_type(const Device& device, uint32_t type_bits, VkMemoryPropertyFlags flags);
+
+// A buffer in host-visible, host-coherent memory, mapped for its lifetime.
+struct Buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void* mapped = nullptr;
+    VkDeviceSize size = 0;
+};
+
+bool create_host_buffer(const Device& device, VkDeviceSize size, VkBufferUsageFlags usage, Buffer* out);
+void destroy_buffer(const Device& device, Buffer* buffer);
+
+VkCommandBuffer allocate_command_buffer(const Device& device, VkCommandBufferLevel level);
+bool submit_and_wait(const Device& device, VkCommandBuffer command_buffer);
+
+// The ICD's counters; false when the driver is not the Venus Plus ICD.
+bool get_client_stats(const Device& device, venus_plus::ClientStats* stats);
+
+// An RGBA8 color target with a one-subpass render pass that clears it and
+// leaves it in TRANSFER_SRC_OPTIMAL, and the triangle pipeline of phase 10
+// with dynamic viewport and scissor.
+struct TriangleTarget {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory image_memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkShaderModule vertex_shader = VK_NULL_HANDLE;
+    VkShaderModule fragment_shader = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    Buffer vertices;
+    Buffer readback;
+};
+
+// |vertex_spirv|, when given, replaces the triangle's vertex shader and must
+// have the same interface.
+bool create_triangle_target(const Device& device,
+                            uint32_t width,
+                            uint32_t height,
+                            TriangleTarget* out,
+                            const std::vector<uint32_t>* vertex_spirv = nullptr);
+void destroy_triangle_target(const Device& device, TriangleTarget* target);
+
+// Writes all channels without blending, as the target's own pipeline does.
+VkPipelineColorBlendAttachmentState opaque_blend_state();
+// Another pipeline for |target|'s shaders, layout and render pass, differing
+// only in |blend|.
+bool create_triangle_pipeline(const Device& device,
+                              const TriangleTarget& target,
+                              const VkPipelineColorBlendAttachmentState& blend,
+                              VkPipeline* pipeline);
+
+// Begins the render pass (inline contents) on a dark clear color, and ends it
+// with a copy of the image into the readback buffer.
+void cmd_begin_triangle_pass(VkCommandBuffer command_buffer, const TriangleTarget& target);
+void cmd_end_triangle_pass(VkCommandBuffer command_buffer, const TriangleTarget& target);
+// Binds the pipeline (|pipeline|, when given, instead of the target's) and
+// vertices and draws the triangle into |area|.
+void cmd_draw_triangle(VkCommandBuffer command_buffer,
+                       const TriangleTarget& target,
+                       const VkRect2D& area,
+                       VkPipeline pipeline = VK_NULL_HANDLE);
+
+std::vector<uint8_t> read_pixels(const TriangleTarget& target);
+// True when the pixel is brighter than the clear color.
+bool pixel_lit(const std::vector<uint8_t>& pixels, const TriangleTarget& target, uint32_t x, uint32_t y);
+
+} // namespace features
+
+#endif // VENUS_TEST_APP_FEATURE_HARNESS_H
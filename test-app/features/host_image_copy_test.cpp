@@ -0,0 +1,286 @@
+#include "host_image_copy_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kWidth = 64;
+constexpr uint32_t kHeight = 32;
+
+struct TextureFormat {
+    const char* name;
+    VkFormat format;
+    uint32_t block_size;   // bytes
+    uint32_t block_extent; // texels per block side
+};
+
+struct HostCopy {
+    PFN_vkTransitionImageLayoutEXT transition = nullptr;
+    PFN_vkCopyMemoryToImageEXT to_image = nullptr;
+    PFN_vkCopyImageToMemoryEXT to_memory = nullptr;
+};
+
+// Host memory holding |width| x |height| texels in rows |row_length| texels
+// apart, all in blocks of |format|.
+struct HostTexels {
+    const TextureFormat* format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t row_length;
+    std::vector<uint8_t> bytes;
+
+    HostTexels(const TextureFormat& texture_format, uint32_t w, uint32_t h, uint32_t row)
+        : format(&texture_format),
+          width(w),
+          height(h),
+          row_length(row),
+          bytes(static_cast<size_t>(row_pitch()) * block_rows(), 0) {}
+
+    uint32_t row_pitch() const { return row_length / format->block_extent * format->block_size; }
+    uint32_t row_bytes() const { return width / format->block_extent * format->block_size; }
+    uint32_t block_rows() const { return height / format->block_extent; }
+    uint8_t* row(uint32_t block_row) { return bytes.data() + static_cast<size_t>(block_row) * row_pitch(); }
+    const uint8_t* row(uint32_t block_row) const {
+        return bytes.data() + static_cast<size_t>(block_row) * row_pitch();
+    }
+};
+
+VkImageSubresourceLayers color_layers() {
+    VkImageSubresourceLayers layers = {};
+    layers.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    layers.layerCount = 1;
+    return layers;
+}
+
+bool supports_host_copy(const features::Device& device, const TextureFormat& format) {
+    VkPhysicalDeviceImageFormatInfo2 info = {};
+    info.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2;
+    info.format = format.format;
+    info.type = VK_IMAGE_TYPE_2D;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImageFormatProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2;
+    return vkGetPhysicalDeviceImageFormatProperties2(device.physical_device, &info, &properties) == VK_SUCCESS;
+}
+
+// Reads |expected|'s rectangle back from the image at |offset| into memory
+// with its own row length, and compares the texels, not the row padding.
+bool read_back(const features::Device& device,
+               const HostCopy& copy,
+               VkImage image,
+               const HostTexels& expected,
+               uint32_t x,
+               uint32_t y,
+               uint32_t row_length) {
+    HostTexels actual(*expected.format, expected.width, expected.height, row_length);
+    VkImageToMemoryCopyEXT region = {};
+    region.sType = VK_STRUCTURE_TYPE_IMAGE_TO_MEMORY_COPY_EXT;
+    region.pHostPointer = actual.bytes.data();
+    region.memoryRowLength = row_length;
+    region.imageSubresource = color_layers();
+    region.imageOffset = {static_cast<int32_t>(x), static_cast<int32_t>(y), 0};
+    region.imageExtent = {expected.width, expected.height, 1};
+    VkCopyImageToMemoryInfoEXT info = {};
+    info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_MEMORY_INFO_EXT;
+    info.srcImage = image;
+    info.srcImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    info.regionCount = 1;
+    info.pRegions = &region;
+    if (copy.to_memory(device.device, &info) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCopyImageToMemory of " << expected.format->name << " failed";
+        return false;
+    }
+    for (uint32_t block_row = 0; block_row < expected.block_rows(); ++block_row) {
+        if (std::memcmp(actual.row(block_row), expected.row(block_row), expected.row_bytes()) != 0) {
+            TEST_LOG_ERROR() << "✗ " << expected.format->name << " block row " << block_row << " of the "
+                             << expected.width << "x" << expected.height << " region at " << x << "," << y
+                             << " read back with row length " << row_length << " differs";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool round_trip(const features::Device& device, const HostCopy& copy, const TextureFormat& format) {
+    VkImageCreateInfo image_info = {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = format.format;
+    image_info.extent = {kWidth, kHeight, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    auto cleanup = [&]() {
+        vkDestroyImage(device.device, image, nullptr);
+        vkFreeMemory(device.device, memory, nullptr);
+    };
+    if (vkCreateImage(device.device, &image_info, nullptr, &image) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Creating the " << format.name << " image failed";
+        return false;
+    }
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(device.device, image, &requirements);
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = requirements.size;
+    alloc_info.memoryTypeIndex =
+        features::find_memory_type(device, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (alloc_info.memoryTypeIndex == UINT32_MAX) {
+        alloc_info.memoryTypeIndex = features::find_memory_type(device, requirements.memoryTypeBits, 0);
+    }
+    if (vkAllocateMemory(device.device, &alloc_info, nullptr, &memory) != VK_SUCCESS ||
+        vkBindImageMemory(device.device, image, memory, 0) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Binding memory to the " << format.name << " image failed";
+        cleanup();
+        return false;
+    }
+
+    VkHostImageLayoutTransitionInfoEXT transition = {};
+    transition.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+    transition.image = image;
+    transition.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    transition.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    transition.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (copy.transition(device.device, 1, &transition) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkTransitionImageLayout of the " << format.name << " image failed";
+        cleanup();
+        return false;
+    }
+
+    // Rows padded by 16 texels, the padding in a byte the texels never use.
+    HostTexels source(format, kWidth, kHeight, kWidth + 16);
+    std::fill(source.bytes.begin(), source.bytes.end(), 0xee);
+    for (uint32_t block_row = 0; block_row < source.block_rows(); ++block_row) {
+        uint8_t* row = source.row(block_row);
+        for (uint32_t i = 0; i < source.row_bytes(); ++i) {
+            row[i] = static_cast<uint8_t>((block_row * 31 + i * 7) % 0xe0);
+        }
+    }
+    VkMemoryToImageCopyEXT region = {};
+    region.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+    region.pHostPointer = source.bytes.data();
+    region.memoryRowLength = source.row_length;
+    region.imageSubresource = color_layers();
+    region.imageExtent = {kWidth, kHeight, 1};
+    VkCopyMemoryToImageInfoEXT upload = {};
+    upload.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+    upload.dstImage = image;
+    upload.dstImageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    upload.regionCount = 1;
+    upload.pRegions = &region;
+    if (copy.to_image(device.device, &upload) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCopyMemoryToImage of the " << format.name << " image failed";
+        cleanup();
+        return false;
+    }
+
+    // The whole image at a different padding, then a block-aligned quarter.
+    HostTexels quarter(format, kWidth / 2, kHeight / 2, kWidth / 2);
+    const uint32_t x = kWidth / 4;
+    const uint32_t y = kHeight / 4;
+    const uint32_t x_bytes = x / format.block_extent * format.block_size;
+    for (uint32_t block_row = 0; block_row < quarter.block_rows(); ++block_row) {
+        std::memcpy(quarter.row(block_row),
+                    source.row(y / format.block_extent + block_row) + x_bytes,
+                    quarter.row_bytes());
+    }
+    const bool passed = read_back(device, copy, image, source, 0, 0, kWidth + 8) &&
+                        read_back(device, copy, image, quarter, x, y, quarter.width + 4);
+    cleanup();
+    return passed;
+}
+
+} // namespace
+
+bool run_host_image_copy_test() {
+    TEST_LOG_INFO() << "Host image copy round-trip test";
+
+    uint32_t api_version = 0;
+    std::vector<std::string> extensions;
+    VkPhysicalDeviceFeatures supported = {};
+    if (!features::query_physical_device(&api_version, &extensions, &supported)) {
+        return false;
+    }
+    auto has_extension = [&](const char* name) {
+        return std::find(extensions.begin(), extensions.end(), name) != extensions.end();
+    };
+    if (!has_extension(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME)) {
+        TEST_LOG_INFO() << "  Device lacks " << VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME << ", skipping";
+        return true;
+    }
+
+    features::DeviceOptions options;
+    options.extensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+    if (api_version >= VK_API_VERSION_1_3) {
+        options.api_version = VK_API_VERSION_1_3;
+    } else if (has_extension(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME) &&
+               has_extension(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME)) {
+        options.extensions.push_back(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME);
+        options.extensions.push_back(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME);
+    } else {
+        TEST_LOG_INFO() << "  Device has neither Vulkan 1.3 nor the extensions host image copy needs, skipping";
+        return true;
+    }
+    VkPhysicalDeviceFeatures2 features2 = {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.features.textureCompressionBC = supported.textureCompressionBC;
+    VkPhysicalDeviceHostImageCopyFeaturesEXT host_image_copy = {};
+    host_image_copy.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+    host_image_copy.pNext = &features2;
+    host_image_copy.hostImageCopy = VK_TRUE;
+    options.next = &host_image_copy;
+
+    features::Device device;
+    if (!features::create_device("Host Image Copy Test", options, &device)) {
+        return false;
+    }
+    HostCopy copy;
+    copy.transition = reinterpret_cast<PFN_vkTransitionImageLayoutEXT>(
+        vkGetDeviceProcAddr(device.device, "vkTransitionImageLayoutEXT"));
+    copy.to_image = reinterpret_cast<PFN_vkCopyMemoryToImageEXT>(
+        vkGetDeviceProcAddr(device.device, "vkCopyMemoryToImageEXT"));
+    copy.to_memory = reinterpret_cast<PFN_vkCopyImageToMemoryEXT>(
+        vkGetDeviceProcAddr(device.device, "vkCopyImageToMemoryEXT"));
+    if (!copy.transition || !copy.to_image || !copy.to_memory) {
+        TEST_LOG_ERROR() << "✗ Host image copy entry points missing";
+        features::destroy_device(&device);
+        return false;
+    }
+
+    const TextureFormat rgba8 = {"RGBA8", VK_FORMAT_R8G8B8A8_UNORM, 4, 1};
+    const TextureFormat bc1 = {"BC1", VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4};
+    bool passed = true;
+    if (!supports_host_copy(device, rgba8)) {
+        TEST_LOG_ERROR() << "✗ RGBA8 images cannot be host copied";
+        passed = false;
+    } else {
+        passed = round_trip(device, copy, rgba8);
+    }
+    bool bc_tested = false;
+    if (passed && supported.textureCompressionBC && supports_host_copy(device, bc1)) {
+        passed = round_trip(device, copy, bc1);
+        bc_tested = true;
+    } else if (passed) {
+        TEST_LOG_INFO() << "  GPU cannot host copy BC1 textures, checking RGBA8 only";
+    }
+    features::destroy_device(&device);
+    if (passed) {
+        TEST_LOG_INFO() << "✅ " << (bc_tested ? "RGBA8 and BC1 textures" : "RGBA8 textures")
+                        << " survive padded host image copies both ways";
+    }
+    return passed;
+}
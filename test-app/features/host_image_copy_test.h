@@ -0,0 +1,12 @@
+#ifndef VENUS_TEST_APP_HOST_IMAGE_COPY_TEST_H
+#define VENUS_TEST_APP_HOST_IMAGE_COPY_TEST_H
+
+// Uploads an RGBA8 and, when the GPU has BC textures, a BC1 texture with
+// vkCopyMemoryToImage from rows padded past the image width, reads them back
+// whole and in part with vkCopyImageToMemory at other row lengths, and
+// compares the texels. Runs on whichever path the server takes: start it
+// with --emulate-host-image-copy to cover the emulation on a GPU that has
+// the extension.
+bool run_host_image_copy_test();
+
+#endif // VENUS_TEST_APP_HOST_IMAGE_COPY_TEST_H
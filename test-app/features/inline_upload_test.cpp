@@ -0,0 +1,111 @@
+#include "inline_upload_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr VkDeviceSize kBufferSize = 256;
+
+struct Update {
+    int buffer; // 0 or 1
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint8_t fill;
+};
+
+// In recording order. The second overlaps the first, the fourth goes back to
+// buffer 0 after buffer 1, and the last lies inside the second.
+const Update kUpdates[] = {
+    {0, 0, 64, 0x11},
+    {0, 32, 64, 0x22},
+    {1, 0, 128, 0x33},
+    {0, 128, 64, 0x44},
+    {1, 64, 16, 0x55},
+    {0, 48, 8, 0x66},
+};
+constexpr uint64_t kUpdateCount = sizeof(kUpdates) / sizeof(kUpdates[0]);
+
+bool env_off(const char* name) {
+    const char* value = std::getenv(name);
+    return value && (std::strcmp(value, "0") == 0 || std::strcmp(value, "off") == 0 || std::strcmp(value, "OFF") == 0);
+}
+
+} // namespace
+
+bool run_inline_upload_test() {
+    TEST_LOG_INFO() << "Inline upload test";
+
+    features::Device device;
+    features::Buffer buffers[2];
+    auto cleanup = [&]() {
+        features::destroy_buffer(device, &buffers[0]);
+        features::destroy_buffer(device, &buffers[1]);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Inline Upload Test", {}, &device) ||
+        !features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &buffers[0]) ||
+        !features::create_host_buffer(device, kBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &buffers[1])) {
+        cleanup();
+        return false;
+    }
+
+    std::vector<uint8_t> expected[2] = {std::vector<uint8_t>(kBufferSize, 0), std::vector<uint8_t>(kBufferSize, 0)};
+    for (features::Buffer& buffer : buffers) {
+        std::memset(buffer.mapped, 0, kBufferSize);
+    }
+
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    venus_plus::ClientStats before = {};
+    if (command_buffer == VK_NULL_HANDLE || !features::get_client_stats(device, &before) ||
+        vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        cleanup();
+        return false;
+    }
+    for (const Update& update : kUpdates) {
+        const std::vector<uint8_t> data(update.size, update.fill);
+        vkCmdUpdateBuffer(command_buffer, buffers[update.buffer].buffer, update.offset, update.size, data.data());
+        std::memcpy(expected[update.buffer].data() + update.offset, data.data(), data.size());
+    }
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Submitting the updates failed";
+        cleanup();
+        return false;
+    }
+
+    // Only captured recordings carry inline uploads.
+    const bool captured = !env_off("VENUS_REPLAY_CACHE") || !env_off("VENUS_DEFERRED_RECORDING");
+    const uint64_t expected_inline = captured && !env_off("VENUS_INLINE_UPLOADS") ? kUpdateCount : 0;
+    venus_plus::ClientStats after = {};
+    features::get_client_stats(device, &after);
+    const uint64_t inline_uploads = after.inline_uploads - before.inline_uploads;
+    TEST_LOG_INFO() << "  inline uploads: " << inline_uploads << " of " << kUpdateCount << " updates";
+    if (inline_uploads != expected_inline) {
+        TEST_LOG_ERROR() << "✗ Expected " << expected_inline << " updates to travel as inline uploads";
+        cleanup();
+        return false;
+    }
+
+    for (int b = 0; b < 2; ++b) {
+        const uint8_t* actual = static_cast<const uint8_t*>(buffers[b].mapped);
+        for (VkDeviceSize i = 0; i < kBufferSize; ++i) {
+            if (actual[i] != expected[b][i]) {
+                TEST_LOG_ERROR() << "✗ Buffer " << b << " byte " << i << " is 0x" << std::hex
+                                 << static_cast<int>(actual[i]) << ", expected 0x"
+                                 << static_cast<int>(expected[b][i]) << std::dec;
+                cleanup();
+                return false;
+            }
+        }
+    }
+    cleanup();
+    TEST_LOG_INFO() << "✅ Adjacent buffer updates land in order, overlapping and across buffers"
+                    << (expected_inline ? ", as inline uploads" : "");
+    return true;
+}
@@ -0,0 +1,11 @@
+#ifndef VENUS_TEST_APP_INLINE_UPLOAD_TEST_H
+#define VENUS_TEST_APP_INLINE_UPLOAD_TEST_H
+
+// Records back-to-back vkCmdUpdateBuffer calls, which travel as one inline
+// upload: regions that overlap, and alternating destination buffers. Checks
+// both buffers hold what the calls would leave in order, later writes winning,
+// and that the ICD counted every call as an inline upload region, unless
+// VENUS_INLINE_UPLOADS or recording capture is off.
+bool run_inline_upload_test();
+
+#endif // VENUS_TEST_APP_INLINE_UPLOAD_TEST_H
@@ -0,0 +1,227 @@
+#include "memory_requirements_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// |repeat|: the same create info as an earlier entry, so a hit.
+struct BufferDesc {
+    VkDeviceSize size;
+    VkBufferUsageFlags usage;
+    bool repeat;
+};
+
+struct ImageDesc {
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+    VkImageUsageFlags usage;
+    bool repeat;
+};
+
+const BufferDesc kBuffers[] = {
+    {4096, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false},
+    {4096, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true},
+    {4100, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false},
+    {4096, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false},
+    {65536, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, false},
+    {4096, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true},
+};
+
+const ImageDesc kImages[] = {
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, false},
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, true},
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 32, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, false},
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 7, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, false},
+    {VK_FORMAT_R16G16B16A16_SFLOAT, 64, 64, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, false},
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, false},
+    {VK_FORMAT_D16_UNORM, 64, 64, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false},
+    {VK_FORMAT_R8G8B8A8_UNORM, 64, 64, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, true},
+};
+
+struct RunResult {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t checksum = 0;
+};
+
+// FNV-1a over the answers.
+void fold(uint64_t* checksum, const VkMemoryRequirements& requirements) {
+    const uint64_t fields[] = {requirements.size, requirements.alignment, requirements.memoryTypeBits};
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(fields);
+    for (size_t i = 0; i < sizeof(fields); ++i) {
+        *checksum = (*checksum ^ bytes[i]) * 1099511628211ull;
+    }
+}
+
+bool buffer_requirements(const features::Device& device, const BufferDesc& desc, VkMemoryRequirements* out) {
+    VkBufferCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = desc.size;
+    info.usage = desc.usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    if (vkCreateBuffer(device.device, &info, nullptr, &buffer) != VK_SUCCESS) {
+        return false;
+    }
+    vkGetBufferMemoryRequirements(device.device, buffer, out);
+    vkDestroyBuffer(device.device, buffer, nullptr);
+    return out->size > 0;
+}
+
+bool image_requirements(const features::Device& device, const ImageDesc& desc, VkMemoryRequirements* out) {
+    VkImageCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = desc.format;
+    info.extent = {desc.width, desc.height, 1};
+    info.mipLevels = desc.mip_levels;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = desc.usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image = VK_NULL_HANDLE;
+    if (vkCreateImage(device.device, &info, nullptr, &image) != VK_SUCCESS) {
+        return false;
+    }
+    vkGetImageMemoryRequirements(device.device, image, out);
+    vkDestroyImage(device.device, image, nullptr);
+    return out->size > 0;
+}
+
+bool run_child(bool cached, const std::string& result_path, RunResult* result) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        TEST_LOG_ERROR() << "✗ fork failed";
+        return false;
+    }
+    if (pid == 0) {
+        setenv("VENUS_MEMORY_REQUIREMENTS_CACHE", cached ? "on" : "off", 1);
+        execl("/proc/self/exe",
+              "venus-test-app",
+              "--memory-requirements-run",
+              result_path.c_str(),
+              static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        TEST_LOG_ERROR() << "✗ Memory requirements run failed";
+        return false;
+    }
+    FILE* file = std::fopen(result_path.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    const int fields = std::fscanf(file,
+                                   "%" SCNu64 " %" SCNu64 " %" SCNu64,
+                                   &result->hits,
+                                   &result->misses,
+                                   &result->checksum);
+    std::fclose(file);
+    return fields == 3;
+}
+
+} // namespace
+
+int run_memory_requirements_child(const char* result_path) {
+    features::Device device;
+    if (!features::create_device("Memory Requirements Run", {}, &device)) {
+        return 1;
+    }
+    venus_plus::ClientStats before = {};
+    if (!features::get_client_stats(device, &before)) {
+        features::destroy_device(&device);
+        return 1;
+    }
+
+    uint64_t checksum = 14695981039346656037ull;
+    bool queried = true;
+    for (const BufferDesc& desc : kBuffers) {
+        VkMemoryRequirements requirements = {};
+        queried = queried && buffer_requirements(device, desc, &requirements);
+        fold(&checksum, requirements);
+    }
+    for (const ImageDesc& desc : kImages) {
+        VkMemoryRequirements requirements = {};
+        queried = queried && image_requirements(device, desc, &requirements);
+        fold(&checksum, requirements);
+    }
+    venus_plus::ClientStats after = {};
+    features::get_client_stats(device, &after);
+    features::destroy_device(&device);
+    if (!queried) {
+        return 1;
+    }
+
+    FILE* file = std::fopen(result_path, "w");
+    if (!file) {
+        return 1;
+    }
+    std::fprintf(file,
+                 "%" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+                 after.memory_requirements_hits - before.memory_requirements_hits,
+                 after.memory_requirements_misses - before.memory_requirements_misses,
+                 checksum);
+    return std::fclose(file) == 0 ? 0 : 1;
+}
+
+bool run_memory_requirements_test() {
+    TEST_LOG_INFO() << "Memory requirements cache test";
+
+    char path_template[] = "/tmp/venus-memreq-test-XXXXXX";
+    const int fd = mkstemp(path_template);
+    if (fd < 0) {
+        TEST_LOG_ERROR() << "✗ Cannot create a result file";
+        return false;
+    }
+    close(fd);
+    const std::string result_path = path_template;
+
+    RunResult cached;
+    RunResult uncached;
+    const bool ran = run_child(true, result_path, &cached) && run_child(false, result_path, &uncached);
+    unlink(result_path.c_str());
+    if (!ran) {
+        return false;
+    }
+
+    uint64_t repeats = 0;
+    uint64_t queries = 0;
+    for (const BufferDesc& desc : kBuffers) {
+        repeats += desc.repeat;
+        ++queries;
+    }
+    for (const ImageDesc& desc : kImages) {
+        repeats += desc.repeat;
+        ++queries;
+    }
+    TEST_LOG_INFO() << "  cached run: hits=" << cached.hits << " misses=" << cached.misses;
+    TEST_LOG_INFO() << "  uncached run: hits=" << uncached.hits << " misses=" << uncached.misses;
+    if (cached.hits != repeats || cached.misses != queries - repeats) {
+        TEST_LOG_ERROR() << "✗ Cached run should hit " << repeats << " times and miss " << queries - repeats;
+        return false;
+    }
+    if (uncached.hits != 0 || uncached.misses != 0) {
+        TEST_LOG_ERROR() << "✗ VENUS_MEMORY_REQUIREMENTS_CACHE=off still used the cache";
+        return false;
+    }
+    if (cached.checksum != uncached.checksum) {
+        TEST_LOG_ERROR() << "✗ Cached requirements differ from the server's";
+        return false;
+    }
+    TEST_LOG_INFO() << "✅ " << repeats << " repeated create infos answered locally, as the server answers them";
+    return true;
+}
@@ -0,0 +1,14 @@
+#ifndef VENUS_TEST_APP_MEMORY_REQUIREMENTS_TEST_H
+#define VENUS_TEST_APP_MEMORY_REQUIREMENTS_TEST_H
+
+// Runs the test app twice, with the ICD's memory requirements cache on and
+// off, each run creating buffers and images some of which repeat an earlier
+// create info. The cached run must answer exactly the repeats locally and
+// the uncached one none, and both must report the same requirements.
+bool run_memory_requirements_test();
+
+// One of those runs (--memory-requirements-run FILE): queries, then writes
+// the cache counters and a checksum of the answers to |result_path|.
+int run_memory_requirements_child(const char* result_path);
+
+#endif // VENUS_TEST_APP_MEMORY_REQUIREMENTS_TEST_H
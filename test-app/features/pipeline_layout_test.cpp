@@ -0,0 +1,121 @@
+#include "pipeline_layout_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSize = 64;
+
+VkPipelineLayout create_push_constant_layout(const features::Device& device) {
+    VkPushConstantRange range = {};
+    range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    range.size = 16;
+
+    VkPipelineLayoutCreateInfo layout_info = {};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &range;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    vkCreatePipelineLayout(device.device, &layout_info, nullptr, &layout);
+    return layout;
+}
+
+// Records the triangle with a push constant through a layout of its own and
+// destroys that layout before end (|during_recording|) or right after it.
+bool render(const features::Device& device,
+            const features::TriangleTarget& target,
+            VkCommandBuffer command_buffer,
+            bool during_recording) {
+    VkPipelineLayout layout = create_push_constant_layout(device);
+    if (layout == VK_NULL_HANDLE) {
+        TEST_LOG_ERROR() << "✗ vkCreatePipelineLayout failed";
+        return false;
+    }
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    features::cmd_begin_triangle_pass(command_buffer, target);
+    const float offset[4] = {};
+    vkCmdPushConstants(command_buffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(offset), offset);
+    if (during_recording) {
+        vkDestroyPipelineLayout(device.device, layout, nullptr);
+    }
+    VkRect2D area = {};
+    area.extent = {kSize, kSize};
+    features::cmd_draw_triangle(command_buffer, target, area);
+    features::cmd_end_triangle_pass(command_buffer, target);
+    const VkResult end_result = vkEndCommandBuffer(command_buffer);
+    if (!during_recording) {
+        vkDestroyPipelineLayout(device.device, layout, nullptr);
+    }
+
+    const char* when = during_recording ? "while recording" : "before submit";
+    if (end_result != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Recording with its layout destroyed " << when << " failed";
+        return false;
+    }
+    if (!features::pixel_lit(features::read_pixels(target), target, kSize / 2, kSize / 2)) {
+        TEST_LOG_ERROR() << "✗ Triangle missing with its layout destroyed " << when;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_pipeline_layout_test() {
+    TEST_LOG_INFO() << "Pipeline layout lifetime test";
+
+    uint32_t api_version = 0;
+    std::vector<std::string> extensions;
+    if (!features::query_physical_device(&api_version, &extensions)) {
+        return false;
+    }
+
+    features::DeviceOptions options;
+    VkPhysicalDeviceVulkan13Features features13 = {};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    features13.maintenance4 = VK_TRUE;
+    VkPhysicalDeviceMaintenance4FeaturesKHR maintenance4 = {};
+    maintenance4.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_4_FEATURES_KHR;
+    maintenance4.maintenance4 = VK_TRUE;
+    if (api_version >= VK_API_VERSION_1_3) {
+        options.api_version = VK_API_VERSION_1_3;
+        options.next = &features13;
+    } else if (std::find(extensions.begin(), extensions.end(), VK_KHR_MAINTENANCE_4_EXTENSION_NAME) !=
+               extensions.end()) {
+        options.extensions.push_back(VK_KHR_MAINTENANCE_4_EXTENSION_NAME);
+        options.next = &maintenance4;
+    } else {
+        TEST_LOG_INFO() << "  Device has neither Vulkan 1.3 nor " << VK_KHR_MAINTENANCE_4_EXTENSION_NAME
+                        << ", skipping";
+        return true;
+    }
+
+    features::Device device;
+    features::TriangleTarget target;
+    auto cleanup = [&]() {
+        features::destroy_triangle_target(device, &target);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Pipeline Layout Test", options, &device) ||
+        !features::create_triangle_target(device, kSize, kSize, &target)) {
+        cleanup();
+        return false;
+    }
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    const bool passed = command_buffer != VK_NULL_HANDLE && render(device, target, command_buffer, true) &&
+                        vkResetCommandBuffer(command_buffer, 0) == VK_SUCCESS &&
+                        render(device, target, command_buffer, false);
+    cleanup();
+    if (passed) {
+        TEST_LOG_INFO() << "✅ Recordings outlive their destroyed pipeline layouts";
+    }
+    return passed;
+}
@@ -0,0 +1,10 @@
+#ifndef VENUS_TEST_APP_PIPELINE_LAYOUT_TEST_H
+#define VENUS_TEST_APP_PIPELINE_LAYOUT_TEST_H
+
+// With maintenance4 a pipeline layout may be destroyed right after the
+// commands that use it: destroys one while its command buffer is still
+// recording and another before the first submit, and checks both recordings
+// still run and render.
+bool run_pipeline_layout_test();
+
+#endif // VENUS_TEST_APP_PIPELINE_LAYOUT_TEST_H
@@ -0,0 +1,118 @@
+#include "replay_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSize = 64;
+
+struct Frame {
+    std::vector<uint8_t> pixels;
+    venus_plus::ClientStats stats = {};
+};
+
+// Records one triangle into the left or right half, submits it and reads the
+// image back along with the counters after the submit.
+bool render(const features::Device& device,
+            const features::TriangleTarget& target,
+            VkCommandBuffer command_buffer,
+            bool right,
+            Frame* frame) {
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkBeginCommandBuffer failed";
+        return false;
+    }
+    features::cmd_begin_triangle_pass(command_buffer, target);
+    VkRect2D area = {};
+    area.offset = {right ? static_cast<int32_t>(kSize) : 0, 0};
+    area.extent = {kSize, kSize};
+    features::cmd_draw_triangle(command_buffer, target, area);
+    features::cmd_end_triangle_pass(command_buffer, target);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Rendering failed";
+        return false;
+    }
+    frame->pixels = features::read_pixels(target);
+    features::get_client_stats(device, &frame->stats);
+
+    const uint32_t lit_x = (right ? kSize : 0) + kSize / 2;
+    const uint32_t dark_x = (right ? 0 : kSize) + kSize / 2;
+    if (!features::pixel_lit(frame->pixels, target, lit_x, kSize / 2) ||
+        features::pixel_lit(frame->pixels, target, dark_x, kSize / 2)) {
+        TEST_LOG_ERROR() << "✗ Triangle not in the " << (right ? "right" : "left") << " half";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool run_replay_test() {
+    TEST_LOG_INFO() << "Command replay test";
+
+    features::Device device;
+    features::TriangleTarget target;
+    auto cleanup = [&]() {
+        features::destroy_triangle_target(device, &target);
+        features::destroy_device(&device);
+    };
+    if (!features::create_device("Replay Test", {}, &device) ||
+        !features::create_triangle_target(device, kSize * 2, kSize, &target)) {
+        cleanup();
+        return false;
+    }
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    venus_plus::ClientStats start = {};
+    if (command_buffer == VK_NULL_HANDLE || !features::get_client_stats(device, &start)) {
+        cleanup();
+        return false;
+    }
+
+    // Neither reset releases resources, so the client keeps both from the
+    // server and the recordings after them begin over an executable buffer.
+    Frame first;
+    Frame repeat;
+    Frame moved;
+    Frame back;
+    bool rendered = render(device, target, command_buffer, false, &first) &&
+                    vkResetCommandBuffer(command_buffer, 0) == VK_SUCCESS &&
+                    render(device, target, command_buffer, false, &repeat) &&
+                    vkResetCommandBuffer(command_buffer, 0) == VK_SUCCESS &&
+                    render(device, target, command_buffer, true, &moved) &&
+                    vkResetCommandPool(device.device, device.pool, 0) == VK_SUCCESS &&
+                    render(device, target, command_buffer, false, &back);
+    cleanup();
+    if (!rendered) {
+        return false;
+    }
+
+    if (start.replay_recordings == first.stats.replay_recordings) {
+        TEST_LOG_INFO() << "  Replay cache disabled (VENUS_REPLAY_CACHE), skipping the hit checks";
+        TEST_LOG_INFO() << "✅ Command buffer re-recorded after kept resets";
+        return true;
+    }
+    if (repeat.stats.replay_hits <= first.stats.replay_hits) {
+        TEST_LOG_ERROR() << "✗ Identical re-recording was not a replay hit";
+        return false;
+    }
+    if (repeat.pixels != first.pixels) {
+        TEST_LOG_ERROR() << "✗ Replayed recording rendered a different image";
+        return false;
+    }
+    if (moved.stats.replay_misses <= repeat.stats.replay_misses) {
+        TEST_LOG_ERROR() << "✗ Changed recording was not uploaded";
+        return false;
+    }
+    if (back.pixels != first.pixels) {
+        TEST_LOG_ERROR() << "✗ Re-recording after the pool reset rendered a different image";
+        return false;
+    }
+    TEST_LOG_INFO() << "✅ " << (back.stats.replay_hits - start.replay_hits) << " replay hits, "
+                    << (back.stats.replay_misses - start.replay_misses) << " uploads, identical images";
+    return true;
+}
@@ -0,0 +1,9 @@
+#ifndef VENUS_TEST_APP_REPLAY_TEST_H
+#define VENUS_TEST_APP_REPLAY_TEST_H
+
+// Re-records one command buffer after resets the client keeps from the
+// server: an identical recording must be a replay hit with the same image,
+// a different one must be uploaded and begun over the kept recording.
+bool run_replay_test();
+
+#endif // VENUS_TEST_APP_REPLAY_TEST_H
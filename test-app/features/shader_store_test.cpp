@@ -0,0 +1,118 @@
+#include "shader_store_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+#include "phase10/shaders/triangle_spirv.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSize = 64;
+// Larger than what the ICD uploads with the first request.
+constexpr size_t kModuleBytes = 8192;
+
+constexpr uint32_t kOpSource = 3;
+constexpr uint32_t kOpSourceExtension = 4;
+constexpr size_t kSpirvHeaderWords = 5;
+
+// The triangle vertex shader padded past kModuleBytes with an
+// OpSourceExtension, a debug instruction drivers ignore, placed ahead of its
+// OpSource.
+std::vector<uint32_t> padded_vertex_shader() {
+    const std::vector<uint32_t> code(std::begin(kVertexShaderSpv), std::end(kVertexShaderSpv));
+    size_t source = kSpirvHeaderWords;
+    while (source < code.size() && (code[source] & 0xffffu) != kOpSource) {
+        source += code[source] >> 16;
+    }
+
+    std::string name = "venus_plus_shader_store_test_";
+    name.append(kModuleBytes - code.size() * sizeof(uint32_t), 'x');
+    const size_t string_words = name.size() / sizeof(uint32_t) + 1; // with the terminator
+    std::vector<uint32_t> padding(1 + string_words, 0);
+    padding[0] = static_cast<uint32_t>(padding.size() << 16) | kOpSourceExtension;
+    std::memcpy(padding.data() + 1, name.data(), name.size());
+
+    std::vector<uint32_t> padded(code.begin(), code.begin() + source);
+    padded.insert(padded.end(), padding.begin(), padding.end());
+    padded.insert(padded.end(), code.begin() + source, code.end());
+    return padded;
+}
+
+} // namespace
+
+bool run_shader_store_test() {
+    TEST_LOG_INFO() << "Shader module store test";
+    const char* cache = std::getenv("VENUS_SHADER_CACHE");
+    if (cache && (std::strcmp(cache, "0") == 0 || std::strcmp(cache, "off") == 0 || std::strcmp(cache, "OFF") == 0)) {
+        TEST_LOG_INFO() << "  VENUS_SHADER_CACHE is off, skipping";
+        return true;
+    }
+
+    features::Device device;
+    features::TriangleTarget target;
+    auto cleanup = [&]() {
+        features::destroy_triangle_target(device, &target);
+        features::destroy_device(&device);
+    };
+    venus_plus::ClientStats start = {};
+    if (!features::create_device("Shader Store Test", {}, &device) || !features::get_client_stats(device, &start)) {
+        cleanup();
+        return false;
+    }
+
+    // The first creation stores the code on the server (or finds it there
+    // from an earlier run); the one in the triangle target must find it.
+    const std::vector<uint32_t> code = padded_vertex_shader();
+    VkShaderModuleCreateInfo shader_info = {};
+    shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_info.codeSize = code.size() * sizeof(uint32_t);
+    shader_info.pCode = code.data();
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device.device, &shader_info, nullptr, &module) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateShaderModule failed";
+        cleanup();
+        return false;
+    }
+    vkDestroyShaderModule(device.device, module, nullptr);
+
+    venus_plus::ClientStats first = {};
+    features::get_client_stats(device, &first);
+    if (!features::create_triangle_target(device, kSize, kSize, &target, &code)) {
+        cleanup();
+        return false;
+    }
+    venus_plus::ClientStats second = {};
+    features::get_client_stats(device, &second);
+
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    features::cmd_begin_triangle_pass(command_buffer, target);
+    VkRect2D area = {};
+    area.extent = {kSize, kSize};
+    features::cmd_draw_triangle(command_buffer, target, area);
+    features::cmd_end_triangle_pass(command_buffer, target);
+    const bool drawn = vkEndCommandBuffer(command_buffer) == VK_SUCCESS &&
+                       features::submit_and_wait(device, command_buffer) &&
+                       features::pixel_lit(features::read_pixels(target), target, kSize / 2, kSize / 2);
+    cleanup();
+
+    if (second.shader_store_hits <= first.shader_store_hits) {
+        TEST_LOG_ERROR() << "✗ Second creation of the " << shader_info.codeSize
+                         << "-byte module was not answered from the store";
+        return false;
+    }
+    if (!drawn) {
+        TEST_LOG_ERROR() << "✗ Triangle from the stored module missing";
+        return false;
+    }
+    TEST_LOG_INFO() << "✅ Module created from the store (" << (second.shader_store_hits - start.shader_store_hits)
+                    << " store hits) and drew the triangle";
+    return true;
+}
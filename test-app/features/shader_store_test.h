@@ -0,0 +1,9 @@
+#ifndef VENUS_TEST_APP_SHADER_STORE_TEST_H
+#define VENUS_TEST_APP_SHADER_STORE_TEST_H
+
+// Creates a shader module too large to go out with its code twice: the
+// second creation must be answered from the server's SPIR-V store by hash
+// alone, and the module must still draw.
+bool run_shader_store_test();
+
+#endif // VENUS_TEST_APP_SHADER_STORE_TEST_H
@@ -0,0 +1,114 @@
+#include "state_filter_test.h"
+
+#include "feature_harness.h"
+#include "logging.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSize = 64;
+constexpr uint32_t kDraws = 4;
+
+// Renders kDraws triangles side by side, each after a full set of binds;
+// only the viewport and scissor change between them, so the pipeline and
+// vertex buffer binds after the first are redundant.
+bool render(bool filter, std::vector<uint8_t>* pixels, uint64_t* elided) {
+    if (filter) {
+        unsetenv("VENUS_STATE_FILTER");
+    } else {
+        setenv("VENUS_STATE_FILTER", "off", 1);
+    }
+
+    features::Device device;
+    features::TriangleTarget target;
+    auto cleanup = [&]() {
+        features::destroy_triangle_target(device, &target);
+        features::destroy_device(&device);
+    };
+    // The ICD reads VENUS_STATE_FILTER at vkCreateInstance.
+    if (!features::create_device("State Filter Test", {}, &device) ||
+        !features::create_triangle_target(device, kSize * kDraws, kSize, &target)) {
+        cleanup();
+        return false;
+    }
+    VkCommandBuffer command_buffer = features::allocate_command_buffer(device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    venus_plus::ClientStats before = {};
+    if (command_buffer == VK_NULL_HANDLE || !features::get_client_stats(device, &before)) {
+        cleanup();
+        return false;
+    }
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    features::cmd_begin_triangle_pass(command_buffer, target);
+    for (uint32_t i = 0; i < kDraws; ++i) {
+        VkRect2D area = {};
+        area.offset = {static_cast<int32_t>(i * kSize), 0};
+        area.extent = {kSize, kSize};
+        features::cmd_draw_triangle(command_buffer, target, area);
+    }
+    features::cmd_end_triangle_pass(command_buffer, target);
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS || !features::submit_and_wait(device, command_buffer)) {
+        TEST_LOG_ERROR() << "✗ Rendering failed";
+        cleanup();
+        return false;
+    }
+
+    venus_plus::ClientStats after = {};
+    features::get_client_stats(device, &after);
+    *elided = after.state_filter_elided - before.state_filter_elided;
+    *pixels = features::read_pixels(target);
+    for (uint32_t i = 0; i < kDraws; ++i) {
+        if (!features::pixel_lit(*pixels, target, i * kSize + kSize / 2, kSize / 2)) {
+            TEST_LOG_ERROR() << "✗ Triangle " << i << " missing (filter " << (filter ? "on" : "off") << ")";
+            cleanup();
+            return false;
+        }
+    }
+    cleanup();
+    return true;
+}
+
+} // namespace
+
+bool run_state_filter_test() {
+    TEST_LOG_INFO() << "State filter test";
+
+    const char* saved = std::getenv("VENUS_STATE_FILTER");
+    const std::string saved_value = saved ? saved : "";
+
+    std::vector<uint8_t> unfiltered;
+    std::vector<uint8_t> filtered;
+    uint64_t unfiltered_elided = 0;
+    uint64_t filtered_elided = 0;
+    const bool rendered = render(false, &unfiltered, &unfiltered_elided) &&
+                          render(true, &filtered, &filtered_elided);
+
+    if (saved) {
+        setenv("VENUS_STATE_FILTER", saved_value.c_str(), 1);
+    } else {
+        unsetenv("VENUS_STATE_FILTER");
+    }
+    if (!rendered) {
+        return false;
+    }
+
+    if (unfiltered_elided != 0) {
+        TEST_LOG_ERROR() << "✗ VENUS_STATE_FILTER=off still elided " << unfiltered_elided << " commands";
+        return false;
+    }
+    if (filtered_elided == 0) {
+        TEST_LOG_ERROR() << "✗ The filter elided no redundant commands";
+        return false;
+    }
+    if (filtered != unfiltered) {
+        TEST_LOG_ERROR() << "✗ Filtered and unfiltered images differ";
+        return false;
+    }
+    TEST_LOG_INFO() << "✅ " << filtered_elided << " redundant commands elided, identical images";
+    return true;
+}
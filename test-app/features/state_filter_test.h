@@ -0,0 +1,9 @@
+#ifndef VENUS_TEST_APP_STATE_FILTER_TEST_H
+#define VENUS_TEST_APP_STATE_FILTER_TEST_H
+
+// Records the same draws, re-binding unchanged pipeline, vertex buffer,
+// viewport and scissor before each one, with VENUS_STATE_FILTER off and on.
+// The images must match and the filtered run must have elided commands.
+bool run_state_filter_test();
+
+#endif // VENUS_TEST_APP_STATE_FILTER_TEST_H
@@ -9,7 +9,27 @@
 #include "phase09/phase09_test.h"
 #include "phase09_1/phase09_1_test.h"
 #include "phase10/phase10_test.h"
+#include "benchmarks/decode_throughput_benchmark.h"
+#include "benchmarks/handle_table_benchmark.h"
+#include "benchmarks/logging_benchmark.h"
+#include "benchmarks/pipeline_cache_benchmark.h"
+#include "benchmarks/replay_cache_benchmark.h"
+#include "benchmarks/session_scaling_benchmark.h"
+#include "benchmarks/wsi_present_benchmark.h"
+#include "features/caps_cache_test.h"
+#include "features/deferred_pipeline_test.h"
+#include "features/descriptor_pool_test.h"
+#include "features/descriptor_template_test.h"
+#include "features/device_local_mapping_test.h"
+#include "features/host_image_copy_test.h"
+#include "features/inline_upload_test.h"
+#include "features/memory_requirements_test.h"
+#include "features/pipeline_layout_test.h"
+#include "features/replay_test.h"
+#include "features/shader_store_test.h"
+#include "features/state_filter_test.h"
 #include "logging.h"
+#include <cstdlib>
 #include <cstring>
 
 void print_usage(const char* prog_name) {
@@ -17,6 +37,25 @@ void print_usage(const char* prog_name) {
     TEST_LOG_INFO() << "Options:";
     TEST_LOG_INFO() << "  --phase N    Run phase N test";
     TEST_LOG_INFO() << "  --all        Run all available phases";
+    TEST_LOG_INFO() << "  --bench wsi [frames] [width] [height]";
+    TEST_LOG_INFO() << "               Headless present benchmark (client CPU per frame)";
+    TEST_LOG_INFO() << "  --bench logging [calls]";
+    TEST_LOG_INFO() << "               Per-call cost of disabled and enabled log statements";
+    TEST_LOG_INFO() << "  --bench handles [lookups]";
+    TEST_LOG_INFO() << "               Server handle translation, lookups/s before and after slot maps";
+    TEST_LOG_INFO() << "  --bench decode [commands]";
+    TEST_LOG_INFO() << "               Server decode throughput (compare against --trusted-client)";
+    TEST_LOG_INFO() << "  --bench sessions [clients] [commands]";
+    TEST_LOG_INFO() << "               Aggregate server throughput with 1..clients concurrent connections";
+    TEST_LOG_INFO() << "  --bench replay [frames] [commands]";
+    TEST_LOG_INFO() << "               Frame time of re-recorded identical vs changing command buffers";
+    TEST_LOG_INFO() << "  --bench pipelines [count]";
+    TEST_LOG_INFO() << "               Pipeline create-to-first-fence time, cold and from the server's cache";
+    TEST_LOG_INFO() << "  --test NAME  Run one feature test, or all of them with --test all:";
+    TEST_LOG_INFO() << "               state-filter, replay, pipeline-layout, deferred-pipelines,";
+    TEST_LOG_INFO() << "               shader-store, caps-cache, memory-requirements, descriptor-pool,";
+    TEST_LOG_INFO() << "               descriptor-template, inline-upload, device-local-mapping,";
+    TEST_LOG_INFO() << "               host-image-copy";
     TEST_LOG_INFO() << "  --help       Show this help";
 }
 
@@ -74,6 +113,97 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (strcmp(argv[1], "--bench") == 0) {
+        if (argc < 3) {
+            TEST_LOG_ERROR() << "Error: --bench requires a benchmark name";
+            return 1;
+        }
+        if (strcmp(argv[2], "wsi") == 0) {
+            uint32_t frames = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 300;
+            uint32_t width = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 1280;
+            uint32_t height = argc > 5 ? static_cast<uint32_t>(atoi(argv[5])) : 720;
+            return run_wsi_present_benchmark(frames, width, height) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "logging") == 0) {
+            uint32_t calls = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 1000000;
+            return run_logging_benchmark(calls) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "handles") == 0) {
+            uint32_t lookups = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 10000000;
+            return run_handle_table_benchmark(lookups) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "decode") == 0) {
+            uint32_t commands = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 300000;
+            return run_decode_throughput_benchmark(commands) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "sessions") == 0) {
+            uint32_t clients = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 4;
+            uint32_t commands = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 100000;
+            return run_session_scaling_benchmark(clients, commands) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "replay") == 0) {
+            uint32_t frames = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 300;
+            uint32_t commands = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 2000;
+            return run_replay_cache_benchmark(frames, commands) ? 0 : 1;
+        }
+        if (strcmp(argv[2], "pipelines") == 0) {
+            uint32_t pipelines = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 64;
+            return run_pipeline_cache_benchmark(pipelines) ? 0 : 1;
+        }
+        TEST_LOG_ERROR() << "Error: Unknown benchmark " << argv[2];
+        return 1;
+    }
+
+    if (strcmp(argv[1], "--caps-cache-run") == 0 && argc > 2) {
+        // Child process of the caps-cache test.
+        return run_caps_cache_child(argv[2]);
+    }
+
+    if (strcmp(argv[1], "--memory-requirements-run") == 0 && argc > 2) {
+        // Child process of the memory-requirements test.
+        return run_memory_requirements_child(argv[2]);
+    }
+
+    if (strcmp(argv[1], "--test") == 0) {
+        if (argc < 3) {
+            TEST_LOG_ERROR() << "Error: --test requires a test name";
+            return 1;
+        }
+        struct FeatureTest {
+            const char* name;
+            bool (*run)();
+        };
+        static const FeatureTest kFeatureTests[] = {
+            {"state-filter", run_state_filter_test},
+            {"replay", run_replay_test},
+            {"pipeline-layout", run_pipeline_layout_test},
+            {"deferred-pipelines", run_deferred_pipeline_test},
+            {"shader-store", run_shader_store_test},
+            {"caps-cache", run_caps_cache_test},
+            {"memory-requirements", run_memory_requirements_test},
+            {"descriptor-pool", run_descriptor_pool_test},
+            {"descriptor-template", run_descriptor_template_test},
+            {"inline-upload", run_inline_upload_test},
+            {"device-local-mapping", run_device_local_mapping_test},
+            {"host-image-copy", run_host_image_copy_test},
+        };
+        const bool all = strcmp(argv[2], "all") == 0;
+        bool found = false;
+        for (const FeatureTest& test : kFeatureTests) {
+            if (all || strcmp(argv[2], test.name) == 0) {
+                found = true;
+                if (!test.run()) {
+                    return 1;
+                }
+            }
+        }
+        if (!found) {
+            TEST_LOG_ERROR() << "Error: Unknown test " << argv[2];
+            return 1;
+        }
+        return 0;
+    }
+
     if (strcmp(argv[1], "--all") == 0) {
         // Run all phases
         int result = phase01::run_test();
@@ -1,5 +1,7 @@
 #include "phase09_test.h"
 
+#include "shaders/simple_add_spirv.h"
+
 #include <cmath>
 #include <cstring>
 #include "logging.h"
@@ -11,50 +13,6 @@ namespace {
 constexpr uint32_t kElementCount = 1024;
 constexpr VkDeviceSize kBufferSize = kElementCount * sizeof(float);
 
-static const uint32_t kSimpleAddSpirv[] = {
-    0x07230203, 0x00010000, 0x0008000b, 0x0000002c, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
-    0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
-    0x0006000f, 0x00000005, 0x00000004, 0x6e69616d, 0x00000000, 0x0000000b, 0x00060010, 0x00000004,
-    0x00000011, 0x00000100, 0x00000001, 0x00000001, 0x00030003, 0x00000002, 0x000001c2, 0x00040005,
-    0x00000004, 0x6e69616d, 0x00000000, 0x00030005, 0x00000008, 0x00786469, 0x00080005, 0x0000000b,
-    0x475f6c67, 0x61626f6c, 0x766e496c, 0x7461636f, 0x496e6f69, 0x00000044, 0x00040005, 0x00000012,
-    0x7074754f, 0x00007475, 0x00040006, 0x00000012, 0x00000000, 0x00000063, 0x00030005, 0x00000014,
-    0x00000000, 0x00040005, 0x00000019, 0x75706e49, 0x00004174, 0x00040006, 0x00000019, 0x00000000,
-    0x00000061, 0x00030005, 0x0000001b, 0x00000000, 0x00040005, 0x00000021, 0x75706e49, 0x00004274,
-    0x00040006, 0x00000021, 0x00000000, 0x00000062, 0x00030005, 0x00000023, 0x00000000, 0x00040047,
-    0x0000000b, 0x0000000b, 0x0000001c, 0x00040047, 0x00000011, 0x00000006, 0x00000004, 0x00050048,
-    0x00000012, 0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x00000012, 0x00000003, 0x00040047,
-    0x00000014, 0x00000022, 0x00000000, 0x00040047, 0x00000014, 0x00000021, 0x00000002, 0x00040047,
-    0x00000018, 0x00000006, 0x00000004, 0x00050048, 0x00000019, 0x00000000, 0x00000023, 0x00000000,
-    0x00030047, 0x00000019, 0x00000003, 0x00040047, 0x0000001b, 0x00000022, 0x00000000, 0x00040047,
-    0x0000001b, 0x00000021, 0x00000000, 0x00040047, 0x00000020, 0x00000006, 0x00000004, 0x00050048,
-    0x00000021, 0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x00000021, 0x00000003, 0x00040047,
-    0x00000023, 0x00000022, 0x00000000, 0x00040047, 0x00000023, 0x00000021, 0x00000001, 0x00040047,
-    0x0000002b, 0x0000000b, 0x00000019, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002,
-    0x00040015, 0x00000006, 0x00000020, 0x00000000, 0x00040020, 0x00000007, 0x00000007, 0x00000006,
-    0x00040017, 0x00000009, 0x00000006, 0x00000003, 0x00040020, 0x0000000a, 0x00000001, 0x00000009,
-    0x0004003b, 0x0000000a, 0x0000000b, 0x00000001, 0x0004002b, 0x00000006, 0x0000000c, 0x00000000,
-    0x00040020, 0x0000000d, 0x00000001, 0x00000006, 0x00030016, 0x00000010, 0x00000020, 0x0003001d,
-    0x00000011, 0x00000010, 0x0003001e, 0x00000012, 0x00000011, 0x00040020, 0x00000013, 0x00000002,
-    0x00000012, 0x0004003b, 0x00000013, 0x00000014, 0x00000002, 0x00040015, 0x00000015, 0x00000020,
-    0x00000001, 0x0004002b, 0x00000015, 0x00000016, 0x00000000, 0x0003001d, 0x00000018, 0x00000010,
-    0x0003001e, 0x00000019, 0x00000018, 0x00040020, 0x0000001a, 0x00000002, 0x00000019, 0x0004003b,
-    0x0000001a, 0x0000001b, 0x00000002, 0x00040020, 0x0000001d, 0x00000002, 0x00000010, 0x0003001d,
-    0x00000020, 0x00000010, 0x0003001e, 0x00000021, 0x00000020, 0x00040020, 0x00000022, 0x00000002,
-    0x00000021, 0x0004003b, 0x00000022, 0x00000023, 0x00000002, 0x0004002b, 0x00000006, 0x00000029,
-    0x00000100, 0x0004002b, 0x00000006, 0x0000002a, 0x00000001, 0x0006002c, 0x00000009, 0x0000002b,
-    0x00000029, 0x0000002a, 0x0000002a, 0x00050036, 0x00000002, 0x00000004, 0x00000000, 0x00000003,
-    0x000200f8, 0x00000005, 0x0004003b, 0x00000007, 0x00000008, 0x00000007, 0x00050041, 0x0000000d,
-    0x0000000e, 0x0000000b, 0x0000000c, 0x0004003d, 0x00000006, 0x0000000f, 0x0000000e, 0x0003003e,
-    0x00000008, 0x0000000f, 0x0004003d, 0x00000006, 0x00000017, 0x00000008, 0x0004003d, 0x00000006,
-    0x0000001c, 0x00000008, 0x00060041, 0x0000001d, 0x0000001e, 0x0000001b, 0x00000016, 0x0000001c,
-    0x0004003d, 0x00000010, 0x0000001f, 0x0000001e, 0x0004003d, 0x00000006, 0x00000024, 0x00000008,
-    0x00060041, 0x0000001d, 0x00000025, 0x00000023, 0x00000016, 0x00000024, 0x0004003d, 0x00000010,
-    0x00000026, 0x00000025, 0x00050081, 0x00000010, 0x00000027, 0x0000001f, 0x00000026, 0x00060041,
-    0x0000001d, 0x00000028, 0x00000014, 0x00000016, 0x00000017, 0x0003003e, 0x00000028, 0x00000027,
-    0x000100fd, 0x00010038,
-};
-
 uint32_t find_memory_type(uint32_t type_bits,
                           VkMemoryPropertyFlags desired,
                           const VkPhysicalDeviceMemoryProperties& props) {
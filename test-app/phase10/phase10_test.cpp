@@ -1,11 +1,13 @@
 #include "phase10_test.h"
 
 #include "logging.h"
+#include "shaders/triangle_spirv.h"
 #include <vulkan/vulkan.h>
 
 #include <algorithm>
 #include <array>
 #include <cctype>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
@@ -33,60 +35,6 @@ namespace {
 constexpr uint32_t kImageWidth = 256;
 constexpr uint32_t kImageHeight = 256;
 
-const uint32_t kVertexShaderSpv[] = {
-    0x07230203, 0x00010000, 0x0008000b, 0x00000021, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
-    0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
-    0x0009000f, 0x00000000, 0x00000004, 0x6e69616d, 0x00000000, 0x00000009, 0x0000000b, 0x00000013,
-    0x00000018, 0x00030003, 0x00000002, 0x000001c2, 0x00040005, 0x00000004, 0x6e69616d, 0x00000000,
-    0x00050005, 0x00000009, 0x4374756f, 0x726f6c6f, 0x00000000, 0x00040005, 0x0000000b, 0x6f436e69,
-    0x00726f6c, 0x00060005, 0x00000011, 0x505f6c67, 0x65567265, 0x78657472, 0x00000000, 0x00060006,
-    0x00000011, 0x00000000, 0x505f6c67, 0x7469736f, 0x006e6f69, 0x00070006, 0x00000011, 0x00000001,
-    0x505f6c67, 0x746e696f, 0x657a6953, 0x00000000, 0x00070006, 0x00000011, 0x00000002, 0x435f6c67,
-    0x4470696c, 0x61747369, 0x0065636e, 0x00070006, 0x00000011, 0x00000003, 0x435f6c67, 0x446c6c75,
-    0x61747369, 0x0065636e, 0x00030005, 0x00000013, 0x00000000, 0x00050005, 0x00000018, 0x6f506e69,
-    0x69746973, 0x00006e6f, 0x00040047, 0x00000009, 0x0000001e, 0x00000000, 0x00040047, 0x0000000b,
-    0x0000001e, 0x00000001, 0x00050048, 0x00000011, 0x00000000, 0x0000000b, 0x00000000, 0x00050048,
-    0x00000011, 0x00000001, 0x0000000b, 0x00000001, 0x00050048, 0x00000011, 0x00000002, 0x0000000b,
-    0x00000003, 0x00050048, 0x00000011, 0x00000003, 0x0000000b, 0x00000004, 0x00030047, 0x00000011,
-    0x00000002, 0x00040047, 0x00000018, 0x0000001e, 0x00000000, 0x00020013, 0x00000002, 0x00030021,
-    0x00000003, 0x00000002, 0x00030016, 0x00000006, 0x00000020, 0x00040017, 0x00000007, 0x00000006,
-    0x00000003, 0x00040020, 0x00000008, 0x00000003, 0x00000007, 0x0004003b, 0x00000008, 0x00000009,
-    0x00000003, 0x00040020, 0x0000000a, 0x00000001, 0x00000007, 0x0004003b, 0x0000000a, 0x0000000b,
-    0x00000001, 0x00040017, 0x0000000d, 0x00000006, 0x00000004, 0x00040015, 0x0000000e, 0x00000020,
-    0x00000000, 0x0004002b, 0x0000000e, 0x0000000f, 0x00000001, 0x0004001c, 0x00000010, 0x00000006,
-    0x0000000f, 0x0006001e, 0x00000011, 0x0000000d, 0x00000006, 0x00000010, 0x00000010, 0x00040020,
-    0x00000012, 0x00000003, 0x00000011, 0x0004003b, 0x00000012, 0x00000013, 0x00000003, 0x00040015,
-    0x00000014, 0x00000020, 0x00000001, 0x0004002b, 0x00000014, 0x00000015, 0x00000000, 0x00040017,
-    0x00000016, 0x00000006, 0x00000002, 0x00040020, 0x00000017, 0x00000001, 0x00000016, 0x0004003b,
-    0x00000017, 0x00000018, 0x00000001, 0x0004002b, 0x00000006, 0x0000001a, 0x00000000, 0x0004002b,
-    0x00000006, 0x0000001b, 0x3f800000, 0x00040020, 0x0000001f, 0x00000003, 0x0000000d, 0x00050036,
-    0x00000002, 0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005, 0x0004003d, 0x00000007,
-    0x0000000c, 0x0000000b, 0x0003003e, 0x00000009, 0x0000000c, 0x0004003d, 0x00000016, 0x00000019,
-    0x00000018, 0x00050051, 0x00000006, 0x0000001c, 0x00000019, 0x00000000, 0x00050051, 0x00000006,
-    0x0000001d, 0x00000019, 0x00000001, 0x00070050, 0x0000000d, 0x0000001e, 0x0000001c, 0x0000001d,
-    0x0000001a, 0x0000001b, 0x00050041, 0x0000001f, 0x00000020, 0x00000013, 0x00000015, 0x0003003e,
-    0x00000020, 0x0000001e, 0x000100fd, 0x00010038,
-};
-
-const uint32_t kFragmentShaderSpv[] = {
-    0x07230203, 0x00010000, 0x0008000b, 0x00000013, 0x00000000, 0x00020011, 0x00000001, 0x0006000b,
-    0x00000001, 0x4c534c47, 0x6474732e, 0x3035342e, 0x00000000, 0x0003000e, 0x00000000, 0x00000001,
-    0x0007000f, 0x00000004, 0x00000004, 0x6e69616d, 0x00000000, 0x00000009, 0x0000000c, 0x00030010,
-    0x00000004, 0x00000007, 0x00030003, 0x00000002, 0x000001c2, 0x00040005, 0x00000004, 0x6e69616d,
-    0x00000000, 0x00050005, 0x00000009, 0x4374756f, 0x726f6c6f, 0x00000000, 0x00040005, 0x0000000c,
-    0x6f436e69, 0x00726f6c, 0x00040047, 0x00000009, 0x0000001e, 0x00000000, 0x00040047, 0x0000000c,
-    0x0000001e, 0x00000000, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016,
-    0x00000006, 0x00000020, 0x00040017, 0x00000007, 0x00000006, 0x00000004, 0x00040020, 0x00000008,
-    0x00000003, 0x00000007, 0x0004003b, 0x00000008, 0x00000009, 0x00000003, 0x00040017, 0x0000000a,
-    0x00000006, 0x00000003, 0x00040020, 0x0000000b, 0x00000001, 0x0000000a, 0x0004003b, 0x0000000b,
-    0x0000000c, 0x00000001, 0x0004002b, 0x00000006, 0x0000000e, 0x3f800000, 0x00050036, 0x00000002,
-    0x00000004, 0x00000000, 0x00000003, 0x000200f8, 0x00000005, 0x0004003d, 0x0000000a, 0x0000000d,
-    0x0000000c, 0x00050051, 0x00000006, 0x0000000f, 0x0000000d, 0x00000000, 0x00050051, 0x00000006,
-    0x00000010, 0x0000000d, 0x00000001, 0x00050051, 0x00000006, 0x00000011, 0x0000000d, 0x00000002,
-    0x00070050, 0x00000007, 0x00000012, 0x0000000f, 0x00000010, 0x00000011, 0x0000000e, 0x0003003e,
-    0x00000009, 0x00000012, 0x000100fd, 0x00010038,
-};
-
 struct BufferResource {
     VkBuffer buffer = VK_NULL_HANDLE;
     VkDeviceMemory memory = VK_NULL_HANDLE;
@@ -264,6 +212,68 @@ const std::array<Vertex, 3> kVertices = {{
     {{-0.6f, 0.6f}, {0.0f, 0.0f, 1.0f}},
 }};
 
+// Index data, indirect arguments and the draw count of the *IndirectCount
+// draws share one buffer.
+struct DrawArgs {
+    uint16_t indices[4];
+    VkDrawIndirectCommand draw;
+    VkDrawIndexedIndirectCommand indexed;
+    uint32_t draw_count;
+};
+
+const DrawArgs kDrawArgs = {
+    {0, 1, 2, 0},
+    {static_cast<uint32_t>(kVertices.size()), 1, 0, 0},
+    {3, 1, 0, 0, 0},
+    1,
+};
+
+// The triangle is drawn once per draw path, each into its own cell of a 3x3
+// grid. The plain vkCmdDraw keeps the middle cell, at the image center.
+constexpr uint32_t kGridSize = 3;
+constexpr uint32_t kCellSize = kImageWidth / kGridSize;
+
+enum DrawCell : uint32_t {
+    kCellDrawIndexed = 0,
+    kCellDrawIndirect = 1,
+    kCellDrawIndexedIndirect = 2,
+    kCellDrawIndirectCount = 3,
+    kCellDraw = 4,
+    kCellDrawIndexedIndirectCount = 5,
+    kCellSecondary = 6,
+    kCellCount = kGridSize * kGridSize,
+};
+
+VkRect2D cell_rect(uint32_t cell) {
+    VkRect2D rect = {};
+    rect.offset = {static_cast<int32_t>(cell % kGridSize * kCellSize),
+                   static_cast<int32_t>(cell / kGridSize * kCellSize)};
+    rect.extent = {kCellSize, kCellSize};
+    return rect;
+}
+
+void set_cell(VkCommandBuffer command_buffer, uint32_t cell) {
+    const VkRect2D rect = cell_rect(cell);
+    VkViewport viewport = {};
+    viewport.x = static_cast<float>(rect.offset.x);
+    viewport.y = static_cast<float>(rect.offset.y);
+    viewport.width = static_cast<float>(rect.extent.width);
+    viewport.height = static_cast<float>(rect.extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &rect);
+}
+
+// The triangle covers the center of its cell; an empty cell keeps the clear color.
+bool cell_lit(const std::vector<uint8_t>& pixels, uint32_t cell) {
+    const VkRect2D rect = cell_rect(cell);
+    const uint32_t x = static_cast<uint32_t>(rect.offset.x) + kCellSize / 2;
+    const uint32_t y = static_cast<uint32_t>(rect.offset.y) + kCellSize / 2;
+    const uint8_t* pixel = pixels.data() + (y * kImageWidth + x) * 4;
+    return pixel[0] >= 32 || pixel[1] >= 32 || pixel[2] >= 32;
+}
+
 std::set<std::string> list_swapchain_files() {
     namespace fs = std::filesystem;
     std::set<std::string> files;
@@ -748,15 +758,18 @@ bool run_phase10_test() {
     uint32_t queue_family = 0;
     VkCommandPool command_pool = VK_NULL_HANDLE;
     VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    VkCommandBuffer secondary_command_buffer = VK_NULL_HANDLE;
     VkFence render_fence = VK_NULL_HANDLE;
     VkShaderModule vert_shader = VK_NULL_HANDLE;
     VkShaderModule frag_shader = VK_NULL_HANDLE;
     VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
     VkPipeline pipeline = VK_NULL_HANDLE;
     BufferResource vertex_buffer;
+    BufferResource draw_args_buffer;
     ImageResource color_image;
     VkImageView color_view = VK_NULL_HANDLE;
     VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkRenderPass load_render_pass = VK_NULL_HANDLE;
     VkFramebuffer framebuffer = VK_NULL_HANDLE;
     BufferResource readback_buffer;
     SwapchainPresentContext wsi_present_ctx;
@@ -770,6 +783,7 @@ bool run_phase10_test() {
         destroy_surface_context(instance, &surface_ctx);
         if (framebuffer) vkDestroyFramebuffer(device, framebuffer, nullptr);
         if (render_pass) vkDestroyRenderPass(device, render_pass, nullptr);
+        if (load_render_pass) vkDestroyRenderPass(device, load_render_pass, nullptr);
         if (color_view) vkDestroyImageView(device, color_view, nullptr);
         if (color_image.image) vkDestroyImage(device, color_image.image, nullptr);
         if (color_image.memory) vkFreeMemory(device, color_image.memory, nullptr);
@@ -779,6 +793,8 @@ bool run_phase10_test() {
         if (frag_shader) vkDestroyShaderModule(device, frag_shader, nullptr);
         if (vertex_buffer.buffer) vkDestroyBuffer(device, vertex_buffer.buffer, nullptr);
         if (vertex_buffer.memory) vkFreeMemory(device, vertex_buffer.memory, nullptr);
+        if (draw_args_buffer.buffer) vkDestroyBuffer(device, draw_args_buffer.buffer, nullptr);
+        if (draw_args_buffer.memory) vkFreeMemory(device, draw_args_buffer.memory, nullptr);
         if (readback_buffer.buffer) vkDestroyBuffer(device, readback_buffer.buffer, nullptr);
         if (readback_buffer.memory) vkFreeMemory(device, readback_buffer.memory, nullptr);
         if (render_fence) vkDestroyFence(device, render_fence, nullptr);
@@ -863,7 +879,7 @@ bool run_phase10_test() {
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "VenusPlus";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_1;
+    app_info.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo instance_info = {};
     instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -934,6 +950,25 @@ bool run_phase10_test() {
     device_info.enabledExtensionCount = 1;
     device_info.ppEnabledExtensionNames = device_extensions;
 
+    // vkCmdDraw*IndirectCount are core from Vulkan 1.2 behind the
+    // drawIndirectCount feature; skip those draws without it.
+    VkPhysicalDeviceProperties device_props = {};
+    vkGetPhysicalDeviceProperties(physical_device, &device_props);
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (device_props.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &features12;
+        vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+    }
+    VkPhysicalDeviceVulkan12Features enabled12 = {};
+    enabled12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    enabled12.drawIndirectCount = features12.drawIndirectCount;
+    if (enabled12.drawIndirectCount) {
+        device_info.pNext = &enabled12;
+    }
+
     if (vkCreateDevice(physical_device, &device_info, nullptr, &device) != VK_SUCCESS) {
         TEST_LOG_ERROR() << "✗ vkCreateDevice failed";
         cleanup();
@@ -942,6 +977,19 @@ bool run_phase10_test() {
     vkGetDeviceQueue(device, queue_family, 0, &queue);
     TEST_LOG_INFO() << "✅ Device and queue ready";
 
+    PFN_vkCmdDrawIndirectCount draw_indirect_count = nullptr;
+    PFN_vkCmdDrawIndexedIndirectCount draw_indexed_indirect_count = nullptr;
+    if (enabled12.drawIndirectCount) {
+        draw_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndirectCount>(
+            vkGetDeviceProcAddr(device, "vkCmdDrawIndirectCount"));
+        draw_indexed_indirect_count = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+            vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCount"));
+    }
+    const bool has_indirect_count = draw_indirect_count && draw_indexed_indirect_count;
+    if (!has_indirect_count) {
+        TEST_LOG_INFO() << "drawIndirectCount not supported, skipping vkCmdDraw*IndirectCount";
+    }
+
     const VkFormat swapchain_format = VK_FORMAT_B8G8R8A8_UNORM;
     VkExtent2D swapchain_extent = {kImageWidth, kImageHeight};
     if (surface_ctx.surface != VK_NULL_HANDLE) {
@@ -975,6 +1023,12 @@ bool run_phase10_test() {
         cleanup();
         return false;
     }
+    cmd_alloc.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    if (vkAllocateCommandBuffers(device, &cmd_alloc, &secondary_command_buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkAllocateCommandBuffers failed for secondary command buffer";
+        cleanup();
+        return false;
+    }
 
     VkFenceCreateInfo fence_info = {};
     fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -1041,6 +1095,16 @@ bool run_phase10_test() {
         return false;
     }
 
+    // A compatible pass that keeps what the first one drew, for the draw
+    // executed from a secondary command buffer.
+    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    if (vkCreateRenderPass(device, &rp_info, nullptr, &load_render_pass) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkCreateRenderPass failed for the load pass";
+        cleanup();
+        return false;
+    }
+
     VkImageCreateInfo image_info = {};
     image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     image_info.imageType = VK_IMAGE_TYPE_2D;
@@ -1155,6 +1219,44 @@ bool run_phase10_test() {
     }
     vkUnmapMemory(device, vertex_buffer.memory);
 
+    buffer_info.size = sizeof(DrawArgs);
+    buffer_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    if (vkCreateBuffer(device, &buffer_info, nullptr, &draw_args_buffer.buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Failed to create index/indirect buffer";
+        cleanup();
+        return false;
+    }
+    VkMemoryRequirements da_reqs = {};
+    vkGetBufferMemoryRequirements(device, draw_args_buffer.buffer, &da_reqs);
+    uint32_t da_mem_type = find_memory_type(da_reqs.memoryTypeBits,
+                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                            mem_props);
+    if (da_mem_type == UINT32_MAX) {
+        TEST_LOG_ERROR() << "✗ Unable to find memory type for index/indirect buffer";
+        cleanup();
+        return false;
+    }
+    VkMemoryAllocateInfo da_alloc = {};
+    da_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    da_alloc.allocationSize = da_reqs.size;
+    da_alloc.memoryTypeIndex = da_mem_type;
+    if (vkAllocateMemory(device, &da_alloc, nullptr, &draw_args_buffer.memory) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ Failed to allocate index/indirect buffer memory";
+        cleanup();
+        return false;
+    }
+    vkBindBufferMemory(device, draw_args_buffer.buffer, draw_args_buffer.memory, 0);
+    mapped = nullptr;
+    vkMapMemory(device, draw_args_buffer.memory, 0, buffer_info.size, 0, &mapped);
+    std::memcpy(mapped, &kDrawArgs, sizeof(kDrawArgs));
+    if (!flush_memory(device, draw_args_buffer.memory, buffer_info.size)) {
+        TEST_LOG_ERROR() << "✗ Failed to flush index/indirect buffer memory";
+        cleanup();
+        return false;
+    }
+    vkUnmapMemory(device, draw_args_buffer.memory);
+
     buffer_info.size = static_cast<VkDeviceSize>(kImageWidth) * kImageHeight * 4u;
     buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     if (vkCreateBuffer(device, &buffer_info, nullptr, &readback_buffer.buffer) != VK_SUCCESS) {
@@ -1261,6 +1363,12 @@ bool run_phase10_test() {
     color_blend.attachmentCount = 1;
     color_blend.pAttachments = &color_blend_attachment;
 
+    const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamic_state = {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
     VkGraphicsPipelineCreateInfo pipeline_info = {};
     pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipeline_info.stageCount = 2;
@@ -1271,6 +1379,7 @@ bool run_phase10_test() {
     pipeline_info.pRasterizationState = &raster;
     pipeline_info.pMultisampleState = &multisample;
     pipeline_info.pColorBlendState = &color_blend;
+    pipeline_info.pDynamicState = &dynamic_state;
     pipeline_info.layout = pipeline_layout;
     pipeline_info.renderPass = render_pass;
     pipeline_info.subpass = 0;
@@ -1282,6 +1391,34 @@ bool run_phase10_test() {
     }
     TEST_LOG_INFO() << "✅ Graphics pipeline created";
 
+    // The secondary inherits the load pass and framebuffer and draws one
+    // triangle into its own cell.
+    VkCommandBufferInheritanceInfo inheritance_info = {};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = load_render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo secondary_begin_info = {};
+    secondary_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    secondary_begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    secondary_begin_info.pInheritanceInfo = &inheritance_info;
+    if (vkBeginCommandBuffer(secondary_command_buffer, &secondary_begin_info) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkBeginCommandBuffer failed for secondary command buffer";
+        cleanup();
+        return false;
+    }
+    VkDeviceSize offsets = 0;
+    vkCmdBindPipeline(secondary_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindVertexBuffers(secondary_command_buffer, 0, 1, &vertex_buffer.buffer, &offsets);
+    set_cell(secondary_command_buffer, kCellSecondary);
+    vkCmdDraw(secondary_command_buffer, static_cast<uint32_t>(kVertices.size()), 1, 0, 0);
+    if (vkEndCommandBuffer(secondary_command_buffer) != VK_SUCCESS) {
+        TEST_LOG_ERROR() << "✗ vkEndCommandBuffer failed for secondary command buffer";
+        cleanup();
+        return false;
+    }
+
     VkCommandBufferBeginInfo begin_info = {};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -1327,11 +1464,61 @@ bool run_phase10_test() {
 
     vkCmdBeginRenderPass(command_buffer, &rp_begin, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-    VkDeviceSize offsets = 0;
     vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_buffer.buffer, &offsets);
-    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    vkCmdBindIndexBuffer(command_buffer, draw_args_buffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+    set_cell(command_buffer, kCellDraw);
     vkCmdDraw(command_buffer, static_cast<uint32_t>(kVertices.size()), 1, 0, 0);
+    set_cell(command_buffer, kCellDrawIndexed);
+    vkCmdDrawIndexed(command_buffer, 3, 1, 0, 0, 0);
+    set_cell(command_buffer, kCellDrawIndirect);
+    vkCmdDrawIndirect(command_buffer,
+                      draw_args_buffer.buffer,
+                      offsetof(DrawArgs, draw),
+                      1,
+                      sizeof(VkDrawIndirectCommand));
+    set_cell(command_buffer, kCellDrawIndexedIndirect);
+    vkCmdDrawIndexedIndirect(command_buffer,
+                             draw_args_buffer.buffer,
+                             offsetof(DrawArgs, indexed),
+                             1,
+                             sizeof(VkDrawIndexedIndirectCommand));
+    if (has_indirect_count) {
+        set_cell(command_buffer, kCellDrawIndirectCount);
+        draw_indirect_count(command_buffer,
+                            draw_args_buffer.buffer,
+                            offsetof(DrawArgs, draw),
+                            draw_args_buffer.buffer,
+                            offsetof(DrawArgs, draw_count),
+                            1,
+                            sizeof(VkDrawIndirectCommand));
+        set_cell(command_buffer, kCellDrawIndexedIndirectCount);
+        draw_indexed_indirect_count(command_buffer,
+                                    draw_args_buffer.buffer,
+                                    offsetof(DrawArgs, indexed),
+                                    draw_args_buffer.buffer,
+                                    offsetof(DrawArgs, draw_count),
+                                    1,
+                                    sizeof(VkDrawIndexedIndirectCommand));
+    }
+    vkCmdEndRenderPass(command_buffer);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &barrier);
+
+    rp_begin.renderPass = load_render_pass;
+    rp_begin.clearValueCount = 0;
+    rp_begin.pClearValues = nullptr;
+    vkCmdBeginRenderPass(command_buffer, &rp_begin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(command_buffer, 1, &secondary_command_buffer);
     vkCmdEndRenderPass(command_buffer);
 
     barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -1469,6 +1656,30 @@ bool run_phase10_test() {
         return false;
     }
 
+    static const char* const kCellNames[kCellCount] = {
+        "vkCmdDrawIndexed",
+        "vkCmdDrawIndirect",
+        "vkCmdDrawIndexedIndirect",
+        "vkCmdDrawIndirectCount",
+        "vkCmdDraw",
+        "vkCmdDrawIndexedIndirectCount",
+        "vkCmdExecuteCommands",
+        nullptr,
+        nullptr,
+    };
+    for (uint32_t cell = 0; cell < kCellCount; ++cell) {
+        const bool expected = kCellNames[cell] &&
+                              (has_indirect_count || (cell != kCellDrawIndirectCount &&
+                                                      cell != kCellDrawIndexedIndirectCount));
+        if (cell_lit(pixels, cell) != expected) {
+            TEST_LOG_ERROR() << "✗ Cell " << cell << (expected ? " is empty" : " was drawn into")
+                             << (kCellNames[cell] ? std::string(" (") + kCellNames[cell] + ")" : std::string());
+            cleanup();
+            return false;
+        }
+    }
+    TEST_LOG_INFO() << "✅ Every draw path rendered its own cell";
+
     const std::string output_path = "triangle.png";
     if (!write_png(output_path, kImageWidth, kImageHeight, pixels)) {
         TEST_LOG_ERROR() << "✗ Failed to write triangle.png";